@@ -39,6 +39,12 @@ COPYRIGHT 1993-1999 PARALLAX SOFTWARE CORPORATION.  ALL RIGHTS RESERVED.
 #include "compiler-array.h"
 #include "compiler-exchange.h"
 
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
 namespace dcx {
 
 static void gr_bm_ubitblt00_rle(unsigned w, unsigned h, int dx, int dy, int sx, int sy, const grs_bitmap &src, grs_bitmap &dest);
@@ -50,12 +56,36 @@ static void gr_bm_ubitblt0x_rle(grs_canvas &dest, unsigned w, unsigned h, int dx
 #define gr_linear_movsd(S,D,L)	memcpy(D,S,L)
 
 #if !DXX_USE_OGL
-static void gr_linear_rep_movsdm(uint8_t *const dest, const uint8_t *const src, const uint_fast32_t num_pixels)
+static void gr_linear_rep_movsdm(uint8_t *dest, const uint8_t *src, const uint_fast32_t num_pixels)
 {
+	auto n = num_pixels;
+	/* 16 pixels at a time: compare against the transparent color and
+	 * blend the source over the destination through the result.
+	 */
+#if defined(__SSE2__)
+	const auto transparent = _mm_set1_epi8(static_cast<char>(TRANSPARENCY_COLOR));
+	for (; n >= 16; n -= 16, src += 16, dest += 16)
+	{
+		const auto s = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src));
+		const auto m = _mm_cmpeq_epi8(s, transparent);
+		const auto mask = _mm_movemask_epi8(m);
+		if (mask == 0xffff)
+			continue;
+		const auto d = mask ? _mm_and_si128(m, _mm_loadu_si128(reinterpret_cast<const __m128i *>(dest))) : _mm_setzero_si128();
+		_mm_storeu_si128(reinterpret_cast<__m128i *>(dest), _mm_or_si128(d, _mm_andnot_si128(m, s)));
+	}
+#elif defined(__ARM_NEON)
+	const auto transparent = vdupq_n_u8(TRANSPARENCY_COLOR);
+	for (; n >= 16; n -= 16, src += 16, dest += 16)
+	{
+		const auto s = vld1q_u8(src);
+		vst1q_u8(dest, vbslq_u8(vceqq_u8(s, transparent), vld1q_u8(dest), s));
+	}
+#endif
 	auto predicate = [&](uint8_t s, uint8_t d) {
-		return s == 255 ? d : s;
+		return s == TRANSPARENCY_COLOR ? d : s;
 	};
-	std::transform(src, src + num_pixels, dest, dest, predicate);
+	std::transform(src, src + n, dest, dest, predicate);
 }
 #endif
 
@@ -443,6 +473,29 @@ static void gr_bm_ubitblt0x_rle(grs_canvas &canvas, unsigned w, unsigned h, int
 
 static void scale_line(const uint8_t *in, uint8_t *out, const uint_fast32_t ilen, const uint_fast32_t olen)
 {
+#if defined(__SSE2__) || defined(__ARM_NEON)
+	/* Doubling, as when a 320 wide screen is shown at 640, is an
+	 * interleave of each pixel with itself.
+	 */
+	if (olen == 2 * ilen)
+	{
+		uint_fast32_t n = ilen;
+		for (; n >= 16; n -= 16, in += 16, out += 32)
+		{
+#if defined(__SSE2__)
+			const auto v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(in));
+			_mm_storeu_si128(reinterpret_cast<__m128i *>(out), _mm_unpacklo_epi8(v, v));
+			_mm_storeu_si128(reinterpret_cast<__m128i *>(out + 16), _mm_unpackhi_epi8(v, v));
+#else
+			const auto v = vld1q_u8(in);
+			vst2q_u8(out, uint8x16x2_t{{v, v}});
+#endif
+		}
+		for (; n; --n, out += 2)
+			out[0] = out[1] = *in++;
+		return;
+	}
+#endif
 	uint_fast32_t a = olen / ilen, b = olen % ilen, c = 0;
 	for (uint8_t *const end = out + olen; out != end;)
 	{
@@ -470,12 +523,17 @@ static void gr_bitmap_scale_to(const grs_bitmap &src, grs_bitmap &dst)
 		c += b;
 		if(c >= h) {
 			c -= h;
-			goto inside;
+			++i;
 		}
-		while(--i>=0) {
-inside:
+		if (i) {
+			// scale the row once, then copy it for the repeats
+			const auto first = d;
 			scale_line(s, d, src.bm_w, dst.bm_w);
 			d += dst.bm_rowsize;
+			while (--i) {
+				memcpy(d, first, dst.bm_w);
+				d += dst.bm_rowsize;
+			}
 		}
 		s += src.bm_rowsize;
 	}
@@ -25,6 +25,7 @@ COPYRIGHT 1993-1998 PARALLAX SOFTWARE CORPORATION.  ALL RIGHTS RESERVED.
  */
 
 #include <algorithm>
+#include <unordered_map>
 #include <stdlib.h>
 #include <stdio.h>
 #include <string.h>
@@ -35,10 +36,18 @@ COPYRIGHT 1993-1998 PARALLAX SOFTWARE CORPORATION.  ALL RIGHTS RESERVED.
 #include "grdef.h"
 #include "dxxerror.h"
 #include "rle.h"
+#include "args.h"
+#include "texmap.h"
 #include "byteutil.h"
 
 #include "compiler-range_for.h"
 
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
 namespace dcx {
 
 constexpr uint8_t RLE_CODE = 0xe0;
@@ -48,7 +57,51 @@ static inline int IS_RLE_CODE(const uint8_t &x)
 {
 	return (x & RLE_CODE) == RLE_CODE;
 }
-#define rle_stosb(_dest, _len, _color)	memset(_dest,_color,_len)
+
+/* Runs are at most 31 pixels, so memset spends more time choosing a
+ * strategy than storing.  Cover the run with stores of the widest size
+ * that fits, overlapping the last one with the one before it.
+ */
+static inline void rle_stosb(uint8_t *const dest, const std::size_t len, const uint8_t color)
+{
+	if (len < 4)
+	{
+		if (len)
+		{
+			dest[0] = color;
+			dest[len >> 1] = color;
+			dest[len - 1] = color;
+		}
+		return;
+	}
+	if (len < 8)
+	{
+		const uint32_t w = color * UINT32_C(0x01010101);
+		memcpy(dest, &w, sizeof(w));
+		memcpy(dest + len - sizeof(w), &w, sizeof(w));
+		return;
+	}
+#if defined(__SSE2__) || defined(__ARM_NEON)
+	if (len >= 16)
+	{
+#if defined(__SSE2__)
+		const auto v = _mm_set1_epi8(static_cast<char>(color));
+		const auto store = [v](uint8_t *const p) { _mm_storeu_si128(reinterpret_cast<__m128i *>(p), v); };
+#else
+		const auto v = vdupq_n_u8(color);
+		const auto store = [v](uint8_t *const p) { vst1q_u8(p, v); };
+#endif
+		for (std::size_t i = 0; i < len - 16; i += 16)
+			store(dest + i);
+		store(dest + len - 16);
+		return;
+	}
+#endif
+	const uint64_t w = color * UINT64_C(0x0101010101010101);
+	for (std::size_t i = 0; i < len - sizeof(w); i += sizeof(w))
+		memcpy(dest + i, &w, sizeof(w));
+	memcpy(dest + len - sizeof(w), &w, sizeof(w));
+}
 
 uint8_t *gr_rle_decode(const uint8_t *sb, uint8_t *db, const rle_position_t e)
 {
@@ -72,7 +125,7 @@ uint8_t *gr_rle_decode(const uint8_t *sb, uint8_t *db, const rle_position_t e)
 			break;
 		if (++ sb == e.src)
 			break;
-		std::fill_n(db, count, *sb++);
+		rle_stosb(db, count, *sb++);
 		advance(db, count);
 	}
 	return db;
@@ -343,42 +396,112 @@ int gr_bitmap_rle_compress(grs_bitmap &bmp)
 
 namespace {
 
+/* Expanded copies of RLE bitmaps, found by the address of the RLE
+ * bitmap, and kept in a list from the most to the least recently used.
+ * The least recently used are freed when the expanded bitmaps exceed
+ * the -rlecache budget.  With -rlepin, a bitmap which has been expanded
+ * rle_cache_pin_expansions times since the last flush is pinned: it is
+ * taken off the list and stays expanded until the next flush, usually
+ * the next level.
+ */
 struct rle_cache_element
 {
 	const grs_bitmap *rle_bitmap;
 	grs_bitmap_ptr expanded_bitmap;
-	int last_used;
+	std::size_t bytes;
+	rle_cache_element *lru_prev, *lru_next;
+	bool pinned;
 };
 
+struct rle_cache_state
+{
+	std::unordered_map<const grs_bitmap *, rle_cache_element> entries;
+	/* Expansions of each bitmap since the last flush, kept after its
+	 * entry is freed, to decide which bitmaps to pin.
+	 */
+	std::unordered_map<const grs_bitmap *, unsigned> expansions;
+	rle_cache_element *lru_head, *lru_tail;
+	std::size_t bytes, pinned_bytes;
+	unsigned hits, misses;
+};
+
+constexpr unsigned rle_cache_pin_expansions = 3;
+
 }
 
-static int rle_cache_initialized;
-static int rle_counter;
-static int rle_next;
-static array<rle_cache_element, 32> rle_cache;
+static rle_cache_state rle_cache;
+
+static std::size_t rle_cache_budget()
+{
+	return static_cast<std::size_t>(CGameArg.SysRleCacheSize) << 20;
+}
+
+static void rle_cache_unlink(rle_cache_element &e)
+{
+	auto &c = rle_cache;
+	(e.lru_prev ? e.lru_prev->lru_next : c.lru_head) = e.lru_next;
+	(e.lru_next ? e.lru_next->lru_prev : c.lru_tail) = e.lru_prev;
+}
+
+static void rle_cache_push_front(rle_cache_element &e)
+{
+	auto &c = rle_cache;
+	e.lru_prev = nullptr;
+	e.lru_next = c.lru_head;
+	(c.lru_head ? c.lru_head->lru_prev : c.lru_tail) = &e;
+	c.lru_head = &e;
+}
 
 void rle_cache_close(void)
 {
-	if (rle_cache_initialized)	{
-		rle_cache_initialized = 0;
-		range_for (auto &i, rle_cache)
-			i.expanded_bitmap.reset();
-	}
+	rle_cache_flush();
+	auto &c = rle_cache;
+	c.entries.rehash(0);
+	c.expansions.rehash(0);
 }
 
-static void rle_cache_init()
+rle_cache_stats rle_cache_get_stats()
 {
-	rle_cache = {};
-	rle_cache_initialized = 1;
+	auto &c = rle_cache;
+	return {c.bytes, c.pinned_bytes, rle_cache_budget(), static_cast<unsigned>(c.entries.size()), c.hits, c.misses};
 }
 
 void rle_cache_flush()
 {
-	range_for (auto &i, rle_cache)
+	auto &c = rle_cache;
+	if (c.entries.empty() && c.expansions.empty())
+		return;
+#if !DXX_USE_OGL
+	//	A pending texture map may still use a bitmap being freed.
+	draw_tmap_flush();
+#endif
+	c.entries.clear();
+	c.expansions.clear();
+	c.lru_head = c.lru_tail = nullptr;
+	c.bytes = c.pinned_bytes = 0;
+}
+
+/* Free the least recently used bitmaps until bytes more fit in the
+ * budget.  The most recently used bitmap is always kept, because a
+ * caller may still hold it while it expands another, as texmerge does.
+ */
+static void rle_cache_make_room(const std::size_t bytes)
+{
+	auto &c = rle_cache;
+	const auto budget = rle_cache_budget();
+	if (c.bytes + bytes <= budget || c.lru_tail == c.lru_head)
+		return;
+#if !DXX_USE_OGL
+	//	A pending texture map may still use the bitmaps being replaced.
+	draw_tmap_flush();
+#endif
+	do
 	{
-		i.rle_bitmap = NULL;
-		i.last_used = 0;
-	}
+		const auto e = c.lru_tail;
+		rle_cache_unlink(*e);
+		c.bytes -= e->bytes;
+		c.entries.erase(e->rle_bitmap);
+	} while (c.lru_tail != c.lru_head && c.bytes + bytes > budget);
 }
 
 static void rle_expand_texture_sub(const grs_bitmap &bmp, grs_bitmap &rle_temp_bitmap_1)
@@ -398,46 +521,43 @@ static void rle_expand_texture_sub(const grs_bitmap &bmp, grs_bitmap &rle_temp_b
 
 grs_bitmap *_rle_expand_texture(const grs_bitmap &bmp)
 {
-	int lowest_count, lc;
-
-	if (!rle_cache_initialized) rle_cache_init();
-
 	Assert(!(bmp.get_flag_mask(BM_FLAG_PAGED_OUT)));
 
-	lc = rle_counter;
-	rle_counter++;
-
-	if (rle_counter < 0)
-		rle_counter = 0;
-	
-	if ( rle_counter < lc )	{
-		rle_cache_flush();
-	}
-
-	lowest_count = rle_cache[rle_next].last_used;
-	auto least_recently_used = &rle_cache[rle_next];
-	rle_next++;
-	if (rle_next >= rle_cache.size())
-		rle_next = 0;
-
-	range_for (auto &i, rle_cache)
+	auto &c = rle_cache;
+	const auto i = c.entries.find(&bmp);
+	if (i != c.entries.end())
 	{
-		if (i.rle_bitmap == &bmp)
-		{
-			i.last_used = rle_counter;
-			return i.expanded_bitmap.get();
-		}
-		if (i.last_used < lowest_count)
+		++c.hits;
+		auto &e = i->second;
+		if (!e.pinned && &e != c.lru_head)
 		{
-			lowest_count = (least_recently_used = &i)->last_used;
+			rle_cache_unlink(e);
+			rle_cache_push_front(e);
 		}
+		return e.expanded_bitmap.get();
 	}
 
-	least_recently_used->expanded_bitmap = gr_create_bitmap(bmp.bm_w, bmp.bm_h);
-	rle_expand_texture_sub(bmp, *least_recently_used->expanded_bitmap.get());
-	least_recently_used->rle_bitmap = &bmp;
-	least_recently_used->last_used = rle_counter;
-	return least_recently_used->expanded_bitmap.get();
+	++c.misses;
+	const std::size_t bytes = bmp.bm_w * bmp.bm_h;
+	const bool pin = CGameArg.SysRlePin && ++c.expansions[&bmp] >= rle_cache_pin_expansions &&
+		/* Pinned bitmaps may use as much again as the budget. */
+		c.pinned_bytes + bytes <= rle_cache_budget();
+	if (!pin)
+		rle_cache_make_room(bytes);
+	auto &e = c.entries[&bmp];
+	e.rle_bitmap = &bmp;
+	e.expanded_bitmap = gr_create_bitmap(bmp.bm_w, bmp.bm_h);
+	e.bytes = bytes;
+	e.pinned = pin;
+	if (pin)
+		c.pinned_bytes += bytes;
+	else
+	{
+		c.bytes += bytes;
+		rle_cache_push_front(e);
+	}
+	rle_expand_texture_sub(bmp, *e.expanded_bitmap.get());
+	return e.expanded_bitmap.get();
 }
 
 void gr_rle_expand_scanline_generic(grs_canvas &canvas, grs_bitmap &dest, int dx, const int dy, const uint8_t *src, const int x1, const int x2)
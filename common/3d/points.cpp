@@ -11,6 +11,7 @@
  */
 
 
+#include <cmath>
 #include "3d.h"
 #include "globvars.h"
 
@@ -49,6 +50,81 @@ ubyte g3_rotate_point(g3s_point &dest,const vms_vector &src)
 	return g3_code_point(dest);
 }
 
+namespace {
+
+//View_matrix and View_position, loaded once for a batch of points
+class view_rotation
+{
+	const vms_vector position;
+	const int64_t rx, ry, rz, ux, uy, uz, fx, fy, fz;
+	static fix dot(const int64_t x, const int64_t y, const int64_t z, const int64_t mx, const int64_t my, const int64_t mz)
+	{
+		return ((x * mx) + (y * my) + (z * mz)) >> 16;
+	}
+public:
+	view_rotation() :
+		position(View_position),
+		rx(View_matrix.rvec.x), ry(View_matrix.rvec.y), rz(View_matrix.rvec.z),
+		ux(View_matrix.uvec.x), uy(View_matrix.uvec.y), uz(View_matrix.uvec.z),
+		fx(View_matrix.fvec.x), fy(View_matrix.fvec.y), fz(View_matrix.fvec.z)
+	{
+	}
+	//same result as g3_rotate_point
+	ubyte operator()(g3s_point &dest, const vms_vector &src) const
+	{
+		const int64_t x = static_cast<fix>(src.x - position.x);
+		const int64_t y = static_cast<fix>(src.y - position.y);
+		const int64_t z = static_cast<fix>(src.z - position.z);
+		const fix px = dot(x, y, z, rx, ry, rz);
+		const fix py = dot(x, y, z, ux, uy, uz);
+		const fix pz = dot(x, y, z, fx, fy, fz);
+		dest.p3_x = px;
+		dest.p3_y = py;
+		dest.p3_z = pz;
+		dest.p3_flags = 0;
+		ubyte cc = 0;
+		if (px > pz)
+			cc |= CC_OFF_RIGHT;
+		if (py > pz)
+			cc |= CC_OFF_TOP;
+		if (px < -pz)
+			cc |= CC_OFF_LEFT;
+		if (py < -pz)
+			cc |= CC_OFF_BOT;
+		if (pz < 0)
+			cc |= CC_BEHIND;
+		return dest.p3_codes = cc;
+	}
+};
+
+}
+
+g3s_codes g3_rotate_points(g3s_point *dest, const vms_vector *src, const std::size_t n)
+{
+	const view_rotation rotate;
+	g3s_codes cc;
+	for (const auto end = src + n; src != end; ++src, ++dest)
+	{
+		const auto c = rotate(*dest, *src);
+		cc.uand &= c;
+		cc.uor |= c;
+	}
+	return cc;
+}
+
+g3s_codes g3_rotate_points(g3s_point *const *const dest, const vms_vector *const *const src, const std::size_t n)
+{
+	const view_rotation rotate;
+	g3s_codes cc;
+	for (std::size_t i = 0; i != n; ++i)
+	{
+		const auto c = rotate(*dest[i], *src[i]);
+		cc.uand &= c;
+		cc.uor |= c;
+	}
+	return cc;
+}
+
 //checks for overflow & divides if ok, fillig in r
 //returns true if div is ok, else false
 int checkmuldiv(fix *r,fix a,fix b,fix c)
@@ -146,4 +222,25 @@ fix g3_calc_point_depth(const vms_vector &pnt)
 	return fixquadadjust(&q);
 }
 
+//The rows of View_matrix are scaled by Matrix_scale, at any instance
+//depth, so the sphere is an axis aligned ellipsoid in view space, and
+//each side of the frustum is tested against its extent in that
+//direction.
+bool g3_check_sphere_visible(const vms_vector &center, const fix radius)
+{
+	g3s_point p;
+	g3_rotate_point(p, center);
+	const double x = f2db(p.p3_x), y = f2db(p.p3_y), z = f2db(p.p3_z), r = f2db(radius);
+	const double sx = f2db(Matrix_scale.x), sy = f2db(Matrix_scale.y), sz = f2db(Matrix_scale.z);
+	if (z + r * sz < 0)
+		return false;
+	const double rxz = r * std::sqrt(sx * sx + sz * sz);
+	if (x - z > rxz || -x - z > rxz)
+		return false;
+	const double ryz = r * std::sqrt(sy * sy + sz * sz);
+	if (y - z > ryz || -y - z > ryz)
+		return false;
+	return true;
+}
+
 }
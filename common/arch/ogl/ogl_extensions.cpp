@@ -27,6 +27,87 @@ PFNGLFENCESYNCPROC glFenceSyncFunc = NULL;
 PFNGLDELETESYNCPROC glDeleteSyncFunc = NULL;
 PFNGLCLIENTWAITSYNCPROC glClientWaitSyncFunc = NULL;
 
+/* GL_ARB_vertex_buffer_object */
+bool ogl_have_ARB_vertex_buffer_object = false;
+PFNGLBINDBUFFERPROC glBindBufferFunc = NULL;
+PFNGLDELETEBUFFERSPROC glDeleteBuffersFunc = NULL;
+PFNGLGENBUFFERSPROC glGenBuffersFunc = NULL;
+PFNGLBUFFERDATAPROC glBufferDataFunc = NULL;
+PFNGLBUFFERSUBDATAPROC glBufferSubDataFunc = NULL;
+
+/* GL_ARB_pixel_buffer_object */
+bool ogl_have_ARB_pixel_buffer_object = false;
+PFNGLMAPBUFFERPROC glMapBufferFunc = NULL;
+PFNGLUNMAPBUFFERPROC glUnmapBufferFunc = NULL;
+
+/* GL_ARB_timer_query */
+bool ogl_have_ARB_timer_query = false;
+PFNGLGENQUERIESPROC glGenQueriesFunc = NULL;
+PFNGLDELETEQUERIESPROC glDeleteQueriesFunc = NULL;
+PFNGLBEGINQUERYPROC glBeginQueryFunc = NULL;
+PFNGLENDQUERYPROC glEndQueryFunc = NULL;
+PFNGLGETQUERYOBJECTIVPROC glGetQueryObjectivFunc = NULL;
+PFNGLGETQUERYOBJECTUI64VPROC glGetQueryObjectui64vFunc = NULL;
+
+/* GL_ARB_occlusion_query */
+bool ogl_have_ARB_occlusion_query = false;
+PFNGLGETQUERYOBJECTUIVPROC glGetQueryObjectuivFunc = NULL;
+
+/* GL_ARB_draw_instanced */
+bool ogl_have_ARB_draw_instanced = false;
+PFNGLDRAWELEMENTSINSTANCEDPROC glDrawElementsInstancedFunc = NULL;
+
+/* GL_ARB_framebuffer_object */
+bool ogl_have_ARB_framebuffer_object = false;
+PFNGLGENFRAMEBUFFERSPROC glGenFramebuffersFunc = NULL;
+PFNGLDELETEFRAMEBUFFERSPROC glDeleteFramebuffersFunc = NULL;
+PFNGLBINDFRAMEBUFFERPROC glBindFramebufferFunc = NULL;
+PFNGLFRAMEBUFFERTEXTURE2DPROC glFramebufferTexture2DFunc = NULL;
+PFNGLFRAMEBUFFERRENDERBUFFERPROC glFramebufferRenderbufferFunc = NULL;
+PFNGLCHECKFRAMEBUFFERSTATUSPROC glCheckFramebufferStatusFunc = NULL;
+PFNGLGENRENDERBUFFERSPROC glGenRenderbuffersFunc = NULL;
+PFNGLDELETERENDERBUFFERSPROC glDeleteRenderbuffersFunc = NULL;
+PFNGLBINDRENDERBUFFERPROC glBindRenderbufferFunc = NULL;
+PFNGLRENDERBUFFERSTORAGEPROC glRenderbufferStorageFunc = NULL;
+PFNGLGENERATEMIPMAPPROC glGenerateMipmapFunc = NULL;
+
+/* GL_EXT_texture3D */
+bool ogl_have_EXT_texture3D = false;
+PFNGLTEXIMAGE3DPROC glTexImage3DFunc = NULL;
+PFNGLTEXSUBIMAGE3DPROC glTexSubImage3DFunc = NULL;
+GLint ogl_max_3d_texture_size = 0;
+
+/* GL_EXT_blend_color */
+bool ogl_have_EXT_blend_color = false;
+PFNGLBLENDCOLORPROC glBlendColorFunc = NULL;
+
+/* GL_ARB_multitexture */
+bool ogl_have_ARB_multitexture = false;
+PFNGLACTIVETEXTUREPROC glActiveTextureFunc = NULL;
+PFNGLCLIENTACTIVETEXTUREPROC glClientActiveTextureFunc = NULL;
+
+/* GL_ARB_shader_objects */
+bool ogl_have_ARB_shader_objects = false;
+PFNGLCREATESHADERPROC glCreateShaderFunc = NULL;
+PFNGLSHADERSOURCEPROC glShaderSourceFunc = NULL;
+PFNGLCOMPILESHADERPROC glCompileShaderFunc = NULL;
+PFNGLGETSHADERIVPROC glGetShaderivFunc = NULL;
+PFNGLGETSHADERINFOLOGPROC glGetShaderInfoLogFunc = NULL;
+PFNGLDELETESHADERPROC glDeleteShaderFunc = NULL;
+PFNGLCREATEPROGRAMPROC glCreateProgramFunc = NULL;
+PFNGLATTACHSHADERPROC glAttachShaderFunc = NULL;
+PFNGLLINKPROGRAMPROC glLinkProgramFunc = NULL;
+PFNGLGETPROGRAMIVPROC glGetProgramivFunc = NULL;
+PFNGLGETPROGRAMINFOLOGPROC glGetProgramInfoLogFunc = NULL;
+PFNGLDELETEPROGRAMPROC glDeleteProgramFunc = NULL;
+PFNGLUSEPROGRAMPROC glUseProgramFunc = NULL;
+PFNGLGETUNIFORMLOCATIONPROC glGetUniformLocationFunc = NULL;
+PFNGLUNIFORM1IPROC glUniform1iFunc = NULL;
+PFNGLUNIFORM1FPROC glUniform1fFunc = NULL;
+PFNGLUNIFORM2FPROC glUniform2fFunc = NULL;
+PFNGLUNIFORM4FPROC glUniform4fFunc = NULL;
+PFNGLUNIFORM4FVPROC glUniform4fvFunc = NULL;
+
 /* GL_EXT_texture_filter_anisotropic */
 GLfloat ogl_maxanisotropy = 0.0f;
 
@@ -137,6 +218,217 @@ void ogl_extensions_init()
 		s = "DXX-Rebirth: OpenGL: GL_ARB_sync not available";
 	}
 	con_puts(CON_VERBOSE, s);
+
+	/* GL_ARB_vertex_buffer_object */
+	if (is_supported(extension_str, version, "GL_ARB_vertex_buffer_object", 1, 5, 1, 1)) {
+		glBindBufferFunc = reinterpret_cast<PFNGLBINDBUFFERPROC>(SDL_GL_GetProcAddress("glBindBuffer"));
+		glDeleteBuffersFunc = reinterpret_cast<PFNGLDELETEBUFFERSPROC>(SDL_GL_GetProcAddress("glDeleteBuffers"));
+		glGenBuffersFunc = reinterpret_cast<PFNGLGENBUFFERSPROC>(SDL_GL_GetProcAddress("glGenBuffers"));
+		glBufferDataFunc = reinterpret_cast<PFNGLBUFFERDATAPROC>(SDL_GL_GetProcAddress("glBufferData"));
+		glBufferSubDataFunc = reinterpret_cast<PFNGLBUFFERSUBDATAPROC>(SDL_GL_GetProcAddress("glBufferSubData"));
+	}
+	if (glBindBufferFunc && glDeleteBuffersFunc && glGenBuffersFunc && glBufferDataFunc && glBufferSubDataFunc) {
+		ogl_have_ARB_vertex_buffer_object = true;
+		s = "DXX-Rebirth: OpenGL: GL_ARB_vertex_buffer_object available";
+	} else {
+		ogl_have_ARB_vertex_buffer_object = false;
+		s = "DXX-Rebirth: OpenGL: GL_ARB_vertex_buffer_object not available";
+	}
+	con_puts(CON_VERBOSE, s);
+
+	/* GL_ARB_pixel_buffer_object: buffer binding comes from
+	 * GL_ARB_vertex_buffer_object.  OpenGL ES 3.0 has pixel buffers,
+	 * but only glMapBufferRange.
+	 */
+	if (ogl_have_ARB_vertex_buffer_object && is_supported(extension_str, version, "GL_ARB_pixel_buffer_object", 2, 1, -1, -1)) {
+		glMapBufferFunc = reinterpret_cast<PFNGLMAPBUFFERPROC>(SDL_GL_GetProcAddress("glMapBuffer"));
+		glUnmapBufferFunc = reinterpret_cast<PFNGLUNMAPBUFFERPROC>(SDL_GL_GetProcAddress("glUnmapBuffer"));
+	}
+	if (glMapBufferFunc && glUnmapBufferFunc) {
+		ogl_have_ARB_pixel_buffer_object = true;
+		s = "DXX-Rebirth: OpenGL: GL_ARB_pixel_buffer_object available";
+	} else {
+		ogl_have_ARB_pixel_buffer_object = false;
+		s = "DXX-Rebirth: OpenGL: GL_ARB_pixel_buffer_object not available";
+	}
+	con_puts(CON_VERBOSE, s);
+
+	/* GL_ARB_timer_query: the query object entry points are core since
+	 * OpenGL 1.5.
+	 */
+	if (is_supported(extension_str, version, "GL_ARB_timer_query", 3, 3, -1, -1)) {
+		glGenQueriesFunc = reinterpret_cast<PFNGLGENQUERIESPROC>(SDL_GL_GetProcAddress("glGenQueries"));
+		glDeleteQueriesFunc = reinterpret_cast<PFNGLDELETEQUERIESPROC>(SDL_GL_GetProcAddress("glDeleteQueries"));
+		glBeginQueryFunc = reinterpret_cast<PFNGLBEGINQUERYPROC>(SDL_GL_GetProcAddress("glBeginQuery"));
+		glEndQueryFunc = reinterpret_cast<PFNGLENDQUERYPROC>(SDL_GL_GetProcAddress("glEndQuery"));
+		glGetQueryObjectivFunc = reinterpret_cast<PFNGLGETQUERYOBJECTIVPROC>(SDL_GL_GetProcAddress("glGetQueryObjectiv"));
+		glGetQueryObjectui64vFunc = reinterpret_cast<PFNGLGETQUERYOBJECTUI64VPROC>(SDL_GL_GetProcAddress("glGetQueryObjectui64v"));
+	}
+	if (glGenQueriesFunc && glDeleteQueriesFunc && glBeginQueryFunc && glEndQueryFunc && glGetQueryObjectivFunc && glGetQueryObjectui64vFunc) {
+		ogl_have_ARB_timer_query = true;
+		s = "DXX-Rebirth: OpenGL: GL_ARB_timer_query available";
+	} else {
+		ogl_have_ARB_timer_query = false;
+		s = "DXX-Rebirth: OpenGL: GL_ARB_timer_query not available";
+	}
+	con_puts(CON_VERBOSE, s);
+
+	/* GL_ARB_occlusion_query: core since OpenGL 1.5, which also
+	 * provides the query object entry points that GL_ARB_timer_query
+	 * loads above.
+	 */
+	if (is_supported(extension_str, version, "GL_ARB_occlusion_query", 1, 5, -1, -1)) {
+		if (!glGenQueriesFunc)
+			glGenQueriesFunc = reinterpret_cast<PFNGLGENQUERIESPROC>(SDL_GL_GetProcAddress("glGenQueries"));
+		if (!glDeleteQueriesFunc)
+			glDeleteQueriesFunc = reinterpret_cast<PFNGLDELETEQUERIESPROC>(SDL_GL_GetProcAddress("glDeleteQueries"));
+		if (!glBeginQueryFunc)
+			glBeginQueryFunc = reinterpret_cast<PFNGLBEGINQUERYPROC>(SDL_GL_GetProcAddress("glBeginQuery"));
+		if (!glEndQueryFunc)
+			glEndQueryFunc = reinterpret_cast<PFNGLENDQUERYPROC>(SDL_GL_GetProcAddress("glEndQuery"));
+		if (!glGetQueryObjectivFunc)
+			glGetQueryObjectivFunc = reinterpret_cast<PFNGLGETQUERYOBJECTIVPROC>(SDL_GL_GetProcAddress("glGetQueryObjectiv"));
+		glGetQueryObjectuivFunc = reinterpret_cast<PFNGLGETQUERYOBJECTUIVPROC>(SDL_GL_GetProcAddress("glGetQueryObjectuiv"));
+	}
+	if (glGenQueriesFunc && glDeleteQueriesFunc && glBeginQueryFunc && glEndQueryFunc && glGetQueryObjectivFunc && glGetQueryObjectuivFunc) {
+		ogl_have_ARB_occlusion_query = true;
+		s = "DXX-Rebirth: OpenGL: GL_ARB_occlusion_query available";
+	} else {
+		ogl_have_ARB_occlusion_query = false;
+		s = "DXX-Rebirth: OpenGL: GL_ARB_occlusion_query not available";
+	}
+	con_puts(CON_VERBOSE, s);
+
+	/* GL_ARB_draw_instanced: the shaders read gl_InstanceIDARB, so the
+	 * extension is needed even where the entry point is core.
+	 */
+	if (is_supported(extension_str, version, "GL_ARB_draw_instanced", -1, -1, -1, -1))
+		glDrawElementsInstancedFunc = reinterpret_cast<PFNGLDRAWELEMENTSINSTANCEDPROC>(SDL_GL_GetProcAddress("glDrawElementsInstancedARB"));
+	if (glDrawElementsInstancedFunc) {
+		ogl_have_ARB_draw_instanced = true;
+		s = "DXX-Rebirth: OpenGL: GL_ARB_draw_instanced available";
+	} else {
+		ogl_have_ARB_draw_instanced = false;
+		s = "DXX-Rebirth: OpenGL: GL_ARB_draw_instanced not available";
+	}
+	con_puts(CON_VERBOSE, s);
+
+	/* GL_ARB_framebuffer_object: OpenGL ES 1 has only the OES suffixed
+	 * extension, which is not used.
+	 */
+	if (is_supported(extension_str, version, "GL_ARB_framebuffer_object", 3, 0, -1, -1)) {
+		glGenFramebuffersFunc = reinterpret_cast<PFNGLGENFRAMEBUFFERSPROC>(SDL_GL_GetProcAddress("glGenFramebuffers"));
+		glDeleteFramebuffersFunc = reinterpret_cast<PFNGLDELETEFRAMEBUFFERSPROC>(SDL_GL_GetProcAddress("glDeleteFramebuffers"));
+		glBindFramebufferFunc = reinterpret_cast<PFNGLBINDFRAMEBUFFERPROC>(SDL_GL_GetProcAddress("glBindFramebuffer"));
+		glFramebufferTexture2DFunc = reinterpret_cast<PFNGLFRAMEBUFFERTEXTURE2DPROC>(SDL_GL_GetProcAddress("glFramebufferTexture2D"));
+		glFramebufferRenderbufferFunc = reinterpret_cast<PFNGLFRAMEBUFFERRENDERBUFFERPROC>(SDL_GL_GetProcAddress("glFramebufferRenderbuffer"));
+		glCheckFramebufferStatusFunc = reinterpret_cast<PFNGLCHECKFRAMEBUFFERSTATUSPROC>(SDL_GL_GetProcAddress("glCheckFramebufferStatus"));
+		glGenRenderbuffersFunc = reinterpret_cast<PFNGLGENRENDERBUFFERSPROC>(SDL_GL_GetProcAddress("glGenRenderbuffers"));
+		glDeleteRenderbuffersFunc = reinterpret_cast<PFNGLDELETERENDERBUFFERSPROC>(SDL_GL_GetProcAddress("glDeleteRenderbuffers"));
+		glBindRenderbufferFunc = reinterpret_cast<PFNGLBINDRENDERBUFFERPROC>(SDL_GL_GetProcAddress("glBindRenderbuffer"));
+		glRenderbufferStorageFunc = reinterpret_cast<PFNGLRENDERBUFFERSTORAGEPROC>(SDL_GL_GetProcAddress("glRenderbufferStorage"));
+	}
+	if (glGenFramebuffersFunc && glDeleteFramebuffersFunc && glBindFramebufferFunc && glFramebufferTexture2DFunc && glFramebufferRenderbufferFunc &&
+		glCheckFramebufferStatusFunc && glGenRenderbuffersFunc && glDeleteRenderbuffersFunc && glBindRenderbufferFunc && glRenderbufferStorageFunc) {
+		ogl_have_ARB_framebuffer_object = true;
+		s = "DXX-Rebirth: OpenGL: GL_ARB_framebuffer_object available";
+	} else {
+		ogl_have_ARB_framebuffer_object = false;
+		s = "DXX-Rebirth: OpenGL: GL_ARB_framebuffer_object not available";
+	}
+	con_puts(CON_VERBOSE, s);
+
+	/* glGenerateMipmap: part of GL_ARB_framebuffer_object, and suffixed
+	 * in the older GL_EXT_framebuffer_object, which also has it.
+	 */
+	if (ogl_have_ARB_framebuffer_object)
+		glGenerateMipmapFunc = reinterpret_cast<PFNGLGENERATEMIPMAPPROC>(SDL_GL_GetProcAddress("glGenerateMipmap"));
+	else if (is_supported(extension_str, version, "GL_EXT_framebuffer_object", -1, -1, -1, -1))
+		glGenerateMipmapFunc = reinterpret_cast<PFNGLGENERATEMIPMAPPROC>(SDL_GL_GetProcAddress("glGenerateMipmapEXT"));
+	con_puts(CON_VERBOSE, glGenerateMipmapFunc ? "DXX-Rebirth: OpenGL: glGenerateMipmap available" : "DXX-Rebirth: OpenGL: glGenerateMipmap not available");
+
+	/* GL_EXT_texture3D */
+	if (is_supported(extension_str, version, "GL_EXT_texture3D", 1, 2, -1, -1)) {
+		glTexImage3DFunc = reinterpret_cast<PFNGLTEXIMAGE3DPROC>(SDL_GL_GetProcAddress("glTexImage3D"));
+		glTexSubImage3DFunc = reinterpret_cast<PFNGLTEXSUBIMAGE3DPROC>(SDL_GL_GetProcAddress("glTexSubImage3D"));
+	}
+	if (glTexImage3DFunc && glTexSubImage3DFunc) {
+		ogl_have_EXT_texture3D = true;
+		glGetIntegerv(GL_MAX_3D_TEXTURE_SIZE, &ogl_max_3d_texture_size);
+		con_printf(CON_VERBOSE, "DXX-Rebirth: OpenGL: GL_EXT_texture3D available, max size: %i", ogl_max_3d_texture_size);
+	} else {
+		ogl_have_EXT_texture3D = false;
+		con_puts(CON_VERBOSE, "DXX-Rebirth: OpenGL: GL_EXT_texture3D not available");
+	}
+
+	/* GL_EXT_blend_color */
+	switch (is_supported(extension_str, version, "GL_EXT_blend_color", 1, 4, 2, 0)) {
+		case SUPPORT_CORE:
+			glBlendColorFunc = reinterpret_cast<PFNGLBLENDCOLORPROC>(SDL_GL_GetProcAddress("glBlendColor"));
+			break;
+		case SUPPORT_EXT:
+			glBlendColorFunc = reinterpret_cast<PFNGLBLENDCOLORPROC>(SDL_GL_GetProcAddress("glBlendColorEXT"));
+			break;
+		case NO_SUPPORT:
+			break;
+	}
+	if (glBlendColorFunc) {
+		ogl_have_EXT_blend_color = true;
+		s = "DXX-Rebirth: OpenGL: GL_EXT_blend_color available";
+	} else {
+		ogl_have_EXT_blend_color = false;
+		s = "DXX-Rebirth: OpenGL: GL_EXT_blend_color not available";
+	}
+	con_puts(CON_VERBOSE, s);
+
+	/* GL_ARB_multitexture */
+	if (is_supported(extension_str, version, "GL_ARB_multitexture", 1, 3, 1, 0)) {
+		glActiveTextureFunc = reinterpret_cast<PFNGLACTIVETEXTUREPROC>(SDL_GL_GetProcAddress("glActiveTexture"));
+		glClientActiveTextureFunc = reinterpret_cast<PFNGLCLIENTACTIVETEXTUREPROC>(SDL_GL_GetProcAddress("glClientActiveTexture"));
+	}
+	if (glActiveTextureFunc && glClientActiveTextureFunc) {
+		ogl_have_ARB_multitexture = true;
+		s = "DXX-Rebirth: OpenGL: GL_ARB_multitexture available";
+	} else {
+		ogl_have_ARB_multitexture = false;
+		s = "DXX-Rebirth: OpenGL: GL_ARB_multitexture not available";
+	}
+	con_puts(CON_VERBOSE, s);
+
+	/* GL_ARB_shader_objects: only the OpenGL 2.0 entry points are used,
+	 * so there is no fallback to the ARB suffixed names.
+	 */
+	if (is_supported(extension_str, version, "GL_ARB_shader_objects", 2, 0, -1, -1)) {
+		glCreateShaderFunc = reinterpret_cast<PFNGLCREATESHADERPROC>(SDL_GL_GetProcAddress("glCreateShader"));
+		glShaderSourceFunc = reinterpret_cast<PFNGLSHADERSOURCEPROC>(SDL_GL_GetProcAddress("glShaderSource"));
+		glCompileShaderFunc = reinterpret_cast<PFNGLCOMPILESHADERPROC>(SDL_GL_GetProcAddress("glCompileShader"));
+		glGetShaderivFunc = reinterpret_cast<PFNGLGETSHADERIVPROC>(SDL_GL_GetProcAddress("glGetShaderiv"));
+		glGetShaderInfoLogFunc = reinterpret_cast<PFNGLGETSHADERINFOLOGPROC>(SDL_GL_GetProcAddress("glGetShaderInfoLog"));
+		glDeleteShaderFunc = reinterpret_cast<PFNGLDELETESHADERPROC>(SDL_GL_GetProcAddress("glDeleteShader"));
+		glCreateProgramFunc = reinterpret_cast<PFNGLCREATEPROGRAMPROC>(SDL_GL_GetProcAddress("glCreateProgram"));
+		glAttachShaderFunc = reinterpret_cast<PFNGLATTACHSHADERPROC>(SDL_GL_GetProcAddress("glAttachShader"));
+		glLinkProgramFunc = reinterpret_cast<PFNGLLINKPROGRAMPROC>(SDL_GL_GetProcAddress("glLinkProgram"));
+		glGetProgramivFunc = reinterpret_cast<PFNGLGETPROGRAMIVPROC>(SDL_GL_GetProcAddress("glGetProgramiv"));
+		glGetProgramInfoLogFunc = reinterpret_cast<PFNGLGETPROGRAMINFOLOGPROC>(SDL_GL_GetProcAddress("glGetProgramInfoLog"));
+		glDeleteProgramFunc = reinterpret_cast<PFNGLDELETEPROGRAMPROC>(SDL_GL_GetProcAddress("glDeleteProgram"));
+		glUseProgramFunc = reinterpret_cast<PFNGLUSEPROGRAMPROC>(SDL_GL_GetProcAddress("glUseProgram"));
+		glGetUniformLocationFunc = reinterpret_cast<PFNGLGETUNIFORMLOCATIONPROC>(SDL_GL_GetProcAddress("glGetUniformLocation"));
+		glUniform1iFunc = reinterpret_cast<PFNGLUNIFORM1IPROC>(SDL_GL_GetProcAddress("glUniform1i"));
+		glUniform1fFunc = reinterpret_cast<PFNGLUNIFORM1FPROC>(SDL_GL_GetProcAddress("glUniform1f"));
+		glUniform2fFunc = reinterpret_cast<PFNGLUNIFORM2FPROC>(SDL_GL_GetProcAddress("glUniform2f"));
+		glUniform4fFunc = reinterpret_cast<PFNGLUNIFORM4FPROC>(SDL_GL_GetProcAddress("glUniform4f"));
+		glUniform4fvFunc = reinterpret_cast<PFNGLUNIFORM4FVPROC>(SDL_GL_GetProcAddress("glUniform4fv"));
+	}
+	if (glCreateShaderFunc && glShaderSourceFunc && glCompileShaderFunc && glGetShaderivFunc && glGetShaderInfoLogFunc && glDeleteShaderFunc &&
+		glCreateProgramFunc && glAttachShaderFunc && glLinkProgramFunc && glGetProgramivFunc && glGetProgramInfoLogFunc && glDeleteProgramFunc &&
+		glUseProgramFunc && glGetUniformLocationFunc && glUniform1iFunc && glUniform1fFunc && glUniform2fFunc && glUniform4fFunc && glUniform4fvFunc) {
+		ogl_have_ARB_shader_objects = true;
+		s = "DXX-Rebirth: OpenGL: GLSL shaders available";
+	} else {
+		ogl_have_ARB_shader_objects = false;
+		s = "DXX-Rebirth: OpenGL: GLSL shaders not available";
+	}
+	con_puts(CON_VERBOSE, s);
 }
 
 }
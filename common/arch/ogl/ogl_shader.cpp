@@ -0,0 +1,113 @@
+/*
+ * This file is part of the DXX-Rebirth project <https://www.dxx-rebirth.com/>.
+ * It is copyright by its individual contributors, as recorded in the
+ * project's Git history.  See COPYING.txt at the top level for license
+ * terms and a link to the Git history.
+ */
+
+/* OpenGL shader programs:
+ * compile and link GLSL programs for the optional shader based paths.
+ */
+
+#include <memory>
+
+#include "console.h"
+#include "ogl_shader.h"
+
+#include "compiler-make_unique.h"
+
+namespace dcx {
+
+namespace {
+
+template <PFNGLGETSHADERIVPROC &get_iv, PFNGLGETSHADERINFOLOGPROC &get_log>
+class ogl_info_log
+{
+public:
+	static void print(const char *const name, const char *const what, const GLuint object)
+	{
+		GLint length = 0;
+		get_iv(object, GL_INFO_LOG_LENGTH, &length);
+		if (length <= 1)
+		{
+			con_printf(CON_URGENT, "DXX-Rebirth: OpenGL: %s shader \"%s\" failed", what, name);
+			return;
+		}
+		auto log = make_unique<GLchar[]>(length);
+		get_log(object, length, nullptr, log.get());
+		con_printf(CON_URGENT, "DXX-Rebirth: OpenGL: %s shader \"%s\" failed: %s", what, name, log.get());
+	}
+};
+
+}
+
+static GLuint ogl_compile_shader(const char *const name, const GLenum type, const char *const source)
+{
+	const auto shader = glCreateShaderFunc(type);
+	if (!shader)
+		return 0;
+	glShaderSourceFunc(shader, 1, &source, nullptr);
+	glCompileShaderFunc(shader);
+	GLint status = 0;
+	glGetShaderivFunc(shader, GL_COMPILE_STATUS, &status);
+	if (!status)
+	{
+		ogl_info_log<glGetShaderivFunc, glGetShaderInfoLogFunc>::print(name, "compiling", shader);
+		glDeleteShaderFunc(shader);
+		return 0;
+	}
+	return shader;
+}
+
+bool ogl_program::build(const char *const name, const char *const vertex_source, const char *const fragment_source)
+{
+	reset();
+	failed = true;
+	if (!ogl_have_ARB_shader_objects)
+		return false;
+	const auto vs = ogl_compile_shader(name, GL_VERTEX_SHADER, vertex_source);
+	if (!vs)
+		return false;
+	const auto fs = ogl_compile_shader(name, GL_FRAGMENT_SHADER, fragment_source);
+	if (!fs)
+	{
+		glDeleteShaderFunc(vs);
+		return false;
+	}
+	const auto program = glCreateProgramFunc();
+	glAttachShaderFunc(program, vs);
+	glAttachShaderFunc(program, fs);
+	glLinkProgramFunc(program);
+	/* The program keeps the shaders alive until it is deleted. */
+	glDeleteShaderFunc(vs);
+	glDeleteShaderFunc(fs);
+	GLint status = 0;
+	glGetProgramivFunc(program, GL_LINK_STATUS, &status);
+	if (!status)
+	{
+		ogl_info_log<glGetProgramivFunc, glGetProgramInfoLogFunc>::print(name, "linking", program);
+		glDeleteProgramFunc(program);
+		return false;
+	}
+	handle = program;
+	failed = false;
+	con_printf(CON_VERBOSE, "DXX-Rebirth: OpenGL: built shader \"%s\"", name);
+	return true;
+}
+
+void ogl_program::reset()
+{
+	failed = false;
+	if (handle)
+	{
+		glDeleteProgramFunc(handle);
+		handle = 0;
+	}
+}
+
+GLint ogl_program::uniform(const char *const name) const
+{
+	return glGetUniformLocationFunc(handle, name);
+}
+
+}
@@ -20,6 +20,7 @@
 #include "maths.h"
 #include "multi.h"
 #include "ogl_sync.h"
+#include "profile.h"
 #include "timer.h"
 
 namespace dcx {
@@ -43,6 +44,7 @@ void ogl_sync::sync_deleter::operator()(GLsync fence_func) const
 
 void ogl_sync::before_swap()
 {
+	const profile_scope profile(profile_phase::sync);
 	if (const auto local_fence = std::move(fence))
 	{
 		/// use a fence sync object to prevent the GPU from queuing up more than one frame
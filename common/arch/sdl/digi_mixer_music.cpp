@@ -12,7 +12,9 @@
  *  -- MD2211 (2006-04-24)
  */
 
+#include <atomic>
 #include <memory>
+#include <string>
 #include <SDL.h>
 #include <SDL_mixer.h>
 #include <string.h>
@@ -108,7 +110,8 @@ static ADL_MIDIPlayer *get_adlmidi()
 		adlmidi = adl_init(sample_rate);
 		if (adlmidi)
 		{
-			adl_switchEmulator(adlmidi, ADLMIDI_EMU_DOSBOX);
+			if (adl_switchEmulator(adlmidi, CGameCfg.ADLMIDI_emulator) < 0)
+				adl_switchEmulator(adlmidi, ADLMIDI_EMU_DOSBOX);
 			adl_setNumChips(adlmidi, CGameCfg.ADLMIDI_num_chips);
 			adl_setBank(adlmidi, CGameCfg.ADLMIDI_bank);
 			adl_setSoftPanEnabled(adlmidi, 1);
@@ -119,6 +122,33 @@ static ADL_MIDIPlayer *get_adlmidi()
 }
 
 static void mix_adlmidi(void *udata, Uint8 *stream, int len);
+
+/* Synthesis runs on its own thread, ahead of the audio callback, so the
+ * callback only copies.  Channels are interleaved in the ring.
+ */
+// Frames rendered ahead of the callback, about 370ms; a power of two
+constexpr unsigned adlmidi_ring_frames = 16384;
+// Frames rendered per call to adl_playFormat; divides adlmidi_ring_frames
+constexpr unsigned adlmidi_chunk_frames = 1024;
+
+namespace {
+
+struct adlmidi_render_state
+{
+	SDL_Thread *thread;
+	SDL_sem *wake;
+	std::atomic<bool> quit;
+	// Frames written by the thread, and frames read by the callback
+	alignas(64) std::atomic<unsigned> head;
+	alignas(64) std::atomic<unsigned> tail;
+	array<int16_t, adlmidi_ring_frames * 2> ring;
+};
+
+}
+
+static adlmidi_render_state adlmidi_render;
+static void adlmidi_render_start();
+static void adlmidi_render_stop();
 #endif
 
 enum class CurrentMusicType
@@ -135,6 +165,125 @@ static CurrentMusicType current_music_type = CurrentMusicType::None;
 static CurrentMusicType load_mus_data(const uint8_t *data, size_t size);
 static CurrentMusicType load_mus_file(const char *filename);
 
+namespace {
+
+struct mix_prefetch_state
+{
+	SDL_Thread *thread;
+	std::atomic<bool> done;
+	std::string filename;
+	std::vector<uint8_t> data;
+};
+
+}
+
+// Larger files are left for SDL_mixer to read as they play
+constexpr std::size_t mix_prefetch_max_size = 64 << 20;
+static mix_prefetch_state mix_prefetch;
+
+static bool mix_prefetch_read_disk(const char *const path, std::vector<uint8_t> &data)
+{
+	const auto fp = fopen(path, "rb");
+	if (!fp)
+		return false;
+	bool ok = false;
+	if (!fseek(fp, 0, SEEK_END))
+	{
+		const auto len = ftell(fp);
+		if (len > 0 && static_cast<std::size_t>(len) <= mix_prefetch_max_size && !fseek(fp, 0, SEEK_SET))
+		{
+			data.resize(len);
+			ok = fread(data.data(), 1, len, fp) == static_cast<std::size_t>(len);
+		}
+	}
+	fclose(fp);
+	if (!ok)
+		data.clear();
+	return ok;
+}
+
+/* Find the file the way mix_play_file does, and read all of it. */
+static int mix_prefetch_thread(void *)
+{
+	auto &p = mix_prefetch;
+	const char *const filename = p.filename.c_str();
+	array<char, PATH_MAX> full_path;
+	if (!mix_prefetch_read_disk(filename, p.data))
+	{
+		bool found = false;
+		if (*filename == '~')
+		{
+			const auto sep = PHYSFS_getDirSeparator();
+			const auto lensep = strlen(sep);
+			snprintf(full_path.data(), PATH_MAX, "%s%s", PHYSFS_getUserDir(),
+					 &filename[1 + (!strncmp(&filename[1], sep, lensep)
+				? lensep
+				: 0)]);
+			found = mix_prefetch_read_disk(full_path.data(), p.data);
+		}
+		if (!found)
+		{
+			PHYSFSX_getRealPath(filename, full_path);
+			found = mix_prefetch_read_disk(full_path.data(), p.data);
+		}
+		if (!found)
+			if (RAIIPHYSFS_File filehandle{PHYSFS_openRead(filename)})
+			{
+				const auto len = PHYSFS_fileLength(filehandle);
+				if (len > 0 && static_cast<std::size_t>(len) <= mix_prefetch_max_size)
+				{
+					p.data.resize(len);
+					if (PHYSFS_read(filehandle, p.data.data(), 1, len) != len)
+						p.data.clear();
+				}
+			}
+	}
+	p.done.store(true, std::memory_order_release);
+	return 0;
+}
+
+/* Never waits for the reader, since the finished-track hook which
+ * starts the next track runs in the audio callback.
+ */
+static bool mix_prefetch_reap()
+{
+	auto &p = mix_prefetch;
+	if (!p.thread)
+		return true;
+	if (!p.done.load(std::memory_order_acquire))
+		return false;
+	SDL_WaitThread(p.thread, nullptr);
+	p.thread = nullptr;
+	return true;
+}
+
+static bool mix_take_prefetched(const char *const filename, std::vector<uint8_t> &data)
+{
+	auto &p = mix_prefetch;
+	if (!p.thread || !mix_prefetch_reap())
+		return false;
+	const bool match = !p.data.empty() && p.filename == filename;
+	if (match)
+		data = std::move(p.data);
+	p.data = {};
+	return match;
+}
+
+void mix_prefetch_file(const char *const filename)
+{
+	auto &p = mix_prefetch;
+	if (!mix_prefetch_reap())
+		return;
+	p.filename = filename;
+	p.data = {};
+	p.done.store(false, std::memory_order_relaxed);
+#if SDL_MAJOR_VERSION == 2
+	p.thread = SDL_CreateThread(mix_prefetch_thread, "mix_prefetch", nullptr);
+#else
+	p.thread = SDL_CreateThread(mix_prefetch_thread, nullptr);
+#endif
+}
+
 /*
  *  Plays a music file from an absolute path or a relative path
  */
@@ -159,6 +308,10 @@ int mix_play_file(const char *filename, int loop, void (*hook_finished_track)())
 		current_music_type = load_mus_data(current_music_hndlbuf.data(), current_music_hndlbuf.size());
 	}
 
+	// a read-ahead copy of the file saves waiting for the disk
+	if (current_music_type == CurrentMusicType::None && mix_take_prefetched(filename, current_music_hndlbuf))
+		current_music_type = load_mus_data(current_music_hndlbuf.data(), current_music_hndlbuf.size());
+
 	// try loading music via given filename
 	if (current_music_type == CurrentMusicType::None)
 		current_music_type = load_mus_file(filename);
@@ -207,6 +360,7 @@ int mix_play_file(const char *filename, int loop, void (*hook_finished_track)())
 	{
 		ADL_MIDIPlayer *adlmidi = get_adlmidi();
 		adl_setLoopEnabled(adlmidi, loop);
+		adlmidi_render_start();
 		Mix_HookMusic(&mix_adlmidi, nullptr);
 		Mix_HookMusicFinished(hook_finished_track ? hook_finished_track : mix_free_music);
 		return 1;
@@ -243,6 +397,7 @@ void mix_free_music()
 	 * whether the music type requires it.
 	 */
 	Mix_HookMusic(nullptr, nullptr);
+	adlmidi_render_stop();
 #endif
 	current_music.reset();
 	current_music_hndlbuf.clear();
@@ -324,20 +479,91 @@ static int16_t sat16(int32_t x)
 	return x;
 }
 
-static void mix_adlmidi(void *, Uint8 *stream, int len)
+static int adlmidi_render_thread(void *)
 {
+	auto &r = adlmidi_render;
+	ADL_MIDIPlayer *const adlmidi = current_adlmidi.get();
 	ADLMIDI_AudioFormat format;
 	format.containerSize = sizeof(int16_t);
 	format.sampleOffset = 2 * format.containerSize;
 	format.type = ADLMIDI_SampleType_S16;
+	constexpr int sampleCount = adlmidi_chunk_frames * 2;
+	while (!r.quit.load(std::memory_order_relaxed))
+	{
+		const auto head = r.head.load(std::memory_order_relaxed);
+		if (head - r.tail.load(std::memory_order_acquire) > adlmidi_ring_frames - adlmidi_chunk_frames)
+		{
+			SDL_SemWait(r.wake);
+			continue;
+		}
+		// Chunks never wrap, since a whole number of them fills the ring
+		const auto samples = &r.ring[(head % adlmidi_ring_frames) * 2];
+		const auto stream = reinterpret_cast<uint8_t *>(samples);
+		auto rendered = adl_playFormat(adlmidi, sampleCount, stream, stream + format.containerSize, &format);
+		if (rendered < 0)
+			rendered = 0;
+		// A song which is not looped ends in silence
+		std::fill(samples + rendered, samples + sampleCount, 0);
+		const auto amplify = [](int16_t i) { return sat16(2 * i); };
+		std::transform(samples, samples + rendered, samples, amplify);
+		r.head.store(head + adlmidi_chunk_frames, std::memory_order_release);
+	}
+	return 0;
+}
 
-	ADL_MIDIPlayer *adlmidi = get_adlmidi();
-	int sampleCount = len / format.containerSize;
-	adl_playFormat(adlmidi, sampleCount, stream, stream + format.containerSize, &format);
+static void adlmidi_render_start()
+{
+	auto &r = adlmidi_render;
+	r.quit.store(false, std::memory_order_relaxed);
+	r.head.store(0, std::memory_order_relaxed);
+	r.tail.store(0, std::memory_order_relaxed);
+	if (!(r.wake = SDL_CreateSemaphore(0)))
+		return;
+#if SDL_MAJOR_VERSION == 2
+	r.thread = SDL_CreateThread(adlmidi_render_thread, "adlmidi", nullptr);
+#else
+	r.thread = SDL_CreateThread(adlmidi_render_thread, nullptr);
+#endif
+	if (!r.thread)
+	{
+		SDL_DestroySemaphore(r.wake);
+		r.wake = nullptr;
+	}
+}
+
+/* Called only after the hook is removed, so the callback no longer
+ * reads the ring.
+ */
+static void adlmidi_render_stop()
+{
+	auto &r = adlmidi_render;
+	if (!r.thread)
+		return;
+	r.quit.store(true, std::memory_order_relaxed);
+	SDL_SemPost(r.wake);
+	SDL_WaitThread(r.thread, nullptr);
+	r.thread = nullptr;
+	SDL_DestroySemaphore(r.wake);
+	r.wake = nullptr;
+}
 
-	const auto samples = reinterpret_cast<int16_t *>(stream);
-	const auto amplify = [](int16_t i) { return sat16(2 * i); };
-	std::transform(samples, samples + sampleCount, samples, amplify);
+static void mix_adlmidi(void *, Uint8 *stream, int len)
+{
+	auto &r = adlmidi_render;
+	const auto out = reinterpret_cast<int16_t *>(stream);
+	const unsigned frames = static_cast<unsigned>(len) / (2 * sizeof(int16_t));
+	const auto tail = r.tail.load(std::memory_order_relaxed);
+	const unsigned available = r.head.load(std::memory_order_acquire) - tail;
+	const auto n = std::min(frames, available);
+	const auto start = tail % adlmidi_ring_frames;
+	const auto first = std::min(n, adlmidi_ring_frames - start);
+	std::copy_n(&r.ring[start * 2], first * 2, out);
+	std::copy_n(&r.ring[0], (n - first) * 2, out + first * 2);
+	// Underrun: play silence rather than wait for the thread
+	std::fill(out + n * 2, out + frames * 2, 0);
+	r.tail.store(tail + n, std::memory_order_release);
+	if (r.wake)
+		SDL_SemPost(r.wake);
 }
 #endif
 
@@ -11,6 +11,7 @@
  *
  */
 
+#include <algorithm>
 #include <SDL.h>
 #include <stdio.h>
 #include <stdlib.h>
@@ -21,9 +22,12 @@
 #include "timer.h"
 #include "config.h"
 #include "inferno.h"
+#include "game.h"
 
 #include "joy.h"
 #include "args.h"
+#include "console.h"
+#include "compiler-array.h"
 
 namespace dcx {
 
@@ -31,6 +35,199 @@ namespace dcx {
 extern SDL_Window *g_pRebirthSDLMainWindow;
 #endif
 
+#if SDL_MAJOR_VERSION == 2
+#define DXX_INPUT_TIMESTAMP(E)	((E).common.timestamp)
+#else
+/* SDL 1.2 events carry no time, so input is timed when it is polled. */
+#define DXX_INPUT_TIMESTAMP(E)	SDL_GetTicks()
+#endif
+
+namespace {
+
+/* For -latency: the time from an input event reaching SDL to the first
+ * buffer swap after the game saw it.  Times are SDL ticks (ms).
+ */
+struct input_latency
+{
+	uint32_t pending;
+	/* Input at or before this was shown by an earlier swap.  Events
+	 * which event_peek_pending saw are polled again later, and must
+	 * not be counted twice.
+	 */
+	uint32_t credited_until;
+	uint32_t latest;
+	bool have_pending;
+	unsigned samples;
+	uint32_t total, best, worst;
+	uint32_t report_time;
+};
+
+input_latency Input_latency;
+
+/* Print the measurements this often. */
+constexpr uint32_t input_latency_report_ms = 5000;
+
+static bool event_is_input(const uint32_t type)
+{
+	switch (type)
+	{
+		case SDL_KEYDOWN:
+		case SDL_KEYUP:
+		case SDL_MOUSEBUTTONDOWN:
+		case SDL_MOUSEBUTTONUP:
+		case SDL_MOUSEMOTION:
+		case SDL_JOYBUTTONDOWN:
+		case SDL_JOYBUTTONUP:
+		case SDL_JOYAXISMOTION:
+		case SDL_JOYHATMOTION:
+			return true;
+		default:
+			return false;
+	}
+}
+
+static void input_latency_note(const SDL_Event &event)
+{
+	if (!event_is_input(event.type))
+		return;
+	auto &l = Input_latency;
+	const uint32_t when = DXX_INPUT_TIMESTAMP(event);
+	if (static_cast<int32_t>(when - l.credited_until) <= 0)
+		return;
+	if (!l.have_pending)
+	{
+		l.have_pending = true;
+		l.pending = when;
+	}
+	l.latest = when;
+}
+
+static void input_latency_note_swap()
+{
+	auto &l = Input_latency;
+	if (!l.have_pending)
+		return;
+	const uint32_t now = SDL_GetTicks();
+	const uint32_t latency = now - l.pending;
+	l.have_pending = false;
+	l.credited_until = l.latest;
+	if (!l.samples)
+	{
+		l.best = l.worst = latency;
+		l.total = 0;
+		l.report_time = now;
+	}
+	++l.samples;
+	l.total += latency;
+	l.best = std::min(l.best, latency);
+	l.worst = std::max(l.worst, latency);
+	if (now - l.report_time < input_latency_report_ms)
+		return;
+	const auto tenths = (l.total * 10) / l.samples;
+	con_printf(CON_NORMAL, "latency: %u inputs shown, input to swap %u/%u.%u/%u ms min/avg/max", l.samples, l.best, tenths / 10, tenths % 10, l.worst);
+	l.samples = 0;
+}
+
+/* Motion from a mouse or stick reporting at several kHz arrives as many
+ * events per frame.  The motion events queued right behind one are
+ * folded into it, so that each run costs one dispatch.  Only a run of
+ * motion is folded, so motion stays in order with keys and buttons.
+ */
+static bool event_peek_head(SDL_Event &next)
+{
+#if SDL_MAJOR_VERSION == 1
+	return SDL_PeepEvents(&next, 1, SDL_PEEKEVENT, SDL_ALLEVENTS) > 0;
+#elif SDL_MAJOR_VERSION == 2
+	return SDL_PeepEvents(&next, 1, SDL_PEEKEVENT, SDL_FIRSTEVENT, SDL_LASTEVENT) > 0;
+#endif
+}
+
+/* Remove the event which event_peek_head returned. */
+static void event_drop_head(const SDL_Event &next)
+{
+	SDL_Event e;
+#if SDL_MAJOR_VERSION == 1
+	SDL_PeepEvents(&e, 1, SDL_GETEVENT, SDL_EVENTMASK(next.type));
+#elif SDL_MAJOR_VERSION == 2
+	SDL_PeepEvents(&e, 1, SDL_GETEVENT, next.type, next.type);
+#endif
+	if (CGameArg.DbgLatency)
+		input_latency_note(e);
+}
+
+/* Add the relative motion of the queued events of the same mouse, and
+ * keep the position of the last.
+ */
+static void event_coalesce_mouse_motion(SDL_MouseMotionEvent &mme)
+{
+	for (SDL_Event next; event_peek_head(next);)
+	{
+		if (next.type != SDL_MOUSEMOTION || next.motion.which != mme.which)
+			return;
+#if SDL_MAJOR_VERSION == 1
+		/* The deltas are 16 bits wide here. */
+		const int xrel = mme.xrel + next.motion.xrel, yrel = mme.yrel + next.motion.yrel;
+		if (xrel != static_cast<Sint16>(xrel) || yrel != static_cast<Sint16>(yrel))
+			return;
+#endif
+		mme.xrel += next.motion.xrel;
+		mme.yrel += next.motion.yrel;
+		mme.x = next.motion.x;
+		mme.y = next.motion.y;
+		mme.state = next.motion.state;
+		event_drop_head(next);
+	}
+}
+
+/* A stick sends its axes in turn, so each axis of the run keeps its
+ * last value.  Returns how many axes `axes` holds, in the order they
+ * first moved.
+ */
+template <std::size_t N>
+static unsigned event_coalesce_joy_axis_motion(const SDL_JoyAxisEvent &jae, array<SDL_JoyAxisEvent, N> &axes)
+{
+	axes[0] = jae;
+	unsigned n = 1;
+	for (SDL_Event next; event_peek_head(next);)
+	{
+		if (next.type != SDL_JOYAXISMOTION)
+			break;
+		const auto &&e = axes.begin() + n;
+		const auto &&i = std::find_if(axes.begin(), e, [&next](const SDL_JoyAxisEvent &a) {
+			return a.which == next.jaxis.which && a.axis == next.jaxis.axis;
+		});
+		if (i != e)
+			i->value = next.jaxis.value;
+		else if (n != N)
+			axes[n++] = next.jaxis;
+		else
+			break;
+		event_drop_head(next);
+	}
+	return n;
+}
+
+}
+
+unsigned event_peek_pending(SDL_Event *const events, const unsigned n, const uint32_t type)
+{
+	SDL_PumpEvents();
+#if SDL_MAJOR_VERSION == 1
+	const int r = SDL_PeepEvents(events, n, SDL_PEEKEVENT, SDL_EVENTMASK(type));
+#elif SDL_MAJOR_VERSION == 2
+	const int r = SDL_PeepEvents(events, n, SDL_PEEKEVENT, type, type);
+#endif
+	if (r <= 0)
+		return 0;
+#if SDL_MAJOR_VERSION == 2
+	/* Only SDL 2 can tell these events apart when they are polled. */
+	if (CGameArg.DbgLatency)
+		for (int i = 0; i != r; ++i)
+			input_latency_note(events[i]);
+#endif
+	return r;
+}
+
 window_event_result event_poll()
 {
 	SDL_Event event;
@@ -42,6 +239,10 @@ window_event_result event_poll()
 	// like pressing 'Return' really fast at 'Difficulty Level' causing multiple games to be started
 	while ((highest_result != window_event_result::deleted) && (wind == window_get_front()) && (event = {}, SDL_PollEvent(&event)))
 	{
+		// Input, focus and expose events can all change what is on screen
+		window_request_redraw();
+		if (CGameArg.DbgLatency)
+			input_latency_note(event);
 		switch(event.type) {
 			case SDL_KEYDOWN:
 			case SDL_KEYUP:
@@ -61,6 +262,7 @@ window_event_result event_poll()
 			case SDL_MOUSEMOTION:
 				if (CGameArg.CtlNoMouse)
 					break;
+				event_coalesce_mouse_motion(event.motion);
 				highest_result = std::max(mouse_motion_handler(&event.motion), highest_result);
 				break;
 			case SDL_JOYBUTTONDOWN:
@@ -72,7 +274,12 @@ window_event_result event_poll()
 			case SDL_JOYAXISMOTION:
 				if (CGameArg.CtlNoJoystick)
 					break;
-				highest_result = std::max(joy_axis_handler(&event.jaxis), highest_result);
+				{
+					array<SDL_JoyAxisEvent, 16> axes;
+					const auto n = event_coalesce_joy_axis_motion(event.jaxis, axes);
+					for (unsigned i = 0; i != n && highest_result != window_event_result::deleted; ++i)
+						highest_result = std::max(joy_axis_handler(&axes[i]), highest_result);
+				}
 				break;
 			case SDL_JOYHATMOTION:
 				if (CGameArg.CtlNoJoystick)
@@ -146,15 +353,47 @@ window_event_result event_send(const d_event &event)
 	return handled;
 }
 
+// Longest time to sleep when the last frame was not drawn, so that idle
+// handlers still run often enough for network menus and blinking cursors
+constexpr unsigned event_idle_wait_ms = 50;
+
+// Set when the previous event_process had nothing to draw
+static bool event_was_idle;
+
+static void event_wait_idle()
+{
+#if SDL_MAJOR_VERSION == 1
+	/* SDL 1.2 has no timed wait, so poll at a coarse interval */
+	for (unsigned waited = 0; waited < event_idle_wait_ms; waited += 10)
+	{
+		SDL_Event event;
+		SDL_PumpEvents();
+		if (SDL_PeepEvents(&event, 1, SDL_PEEKEVENT, SDL_ALLEVENTS) > 0)
+			break;
+		SDL_Delay(10);
+	}
+#elif SDL_MAJOR_VERSION == 2
+	SDL_WaitEventTimeout(nullptr, event_idle_wait_ms);
+#endif
+}
+
 // Process the first event in queue, sending to the appropriate handler
 // This is the new object-oriented system
 // Uses the old system for now, but this may change
 window_event_result event_process(void)
 {
-	window *wind = window_get_front();
 	window_event_result highest_result;
 
+	// Block until there is input instead of spinning through frames that
+	// would look the same as the last one
+	if (event_was_idle)
+		event_wait_idle();
+
+	window *wind = window_get_front();
 	timer_update();
+#if DXX_USE_SCREENSHOT
+	screenshot_service();
+#endif
 
 	highest_result = event_poll();	// send input events first
 
@@ -165,6 +404,13 @@ window_event_result event_process(void)
 	// Also checking for window_event_result::deleted in case a window was created
 	// with the same pointer value as the deleted one
 	if ((highest_result == window_event_result::deleted) || (window_get_front() != wind))
+	{
+		event_was_idle = false;
+		return highest_result;
+	}
+
+	event_was_idle = !window_redraw_needed();
+	if (event_was_idle)
 		return highest_result;
 
 	const d_event event{EVENT_WINDOW_DRAW};	// then draw all visible windows
@@ -189,6 +435,8 @@ window_event_result event_process(void)
 	}
 
 	gr_flip();
+	if (CGameArg.DbgLatency)
+		input_latency_note_swap();
 
 	return highest_result;
 }
@@ -0,0 +1,174 @@
+/*
+ * This file is part of the DXX-Rebirth project <https://www.dxx-rebirth.com/>.
+ * It is copyright by its individual contributors, as recorded in the
+ * project's Git history.  See COPYING.txt at the top level for license
+ * terms and a link to the Git history.
+ */
+/*
+ *
+ * SDL worker thread pool
+ *
+ */
+
+#include <atomic>
+#include <cstdint>
+#include <SDL.h>
+
+#include "jobs.h"
+#include "console.h"
+#include "compiler-array.h"
+
+namespace dcx {
+
+namespace {
+
+// Batches smaller than this run on the calling thread, since waking the
+// workers costs more than the work.
+constexpr unsigned job_pool_min_parallel = 16;
+
+// The indices a thread has not yet started.  Owners and thieves both
+// claim indices by incrementing next, so a range never hands out the
+// same index twice.
+struct alignas(64) job_range
+{
+	std::atomic<unsigned> next;
+	unsigned end;
+};
+
+struct job_worker
+{
+	SDL_Thread *thread;
+	SDL_sem *wake;
+};
+
+struct job_pool_state
+{
+	unsigned threads = 1;
+	bool quit;
+	job_function *fn;
+	void *context;
+	SDL_sem *done;
+	array<job_worker, MAX_JOB_THREADS - 1> workers;
+	array<job_range, MAX_JOB_THREADS> ranges;
+};
+
+static job_pool_state job_pool;
+
+static void job_pool_work(const unsigned thread)
+{
+	auto &p = job_pool;
+	const auto threads = p.threads;
+	for (unsigned i = 0; i != threads; ++i)
+	{
+		auto &r = p.ranges[(thread + i) % threads];
+		for (unsigned index; (index = r.next.fetch_add(1, std::memory_order_relaxed)) < r.end;)
+			p.fn(p.context, index, thread);
+	}
+}
+
+static int job_pool_worker(void *const data)
+{
+	const unsigned thread = reinterpret_cast<uintptr_t>(data);
+	auto &p = job_pool;
+	auto &w = p.workers[thread - 1];
+	for (;;)
+	{
+		SDL_SemWait(w.wake);
+		if (p.quit)
+			return 0;
+		job_pool_work(thread);
+		SDL_SemPost(p.done);
+	}
+}
+
+}
+
+void job_pool_init()
+{
+	auto &p = job_pool;
+	if (p.threads > 1)
+		return;
+#if SDL_MAJOR_VERSION == 2
+	const int cpus = SDL_GetCPUCount();
+	const unsigned want = cpus < 1 ? 1 : (static_cast<unsigned>(cpus) < MAX_JOB_THREADS ? cpus : MAX_JOB_THREADS);
+#else
+	/* SDL 1.2 cannot report the number of processors */
+	const unsigned want = 1;
+#endif
+	if (want < 2)
+		return;
+	p.quit = false;
+	p.done = SDL_CreateSemaphore(0);
+	if (!p.done)
+		return;
+	unsigned threads = 1;
+	for (; threads != want; ++threads)
+	{
+		auto &w = p.workers[threads - 1];
+		w.wake = SDL_CreateSemaphore(0);
+		if (!w.wake)
+			break;
+		void *const data = reinterpret_cast<void *>(static_cast<uintptr_t>(threads));
+#if SDL_MAJOR_VERSION == 2
+		w.thread = SDL_CreateThread(job_pool_worker, "job_pool", data);
+#else
+		w.thread = SDL_CreateThread(job_pool_worker, data);
+#endif
+		if (!w.thread)
+		{
+			SDL_DestroySemaphore(w.wake);
+			break;
+		}
+	}
+	p.threads = threads;
+	con_printf(CON_VERBOSE, "DXX-Rebirth: started %u worker threads", threads - 1);
+}
+
+void job_pool_close()
+{
+	auto &p = job_pool;
+	if (p.threads < 2)
+		return;
+	p.quit = true;
+	for (unsigned i = 1; i != p.threads; ++i)
+	{
+		auto &w = p.workers[i - 1];
+		SDL_SemPost(w.wake);
+		SDL_WaitThread(w.thread, nullptr);
+		SDL_DestroySemaphore(w.wake);
+	}
+	SDL_DestroySemaphore(p.done);
+	p.threads = 1;
+}
+
+unsigned job_pool_threads()
+{
+	return job_pool.threads;
+}
+
+void job_pool_run(const unsigned count, job_function *const fn, void *const context)
+{
+	auto &p = job_pool;
+	const auto threads = p.threads;
+	if (threads < 2 || count < job_pool_min_parallel)
+	{
+		for (unsigned index = 0; index != count; ++index)
+			fn(context, index, 0);
+		return;
+	}
+	p.fn = fn;
+	p.context = context;
+	for (unsigned i = 0; i != threads; ++i)
+	{
+		auto &r = p.ranges[i];
+		r.next.store(count * i / threads, std::memory_order_relaxed);
+		r.end = count * (i + 1) / threads;
+	}
+	for (unsigned i = 1; i != threads; ++i)
+		SDL_SemPost(p.workers[i - 1].wake);
+	job_pool_work(0);
+	for (unsigned i = 1; i != threads; ++i)
+		SDL_SemWait(p.done);
+}
+
+}
@@ -262,6 +262,22 @@ window_event_result joy_axis_handler(SDL_JoyAxisEvent *jae)
 
 	return event_send(event);
 }
+
+bool joy_peek_axis(const unsigned axis, int &value)
+{
+	array<SDL_Event, 64> events;
+	bool found = false;
+	const auto n = event_peek_pending(events.data(), events.size(), SDL_JOYAXISMOTION);
+	for (unsigned i = 0; i != n; ++i)
+	{
+		auto &jae = events[i].jaxis;
+		if (SDL_Joysticks[jae.which].axis_map()[jae.axis] != axis)
+			continue;
+		value = jae.value / 256;
+		found = true;
+	}
+	return found;
+}
 #endif
 
 
@@ -587,6 +587,18 @@ void key_flush()
 		restore_sticky_key(keystate, key);
 }
 
+// Poll Escape directly, for long operations which do not return to the
+// event loop.  The caller should flush the event queue afterward.
+bool key_escape_held()
+{
+	SDL_PumpEvents();
+#if SDL_MAJOR_VERSION == 1
+	return SDL_GetKeyState(nullptr)[SDLK_ESCAPE];
+#elif SDL_MAJOR_VERSION == 2
+	return SDL_GetKeyboardState(nullptr)[SDL_SCANCODE_ESCAPE];
+#endif
+}
+
 int event_key_get(const d_event &event)
 {
 	auto &e = static_cast<const d_event_keycommand &>(event);
@@ -21,6 +21,7 @@
 #include "playsave.h"
 #include "dxxerror.h"
 #include "args.h"
+#include "compiler-array.h"
 #include "gr.h"
 
 namespace dcx {
@@ -154,8 +155,19 @@ window_event_result mouse_button_handler(SDL_MouseButtonEvent *mbe)
 window_event_result mouse_motion_handler(SDL_MouseMotionEvent *mme)
 {
 	Mouse.cursor_time = timer_query();
-	Mouse.x += mme->xrel;
-	Mouse.y += mme->yrel;
+#if !DXX_USE_OGL
+	const auto scale = gr_window_scale();
+	if (scale > 1)
+	{
+		Mouse.x = mme->x / scale;
+		Mouse.y = mme->y / scale;
+	}
+	else
+#endif
+	{
+		Mouse.x += mme->xrel;
+		Mouse.y += mme->yrel;
+	}
 	
 	// z handled in mouse_button_handler
 	const d_event_mouse_moved event{EVENT_MOUSE_MOVED, mme->xrel, mme->yrel, 0};
@@ -165,11 +177,28 @@ window_event_result mouse_motion_handler(SDL_MouseMotionEvent *mme)
 	return event_send(event);
 }
 
+bool mouse_peek_delta(int &dx, int &dy)
+{
+	array<SDL_Event, 64> events;
+	const auto n = event_peek_pending(events.data(), events.size(), SDL_MOUSEMOTION);
+	if (!n)
+		return false;
+	auto &mme = events[n - 1].motion;
+	dx = mme.xrel;
+	dy = mme.yrel;
+	return true;
+}
+
 void mouse_flush()	// clears all mice events...
 {
 //	event_poll();
 	static_cast<flushable_mouseinfo &>(Mouse) = {};
 	SDL_GetMouseState(&Mouse.x, &Mouse.y); // necessary because polling only gives us the delta.
+#if !DXX_USE_OGL
+	const auto scale = gr_window_scale();
+	Mouse.x /= scale;
+	Mouse.y /= scale;
+#endif
 }
 
 //========================================================================
@@ -10,6 +10,7 @@
  *
  */
 
+#include <chrono>
 #include <SDL.h>
 
 #include "maths.h"
@@ -19,23 +20,28 @@
 
 namespace dcx {
 
+namespace {
+
+typedef std::chrono::duration<fix64, std::ratio<1, F1_0>> fix64_duration;
+
+// How often a netgame services packets while waiting for a frame
+constexpr fix network_service_interval = F1_0 / 1000;
+
+}
+
 static fix64 F64_RunTime = 0;
 
+// How much later than requested SDL_Delay tends to return.  Waits stop
+// sleeping this far before the deadline and spin the rest of the way.
+static fix64 sleep_overshoot = F1_0 / 500;
+
 fix64 timer_update()
 {
-	static bool already_initialized;
-	static fix64 last_tv;
-	const fix64 cur_tv = static_cast<fix64>(SDL_GetTicks()) * F1_0 / 1000;
-	const fix64 prev_tv = last_tv;
-	fix64 runtime = F64_RunTime;
-	last_tv = cur_tv;
-	if (unlikely(!already_initialized))
-	{
-		already_initialized = true;
-	}
-	else if (likely(prev_tv < cur_tv)) // in case SDL_GetTicks wraps, don't update and have a little hickup
-		F64_RunTime = (runtime += (cur_tv - prev_tv)); // increment! this value will overflow long after we are all dead... so why bother checking?
-	return runtime;
+	/* Counting from the first call keeps the conversion to fix units
+	 * far away from overflow.
+	 */
+	static const auto start = std::chrono::steady_clock::now();
+	return F64_RunTime = std::chrono::duration_cast<fix64_duration>(std::chrono::steady_clock::now() - start).count();
 }
 
 fix64 timer_query(void)
@@ -48,30 +54,55 @@ void timer_delay_ms(unsigned milliseconds)
 	SDL_Delay(milliseconds);
 }
 
-// Replacement for timer_delay which considers calc time the program needs between frames (not reentrant)
-void timer_delay_bound(const unsigned caller_bound)
+void timer_delay_until(const fix64 deadline, const bool may_sleep)
 {
-	static uint32_t FrameStart;
-
-	uint32_t start = FrameStart;
 	const auto multiplayer = Game_mode & GM_MULTI;
-	const auto vsync = CGameCfg.VSync;
-	const auto bound = vsync ? 1000u / MAXIMUM_FPS : caller_bound;
-	for (;;)
+	fix64 next_service = 0;
+	for (fix64 now; (now = timer_update()) < deadline;)
 	{
-		const uint32_t tv_now = SDL_GetTicks();
-		if (multiplayer)
-			multi_do_frame(); // during long wait, keep packets flowing
-		if (!vsync)
-			SDL_Delay(1);
-		if (unlikely(start > tv_now))
-			start = tv_now;
-		if (unlikely(tv_now - start >= bound))
+		if (multiplayer && now >= next_service)
 		{
-			FrameStart = tv_now;
-			break;
+			multi_do_frame(); // during long wait, keep packets flowing
+			next_service = now + network_service_interval;
+			continue;
 		}
+		if (!may_sleep)
+			continue;
+		auto wake = deadline - sleep_overshoot;
+		if (multiplayer && wake > next_service)
+			wake = next_service;
+		if (wake <= now)
+			continue;
+		const unsigned ms = (wake - now) * 1000 / F1_0;
+		if (!ms)
+			continue;
+		SDL_Delay(ms);
+		// Follow a slower scheduler at once, but only trust a faster
+		// one gradually, since a late wakeup costs a late frame.
+		const auto overshoot = timer_update() - now - static_cast<fix64>(ms) * F1_0 / 1000;
+		if (overshoot > sleep_overshoot)
+			sleep_overshoot = overshoot;
+		else if (overshoot > 0)
+			sleep_overshoot -= (sleep_overshoot - overshoot) / 16;
 	}
 }
 
+// Replacement for timer_delay which considers calc time the program needs between frames (not reentrant)
+void timer_delay_bound(const fix caller_bound)
+{
+	static fix64 FrameStart;
+
+	const auto vsync = CGameCfg.VSync;
+	const fix bound = vsync ? F1_0 / MAXIMUM_FPS : caller_bound;
+	const auto now = timer_update();
+	auto deadline = FrameStart + bound;
+	// Advance by whole frame budgets so that fractional budgets average
+	// out, but a caller which fell behind starts over instead of
+	// rushing through several frames.
+	if (deadline + bound < now)
+		deadline = now;
+	timer_delay_until(deadline, !vsync);
+	FrameStart = deadline;
+}
+
 }
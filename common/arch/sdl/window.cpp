@@ -24,10 +24,12 @@ namespace dcx {
 
 static window *FrontWindow = nullptr;
 static window *FirstWindow = nullptr;
+// Set when something may have changed the picture on screen
+static bool RedrawRequested = true;
 
 window::window(grs_canvas &src, const int x, const int y, const int w, const int h) :
 	// Default to visible and modal
-	w_visible(1), w_modal(1), prev(FrontWindow), next(nullptr), w_exists(nullptr)
+	w_visible(1), w_modal(1), prev(FrontWindow), next(nullptr), w_exists(nullptr), w_redraw_on_demand(false)
 {
 	gr_init_sub_canvas(w_canv, src, x, y, w, h);
 
@@ -38,6 +40,7 @@ window::window(grs_canvas &src, const int x, const int y, const int w, const int
 void window::send_creation_events(const void *const createdata)
 {
 	const auto prev_front = window_get_front();
+	RedrawRequested = true;
 	if (FrontWindow)
 		FrontWindow->next = this;
 	FrontWindow = this;
@@ -60,6 +63,7 @@ window::~window()
 {
 	if (w_exists)
 		*w_exists = false;
+	RedrawRequested = true;
 	if (this == FrontWindow)
 		FrontWindow = this->prev;
 	if (this == FirstWindow)
@@ -142,6 +146,7 @@ void window_select(window &wind)
 	window *prev = window_get_front();
 	if (&wind == FrontWindow)
 		return;
+	RedrawRequested = true;
 	if (&wind == FirstWindow && wind.next)
 		FirstWindow = FirstWindow->next;
 
@@ -169,6 +174,8 @@ void window_select(window &wind)
 window *window_set_visible(window &w, int visible)
 {
 	window *prev = window_get_front();
+	if (w.w_visible != visible)
+		RedrawRequested = true;
 	w.w_visible = visible;
 	auto wind = window_get_front();	// get the new front window
 	if (wind == prev)
@@ -188,11 +195,30 @@ window *window_set_visible(window &w, int visible)
 	return wind;
 }
 
+void window_request_redraw()
+{
+	RedrawRequested = true;
+}
+
+bool window_redraw_needed()
+{
+	if (RedrawRequested)
+	{
+		RedrawRequested = false;
+		return true;
+	}
+	for (auto wind = FirstWindow; wind; wind = wind->next)
+		if (wind->w_visible && !wind->w_redraw_on_demand)
+			return true;
+	return false;
+}
+
 #if !DXX_USE_OGL
 void window_update_canvases()
 {
 	window *wind;
 	
+	RedrawRequested = true;
 	for (wind = FirstWindow; wind != NULL; wind = wind->next)
 		gr_init_sub_bitmap (wind->w_canv.cv_bitmap,
 							*wind->w_canv.cv_bitmap.bm_parent,
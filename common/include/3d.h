@@ -162,12 +162,21 @@ static inline g3s_point g3_rotate_point(const vms_vector &src)
 	return g3_rotate_point(dest, src), dest;
 }
 
+//rotates n points, the same as n calls to g3_rotate_point but without
+//reloading the view for each one.  returns the and/or of their codes
+g3s_codes g3_rotate_points(g3s_point *dest, const vms_vector *src, std::size_t n);
+//as above, for points which are not stored contiguously
+g3s_codes g3_rotate_points(g3s_point *const *dest, const vms_vector *const *src, std::size_t n);
+
 //projects a point
 void g3_project_point(g3s_point &point);
 
 //calculate the depth of a point - returns the z coord of the rotated point
 fix g3_calc_point_depth(const vms_vector &pnt);
 
+//return false if no part of the sphere can be in the view frustum
+bool g3_check_sphere_visible(const vms_vector &center, fix radius);
+
 //from a 2d point, compute the vector through that point
 void g3_point_2_vec(vms_vector &v,short sx,short sy);
 
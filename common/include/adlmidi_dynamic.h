@@ -27,9 +27,16 @@ struct ADLMIDI_AudioFormat
 	unsigned sampleOffset;
 };
 
+/*
+ * Listed from most accurate and most expensive to cheapest.  DOSBOX is
+ * the default; OPAL suits slow machines such as the Raspberry Pi.
+ */
 enum ADL_Emulator
 {
+    ADLMIDI_EMU_NUKED = 0,
+    ADLMIDI_EMU_NUKED_174 = 1,
     ADLMIDI_EMU_DOSBOX = 2,
+    ADLMIDI_EMU_OPAL = 3,
 };
 
 /*
@@ -66,18 +66,29 @@ struct CArg : prohibit_void_ptr<CArg>
 	bool CtlNoCursor;
 	bool CtlNoMouse;
 	bool CtlNoStickyKeys;
+	bool CtlLateLook;
 	bool DbgForbidConsoleGrab;
 	bool DbgShowMemInfo;
 	bool DbgSafelog;
 	bool SysShowCmdHelp;
 	bool SysLowMem;
+	bool SysMapPigFile;
+	bool SysNoMissionCache;
+	bool SysNoModelCache;
+	bool SysNoLevelCache;
+	bool SysRlePin;
 	int8_t SysUsePlayersDir;
 	bool SysAutoRecordDemo;
+	bool SysRecordDemoDelta;
 	bool SysWindow;
 	bool SysAutoDemo;
+	bool SysHeadless;
+	bool SysFastScreenshots;
 	bool GfxSkipHiresFNT;
+	unsigned GfxWindowDepth;
 	bool SndNoSound;
 	bool SndNoMusic;
+	bool SndLazyLoad;
 	bool SysNoBorders;
 	bool SysNoTitles;
 #if DXX_USE_SDLMIXER
@@ -94,6 +105,19 @@ struct CArg : prohibit_void_ptr<CArg>
 	bool OglFixedFont;
 	SyncGLMethod OglSyncMethod;
 	bool OglDarkEdges;
+	bool OglWorldBuffer;
+	bool OglSortFaces;
+	bool OglOverlayShader;
+	bool OglPixelLight;
+	bool OglModelBuffer;
+	bool OglAsyncUpload;
+	bool OglOcclusionQueries;
+	bool OglTextureCache;
+	unsigned OglVramBudget;
+	bool OglPipeline;
+	unsigned OglDynresTarget;
+	unsigned OglModelLod;
+	bool OglInstancing;
 	bool DbgUseOldTextureMerge;
 	bool DbgGlIntensity4Ok;
 	bool DbgGlReadPixelsOk;
@@ -104,17 +128,27 @@ struct CArg : prohibit_void_ptr<CArg>
 #else
 	bool DbgSdlHWSurface;
 	bool DbgSdlASyncBlit;
+	unsigned SdlRenderScale;
 #endif
 	bool DbgNoRun;
 	bool DbgNoDoubleBuffer;
 	bool DbgNoCompressPigBitmap;
 	bool DbgRenderStats;
+	bool DbgLatency;
+	bool DbgNoPVS;
+	bool DbgNoJobs;
 	uint8_t DbgBpp;
 	int8_t DbgVerbose;
 	bool SysNoNiceFPS;
 	int SysMaxFPS;
+	unsigned SysFixedTickRate;
+	unsigned SysRleCacheSize;
+	unsigned SysAiLodDepth;
+	unsigned SysRewindInterval;
+	unsigned SysDemoVideoFPS;
 	uint16_t MplUdpHostPort;
 	uint16_t MplUdpMyPort;
+	uint16_t MplUdpInterpDelay;
 #if DXX_USE_TRACKER
 	uint16_t MplTrackerPort;
 	std::string MplTrackerAddr;
@@ -123,8 +157,18 @@ struct CArg : prohibit_void_ptr<CArg>
 	std::string SysHogDir;
 	std::string SysPilot;
 	std::string SysRecordDemoNameTemplate;
+	std::string SysDemoStats;
+	std::string SysDemoVideo;
+	std::string SysTimeDemo;
+	std::string SysReplayRecord;
+	std::string SysReplay;
+	std::string SysReplayCheck;
+	std::string SysDemoBatch;
 	std::string MplUdpHostAddr;
+	std::string MplUdpAutoHost;
+	std::string MplUdpStatsFile;
 	std::string DbgAltTex;
+	std::string DbgTraceFile;
 #if !DXX_USE_OGL
 	std::string DbgTexMap;
 #endif
@@ -151,6 +195,9 @@ struct Arg : prohibit_void_ptr<Arg>
 	bool EdiSaveHoardData;
 	bool EdiMacData; // also used for some read routines in non-editor build
 #endif
+#if DXX_USE_EDITOR
+	bool EdiNoTblCache;
+#endif
 };
 
 extern struct Arg GameArg;
@@ -14,7 +14,7 @@
 #ifdef dsx
 namespace dcx {
 struct sound_object;
-constexpr std::integral_constant<int, 16> digi_max_channels{};
+constexpr std::integral_constant<int, 64> digi_max_channels{};
 }
 namespace dsx {
 int digi_audio_init();
@@ -28,6 +28,8 @@ void digi_audio_set_channel_pan(int, int );
 void digi_audio_stop_sound(int );
 void digi_audio_end_sound(int );
 void digi_audio_set_digi_volume(int);
+void digi_audio_prefetch_sound(short);
+void digi_audio_convert_sounds();
 }
 #endif
 
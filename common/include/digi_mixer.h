@@ -26,6 +26,8 @@ int digi_mixer_is_channel_playing(int);
 void digi_mixer_reset();
 void digi_mixer_stop_all_channels();
 void digi_mixer_set_digi_volume(int);
+void digi_mixer_prefetch_sound(short);
+void digi_mixer_convert_sounds();
 }
 #endif
 
@@ -17,6 +17,8 @@ namespace dcx {
 
 int mix_play_music(const char *, int);
 int mix_play_file(const char *, int, void (*)());
+// Read a file in the background for a following mix_play_file of it.
+void mix_prefetch_file(const char *);
 void mix_set_music_volume(int);
 void mix_stop_music();
 void mix_pause_music();
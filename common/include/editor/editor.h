@@ -181,7 +181,6 @@ extern	class window *Pad_info;		// Keypad text
 extern	int		Show_axes_flag;		// 0 = don't show, !0 = do show coordinate axes in *Cursegp orientation
 
 namespace dcx {
-extern   int		Autosave_count;		// Current counter for which autosave mine we are "on"
 extern	int		Autosave_flag;			// Whether or not Autosave is on.
 extern	struct tm Editor_time_of_day;
 }
@@ -386,6 +385,19 @@ int med_find_adjacent_segment_side(vmsegptridx_t sp, int side, imsegptridx_t &ad
 // Finds the closest segment and side to sp:side.
 int med_find_closest_threshold_segment_side(vmsegptridx_t sp, int side, imsegptridx_t &adj_sp, int *adj_side, fix threshold);
 
+// While one of these exists, the two searches above and med_form_joint
+// look segments up in a spatial index instead of scanning the mine.
+// Commands which form many joints hold one for their whole run.
+class med_segment_index_scope
+{
+	const bool owner;
+public:
+	med_segment_index_scope();
+	~med_segment_index_scope();
+	med_segment_index_scope(const med_segment_index_scope &) = delete;
+	med_segment_index_scope &operator=(const med_segment_index_scope &) = delete;
+};
+
 // Select previous segment.
 //	If there is a connection on the side opposite to the current side, then choose that segment.
 // If there is no connecting segment on the opposite face, try any segment.
@@ -401,15 +413,21 @@ void copy_uvs_seg_to_seg(unique_segment &destseg, const unique_segment &srcseg);
 
 //	Return N_found_segs = number of concave segments in mine.
 //	Segment ids stored at Found_segs
+//	Checks every segment.
 extern void find_concave_segs(void);
 
 //	High level call.  Check for concave segments, print warning message (using editor_status)
 //	if any concave segments.
-//	Calls find_concave_segs, therefore N_found_segs gets set, and Found_segs filled in.
+//	Fills in the same list as find_concave_segs, but only rechecks the segments whose
+//	vertices or connections changed since the last check.
 extern void warn_if_concave_segments(void);
 
 //	Warn if segment s is concave.
 void warn_if_concave_segment(vmsegptridx_t s);
+
+//	Like validate_segment_all, but only for the segments whose vertices or
+//	connections changed since the last call.
+void validate_changed_segments();
 }
 
 //	Add a vertex to the vertex list.
@@ -469,6 +487,7 @@ int save_mine_data_compiled(PHYSFS_File *SaveFile);
 }
 #endif
 void editor_status( const char *text);
+void editor_status_show();
 
 extern int MacroNumEvents;
 extern int MacroStatus;
@@ -481,30 +500,41 @@ extern	int	Num_tilings;						// number of tilings/wall
 extern	int	Degenerate_segment_found;
 
 namespace dcx {
+extern void set_editor_time_of_day();
+}
+
+#ifdef dsx
+namespace dsx {
 
 // Initializes autosave system.
-// Sets global Autosave_count to 0.
+// Sets Autosave_count to 0 and starts a new undo history.
 extern void init_autosave(void);
 
 // Closes autosave system.
-// Deletes all autosaved files.
+// Deletes all autosaved files and the undo history.
 extern void close_autosave(void);
 
-// Saves current mine to name.miX where name = suffix of mine name and X = Autosave_count.
-// For example, if name = "cookie.min", and Autosave_count = 3, then writes "cookie.mi3".
-// Increments Autosave_count, wrapping from 9 to 0.
-// (If there is no current mine name, assume "temp.min")
-// Call med_save_mine to save the mine.
-extern void autosave_mine(const char *name);
-
 // Timed autosave
+// Every AUTOSAVE_PERIOD minutes, if Autosave_flag is set, saves the mine
+// to the next of the rotating name.mi0 .. name.mi9 files.
 extern void TimedAutosave(const char *name);
-extern void set_editor_time_of_day();
 
-// Undo function
-extern int undo(void);
-extern array<const char *, 10> undo_status;
+// Undo history, kept in memory.
+// An operation is everything which changed between two checkpoints.
+// Call undo_checkpoint after an edit (or before, in which case the edit is
+// recorded by the next checkpoint or undo) and optionally label it with
+// undo_set_status.  The message is shown when the operation is undone.
+void undo_checkpoint();
+void undo_set_status(const char *status);
+// Forget the history and take the current mine as the starting point.
+// Call after loading or creating a mine.
+void undo_reset();
+// Return 0 and set status to the operation's label (or nullptr) if an
+// operation was undone or redone, 1 if there was nothing to undo or redo.
+extern int undo(const char *&status);
+extern int redo(const char *&status);
 }
+#endif
 
 extern char mine_filename[PATH_MAX];
 
@@ -79,6 +79,7 @@ int select_segment_with_powerup();
 
 // In editor.c
 int UndoCommand();
+int RedoCommand();
 
 // In kview.c
 int ZoomOut();
@@ -294,6 +295,7 @@ int SetPlayerFromCurseg();
 int SetPlayerFromCursegAndRotate();
 int SetPlayerFromCursegMinusOne();
 int FindConcaveSegs();
+int CheckMine();
 int do_reset_orient();
 int GameZoomOut();
 int GameZoomIn();
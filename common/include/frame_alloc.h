@@ -0,0 +1,65 @@
+/*
+ * This file is part of the DXX-Rebirth project <https://www.dxx-rebirth.com/>.
+ * It is copyright by its individual contributors, as recorded in the
+ * project's Git history.  See COPYING.txt at the top level for license
+ * terms and a link to the Git history.
+ */
+
+/*
+ *
+ * Header for the scratch memory of the drawing functions
+ *
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <type_traits>
+#include <vector>
+
+#ifdef __cplusplus
+namespace dcx {
+
+/* Scratch memory for buffers which live only as long as one drawing
+ * call, such as the vertex arrays passed to OpenGL.  A scope takes its
+ * allocations from one buffer in stack order and gives them all back
+ * when it ends, so drawing a frame normally allocates nothing from the
+ * heap.
+ *
+ * A request which does not fit is taken from the heap instead, and the
+ * buffer grows to fit it at the next frame_alloc_start_frame.  Only the
+ * main thread may use scopes.
+ */
+class frame_alloc_scope
+{
+	const std::size_t mark;
+	std::vector<std::unique_ptr<uint8_t[]>> overflow;
+	void *allocate_bytes(std::size_t bytes, std::size_t alignment);
+public:
+	frame_alloc_scope();
+	frame_alloc_scope(const frame_alloc_scope &) = delete;
+	frame_alloc_scope &operator=(const frame_alloc_scope &) = delete;
+	~frame_alloc_scope();
+	/* The memory is not initialized. */
+	template <typename T>
+		T *allocate(const std::size_t count)
+		{
+			static_assert(std::is_trivially_destructible<T>::value, "frame_alloc_scope does not run destructors");
+			return static_cast<T *>(allocate_bytes(count * sizeof(T), alignof(T)));
+		}
+};
+
+/* Called by render_start_frame.  Grow the buffer if the last frame
+ * needed more than it holds.
+ */
+void frame_alloc_start_frame();
+/* Number of requests taken from the heap since the program started.
+ * This stays constant once the buffer has grown to fit a typical
+ * frame.
+ */
+unsigned frame_alloc_heap_allocations();
+
+}
+#endif
@@ -10,6 +10,8 @@
 #include <cstdint>
 #include "dxxsconf.h"
 
+union SDL_Event;
+
 namespace dcx {
 
 struct d_event;
@@ -45,6 +47,11 @@ static inline void event_toggle_focus(int activate_focus)
 		event_disable_focus();
 }
 
+/* Copy up to n queued events of this SDL event type into events, leaving
+ * them queued for event_poll.  Returns the number copied.
+ */
+unsigned event_peek_pending(union SDL_Event *events, unsigned n, uint32_t type);
+
 #if DXX_USE_EDITOR
 // See how long we were idle for
 void event_reset_idle_seconds();
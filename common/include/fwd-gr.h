@@ -402,6 +402,14 @@ int gr_check_fullscreen();
  */
 void gr_toggle_fullscreen();
 
+#if !DXX_USE_OGL
+/*
+ * window pixels per canvas pixel: above 1 when -sdl_scale draws the
+ * canvas at a reduced size and a video overlay scales it up
+ */
+unsigned gr_window_scale();
+#endif
+
 void ogl_do_palfx();
 void ogl_init_pixel_buffers(unsigned w, unsigned h);
 void ogl_close_pixel_buffers();
@@ -44,6 +44,9 @@ grs_canvas &window_get_canvas(window &wind);
 void window_update_canvases();
 #endif
 int window_is_modal(window &wind);
+void window_request_redraw();
+// Whether the next frame must be drawn.  Clears the pending request.
+bool window_redraw_needed();
 
 #define WINDOW_SEND_EVENT(w)	((WINDOW_SEND_EVENT)(*w, event, __FILE__, __LINE__))
 
@@ -265,6 +265,23 @@ class grs_subbitmap : public grs_bitmap
 };
 
 //font structure
+/* Sizes recently measured by gr_get_string_size.  Menus and the HUD
+ * measure the same short strings every frame.
+ */
+struct grs_font_size_cache
+{
+	static constexpr std::size_t max_text = 48;
+	struct entry
+	{
+		float scale;
+		unsigned max_chars_per_line;
+		float width;
+		unsigned lines;
+		array<char, max_text> text;
+	};
+	array<entry, 64> entries;
+};
+
 struct grs_font : public prohibit_void_ptr<grs_font>
 {
 	int16_t     ft_w;           // Width in pixels
@@ -279,6 +296,10 @@ struct grs_font : public prohibit_void_ptr<grs_font>
 	const int16_t *ft_widths = nullptr;      // Array of widths (required for prop font)
 	const uint8_t *ft_kerndata = nullptr;    // Array of kerning triplet data
 	std::unique_ptr<uint8_t[]> ft_allocdata;
+	// ft_kerndata as a square table indexed by the pair of offset
+	// characters.  UINT16_MAX where the pair has no kerning entry.
+	std::unique_ptr<uint16_t[]> ft_kerntable;
+	mutable std::unique_ptr<grs_font_size_cache> ft_size_cache;
 #if DXX_USE_OGL
 	// These fields do not participate in disk i/o!
 	std::unique_ptr<grs_bitmap[]> ft_bitmaps;
@@ -20,20 +20,54 @@ COPYRIGHT 1993-1999 PARALLAX SOFTWARE CORPORATION.  ALL RIGHTS RESERVED.
 
 #pragma once
 
-#include <map>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
 
 namespace dcx {
 
+/* Case-insensitive map from names to indices, using open addressing.
+ * Keys are not copied, so they must outlive the table.  Inserting a key
+ * which is already present keeps the old value.
+ */
 struct hashtable
 {
-	struct compare_t
+	struct entry
 	{
-		bool operator()(const char *l, const char *r) const;
+		uint32_t hash;
+		int value;
+		const char *key;
 	};
-	std::map<const char *, int, compare_t> m;
+	std::vector<entry> table;
+	unsigned count = 0;
 };
 
 int hashtable_search( hashtable *ht, const char *key );
 void hashtable_insert( hashtable *ht, const char *key, int value );
+// Recompute the hashes after keys were changed in place.
+void hashtable_rehash(hashtable *ht);
+
+/* 64-bit FNV-1a over arbitrary bytes, for cache keys. */
+class fnv1a_hash
+{
+	uint64_t h = 0xcbf29ce484222325ull;
+public:
+	void add(const void *const p, const std::size_t len)
+	{
+		auto b = reinterpret_cast<const uint8_t *>(p);
+		for (const auto e = b + len; b != e; ++b)
+			h = (h ^ *b) * 0x100000001b3ull;
+	}
+	template <typename T>
+		void add(const T &t)
+		{
+			add(std::addressof(t), sizeof(t));
+		}
+	uint64_t get() const
+	{
+		return h;
+	}
+};
 
 }
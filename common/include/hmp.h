@@ -93,7 +93,11 @@ struct hmp_file
 };
 
 std::unique_ptr<hmp_file> hmp_open(const char *filename);
+// Converted songs are cached, so converting a song again is a copy.
 void hmp2mid(const char *hmp_name, std::vector<uint8_t> &midbuf);
+// Start converting hmp_name in the background, so that a following
+// hmp2mid of it need not wait for the conversion.
+void hmp2mid_prefetch(const char *hmp_name);
 #ifdef _WIN32
 void hmp_setvolume(hmp_file *hmp, int volume);
 int hmp_play(hmp_file *hmp, int bLoop);
@@ -0,0 +1,106 @@
+/*
+ * This file is part of the DXX-Rebirth project <https://www.dxx-rebirth.com/>.
+ * It is copyright by its individual contributors, as recorded in the
+ * project's Git history.  See COPYING.txt at the top level for license
+ * terms and a link to the Git history.
+ */
+/*
+ *
+ * The indexed HOG format, written by hogcreate -2
+ *
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include "byteutil.h"
+#include "dxxsconf.h"
+#include "compiler-array.h"
+
+namespace dcx {
+
+/* A classic HOG is "DHF" followed by each member, its name and size
+ * just before its data, so opening it means reading the whole file.
+ *
+ * An indexed HOG starts with a header and the directory of all its
+ * members, so that one read finds every member:
+ *
+ *	header, 16 bytes:
+ *		char signature[4];	"DHG2", which a classic HOG reader rejects
+ *		uint32 version;	hog2_version
+ *		uint32 count;	number of directory entries
+ *		uint32 alignment;	power of two to which each member's data is aligned
+ *	directory, count entries of 56 bytes each:
+ *		char name[32];	NUL padded
+ *		uint64 offset;	of the data from the start of the file
+ *		uint32 stored_size;	bytes of data in the file
+ *		uint32 size;	bytes of data after decompression
+ *		uint32 method;	hog2_method
+ *		uint32 reserved;	0
+ *	data of each member
+ *
+ * All integers are little endian.  The entries are sorted by
+ * hog2_compare_name, so a member is found by binary search.  Stored
+ * members can be mapped straight from the file.
+ */
+
+constexpr array<char, 4> hog2_signature{{'D', 'H', 'G', '2'}};
+constexpr uint32_t hog2_version = 2;
+constexpr std::size_t hog2_header_size = 16;
+constexpr std::size_t hog2_entry_size = 56;
+constexpr std::size_t hog2_name_size = 32;
+
+enum class hog2_method : uint32_t
+{
+	stored,
+	/* zlib stream, as written by compress2 */
+	deflate,
+};
+
+struct hog2_header
+{
+	uint32_t count;
+	uint32_t alignment;
+};
+
+struct hog2_entry
+{
+	array<char, hog2_name_size> name;
+	uint64_t offset;
+	uint32_t stored_size, size;
+	hog2_method method;
+};
+
+/* Return false if the header is not of a version this build reads. */
+static inline bool hog2_parse_header(const uint8_t *const p, hog2_header &h)
+{
+	if (memcmp(p, hog2_signature.data(), hog2_signature.size()) || GET_INTEL_INT(p + 4) != hog2_version)
+		return false;
+	h.count = GET_INTEL_INT(p + 8);
+	h.alignment = GET_INTEL_INT(p + 12);
+	return h.alignment && !(h.alignment & (h.alignment - 1));
+}
+
+static inline void hog2_parse_entry(const uint8_t *const p, hog2_entry &e)
+{
+	memcpy(e.name.data(), p, hog2_name_size);
+	/* A name which fills the field is cut, rather than read past. */
+	e.name.back() = 0;
+	e.offset = GET_INTEL_INT(p + 32) | (static_cast<uint64_t>(GET_INTEL_INT(p + 36)) << 32);
+	e.stored_size = GET_INTEL_INT(p + 40);
+	e.size = GET_INTEL_INT(p + 44);
+	e.method = static_cast<hog2_method>(GET_INTEL_INT(p + 48));
+}
+
+/* Member names are compared without regard to ASCII case, as the game
+ * looks members up by names in any case.
+ */
+int hog2_compare_name(const char *a, const char *b);
+
+/* Register the PhysFS archiver for indexed HOGs, so that they can be
+ * added to the search path like any other archive.
+ */
+void hog2_register_archiver();
+
+}
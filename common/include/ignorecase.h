@@ -82,6 +82,21 @@ namespace dcx {
  */
 int PHYSFSEXT_locateCorrectCase(char *buf);
 
+/**
+ * \fn void PHYSFSEXT_flushCaseCache()
+ * \brief Forget the directory listings PHYSFSEXT_locateCorrectCase keeps.
+ *
+ * The listing of each directory is read once and kept, so that a name
+ *  which differs only in case is found without listing the directory again.
+ *  Call this whenever the search path changes.  Files which the game writes
+ *  later are still found under the name they were written with, since
+ *  exact matches are checked before the listing; a file which appears
+ *  under a name in another case is only found after the next flush.
+ *
+ * Only the main thread may call either function.
+ */
+void PHYSFSEXT_flushCaseCache();
+
 /* end of ignorecase.h ... */
 
 }
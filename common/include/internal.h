@@ -12,6 +12,7 @@
 #if DXX_USE_OGL
 #include "ogl_init.h" // interface to OpenGL module
 #include "gr.h"
+#include "compiler-array.h"
 
 #ifdef __cplusplus
 
@@ -24,9 +25,103 @@ namespace dcx {
 extern int linedotscale;
 
 extern int GL_TEXTURE_2D_enabled;
+
+enum ogl_client_array : uint8_t
+{
+	ogl_client_array_vertex = 1,
+	ogl_client_array_color = 2,
+	ogl_client_array_texcoord = 4,
+	/* Set when the enabled arrays are not known. */
+	ogl_client_array_unknown = 0x80,
+};
+
+/* Shadow copy of the GL state which nearly every draw sets, so that
+ * calls which would not change it are skipped.  All changes to this
+ * state must go through the functions below.  ogl_state_reset forgets
+ * it, for when a new context is made or GL changed it behind our back.
+ */
+struct ogl_state_cache
+{
+	static constexpr GLuint unknown_texture = ~0u;
+	static constexpr GLenum unknown_blend = ~0u;
+	/* Texture bound to GL_TEXTURE_2D on texture units 0 and 1 */
+	array<GLuint, 2> texture_2d;
+	uint8_t active_texture;
+	uint8_t client_arrays;
+	int8_t depth_test;
+	GLenum blend_src, blend_dst;
+	/* Calls skipped since the last gr_flip, and during the last frame */
+	unsigned skipped, skipped_last_frame;
+};
+
+extern ogl_state_cache Ogl_state;
+
+void ogl_state_reset();
+
+static inline void ogl_state_skipped()
+{
+	++Ogl_state.skipped;
+}
+
+static inline void ogl_bind_texture_2d(const GLuint handle)
+{
+	auto &bound = Ogl_state.texture_2d[Ogl_state.active_texture];
+	if (bound == handle)
+	{
+		ogl_state_skipped();
+		return;
+	}
+	bound = handle;
+	glBindTexture(GL_TEXTURE_2D, handle);
+}
+
+/* A deleted texture is unbound, and its name may be reused. */
+static inline void ogl_delete_texture(GLuint &handle)
+{
+	for (auto &bound : Ogl_state.texture_2d)
+		if (bound == handle)
+			bound = 0;
+	glDeleteTextures(1, &handle);
+}
+
+/* unit is 0 or 1, for GL_TEXTURE0 and GL_TEXTURE1 */
+void ogl_active_texture(unsigned unit);
+
+static inline void ogl_blend_func(const GLenum s, const GLenum d)
+{
+	auto &c = Ogl_state;
+	if (c.blend_src == s && c.blend_dst == d)
+	{
+		ogl_state_skipped();
+		return;
+	}
+	c.blend_src = s;
+	c.blend_dst = d;
+	glBlendFunc(s, d);
+}
+
+static inline void ogl_depth_test(const bool enable)
+{
+	if (Ogl_state.depth_test == enable)
+	{
+		ogl_state_skipped();
+		return;
+	}
+	Ogl_state.depth_test = enable;
+	if (enable)
+		glEnable(GL_DEPTH_TEST);
+	else
+		glDisable(GL_DEPTH_TEST);
+}
+
+/* Enable exactly the client arrays in mask.  Arrays are left enabled
+ * after a draw, so every glDrawArrays or glDrawElements must be
+ * preceded by a call which names the arrays it reads.
+ */
+void ogl_set_client_arrays(uint8_t mask);
 }
 
-#define OGL_SET_FEATURE_STATE(G,V,F)	static_cast<void>(G != V && (G = V, F, 0))
+#define OGL_SET_FEATURE_STATE(G,V,F)	static_cast<void>(G != V ? (G = V, F, 0) : (ogl_state_skipped(), 0))
 #define OGL_ENABLE(a)	OGL_SET_FEATURE_STATE(GL_##a##_enabled, 1, glEnable(GL_##a))
 #define OGL_DISABLE(a)	OGL_SET_FEATURE_STATE(GL_##a##_enabled, 0, glDisable(GL_##a))
 
@@ -42,6 +137,7 @@ static inline void OGL_VIEWPORT(const unsigned x, const unsigned y, const unsign
 {
 	if (w!=last_width || h!=last_height)
 	{
+		ogl_flush_text_batch();
 		last_width = w;
 		last_height = h;
 		glViewport(x,grd_curscreen->sc_canvas.cv_bitmap.bm_h-y-h,w,h);
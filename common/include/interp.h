@@ -17,6 +17,7 @@
 #include "3d.h"
 
 #ifdef __cplusplus
+#include <vector>
 #include "dxxsconf.h"
 #include "dsx-ns.h"
 #include "compiler-array.h"
@@ -26,6 +27,90 @@ class submodel_angles;
 
 constexpr std::integral_constant<std::size_t, 1000> MAX_POLYGON_VECS{};
 struct polygon_model_points : array<g3s_point, MAX_POLYGON_VECS> {};
+
+/* A polygon model flattened by g3_build_polygon_model_mesh, so that it
+ * can be drawn without running the interpreter.  Each node holds the
+ * polygons of one submodel and the submodels it calls.  Node 0 is the
+ * root of the model.
+ *
+ * The sphere of a node, in the frame of the node, bounds its polygons
+ * and those of every submodel it calls at any angle.  Its reduced
+ * polygons, in lod_polygons, are the largest of its polygons, which a
+ * distant model is drawn with.
+ */
+struct polymodel_mesh
+{
+	struct vertex
+	{
+		vms_vector p;
+		fix u, v;
+		uint16_t point;	// index of p in the model's point list
+	};
+	struct polygon
+	{
+		vms_vector point, normal;
+		uint16_t first_vertex;
+		uint8_t nv;
+		uint8_t bitmap;
+		uint8_t glow;	// glow_values slot, or UINT8_MAX
+	};
+	struct subcall
+	{
+		vms_vector offset;
+		uint16_t node;
+		uint8_t submodel;
+	};
+	struct node
+	{
+		vms_vector center;
+		fix radius;
+		uint16_t first_polygon, n_polygons;
+		uint16_t first_subcall, n_subcalls;
+		uint16_t first_lod_polygon, n_lod_polygons;
+	};
+	std::vector<vertex> vertices;
+	std::vector<polygon> polygons;
+	std::vector<subcall> subcalls;
+	std::vector<node> nodes;
+	std::vector<uint16_t> lod_polygons;	// indices into polygons
+};
+
+/* A polygon model compiled by g3_build_polygon_model_draw_list into one
+ * array of operations, so that drawing does not decode the bytecode.
+ * The operations drawn by a sort normal or a subcall follow it, up to
+ * its end.  A sort normal draws [index + 1, split) and [split, end) in
+ * the order that its plane test picks.  The split of a subcall is the
+ * index in spheres of the bounds of what it draws, in the frame of the
+ * submodel, or UINT32_MAX if they are not known.
+ */
+struct polymodel_draw_list
+{
+	enum class op_type : uint8_t
+	{
+		defpoints,
+		defp_start,
+		flatpoly,
+		tmappoly,
+		sortnorm,
+		rodbm,
+		subcall,
+		glow,
+	};
+	struct op
+	{
+		const uint8_t *p;	// the record in the model data
+		uint32_t split, end;
+		uint16_t count;	// points or polygon vertices
+		op_type type;
+	};
+	struct sphere
+	{
+		vms_vector center;
+		fix radius;
+	};
+	std::vector<op> ops;
+	std::vector<sphere> spheres;
+};
 }
 
 #ifdef dsx
@@ -44,8 +129,19 @@ struct glow_values_t : public array<fix, glow_array_size> {};
 //is really a seperate pipeline. returns true if drew
 void g3_draw_polygon_model(grs_bitmap *const *model_bitmaps, polygon_model_points &Interp_point_list, grs_canvas &, submodel_angles anim_angles, g3s_lrgb model_light, const glow_values_t *glow_values, const uint8_t *p);
 
+//draw a model compiled by g3_build_polygon_model_draw_list
+void g3_draw_polygon_model(const polymodel_draw_list &, grs_bitmap *const *model_bitmaps, polygon_model_points &Interp_point_list, grs_canvas &, submodel_angles anim_angles, g3s_lrgb model_light, const glow_values_t *glow_values);
+
 //init code for bitmap models
 int16_t g3_init_polygon_model(void *model_ptr);
+
+//compile a model into a draw list.  returns false if the model data is
+//not valid
+bool g3_build_polygon_model_draw_list(const uint8_t *model_ptr, polymodel_draw_list &);
+
+//flatten a model into a mesh.  returns false if the model uses
+//flat polygons or rod bitmaps, which meshes do not represent
+bool g3_build_polygon_model_mesh(const uint8_t *model_ptr, polymodel_mesh &mesh);
 }
 #endif
 
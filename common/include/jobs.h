@@ -0,0 +1,51 @@
+/*
+ * This file is part of the DXX-Rebirth project <https://www.dxx-rebirth.com/>.
+ * It is copyright by its individual contributors, as recorded in the
+ * project's Git history.  See COPYING.txt at the top level for license
+ * terms and a link to the Git history.
+ */
+
+/*
+ *
+ * Header for the worker thread pool
+ *
+ */
+
+#pragma once
+
+#include <type_traits>
+
+#ifdef __cplusplus
+namespace dcx {
+
+// Most threads, including the calling thread, that a batch will use.
+// Per-thread scratch buffers can be sized with this.
+constexpr std::integral_constant<unsigned, 8> MAX_JOB_THREADS{};
+
+typedef void job_function(void *context, unsigned index, unsigned thread);
+
+void job_pool_init();
+void job_pool_close();
+// Number of threads, including the calling thread, which job_pool_run
+// can use.  1 if the pool could not start any workers.
+unsigned job_pool_threads();
+
+// Call fn(context, index, thread) once for every index in [0, count),
+// spread over the worker threads and the calling thread, and return
+// when every call has finished.  thread is below MAX_JOB_THREADS and
+// no two calls with the same thread run at once.  Each thread first
+// runs its own share of the indices, then steals from the others.
+// Calls must not write to anything another index can see.
+void job_pool_run(unsigned count, job_function *fn, void *context);
+
+template <typename F>
+static inline void job_pool_run(const unsigned count, F &&f)
+{
+	typedef typename std::remove_reference<F>::type function_type;
+	job_pool_run(count, [](void *const context, const unsigned index, const unsigned thread) {
+		(*static_cast<function_type *>(context))(index, thread);
+	}, &f);
+}
+
+}
+#endif
@@ -61,6 +61,8 @@ extern window_event_result joy_hat_handler(SDL_JoyHatEvent *jhe);
 
 #if DXX_MAX_AXES_PER_JOYSTICK
 extern window_event_result joy_axis_handler(SDL_JoyAxisEvent *jae);
+/* Get the value of the last event for this axis still queued, if any. */
+bool joy_peek_axis(unsigned axis, int &value);
 #else
 #define joy_axis_handler(jbe) (static_cast<SDL_JoyAxisEvent *const &>(jbe), window_event_result::ignored)
 #endif
@@ -61,6 +61,7 @@ extern fix64 keyd_time_when_last_pressed;
 extern array<unsigned char, KEY_BUFFER_SIZE> unicode_frame_buffer;
 
 extern void key_flush();    // Clears the 256 char buffer
+bool key_escape_held();	// Polls the keyboard for Escape, outside the event loop
 extern int event_key_get(const d_event &event);	// Get the keycode from the EVENT_KEY_COMMAND event
 extern int event_key_get_raw(const d_event &event);	// same as above but without mod states
 unsigned char key_ascii();
@@ -0,0 +1,78 @@
+/*
+ * This file is part of the DXX-Rebirth project <https://www.dxx-rebirth.com/>.
+ * It is copyright by its individual contributors, as recorded in the
+ * project's Git history.  See COPYING.txt at the top level for license
+ * terms and a link to the Git history.
+ */
+
+/*
+ *
+ * Header for the arena of tables which last for one level
+ *
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <type_traits>
+#include <vector>
+#include "dxxsconf.h"
+
+#ifdef __cplusplus
+namespace dcx {
+
+/* Memory which is handed out in order and released all at once when
+ * the next level is loaded, for the tables built from the level
+ * geometry.  The chunks are kept for the next level, so loading a
+ * level of similar size allocates nothing.
+ *
+ * Freeing a single allocation does nothing.  A table in the arena must
+ * not be used after a release, so each owner records
+ * level_arena_generation() when it builds its table, and treats the
+ * table as absent if the generation has changed.  Owners assign a new
+ * empty container, rather than calling clear() or assigning {}, since
+ * those keep the old storage.
+ */
+void *level_arena_allocate(std::size_t bytes, std::size_t alignment) __attribute_malloc();
+void level_arena_release();
+unsigned level_arena_generation();
+/* Largest number of bytes in use since the program started. */
+std::size_t level_arena_high_water();
+
+template <typename T>
+class level_arena_allocator
+{
+public:
+	typedef T value_type;
+	typedef std::true_type propagate_on_container_move_assignment;
+	level_arena_allocator() = default;
+	template <typename U>
+		level_arena_allocator(const level_arena_allocator<U> &)
+		{
+		}
+	T *allocate(const std::size_t n)
+	{
+		return static_cast<T *>(level_arena_allocate(n * sizeof(T), alignof(T)));
+	}
+	void deallocate(T *, std::size_t)
+	{
+	}
+};
+
+template <typename T, typename U>
+static inline bool operator==(const level_arena_allocator<T> &, const level_arena_allocator<U> &)
+{
+	return true;
+}
+
+template <typename T, typename U>
+static inline bool operator!=(const level_arena_allocator<T> &, const level_arena_allocator<U> &)
+{
+	return false;
+}
+
+template <typename T>
+using level_arena_vector = std::vector<T, level_arena_allocator<T>>;
+
+}
+#endif
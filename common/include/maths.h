@@ -101,8 +101,14 @@ static constexpr int f2ir(const fix &f)
 #define F0_1 	f0_1
 
 //multiply two fixes, return a fix(64)
+//Inline so that callers in hot loops do not pay for a call per product.
 __attribute_warn_unused_result
-fix64 fixmul64 (fix a, fix b);
+static inline fix64 fixmul64(const fix a, const fix b)
+{
+	const fix64 a64 = a;
+	const fix64 b64 = b;
+	return (a64 * b64) / 65536;
+}
 
 /* On x86/amd64 for Windows/Linux, truncating fix64->fix is free. */
 __attribute_warn_unused_result
@@ -59,6 +59,8 @@ void mouse_enable_cursor();
 void mouse_disable_cursor();
 window_event_result mouse_button_handler(struct SDL_MouseButtonEvent *mbe);
 window_event_result mouse_motion_handler(struct SDL_MouseMotionEvent *mme);
+/* Get the motion of the last mouse event still queued, if any. */
+bool mouse_peek_delta(int &dx, int &dy);
 void mouse_cursor_autohide();
 
 class d_event_mousebutton : public d_event
@@ -11,6 +11,7 @@
 
 #pragma once
 
+#include <cstddef>
 #include <cstdint>
 
 #if defined(__APPLE__) && defined(__MACH__)
@@ -47,6 +48,191 @@ typedef void (APIENTRYP PFNGLWAITSYNCPROC) (GLsync sync, GLbitfield flags, GLuin
 #define GL_SYNC_GPU_COMMANDS_COMPLETE     0x9117
 #define GL_TIMEOUT_EXPIRED                0x911B
 
+/* GL_ARB_vertex_buffer_object */
+#ifndef GL_VERSION_1_5
+typedef ptrdiff_t GLsizeiptr;
+typedef ptrdiff_t GLintptr;
+#endif
+
+typedef void (APIENTRYP PFNGLBINDBUFFERPROC) (GLenum target, GLuint buffer);
+typedef void (APIENTRYP PFNGLDELETEBUFFERSPROC) (GLsizei n, const GLuint *buffers);
+typedef void (APIENTRYP PFNGLGENBUFFERSPROC) (GLsizei n, GLuint *buffers);
+typedef void (APIENTRYP PFNGLBUFFERDATAPROC) (GLenum target, GLsizeiptr size, const void *data, GLenum usage);
+typedef void (APIENTRYP PFNGLBUFFERSUBDATAPROC) (GLenum target, GLintptr offset, GLsizeiptr size, const void *data);
+
+#ifndef GL_ARRAY_BUFFER
+#define GL_ARRAY_BUFFER                   0x8892
+#endif
+#ifndef GL_ELEMENT_ARRAY_BUFFER
+#define GL_ELEMENT_ARRAY_BUFFER           0x8893
+#endif
+#ifndef GL_STREAM_DRAW
+#define GL_STREAM_DRAW                    0x88E0
+#endif
+#ifndef GL_STATIC_DRAW
+#define GL_STATIC_DRAW                    0x88E4
+#endif
+#ifndef GL_DYNAMIC_DRAW
+#define GL_DYNAMIC_DRAW                   0x88E8
+#endif
+
+/* GL_ARB_pixel_buffer_object */
+typedef void *(APIENTRYP PFNGLMAPBUFFERPROC) (GLenum target, GLenum access);
+typedef GLboolean (APIENTRYP PFNGLUNMAPBUFFERPROC) (GLenum target);
+
+#ifndef GL_PIXEL_UNPACK_BUFFER
+#define GL_PIXEL_UNPACK_BUFFER            0x88EC
+#endif
+#ifndef GL_WRITE_ONLY
+#define GL_WRITE_ONLY                     0x88B9
+#endif
+#ifndef GL_PIXEL_PACK_BUFFER
+#define GL_PIXEL_PACK_BUFFER              0x88EB
+#endif
+#ifndef GL_READ_ONLY
+#define GL_READ_ONLY                      0x88B8
+#endif
+#ifndef GL_STREAM_READ
+#define GL_STREAM_READ                    0x88E1
+#endif
+
+/* GL_ARB_timer_query */
+typedef void (APIENTRYP PFNGLGENQUERIESPROC) (GLsizei n, GLuint *ids);
+typedef void (APIENTRYP PFNGLDELETEQUERIESPROC) (GLsizei n, const GLuint *ids);
+typedef void (APIENTRYP PFNGLBEGINQUERYPROC) (GLenum target, GLuint id);
+typedef void (APIENTRYP PFNGLENDQUERYPROC) (GLenum target);
+typedef void (APIENTRYP PFNGLGETQUERYOBJECTIVPROC) (GLuint id, GLenum pname, GLint *params);
+typedef void (APIENTRYP PFNGLGETQUERYOBJECTUI64VPROC) (GLuint id, GLenum pname, GLuint64 *params);
+
+#ifndef GL_QUERY_RESULT
+#define GL_QUERY_RESULT                   0x8866
+#endif
+#ifndef GL_QUERY_RESULT_AVAILABLE
+#define GL_QUERY_RESULT_AVAILABLE         0x8867
+#endif
+#ifndef GL_TIME_ELAPSED
+#define GL_TIME_ELAPSED                   0x88BF
+#endif
+
+/* GL_ARB_occlusion_query */
+typedef void (APIENTRYP PFNGLGETQUERYOBJECTUIVPROC) (GLuint id, GLenum pname, GLuint *params);
+
+/* GL_ARB_draw_instanced */
+typedef void (APIENTRYP PFNGLDRAWELEMENTSINSTANCEDPROC) (GLenum mode, GLsizei count, GLenum type, const void *indices, GLsizei instancecount);
+
+#ifndef GL_MAX_VERTEX_UNIFORM_COMPONENTS
+#define GL_MAX_VERTEX_UNIFORM_COMPONENTS  0x8B4A
+#endif
+
+#ifndef GL_SAMPLES_PASSED
+#define GL_SAMPLES_PASSED                 0x8914
+#endif
+
+/* GL_ARB_framebuffer_object */
+typedef void (APIENTRYP PFNGLGENFRAMEBUFFERSPROC) (GLsizei n, GLuint *framebuffers);
+typedef void (APIENTRYP PFNGLDELETEFRAMEBUFFERSPROC) (GLsizei n, const GLuint *framebuffers);
+typedef void (APIENTRYP PFNGLBINDFRAMEBUFFERPROC) (GLenum target, GLuint framebuffer);
+typedef void (APIENTRYP PFNGLFRAMEBUFFERTEXTURE2DPROC) (GLenum target, GLenum attachment, GLenum textarget, GLuint texture, GLint level);
+typedef void (APIENTRYP PFNGLFRAMEBUFFERRENDERBUFFERPROC) (GLenum target, GLenum attachment, GLenum renderbuffertarget, GLuint renderbuffer);
+typedef GLenum (APIENTRYP PFNGLCHECKFRAMEBUFFERSTATUSPROC) (GLenum target);
+typedef void (APIENTRYP PFNGLGENRENDERBUFFERSPROC) (GLsizei n, GLuint *renderbuffers);
+typedef void (APIENTRYP PFNGLDELETERENDERBUFFERSPROC) (GLsizei n, const GLuint *renderbuffers);
+typedef void (APIENTRYP PFNGLBINDRENDERBUFFERPROC) (GLenum target, GLuint renderbuffer);
+typedef void (APIENTRYP PFNGLRENDERBUFFERSTORAGEPROC) (GLenum target, GLenum internalformat, GLsizei width, GLsizei height);
+typedef void (APIENTRYP PFNGLGENERATEMIPMAPPROC) (GLenum target);
+
+#ifndef GL_FRAMEBUFFER
+#define GL_FRAMEBUFFER                    0x8D40
+#endif
+#ifndef GL_RENDERBUFFER
+#define GL_RENDERBUFFER                   0x8D41
+#endif
+#ifndef GL_COLOR_ATTACHMENT0
+#define GL_COLOR_ATTACHMENT0              0x8CE0
+#endif
+#ifndef GL_DEPTH_ATTACHMENT
+#define GL_DEPTH_ATTACHMENT               0x8D00
+#endif
+#ifndef GL_FRAMEBUFFER_COMPLETE
+#define GL_FRAMEBUFFER_COMPLETE           0x8CD5
+#endif
+#ifndef GL_DEPTH_COMPONENT24
+#define GL_DEPTH_COMPONENT24              0x81A6
+#endif
+
+/* GL_EXT_texture3D */
+typedef void (APIENTRYP PFNGLTEXIMAGE3DPROC) (GLenum target, GLint level, GLint internalformat, GLsizei width, GLsizei height, GLsizei depth, GLint border, GLenum format, GLenum type, const void *pixels);
+typedef void (APIENTRYP PFNGLTEXSUBIMAGE3DPROC) (GLenum target, GLint level, GLint xoffset, GLint yoffset, GLint zoffset, GLsizei width, GLsizei height, GLsizei depth, GLenum format, GLenum type, const void *pixels);
+
+#ifndef GL_TEXTURE_3D
+#define GL_TEXTURE_3D                     0x806F
+#endif
+#ifndef GL_TEXTURE_WRAP_R
+#define GL_TEXTURE_WRAP_R                 0x8072
+#endif
+#ifndef GL_MAX_3D_TEXTURE_SIZE
+#define GL_MAX_3D_TEXTURE_SIZE            0x8073
+#endif
+
+/* GL_EXT_blend_color */
+typedef void (APIENTRYP PFNGLBLENDCOLORPROC) (GLfloat red, GLfloat green, GLfloat blue, GLfloat alpha);
+
+#ifndef GL_CONSTANT_COLOR
+#define GL_CONSTANT_COLOR                 0x8001
+#endif
+
+/* GL_ARB_multitexture */
+typedef void (APIENTRYP PFNGLACTIVETEXTUREPROC) (GLenum texture);
+typedef void (APIENTRYP PFNGLCLIENTACTIVETEXTUREPROC) (GLenum texture);
+
+#ifndef GL_TEXTURE0
+#define GL_TEXTURE0                       0x84C0
+#endif
+#ifndef GL_TEXTURE1
+#define GL_TEXTURE1                       0x84C1
+#endif
+
+/* GL_ARB_shader_objects, GL_ARB_vertex_shader, GL_ARB_fragment_shader */
+#ifndef GL_VERSION_2_0
+typedef char GLchar;
+#endif
+
+typedef GLuint (APIENTRYP PFNGLCREATESHADERPROC) (GLenum type);
+typedef void (APIENTRYP PFNGLSHADERSOURCEPROC) (GLuint shader, GLsizei count, const GLchar *const *string, const GLint *length);
+typedef void (APIENTRYP PFNGLCOMPILESHADERPROC) (GLuint shader);
+typedef void (APIENTRYP PFNGLGETSHADERIVPROC) (GLuint shader, GLenum pname, GLint *params);
+typedef void (APIENTRYP PFNGLGETSHADERINFOLOGPROC) (GLuint shader, GLsizei bufSize, GLsizei *length, GLchar *infoLog);
+typedef void (APIENTRYP PFNGLDELETESHADERPROC) (GLuint shader);
+typedef GLuint (APIENTRYP PFNGLCREATEPROGRAMPROC) (void);
+typedef void (APIENTRYP PFNGLATTACHSHADERPROC) (GLuint program, GLuint shader);
+typedef void (APIENTRYP PFNGLLINKPROGRAMPROC) (GLuint program);
+typedef void (APIENTRYP PFNGLGETPROGRAMIVPROC) (GLuint program, GLenum pname, GLint *params);
+typedef void (APIENTRYP PFNGLGETPROGRAMINFOLOGPROC) (GLuint program, GLsizei bufSize, GLsizei *length, GLchar *infoLog);
+typedef void (APIENTRYP PFNGLDELETEPROGRAMPROC) (GLuint program);
+typedef void (APIENTRYP PFNGLUSEPROGRAMPROC) (GLuint program);
+typedef GLint (APIENTRYP PFNGLGETUNIFORMLOCATIONPROC) (GLuint program, const GLchar *name);
+typedef void (APIENTRYP PFNGLUNIFORM1IPROC) (GLint location, GLint v0);
+typedef void (APIENTRYP PFNGLUNIFORM1FPROC) (GLint location, GLfloat v0);
+typedef void (APIENTRYP PFNGLUNIFORM2FPROC) (GLint location, GLfloat v0, GLfloat v1);
+typedef void (APIENTRYP PFNGLUNIFORM4FPROC) (GLint location, GLfloat v0, GLfloat v1, GLfloat v2, GLfloat v3);
+typedef void (APIENTRYP PFNGLUNIFORM4FVPROC) (GLint location, GLsizei count, const GLfloat *value);
+
+#ifndef GL_FRAGMENT_SHADER
+#define GL_FRAGMENT_SHADER                0x8B30
+#endif
+#ifndef GL_VERTEX_SHADER
+#define GL_VERTEX_SHADER                  0x8B31
+#endif
+#ifndef GL_COMPILE_STATUS
+#define GL_COMPILE_STATUS                 0x8B81
+#endif
+#ifndef GL_LINK_STATUS
+#define GL_LINK_STATUS                    0x8B82
+#endif
+#ifndef GL_INFO_LOG_LENGTH
+#define GL_INFO_LOG_LENGTH                0x8B84
+#endif
+
 /* GL_EXT_texture */
 #ifndef GL_VERSION_1_1
 #ifdef GL_EXT_texture
@@ -69,6 +255,77 @@ extern bool ogl_have_ARB_sync;
 extern PFNGLFENCESYNCPROC glFenceSyncFunc;
 extern PFNGLDELETESYNCPROC glDeleteSyncFunc;
 extern PFNGLCLIENTWAITSYNCPROC glClientWaitSyncFunc;
+
+extern bool ogl_have_ARB_vertex_buffer_object;
+extern PFNGLBINDBUFFERPROC glBindBufferFunc;
+extern PFNGLDELETEBUFFERSPROC glDeleteBuffersFunc;
+extern PFNGLGENBUFFERSPROC glGenBuffersFunc;
+extern PFNGLBUFFERDATAPROC glBufferDataFunc;
+extern PFNGLBUFFERSUBDATAPROC glBufferSubDataFunc;
+
+extern bool ogl_have_ARB_pixel_buffer_object;
+extern PFNGLMAPBUFFERPROC glMapBufferFunc;
+extern PFNGLUNMAPBUFFERPROC glUnmapBufferFunc;
+
+extern bool ogl_have_ARB_timer_query;
+extern PFNGLGENQUERIESPROC glGenQueriesFunc;
+extern PFNGLDELETEQUERIESPROC glDeleteQueriesFunc;
+extern PFNGLBEGINQUERYPROC glBeginQueryFunc;
+extern PFNGLENDQUERYPROC glEndQueryFunc;
+extern PFNGLGETQUERYOBJECTIVPROC glGetQueryObjectivFunc;
+extern PFNGLGETQUERYOBJECTUI64VPROC glGetQueryObjectui64vFunc;
+
+extern bool ogl_have_ARB_occlusion_query;
+extern PFNGLGETQUERYOBJECTUIVPROC glGetQueryObjectuivFunc;
+
+extern bool ogl_have_ARB_draw_instanced;
+extern PFNGLDRAWELEMENTSINSTANCEDPROC glDrawElementsInstancedFunc;
+
+extern bool ogl_have_ARB_framebuffer_object;
+extern PFNGLGENFRAMEBUFFERSPROC glGenFramebuffersFunc;
+extern PFNGLDELETEFRAMEBUFFERSPROC glDeleteFramebuffersFunc;
+extern PFNGLBINDFRAMEBUFFERPROC glBindFramebufferFunc;
+extern PFNGLFRAMEBUFFERTEXTURE2DPROC glFramebufferTexture2DFunc;
+extern PFNGLFRAMEBUFFERRENDERBUFFERPROC glFramebufferRenderbufferFunc;
+extern PFNGLCHECKFRAMEBUFFERSTATUSPROC glCheckFramebufferStatusFunc;
+extern PFNGLGENRENDERBUFFERSPROC glGenRenderbuffersFunc;
+extern PFNGLDELETERENDERBUFFERSPROC glDeleteRenderbuffersFunc;
+extern PFNGLBINDRENDERBUFFERPROC glBindRenderbufferFunc;
+extern PFNGLRENDERBUFFERSTORAGEPROC glRenderbufferStorageFunc;
+extern PFNGLGENERATEMIPMAPPROC glGenerateMipmapFunc;
+
+extern bool ogl_have_EXT_texture3D;
+extern PFNGLTEXIMAGE3DPROC glTexImage3DFunc;
+extern PFNGLTEXSUBIMAGE3DPROC glTexSubImage3DFunc;
+extern GLint ogl_max_3d_texture_size;
+
+extern bool ogl_have_EXT_blend_color;
+extern PFNGLBLENDCOLORPROC glBlendColorFunc;
+
+extern bool ogl_have_ARB_multitexture;
+extern PFNGLACTIVETEXTUREPROC glActiveTextureFunc;
+extern PFNGLCLIENTACTIVETEXTUREPROC glClientActiveTextureFunc;
+
+extern bool ogl_have_ARB_shader_objects;
+extern PFNGLCREATESHADERPROC glCreateShaderFunc;
+extern PFNGLSHADERSOURCEPROC glShaderSourceFunc;
+extern PFNGLCOMPILESHADERPROC glCompileShaderFunc;
+extern PFNGLGETSHADERIVPROC glGetShaderivFunc;
+extern PFNGLGETSHADERINFOLOGPROC glGetShaderInfoLogFunc;
+extern PFNGLDELETESHADERPROC glDeleteShaderFunc;
+extern PFNGLCREATEPROGRAMPROC glCreateProgramFunc;
+extern PFNGLATTACHSHADERPROC glAttachShaderFunc;
+extern PFNGLLINKPROGRAMPROC glLinkProgramFunc;
+extern PFNGLGETPROGRAMIVPROC glGetProgramivFunc;
+extern PFNGLGETPROGRAMINFOLOGPROC glGetProgramInfoLogFunc;
+extern PFNGLDELETEPROGRAMPROC glDeleteProgramFunc;
+extern PFNGLUSEPROGRAMPROC glUseProgramFunc;
+extern PFNGLGETUNIFORMLOCATIONPROC glGetUniformLocationFunc;
+extern PFNGLUNIFORM1IPROC glUniform1iFunc;
+extern PFNGLUNIFORM1FPROC glUniform1fFunc;
+extern PFNGLUNIFORM2FPROC glUniform2fFunc;
+extern PFNGLUNIFORM4FPROC glUniform4fFunc;
+extern PFNGLUNIFORM4FVPROC glUniform4fvFunc;
 extern GLfloat ogl_maxanisotropy;
 
 /* Global initialization:
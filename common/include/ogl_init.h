@@ -64,15 +64,42 @@ struct ogl_texture
 	GLfloat u,v;
 	GLfloat prio;
 	int wrapstate;
+	int array_layer;	// layer in the level texture array, or -1
+	bool placeholder;	// 1x1 stand-in until the real upload (-gl_asyncupload)
+	bool evictable;	// loaded from a bitmap which can load it again
 	unsigned long numrend;
+	/* Residency: bytes counted against -gl_vram while the texture is
+	 * uploaded, the frame it was last drawn in, and its place in the
+	 * list of evictable textures, most recently drawn first.
+	 */
+	unsigned resident_bytes;
+	unsigned lru_frame;
+	ogl_texture *lru_prev, *lru_next;
 };
 
 extern ogl_texture* ogl_get_free_texture();
 void ogl_init_texture(ogl_texture &t, int w, int h, int flags);
 
+struct ogl_texture_stats
+{
+	std::size_t resident_bytes;
+	unsigned textures, evictions;
+	unsigned state_calls_skipped;
+	unsigned dynres_percent;
+};
+
+/* Evictions count the textures -gl_vram freed since startup.
+ * state_calls_skipped counts the redundant GL state changes which were
+ * not sent during the last frame.  dynres_percent is the -gl_dynres
+ * scale of the 3D view.
+ */
+ogl_texture_stats ogl_get_texture_stats();
+
 void ogl_init_shared_palette(void);
 
 namespace dcx {
+struct polymodel;
+class submodel_angles;
 
 #define OGL_FLAG_MIPMAP (1 << 0)
 #define OGL_FLAG_NOCOLOR (1 << 1)
@@ -82,6 +109,13 @@ void ogl_freebmtexture(grs_bitmap &bm);
 
 void ogl_start_frame(grs_canvas &);
 void ogl_end_frame(void);
+/* With -gl_dynres, draw the 3D view of the canvas into a framebuffer
+ * object at the current scale: ogl_dynres_begin returns true if it did,
+ * and then ogl_dynres_end stretches the view over the canvas.
+ */
+bool ogl_dynres_begin(const grs_canvas &);
+void ogl_dynres_end(const grs_canvas &);
+unsigned ogl_dynres_percent();
 void ogl_set_screen_mode(void);
 
 struct ogl_colors
@@ -109,8 +143,24 @@ private:
 void ogl_urect(grs_canvas &, int left, int top, int right, int bot, int color);
 bool ogl_ubitmapm_cs(grs_canvas &, int x, int y,int dw, int dh, grs_bitmap &bm,int c, int scale);
 bool ogl_ubitmapm_cs(grs_canvas &, int x, int y,int dw, int dh, grs_bitmap &bm, const ogl_colors::array_type &c, int scale);
+void ogl_ubitmapm_cs_batched(grs_canvas &, int x, int y, int dw, int dh, grs_bitmap &bm, const ogl_colors::array_type &c);
+/* Draw any glyphs queued by ogl_ubitmapm_cs_batched. */
+void ogl_flush_text_batch();
+/* Send the commands of the frame drawn so far to the GPU without
+ * waiting for them, so that the CPU can do other work before gr_flip.
+ */
+void ogl_submit_frame();
+/* Between these, g3_draw_line queues its lines and draws them together. */
+void ogl_begin_line_batch();
+void ogl_end_line_batch();
 bool ogl_ubitblt_i(unsigned dw, unsigned dh, unsigned dx, unsigned dy, unsigned sw, unsigned sh, unsigned sx, unsigned sy, const grs_bitmap &src, grs_bitmap &dest, unsigned texfilt);
 bool ogl_ubitblt(unsigned w, unsigned h, unsigned dx, unsigned dy, unsigned sx, unsigned sy, const grs_bitmap &src, grs_bitmap &dest);
+/* Draw an 8 bit movie frame of sw x sh pixels, scaled to dw x dh at
+ * dx, dy, with the palette lookup done by a shader.  Returns false if
+ * shaders are not available, in which case the caller should use
+ * ogl_ubitblt_i.
+ */
+bool ogl_draw_movie_frame(const uint8_t *buf, unsigned sw, unsigned sh, unsigned dx, unsigned dy, unsigned dw, unsigned dh, grs_bitmap &dest, bool bilinear);
 void ogl_upixelc(const grs_bitmap &, unsigned x, unsigned y, unsigned c);
 unsigned char ogl_ugpixel(const grs_bitmap &bitmap, unsigned x, unsigned y);
 void ogl_ulinec(grs_canvas &, int left, int top, int right, int bot, int c);
@@ -118,10 +168,76 @@ void ogl_ulinec(grs_canvas &, int left, int top, int right, int bot, int c);
 #ifdef dsx
 namespace dsx {
 void ogl_cache_level_textures();
+void ogl_build_world_buffer();
+struct glow_values_t;
+/* Draw a whole polygon model from its buffer object (-gl_modelbuffer).
+ * Returns false if the caller must run the interpreter instead.
+ */
+bool ogl_draw_polygon_model_mesh(grs_canvas &, const polymodel &, grs_bitmap *const *model_bitmaps, submodel_angles anim_angles, g3s_lrgb light, const glow_values_t *glow_values);
+/* Draw one submodel of a morphing model from the same mesh, with its
+ * points taken from morph_points (indexed by model point number) and
+ * streamed through a dynamic buffer.  Returns false if the caller must
+ * run the morphing interpreter instead.
+ */
+bool ogl_draw_morphing_submodel_mesh(grs_canvas &, const polymodel &, unsigned submodel_num, grs_bitmap *const *model_bitmaps, submodel_angles anim_angles, g3s_lrgb light, const vms_vector *morph_points, std::size_t n_morph_points);
 }
 #endif
 
 #include "3d.h"
+
+namespace dcx {
+/* Level geometry kept in a buffer object (-gl_worldbuffer).  Faces
+ * sharing a texture are queued and drawn together by
+ * ogl_flush_world_buffer, which every immediate mode draw calls first.
+ */
+bool ogl_draw_world_face(grs_canvas &, unsigned segnum, unsigned sidenum, unsigned nv, const array<unsigned, 4> &corners, const array<g3s_lrgb, 4> &light_rgb, grs_bitmap &bm);
+bool ogl_draw_world_overlay_face(grs_canvas &, unsigned segnum, unsigned sidenum, unsigned nv, const array<unsigned, 4> &corners, const array<g3s_lrgb, 4> &light_rgb, grs_bitmap &bmbot, grs_bitmap &bm, unsigned orient);
+void ogl_flush_world_buffer();
+void ogl_invalidate_world_buffer();
+void ogl_free_world_buffer();
+/* The endlevel terrain in a buffer object (-gl_worldbuffer).
+ * ogl_build_terrain_buffer takes the world position, texture coordinates
+ * and light of every grid point, and returns false if the terrain cannot
+ * be buffered.  ogl_draw_terrain draws triangles of those points, unless
+ * it returns false, when the caller must draw the cells itself.
+ */
+bool ogl_build_terrain_buffer(unsigned count, const vms_vector *points, const g3s_uvl *uvls);
+bool ogl_draw_terrain(grs_canvas &, grs_bitmap &, const uint16_t *indices, unsigned count);
+void ogl_free_terrain_buffer();
+/* The automap edges in a buffer object (-gl_worldbuffer).
+ * ogl_build_automap_buffer takes both end points of each of count edge
+ * slots, and returns false if the edges cannot be buffered.
+ * ogl_draw_automap_edges draws the listed slots, in order, each in its
+ * palette color.
+ */
+bool ogl_build_automap_buffer(unsigned count, const vms_vector *points);
+void ogl_draw_automap_edges(const uint32_t *slots, const uint8_t *colors, unsigned count);
+void ogl_free_automap_buffer();
+void ogl_free_texture_array();
+/* True if overlay textures are drawn in one pass by a shader
+ * (-gl_overlayshader), which also handles super transparency.
+ */
+bool ogl_use_overlay_shader();
+/* True when -gl_pixellight is in use and its shaders were built. */
+bool ogl_use_pixel_light_shader();
+void ogl_reset_shaders();
+void ogl_invalidate_polygon_model_meshes();
+void ogl_free_polygon_model_mesh(const polymodel &);
+/* Occlusion queries for distant segments (-gl_occlusion).  Each frame
+ * of the main view calls ogl_occlusion_begin_frame, asks
+ * ogl_occlusion_occluded which segments the previous frame found
+ * hidden, then tests this frame's candidates between
+ * ogl_occlusion_begin_tests and ogl_occlusion_end_tests.  The bounds
+ * given to ogl_occlusion_test are in view space at depth z.
+ */
+bool ogl_occlusion_enabled();
+void ogl_occlusion_reset();
+void ogl_occlusion_begin_frame(unsigned segment_count);
+bool ogl_occlusion_occluded(unsigned segnum);
+void ogl_occlusion_begin_tests();
+void ogl_occlusion_test(unsigned segnum, GLfloat left, GLfloat right, GLfloat bot, GLfloat top, GLfloat z);
+void ogl_occlusion_end_tests();
+}
 void _g3_draw_tmap_2(grs_canvas &, unsigned nv, const g3s_point *const *const pointlist, const g3s_uvl *uvl_list, const g3s_lrgb *light_rgb, grs_bitmap &bmbot, grs_bitmap &bm, unsigned orient);
 
 template <std::size_t N>
@@ -0,0 +1,64 @@
+/*
+ * This file is part of the DXX-Rebirth project <https://www.dxx-rebirth.com/>.
+ * It is copyright by its individual contributors, as recorded in the
+ * project's Git history.  See COPYING.txt at the top level for license
+ * terms and a link to the Git history.
+ */
+
+/* OpenGL shader programs:
+ * compile and link GLSL programs for the optional shader based paths.
+ * Shaders are written against GLSL 1.10 and the fixed function
+ * built-in attributes, so the rest of the renderer is unaffected.
+ */
+
+#pragma once
+
+#include "dxxsconf.h"
+#include "ogl_extensions.h"
+
+namespace dcx {
+
+#if DXX_USE_OGL
+class ogl_program
+{
+	GLuint handle;
+	/* Set when building failed, so that the build is not retried every
+	 * frame.  Cleared by reset().
+	 */
+	bool failed;
+public:
+	ogl_program() :
+		handle(0), failed(false)
+	{
+	}
+	ogl_program(const ogl_program &) = delete;
+	ogl_program &operator=(const ogl_program &) = delete;
+	explicit operator bool() const
+	{
+		return handle;
+	}
+	bool build_failed() const
+	{
+		return failed;
+	}
+	/* Compile and link the program.  On failure, the compiler log is
+	 * printed to the console and false is returned.
+	 */
+	bool build(const char *name, const char *vertex_source, const char *fragment_source);
+	/* Delete the program.  This must be called while the OpenGL context
+	 * that created it is still current.
+	 */
+	void reset();
+	GLint uniform(const char *name) const;
+	void use() const
+	{
+		glUseProgramFunc(handle);
+	}
+	static void use_fixed_function()
+	{
+		glUseProgramFunc(0);
+	}
+};
+#endif
+
+}
@@ -60,6 +60,11 @@ namespace dcx {
 
 int pcx_read_bitmap(const char * filename, grs_main_bitmap &bmp, palette_array_t &palette);
 
+// Decodes filename into the cache of recently used screens, so that a
+// later pcx_read_bitmap of it does not touch the file.  Errors are left
+// for that pcx_read_bitmap to report.
+void pcx_preload(const char *filename);
+
 // Writes the bitmap bmp to filename, using palette. Returns error code.
 
 #if !DXX_USE_OGL && DXX_USE_SCREENSHOT_FORMAT_LEGACY
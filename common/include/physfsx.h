@@ -18,6 +18,7 @@
 #include <string.h>
 #include <stdarg.h>
 #include <type_traits>
+#include <utility>
 
 // When PhysicsFS can *easily* be built as a framework on Mac OS X,
 // the framework form will be supported again -kreatordxx
@@ -464,8 +465,128 @@ extern int PHYSFSX_rename(const char *oldpath, const char *newpath);
 
 #define PHYSFSX_exists(F,I)	((I) ? PHYSFSX_exists_ignorecase(F) : PHYSFS_exists(F))
 int PHYSFSX_exists_ignorecase(const char *filename);
+// Get the size and modification time of filename, ignoring case.  size
+// is -1 if PhysFS cannot report it without opening the file.
+bool PHYSFSX_stat(const char *filename, PHYSFS_sint64 &size, PHYSFS_sint64 &mtime);
 RAIIPHYSFS_File PHYSFSX_openReadBuffered(const char *filename);
 RAIIPHYSFS_File PHYSFSX_openWriteBuffered(const char *filename);
+// Write to a temporary file, then replace filename with it only once it
+// has all been written, so that a failed save cannot truncate filename.
+RAIIPHYSFS_File PHYSFSX_openReplaceBuffered(const char *filename);
+// Close file and move it over filename.  Returns 0, with the temporary
+// file removed and filename unchanged, if either step fails.
+int PHYSFSX_commitReplace(RAIIPHYSFS_File &file, const char *filename);
+
+/* A copy-on-write memory mapping of a file in the search path. */
+class PHYSFSX_mapped_file
+{
+	void *base = nullptr;
+	std::size_t base_size = 0;
+	uint8_t *first = nullptr;
+	std::size_t length = 0;
+public:
+	PHYSFSX_mapped_file() = default;
+	PHYSFSX_mapped_file(void *base, std::size_t base_size, std::size_t offset, std::size_t length);
+	PHYSFSX_mapped_file(const PHYSFSX_mapped_file &) = delete;
+	PHYSFSX_mapped_file &operator=(const PHYSFSX_mapped_file &) = delete;
+	PHYSFSX_mapped_file(PHYSFSX_mapped_file &&rhs) :
+		base(rhs.base), base_size(rhs.base_size), first(rhs.first), length(rhs.length)
+	{
+		rhs.base = nullptr;
+		rhs.first = nullptr;
+	}
+	PHYSFSX_mapped_file &operator=(PHYSFSX_mapped_file &&rhs)
+	{
+		if (this != &rhs)
+		{
+			reset();
+			std::swap(base, rhs.base);
+			std::swap(base_size, rhs.base_size);
+			std::swap(first, rhs.first);
+			std::swap(length, rhs.length);
+		}
+		return *this;
+	}
+	~PHYSFSX_mapped_file()
+	{
+		reset();
+	}
+	void reset();
+	explicit operator bool() const
+	{
+		return first;
+	}
+	uint8_t *data() const
+	{
+		return first;
+	}
+	std::size_t size() const
+	{
+		return length;
+	}
+};
+
+/* Decodes little endian values from part of a file read into memory
+ * with one PHYSFS_read, for loaders which would otherwise make
+ * thousands of small reads.  Reading past the end of the buffer is an
+ * error, like reading past the end of the file with PHYSFSX_readInt.
+ */
+class PHYSFSX_buffer_reader
+{
+	std::unique_ptr<uint8_t[]> buffer;
+	std::size_t length = 0, position = 0;
+	PHYSFS_sint64 file_offset;
+	__attribute_cold
+	__attribute_noreturn
+	void report_overread(std::size_t size) const;
+	const uint8_t *consume(const std::size_t size)
+	{
+		if (unlikely(length - position < size))
+			report_overread(size);
+		const auto p = &buffer[position];
+		position += size;
+		return p;
+	}
+public:
+	/* Read at most max_length bytes from the current position of fp. */
+	PHYSFSX_buffer_reader(PHYSFS_File *fp, std::size_t max_length);
+	int8_t readByte()
+	{
+		return *consume(1);
+	}
+	int16_t readShort()
+	{
+		const auto p = consume(2);
+		return static_cast<int16_t>(p[0] | (p[1] << 8));
+	}
+	int32_t readInt()
+	{
+		const auto p = consume(4);
+		return static_cast<int32_t>(p[0] | (p[1] << 8) | (p[2] << 16) | (static_cast<uint32_t>(p[3]) << 24));
+	}
+	fix readFix()
+	{
+		return readInt();
+	}
+	void readVector(vms_vector &v)
+	{
+		v.x = readFix();
+		v.y = readFix();
+		v.z = readFix();
+	}
+	/* The file offset of the next value. */
+	PHYSFS_sint64 tell() const
+	{
+		return file_offset + position;
+	}
+};
+
+/* Map a file which is either stored loose in a search path directory
+ * or uncompressed in a HOG.  Returns an empty mapping for anything
+ * else, such as files in a ZIP, and the caller must read the file
+ * normally.
+ */
+PHYSFSX_mapped_file PHYSFSX_mapRead(const char *filename);
 extern void PHYSFSX_addArchiveContent();
 extern void PHYSFSX_removeArchiveContent();
 }
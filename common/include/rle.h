@@ -70,6 +70,17 @@ static inline const grs_bitmap *rle_expand_texture(const grs_bitmap &bmp)
 }
 void rle_cache_close();
 void rle_cache_flush();
+
+struct rle_cache_stats
+{
+	std::size_t bytes, pinned_bytes, budget;
+	unsigned entries, hits, misses;
+};
+
+/* Lookups since startup.  Pinned bitmaps count in pinned_bytes, not in
+ * bytes.
+ */
+rle_cache_stats rle_cache_get_stats();
 void rle_swap_0_255(grs_bitmap &bmp);
 void rle_remap(grs_bitmap &bmp, array<color_t, 256> &colormap);
 #if !DXX_USE_OGL
@@ -52,6 +52,16 @@ constexpr std::integral_constant<unsigned, 25> MAX_TMAP_VERTS{};
 //	vertbuf is a pointer to an array of vertex pointers
 void draw_tmap(grs_canvas &, const grs_bitmap &bp, uint_fast32_t nverts, const g3s_point *const *vertbuf);
 
+// Between draw_tmap_begin_batch and draw_tmap_end_batch, draw_tmap only
+// records the texture map.  draw_tmap_flush rasterizes everything recorded,
+// in painter's order, as horizontal bands spread over the worker pool.
+// Nothing else may draw to the canvas while a batch holds texture maps, and
+// the bitmaps they use must not change, so anything which draws directly or
+// frees a cached bitmap calls draw_tmap_flush first.
+void draw_tmap_begin_batch();
+void draw_tmap_flush();
+void draw_tmap_end_batch();
+
 //function that takes the same parms as draw_tmap, but renders as flat poly
 //we need this to do the cloaked effect
 void draw_tmap_flat(grs_canvas &, const grs_bitmap &bp, uint_fast32_t nverts, const g3s_point *const *vertbuf);
@@ -83,7 +93,7 @@ struct g3ds_tmap {
 //	Set Interpolation_method to 0/1/2 for linear/linear, perspective/linear, perspective/perspective
 #if !DXX_USE_OGL
 extern	int	Interpolation_method;
-extern uint8_t Transparency_on;
+extern thread_local uint8_t Transparency_on;
 
 // Set Lighting_on to 0/1/2 for no lighting/intensity lighting/rgb lighting
 extern	int	Lighting_on;
@@ -116,7 +126,7 @@ public:
 //	These are pointers to texture maps.  If you want to render texture map #7, then you will render
 //	the texture map defined by Texmap_ptrs[7].
 
-extern int Window_clip_left, Window_clip_bot, Window_clip_right, Window_clip_top;
+extern thread_local int Window_clip_left, Window_clip_bot, Window_clip_right, Window_clip_top;
 
 // for ugly hack put in to be sure we don't overflow render buffer
 
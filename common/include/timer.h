@@ -26,10 +26,14 @@ static inline void timer_delay(fix seconds)
 {
 	timer_delay_ms(f2i(seconds * 1000));
 }
-void timer_delay_bound(unsigned bound);
+// Wait until timer_update() reaches deadline, servicing the network in
+// a netgame.  Unless may_sleep is false, sleeps for most of the wait.
+void timer_delay_until(fix64 deadline, bool may_sleep);
+// Wait until bound has passed since the previous frame ended
+void timer_delay_bound(fix bound);
 static inline void timer_delay2(int fps)
 {
-	timer_delay_bound(1000u / fps);
+	timer_delay_bound(F1_0 / fps);
 }
 
 }
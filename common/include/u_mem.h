@@ -20,6 +20,7 @@ COPYRIGHT 1993-1999 PARALLAX SOFTWARE CORPORATION.  ALL RIGHTS RESERVED.
 #pragma once
 
 #include <stdlib.h>
+#include <cstdint>
 #include <type_traits>
 
 #ifdef __cplusplus
@@ -174,6 +175,51 @@ void CALLOC(RAIIdmem<T> &r, std::size_t count, const char *var, const char *file
 #define MALLOC( var, type, count )	(MALLOC<type>(var, (count),#var, __FILE__,__LINE__ ))
 #define CALLOC( var, type, count )	(CALLOC<type>(var, (count),#var, __FILE__,__LINE__ ))
 
+/* Accounting of the large buffers held by each subsystem.  Unlike
+ * DEBUG_MEMORY_ALLOCATIONS, this is in every build, since it costs one
+ * call per buffer allocated, not per d_malloc.  See the "memstat"
+ * console command.
+ */
+enum class mem_tag : uint8_t
+{
+	/* Bitmap data in system memory */
+	textures,
+	/* Texture data uploaded to OpenGL */
+	gl_textures,
+	sounds,
+	models,
+	/* Tables built from the level geometry at load */
+	level,
+};
+
+constexpr unsigned mem_tag_count = static_cast<unsigned>(mem_tag::level) + 1;
+
+/* Record that one buffer of a tag changed from old_bytes to new_bytes.
+ * A size of 0 means no buffer, so allocating passes 0 as old_bytes and
+ * freeing passes 0 as new_bytes.
+ */
+void mem_account(mem_tag, std::size_t old_bytes, std::size_t new_bytes);
+
+/* The accounted size of one buffer, for owners which do not otherwise
+ * keep the size of what they last allocated.
+ */
+class mem_account_buffer
+{
+	const mem_tag tag;
+	std::size_t bytes = 0;
+public:
+	constexpr mem_account_buffer(const mem_tag t) :
+		tag(t)
+	{
+	}
+	void set(const std::size_t b)
+	{
+		mem_account(tag, exchange(bytes, b), b);
+	}
+};
+
+void mem_account_init();
+
 }
 
 #endif
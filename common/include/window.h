@@ -52,6 +52,7 @@ class window
 	class window *prev;				// the previous window in the doubly linked list
 	class window *next;				// the next window in the doubly linked list
 	bool *w_exists;					// optional pointer to a tracking variable
+	bool w_redraw_on_demand;			// only needs drawing after window_request_redraw()
 	
 public:
 	// For creating the window, there are two ways - using the (older) window_create function
@@ -111,6 +112,16 @@ public:
 		return wind.w_modal;
 	}
 
+	// A window whose picture only changes in response to input, or when it
+	// calls window_request_redraw() itself.  While every visible window is
+	// like this, event_process skips drawing frames that would be the same.
+	void set_redraw_on_demand(bool on_demand)
+	{
+		w_redraw_on_demand = on_demand;
+	}
+
+	friend bool window_redraw_needed();
+
 	friend window_event_result window_send_event(window &wind, const d_event &event)
 	{
 		auto r = wind.event_handler(event);
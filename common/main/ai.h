@@ -130,6 +130,7 @@ void create_path_to_station(vmobjptridx_t objp, int max_length);
 void ai_follow_path(vmobjptridx_t objp, int player_visibility, const vms_vector *vec_to_player);
 void ai_turn_towards_vector(const vms_vector &vec_to_player, object_base &obj, fix rate);
 extern void init_ai_objects(void);
+void ai_build_nav_segments();
 void create_n_segment_path(vmobjptridx_t objp, unsigned path_length, imsegidx_t avoid_seg);
 void create_n_segment_path_to_door(vmobjptridx_t objp, unsigned path_length);
 }
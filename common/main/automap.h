@@ -45,6 +45,19 @@ extern void automap_clear_visited();
 #endif
 namespace dcx {
 extern array<ubyte, MAX_SEGMENTS> Automap_visited;
+void automap_queue_visit(segnum_t segnum);
+// Call when Automap_visited is replaced, not just added to.
+void automap_invalidate_edges();
+
+static inline void automap_visit_segment(const segnum_t segnum)
+{
+	auto &v = Automap_visited[segnum];
+	if (!v)
+	{
+		v = 1;
+		automap_queue_visit(segnum);
+	}
+}
 }
 
 #if defined(DXX_BUILD_DESCENT_II)
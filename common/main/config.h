@@ -44,6 +44,10 @@ struct CCfg : prohibit_void_ptr<CCfg>
 	 * values.
 	 */
 	int ADLMIDI_bank = 31;
+	/* An ADL_Emulator.  Together with ADLMIDI_num_chips, this trades
+	 * accuracy for speed.
+	 */
+	int ADLMIDI_emulator = 2;
 	bool ADLMIDI_enabled;
 #endif
 	bool VSync;
@@ -29,8 +29,23 @@
 
 #define CVAR_MAX_LENGTH 1024
 
+namespace {
+
+/* Names are compared as strings, as the console types them, not as
+ * pointers.
+ */
+struct cvar_name_less
+{
+	bool operator()(const char *const a, const char *const b) const
+	{
+		return d_stricmp(a, b) < 0;
+	}
+};
+
+}
+
 /* The list of cvars */
-typedef std::map<const char *, std::reference_wrapper<cvar_t>> cvar_list_type;
+typedef std::map<const char *, std::reference_wrapper<cvar_t>, cvar_name_less> cvar_list_type;
 static cvar_list_type cvar_list;
 
 const char *cvar_t::operator=(const char *s)
@@ -136,6 +151,8 @@ void cvar_set_cvar(cvar_t *cvar, const char *value)
 	cvar->value = fl2f(strtod(value, NULL));
 	cvar->intval = static_cast<int>(strtol(value, NULL, 10));
 	con_printf(CON_VERBOSE, "%s: %s", cvar->name, value);
+	if (cvar->changed)
+		cvar->changed(*cvar);
 }
 
 
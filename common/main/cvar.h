@@ -43,6 +43,10 @@ struct cvar_t
 	uint16_t flags;
 	fix value;
 	int intval;
+	/* If set, called after each change of the value, so that the
+	 * change takes effect at once.
+	 */
+	void (*changed)(cvar_t &);
 
 	operator    int() const { return intval; }
 	const char  *operator=(const char *s);
@@ -94,6 +94,11 @@ extern void digi_stop_sound( int channel );
 // Volume 0-F1_0
 constexpr sound_object *sound_object_none = nullptr;
 int digi_start_sound(short soundnum, fix volume, int pan, int looping, int loop_start, int loop_end, sound_object *);
+// Read soundnum and convert it for the mixer ahead of its first use.
+void digi_prefetch_sound(short soundnum);
+// Convert every loaded sound which is not yet in the mixer's output
+// format, and wait for the conversions to finish.
+void digi_convert_sounds();
 
 // Stops all sounds that are playing
 void digi_stop_all_channels();
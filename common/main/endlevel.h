@@ -54,6 +54,8 @@ namespace dsx {
 window_event_result start_endlevel_sequence();
 }
 #endif
+//find the exit tunnel ahead of the escape, once the reactor is destroyed
+void prepare_exit_tunnel();
 void render_endlevel_frame(grs_canvas &, fix eye_offset);
 
 void draw_exit_model(grs_canvas &);
@@ -25,6 +25,7 @@ COPYRIGHT 1993-1999 PARALLAX SOFTWARE CORPORATION.  ALL RIGHTS RESERVED.
 
 #pragma once
 
+#include <bitset>
 #include <physfs.h>
 
 #ifdef __cplusplus
@@ -32,6 +33,8 @@ COPYRIGHT 1993-1999 PARALLAX SOFTWARE CORPORATION.  ALL RIGHTS RESERVED.
 #include "fwd-partial_range.h"
 #include "fwd-object.h"
 #include "fwd-segment.h"
+#include "fwd-wall.h"
+#include "countarray.h"
 #include "fwd-vecmat.h"
 #include "fwd-wall.h"
 #include "pack.h"
@@ -40,6 +43,29 @@ enum powerup_type_t : uint8_t;
 
 namespace dcx {
 extern unsigned Num_exploding_walls;
+
+//	Walls which have had WALL_EXPLODING set since the last
+//	process_exploding_walls, so that it need not scan every wall.  A
+//	wall whose explosion ended stays listed until that call.
+struct exploding_wall_list
+{
+	std::bitset<MAX_WALLS> listed;
+	count_array_t<wallnum_t, MAX_WALLS> walls;
+	void add(const wallnum_t w)
+	{
+		if (listed[w])
+			return;
+		listed[w] = true;
+		walls.emplace_back(w);
+	}
+	void clear()
+	{
+		listed.reset();
+		walls.clear();
+	}
+};
+
+extern exploding_wall_list Exploding_walls;
 }
 
 #ifdef dsx
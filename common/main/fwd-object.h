@@ -24,7 +24,12 @@ namespace dcx {
 
 // Movement types
 enum movement_type_t : uint8_t;
-constexpr std::integral_constant<std::size_t, 350> MAX_OBJECTS{};
+// Set by the max_objects build option.  350 matches the original
+// games; larger values let big levels and crowded multiplayer games run
+// without culling objects.
+constexpr std::integral_constant<std::size_t, DXX_MAX_OBJECTS> MAX_OBJECTS{};
+static_assert(MAX_OBJECTS >= 350, "MAX_OBJECTS must not be below the original limit");
+static_assert(MAX_OBJECTS <= INT16_MAX, "demos and multiplayer packets store object numbers as signed 16-bit values");
 constexpr std::integral_constant<std::size_t, MAX_OBJECTS - 20> MAX_USED_OBJECTS{};
 
 }
@@ -247,6 +252,10 @@ void compress_objects();
 // Render an object.  Calls one of several routines based on type
 void render_object(grs_canvas &, vmobjptridx_t obj);
 
+// Do what render_object does for an object which is not drawn because
+// it is outside the view, other than drawing it
+void render_object_outside_view(vmobjptridx_t obj);
+
 // draw an object that is a texture-mapped rod
 void draw_object_tmap_rod(grs_canvas &, vcobjptridx_t obj, bitmap_index bitmap, int lighted);
 
@@ -165,6 +165,20 @@ namespace dsx {
 DXX_VALPTRIDX_DEFINE_SUBTYPE_TYPEDEFS(dl_index, dlindex);
 int subtract_light(const d_level_shared_destructible_light_state &LevelSharedDestructibleLightState, vmsegptridx_t segnum, sidenum_fast_t sidenum);
 int add_light(const d_level_shared_destructible_light_state &LevelSharedDestructibleLightState, vmsegptridx_t segnum, sidenum_fast_t sidenum);
+
+// While one exists, subtract_light and add_light only record what they
+// change, and the outermost one applies all of it in one pass when it is
+// destroyed.  Lights which overlap are then summed before anything is
+// stored.
+class light_change_batch
+{
+	const bool owner;
+public:
+	light_change_batch(const d_level_shared_destructible_light_state &);
+	light_change_batch(const light_change_batch &) = delete;
+	light_change_batch &operator=(const light_change_batch &) = delete;
+	~light_change_batch();
+};
 }
 #endif
 
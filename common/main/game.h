@@ -192,6 +192,13 @@ extern void save_screen_shot(int automap_flag);
 
 }
 #endif
+namespace dcx {
+// Collect finished framebuffer readbacks and report failed writes.
+// Called once per pass of the event loop.
+void screenshot_service();
+// Finish every screenshot in progress.  Needs the GL context.
+void screenshot_close();
+}
 #endif
 
 enum cockpit_mode_t
@@ -302,6 +309,8 @@ extern d_flickering_light_state Flickering_light_state;
 
 extern int BigWindowSwitch;
 void compute_slide_segs();
+// Bring the texture of a sliding side up to the current game time.
+void slide_side_texture(vmsegptridx_t segp, unsigned sidenum);
 
 // turn flickering off (because light has been turned off)
 void disable_flicker(d_flickering_light_state &fls, vmsegidx_t segnum, unsigned sidenum);
@@ -368,6 +377,8 @@ extern game_cheats cheats;
 window *game_setup();
 window_event_result game_handler(window *wind,const d_event &event, const unused_window_userdata_t *);
 window_event_result ReadControls(const d_event &event);
+// Select weapons and use items as the controls ask.
+void do_weapon_n_item_stuff(object_array &objects);
 bool allowed_to_fire_laser(const player_info &);
 }
 #endif
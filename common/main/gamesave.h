@@ -31,6 +31,11 @@ COPYRIGHT 1993-1999 PARALLAX SOFTWARE CORPORATION.  ALL RIGHTS RESERVED.
 
 #ifdef __cplusplus
 #include "fwd-segment.h"
+#include "fwd-object.h"
+
+namespace dcx {
+struct d_level_shared_boss_state;
+}
 
 #define D1X_LEVEL_FILE_EXTENSION	"RDL"
 #define D2X_LEVEL_FILE_EXTENSION	"RL2"
@@ -63,6 +68,13 @@ int save_level(
 	const d_level_shared_destructible_light_state &LevelSharedDestructibleLightState,
 #endif
 	const char *filename);
+// validate_segment_all, or restore what it computed for this level the
+// last time it was loaded.  For use by load_mine_data_compiled.
+void level_cache_validate_segment_all(d_level_shared_segment_state &);
+// Boss segment lists for this boss in the current level, saved by
+// level_cache_write_boss_segments the last time they were built.
+bool level_cache_read_boss_segments(const object_base &boss, d_level_shared_boss_state &);
+void level_cache_write_boss_segments(const object_base &boss, const d_level_shared_boss_state &);
 }
 #endif
 
@@ -70,6 +82,10 @@ extern char Gamesave_current_filename[PATH_MAX];
 
 extern int Gamesave_current_version;
 
+// 64-bit hash of the bytes of the level file last loaded, which tells
+// two copies of a level apart where the segment checksum cannot.
+extern uint64_t Gamesave_current_hash;
+
 extern int Gamesave_num_org_robots;
 
 // In dumpmine.c
@@ -72,6 +72,7 @@ static inline vms_vector compute_segment_center(fvcvertptr &vcvertptr, const sha
 	compute_segment_center(vcvertptr, v, sp);
 	return v;
 }
+fix compute_segment_radius(fvcvertptr &vcvertptr, const shared_segment &sp, const vms_vector &center);
 
 // Fill in array with four absolute point numbers for a given side
 void get_side_verts(side_vertnum_list_t &vertlist, const shared_segment &seg, unsigned sidenum);
@@ -164,6 +165,11 @@ segmasks get_seg_masks(fvcvertptr &, const vms_vector &checkp, const shared_segm
 imsegptridx_t find_point_seg(const d_level_shared_segment_state &, d_level_unique_segment_state &, const vms_vector &p, imsegptridx_t segnum);
 icsegptridx_t find_point_seg(const d_level_shared_segment_state &, const vms_vector &p, icsegptridx_t segnum);
 
+// Index the segments by position, so that step 3 above tests only the
+// segments near the point.  Must be called again whenever the mine
+// geometry changes.
+void build_segment_point_grid();
+
 //      ----------------------------------------------------------------------------------------------------------
 //      Determine whether seg0 and seg1 are reachable using wid_flag to go through walls.
 //      For example, set to WID_RENDPAST_FLAG to see if sound can get from one segment to the other.
@@ -217,6 +223,14 @@ unsigned set_segment_depths(vcsegidx_t start_seg, const array<uint8_t, MAX_SEGME
 static inline void flush_fcd_cache() {}
 #elif defined(DXX_BUILD_DESCENT_II)
 void flush_fcd_cache();
+// Changes every time flush_fcd_cache is called
+unsigned fcd_cache_generation();
+struct fcd_cache_stats
+{
+	unsigned hits, misses;
+};
+// Lookups of find_connected_distance since startup
+fcd_cache_stats fcd_cache_get_stats();
 void apply_all_changed_light(const d_level_shared_destructible_light_state &LevelSharedDestructibleLightState, fvmsegptridx &vmsegptridx);
 void	set_ambient_sound_flags(void);
 #endif
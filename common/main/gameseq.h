@@ -78,6 +78,8 @@ window_event_result PlayerFinishedLevel(int secret_flag);
 
 }
 #endif
+// start reading the files of the level after this one, as the player leaves
+void read_ahead_next_level();
 namespace dsx {
 // called when the player has died
 window_event_result DoPlayerDead(void);
@@ -32,6 +32,8 @@ COPYRIGHT 1993-1999 PARALLAX SOFTWARE CORPORATION.  ALL RIGHTS RESERVED.
 #ifdef __cplusplus
 #include <vector>
 #include "fwd-event.h"
+#include "fwd-object.h"
+#include "fwd-vecmat.h"
 #include "compiler-array.h"
 
 #ifdef dsx
@@ -119,6 +121,15 @@ extern const array<uint8_t, MAX_DXX_REBIRTH_CONTROLS> DefaultKeySettingsRebirth;
 #endif
 
 extern void kconfig_read_controls(const d_event &event, int automap_flag);
+#ifdef dsx
+namespace dsx {
+/* For -latelook: the turn which mouse and joystick input queued since
+ * the controls were read would add to the next frame.  Only the view
+ * uses it; the input is read as usual on the next frame.
+ */
+void kconfig_late_look(const object_base &plr, vms_angvec &angles);
+}
+#endif
 
 enum class kconfig_type
 {
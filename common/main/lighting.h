@@ -39,9 +39,26 @@ COPYRIGHT 1993-1999 PARALLAX SOFTWARE CORPORATION.  ALL RIGHTS RESERVED.
 
 namespace dcx {
 
+/* A light which the GL renderer applies to walls per pixel
+ * (-gl_pixellight) instead of set_dynamic_light adding it to
+ * Dynamic_light.  It lights what lies within range of pos.
+ */
+struct pixel_light
+{
+	vms_vector pos;
+	fix range;
+	g3s_lrgb emission;
+};
+
+constexpr std::integral_constant<unsigned, 32> MAX_PIXEL_LIGHTS{};
+
 struct d_level_unique_light_state
 {
 	array<g3s_lrgb, MAX_VERTICES> Dynamic_light;
+	unsigned Num_pixel_lights;
+	//	Changed whenever Pixel_lights is rebuilt
+	uint16_t Pixel_light_generation;
+	array<pixel_light, MAX_PIXEL_LIGHTS> Pixel_lights;
 };
 extern d_level_unique_light_state LevelUniqueLightState;
 
@@ -62,6 +79,15 @@ void toggle_headlight_active(object &);
 #endif
 }
 void start_lighting_frame(const object &viewer);
+
+// Bring Dynamic_light up to date with the lights which changed since the
+// last call.
+void set_dynamic_light();
+// Forget the lights of the previous mine.  Call when a mine is loaded.
+void reset_dynamic_light();
+// The light that the pixel lights add at pos, the same as set_dynamic_light
+// would have added to a vertex there.
+g3s_lrgb compute_pixel_light(const vms_vector &pos);
 #endif
 
 #endif
@@ -220,6 +220,10 @@ void bm_read_extra_robots(const char *fname, Mission::descent_version_type type)
 //Returns nullptr if mission loaded ok, else error string.
 const char *load_mission_by_name (const char *mission_name);
 
+//Brings the catalog of mission names up to date in the background.
+void mission_catalog_refresh();
+void mission_catalog_close();
+
 //Handles creating and selecting from the mission list.
 //Returns 1 if a mission was loaded.
 int select_mission (int anarchy_mode, const char *message, window_event_result (*when_selected)(void));
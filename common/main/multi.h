@@ -96,7 +96,9 @@ extern int multi_protocol; // set and determinate used protocol
 #define MULTI_PROTO_UDP 1 // UDP protocol
 
 // What version of the multiplayer protocol is this? Increment each time something drastic changes in Multiplayer without the version number changes. Reset to 0 each time the version of the game changes
-#define MULTI_PROTO_VERSION	static_cast<uint16_t>(9)
+// Builds with a non-default max_objects use their own protocol number,
+// since their object numbers do not fit in a default build.
+#define MULTI_PROTO_VERSION	static_cast<uint16_t>(MAX_OBJECTS == 350 ? 13 : 0x8000 | MAX_OBJECTS)
 // PROTOCOL VARIABLES AND DEFINES - END
 
 // limits for Packets (i.e. positional updates) per sec
@@ -406,6 +408,9 @@ uint16_t objnum_local_to_remote(objnum_t local_obj, int8_t *owner);
 owned_remote_objnum objnum_local_to_remote(objnum_t local);
 void map_objnum_local_to_remote(int local, int remote, int owner);
 void map_objnum_local_to_local(objnum_t objnum);
+// Which player 'owns' a local object for network purposes, -1 = loaded at start
+int8_t multi_object_owner(objnum_t objnum);
+void multi_clear_object_owner(objnum_t objnum);
 void reset_network_objects();
 int multi_objnum_is_past(objnum_t objnum);
 void multi_do_ping_frame();
@@ -545,9 +550,6 @@ extern fix Show_kill_list_timer;
 extern ntstring<MAX_MESSAGE_LEN - 1> Network_message;
 extern int Network_message_reciever;
 
-// Which player 'owns' each local object for network purposes
-extern array<sbyte, MAX_OBJECTS> object_owner;
-
 extern int multi_quit_game;
 
 extern array<msgsend_state_t, MAX_PLAYERS> multi_sending_message;
@@ -805,6 +807,7 @@ struct netgame_info : prohibit_void_ptr<netgame_info>, ignore_window_pointer_t
 	uint8_t BrightPlayers;
 	uint8_t InvulAppear;
 	ushort						segments_checksum;
+	uint64_t					level_hash;
 	int						KillGoal;
 	fix						PlayTimeAllowed;
 	fix						level_time;
@@ -18,11 +18,14 @@
 #include "compiler-array.h"
 #include "ntstring.h"
 #include "fwd-window.h"
+#include "fwd-gr.h"
 
 // Exported functions
 #ifdef dsx
 namespace dsx {
 window_event_result net_udp_setup_game(void);
+// Host the saved netgame profile on mission without showing any menus
+void net_udp_autohost(const char *mission);
 }
 #endif
 void net_udp_manual_join_game();
@@ -47,6 +50,10 @@ void net_udp_disconnect_player(int playernum);
 window_event_result net_udp_level_sync();
 void net_udp_send_mdata_direct(const ubyte *data, int data_len, int pnum, int priority);
 void net_udp_send_netgame_update();
+// Set by the "netstat show" console command.
+extern bool net_udp_stats_overlay;
+void net_udp_stats_init();
+void net_udp_show_stats(grs_canvas &);
 
 // Some defines
 // Our default port - easy to remember: D = 4, X = 24, X = 24
@@ -63,12 +70,12 @@ constexpr uint16_t TRACKER_PORT_DEFAULT = 9999;
 namespace dcx {
 constexpr std::integral_constant<unsigned, 12> UDP_NETGAMES_PPAGE{}; // Netgames on one page of Netlist
 }
-#define UDP_NETGAMES_PAGES 75 // Pages available on Netlist (UDP_MAX_NETGAMES/UDP_NETGAMES_PPAGE)
 #define UDP_TIMEOUT (5*F1_0) // 5 seconds disconnect timeout
 #define UDP_MDATA_STOR_QUEUE_SIZE 1024 // Store up to 1024 MDATA packets
 #define UDP_MDATA_STOR_MIN_FREE_2JOIN 384 // have at least this many free packet slots before we let someone join the game
 #define UDP_MDATA_PKT_NUM_MIN 1 // start from pkt_num 1 (0 is used to initialize the trace list)
 #define UDP_MDATA_PKT_NUM_MAX (UDP_MDATA_STOR_QUEUE_SIZE*100) // the max value for pkt_num. roll over when we go any higher. this should be smaller than INT_MAX
+#define UDP_MDATA_PEER_MAX_PENDING (UDP_MDATA_STOR_QUEUE_SIZE/2) // the host drops a player who leaves this many packets un-ACK'd, so one bad connection cannot fill the store
 
 // UDP-Packet identificators (ubyte) and their (max. sizes).
 #define UPID_VERSION_DENY			  1 // Netgame join or info has been denied due to version difference.
@@ -96,7 +103,10 @@ constexpr std::integral_constant<unsigned, 12> UDP_NETGAMES_PPAGE{}; // Netgames
 #define UPID_ENDLEVEL_H				 14 // Packet from Host to all Clients containing connect-states and kills information about everyone in the game.
 #define UPID_ENDLEVEL_C				 15 // Packet from Client to Host containing connect-state and kills information from this Client.
 #define UPID_PDATA				 16 // Packet from player containing his movement data.
-#define UPID_PDATA_SIZE				 49
+#define UPID_PDATA_SIZE				 26 // Without the velocity and rotational velocity, which are only sent when not zero.
+#define UPID_PDATA_VECTOR_SIZE			 12
+#define UPID_PDATA_HAS_VELOCITY			  1
+#define UPID_PDATA_HAS_ROTVEL			  2
 #define UPID_MDATA_PNORM			 17 // Packet containing multi buffer from a player. Priority 0,1 - no ACK needed.
 #define UPID_MDATA_PNEEDACK			 18 // Packet containing multi buffer from a player. Priority 2 - ACK needed. Also contains pkt_num
 #define UPID_MDATA_ACK				 19 // ACK packet for UPID_MDATA_P1.
@@ -165,10 +175,11 @@ struct UDP_mdata_store : prohibit_void_ptr<UDP_mdata_store>
 // structure to keep track of MDATA packets we already got, which we expect from another player and the pkt_num for the next packet we want to send to another player
 struct UDP_mdata_check : public prohibit_void_ptr<UDP_mdata_check>
 {
-	array<uint32_t, UDP_MDATA_STOR_QUEUE_SIZE>			pkt_num; 	// all those we got just recently, so we can ignore them if we get them again
-	int				cur_slot; 				// index we can use for a new pkt_num
+	array<uint16_t, UDP_MDATA_STOR_QUEUE_SIZE>			queue_slot; 	// store slot of each pkt_num we sent to this player, indexed by pkt_num % UDP_MDATA_STOR_QUEUE_SIZE
+	uint16_t			recv_count;				// how many pkt_num before pkt_num_torecv we count as already received, up to UDP_MDATA_STOR_QUEUE_SIZE
 	uint32_t			pkt_num_torecv; 			// the next pkt_num we await for this player
 	uint32_t			pkt_num_tosend; 			// the next pkt_num we want to send to another player
+	uint32_t			pkt_num_unacked;			// the oldest pkt_num this player has not ACK'd yet
 };
 
 #endif
@@ -144,6 +144,8 @@ extern window_event_result newdemo_playback_one_frame();
 #ifdef dsx
 namespace dsx {
 extern window_event_result newdemo_goto_end(int to_rewrite);
+// Jump to the previous (direction < 0) or next recorded keyframe
+window_event_result newdemo_seek_keyframe(int direction);
 }
 #endif
 extern window_event_result newdemo_goto_beginning();
@@ -158,6 +160,8 @@ extern void newdemo_start_recording();
 extern void newdemo_stop_recording();
 
 extern int newdemo_swap_endian(const char *filename);
+// Verify or index every demo in DEMO_DIR, for -demo_batch
+void newdemo_batch(const char *op);
 
 extern int newdemo_get_percent_done();
 
@@ -585,6 +585,8 @@ struct d_level_unique_object_state
 {
 	unsigned num_objects = 0;
 	unsigned Debris_object_count = 0;
+	// Bumped by obj_allocate, so callers can tell when objects appeared
+	unsigned allocations = 0;
 #if defined(DXX_BUILD_DESCENT_II)
 	d_guided_missile_indices Guided_missile;
 #endif
@@ -28,10 +28,17 @@ COPYRIGHT 1993-1999 PARALLAX SOFTWARE CORPORATION.  ALL RIGHTS RESERVED.
 #define _PAGING_H
 
 #ifdef __cplusplus
+#include "fwd-partial_range.h"
+#include "fwd-segment.h"
 
 #ifdef dsx
 namespace dsx {
 void paging_touch_all(const d_vclip_array &Vclip);
+/* Page in a few of the wall textures of the segments up to a few
+ * portals beyond segments, typically the last ones of the render list,
+ * so that they are ready before the player can see them.
+ */
+void paging_prefetch_beyond(const partial_range_t<const segnum_t *> segments);
 
 }
 #endif
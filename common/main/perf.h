@@ -0,0 +1,28 @@
+/*
+ * This file is part of the DXX-Rebirth project <https://www.dxx-rebirth.com/>.
+ * It is copyright by its individual contributors, as recorded in the
+ * project's Git history.  See COPYING.txt at the top level for license
+ * terms and a link to the Git history.
+ */
+/*
+ *
+ * Console variables for the performance settings, and the perf_report
+ * command
+ *
+ */
+
+#pragma once
+
+#include "dsx-ns.h"
+
+#ifdef dsx
+namespace dsx {
+
+/* Register the cvars of the settings which can change while the game
+ * runs, starting from the values the command line chose, and the
+ * perf_report command.
+ */
+void perf_init();
+
+}
+#endif
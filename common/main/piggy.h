@@ -98,6 +98,12 @@ int piggy_register_sound( digi_sound * snd, const char * name, int in_file );
 bitmap_index piggy_find_bitmap(const char *name);
 }
 int piggy_find_sound(const char *name);
+#if DXX_USE_EDITOR
+/* Hash the names of every bitmap and sound registered so far.  These
+ * decide which files BITMAPS.TBL parsing finds already loaded.
+ */
+uint64_t piggy_names_hash();
+#endif
 
 void piggy_read_bitmap_data(grs_bitmap * bmp);
 namespace dsx {
@@ -105,6 +111,11 @@ void piggy_read_sound_data(digi_sound *snd);
 }
 
 void piggy_load_level_data();
+/* Start reading the files of the level about to be loaded in the
+ * background.  level_file is tried first, then mission_level_file.
+ */
+void piggy_read_ahead_level(const char *level_file, const char *mission_level_file);
+void piggy_read_ahead_stop();
 
 #if defined(DXX_BUILD_DESCENT_I)
 constexpr std::integral_constant<unsigned, 1800> MAX_BITMAP_FILES{};
@@ -120,6 +131,10 @@ constexpr std::integral_constant<unsigned, 2620> MAX_BITMAP_FILES{};
 namespace dsx {
 extern void piggy_bitmap_page_in( bitmap_index bmp );
 void piggy_bitmap_page_out_all();
+/* Page in bmp unless the cache would first have to page out every
+ * bitmap.  Returns true if bmp was read.
+ */
+bool piggy_bitmap_prefetch(bitmap_index bmp);
 
 using GameBitmaps_array = array<grs_bitmap, MAX_BITMAP_FILES>;
 extern array<digi_sound, MAX_SOUND_FILES> GameSounds;
@@ -134,6 +149,8 @@ static inline void _piggy_page_in(bitmap_index bmp) {
 }
 #endif
 
+// Reads a sound left unread by piggy_read_sounds under -lazysounds.
+void piggy_sound_page_in(int soundnum);
 #if defined(DXX_BUILD_DESCENT_I)
 void piggy_read_sounds(int pc_shareware);
 #elif defined(DXX_BUILD_DESCENT_II)
@@ -205,6 +205,11 @@ int new_player_config();
 
 int read_player_file();
 
+// Wait for write_player_file to finish writing.
+void player_file_wait_for_writes();
+// Wait for writes, then make the next read_player_file read the files.
+void player_file_forget();
+
 // set a new highest level for player for this mission
 }
 #endif
@@ -97,6 +97,7 @@ public:
 // how many polygon objects there are
 extern unsigned N_polygon_models;
 void init_polygon_models();
+void polymodel_cache_close();
 
 }
 #ifdef dsx
@@ -168,7 +169,7 @@ namespace dcx {
  */
 extern void polymodel_read(polymodel *pm, PHYSFS_File *fp);
 }
-#if 0
+#if DXX_USE_EDITOR
 void polymodel_write(PHYSFS_File *fp, const polymodel &pm);
 #endif
 
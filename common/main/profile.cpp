@@ -0,0 +1,350 @@
+/*
+ * This file is part of the DXX-Rebirth project <https://www.dxx-rebirth.com/>.
+ * It is copyright by its individual contributors, as recorded in the
+ * project's Git history.  See COPYING.txt at the top level for license
+ * terms and a link to the Git history.
+ *
+ */
+/*
+ *
+ * Per-frame timing of the main game loop phases, and tracing of the
+ * startup and level load phases
+ *
+ */
+
+#include <algorithm>
+#include <numeric>
+#include <string>
+#include <vector>
+#include "profile.h"
+#include "cmd.h"
+#include "console.h"
+#include "physfsx.h"
+#include "strutil.h"
+
+#include "compiler-array.h"
+
+namespace dcx {
+
+namespace {
+
+/* About 4 seconds at 60 frames per second. */
+constexpr unsigned profile_history_frames = 256;
+
+struct profile_history
+{
+	array<array<uint32_t, profile_history_frames>, profile_phase_count> frames;
+	array<uint32_t, profile_phase_count> current;
+	unsigned next = 0;
+	unsigned count = 0;
+};
+
+}
+
+bool profile_overlay;
+bool profile_gpu_timing;
+static profile_history profile_state;
+
+namespace {
+
+struct trace_state
+{
+	RAIIPHYSFS_File file;
+	std::chrono::steady_clock::time_point base;
+	bool first;
+};
+
+}
+
+static trace_state trace_output;
+
+namespace {
+
+struct timedemo_state
+{
+	bool active;
+	bool started;
+	std::chrono::steady_clock::time_point last;
+	std::string report;
+	/* Wall time of each frame, in microseconds */
+	std::vector<uint32_t> frames;
+	array<uint64_t, profile_phase_count> phase_total;
+};
+
+}
+
+static timedemo_state timedemo;
+
+static const array<const char *, profile_phase_count> profile_phase_names{{
+	"ai",
+	"physics",
+	"network",
+	"sound",
+	"render",
+	"sync",
+	"swap",
+	"gpu",
+}};
+
+profile_scope::~profile_scope()
+{
+	const auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start);
+	profile_add_time(phase, elapsed.count());
+}
+
+void profile_add_time(const profile_phase phase, const uint32_t us)
+{
+	profile_state.current[static_cast<unsigned>(phase)] += us;
+}
+
+/* Event names and details are short, so escape through a fixed buffer
+ * and cut off anything which does not fit.
+ */
+static const char *trace_escape(array<char, 256> &buf, const char *s)
+{
+	auto o = buf.begin();
+	const auto e = std::prev(buf.end(), 7);
+	for (uint8_t c; (c = *s) && o < e; ++s)
+	{
+		if (c == '"' || c == '\\')
+		{
+			*o++ = '\\';
+			*o++ = c;
+		}
+		else if (c < 0x20)
+			o += snprintf(o, 7, "\\u%04x", c);
+		else
+			*o++ = c;
+	}
+	*o = 0;
+	return buf.data();
+}
+
+/* Write the fields every event has.  The caller writes the rest of the
+ * event and closes it.
+ */
+static void trace_begin_event(const char *const name, const std::chrono::steady_clock::time_point when)
+{
+	auto &t = trace_output;
+	array<char, 256> buf;
+	const auto ts = std::chrono::duration_cast<std::chrono::microseconds>(when - t.base).count();
+	PHYSFSX_printf(t.file, "%s\n{\"name\":\"%s\",\"cat\":\"dxx\",\"pid\":1,\"tid\":1,\"ts\":%lld", t.first ? "" : ",", trace_escape(buf, name), static_cast<long long>(ts));
+	t.first = false;
+}
+
+trace_scope::~trace_scope()
+{
+	auto &t = trace_output;
+	if (!t.file)
+		return;
+	const auto dur = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+	trace_begin_event(name, start);
+	PHYSFSX_printf(t.file, ",\"ph\":\"X\",\"dur\":%lld", static_cast<long long>(dur));
+	if (detail)
+	{
+		array<char, 256> buf;
+		PHYSFSX_printf(t.file, ",\"args\":{\"detail\":\"%s\"}", trace_escape(buf, detail));
+	}
+	PHYSFSX_puts_literal(t.file, "}");
+}
+
+void trace_open(const char *const filename)
+{
+	auto &t = trace_output;
+	t.file = PHYSFSX_openWriteBuffered(filename);
+	if (!t.file)
+	{
+		con_printf(CON_URGENT, "DXX-Rebirth: failed to open trace file \"%s\": %s", filename, PHYSFS_getLastError());
+		return;
+	}
+	t.base = std::chrono::steady_clock::now();
+	t.first = true;
+	/* The closing bracket is optional in the Chrome trace format, so
+	 * the file stays readable after a crash.
+	 */
+	PHYSFSX_puts_literal(t.file, "[");
+}
+
+void trace_close()
+{
+	auto &t = trace_output;
+	if (!t.file)
+		return;
+	PHYSFSX_puts_literal(t.file, "\n]\n");
+	t.file.reset();
+}
+
+void trace_mark(const char *const name)
+{
+	auto &t = trace_output;
+	if (!t.file)
+		return;
+	trace_begin_event(name, std::chrono::steady_clock::now());
+	PHYSFSX_puts_literal(t.file, ",\"ph\":\"i\",\"s\":\"g\"}");
+}
+
+void trace_counter(const char *const name, const long long value)
+{
+	auto &t = trace_output;
+	if (!t.file)
+		return;
+	trace_begin_event(name, std::chrono::steady_clock::now());
+	PHYSFSX_printf(t.file, ",\"ph\":\"C\",\"args\":{\"value\":%lld}}", value);
+}
+
+void profile_end_frame()
+{
+	auto &h = profile_state;
+	auto &t = timedemo;
+	if (t.active)
+	{
+		const auto now = std::chrono::steady_clock::now();
+		/* The first frame has no start to measure from. */
+		if (t.started)
+		{
+			t.frames.emplace_back(std::chrono::duration_cast<std::chrono::microseconds>(now - t.last).count());
+			for (unsigned p = 0; p != profile_phase_count; ++p)
+				t.phase_total[p] += h.current[p];
+		}
+		t.started = true;
+		t.last = now;
+	}
+	const auto n = h.next;
+	for (unsigned p = 0; p != profile_phase_count; ++p)
+	{
+		h.frames[p][n] = h.current[p];
+		h.current[p] = 0;
+	}
+	h.next = (n + 1) % profile_history_frames;
+	if (h.count < profile_history_frames)
+		++h.count;
+}
+
+const char *profile_phase_name(const profile_phase p)
+{
+	return profile_phase_names[static_cast<unsigned>(p)];
+}
+
+uint32_t profile_last_frame_time(const profile_phase p)
+{
+	auto &h = profile_state;
+	if (!h.count)
+		return 0;
+	return h.frames[static_cast<unsigned>(p)][(h.next + profile_history_frames - 1) % profile_history_frames];
+}
+
+void profile_dump()
+{
+	auto &h = profile_state;
+	const auto count = h.count;
+	if (!count)
+	{
+		con_puts(CON_NORMAL, "profile: no frames recorded");
+		return;
+	}
+	con_printf(CON_NORMAL, "profile: last %u frames, times in microseconds", count);
+	array<uint32_t, profile_history_frames> sorted;
+	for (unsigned p = 0; p != profile_phase_count; ++p)
+	{
+		const auto &frames = h.frames[p];
+		/* Until the history fills, the recorded frames are at the start. */
+		const auto b = sorted.begin(), e = std::next(b, count);
+		std::copy_n(frames.begin(), count, b);
+		std::sort(b, e);
+		const auto sum = std::accumulate(b, e, uint64_t());
+		const auto p99 = sorted[(count - 1) * 99 / 100];
+		con_printf(CON_NORMAL, "%-8s min %6u  avg %6u  p99 %6u  max %6u", profile_phase_names[p], *b, static_cast<unsigned>(sum / count), p99, e[-1]);
+	}
+}
+
+void profile_timedemo_begin(const char *const report)
+{
+	auto &t = timedemo;
+	t.active = true;
+	t.started = false;
+	t.report = report;
+	t.frames.clear();
+	t.phase_total = {};
+}
+
+/* Frames per second over the slowest fraction 1/divisor of the frames,
+ * given the frame times sorted slowest first.
+ */
+static double timedemo_low(const std::vector<uint32_t> &sorted, const unsigned divisor)
+{
+	const auto n = std::max<std::size_t>(sorted.size() / divisor, 1);
+	const auto sum = std::accumulate(sorted.begin(), std::next(sorted.begin(), n), uint64_t());
+	return sum ? 1e6 * n / sum : 0;
+}
+
+void profile_timedemo_end()
+{
+	auto &t = timedemo;
+	if (!t.active)
+		return;
+	t.active = false;
+	const auto count = t.frames.size();
+	if (!count)
+	{
+		con_puts(CON_URGENT, "timedemo: no frames recorded");
+		return;
+	}
+	auto sorted = t.frames;
+	std::sort(sorted.begin(), sorted.end(), [](const uint32_t a, const uint32_t b) { return a > b; });
+	const auto total = std::accumulate(sorted.begin(), sorted.end(), uint64_t());
+	const double fps = total ? 1e6 * count / total : 0;
+	const auto low1 = timedemo_low(sorted, 100), low01 = timedemo_low(sorted, 1000);
+	con_printf(CON_URGENT, "timedemo: %u frames in %.3f seconds, %.1f fps, 1%% low %.1f fps, 0.1%% low %.1f fps", static_cast<unsigned>(count), total / 1e6, fps, low1, low01);
+	for (unsigned p = 0; p != profile_phase_count; ++p)
+		con_printf(CON_URGENT, "timedemo: %-8s avg %8.1f us", profile_phase_names[p], static_cast<double>(t.phase_total[p]) / count);
+	RAIIPHYSFS_File file{PHYSFSX_openWriteBuffered(t.report.c_str())};
+	if (!file)
+	{
+		con_printf(CON_URGENT, "timedemo: failed to open report \"%s\": %s", t.report.c_str(), PHYSFS_getLastError());
+		return;
+	}
+	PHYSFSX_printf(file, "{\n\t\"frames\": %u,\n\t\"seconds\": %.6f,\n\t\"fps\": %.3f,\n\t\"low_1_percent_fps\": %.3f,\n\t\"low_0_1_percent_fps\": %.3f,\n\t\"phase_avg_us\": {", static_cast<unsigned>(count), total / 1e6, fps, low1, low01);
+	for (unsigned p = 0; p != profile_phase_count; ++p)
+		PHYSFSX_printf(file, "%s\n\t\t\"%s\": %.3f", p ? "," : "", profile_phase_names[p], static_cast<double>(t.phase_total[p]) / count);
+	PHYSFSX_puts_literal(file, "\n\t}\n}\n");
+}
+
+static void profile_cmd(unsigned long argc, const char *const *const argv)
+{
+	if (argc == 2)
+	{
+		const auto a = argv[1];
+		if (!d_stricmp(a, "dump"))
+		{
+			profile_dump();
+			return;
+		}
+		if (!d_stricmp(a, "show"))
+		{
+			profile_overlay = !profile_overlay;
+			return;
+		}
+		if (!d_stricmp(a, "gpu"))
+		{
+			profile_gpu_timing = !profile_gpu_timing;
+			con_printf(CON_NORMAL, "profile: GPU timing %s", profile_gpu_timing ? "enabled" : "disabled");
+			return;
+		}
+		if (!d_stricmp(a, "reset"))
+		{
+			profile_state = {};
+			return;
+		}
+	}
+	cmd_insertf("help %s", argv[0]);
+}
+
+void profile_init()
+{
+	cmd_addcommand("profile", profile_cmd, "profile dump\n"   "    write min/avg/p99/max frame time of each game loop phase to the console\n"
+	                                       "profile show\n"   "    toggle the on-screen profile overlay\n"
+	                                       "profile gpu\n"    "    toggle GPU timer queries around the 3D view\n"
+	                                       "profile reset\n"  "    discard the recorded frames");
+}
+
+}
@@ -0,0 +1,129 @@
+/*
+ * This file is part of the DXX-Rebirth project <https://www.dxx-rebirth.com/>.
+ * It is copyright by its individual contributors, as recorded in the
+ * project's Git history.  See COPYING.txt at the top level for license
+ * terms and a link to the Git history.
+ *
+ */
+/*
+ *
+ * Per-frame timing of the main game loop phases, and tracing of the
+ * startup and level load phases
+ *
+ */
+
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include "dxxsconf.h"
+
+namespace dcx {
+
+enum class profile_phase : uint8_t
+{
+	ai,
+	physics,
+	network,
+	sound,
+	/* render includes sync and swap */
+	render,
+	/* CPU time spent in ogl_sync::before_swap */
+	sync,
+	/* CPU time spent in the buffer swap call */
+	swap,
+	/* GPU time of the 3D view, from GL_ARB_timer_query.  The result
+	 * is read back two frames late, so that reading it never stalls.
+	 */
+	gpu,
+};
+
+constexpr unsigned profile_phase_count = static_cast<unsigned>(profile_phase::gpu) + 1;
+
+/* Set by the "profile show" console command. */
+extern bool profile_overlay;
+/* Set by the "profile gpu" console command. */
+extern bool profile_gpu_timing;
+
+/* Add the lifetime of this object to the current frame's time for a
+ * phase.  A phase may be entered several times per frame.
+ */
+class profile_scope
+{
+	const profile_phase phase;
+	const std::chrono::steady_clock::time_point start;
+public:
+	explicit profile_scope(const profile_phase p) :
+		phase(p), start(std::chrono::steady_clock::now())
+	{
+	}
+	profile_scope(const profile_scope &) = delete;
+	profile_scope &operator=(const profile_scope &) = delete;
+	~profile_scope();
+};
+
+/* -tracefile: the start and duration of each startup and level load
+ * phase, written as Chrome trace events which chrome://tracing and
+ * Perfetto can show.  Phases may nest.  Only the main thread may trace.
+ * Builds with tracing=1 also trace the game loop; see DXX_TRACE_ZONE.
+ */
+class trace_scope
+{
+	const char *const name;
+	const char *const detail;
+	const std::chrono::steady_clock::time_point start;
+public:
+	/* detail, if not null, is shown with the event and must outlive
+	 * the scope.
+	 */
+	explicit trace_scope(const char *const n, const char *const d = nullptr) :
+		name(n), detail(d), start(std::chrono::steady_clock::now())
+	{
+	}
+	trace_scope(const trace_scope &) = delete;
+	trace_scope &operator=(const trace_scope &) = delete;
+	~trace_scope();
+};
+
+/* Start writing trace events to a file in the write directory. */
+void trace_open(const char *filename);
+void trace_close();
+/* Record a point in time, such as reaching the main menu. */
+void trace_mark(const char *name);
+/* Record the value of a counter, shown as a graph over time. */
+void trace_counter(const char *name, long long value);
+
+/* Tracing of the per-frame game loop, for finding the cause of a slow
+ * frame.  This writes several events per frame to the -tracefile, so
+ * it is only built when SCons is given tracing=1.  Otherwise the
+ * macros expand to nothing, and their arguments are not evaluated.
+ */
+#if DXX_USE_TRACING
+#define DXX_TRACE_ZONE(NAME)	const ::dcx::trace_scope dxx_trace_zone(NAME)
+#define DXX_TRACE_COUNTER(NAME,VALUE)	::dcx::trace_counter(NAME, VALUE)
+#define DXX_TRACE_FRAME()	::dcx::trace_mark("frame")
+#else
+#define DXX_TRACE_ZONE(NAME)	static_cast<void>(0)
+#define DXX_TRACE_COUNTER(NAME,VALUE)	static_cast<void>(0)
+#define DXX_TRACE_FRAME()	static_cast<void>(0)
+#endif
+
+/* Add a time measured elsewhere, in microseconds, to the current frame. */
+void profile_add_time(profile_phase, uint32_t);
+/* Move the times of the current frame into the history. */
+void profile_end_frame();
+const char *profile_phase_name(profile_phase);
+/* Time of a phase in the last complete frame, in microseconds. */
+uint32_t profile_last_frame_time(profile_phase);
+/* -timedemo: keep the time of every frame from now on, not only the
+ * last few.  profile_timedemo_end logs the frame rate, its 1% and 0.1%
+ * lows and the average time of each phase, and writes them to report
+ * as JSON.
+ */
+void profile_timedemo_begin(const char *report);
+void profile_timedemo_end();
+/* Log the spread of the time of each phase over the recent frames. */
+void profile_dump();
+void profile_init();
+
+}
@@ -44,6 +44,11 @@ struct window_rendered_data
 	int     rear_view;
 #endif
 	std::vector<objnum_t> rendered_robots;
+	/* A cockpit window drawn after the main view of the same frame.  It
+	 * reuses the dynamic light of the main view and is limited to
+	 * -window_depth segments.
+	 */
+	bool secondary_view = false;
 };
 
 }
@@ -69,6 +74,36 @@ extern int Clear_window;    // 1 = Clear whole background window, 2 = clear view
 namespace dsx {
 void flash_frame();
 
+// Build the potentially visible set for the current mine.  Must be
+// called again whenever the mine geometry changes.
+void render_build_pvs();
+
+// Copy out the set built by render_build_pvs, or replace it with one
+// copied out earlier for the same mine.  render_set_pvs returns false,
+// and leaves no set, if the runs do not fit the current mine.
+void render_get_pvs(std::vector<uint16_t> &runs, std::vector<uint32_t> &offsets);
+bool render_set_pvs(std::vector<uint16_t> &&runs, std::vector<uint32_t> &&offsets);
+
+// False only if no point of segment to, nor of any segment adjoining it,
+// can be seen from segment from, so an object which sticks out of to
+// cannot be seen either.  True if there is no set for the current mine.
+bool render_pvs_may_see(vcsegptridx_t from, vcsegptridx_t to);
+
+// Compute the bounding sphere of every segment, used to skip segments
+// outside the view, and the compact copy of each segment's links, used
+// to walk the mine.  Must be called again whenever the mine geometry
+// changes.
+void render_build_segment_tables();
+
+struct render_object_stats
+{
+	unsigned drawn, culled;
+};
+
+// The objects of the last main view drawn, and how many of them were
+// not drawn because they were outside the view.
+render_object_stats render_get_object_stats();
+
 }
 #endif
 int find_seg_side_face(short x,short y,segnum_t &seg,objnum_t &obj,int &side,int &face);
@@ -1,11 +1,11 @@
 #pragma once
 
-#include <unordered_map>
-#include <vector>
 #include "dxxsconf.h"
 #include "fwd-segment.h"
+#include "fwd-object.h"
 #include "compiler-array.h"
 #include "objnum.h"
+#include "partial_range.h"
 
 constexpr std::integral_constant<unsigned, 500> MAX_RENDER_SEGS{};
 
@@ -14,31 +14,43 @@ struct rect
 	short left,top,right,bot;
 };
 
+/* All of this is fixed size and is filled in again for each view, so
+ * rendering a frame does not allocate.
+ */
 struct render_state_t
 {
+	struct distant_object
+	{
+		objnum_t objnum;
+		/* The object does not cross any side of the segment it is drawn
+		 * with, so it can only be seen through that segment's window.
+		 */
+		bool inside_segment;
+	};
 	struct per_segment_state_t
 	{
-		struct distant_object
-		{
-			objnum_t objnum;
-		};
-		std::vector<distant_object> objects;
 		uint16_t Seg_depth;		//depth for this seg in Render_list
 		bool processed;		//whether this entry has been processed
+		uint16_t first_object;	//this segment's objects in render_state_t::objects
+		uint16_t num_objects;
 		rect render_window;
-		per_segment_state_t() :
-			Seg_depth(0), processed(false)
-		{
-		}
 	};
 	unsigned N_render_segs;
 	array<segnum_t, MAX_RENDER_SEGS> Render_list;
 	array<short, MAX_SEGMENTS> render_pos;	//where in render_list does this segment appear?
-	std::unordered_map<segnum_t, per_segment_state_t> render_seg_map;
+	array<per_segment_state_t, MAX_RENDER_SEGS> render_seg_state;	//indexed by position in Render_list
+	array<distant_object, MAX_OBJECTS> objects;	//objects of all segments, grouped by segment
 	render_state_t() :
 		N_render_segs(0)
 	{
 	}
+	per_segment_state_t &segment_state(const segnum_t segnum)
+	{
+		return render_seg_state[render_pos[segnum]];
+	}
+	auto segment_objects(const per_segment_state_t &s)
+	{
+		const unsigned first = s.first_object;
+		return partial_range(objects, first, first + s.num_objects);
+	}
 };
-
-void set_dynamic_light(render_state_t &);
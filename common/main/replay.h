@@ -0,0 +1,41 @@
+/*
+ * This file is part of the DXX-Rebirth project <https://www.dxx-rebirth.com/>.
+ * It is copyright by its individual contributors, as recorded in the
+ * project's Git history.  See COPYING.txt at the top level for license
+ * terms and a link to the Git history.
+ */
+/*
+ *
+ * Recorded input streams, replayed to check that two builds or two
+ * sets of options simulate the same game
+ *
+ */
+
+#pragma once
+
+#include "dsx-ns.h"
+
+#ifdef dsx
+namespace dsx {
+
+// True while -replay_record records or a replay plays back.  Weapon
+// selection then happens once per frame, after replay_frame_begin,
+// instead of as each event arrives, so that it is part of the frame's
+// recorded controls.
+bool replay_active();
+// True while a replay plays back, and the controls come from it.
+bool replay_playing();
+// Restore the starting state of the -replay or -replay_check stream.
+// Returns false if there is none or it cannot be read.
+bool replay_start();
+// Called at the start of each simulated frame.  Records the frame's
+// time and controls, or hashes the objects as the previous frame left
+// them and replays the next frame's time and controls.  Returns true
+// when the stream has ended, or diverged from the reference, and the
+// game should close.
+bool replay_frame_begin();
+// Called when the game window closes.  Reports the result of a check.
+void replay_stop();
+
+}
+#endif
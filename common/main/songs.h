@@ -52,6 +52,7 @@ int songs_play_file(const char *filename, int repeat, void (*hook_finished_track
 namespace dsx {
 int songs_play_song( int songnum, int repeat );
 int songs_play_level_song( int levelnum, int offset );
+void songs_prefetch_level_song(int levelnum);
 
 //stop any songs - midi, redbook or jukebox - that are currently playing
 }
@@ -66,6 +66,9 @@ enum class secret_restore
 
 namespace dcx {
 
+// Wait until any savegame still being written is on disk.
+void state_wait_for_writes();
+
 enum class blind_save
 {
 	no,
@@ -77,6 +80,11 @@ enum class blind_save
 #ifdef dsx
 namespace dsx {
 int state_save_all_sub(const char *filename, const char *desc);
+// Take a snapshot for -rewind if one is due.
+void state_rewind_frame();
+// Restore the newest snapshot, or if older, discard it and restore the
+// one before it.
+void state_rewind_restore(bool older);
 
 int state_get_save_file(char *fname, char * dsc, blind_save);
 int state_get_restore_file(char *fname, blind_save);
@@ -32,4 +32,6 @@ COPYRIGHT 1993-1999 PARALLAX SOFTWARE CORPORATION.  ALL RIGHTS RESERVED.
 void free_light_table();
 void free_height_array();
 void load_terrain(const char *filename);
+//use the height map loaded last, when the next level names the same file
+void reuse_terrain();
 void render_terrain(grs_canvas &, const vms_vector &Viewer_eye, const vms_vector &org, int org_i, int org_j);
@@ -31,10 +31,23 @@ COPYRIGHT 1993-1999 PARALLAX SOFTWARE CORPORATION.  ALL RIGHTS RESERVED.
 
 struct grs_bitmap;
 
+struct texmerge_stats
+{
+	unsigned hits, misses, capacity;
+};
+
 int texmerge_init();
 grs_bitmap &texmerge_get_cached_bitmap(unsigned tmap_bottom, unsigned tmap_top);
 void texmerge_close();
 void texmerge_flush();
+/* Lookups since startup or the last "texmerge reset" command. */
+texmerge_stats texmerge_get_stats();
+/* Keep up to capacity merged textures, from 1 to
+ * texmerge_max_capacity.  This empties the cache.
+ */
+constexpr unsigned texmerge_max_capacity = 1024;
+void texmerge_set_capacity(unsigned capacity);
+void texmerge_reserve(unsigned count);
 
 #endif
 
@@ -29,6 +29,7 @@ COPYRIGHT 1993-1999 PARALLAX SOFTWARE CORPORATION.  ALL RIGHTS RESERVED.
 #include "fwd-segment.h"
 #include "fwd-wall.h"
 #include "fwd-object.h"
+#include "segment.h"
 #include "pack.h"
 #include "switch.h"
 
@@ -164,6 +165,22 @@ struct wall : public prohibit_void_ptr<wall>
 #endif
 };
 
+/* Most sides have no wall, so answer those here and only call out of
+ * line for the sides which need the wall examined.
+ */
+static inline WALL_IS_DOORWAY_result_t WALL_IS_DOORWAY(const GameBitmaps_array &GameBitmaps, const Textures_array &Textures, fvcwallptr &vcwallptr, const shared_segment &sseg, const unique_segment &useg, const uint_fast32_t side)
+{
+	const auto child = sseg.children[side];
+	if (unlikely(child == segment_none))
+		return WID_WALL;
+	if (unlikely(child == segment_exit))
+		return WID_EXTERNAL;
+	auto &sside = sseg.sides[side];
+	if (likely(sside.wall_num == wall_none))
+		return WID_NO_WALL;
+	return wall_is_doorway(GameBitmaps, Textures, vcwallptr, sside, useg.sides[side]);
+}
+
 }
 
 namespace dcx {
@@ -38,13 +38,6 @@ public:
 
 }
 
-fix64 fixmul64(fix a, fix b)
-{
-	const fix64 a64 = a;
-	const fix64 b64 = b;
-	return (a64 * b64) / 65536;
-}
-
 fix fixdiv(fix a, fix b)
 {
 	if (!b)
@@ -519,6 +519,24 @@ void vm_vec_rotate(vms_vector &dest,const vms_vector &src,const vms_matrix &m)
 	dest.z = vm_vec_dot(src,m.fvec);
 }
 
+//rotates n vectors through a matrix, with the same results as calling
+//vm_vec_rotate on each.  The matrix is loaded once, so the compiler can
+//keep it in registers and vectorize the loop.
+//dest CANNOT overlap src
+void vm_vec_rotate_n(vms_vector *dest, const vms_vector *src, const std::size_t n, const vms_matrix &m)
+{
+	const int64_t rx = m.rvec.x, ry = m.rvec.y, rz = m.rvec.z;
+	const int64_t ux = m.uvec.x, uy = m.uvec.y, uz = m.uvec.z;
+	const int64_t fx = m.fvec.x, fy = m.fvec.y, fz = m.fvec.z;
+	for (const auto end = src + n; src != end; ++src, ++dest)
+	{
+		const int64_t x = src->x, y = src->y, z = src->z;
+		dest->x = (x * rx + y * ry + z * rz) >> 16;
+		dest->y = (x * ux + y * uy + z * uz) >> 16;
+		dest->z = (x * fx + y * fy + z * fz) >> 16;
+	}
+}
+
 //mulitply 2 matrices, fill in dest.  returns ptr to dest
 //dest CANNOT equal either source
 void _vm_matrix_x_matrix(vms_matrix &dest,const vms_matrix &src0,const vms_matrix &src1)
@@ -0,0 +1,87 @@
+/*
+ * This file is part of the DXX-Rebirth project <https://www.dxx-rebirth.com/>.
+ * It is copyright by its individual contributors, as recorded in the
+ * project's Git history.  See COPYING.txt at the top level for license
+ * terms and a link to the Git history.
+ */
+
+/*
+ *
+ * Scratch memory of the drawing functions
+ *
+ */
+
+#include <algorithm>
+#include "frame_alloc.h"
+#include "console.h"
+
+namespace dcx {
+
+namespace {
+
+/* Enough for the vertex, color, and texture coordinate arrays of the
+ * largest polygons the game draws.
+ */
+constexpr std::size_t frame_alloc_initial_size = 16 * 1024;
+
+struct frame_alloc_state
+{
+	std::unique_ptr<uint8_t[]> buffer;
+	std::size_t size;
+	std::size_t used;
+	/* Most bytes any frame asked for, including those taken from the
+	 * heap.
+	 */
+	std::size_t wanted;
+	unsigned heap_allocations;
+};
+
+}
+
+static frame_alloc_state frame_alloc;
+
+frame_alloc_scope::frame_alloc_scope() :
+	mark(frame_alloc.used)
+{
+}
+
+frame_alloc_scope::~frame_alloc_scope()
+{
+	frame_alloc.used = mark;
+}
+
+void *frame_alloc_scope::allocate_bytes(const std::size_t bytes, const std::size_t alignment)
+{
+	auto &f = frame_alloc;
+	const auto base = reinterpret_cast<uintptr_t>(f.buffer.get());
+	const auto start = ((base + f.used + alignment - 1) & ~(alignment - 1)) - base;
+	f.wanted = std::max(f.wanted, start + bytes);
+	if (f.buffer && start <= f.size && f.size - start >= bytes)
+	{
+		f.used = start + bytes;
+		return f.buffer.get() + start;
+	}
+	++f.heap_allocations;
+	overflow.emplace_back(new uint8_t[bytes]);
+	return overflow.back().get();
+}
+
+void frame_alloc_start_frame()
+{
+	auto &f = frame_alloc;
+	/* A scope is still open, so the buffer cannot move. */
+	if (f.used)
+		return;
+	if (f.buffer && f.size >= f.wanted)
+		return;
+	f.size = std::max(frame_alloc_initial_size, f.wanted + f.wanted / 2);
+	f.buffer.reset(new uint8_t[f.size]);
+	con_printf(CON_DEBUG, "frame allocator: grew to %zu bytes after %u heap allocations", f.size, f.heap_allocations);
+}
+
+unsigned frame_alloc_heap_allocations()
+{
+	return frame_alloc.heap_allocations;
+}
+
+}
@@ -0,0 +1,106 @@
+/*
+ * This file is part of the DXX-Rebirth project <https://www.dxx-rebirth.com/>.
+ * It is copyright by its individual contributors, as recorded in the
+ * project's Git history.  See COPYING.txt at the top level for license
+ * terms and a link to the Git history.
+ */
+
+/*
+ *
+ * Arena of tables which last for one level
+ *
+ */
+
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include "level_arena.h"
+#include "console.h"
+#include "u_mem.h"
+
+namespace dcx {
+
+namespace {
+
+/* Large enough for the tables of a typical level to fit in a few
+ * chunks.
+ */
+constexpr std::size_t level_arena_chunk_size = 256 * 1024;
+
+struct level_arena_chunk
+{
+	std::unique_ptr<uint8_t[]> data;
+	std::size_t size;
+};
+
+struct level_arena_state
+{
+	std::vector<level_arena_chunk> chunks;
+	/* The chunk allocations are taken from, and the offset of its
+	 * first free byte.
+	 */
+	std::size_t current;
+	std::size_t offset;
+	std::size_t used;
+	std::size_t level_high_water;
+	std::size_t high_water;
+	unsigned generation;
+};
+
+}
+
+static level_arena_state level_arena;
+
+static void *level_arena_take(level_arena_chunk &c, std::size_t &offset, const std::size_t bytes, const std::size_t alignment)
+{
+	const auto base = reinterpret_cast<uintptr_t>(c.data.get());
+	const auto start = ((base + offset + alignment - 1) & ~(alignment - 1)) - base;
+	if (start > c.size || c.size - start < bytes)
+		return nullptr;
+	offset = start + bytes;
+	return c.data.get() + start;
+}
+
+void *level_arena_allocate(const std::size_t bytes, const std::size_t alignment)
+{
+	auto &a = level_arena;
+	a.used += bytes;
+	a.level_high_water = std::max(a.level_high_water, a.used);
+	a.high_water = std::max(a.high_water, a.used);
+	/* Chunks kept from earlier levels are used in order.  The tail of a
+	 * chunk too small for a request is skipped until the next release.
+	 */
+	for (; a.current < a.chunks.size(); ++a.current, a.offset = 0)
+		if (const auto p = level_arena_take(a.chunks[a.current], a.offset, bytes, alignment))
+			return p;
+	const auto size = std::max(level_arena_chunk_size, bytes + alignment);
+	a.chunks.push_back({std::unique_ptr<uint8_t[]>(new uint8_t[size]), size});
+	mem_account(mem_tag::level, 0, size);
+	a.current = a.chunks.size() - 1;
+	a.offset = 0;
+	return level_arena_take(a.chunks.back(), a.offset, bytes, alignment);
+}
+
+void level_arena_release()
+{
+	auto &a = level_arena;
+	if (a.level_high_water)
+		con_printf(CON_VERBOSE, "level arena: %zu KiB used at most by the last level, in %zu chunks", a.level_high_water / 1024, a.chunks.size());
+	++a.generation;
+	a.current = 0;
+	a.offset = 0;
+	a.used = 0;
+	a.level_high_water = 0;
+}
+
+unsigned level_arena_generation()
+{
+	return level_arena.generation;
+}
+
+std::size_t level_arena_high_water()
+{
+	return level_arena.high_water;
+}
+
+}
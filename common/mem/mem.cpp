@@ -32,6 +32,11 @@ COPYRIGHT 1993-1999 PARALLAX SOFTWARE CORPORATION.  ALL RIGHTS RESERVED.
 #include "args.h"
 #include "console.h"
 #include "u_mem.h"
+#include "level_arena.h"
+#include "frame_alloc.h"
+#include "cmd.h"
+#include "physfsx.h"
+#include "strutil.h"
 
 #include "compiler-array.h"
 
@@ -395,4 +400,91 @@ void mem_validate_heap()
 #endif
 #endif
 
+namespace {
+
+struct mem_tag_stats
+{
+	std::size_t current;
+	std::size_t peak;
+	/* Number of buffers currently held */
+	unsigned count;
+};
+
+}
+
+static array<mem_tag_stats, mem_tag_count> mem_account_stats;
+
+static const array<const char *, mem_tag_count> mem_tag_names{{
+	"textures",
+	"gl_textures",
+	"sounds",
+	"models",
+	"level",
+}};
+
+void mem_account(const mem_tag tag, const std::size_t old_bytes, const std::size_t new_bytes)
+{
+	auto &s = mem_account_stats[static_cast<unsigned>(tag)];
+	if (old_bytes)
+		--s.count;
+	if (new_bytes)
+		++s.count;
+	s.current += new_bytes - old_bytes;
+	if (s.peak < s.current)
+		s.peak = s.current;
+}
+
+static void mem_account_dump(const char *const filename)
+{
+	if (!filename)
+	{
+		std::size_t current = 0;
+		for (unsigned i = 0; i != mem_tag_count; ++i)
+		{
+			const auto &s = mem_account_stats[i];
+			con_printf(CON_NORMAL, "memstat: %-12s %8zu KiB now, %8zu KiB peak, %6u buffers", mem_tag_names[i], s.current / 1024, s.peak / 1024, s.count);
+			current += s.current;
+		}
+		con_printf(CON_NORMAL, "memstat: %-12s %8zu KiB now", "total", current / 1024);
+		con_printf(CON_NORMAL, "memstat: level arena used at most %zu KiB", level_arena_high_water() / 1024);
+		con_printf(CON_NORMAL, "memstat: drawing scratch fell back to the heap %u times", frame_alloc_heap_allocations());
+		return;
+	}
+	RAIIPHYSFS_File file{PHYSFSX_openWriteBuffered(filename)};
+	if (!file)
+	{
+		con_printf(CON_URGENT, "memstat: failed to open \"%s\": %s", filename, PHYSFS_getLastError());
+		return;
+	}
+	PHYSFSX_puts_literal(file, "{");
+	for (unsigned i = 0; i != mem_tag_count; ++i)
+	{
+		const auto &s = mem_account_stats[i];
+		PHYSFSX_printf(file, "%s\n\t\"%s\": {\"current\": %zu, \"peak\": %zu, \"count\": %u}", i ? "," : "", mem_tag_names[i], s.current, s.peak, s.count);
+	}
+	PHYSFSX_printf(file, ",\n\t\"level_arena_high_water\": %zu,\n\t\"frame_alloc_heap_allocations\": %u\n}\n", level_arena_high_water(), frame_alloc_heap_allocations());
+}
+
+static void mem_account_cmd(unsigned long argc, const char *const *const argv)
+{
+	if ((argc == 2 || argc == 3) && !d_stricmp(argv[1], "dump"))
+	{
+		mem_account_dump(argc == 3 ? argv[2] : nullptr);
+		return;
+	}
+	if (argc == 2 && !d_stricmp(argv[1], "reset"))
+	{
+		for (auto &s : mem_account_stats)
+			s.peak = s.current;
+		return;
+	}
+	cmd_insertf("help %s", argv[0]);
+}
+
+void mem_account_init()
+{
+	cmd_addcommand("memstat", mem_account_cmd, "memstat dump [file]\n"  "    write the memory held now and at peak by textures, sounds, models, and level tables, and the heap fallbacks of the drawing scratch, to the console or <file>\n"
+	                                           "memstat reset\n"        "    restart the peaks from the current sizes");
+}
+
 }
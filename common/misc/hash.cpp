@@ -24,32 +24,88 @@ COPYRIGHT 1993-1999 PARALLAX SOFTWARE CORPORATION.  ALL RIGHTS RESERVED.
 #include <stdio.h>
 #include <string.h>
 #include "hash.h"
+#include "compiler-range_for.h"
 
 namespace dcx {
 
-bool hashtable::compare_t::operator()(const char *l, const char *r) const
+namespace {
+
+constexpr std::size_t hashtable_min_size = 64;
+
+/* Case-insensitive FNV-1a */
+static uint32_t hashtable_hash(const char *k)
+{
+	uint32_t h = 2166136261u;
+	for (; *k; ++k)
+		h = (h ^ static_cast<uint8_t>(tolower(static_cast<unsigned char>(*k)))) * 16777619u;
+	return h;
+}
+
+static bool hashtable_equal(const char *l, const char *r)
 {
 	for (;; ++l, ++r)
 	{
-		uint_fast32_t ll = tolower(static_cast<unsigned>(*l)), lr = tolower(static_cast<unsigned>(*r));
-		if (ll < lr)
-			return true;
-		if (lr < ll || !ll)
+		const unsigned ll = tolower(static_cast<unsigned char>(*l)), lr = tolower(static_cast<unsigned char>(*r));
+		if (ll != lr)
 			return false;
+		if (!ll)
+			return true;
+	}
+}
+
+/* Returns the entry holding key, or the empty entry where it belongs. */
+static hashtable::entry &hashtable_probe(std::vector<hashtable::entry> &table, const uint32_t hash, const char *const key)
+{
+	const std::size_t mask = table.size() - 1;
+	for (std::size_t i = hash & mask;; i = (i + 1) & mask)
+	{
+		auto &e = table[i];
+		if (!e.key || (e.hash == hash && hashtable_equal(e.key, key)))
+			return e;
 	}
 }
 
+static void hashtable_place(hashtable &ht, const uint32_t hash, const char *const key, const int value)
+{
+	auto &e = hashtable_probe(ht.table, hash, key);
+	if (e.key)
+		return;
+	e = {hash, value, key};
+	++ht.count;
+}
+
+static void hashtable_resize(hashtable &ht, const std::size_t size, const bool rehash)
+{
+	std::vector<hashtable::entry> old(size);
+	old.swap(ht.table);
+	ht.count = 0;
+	range_for (auto &e, old)
+		if (e.key)
+			hashtable_place(ht, rehash ? hashtable_hash(e.key) : e.hash, e.key, e.value);
+}
+
+}
+
 int hashtable_search(hashtable *ht, const char *key)
 {
-	auto i = ht->m.find(key);
-	if (i != ht->m.end())
-		return i->second;
-	return -1;
+	if (!ht->count)
+		return -1;
+	auto &e = hashtable_probe(ht->table, hashtable_hash(key), key);
+	return e.key ? e.value : -1;
 }
 
 void hashtable_insert(hashtable *ht, const char *key, int value)
 {
-	ht->m.insert(std::make_pair(key, value));
+	/* Keep the table at most half full, so probe chains stay short. */
+	if ((ht->count + 1) * 2 > ht->table.size())
+		hashtable_resize(*ht, ht->table.empty() ? hashtable_min_size : ht->table.size() * 2, false);
+	hashtable_place(*ht, hashtable_hash(key), key, value);
+}
+
+void hashtable_rehash(hashtable *ht)
+{
+	if (ht->count)
+		hashtable_resize(*ht, ht->table.size(), true);
 }
 
 }
@@ -11,7 +11,9 @@
  * - Convert HMP to MIDI for further use
  * Based on work of Arne de Bruijn and the JFFEE project
  */
+#include <map>
 #include <stdexcept>
+#include <string>
 #include <string.h>
 #include <stdlib.h>
 #include <stdio.h>
@@ -21,6 +23,7 @@
 #include "console.h"
 #include "timer.h"
 #include "serial.h"
+#include <SDL.h>
 
 #include "dxxsconf.h"
 #include "dsx-ns.h"
@@ -699,7 +702,7 @@ struct midhdr
 
 DEFINE_SERIAL_CONST_UDT_TO_MESSAGE(midhdr, m, (magic_header, m.num_trks, m.time_div, tempo));
 
-void hmp2mid(const char *hmp_name, std::vector<uint8_t> &midbuf)
+static void hmp2mid_convert(const char *hmp_name, std::vector<uint8_t> &midbuf)
 {
 	std::unique_ptr<hmp_file> hmp = hmp_open(hmp_name);
 	if (!hmp)
@@ -724,4 +727,95 @@ void hmp2mid(const char *hmp_name, std::vector<uint8_t> &midbuf)
 	}
 }
 
+namespace {
+
+struct hmp2mid_prefetch_state
+{
+	SDL_Thread *thread;
+	std::string key;
+	std::string name;
+	std::vector<uint8_t> midi;
+};
+
+}
+
+/* Songs already converted, by hmp2mid_key.  Only the game thread uses
+ * the cache; a prefetched song is added when its thread is joined.
+ */
+static std::map<std::string, std::vector<uint8_t>> hmp2mid_cache;
+static hmp2mid_prefetch_state hmp2mid_prefetch_pending;
+
+/* The directory or archive which provides the song is part of the key,
+ * so that a mission which replaces a song does not get the cached copy
+ * of the original.
+ */
+static std::string hmp2mid_key(const char *const hmp_name)
+{
+	const auto dir = PHYSFS_getRealDir(hmp_name);
+	std::string key(dir ? dir : "");
+	key += '\0';
+	key += hmp_name;
+	return key;
+}
+
+static int hmp2mid_prefetch_thread(void *)
+{
+	auto &p = hmp2mid_prefetch_pending;
+	try
+	{
+		hmp2mid_convert(p.name.c_str(), p.midi);
+	}
+	catch (const std::exception &)
+	{
+		/* Leave the song out of the cache, so that playing it reports
+		 * the error as before.
+		 */
+		p.midi.clear();
+	}
+	return 0;
+}
+
+static void hmp2mid_join()
+{
+	auto &p = hmp2mid_prefetch_pending;
+	if (!p.thread)
+		return;
+	SDL_WaitThread(p.thread, nullptr);
+	p.thread = nullptr;
+	if (!p.midi.empty())
+		hmp2mid_cache.emplace(std::move(p.key), std::move(p.midi));
+	p.midi = {};
+}
+
+void hmp2mid(const char *hmp_name, std::vector<uint8_t> &midbuf)
+{
+	hmp2mid_join();
+	auto key = hmp2mid_key(hmp_name);
+	const auto i = hmp2mid_cache.find(key);
+	if (i != hmp2mid_cache.end())
+	{
+		midbuf = i->second;
+		return;
+	}
+	hmp2mid_convert(hmp_name, midbuf);
+	if (!midbuf.empty())
+		hmp2mid_cache.emplace(std::move(key), midbuf);
+}
+
+void hmp2mid_prefetch(const char *const hmp_name)
+{
+	hmp2mid_join();
+	auto key = hmp2mid_key(hmp_name);
+	if (hmp2mid_cache.count(key))
+		return;
+	auto &p = hmp2mid_prefetch_pending;
+	p.key = std::move(key);
+	p.name = hmp_name;
+#if SDL_MAJOR_VERSION == 2
+	p.thread = SDL_CreateThread(hmp2mid_prefetch_thread, "hmp2mid", nullptr);
+#else
+	p.thread = SDL_CreateThread(hmp2mid_prefetch_thread, nullptr);
+#endif
+}
+
 }
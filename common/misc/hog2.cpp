@@ -0,0 +1,372 @@
+/*
+ * This file is part of the DXX-Rebirth project <https://www.dxx-rebirth.com/>.
+ * It is copyright by its individual contributors, as recorded in the
+ * project's Git history.  See COPYING.txt at the top level for license
+ * terms and a link to the Git history.
+ */
+/*
+ *
+ * PhysFS archiver for the indexed HOG format
+ *
+ */
+
+#include <algorithm>
+#include <cctype>
+#include <memory>
+#include <vector>
+#include <physfs.h>
+#include "hog2.h"
+#include "console.h"
+
+#if DXX_USE_ZLIB
+#include <zlib.h>
+#endif
+
+#include "compiler-make_unique.h"
+#include "compiler-range_for.h"
+
+namespace dcx {
+
+int hog2_compare_name(const char *a, const char *b)
+{
+	for (;; ++a, ++b)
+	{
+		const int ua = toupper(static_cast<unsigned char>(*a));
+		const int ub = toupper(static_cast<unsigned char>(*b));
+		if (ua != ub)
+			return ua < ub ? -1 : 1;
+		if (!ua)
+			return 0;
+	}
+}
+
+#if PHYSFS_VER_MAJOR >= 3
+/* PHYSFS_registerArchiver first appeared in PhysFS 3.0.  Older
+ * versions can only mount classic HOGs.
+ */
+
+namespace {
+
+struct hog2_archive
+{
+	PHYSFS_Io *const io;
+	std::vector<hog2_entry> entries;
+	explicit hog2_archive(PHYSFS_Io *const io) :
+		io(io)
+	{
+	}
+	~hog2_archive()
+	{
+		io->destroy(io);
+	}
+	hog2_archive(const hog2_archive &) = delete;
+	hog2_archive &operator=(const hog2_archive &) = delete;
+	const hog2_entry *find(const char *const name) const
+	{
+		const auto e = entries.end();
+		const auto i = std::lower_bound(entries.begin(), e, name, [](const hog2_entry &entry, const char *const n) {
+			return hog2_compare_name(entry.name.data(), n) < 0;
+		});
+		return i != e && !hog2_compare_name(i->name.data(), name) ? &*i : nullptr;
+	}
+};
+
+/* An open member.  A stored member reads from its own duplicate of the
+ * archive's PHYSFS_Io.  A compressed member is inflated when opened, and
+ * its duplicates share the inflated data.
+ */
+struct hog2_member
+{
+	PHYSFS_Io io;
+	PHYSFS_Io *const source;
+	const std::shared_ptr<const std::vector<uint8_t>> inflated;
+	const uint64_t start, size;
+	uint64_t position = 0;
+	hog2_member(PHYSFS_Io *source, uint64_t start, uint64_t size);
+	hog2_member(std::shared_ptr<const std::vector<uint8_t>> inflated);
+	~hog2_member()
+	{
+		if (source)
+			source->destroy(source);
+	}
+	hog2_member(const hog2_member &) = delete;
+	hog2_member &operator=(const hog2_member &) = delete;
+	static hog2_member &get(PHYSFS_Io *const io)
+	{
+		return *static_cast<hog2_member *>(io->opaque);
+	}
+	static PHYSFS_sint64 read(PHYSFS_Io *, void *, PHYSFS_uint64);
+	static PHYSFS_sint64 write(PHYSFS_Io *, const void *, PHYSFS_uint64)
+	{
+		PHYSFS_setErrorCode(PHYSFS_ERR_READ_ONLY);
+		return -1;
+	}
+	static int seek(PHYSFS_Io *const io, const PHYSFS_uint64 offset)
+	{
+		auto &m = get(io);
+		if (offset > m.size)
+		{
+			PHYSFS_setErrorCode(PHYSFS_ERR_PAST_EOF);
+			return 0;
+		}
+		m.position = offset;
+		return 1;
+	}
+	static PHYSFS_sint64 tell(PHYSFS_Io *const io)
+	{
+		return get(io).position;
+	}
+	static PHYSFS_sint64 length(PHYSFS_Io *const io)
+	{
+		return get(io).size;
+	}
+	static PHYSFS_Io *duplicate(PHYSFS_Io *);
+	static int flush(PHYSFS_Io *)
+	{
+		return 1;
+	}
+	static void destroy(PHYSFS_Io *const io)
+	{
+		delete &get(io);
+	}
+};
+
+hog2_member::hog2_member(PHYSFS_Io *const source, const uint64_t start, const uint64_t size) :
+	io{0, this, read, write, seek, tell, length, duplicate, flush, destroy},
+	source(source), start(start), size(size)
+{
+}
+
+hog2_member::hog2_member(std::shared_ptr<const std::vector<uint8_t>> i) :
+	io{0, this, read, write, seek, tell, length, duplicate, flush, destroy},
+	source(nullptr), inflated(std::move(i)), start(0), size(inflated->size())
+{
+}
+
+PHYSFS_sint64 hog2_member::read(PHYSFS_Io *const io, void *const buf, const PHYSFS_uint64 len)
+{
+	auto &m = get(io);
+	const auto n = std::min<uint64_t>(len, m.size - m.position);
+	if (!n)
+		return 0;
+	if (m.inflated)
+		memcpy(buf, m.inflated->data() + m.position, n);
+	else
+	{
+		const auto source = m.source;
+		if (!source->seek(source, m.start + m.position))
+			return -1;
+		const auto r = source->read(source, buf, n);
+		if (r <= 0)
+			return r;
+		m.position += r;
+		return r;
+	}
+	m.position += n;
+	return n;
+}
+
+PHYSFS_Io *hog2_member::duplicate(PHYSFS_Io *const io)
+{
+	auto &m = get(io);
+	std::unique_ptr<hog2_member> d;
+	if (m.inflated)
+		d = make_unique<hog2_member>(m.inflated);
+	else
+	{
+		const auto source = m.source->duplicate(m.source);
+		if (!source)
+			return nullptr;
+		d = make_unique<hog2_member>(source, m.start, m.size);
+	}
+	return &d.release()->io;
+}
+
+static bool hog2_read_exact(PHYSFS_Io *const io, void *const buf, const uint64_t len)
+{
+	return io->read(io, buf, len) == static_cast<PHYSFS_sint64>(len);
+}
+
+static void *hog2_open_archive(PHYSFS_Io *const io, const char *const name, const int forWrite, int *const claimed)
+{
+	array<uint8_t, hog2_header_size> raw_header;
+	if (!hog2_read_exact(io, raw_header.data(), raw_header.size()) || memcmp(raw_header.data(), hog2_signature.data(), hog2_signature.size()))
+	{
+		PHYSFS_setErrorCode(PHYSFS_ERR_UNSUPPORTED);
+		return nullptr;
+	}
+	*claimed = 1;
+	if (forWrite)
+	{
+		PHYSFS_setErrorCode(PHYSFS_ERR_READ_ONLY);
+		return nullptr;
+	}
+	hog2_header header;
+	if (!hog2_parse_header(raw_header.data(), header))
+	{
+		con_printf(CON_URGENT, "HOG: \"%s\" is an indexed HOG of an unknown version", name);
+		PHYSFS_setErrorCode(PHYSFS_ERR_UNSUPPORTED);
+		return nullptr;
+	}
+	const auto signed_length = io->length(io);
+	const uint64_t file_length = signed_length;
+	if (signed_length < 0 || header.count > (file_length - hog2_header_size) / hog2_entry_size)
+	{
+		PHYSFS_setErrorCode(PHYSFS_ERR_CORRUPT);
+		return nullptr;
+	}
+	std::vector<uint8_t> raw_directory(header.count * hog2_entry_size);
+	if (!hog2_read_exact(io, raw_directory.data(), raw_directory.size()))
+		return nullptr;
+	std::vector<hog2_entry> entries(header.count);
+	for (uint32_t i = 0; i != header.count; ++i)
+	{
+		auto &e = entries[i];
+		hog2_parse_entry(&raw_directory[i * hog2_entry_size], e);
+		/* A bad directory would make lookups miss, or reads stray
+		 * outside the member, so refuse the whole archive.
+		 */
+		if (e.offset > file_length || e.stored_size > file_length - e.offset ||
+			(i && hog2_compare_name(entries[i - 1].name.data(), e.name.data()) >= 0) ||
+			(e.method == hog2_method::stored ? e.stored_size != e.size : e.method != hog2_method::deflate))
+		{
+			con_printf(CON_URGENT, "HOG: \"%s\" has a bad directory entry for \"%s\"", name, e.name.data());
+			PHYSFS_setErrorCode(PHYSFS_ERR_CORRUPT);
+			return nullptr;
+		}
+	}
+	/* The archive owns io only once this succeeds. */
+	const auto a = new hog2_archive(io);
+	a->entries = std::move(entries);
+	return a;
+}
+
+static PHYSFS_EnumerateCallbackResult hog2_enumerate(void *const opaque, const char *const dirname, const PHYSFS_EnumerateCallback cb, const char *const origdir, void *const callbackdata)
+{
+	/* Indexed HOGs, like classic ones, have no subdirectories. */
+	if (*dirname)
+		return PHYSFS_ENUM_OK;
+	range_for (auto &e, static_cast<const hog2_archive *>(opaque)->entries)
+	{
+		const auto r = cb(callbackdata, origdir, e.name.data());
+		if (r == PHYSFS_ENUM_ERROR)
+			PHYSFS_setErrorCode(PHYSFS_ERR_APP_CALLBACK);
+		if (r != PHYSFS_ENUM_OK)
+			return r;
+	}
+	return PHYSFS_ENUM_OK;
+}
+
+static PHYSFS_Io *hog2_open_read(void *const opaque, const char *const name)
+{
+	auto &a = *static_cast<const hog2_archive *>(opaque);
+	const auto e = a.find(name);
+	if (!e)
+	{
+		PHYSFS_setErrorCode(PHYSFS_ERR_NOT_FOUND);
+		return nullptr;
+	}
+	const auto io = a.io;
+	if (e->method == hog2_method::stored)
+	{
+		const auto source = io->duplicate(io);
+		if (!source)
+			return nullptr;
+		return &(new hog2_member(source, e->offset, e->size))->io;
+	}
+#if DXX_USE_ZLIB
+	std::vector<uint8_t> compressed(e->stored_size);
+	if (!io->seek(io, e->offset) || !hog2_read_exact(io, compressed.data(), compressed.size()))
+		return nullptr;
+	auto inflated = std::make_shared<std::vector<uint8_t>>(e->size);
+	uLongf inflated_size = e->size;
+	if (uncompress(inflated->data(), &inflated_size, compressed.data(), compressed.size()) != Z_OK || inflated_size != e->size)
+	{
+		con_printf(CON_URGENT, "HOG: member \"%s\" does not inflate to its recorded size", name);
+		PHYSFS_setErrorCode(PHYSFS_ERR_CORRUPT);
+		return nullptr;
+	}
+	return &(new hog2_member(std::move(inflated)))->io;
+#else
+	con_printf(CON_URGENT, "HOG: member \"%s\" is compressed, but this build has no zlib", name);
+	PHYSFS_setErrorCode(PHYSFS_ERR_UNSUPPORTED);
+	return nullptr;
+#endif
+}
+
+static PHYSFS_Io *hog2_open_write(void *, const char *)
+{
+	PHYSFS_setErrorCode(PHYSFS_ERR_READ_ONLY);
+	return nullptr;
+}
+
+static int hog2_modify(void *, const char *)
+{
+	PHYSFS_setErrorCode(PHYSFS_ERR_READ_ONLY);
+	return 0;
+}
+
+static int hog2_stat(void *const opaque, const char *const name, PHYSFS_Stat *const st)
+{
+	st->modtime = st->createtime = st->accesstime = -1;
+	st->readonly = 1;
+	if (!*name)
+	{
+		st->filesize = 0;
+		st->filetype = PHYSFS_FILETYPE_DIRECTORY;
+		return 1;
+	}
+	const auto e = static_cast<const hog2_archive *>(opaque)->find(name);
+	if (!e)
+	{
+		PHYSFS_setErrorCode(PHYSFS_ERR_NOT_FOUND);
+		return 0;
+	}
+	st->filesize = e->size;
+	st->filetype = PHYSFS_FILETYPE_REGULAR;
+	return 1;
+}
+
+static void hog2_close_archive(void *const opaque)
+{
+	delete static_cast<hog2_archive *>(opaque);
+}
+
+const PHYSFS_Archiver hog2_archiver{
+	0,
+	{
+		/* The extension only orders the archivers PhysFS tries.
+		 * Classic HOGs own "HOG", so an indexed HOG named .hog is
+		 * found by its signature.
+		 */
+		"HG2",
+		"Descent indexed HOG format",
+		"DXX-Rebirth",
+		"https://www.dxx-rebirth.com/",
+		0,
+	},
+	hog2_open_archive,
+	hog2_enumerate,
+	hog2_open_read,
+	hog2_open_write,
+	hog2_open_write,
+	hog2_modify,
+	hog2_modify,
+	hog2_stat,
+	hog2_close_archive,
+};
+
+}
+
+void hog2_register_archiver()
+{
+	if (!PHYSFS_registerArchiver(&hog2_archiver))
+		con_printf(CON_URGENT, "PHYSFS: failed to register the indexed HOG archiver: %s", PHYSFS_getLastError());
+}
+#else
+void hog2_register_archiver()
+{
+}
+#endif
+
+}
@@ -10,6 +10,8 @@
 #include <stdlib.h>
 #include <string.h>
 #include <ctype.h>
+#include <string>
+#include <unordered_map>
 
 #include "physfsx.h"
 #include "physfs_list.h"
@@ -38,24 +40,24 @@
 
 namespace dcx {
 
-/* I'm not screwing around with stricmp vs. strcasecmp... */
-static int caseInsensitiveStringCompare(const char *x, const char *y)
-{
-    int ux, uy;
-    do
-    {
-        ux = toupper(static_cast<int>(*x));
-        uy = toupper(static_cast<int>(*y));
-        if (ux != uy)
-            return((ux > uy) ? 1 : -1);
-        x++;
-        y++;
-    } while ((ux) && (uy));
+namespace {
 
-    return(0);
-} /* caseInsensitiveStringCompare */
+/* Keyed by the name folded to upper case, as the comparison did before
+ * the listings were kept.  When several names fold to the same key, the
+ * first one listed wins, as it did then.
+ */
+using case_folded_listing = std::unordered_map<std::string, std::string>;
 
-namespace {
+/* Keyed by the directory, in its correct case, with "" for the root. */
+std::unordered_map<std::string, case_folded_listing> case_cache;
+
+std::string fold_case(const char *s)
+{
+	std::string r(s);
+	for (auto &c : r)
+		c = toupper(static_cast<unsigned char>(c));
+	return r;
+}
 
 class search_result_t : public PHYSFSX_uncounted_list
 {
@@ -76,18 +78,19 @@ static int locateOneElement(char *const sptr, char *const ptr, const char *buf)
     if (const auto r = PHYSFS_exists(buf))
         return r;  /* quick rejection: exists in current case. */
 
-	search_result_t rc{ptr, buf};
-	range_for (const auto i, rc)
-    {
-		if (caseInsensitiveStringCompare(i, sptr) == 0)
-        {
-			strcpy(sptr, i); /* found a match. Overwrite with this case. */
-            return(1);
-        } /* if */
-    } /* for */
-
-    /* no match at all... */
-    return(0);
+	const auto ins = case_cache.emplace(ptr ? std::string(buf, ptr - buf) : std::string(), case_folded_listing());
+	auto &listing = ins.first->second;
+	if (ins.second)
+	{
+		search_result_t rc{ptr, buf};
+		range_for (const auto i, rc)
+			listing.emplace(fold_case(i), i);
+	}
+	const auto i = listing.find(fold_case(sptr));
+	if (i == listing.end())
+		return(0);  /* no match at all... */
+	strcpy(sptr, i->second.c_str()); /* found a match. Overwrite with this case. */
+	return(1);
 } /* locateOneElement */
 
 
@@ -117,6 +120,11 @@ int PHYSFSEXT_locateCorrectCase(char *buf)
     return a() ? 0 : -1;
 } /* PHYSFSEXT_locateCorrectCase */
 
+void PHYSFSEXT_flushCaseCache()
+{
+	case_cache.clear();
+}
+
 }
 
 #ifdef TEST_PHYSFSEXT_LOCATECORRECTCASE
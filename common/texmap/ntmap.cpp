@@ -23,6 +23,8 @@ COPYRIGHT 1993-1998 PARALLAX SOFTWARE CORPORATION.  ALL RIGHTS RESERVED.
  *
  */
 
+#include <algorithm>
+#include <vector>
 #include "pstypes.h"
 #include "maths.h"
 #include "vecmat.h"
@@ -35,10 +37,12 @@ COPYRIGHT 1993-1998 PARALLAX SOFTWARE CORPORATION.  ALL RIGHTS RESERVED.
 #include "rle.h"
 #include "scanline.h"
 #include "u_mem.h"
+#include "jobs.h"
 
 #include "dxxsconf.h"
 #include "dsx-ns.h"
 #include "compiler-integer_sequence.h"
+#include "compiler-range_for.h"
 
 namespace dcx {
 
@@ -54,14 +58,15 @@ unsigned	Current_seg_depth;		// HACK INTERFACE: how far away the current segment
 // These variables are the interface to assembler.  They get set for each texture map, which is a real waste of time.
 //	They should be set only when they change, which is generally when the window bounds change.  And, even still, it's
 //	a pretty bad interface.
-int	bytes_per_row=-1;
-unsigned char *write_buffer;
+//	They are thread_local so that draw_tmap_flush can run the scanline renderers on several threads at once.
+thread_local int	bytes_per_row=-1;
+thread_local unsigned char *write_buffer;
 
-fix fx_l, fx_u, fx_v, fx_z, fx_du_dx, fx_dv_dx, fx_dz_dx, fx_dl_dx;
-int fx_xleft, fx_xright, fx_y;
-const unsigned char *pixptr;
-uint8_t Transparency_on = 0;
-uint8_t tmap_flat_color;
+thread_local fix fx_l, fx_u, fx_v, fx_z, fx_du_dx, fx_dv_dx, fx_dz_dx, fx_dl_dx;
+thread_local int fx_xleft, fx_xright, fx_y;
+thread_local const unsigned char *pixptr;
+thread_local uint8_t Transparency_on = 0;
+thread_local uint8_t tmap_flat_color;
 
 int	Interpolation_method;	// 0 = choose best method
 // -------------------------------------------------------------------------------------
@@ -99,7 +104,7 @@ void init_interface_vars_to_assembler(void)
 	Window_clip_bot = static_cast<int>(bp->bm_h)-1;
 }
 
-static int Lighting_enabled;
+static thread_local int Lighting_enabled;
 // -------------------------------------------------------------------------------------
 //                             VARIABLES
 
@@ -536,7 +541,8 @@ static void ntexture_map_lighted(const grs_bitmap &srcb, const g3ds_tmap &t)
 	// We can get lleft or lright out of bounds here because we compute dl_dy using fixed point values,
 	//	but we plot an integer number of scanlines, therefore doing an integer number of additions of the delta.
 
-	ntmap_scanline_lighted(srcb,boty,xleft,xright,uleft,uright,vleft,vright,zleft,zright,lleft,lright);
+	if (boty >= Window_clip_top)
+		ntmap_scanline_lighted(srcb,boty,xleft,xright,uleft,uright,vleft,vright,zleft,zright,lleft,lright);
 }
 
 
@@ -761,11 +767,13 @@ static void ntexture_map_lighted_linear(const grs_bitmap &srcb, const g3ds_tmap
 		}
 
 		if (Lighting_enabled) {
-			ntmap_scanline_lighted_linear(srcb,y,xleft,xright,uleft,uright,vleft,vright,lleft,lright);
+			if (y >= Window_clip_top)
+				ntmap_scanline_lighted_linear(srcb,y,xleft,xright,uleft,uright,vleft,vright,lleft,lright);
 			lleft += dl_dy_left;
 			lright += dl_dy_right;
 		} else
-			ntmap_scanline_lighted_linear(srcb,y,xleft,xright,uleft,uright,vleft,vright,lleft,lright);
+			if (y >= Window_clip_top)
+				ntmap_scanline_lighted_linear(srcb,y,xleft,xright,uleft,uright,vleft,vright,lleft,lright);
 
 		uleft += du_dy_left;
 		vleft += dv_dy_left;
@@ -781,11 +789,145 @@ static void ntexture_map_lighted_linear(const grs_bitmap &srcb, const g3ds_tmap
 	// We can get lleft or lright out of bounds here because we compute dl_dy using fixed point values,
 	//	but we plot an integer number of scanlines, therefore doing an integer number of additions of the delta.
 
-	ntmap_scanline_lighted_linear(srcb,boty,xleft,xright,uleft,uright,vleft,vright,lleft,lright);
+	if (boty >= Window_clip_top)
+		ntmap_scanline_lighted_linear(srcb,boty,xleft,xright,uleft,uright,vleft,vright,lleft,lright);
 }
 
 // fix	DivNum = F1_0*12;
 
+// -------------------------------------------------------------------------------------
+//	Deferred texture maps, rasterized in horizontal bands by draw_tmap_flush.
+// -------------------------------------------------------------------------------------
+namespace {
+
+struct tmap_batch_command
+{
+	const grs_bitmap *bp;
+	unsigned char *write_buffer;
+	int bytes_per_row;
+	int top, bot;		// rows the texture map covers
+	int clip_left, clip_top, clip_right, clip_bot;
+	uint8_t transparency, lighting, linear;
+	g3ds_tmap tmap;
+};
+
+struct tmap_batch_state
+{
+	bool active;
+	int bot;		// lowest row any command draws to
+	std::vector<tmap_batch_command> commands;
+};
+
+}
+
+static tmap_batch_state tmap_batch;
+
+//	Batches smaller than this are drawn as one band on the calling thread.
+constexpr unsigned tmap_batch_min_parallel = 8;
+
+//	Each band has its own copy of the scanline renderer state, so bands can be drawn at once.  Clipping
+//	every texture map to the band rows keeps each thread's writes inside its own band.
+static void draw_tmap_band(const tmap_batch_state &b, const int band_top, const int band_bot)
+{
+	range_for (auto &c, b.commands)
+	{
+		const auto clip_top = std::max(c.clip_top, band_top);
+		const auto clip_bot = std::min(c.clip_bot, band_bot);
+		if (clip_top > clip_bot || c.top > clip_bot || c.bot < clip_top)
+			continue;
+		write_buffer = c.write_buffer;
+		bytes_per_row = c.bytes_per_row;
+		Window_clip_left = c.clip_left;
+		Window_clip_right = c.clip_right;
+		Window_clip_top = clip_top;
+		Window_clip_bot = clip_bot;
+		Transparency_on = c.transparency;
+		Lighting_enabled = c.lighting;
+		if (c.linear)
+			ntexture_map_lighted_linear(*c.bp, c.tmap);
+		else
+			ntexture_map_lighted(*c.bp, c.tmap);
+	}
+}
+
+void draw_tmap_begin_batch()
+{
+	if (job_pool_threads() > 1)
+		tmap_batch.active = true;
+}
+
+void draw_tmap_flush()
+{
+	auto &b = tmap_batch;
+	if (b.commands.empty())
+		return;
+	//	The calling thread draws bands too, so keep what its own caller set up.
+	const auto save_write_buffer = write_buffer;
+	const auto save_bytes_per_row = bytes_per_row;
+	const auto save_clip_left = Window_clip_left, save_clip_top = Window_clip_top, save_clip_right = Window_clip_right, save_clip_bot = Window_clip_bot;
+	const auto save_transparency = Transparency_on;
+	const auto save_lighting = Lighting_enabled;
+	if (b.commands.size() < tmap_batch_min_parallel)
+		draw_tmap_band(b, 0, b.bot);
+	else
+	{
+		//	About 32 bands, but not so thin that edge setup outweighs the spans.
+		const unsigned rows = std::max(8, (b.bot + 32) / 32);
+		const unsigned bands = (b.bot + rows) / rows;
+		job_pool_run(bands, [&b, rows](const unsigned band, unsigned) {
+			const int band_top = band * rows;
+			draw_tmap_band(b, band_top, std::min(band_top + static_cast<int>(rows) - 1, b.bot));
+		});
+	}
+	b.commands.clear();
+	b.bot = 0;
+	write_buffer = save_write_buffer;
+	bytes_per_row = save_bytes_per_row;
+	Window_clip_left = save_clip_left;
+	Window_clip_top = save_clip_top;
+	Window_clip_right = save_clip_right;
+	Window_clip_bot = save_clip_bot;
+	Transparency_on = save_transparency;
+	Lighting_enabled = save_lighting;
+}
+
+void draw_tmap_end_batch()
+{
+	draw_tmap_flush();
+	tmap_batch.active = false;
+}
+
+static void draw_tmap_record(const grs_bitmap &bp, const g3ds_tmap &t, const bool linear)
+{
+	auto &b = tmap_batch;
+	int top = f2i(t.verts[0].y2d), bot = top;
+	for (int i = 1; i < t.nv; i++)
+	{
+		const auto y = f2i(t.verts[i].y2d);
+		top = std::min(top, y);
+		bot = std::max(bot, y);
+	}
+	if (top > Window_clip_bot || bot < 0)
+		return;
+	b.commands.emplace_back();
+	auto &c = b.commands.back();
+	c.bp = &bp;
+	c.write_buffer = write_buffer;
+	c.bytes_per_row = bytes_per_row;
+	c.top = top;
+	c.bot = bot;
+	c.clip_left = Window_clip_left;
+	c.clip_top = Window_clip_top;
+	c.clip_right = Window_clip_right;
+	c.clip_bot = Window_clip_bot;
+	c.transparency = Transparency_on;
+	c.lighting = Lighting_enabled;
+	c.linear = linear;
+	c.tmap.nv = t.nv;
+	std::copy_n(t.verts.begin(), t.nv, c.tmap.verts.begin());
+	b.bot = std::max(b.bot, std::min(bot, Window_clip_bot));
+}
+
 // -------------------------------------------------------------------------------------
 // Interface from Matt's data structures to Mike's texture mapper.
 // -------------------------------------------------------------------------------------
@@ -840,6 +982,9 @@ void draw_tmap(grs_canvas &canvas, const grs_bitmap &rbp, uint_fast32_t nverts,
 	Lighting_enabled = Lighting_on;
 
 	// Now, call my texture mapper.
+	if (tmap_batch.active)
+		draw_tmap_record(*bp, Tmap1, Interpolation_method == 1 || (Interpolation_method == 0 && Current_seg_depth > Max_perspective_depth));
+	else
 		switch (Interpolation_method) {	// 0 = choose, 1 = linear, 2 = /8 perspective, 3 = full perspective
 			case 0:								// choose best interpolation
 				if (Current_seg_depth > Max_perspective_depth)
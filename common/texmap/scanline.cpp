@@ -23,6 +23,7 @@ COPYRIGHT 1993-1998 PARALLAX SOFTWARE CORPORATION.  ALL RIGHTS RESERVED.
  *
  */
 
+#include <algorithm>
 #include <math.h>
 #include <limits.h>
 #include <stdio.h>
@@ -37,6 +38,19 @@ COPYRIGHT 1993-1998 PARALLAX SOFTWARE CORPORATION.  ALL RIGHTS RESERVED.
 #include "scanline.h"
 #include "strutil.h"
 #include "dxxerror.h"
+#include "compiler-array.h"
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#define DXX_TMAP_SCANLINE_SIMD	1
+#define DXX_TMAP_SCANLINE_SIMD_DIVIDE	1
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#define DXX_TMAP_SCANLINE_SIMD	1
+#if defined(__aarch64__)
+#define DXX_TMAP_SCANLINE_SIMD_DIVIDE	1
+#endif
+#endif
 
 namespace dcx {
 
@@ -207,6 +221,270 @@ void c_tmap_scanline_lin()
 	}
 }
 
+#ifdef DXX_TMAP_SCANLINE_SIMD
+// These texture mappers step u, v, z and l for 8 pixels at once in vector registers and compute every
+// texel and shade index in vector registers.  Only the texel and fade table loads are scalar, since
+// neither SSE2 nor NEON can gather bytes.  They draw exactly what c_tmap_scanline_lin and
+// c_tmap_scanline_per draw, which remain the reference.
+namespace {
+
+#if defined(__SSE2__)
+typedef __m128i tmap_lanes;
+
+static inline tmap_lanes tmap_lanes_set(const int32_t a, const int32_t b, const int32_t c, const int32_t d)
+{
+	return _mm_setr_epi32(a, b, c, d);
+}
+
+static inline tmap_lanes tmap_lanes_dup(const int32_t a)
+{
+	return _mm_set1_epi32(a);
+}
+
+static inline tmap_lanes tmap_lanes_add(const tmap_lanes a, const tmap_lanes b)
+{
+	return _mm_add_epi32(a, b);
+}
+
+static inline tmap_lanes tmap_lanes_and(const tmap_lanes a, const int32_t mask)
+{
+	return _mm_and_si128(a, _mm_set1_epi32(mask));
+}
+
+static inline tmap_lanes tmap_lanes_or(const tmap_lanes a, const tmap_lanes b)
+{
+	return _mm_or_si128(a, b);
+}
+
+template <int shift>
+static inline tmap_lanes tmap_lanes_srai(const tmap_lanes a)
+{
+	return _mm_srai_epi32(a, shift);
+}
+
+template <int shift>
+static inline tmap_lanes tmap_lanes_slli(const tmap_lanes a)
+{
+	return _mm_slli_epi32(a, shift);
+}
+
+static inline void tmap_lanes_store(int32_t *const p, const tmap_lanes a)
+{
+	_mm_store_si128(reinterpret_cast<__m128i *>(p), a);
+}
+
+//	Dividing in double precision and truncating gives the same result as integer division for any
+//	32-bit operands: the rounding error is always smaller than the distance to the next integer.
+static inline tmap_lanes tmap_lanes_quotient(const tmap_lanes a, const tmap_lanes b)
+{
+	const auto lo = _mm_div_pd(_mm_cvtepi32_pd(a), _mm_cvtepi32_pd(b));
+	const auto hi = _mm_div_pd(_mm_cvtepi32_pd(_mm_shuffle_epi32(a, _MM_SHUFFLE(1, 0, 3, 2))), _mm_cvtepi32_pd(_mm_shuffle_epi32(b, _MM_SHUFFLE(1, 0, 3, 2))));
+	return _mm_unpacklo_epi64(_mm_cvttpd_epi32(lo), _mm_cvttpd_epi32(hi));
+}
+#else
+typedef int32x4_t tmap_lanes;
+
+static inline tmap_lanes tmap_lanes_set(const int32_t a, const int32_t b, const int32_t c, const int32_t d)
+{
+	const int32_t v[4] = {a, b, c, d};
+	return vld1q_s32(v);
+}
+
+static inline tmap_lanes tmap_lanes_dup(const int32_t a)
+{
+	return vdupq_n_s32(a);
+}
+
+static inline tmap_lanes tmap_lanes_add(const tmap_lanes a, const tmap_lanes b)
+{
+	return vaddq_s32(a, b);
+}
+
+static inline tmap_lanes tmap_lanes_and(const tmap_lanes a, const int32_t mask)
+{
+	return vandq_s32(a, vdupq_n_s32(mask));
+}
+
+static inline tmap_lanes tmap_lanes_or(const tmap_lanes a, const tmap_lanes b)
+{
+	return vorrq_s32(a, b);
+}
+
+template <int shift>
+static inline tmap_lanes tmap_lanes_srai(const tmap_lanes a)
+{
+	return vshrq_n_s32(a, shift);
+}
+
+template <int shift>
+static inline tmap_lanes tmap_lanes_slli(const tmap_lanes a)
+{
+	return vshlq_n_s32(a, shift);
+}
+
+static inline void tmap_lanes_store(int32_t *const p, const tmap_lanes a)
+{
+	vst1q_s32(p, a);
+}
+
+#if defined(DXX_TMAP_SCANLINE_SIMD_DIVIDE)
+//	See the SSE2 version for why this matches integer division.
+static inline tmap_lanes tmap_lanes_quotient(const tmap_lanes a, const tmap_lanes b)
+{
+	const auto lo = vdivq_f64(vcvtq_f64_s64(vmovl_s32(vget_low_s32(a))), vcvtq_f64_s64(vmovl_s32(vget_low_s32(b))));
+	const auto hi = vdivq_f64(vcvtq_f64_s64(vmovl_s32(vget_high_s32(a))), vcvtq_f64_s64(vmovl_s32(vget_high_s32(b))));
+	return vcombine_s32(vmovn_s64(vcvtq_s64_f64(lo)), vmovn_s64(vcvtq_s64_f64(hi)));
+}
+#endif
+#endif
+
+//	The values of base + step * i for lanes i = first .. first + 3, wrapping like repeated addition.
+static inline tmap_lanes tmap_lanes_ramp(const fix base, const fix step, const unsigned first)
+{
+	const auto b = static_cast<uint32_t>(base), s = static_cast<uint32_t>(step);
+	return tmap_lanes_set(b + s * first, b + s * (first + 1), b + s * (first + 2), b + s * (first + 3));
+}
+
+static inline fix tmap_fix_advance(const fix base, const fix step, const unsigned count)
+{
+	return static_cast<uint32_t>(base) + static_cast<uint32_t>(step) * count;
+}
+
+//	Number of pixels the scalar mappers draw before their ++index >= SWIDTH*SHEIGHT check stops them.
+static inline int tmap_scanline_pixels(const int index)
+{
+	return std::min(fx_xright - fx_xleft + 1, SWIDTH*SHEIGHT - index - 1);
+}
+
+//	Write the 4 pixels whose texel offsets are in texel and shade offsets are in shade.
+static inline void tmap_scanline_write4(uint8_t *const dest, const tmap_lanes texel, const tmap_lanes shade, const bool transparent)
+{
+	alignas(16) array<int32_t, 4> t, s;
+	tmap_lanes_store(t.data(), texel);
+	tmap_lanes_store(s.data(), tmap_lanes_slli<8>(shade));
+	const auto pix = pixptr;
+	const auto fade = &gr_fade_table[0][0];
+	for (unsigned i = 0; i != 4; ++i)
+	{
+		const uint8_t c = pix[t[i]];
+		if (!transparent || c != TRANSPARENCY_COLOR)
+			dest[i] = fade[s[i] + c];
+	}
+}
+
+}
+
+static void simd_tmap_scanline_lin()
+{
+	const int index = fx_xleft + (bytes_per_row * fx_y);
+	int x = tmap_scanline_pixels(index);
+	fix u = fx_u;
+	fix v = fx_v*64;
+	fix l = fx_l>>8;
+	const fix dudx = fx_du_dx;
+	const fix dvdx = fx_dv_dx*64;
+	const fix dldx = fx_dl_dx/256;
+	auto dest = &write_buffer[index];
+	const bool transparent = Transparency_on;
+
+	if (x >= 8)
+	{
+		auto u0 = tmap_lanes_ramp(u, dudx, 0), u1 = tmap_lanes_ramp(u, dudx, 4);
+		auto v0 = tmap_lanes_ramp(v, dvdx, 0), v1 = tmap_lanes_ramp(v, dvdx, 4);
+		auto l0 = tmap_lanes_ramp(l, dldx, 0), l1 = tmap_lanes_ramp(l, dldx, 4);
+		const auto su = tmap_lanes_dup(tmap_fix_advance(0, dudx, 8));
+		const auto sv = tmap_lanes_dup(tmap_fix_advance(0, dvdx, 8));
+		const auto sl = tmap_lanes_dup(tmap_fix_advance(0, dldx, 8));
+		const unsigned n = x & ~7;
+		for (unsigned i = 0; i != n; i += 8, dest += 8)
+		{
+			tmap_scanline_write4(dest, tmap_lanes_or(tmap_lanes_and(tmap_lanes_srai<16>(v0), 64*63), tmap_lanes_and(tmap_lanes_srai<16>(u0), 63)), tmap_lanes_and(tmap_lanes_srai<8>(l0), 0x7f), transparent);
+			tmap_scanline_write4(dest + 4, tmap_lanes_or(tmap_lanes_and(tmap_lanes_srai<16>(v1), 64*63), tmap_lanes_and(tmap_lanes_srai<16>(u1), 63)), tmap_lanes_and(tmap_lanes_srai<8>(l1), 0x7f), transparent);
+			u0 = tmap_lanes_add(u0, su);
+			u1 = tmap_lanes_add(u1, su);
+			v0 = tmap_lanes_add(v0, sv);
+			v1 = tmap_lanes_add(v1, sv);
+			l0 = tmap_lanes_add(l0, sl);
+			l1 = tmap_lanes_add(l1, sl);
+		}
+		u = tmap_fix_advance(u, dudx, n);
+		v = tmap_fix_advance(v, dvdx, n);
+		l = tmap_fix_advance(l, dldx, n);
+		x -= n;
+	}
+	for (; x > 0; --x)
+	{
+		const uint8_t c = pixptr[(f2i(v)&(64*63)) + (f2i(u)&63)];
+		if (!transparent || c != TRANSPARENCY_COLOR)
+			*dest = gr_fade_table[(l>>8)&0x7f][c];
+		dest++;
+		l += dldx;
+		u += dudx;
+		v += dvdx;
+	}
+}
+
+#ifdef DXX_TMAP_SCANLINE_SIMD_DIVIDE
+static void simd_tmap_scanline_per()
+{
+	const int index = fx_xleft + (bytes_per_row * fx_y);
+	int x = tmap_scanline_pixels(index);
+	fix u = fx_u;
+	fix v = fx_v*64;
+	fix z = fx_z;
+	fix l = fx_l>>8;
+	const fix dudx = fx_du_dx;
+	const fix dvdx = fx_dv_dx*64;
+	const fix dzdx = fx_dz_dx;
+	const fix dldx = fx_dl_dx/256;
+	auto dest = &write_buffer[index];
+	const bool transparent = Transparency_on;
+
+	if (x >= 8)
+	{
+		auto u0 = tmap_lanes_ramp(u, dudx, 0), u1 = tmap_lanes_ramp(u, dudx, 4);
+		auto v0 = tmap_lanes_ramp(v, dvdx, 0), v1 = tmap_lanes_ramp(v, dvdx, 4);
+		auto z0 = tmap_lanes_ramp(z, dzdx, 0), z1 = tmap_lanes_ramp(z, dzdx, 4);
+		auto l0 = tmap_lanes_ramp(l, dldx, 0), l1 = tmap_lanes_ramp(l, dldx, 4);
+		const auto su = tmap_lanes_dup(tmap_fix_advance(0, dudx, 8));
+		const auto sv = tmap_lanes_dup(tmap_fix_advance(0, dvdx, 8));
+		const auto sz = tmap_lanes_dup(tmap_fix_advance(0, dzdx, 8));
+		const auto sl = tmap_lanes_dup(tmap_fix_advance(0, dldx, 8));
+		const unsigned n = x & ~7;
+		for (unsigned i = 0; i != n; i += 8, dest += 8)
+		{
+			tmap_scanline_write4(dest, tmap_lanes_add(tmap_lanes_and(tmap_lanes_quotient(v0, z0), 64*63), tmap_lanes_and(tmap_lanes_quotient(u0, z0), 63)), tmap_lanes_and(tmap_lanes_srai<8>(l0), 0x7f), transparent);
+			tmap_scanline_write4(dest + 4, tmap_lanes_add(tmap_lanes_and(tmap_lanes_quotient(v1, z1), 64*63), tmap_lanes_and(tmap_lanes_quotient(u1, z1), 63)), tmap_lanes_and(tmap_lanes_srai<8>(l1), 0x7f), transparent);
+			u0 = tmap_lanes_add(u0, su);
+			u1 = tmap_lanes_add(u1, su);
+			v0 = tmap_lanes_add(v0, sv);
+			v1 = tmap_lanes_add(v1, sv);
+			z0 = tmap_lanes_add(z0, sz);
+			z1 = tmap_lanes_add(z1, sz);
+			l0 = tmap_lanes_add(l0, sl);
+			l1 = tmap_lanes_add(l1, sl);
+		}
+		u = tmap_fix_advance(u, dudx, n);
+		v = tmap_fix_advance(v, dvdx, n);
+		z = tmap_fix_advance(z, dzdx, n);
+		l = tmap_fix_advance(l, dldx, n);
+		x -= n;
+	}
+	for (; x > 0; --x)
+	{
+		const uint8_t c = pixptr[((v/z)&(64*63)) + ((u/z)&63)];
+		if (!transparent || c != TRANSPARENCY_COLOR)
+			*dest = gr_fade_table[(l>>8)&0x7f][c];
+		dest++;
+		l += dldx;
+		u += dudx;
+		v += dvdx;
+		z += dzdx;
+	}
+}
+#endif
+#endif
+
 // This texture mapper uses floating point extensively and writes 8 pixels at once, so it likely works
 // best on 64 bit RISC processors.
 // WARNING: it is not endian clean. For big endian, reverse the shift counts in the unrolled loops. I
@@ -661,8 +939,10 @@ static void c_tmap_scanline_quad()
 
 //runtime selection of optimized tmappers.  12/07/99  Matthew Mueller
 //the reason I did it this way rather than having a *tmap_funcs that then points to a c_tmap or fp_tmap struct thats already filled in, is to avoid a second pointer dereference.
+//the vector mappers are the default where the compiler targets SSE2 or NEON; "c" selects the plain C mappers they are checked against.
 void select_tmap(const std::string &type)
 {
+	cur_tmap_scanline_lin=c_tmap_scanline_lin;
 	if (type == "fp")
 	{
 		cur_tmap_scanline_per=c_fp_tmap_scanline_per;
@@ -671,8 +951,19 @@ void select_tmap(const std::string &type)
 	{
 		cur_tmap_scanline_per=c_tmap_scanline_quad;
 	}
+	else if (type == "c")
+	{
+		cur_tmap_scanline_per=c_tmap_scanline_per;
+	}
 	else {
+#ifdef DXX_TMAP_SCANLINE_SIMD
+		cur_tmap_scanline_lin=simd_tmap_scanline_lin;
+#endif
+#ifdef DXX_TMAP_SCANLINE_SIMD_DIVIDE
+		cur_tmap_scanline_per=simd_tmap_scanline_per;
+#else
 		cur_tmap_scanline_per=c_tmap_scanline_per;
+#endif
 	}
 }
 
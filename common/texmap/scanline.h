@@ -39,11 +39,13 @@ void c_tmap_scanline_shaded(const uint_fast32_t fade);
 struct tmap_scanline_function_table
 {
 	using per = void ();
+	using lin = void ();
 	per *sl_per;
+	lin *sl_lin;
 };
 
 #define cur_tmap_scanline_per (tmap_scanline_functions.sl_per)
-#define cur_tmap_scanline_lin (c_tmap_scanline_lin)
+#define cur_tmap_scanline_lin (tmap_scanline_functions.sl_lin)
 #define cur_tmap_scanline_lin_nolight (c_tmap_scanline_lin_nolight)
 #define cur_tmap_scanline_shaded (c_tmap_scanline_shaded)
 #define cur_tmap_scanline_flat (c_tmap_scanline_flat)
@@ -46,16 +46,16 @@ extern	int succmod(int val,int modulus);
 fix compute_dx_dy(const g3ds_tmap &t, int top_vertex,int bottom_vertex, fix recip_dy);
 void compute_y_bounds(const g3ds_tmap &t, int &vlt, int &vlb, int &vrt, int &vrb,int &bottom_y_ind);
 
-extern int	fx_y,fx_xleft,fx_xright;
-extern const unsigned char *pixptr;
+extern thread_local int	fx_y,fx_xleft,fx_xright;
+extern thread_local const unsigned char *pixptr;
 // texture mapper scanline renderers
 // Interface variables to assembler code
-extern	fix	fx_u,fx_v,fx_z,fx_du_dx,fx_dv_dx,fx_dz_dx;
-extern	fix	fx_dl_dx,fx_l;
-extern	int	bytes_per_row;
-extern  unsigned char *write_buffer;
+extern thread_local fix	fx_u,fx_v,fx_z,fx_du_dx,fx_dv_dx,fx_dz_dx;
+extern thread_local fix	fx_dl_dx,fx_l;
+extern thread_local int	bytes_per_row;
+extern thread_local unsigned char *write_buffer;
 
-extern uint8_t tmap_flat_color;
+extern thread_local uint8_t tmap_flat_color;
 
 constexpr std::integral_constant<std::size_t, 641> FIX_RECIP_TABLE_SIZE{};	//increased from 321 to 641, since this res is now quite achievable.. slight fps boost -MM
 extern const array<fix, FIX_RECIP_TABLE_SIZE> fix_recip_table;
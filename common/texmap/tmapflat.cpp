@@ -177,6 +177,7 @@ static void texture_map_flat(grs_canvas &canvas, const g3ds_tmap &t, int color)
 //	(ie, avoids cracking) edge/delta computation.
 void gr_upoly_tmap(grs_canvas &canvas, uint_fast32_t nverts, const array<fix, MAX_POINTS_IN_POLY * 2> &vert, const uint8_t color)
 {
+	draw_tmap_flush();
 	gr_upoly_tmap_ylr(canvas, nverts, vert.data(), color);
 }
 
@@ -193,6 +194,7 @@ void draw_tmap_flat(grs_canvas &canvas, const grs_bitmap &bp, uint_fast32_t nver
 	};
 	static_assert(sizeof(points) == sizeof(ipoints), "array size mismatch");
 	fix	average_light;
+	draw_tmap_flush();
 	Assert(nverts < MAX_TMAP_VERTS);
 	average_light = vertbuf[0]->p3_l;
 	for (int i=1; i<nverts; i++)
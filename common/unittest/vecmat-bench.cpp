@@ -0,0 +1,141 @@
+#include <chrono>
+#include <cstdio>
+#include "vecmat.h"
+
+#define BOOST_TEST_DYN_LINK
+#define BOOST_TEST_MODULE Rebirth vecmat benchmark
+#include <boost/test/unit_test.hpp>
+
+/* Time the vector and matrix kernels which the renderer and physics
+ * call most.  Each case prints one line, "bench <name> <ns> ns/op", so
+ * that the output of two builds can be compared with diff.  The inputs
+ * are the same on every run.
+ */
+
+namespace {
+
+class test_rng
+{
+	uint32_t state = 0x12345678;
+public:
+	fix operator()()
+	{
+		state = state * 1664525u + 1013904223u;
+		/* Stay in the range the game uses, where sums cannot overflow. */
+		return static_cast<fix>(state) >> 8;
+	}
+};
+
+constexpr std::size_t bench_vector_count = 1024;
+constexpr unsigned bench_passes = 2000;
+
+struct bench_inputs
+{
+	vms_vector v[bench_vector_count];
+	vms_matrix m0, m1;
+	bench_inputs()
+	{
+		test_rng rng;
+		for (auto &i : v)
+			i = {rng(), rng(), rng()};
+		m0 = {{rng(), rng(), rng()}, {rng(), rng(), rng()}, {rng(), rng(), rng()}};
+		m1 = {{rng(), rng(), rng()}, {rng(), rng(), rng()}, {rng(), rng(), rng()}};
+	}
+};
+
+/* Results are summed into this, so that the kernels are not optimized
+ * away.
+ */
+volatile fix bench_sink;
+
+template <typename F>
+void bench(const char *const name, const std::size_t ops_per_pass, F &&f)
+{
+	/* One pass untimed, to fault in the inputs. */
+	f();
+	const auto start = std::chrono::steady_clock::now();
+	for (unsigned i = 0; i != bench_passes; ++i)
+		f();
+	const auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+	std::printf("bench %-24s %8.2f ns/op\n", name, static_cast<double>(ns) / (static_cast<double>(bench_passes) * ops_per_pass));
+}
+
+}
+
+BOOST_AUTO_TEST_CASE(bench_vm_vec_rotate)
+{
+	const bench_inputs in;
+	bench("vm_vec_rotate", bench_vector_count, [&in]() {
+		fix sum = 0;
+		for (auto &v : in.v)
+		{
+			vms_vector r;
+			vm_vec_rotate(r, v, in.m0);
+			sum += r.x ^ r.y ^ r.z;
+		}
+		bench_sink = sum;
+	});
+}
+
+BOOST_AUTO_TEST_CASE(bench_vm_vec_rotate_n)
+{
+	const bench_inputs in;
+	vms_vector dest[bench_vector_count];
+	bench("vm_vec_rotate_n", bench_vector_count, [&in, &dest]() {
+		vm_vec_rotate_n(dest, in.v, bench_vector_count, in.m0);
+		bench_sink = dest[bench_vector_count - 1].x;
+	});
+}
+
+BOOST_AUTO_TEST_CASE(bench_vm_matrix_x_matrix)
+{
+	const bench_inputs in;
+	bench("vm_matrix_x_matrix", bench_vector_count, [&in]() {
+		fix sum = 0;
+		auto m = in.m0;
+		for (std::size_t i = 0; i != bench_vector_count; ++i)
+		{
+			const auto r = vm_matrix_x_matrix(m, in.m1);
+			sum += r.rvec.x;
+			m.fvec.x ^= r.uvec.y;
+		}
+		bench_sink = sum;
+	});
+}
+
+BOOST_AUTO_TEST_CASE(bench_vm_vec_normalize_quick)
+{
+	const bench_inputs in;
+	bench("vm_vec_normalize_quick", bench_vector_count, [&in]() {
+		fix sum = 0;
+		for (auto &v : in.v)
+		{
+			auto r = v;
+			vm_vec_normalize_quick(r);
+			sum += r.x;
+		}
+		bench_sink = sum;
+	});
+}
+
+BOOST_AUTO_TEST_CASE(bench_vm_vec_dist_quick)
+{
+	const bench_inputs in;
+	bench("vm_vec_dist_quick", bench_vector_count - 1, [&in]() {
+		fix sum = 0;
+		for (std::size_t i = 1; i != bench_vector_count; ++i)
+			sum += vm_vec_dist_quick(in.v[i - 1], in.v[i]);
+		bench_sink = sum;
+	});
+}
+
+BOOST_AUTO_TEST_CASE(bench_fixmul_fixdiv)
+{
+	const bench_inputs in;
+	bench("fixmul+fixdiv", bench_vector_count, [&in]() {
+		fix sum = 0;
+		for (auto &v : in.v)
+			sum += fixdiv(fixmul(v.x, v.y), v.z | 1);
+		bench_sink = sum;
+	});
+}
@@ -0,0 +1,92 @@
+#include "vecmat.h"
+
+#define BOOST_TEST_DYN_LINK
+#define BOOST_TEST_MODULE Rebirth vecmat
+#include <boost/test/unit_test.hpp>
+
+/* Demo playback and multiplayer sync depend on every build producing
+ * the same fixed-point results, so the optimized kernels must match the
+ * plain arithmetic exactly.
+ */
+
+namespace {
+
+/* Deterministic, so that a failure can be reproduced. */
+class test_rng
+{
+	uint32_t state = 0x12345678;
+public:
+	fix operator()()
+	{
+		state = state * 1664525u + 1013904223u;
+		return static_cast<fix>(state);
+	}
+};
+
+fix reference_dot(const vms_vector &a, const vms_vector &b)
+{
+	return (static_cast<int64_t>(a.x) * b.x + static_cast<int64_t>(a.y) * b.y + static_cast<int64_t>(a.z) * b.z) >> 16;
+}
+
+bool same_vector(const vms_vector &a, const vms_vector &b)
+{
+	return a.x == b.x && a.y == b.y && a.z == b.z;
+}
+
+/* Large enough to reach loop tails of any vector width. */
+constexpr std::size_t test_vector_count = 67;
+
+}
+
+BOOST_AUTO_TEST_CASE(fixmul_truncates_toward_zero)
+{
+	BOOST_TEST(fixmul(F1_0, F1_0) == F1_0);
+	BOOST_TEST(fixmul(-1, 1) == 0);
+	BOOST_TEST(fixmul(-F1_0 / 2, 3) == -1);
+	BOOST_TEST(fixmul(F1_0 / 2, 3) == 1);
+	test_rng rng;
+	for (unsigned i = 0; i != 10000; ++i)
+	{
+		const fix a = rng(), b = rng();
+		BOOST_TEST(fixmul64(a, b) == (static_cast<int64_t>(a) * b) / 65536);
+	}
+}
+
+BOOST_AUTO_TEST_CASE(vm_vec_rotate_matches_reference)
+{
+	test_rng rng;
+	for (unsigned i = 0; i != 1000; ++i)
+	{
+		/* Keep the inputs in a range where the sums cannot overflow,
+		 * as they are in the game.
+		 */
+		const auto small = [&rng]() { return rng() >> 8; };
+		const vms_matrix m{{small(), small(), small()}, {small(), small(), small()}, {small(), small(), small()}};
+		const vms_vector v{small(), small(), small()};
+		vms_vector r;
+		vm_vec_rotate(r, v, m);
+		BOOST_TEST(r.x == reference_dot(v, m.rvec));
+		BOOST_TEST(r.y == reference_dot(v, m.uvec));
+		BOOST_TEST(r.z == reference_dot(v, m.fvec));
+	}
+}
+
+BOOST_AUTO_TEST_CASE(vm_vec_rotate_n_matches_vm_vec_rotate)
+{
+	test_rng rng;
+	const auto small = [&rng]() { return rng() >> 8; };
+	vms_vector src[test_vector_count], dest[test_vector_count];
+	for (auto &v : src)
+		v = {small(), small(), small()};
+	const vms_matrix m{{small(), small(), small()}, {small(), small(), small()}, {small(), small(), small()}};
+	for (std::size_t n = 0; n <= test_vector_count; ++n)
+	{
+		vm_vec_rotate_n(dest, src, n, m);
+		for (std::size_t i = 0; i != n; ++i)
+		{
+			vms_vector expected;
+			vm_vec_rotate(expected, src[i], m);
+			BOOST_TEST(same_vector(dest[i], expected));
+		}
+	}
+}
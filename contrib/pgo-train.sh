@@ -0,0 +1,26 @@
+#!/bin/sh
+# Record a profile with a program built with pgo=generate.  Each demo
+# is played twice: drawn, and without drawing, so that both the
+# renderer and the game simulation are trained.
+#
+# usage: contrib/pgo-train.sh program demo...
+#
+# Options for the program, such as -hogdir, can be given in
+# $DXX_PGO_ARGS.  Build with pgo=use afterward.
+
+set -e
+
+if [ $# -lt 2 ]; then
+	echo "usage: $0 program demo..." >&2
+	exit 2
+fi
+
+program=$1
+shift
+for demo in "$@"; do
+	echo "pgo-train: $demo"
+	# shellcheck disable=SC2086
+	"$program" $DXX_PGO_ARGS -window -nosound -nomusic -timedemo "$demo"
+	# shellcheck disable=SC2086
+	"$program" $DXX_PGO_ARGS -headless -timedemo "$demo"
+done
@@ -21,6 +21,7 @@
 #include "u_mem.h"
 #include "custom.h"
 #include "physfsx.h"
+#include "profile.h"
 
 #include "compiler-begin.h"
 #include "compiler-make_unique.h"
@@ -598,6 +599,7 @@ static void custom_remove()
 
 void load_custom_data(const d_fname &level_name)
 {
+	const trace_scope trace_phase("load_custom_data", level_name);
 	custom_remove();
 	d_fname custom_file;
 	using std::copy;
@@ -18,6 +18,10 @@
 #include "compiler-array.h"
 #include "compiler-integer_sequence.h"
 
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
 static unsigned short *backBuf1, *backBuf2;
 
 static void dispatchDecoder16(unsigned short **pFrame, unsigned char codeType, const unsigned char **pData, const unsigned char **pOffData, int *pDataRemain, int *curXb, int *curYb);
@@ -147,20 +151,70 @@ constexpr lookup_table_t lookup_table = genLoopkupTable(make_tree_index_sequence
 
 static void copyFrame(unsigned short *pDest, unsigned short *pSrc)
 {
-    int i;
+	const auto width = g_width;
+	for (unsigned i = 0; i != 8; ++i, pDest += width, pSrc += width)
+	{
+#if defined(__SSE2__)
+		_mm_storeu_si128(reinterpret_cast<__m128i *>(pDest), _mm_loadu_si128(reinterpret_cast<const __m128i *>(pSrc)));
+#else
+		memcpy(pDest, pSrc, 16);
+#endif
+	}
+}
 
-    for (i=0; i<8; i++)
-    {
-        memcpy(pDest, pSrc, 16);
-        pDest += g_width;
-        pSrc += g_width;
-    }
+#if defined(__SSE2__)
+/* As in the 8 bit decoder, the pattern fills test each pixel's pattern
+ * bit in its own 16 bit lane and blend the colors through the
+ * resulting masks, so that a row of eight pixels is one store.
+ */
+static inline __m128i pattern_mask(const __m128i pattern, const __m128i bits)
+{
+	return _mm_cmpeq_epi16(_mm_and_si128(pattern, bits), bits);
+}
+
+static inline __m128i pattern_select(const __m128i mask, const __m128i set, const __m128i clear)
+{
+	return _mm_or_si128(_mm_and_si128(mask, set), _mm_andnot_si128(mask, clear));
+}
+
+static inline __m128i pattern_color(const uint16_t c)
+{
+	return _mm_set1_epi16(static_cast<short>(c));
+}
+
+/* lo holds the low bit of each pixel's two bit color index; the high
+ * bit is the next one up.
+ */
+static inline __m128i pattern_select4(const __m128i pattern, const __m128i lo, const array<uint16_t, 4> &p)
+{
+	const auto mlo = pattern_mask(pattern, lo);
+	const auto mhi = pattern_mask(pattern, _mm_slli_epi16(lo, 1));
+	return pattern_select(mhi,
+		pattern_select(mlo, pattern_color(p[3]), pattern_color(p[2])),
+		pattern_select(mlo, pattern_color(p[1]), pattern_color(p[0])));
+}
+
+static inline void store_row(unsigned short *const pFrame, const __m128i v)
+{
+	_mm_storeu_si128(reinterpret_cast<__m128i *>(pFrame), v);
+}
+
+/* Two rows of four pixels, one per 64-bit half. */
+static inline void store_half_rows(unsigned short *const pFrame, const __m128i v)
+{
+	_mm_storel_epi64(reinterpret_cast<__m128i *>(pFrame), v);
+	_mm_storel_epi64(reinterpret_cast<__m128i *>(pFrame + g_width), _mm_srli_si128(v, 8));
 }
+#endif
 
 static void patternRow4Pixels(unsigned short *pFrame,
                               unsigned char pat0, unsigned char pat1,
                               const array<uint16_t, 4> &p)
 {
+#if defined(__SSE2__)
+	const auto v = _mm_set1_epi16(static_cast<short>((pat1 << 8) | pat0));
+	store_row(pFrame, pattern_select4(v, _mm_setr_epi16(1, 4, 16, 64, 1 << 8, 1 << 10, 1 << 12, 1 << 14), p));
+#else
     unsigned short mask=0x0003;
     unsigned short shift=0;
     unsigned short pattern = (pat1 << 8) | pat0;
@@ -171,12 +225,18 @@ static void patternRow4Pixels(unsigned short *pFrame,
         mask <<= 2;
         shift += 2;
     }
+#endif
 }
 
 static void patternRow4Pixels2(unsigned short *pFrame,
                                unsigned char pat0,
                                const array<uint16_t, 4> &p)
 {
+#if defined(__SSE2__)
+	const auto row = pattern_select4(_mm_set1_epi16(pat0), _mm_setr_epi16(1, 1, 4, 4, 16, 16, 64, 64), p);
+	store_row(pFrame, row);
+	store_row(pFrame + g_width, row);
+#else
     unsigned char mask=0x03;
     unsigned char shift=0;
     unsigned short pel;
@@ -207,11 +267,15 @@ static void patternRow4Pixels2(unsigned short *pFrame,
         mask <<= 2;
         shift += 2;
     }
+#endif
 }
 
 static void patternRow4Pixels2x1(unsigned short *pFrame, unsigned char pat,
 								 const array<uint16_t, 4> &p)
 {
+#if defined(__SSE2__)
+	store_row(pFrame, pattern_select4(_mm_set1_epi16(pat), _mm_setr_epi16(1, 1, 4, 4, 16, 16, 64, 64), p));
+#else
     unsigned char mask=0x03;
     unsigned char shift=0;
     unsigned short pel;
@@ -225,12 +289,18 @@ static void patternRow4Pixels2x1(unsigned short *pFrame, unsigned char pat,
         mask <<= 2;
         shift += 2;
     }
+#endif
 }
 
 static void patternQuadrant4Pixels(unsigned short *pFrame,
 								   unsigned char pat0, unsigned char pat1, unsigned char pat2,
 								   unsigned char pat3, const array<uint16_t, 4> &p)
 {
+#if defined(__SSE2__)
+	const auto lo = _mm_setr_epi16(1, 4, 16, 64, 1, 4, 16, 64);
+	store_half_rows(pFrame, pattern_select4(_mm_setr_epi16(pat0, pat0, pat0, pat0, pat1, pat1, pat1, pat1), lo, p));
+	store_half_rows(pFrame + 2 * g_width, pattern_select4(_mm_setr_epi16(pat2, pat2, pat2, pat2, pat3, pat3, pat3, pat3), lo, p));
+#else
     unsigned long mask = 0x00000003UL;
     int shift=0;
     int i;
@@ -246,12 +316,17 @@ static void patternQuadrant4Pixels(unsigned short *pFrame,
         mask <<= 2;
         shift += 2;
     }
+#endif
 }
 
 
 static void patternRow2Pixels(unsigned short *pFrame, unsigned char pat,
 							  const array<uint16_t, 4> &p)
 {
+#if defined(__SSE2__)
+	const auto m = pattern_mask(_mm_set1_epi16(pat), _mm_setr_epi16(1, 2, 4, 8, 16, 32, 64, 128));
+	store_row(pFrame, pattern_select(m, pattern_color(p[1]), pattern_color(p[0])));
+#else
     unsigned char mask=0x01;
 
     while (mask != 0)
@@ -259,11 +334,18 @@ static void patternRow2Pixels(unsigned short *pFrame, unsigned char pat,
         *pFrame++ = p[(mask & pat) ? 1 : 0];
         mask <<= 1;
     }
+#endif
 }
 
 static void patternRow2Pixels2(unsigned short *pFrame, unsigned char pat,
 							   const array<uint16_t, 4> &p)
 {
+#if defined(__SSE2__)
+	const auto m = pattern_mask(_mm_set1_epi16(pat), _mm_setr_epi16(1, 1, 2, 2, 4, 4, 8, 8));
+	const auto row = pattern_select(m, pattern_color(p[1]), pattern_color(p[0]));
+	store_row(pFrame, row);
+	store_row(pFrame + g_width, row);
+#else
     unsigned short pel;
     unsigned char mask=0x1;
 
@@ -292,11 +374,18 @@ static void patternRow2Pixels2(unsigned short *pFrame, unsigned char pat,
 
 		mask <<= 1;
 	}
+#endif
 }
 
 static void patternQuadrant2Pixels(unsigned short *pFrame, unsigned char pat0,
 								   unsigned char pat1, const array<uint16_t, 4> &p)
 {
+#if defined(__SSE2__)
+	const auto v = _mm_set1_epi16(static_cast<short>((pat1 << 8) | pat0));
+	const auto p0 = pattern_color(p[0]), p1 = pattern_color(p[1]);
+	store_half_rows(pFrame, pattern_select(pattern_mask(v, _mm_setr_epi16(1, 2, 4, 8, 16, 32, 64, 128)), p1, p0));
+	store_half_rows(pFrame + 2 * g_width, pattern_select(pattern_mask(v, _mm_setr_epi16(1 << 8, 1 << 9, 1 << 10, 1 << 11, 1 << 12, 1 << 13, 1 << 14, static_cast<short>(1 << 15))), p1, p0));
+#else
     unsigned short mask = 0x0001;
     int i;
     unsigned short pat = (pat1 << 8) | pat0;
@@ -310,6 +399,7 @@ static void patternQuadrant2Pixels(unsigned short *pFrame, unsigned char pat0,
 
         mask <<= 1;
     }
+#endif
 }
 
 static void dispatchDecoder16(unsigned short **pFrame, unsigned char codeType, const unsigned char **pData, const unsigned char **pOffData, int *pDataRemain, int *curXb, int *curYb)
@@ -16,6 +16,10 @@
 #include "dxxsconf.h"
 #include "compiler-array.h"
 
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
 static void dispatchDecoder(unsigned char **pFrame, unsigned char codeType, const unsigned char **pData, int *pDataRemain, int *curXb, int *curYb);
 
 void decodeFrame8(unsigned char *pFrame, const unsigned char *pMap, int mapRemain, const unsigned char *pData, int dataRemain)
@@ -72,6 +76,64 @@ static void relFar(int i, int sign, int *x, int *y)
 	}
 }
 
+#if defined(__SSE2__)
+/* The pattern fills expand their pattern bits into one byte mask per
+ * pixel and blend the colors through the masks, so that each row is a
+ * single store instead of eight table lookups.  bits holds, for each
+ * output byte, the pattern bit which selects it.
+ */
+static inline __m128i pattern_mask(const __m128i pattern, const __m128i bits)
+{
+	return _mm_cmpeq_epi8(_mm_and_si128(pattern, bits), bits);
+}
+
+static inline __m128i pattern_select(const __m128i mask, const __m128i set, const __m128i clear)
+{
+	return _mm_or_si128(_mm_and_si128(mask, set), _mm_andnot_si128(mask, clear));
+}
+
+static inline __m128i pattern_color(const uint8_t c)
+{
+	return _mm_set1_epi8(static_cast<char>(c));
+}
+
+/* lo and hi are the masks for the low and high bit of each pixel's
+ * two bit color index.
+ */
+static inline __m128i pattern_select4(const __m128i lo, const __m128i hi, const array<uint8_t, 4> &p)
+{
+	return pattern_select(hi,
+		pattern_select(lo, pattern_color(p[3]), pattern_color(p[2])),
+		pattern_select(lo, pattern_color(p[1]), pattern_color(p[0])));
+}
+
+static inline __m128i pattern_bytes(const unsigned pat)
+{
+	return _mm_set1_epi8(static_cast<char>(pat));
+}
+
+static inline void store_row4(unsigned char *const pFrame, const __m128i v)
+{
+	const uint32_t row = _mm_cvtsi128_si32(v);
+	memcpy(pFrame, &row, sizeof(row));
+}
+
+static inline void store_row8(unsigned char *const pFrame, const __m128i v)
+{
+	_mm_storel_epi64(reinterpret_cast<__m128i *>(pFrame), v);
+}
+
+/* Four rows of four pixels, one row per 32-bit lane. */
+static inline void store_quadrant(unsigned char *pFrame, __m128i v, const int width)
+{
+	for (unsigned i = 0; i != 4; ++i, pFrame += width)
+	{
+		store_row4(pFrame, v);
+		v = _mm_srli_si128(v, 4);
+	}
+}
+#endif
+
 /* copies an 8x8 block from pSrc to pDest.
    pDest and pSrc are both g_width bytes wide */
 static void copyFrame(uint8_t *pDest, const uint8_t *pSrc)
@@ -92,6 +154,12 @@ static void patternRow4Pixels(unsigned char *pFrame,
 							  unsigned char pat0, unsigned char pat1,
 							  const array<uint8_t, 4> &p)
 {
+#if defined(__SSE2__)
+	const auto v = _mm_set_epi32(0, 0, pat1 * 0x01010101u, pat0 * 0x01010101u);
+	const auto lo = pattern_mask(v, _mm_set1_epi32(0x40100401));
+	const auto hi = pattern_mask(v, _mm_set1_epi32(0x80200802));
+	store_row8(pFrame, pattern_select4(lo, hi, p));
+#else
 	unsigned short mask=0x0003;
 	unsigned short shift=0;
 	unsigned short pattern = (pat1 << 8) | pat0;
@@ -102,6 +170,7 @@ static void patternRow4Pixels(unsigned char *pFrame,
 		mask <<= 2;
 		shift += 2;
 	}
+#endif
 }
 
 // Fill in the next four 2x2 pixel blocks with p[0], p[1], p[2], or p[3],
@@ -110,6 +179,14 @@ static void patternRow4Pixels2(unsigned char *pFrame,
 							   unsigned char pat0,
 							   const array<uint8_t, 4> &p)
 {
+#if defined(__SSE2__)
+	const auto v = pattern_bytes(pat0);
+	const auto lo = pattern_mask(v, _mm_set_epi32(0, 0, 0x40401010, 0x04040101));
+	const auto hi = pattern_mask(v, _mm_set_epi32(0, 0, 0x80802020, 0x08080202));
+	const auto row = pattern_select4(lo, hi, p);
+	store_row8(pFrame, row);
+	store_row8(pFrame + g_width, row);
+#else
 	unsigned char mask=0x03;
 	unsigned char shift=0;
 	unsigned char pel;
@@ -126,12 +203,19 @@ static void patternRow4Pixels2(unsigned char *pFrame,
 		mask <<= 2;
 		shift += 2;
 	}
+#endif
 }
 
 // Fill in the next four 2x1 pixel blocks with p[0], p[1], p[2], or p[3],
 // depending on the corresponding two-bit value in pat.
 static void patternRow4Pixels2x1(unsigned char *pFrame, unsigned char pat, const array<uint8_t, 4> &p)
 {
+#if defined(__SSE2__)
+	const auto v = pattern_bytes(pat);
+	const auto lo = pattern_mask(v, _mm_set_epi32(0, 0, 0x40401010, 0x04040101));
+	const auto hi = pattern_mask(v, _mm_set_epi32(0, 0, 0x80802020, 0x08080202));
+	store_row8(pFrame, pattern_select4(lo, hi, p));
+#else
 	unsigned char mask=0x03;
 	unsigned char shift=0;
 	unsigned char pel;
@@ -145,12 +229,19 @@ static void patternRow4Pixels2x1(unsigned char *pFrame, unsigned char pat, const
 		mask <<= 2;
 		shift += 2;
 	}
+#endif
 }
 
 // Fill in the next 4x4 pixel block with p[0], p[1], p[2], or p[3],
 // depending on the corresponding two-bit value in pat0, pat1, pat2, and pat3.
 static void patternQuadrant4Pixels(unsigned char *pFrame, unsigned char pat0, unsigned char pat1, unsigned char pat2, unsigned char pat3, const array<uint8_t, 4> &p)
 {
+#if defined(__SSE2__)
+	const auto v = _mm_set_epi32(pat3 * 0x01010101u, pat2 * 0x01010101u, pat1 * 0x01010101u, pat0 * 0x01010101u);
+	const auto lo = pattern_mask(v, _mm_set1_epi32(0x40100401));
+	const auto hi = pattern_mask(v, _mm_set1_epi32(0x80200802));
+	store_quadrant(pFrame, pattern_select4(lo, hi, p), g_width);
+#else
 	unsigned long mask = 0x00000003UL;
 	int shift=0;
 	unsigned long pat = (pat3 << 24) | (pat2 << 16) | (pat1 << 8) | pat0;
@@ -166,11 +257,16 @@ static void patternQuadrant4Pixels(unsigned char *pFrame, unsigned char pat0, un
 		mask <<= 2;
 		shift += 2;
 	}
+#endif
 }
 
 // fills the next 8 pixels with either p[0] or p[1], depending on pattern
 static void patternRow2Pixels(unsigned char *pFrame, unsigned char pat, const array<uint8_t, 4> &p)
 {
+#if defined(__SSE2__)
+	const auto m = pattern_mask(pattern_bytes(pat), _mm_set_epi32(0, 0, 0x80402010, 0x08040201));
+	store_row8(pFrame, pattern_select(m, pattern_color(p[1]), pattern_color(p[0])));
+#else
 	unsigned char mask=0x01;
 
 	while (mask != 0)
@@ -178,11 +274,18 @@ static void patternRow2Pixels(unsigned char *pFrame, unsigned char pat, const ar
 		*pFrame++ = p[(mask & pat) ? 1 : 0];
 		mask <<= 1;
 	}
+#endif
 }
 
 // fills the next four 2 x 2 pixel boxes with either p[0] or p[1], depending on pattern
 static void patternRow2Pixels2(unsigned char *pFrame, unsigned char pat, const array<uint8_t, 4> &p)
 {
+#if defined(__SSE2__)
+	const auto m = pattern_mask(pattern_bytes(pat), _mm_set_epi32(0, 0, 0x08080404, 0x02020101));
+	const auto row = pattern_select(m, pattern_color(p[1]), pattern_color(p[0]));
+	store_row8(pFrame, row);
+	store_row8(pFrame + g_width, row);
+#else
 	unsigned char pel;
 	unsigned char mask=0x1;
 
@@ -199,11 +302,17 @@ static void patternRow2Pixels2(unsigned char *pFrame, unsigned char pat, const a
 
 		mask <<= 1;
 	}
+#endif
 }
 
 // fills pixels in the next 4 x 4 pixel boxes with either p[0] or p[1], depending on pat0 and pat1.
 static void patternQuadrant2Pixels(unsigned char *pFrame, unsigned char pat0, unsigned char pat1, const array<uint8_t, 4> &p)
 {
+#if defined(__SSE2__)
+	const auto v = _mm_set_epi32(pat1 * 0x01010101u, pat1 * 0x01010101u, pat0 * 0x01010101u, pat0 * 0x01010101u);
+	const auto m = pattern_mask(v, _mm_set_epi32(0x80402010, 0x08040201, 0x80402010, 0x08040201));
+	store_quadrant(pFrame, pattern_select(m, pattern_color(p[1]), pattern_color(p[0])), g_width);
+#else
 	unsigned char pel;
 	unsigned short mask = 0x0001;
 	unsigned short pat = (pat1 << 8) | pat0;
@@ -220,6 +329,7 @@ static void patternQuadrant2Pixels(unsigned char *pFrame, unsigned char pat0, un
 			mask <<= 1;
 		}
 	}
+#endif
 }
 
 static void dispatchDecoder(unsigned char **pFrame, unsigned char codeType, const unsigned char **pData, int *pDataRemain, int *curXb, int *curYb)
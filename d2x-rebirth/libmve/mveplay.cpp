@@ -7,6 +7,7 @@
 //#define DEBUG
 
 #include "dxxsconf.h"
+#include <atomic>
 #include <vector>
 #include <string.h>
 #include <time.h>
@@ -71,6 +72,45 @@ int g_spdFactorNum=0;
 static int g_spdFactorDenom=10;
 static int g_frameUpdated = 0;
 
+namespace {
+
+/* Frames decoded ahead of the one on screen.  The worker thread reads
+ * and decodes chunks into these while the main thread presents the
+ * oldest one, so a slow read or an expensive frame does not stall the
+ * display.
+ */
+constexpr unsigned MVE_FRAME_QUEUE = 3;
+
+struct mve_frame
+{
+	std::vector<unsigned char> pixels;
+	/* Palette changes seen while decoding this frame, applied when it
+	 * is shown.  Only entries [palette_start, palette_end) are valid.
+	 */
+	array<unsigned char, 768> palette;
+	unsigned palette_start, palette_end;
+	bool start_audio;
+	bool eof;
+};
+
+struct mve_decoder_state
+{
+	SDL_Thread *thread;
+	SDL_sem *free_slots, *ready;
+	MVESTREAM *mve;
+	std::atomic<bool> quit;
+	/* Only the worker touches head and current; only the main thread
+	 * touches tail.
+	 */
+	unsigned head, tail;
+	mve_frame *current;
+	array<mve_frame, MVE_FRAME_QUEUE> frames;
+};
+
+}
+
+static mve_decoder_state mve_decoder;
+
 static int16_t get_short(const unsigned char *data)
 {
 	short value;
@@ -397,9 +437,14 @@ static int create_audiobuf_handler(unsigned char, unsigned char minor, const uns
 	return 1;
 }
 
-static int play_audio_handler(unsigned char, unsigned char, const unsigned char *, int, void *)
+static void mve_audio_start()
 {
-	if (mve_audio_canplay  &&  !mve_audio_playing  &&  mve_audio_bufhead != mve_audio_buftail)
+	if (mve_decoder.thread)
+		SDL_LockAudio();
+	const bool start = mve_audio_canplay && !mve_audio_playing && mve_audio_bufhead != mve_audio_buftail;
+	if (mve_decoder.thread)
+		SDL_UnlockAudio();
+	if (start)
 	{
 		if (CGameArg.SndDisableSdlMixer)
 			SDL_PauseAudio(0);
@@ -409,6 +454,18 @@ static int play_audio_handler(unsigned char, unsigned char, const unsigned char
 #endif
 		mve_audio_playing = 1;
 	}
+}
+
+static int play_audio_handler(unsigned char, unsigned char, const unsigned char *, int, void *)
+{
+	/* Audio starts when the frame that carries this opcode is shown,
+	 * not when the worker reaches it, so that it stays in step with the
+	 * picture.
+	 */
+	if (const auto f = mve_decoder.current)
+		f->start_audio = true;
+	else
+		mve_audio_start();
 	return 1;
 }
 
@@ -419,7 +476,11 @@ static int audio_data_handler(unsigned char major, unsigned char, const unsigned
 	int nsamp;
 	if (mve_audio_canplay)
 	{
-		if (mve_audio_playing)
+		/* The worker races the callback even before playback starts,
+		 * since the main thread may start it at any time.
+		 */
+		const bool lock = mve_audio_playing || mve_decoder.current;
+		if (lock)
 			SDL_LockAudio();
 
 		chan = get_ushort(data + 2);
@@ -508,7 +569,7 @@ static int audio_data_handler(unsigned char major, unsigned char, const unsigned
 				con_printf(CON_CRITICAL, "d'oh!  buffer ring overrun (%d)", mve_audio_bufhead);
 		}
 
-		if (mve_audio_playing)
+		if (lock)
 			SDL_UnlockAudio();
 	}
 
@@ -584,7 +645,16 @@ static int create_videobuf_handler(unsigned char, unsigned char minor, const uns
 
 static int display_video_handler(unsigned char, unsigned char, const unsigned char *, int, void *)
 {
-	mve_showframe(g_vBackBuf1, g_destX, g_destY, g_width, g_height, g_screenWidth, g_screenHeight);
+	if (const auto f = mve_decoder.current)
+	{
+		/* g_vBackBuf1 is the reference for the next frame, so the
+		 * queued frame needs its own copy.
+		 */
+		const std::size_t size = g_width * g_height * (g_truecolor ? 2 : 1);
+		f->pixels.assign(g_vBackBuf1, g_vBackBuf1 + size);
+	}
+	else
+		mve_showframe(g_vBackBuf1, g_destX, g_destY, g_width, g_height, g_screenWidth, g_screenHeight);
 
 	g_frameUpdated = 1;
 
@@ -615,7 +685,24 @@ static int video_palette_handler(unsigned char, unsigned char, const unsigned ch
 	count = get_short(data+2);
 
 	auto p = data + 4;
-	mve_setpalette(p - 3*start, start, count);
+	if (const auto f = mve_decoder.current)
+	{
+		if (start < 0 || count <= 0 || start + count > 256)
+			return 1;
+		memcpy(&f->palette[3 * start], p, 3 * count);
+		if (f->palette_start == f->palette_end)
+		{
+			f->palette_start = start;
+			f->palette_end = start + count;
+		}
+		else
+		{
+			f->palette_start = std::min<unsigned>(f->palette_start, start);
+			f->palette_end = std::max<unsigned>(f->palette_end, start + count);
+		}
+	}
+	else
+		mve_setpalette(p - 3*start, start, count);
 	return 1;
 }
 
@@ -681,9 +768,79 @@ void MVE_palCallbacks(mve_cb_SetPalette setpalette)
 	mve_setpalette = setpalette;
 }
 
+static int mve_decoder_thread(void *)
+{
+	auto &d = mve_decoder;
+	for (int cont = 1; cont;)
+	{
+		SDL_SemWait(d.free_slots);
+		if (d.quit.load(std::memory_order_relaxed))
+			break;
+		auto &f = d.frames[d.head % MVE_FRAME_QUEUE];
+		f.palette_start = f.palette_end = 0;
+		f.start_audio = false;
+		d.current = &f;
+		while (cont && !g_frameUpdated)
+			cont = mve_play_next_chunk(*d.mve);
+		g_frameUpdated = 0;
+		f.eof = !cont;
+		++d.head;
+		SDL_SemPost(d.ready);
+	}
+	return 0;
+}
+
+static bool mve_decoder_start(MVESTREAM &mve)
+{
+	auto &d = mve_decoder;
+	if (!(d.free_slots = SDL_CreateSemaphore(MVE_FRAME_QUEUE)))
+		return false;
+	if (!(d.ready = SDL_CreateSemaphore(0)))
+	{
+		SDL_DestroySemaphore(exchange(d.free_slots, nullptr));
+		return false;
+	}
+	d.mve = &mve;
+	d.quit.store(false, std::memory_order_relaxed);
+	d.head = d.tail = 0;
+	/* Set before the thread exists, so that the handlers it runs see
+	 * it from the first chunk.  The main thread never calls them while
+	 * the worker runs.
+	 */
+	d.current = &d.frames[0];
+#if SDL_MAJOR_VERSION == 2
+	d.thread = SDL_CreateThread(mve_decoder_thread, "mve_decoder", nullptr);
+#else
+	d.thread = SDL_CreateThread(mve_decoder_thread, nullptr);
+#endif
+	if (!d.thread)
+	{
+		d.current = nullptr;
+		SDL_DestroySemaphore(exchange(d.free_slots, nullptr));
+		SDL_DestroySemaphore(exchange(d.ready, nullptr));
+		return false;
+	}
+	return true;
+}
+
+static void mve_decoder_stop()
+{
+	auto &d = mve_decoder;
+	if (!d.thread)
+		return;
+	d.quit.store(true, std::memory_order_relaxed);
+	SDL_SemPost(d.free_slots);
+	SDL_WaitThread(d.thread, nullptr);
+	d.thread = nullptr;
+	d.current = nullptr;
+	SDL_DestroySemaphore(exchange(d.free_slots, nullptr));
+	SDL_DestroySemaphore(exchange(d.ready, nullptr));
+}
+
 int MVE_rmPrepMovie(MVESTREAM_ptr_t &pMovie, void *src, int x, int y, int)
 {
 	if (pMovie) {
+		mve_decoder_stop();
 		mve_reset(pMovie.get());
 		return 0;
 	}
@@ -739,9 +896,32 @@ MVE_StepStatus MVE_rmStepMovie(MVESTREAM &mve)
 	if (!timer_started)
 		timer_start();
 
-	while (cont && !g_frameUpdated) // make a "step" be a frame, not a chunk...
-		cont = mve_play_next_chunk(mve);
-	g_frameUpdated = 0;
+	auto &d = mve_decoder;
+	if (d.thread || mve_decoder_start(mve))
+	{
+		SDL_SemWait(d.ready);
+		auto &f = d.frames[d.tail % MVE_FRAME_QUEUE];
+		cont = !f.eof;
+		if (cont)
+		{
+			if (f.palette_start != f.palette_end)
+				mve_setpalette(f.palette.data(), f.palette_start, f.palette_end - f.palette_start);
+			if (!f.pixels.empty())
+				mve_showframe(f.pixels.data(), g_destX, g_destY, g_width, g_height, g_screenWidth, g_screenHeight);
+			if (f.start_audio)
+				mve_audio_start();
+		}
+		++d.tail;
+		SDL_SemPost(d.free_slots);
+		if (!cont)
+			mve_decoder_stop();
+	}
+	else
+	{
+		while (cont && !g_frameUpdated) // make a "step" be a frame, not a chunk...
+			cont = mve_play_next_chunk(mve);
+		g_frameUpdated = 0;
+	}
 
 	if (!cont)
 		return MVE_StepStatus::EndOfFile;
@@ -758,6 +938,7 @@ MVE_StepStatus MVE_rmStepMovie(MVESTREAM &mve)
 
 void MVE_rmEndMovie(std::unique_ptr<MVESTREAM>)
 {
+	mve_decoder_stop();
 	timer_stop();
 	timer_created = 0;
 
@@ -217,6 +217,47 @@ std::size_t create_bfs_list(const vmobjptr_t robot, const vcsegidx_t start_seg,
 	return head;
 }
 
+namespace {
+
+//	The segments the guide-bot can reach from one segment.  The goal
+//	searches made while choosing a goal all start from the same segment,
+//	so they share one search for as long as the game time, the walls and
+//	the player's keys stay the same.
+struct escort_bfs_result
+{
+	fix64 time;
+	unsigned wall_generation;
+	objnum_t robot = object_none;
+	segnum_t start_seg = segment_none;
+	uint32_t powerup_flags;
+	std::size_t length;
+	array<segnum_t, MAX_SEGMENTS> list;
+	//	position of each segment in list, or UINT16_MAX if not reached
+	array<uint16_t, MAX_SEGMENTS> rank;
+};
+
+}
+
+static escort_bfs_result Escort_bfs;
+
+static const escort_bfs_result &escort_bfs(const vcsegidx_t start_seg, const player_flags powerup_flags)
+{
+	auto &b = Escort_bfs;
+	const objnum_t robot = Buddy_objnum;
+	if (b.time == GameTime64 && b.wall_generation == fcd_cache_generation() && b.robot == robot && b.start_seg == start_seg && b.powerup_flags == powerup_flags.get_player_flags())
+		return b;
+	b.time = GameTime64;
+	b.wall_generation = fcd_cache_generation();
+	b.robot = robot;
+	b.start_seg = start_seg;
+	b.powerup_flags = powerup_flags.get_player_flags();
+	b.length = create_bfs_list(vmobjptr(robot), start_seg, powerup_flags, b.list);
+	b.rank.fill(UINT16_MAX);
+	for (std::size_t i = 0; i != b.length; ++i)
+		b.rank[b.list[i]] = i;
+	return b;
+}
+
 //	-----------------------------------------------------------------------------
 //	Return true if ok for buddy to talk, else return false.
 //	Buddy is allowed to talk if the segment he is in does not contain a blastable wall that has not been blasted
@@ -544,33 +585,39 @@ static int get_boss_id(void)
 //	-----------------------------------------------------------------------------
 //	Return object index if object of objtype, objid exists in mine, else return -1
 //	"special" is used to find objects spewed by player which is hacked into flags field of powerup.
-static objnum_t exists_in_mine_2(const unique_segment &segp, const int objtype, const int objid, const int special)
+static bool escort_object_matches(const object_base &curobjp, const int objtype, const int objid, const int special)
 {
 	auto &Robot_info = LevelSharedRobotInfoState.Robot_info;
-	range_for (const auto curobjp, objects_in(segp, vcobjptridx, vcsegptr))
-	{
-		const auto &objnum = curobjp;
-			if (special == ESCORT_GOAL_PLAYER_SPEW && curobjp->type == OBJ_POWERUP)
+			if (special == ESCORT_GOAL_PLAYER_SPEW && curobjp.type == OBJ_POWERUP)
 			{
-				if (curobjp->flags & OF_PLAYER_DROPPED)
-					return objnum;
+				if (curobjp.flags & OF_PLAYER_DROPPED)
+					return true;
 			}
 
-			if (curobjp->type == objtype) {
+			if (curobjp.type == objtype) {
 				//	Don't find escort robots if looking for robot!
-				if ((curobjp->type == OBJ_ROBOT) && (Robot_info[get_robot_id(curobjp)].companion))
+				if ((curobjp.type == OBJ_ROBOT) && (Robot_info[get_robot_id(curobjp)].companion))
 					;
 				else if (objid == -1) {
-						return objnum;
-				} else if (curobjp->id == objid)
-					return objnum;
+						return true;
+				} else if (curobjp.id == objid)
+					return true;
 			}
 
-			if (objtype == OBJ_POWERUP && curobjp->type == OBJ_ROBOT)
-				if (curobjp->contains_count)
-					if (curobjp->contains_type == OBJ_POWERUP)
-						if (curobjp->contains_id == objid)
-							return objnum;
+			if (objtype == OBJ_POWERUP && curobjp.type == OBJ_ROBOT)
+				if (curobjp.contains_count)
+					if (curobjp.contains_type == OBJ_POWERUP)
+						if (curobjp.contains_id == objid)
+							return true;
+	return false;
+}
+
+static objnum_t exists_in_mine_2(const unique_segment &segp, const int objtype, const int objid, const int special)
+{
+	range_for (const auto curobjp, objects_in(segp, vcobjptridx, vcsegptr))
+	{
+		if (escort_object_matches(curobjp, objtype, objid, special))
+			return curobjp;
 	}
 	return object_none;
 }
@@ -578,11 +625,10 @@ static objnum_t exists_in_mine_2(const unique_segment &segp, const int objtype,
 //	-----------------------------------------------------------------------------
 static segnum_t exists_fuelcen_in_mine(const vcsegidx_t start_seg, const player_flags powerup_flags)
 {
-	array<segnum_t, MAX_SEGMENTS> bfs_list;
-	const auto length = create_bfs_list(vmobjptr(Buddy_objnum), start_seg, powerup_flags, bfs_list);
+	auto &bfs = escort_bfs(start_seg, powerup_flags);
 	auto predicate = [](const segnum_t &s) { return vcsegptr(s)->special == SEGMENT_IS_FUELCEN; };
 	{
-		const auto &&rb = partial_const_range(bfs_list, length);
+		const auto &&rb = partial_const_range(bfs.list, bfs.length);
 		auto i = std::find_if(rb.begin(), rb.end(), predicate);
 		if (i != rb.end())
 			return *i;
@@ -604,28 +650,31 @@ static segnum_t exists_fuelcen_in_mine(const vcsegidx_t start_seg, const player_
 //	-2 means object does exist in mine, but buddy-bot can't reach it (eg, behind triggered wall)
 static objnum_t exists_in_mine(const vcsegidx_t start_seg, const int objtype, const int objid, const int special, const player_flags powerup_flags)
 {
-	array<segnum_t, MAX_SEGMENTS> bfs_list;
-	const auto length = create_bfs_list(vmobjptr(Buddy_objnum), start_seg, powerup_flags, bfs_list);
-
-	range_for (const auto segnum, partial_const_range(bfs_list, length))
+	auto &bfs = escort_bfs(start_seg, powerup_flags);
+	/* One pass over the objects finds the reachable segment nearest in
+	 * the search which holds a match, instead of walking the object
+	 * list of every segment.  Robots can match by what they carry, so
+	 * no index by object type would answer this.
+	 */
+	unsigned best_rank = UINT16_MAX;
+	bool found = false;
+	range_for (const auto &&objp, vcobjptr)
 	{
-		const auto &&objnum = exists_in_mine_2(vcsegptr(segnum), objtype, objid, special);
-			if (objnum != object_none)
-				return objnum;
-
-		}
+		if (objp->type == OBJ_NONE || !escort_object_matches(objp, objtype, objid, special))
+			continue;
+		found = true;
+		const unsigned rank = bfs.rank[objp->segnum];
+		if (best_rank > rank)
+			best_rank = rank;
+	}
+	if (best_rank != UINT16_MAX)
+		//	Return the same object as a walk of that segment's list would.
+		return exists_in_mine_2(vcsegptr(bfs.list[best_rank]), objtype, objid, special);
 
 	//	Couldn't find what we're looking for by looking at connectivity.
-	//	See if it's in the mine.  It could be hidden behind a trigger or switch
+	//	It is in the mine, but could be hidden behind a trigger or switch
 	//	which the buddybot doesn't understand.
-	range_for (const auto &&segnum, vcsegptr)
-		{
-		const auto &&objnum = exists_in_mine_2(segnum, objtype, objid, special);
-			if (objnum != object_none)
-				return object_guidebot_cannot_reach;
-		}
-
-	return object_none;
+	return found ? object_guidebot_cannot_reach : object_none;
 }
 
 //	-----------------------------------------------------------------------------
@@ -212,10 +212,11 @@ static void MovieShowFrame(ubyte *buf, int dstx, int dsty, int bufw, int bufh, i
 #if DXX_USE_OGL
 	glDisable (GL_BLEND);
 
-	ogl_ubitblt_i(
-		bufw*scale, bufh*scale,
-		dstx, dsty,
-		bufw, bufh, 0, 0, source_bm, grd_curcanv->cv_bitmap, (GameCfg.MovieTexFilt)?OGL_TEXFILT_TRLINEAR:OGL_TEXFILT_CLASSIC);
+	if (!ogl_draw_movie_frame(buf, bufw, bufh, dstx, dsty, bufw*scale, bufh*scale, grd_curcanv->cv_bitmap, GameCfg.MovieTexFilt))
+		ogl_ubitblt_i(
+			bufw*scale, bufh*scale,
+			dstx, dsty,
+			bufw, bufh, 0, 0, source_bm, grd_curcanv->cv_bitmap, (GameCfg.MovieTexFilt)?OGL_TEXFILT_TRLINEAR:OGL_TEXFILT_CLASSIC);
 
 	glEnable (GL_BLEND);
 #else
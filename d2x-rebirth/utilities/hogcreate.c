@@ -14,6 +14,7 @@
 #include <conf.h>
 #endif
 
+#include <ctype.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -21,9 +22,166 @@
 #include <sys/stat.h>
 #include <fcntl.h>
 #include <dirent.h>
+#ifndef NO_ZLIB
+#include <zlib.h>
+#endif
 
 #define SWAPINT(x)   (((x)<<24) | (((unsigned)(x)) >> 24) | (((x) &0x0000ff00) << 8) | (((x) & 0x00ff0000) >> 8))
 
+/* The indexed format is described in common/include/hog2.h. */
+#define HOG2_HEADER_SIZE	16
+#define HOG2_ENTRY_SIZE	56
+#define HOG2_NAME_SIZE	32
+#define HOG2_METHOD_STORED	0
+#define HOG2_METHOD_DEFLATE	1
+
+struct hog2_member {
+	char name[HOG2_NAME_SIZE];
+	unsigned char *data;
+	unsigned long stored_size, size;
+	unsigned method;
+	unsigned long long offset;
+};
+
+static void put32(unsigned char *p, unsigned long v)
+{
+	p[0] = v;
+	p[1] = v >> 8;
+	p[2] = v >> 16;
+	p[3] = v >> 24;
+}
+
+/* Must order names as hog2_compare_name does. */
+static int compare_name(const char *a, const char *b)
+{
+	int ua, ub;
+	for (;; a++, b++) {
+		ua = toupper((unsigned char)*a);
+		ub = toupper((unsigned char)*b);
+		if (ua != ub)
+			return ua < ub ? -1 : 1;
+		if (!ua)
+			return 0;
+	}
+}
+
+static int compare_members(const void *a, const void *b)
+{
+	return compare_name(((const struct hog2_member *)a)->name, ((const struct hog2_member *)b)->name);
+}
+
+static int create_hog2(const char *hogname, int compress_members, unsigned long alignment)
+{
+	FILE *hogfile, *readfile;
+	DIR *dp;
+	struct dirent *ep;
+	struct stat statbuf;
+	struct hog2_member *members = NULL, *m;
+	unsigned count = 0, i;
+	unsigned long long position;
+	unsigned char entry[HOG2_ENTRY_SIZE];
+	static const unsigned char zeroes[4096];
+
+	dp = opendir("./");
+	if (dp == NULL) {
+		fprintf(stderr, "error: cannot read the current directory\n");
+		return 1;
+	}
+	while ((ep = readdir(dp))) {
+		if (!strcmp(ep->d_name, hogname) || stat(ep->d_name, &statbuf) || !S_ISREG(statbuf.st_mode))
+			continue;
+		if (strlen(ep->d_name) >= HOG2_NAME_SIZE) {
+			fprintf(stderr, "error: filename %s too long! (%i chars max!)\n", ep->d_name, HOG2_NAME_SIZE - 1);
+			return 1;
+		}
+		members = realloc(members, (count + 1) * sizeof(*members));
+		m = &members[count++];
+		memset(m->name, 0, sizeof(m->name));
+		strcpy(m->name, ep->d_name);
+		m->size = m->stored_size = statbuf.st_size;
+		m->method = HOG2_METHOD_STORED;
+		m->data = malloc(m->size ? m->size : 1);
+		readfile = fopen(m->name, "rb");
+		if (!m->data || !readfile || (m->size && fread(m->data, m->size, 1, readfile) != 1)) {
+			fprintf(stderr, "error: cannot read %s\n", m->name);
+			return 1;
+		}
+		fclose(readfile);
+#ifdef NO_ZLIB
+		(void)compress_members;
+#else
+		if (compress_members && m->size) {
+			uLongf packed_size = compressBound(m->size);
+			unsigned char *packed = malloc(packed_size);
+			/* Keep the member stored unless compressing saves space. */
+			if (packed && compress2(packed, &packed_size, m->data, m->size, Z_BEST_COMPRESSION) == Z_OK && packed_size < m->size) {
+				free(m->data);
+				m->data = packed;
+				m->stored_size = packed_size;
+				m->method = HOG2_METHOD_DEFLATE;
+			} else
+				free(packed);
+		}
+#endif
+	}
+	closedir(dp);
+	qsort(members, count, sizeof(*members), compare_members);
+	for (i = 1; i < count; i++)
+		if (!compare_name(members[i - 1].name, members[i].name)) {
+			fprintf(stderr, "error: %s and %s differ only in case\n", members[i - 1].name, members[i].name);
+			return 1;
+		}
+
+	hogfile = fopen(hogname, "wb");
+	if (hogfile == NULL) {
+		fprintf(stderr, "error: cannot create %s\n", hogname);
+		return 1;
+	}
+	printf("Creating: %s\n", hogname);
+	memcpy(entry, "DHG2", 4);
+	put32(entry + 4, 2);
+	put32(entry + 8, count);
+	put32(entry + 12, alignment);
+	fwrite(entry, HOG2_HEADER_SIZE, 1, hogfile);
+	position = HOG2_HEADER_SIZE + (unsigned long long)count * HOG2_ENTRY_SIZE;
+	for (i = 0; i < count; i++) {
+		m = &members[i];
+		position = (position + alignment - 1) & ~(unsigned long long)(alignment - 1);
+		m->offset = position;
+		position += m->stored_size;
+		memset(entry, 0, sizeof(entry));
+		memcpy(entry, m->name, HOG2_NAME_SIZE);
+		put32(entry + 32, m->offset);
+		put32(entry + 36, m->offset >> 32);
+		put32(entry + 40, m->stored_size);
+		put32(entry + 44, m->size);
+		put32(entry + 48, m->method);
+		fwrite(entry, HOG2_ENTRY_SIZE, 1, hogfile);
+	}
+	position = HOG2_HEADER_SIZE + (unsigned long long)count * HOG2_ENTRY_SIZE;
+	for (i = 0; i < count; i++) {
+		m = &members[i];
+		while (position < m->offset) {
+			unsigned long long pad = m->offset - position;
+			if (pad > sizeof(zeroes))
+				pad = sizeof(zeroes);
+			fwrite(zeroes, pad, 1, hogfile);
+			position += pad;
+		}
+		printf("Filename: %s \tLength: %lu\tStored: %lu\n", m->name, m->size, m->stored_size);
+		if (m->stored_size)
+			fwrite(m->data, m->stored_size, 1, hogfile);
+		position += m->stored_size;
+		free(m->data);
+	}
+	free(members);
+	if (fclose(hogfile)) {
+		fprintf(stderr, "error: cannot write %s\n", hogname);
+		return 1;
+	}
+	return 0;
+}
+
 int
 main(int argc, char *argv[])
 {
@@ -34,12 +192,41 @@ main(int argc, char *argv[])
 	char *buf;
 	struct stat statbuf;
 	int tmp;
+	int indexed = 0, compress_members = 0;
+	unsigned long alignment = 16;
 
+	for (; argc > 2 && argv[1][0] == '-'; argc--, argv++) {
+		if (!strcmp(argv[1], "-2"))
+			indexed = 1;
+#ifndef NO_ZLIB
+		else if (!strcmp(argv[1], "-z"))
+			indexed = compress_members = 1;
+#endif
+		else if (!strcmp(argv[1], "-a") && argc > 3) {
+			alignment = strtoul(argv[2], NULL, 0);
+			if (!alignment || (alignment & (alignment - 1))) {
+				fprintf(stderr, "error: alignment must be a power of two\n");
+				return 1;
+			}
+			indexed = 1;
+			argc--;
+			argv++;
+		} else
+			break;
+	}
 	if (argc != 2) {
-		printf("Usage: hogcreate hogfile\n"
-		       "creates hogfile using all the files in the current directory\n");
+		printf("Usage: hogcreate [-2] [-z] [-a alignment] hogfile\n"
+		       "creates hogfile using all the files in the current directory\n"
+		       "Options:\n"
+		       "  -2            write an indexed HOG, which only DXX-Rebirth reads\n"
+#ifndef NO_ZLIB
+		       "  -z            write an indexed HOG, compressing members where it saves space\n"
+#endif
+		       "  -a alignment  write an indexed HOG, aligning each member (default 16)\n");
 		exit(0);
 	}
+	if (indexed)
+		return create_hog2(argv[1], compress_members, alignment);
 	hogfile = fopen(argv[1], "wb");
 	buf = (char *)malloc(3);
 	strncpy(buf, "DHF", 3);
@@ -20,9 +20,90 @@
 #include <sys/types.h>
 #include <sys/stat.h>
 #include <fcntl.h>
+#ifndef NO_ZLIB
+#include <zlib.h>
+#endif
 
 #define SWAPINT(x)   (((x)<<24) | (((unsigned)(x)) >> 24) | (((x) &0x0000ff00) << 8) | (((x) & 0x00ff0000) >> 8))
 
+/* The indexed format is described in common/include/hog2.h. */
+#define HOG2_HEADER_SIZE	16
+#define HOG2_ENTRY_SIZE	56
+#define HOG2_NAME_SIZE	32
+#define HOG2_METHOD_STORED	0
+#define HOG2_METHOD_DEFLATE	1
+
+static unsigned long get32(const unsigned char *p)
+{
+	return p[0] | (p[1] << 8) | ((unsigned long)p[2] << 16) | ((unsigned long)p[3] << 24);
+}
+
+static int extract_hog2(FILE *hogfile, const char *only, int v)
+{
+	unsigned char header[HOG2_HEADER_SIZE], *directory, *entry, *buf, *data;
+	char filename[HOG2_NAME_SIZE];
+	unsigned long count, i, stored_size, size, method;
+	unsigned long long offset;
+	FILE *writefile;
+
+	if (fread(header, sizeof(header), 1, hogfile) != 1 || get32(header + 4) != 2) {
+		fprintf(stderr, "error: unknown version of indexed HOG\n");
+		return 1;
+	}
+	count = get32(header + 8);
+	directory = malloc(count * HOG2_ENTRY_SIZE + 1);
+	if (directory == NULL || (count && fread(directory, count * HOG2_ENTRY_SIZE, 1, hogfile) != 1)) {
+		fprintf(stderr, "error: cannot read the directory\n");
+		return 1;
+	}
+	for (i = 0; i < count; i++) {
+		entry = directory + i * HOG2_ENTRY_SIZE;
+		memcpy(filename, entry, HOG2_NAME_SIZE);
+		filename[HOG2_NAME_SIZE - 1] = 0;
+		offset = get32(entry + 32) | ((unsigned long long)get32(entry + 36) << 32);
+		stored_size = get32(entry + 40);
+		size = get32(entry + 44);
+		method = get32(entry + 48);
+		if (only && strcmp(only, filename))
+			continue;
+		printf("Filename: %s \tLength: %lu\tStored: %lu\n", filename, size, stored_size);
+		if (v)
+			continue;
+		buf = malloc(stored_size + 1);
+		if (buf == NULL || fseek(hogfile, offset, SEEK_SET) || (stored_size && fread(buf, stored_size, 1, hogfile) != 1)) {
+			fprintf(stderr, "error: cannot read %s\n", filename);
+			return 1;
+		}
+		data = buf;
+		if (method == HOG2_METHOD_DEFLATE) {
+#ifdef NO_ZLIB
+			fprintf(stderr, "error: %s is compressed, and this hogextract has no zlib\n", filename);
+			return 1;
+#else
+			uLongf inflated_size = size;
+			data = malloc(size + 1);
+			if (data == NULL || uncompress(data, &inflated_size, buf, stored_size) != Z_OK || inflated_size != size) {
+				fprintf(stderr, "error: cannot inflate %s\n", filename);
+				return 1;
+			}
+			free(buf);
+#endif
+		} else if (method != HOG2_METHOD_STORED) {
+			fprintf(stderr, "error: %s uses unknown method %lu\n", filename, method);
+			return 1;
+		}
+		writefile = fopen(filename, "wb");
+		if (writefile == NULL || (size && fwrite(data, size, 1, writefile) != 1) || fclose(writefile)) {
+			fprintf(stderr, "error: cannot write %s\n", filename);
+			return 1;
+		}
+		free(data);
+	}
+	free(directory);
+	fclose(hogfile);
+	return 0;
+}
+
 int
 main(int argc, char *argv[])
 {
@@ -49,10 +130,16 @@ main(int argc, char *argv[])
 	hogfile = fopen(argv[1], "rb");
 	stat(argv[1], &statbuf);
 	printf("%i\n", (int)statbuf.st_size);
-	buf = (char *)malloc(3);
-	fread(buf, 3, 1, hogfile);
+	buf = (char *)malloc(4);
+	fread(buf, 4, 1, hogfile);
 	printf("Extracting from: %s\n", argv[1]);
+	if (!memcmp(buf, "DHG2", 4)) {
+		free(buf);
+		rewind(hogfile);
+		return extract_hog2(hogfile, argc > 2 ? argv[2] : NULL, v);
+	}
 	free(buf);
+	fseek(hogfile, 3, SEEK_SET);
 	while(ftell(hogfile)<statbuf.st_size) {
 		fread(filename, 13, 1, hogfile);
 		fread(&len, 1, 4, hogfile);
@@ -44,7 +44,9 @@ COPYRIGHT 1993-1999 PARALLAX SOFTWARE CORPORATION.  ALL RIGHTS RESERVED.
 #include "gamefont.h"
 #include "byteutil.h"
 #include "console.h"
+#include "profile.h"
 #include "config.h"
+#include "hash.h"
 #if DXX_USE_OGL
 #include "ogl_init.h"
 #endif
@@ -82,15 +84,26 @@ static array<grs_font *, MAX_OPEN_FONTS> open_font;
 static int gr_internal_string_clipped(grs_canvas &, const grs_font &cv_font, int x, int y, const char *s);
 static int gr_internal_string_clipped_m(grs_canvas &, const grs_font &cv_font, int x, int y, const char *s);
 
-static const uint8_t *find_kern_entry(const grs_font &font, const uint8_t first, const uint8_t second)
+static std::size_t font_nchars(const grs_font &font)
 {
-	auto p = font.ft_kerndata;
+	return font.ft_maxchar - font.ft_minchar + 1;
+}
 
-	while (*p != kerndata_terminator)
-		if (p[0]==first && p[1]==second)
-			return p;
-		else p+=3;
-	return NULL;
+static void build_kern_table(grs_font &font)
+{
+	const auto nchars = font_nchars(font);
+	auto &table = font.ft_kerntable;
+	table = make_unique<uint16_t[]>(nchars * nchars);
+	std::fill_n(table.get(), nchars * nchars, UINT16_MAX);
+	for (auto p = font.ft_kerndata; *p != kerndata_terminator; p += 3)
+	{
+		if (p[0] >= nchars || p[1] >= nchars)
+			continue;
+		auto &k = table[p[0] * nchars + p[1]];
+		/* The first matching triplet is the one that applies */
+		if (k == UINT16_MAX)
+			k = p[2];
+	}
 }
 
 //takes the character AFTER being offset into font
@@ -153,9 +166,9 @@ static get_char_width_result<T> get_char_width(const grs_font &cv_font, const ui
 			const unsigned letter2 = c2 - cv_font.ft_minchar;
 
 			if (INFONT(letter2)) {
-				const auto p = find_kern_entry(cv_font, letter, letter2);
-				if (p)
-					return {width, static_cast<T>(fontscale_x(p[2]))};
+				const auto k = cv_font.ft_kerntable[letter * font_nchars(cv_font) + letter2];
+				if (k != UINT16_MAX)
+					return {width, static_cast<T>(fontscale_x(k))};
 			}
 		}
 	}
@@ -676,7 +689,7 @@ static int ogl_internal_string(grs_canvas &canvas, const grs_font &cv_font, cons
 				? cv_font.ft_widths[letter]
 				: cv_font.ft_w;
 
-			ogl_ubitmapm_cs(canvas, xx, yy, fontscale_x(ft_w), FONTSCALE_Y_ft_h, cv_font.ft_bitmaps[letter], (cv_font.ft_flags & FT_COLOR) ? colors.white : (canvas.cv_bitmap.get_type() == bm_mode::ogl) ? colors.init(canvas.cv_font_fg_color) : throw std::runtime_error("non-color string to non-ogl dest"), F1_0);
+			ogl_ubitmapm_cs_batched(canvas, xx, yy, fontscale_x(ft_w), FONTSCALE_Y_ft_h, cv_font.ft_bitmaps[letter], (cv_font.ft_flags & FT_COLOR) ? colors.white : (canvas.cv_bitmap.get_type() == bm_mode::ogl) ? colors.init(canvas.cv_font_fg_color) : throw std::runtime_error("non-color string to non-ogl dest"));
 
 			xx += spacing;
 
@@ -776,6 +789,33 @@ void gr_get_string_size(const grs_font &cv_font, const char *s, int *const strin
 	gr_get_string_size(cv_font, s, string_width, string_height, average_width, UINT_MAX);
 }
 
+/* Return the cache slot for s.  If its text is empty, the caller must
+ * measure s and fill it in.
+ */
+static grs_font_size_cache::entry *find_string_size(const grs_font &cv_font, const char *const s, const float scale, const unsigned max_chars_per_line)
+{
+	const auto len = strlen(s);
+	if (!len || len >= grs_font_size_cache::max_text)
+		return nullptr;
+	auto &cache = cv_font.ft_size_cache;
+	if (!cache)
+	{
+		cache = make_unique<grs_font_size_cache>();
+		range_for (auto &e, cache->entries)
+			e.text[0] = 0;
+	}
+	fnv1a_hash h;
+	h.add(s, len);
+	auto &e = cache->entries[h.get() % cache->entries.size()];
+	if (e.scale != scale || e.max_chars_per_line != max_chars_per_line || memcmp(e.text.data(), s, len + 1))
+	{
+		e.scale = scale;
+		e.max_chars_per_line = max_chars_per_line;
+		e.text[0] = 0;
+	}
+	return &e;
+}
+
 void gr_get_string_size(const grs_font &cv_font, const char *s, int *const string_width, int *const string_height, int *const average_width, const unsigned max_chars_per_line)
 {
 	float longest_width=0.0,string_width_f=0.0;
@@ -784,8 +824,17 @@ void gr_get_string_size(const grs_font &cv_font, const char *s, int *const strin
 		*average_width = cv_font.ft_w;
 	if (!string_width && !string_height)
 		return;
+	grs_font_size_cache::entry *cached = nullptr;
 	if (s)
+		cached = find_string_size(cv_font, s, FNTScaleX.operator float(), max_chars_per_line);
+	if (cached && cached->text[0])
 	{
+		string_width_f = cached->width;
+		lines = cached->lines;
+	}
+	else if (s)
+	{
+		const auto text = s;
 		unsigned remaining_chars_this_line = max_chars_per_line;
 		while (*s)
 		{
@@ -811,6 +860,13 @@ void gr_get_string_size(const grs_font &cv_font, const char *s, int *const strin
 			if (!--remaining_chars_this_line)
 				break;
 		}
+		string_width_f = std::max(longest_width, string_width_f);
+		if (cached)
+		{
+			cached->width = string_width_f;
+			cached->lines = lines;
+			strcpy(cached->text.data(), text);
+		}
 	}
 	if (string_width)
 		*string_width = std::max(longest_width, string_width_f);
@@ -1001,6 +1057,7 @@ static std::unique_ptr<grs_font> gr_internal_init_font(const char *fontname)
 				break;
 		}
 		font->ft_kerndata = begin_kerndata;
+		build_kern_table(*font);
 	}
 	else
 		font->ft_kerndata = nullptr;
@@ -1034,6 +1091,7 @@ static std::unique_ptr<grs_font> gr_internal_init_font(const char *fontname)
 
 grs_font_ptr gr_init_font(grs_canvas &canvas, const char *fontname)
 {
+	const trace_scope trace_phase("gr_init_font", fontname);
 	auto font = gr_internal_init_font(fontname);
 	if (!font)
 		return {};
@@ -25,6 +25,8 @@ COPYRIGHT 1993-1998 PARALLAX SOFTWARE CORPORATION.  ALL RIGHTS RESERVED.
 #include <stdlib.h>
 #include <stdio.h>
 #include <string.h>
+#include <algorithm>
+#include <string>
 
 #include "gr.h"
 #include "grdef.h"
@@ -68,33 +70,6 @@ struct PCXHeader
 
 #define PCXHEADER_SIZE 128
 
-/*
- * reads n PCXHeader structs from a PHYSFS_File
- */
-static int PCXHeader_read_n(PCXHeader *ph, int n, PHYSFS_File *fp)
-{
-	int i;
-
-	for (i = 0; i < n; i++) {
-		ph->Manufacturer = PHYSFSX_readByte(fp);
-		ph->Version = PHYSFSX_readByte(fp);
-		ph->Encoding = PHYSFSX_readByte(fp);
-		ph->BitsPerPixel = PHYSFSX_readByte(fp);
-		ph->Xmin = PHYSFSX_readShort(fp);
-		ph->Ymin = PHYSFSX_readShort(fp);
-		ph->Xmax = PHYSFSX_readShort(fp);
-		ph->Ymax = PHYSFSX_readShort(fp);
-		ph->Hdpi = PHYSFSX_readShort(fp);
-		ph->Vdpi = PHYSFSX_readShort(fp);
-		PHYSFS_read(fp, &ph->ColorMap, 16*3, 1);
-		ph->Reserved = PHYSFSX_readByte(fp);
-		ph->Nplanes = PHYSFSX_readByte(fp);
-		ph->BytesPerLine = PHYSFSX_readShort(fp);
-		PHYSFS_read(fp, &ph->filler, 60, 1);
-	}
-	return i;
-}
-
 }
 
 #if defined(DXX_BUILD_DESCENT_I)
@@ -191,38 +166,45 @@ int bald_guy_load(const char *const filename, grs_bitmap *const bmp, palette_arr
 
 namespace dcx {
 
-struct PCX_PHYSFS_file
+namespace {
+
+/* Title, briefing and score screens are shown again and again, so the
+ * last few decoded screens are kept.  The key includes the directory the
+ * file came from, so that a mission which replaces a screen does not see
+ * the copy from another hog.
+ */
+struct pcx_cache_entry
 {
-	RAIIPHYSFS_File PCXfile;
+	std::string name;
+	unsigned last_use;
+	uint16_t w, h;
+	bool have_palette;
+	RAIIdmem<uint8_t[]> pixels;
+	palette_array_t palette;
 };
 
-static int pcx_read_bitmap_file(struct PCX_PHYSFS_file *const pcxphysfs, grs_main_bitmap &bmp, bm_mode bitmap_type, palette_array_t &palette);
-
-int pcx_read_bitmap(const char *const filename, grs_main_bitmap &bmp, palette_array_t &palette)
-{
-	int result;
-	PCX_PHYSFS_file pcxphysfs{PHYSFSX_openReadBuffered(filename)};
-	if (!pcxphysfs.PCXfile)
-		return PCX_ERROR_OPENING;
-	result = pcx_read_bitmap_file(&pcxphysfs, bmp, bm_mode::linear, palette);
-	return result;
-}
+constexpr unsigned pcx_cache_size = 6;
+static array<pcx_cache_entry, pcx_cache_size> pcx_cache;
+static unsigned pcx_cache_clock;
 
-static int PCX_PHYSFS_read(struct PCX_PHYSFS_file *pcxphysfs, ubyte *data, unsigned size)
+static std::string pcx_cache_key(const char *const filename)
 {
-	return PHYSFS_read(pcxphysfs->PCXfile, data, size, sizeof(*data));
+	std::string key(filename);
+	for (auto &c : key)
+		c = tolower(static_cast<unsigned char>(c));
+	key += '\0';
+	if (const auto realdir = PHYSFS_getRealDir(filename))
+		key += realdir;
+	return key;
 }
 
-static int pcx_read_bitmap_file(struct PCX_PHYSFS_file *const pcxphysfs, grs_main_bitmap &bmp, const bm_mode bitmap_type, palette_array_t &palette)
+static int pcx_decode(const uint8_t *p, const uint8_t *const e, pcx_cache_entry &entry)
 {
 	PCXHeader header;
-	int i, row, col, count, xsize, ysize;
-	ubyte data;
-
-	// read 128 char PCX header
-	if (PCXHeader_read_n( &header, 1, pcxphysfs->PCXfile )!=1) {
+	if (e - p < PCXHEADER_SIZE)
 		return PCX_ERROR_NO_HEADER;
-	}
+	memcpy(&header, p, sizeof(header));
+	p += PCXHEADER_SIZE;
 
 	// Is it a 256 color PCX file?
 	if ((header.Manufacturer != 10)||(header.Encoding != 1)||(header.Nplanes != 1)||(header.BitsPerPixel != 8)||(header.Version != 5))	{
@@ -230,74 +212,134 @@ static int pcx_read_bitmap_file(struct PCX_PHYSFS_file *const pcxphysfs, grs_mai
 	}
 
 	// Find the size of the image
-	xsize = header.Xmax - header.Xmin + 1;
-	ysize = header.Ymax - header.Ymin + 1;
-
-	if ( bitmap_type == bm_mode::linear )	{
-		if ( bmp.bm_data == NULL )	{
-			gr_init_bitmap_alloc(bmp, bitmap_type, 0, 0, xsize, ysize, xsize);
-		}
-	}
-
-	if (bmp.get_type() == bm_mode::linear)
+	const int xsize = INTEL_SHORT(header.Xmax) - INTEL_SHORT(header.Xmin) + 1;
+	const int ysize = INTEL_SHORT(header.Ymax) - INTEL_SHORT(header.Ymin) + 1;
+	if (xsize <= 0 || ysize <= 0)
+		return PCX_ERROR_WRONG_VERSION;
+	entry.w = xsize;
+	entry.h = ysize;
+	MALLOC(entry.pixels, uint8_t[], xsize * ysize);
+	if (!entry.pixels)
+		return PCX_ERROR_MEMORY;
+
+	auto pixdata = entry.pixels.get();
+	for (int row = 0; row < ysize; ++row)
 	{
-		for (row=0; row< ysize ; row++)      {
-			auto pixdata = &bmp.get_bitmap_data()[bmp.bm_rowsize*row];
-			for (col=0; col< xsize ; )      {
-				if (PCX_PHYSFS_read(pcxphysfs, &data, 1) != 1)	{
+		// A run never continues onto the next line
+		for (int col = 0; col < xsize;)
+		{
+			if (p == e)
+				return PCX_ERROR_READING;
+			auto data = *p++;
+			if ((data & 0xC0) == 0xC0)
+			{
+				const int count = std::min(data & 0x3F, xsize - col);
+				if (p == e)
 					return PCX_ERROR_READING;
-				}
-				if ((data & 0xC0) == 0xC0)     {
-					count =  data & 0x3F;
-					if (PCX_PHYSFS_read(pcxphysfs, &data, 1) != 1)	{
-						return PCX_ERROR_READING;
-					}
-					memset( pixdata, data, count );
-					pixdata += count;
-					col += count;
-				} else {
-					*pixdata++ = data;
-					col++;
-				}
+				data = *p++;
+				memset(pixdata, data, count);
+				pixdata += count;
+				col += count;
 			}
-		}
-	} else {
-		for (row=0; row< ysize ; row++)      {
-			for (col=0; col< xsize ; )      {
-				if (PCX_PHYSFS_read(pcxphysfs, &data, 1) != 1)	{
-					return PCX_ERROR_READING;
-				}
-				if ((data & 0xC0) == 0xC0)     {
-					count =  data & 0x3F;
-					if (PCX_PHYSFS_read(pcxphysfs, &data, 1) != 1)	{
-						return PCX_ERROR_READING;
-					}
-					for (i=0;i<count;i++)
-						gr_bm_pixel(*grd_curcanv, bmp, col+i, row, data);
-					col += count;
-				} else {
-					gr_bm_pixel(*grd_curcanv, bmp, col, row, data);
-					col++;
-				}
+			else
+			{
+				*pixdata++ = data;
+				++col;
 			}
 		}
 	}
 
 	// Read the extended palette at the end of PCX file
-		// Read in a character which should be 12 to be extended palette file
-		if (PCX_PHYSFS_read(pcxphysfs, &data, 1) == 1)	{
-			if ( data == 12 )	{
-				if (PCX_PHYSFS_read(pcxphysfs, reinterpret_cast<ubyte *>(&palette[0]), palette.size() * sizeof(palette[0])) != 1)	{
-					return PCX_ERROR_READING;
-				}
-				diminish_palette(palette);
-			}
-		} else {
-			return PCX_ERROR_NO_PALETTE;
+	// Read in a character which should be 12 to be extended palette file
+	if (p == e)
+		return PCX_ERROR_NO_PALETTE;
+	entry.have_palette = (*p++ == 12);
+	if (entry.have_palette)
+	{
+		if (static_cast<std::size_t>(e - p) < entry.palette.size() * sizeof(entry.palette[0]))
+			return PCX_ERROR_READING;
+		copy_diminish_palette(entry.palette, p);
+	}
+	return PCX_ERROR_NONE;
+}
+
+static int pcx_cache_lookup(const char *const filename, const pcx_cache_entry *&result)
+{
+	auto key = pcx_cache_key(filename);
+	const auto use = ++pcx_cache_clock;
+	auto victim = &pcx_cache[0];
+	range_for (auto &i, pcx_cache)
+	{
+		if (i.pixels && i.name == key)
+		{
+			i.last_use = use;
+			result = &i;
+			return PCX_ERROR_NONE;
 		}
+		if (!i.pixels || (victim->pixels && use - i.last_use > use - victim->last_use))
+			victim = &i;
+	}
+	auto PCXfile = PHYSFSX_openReadBuffered(filename);
+	if (!PCXfile)
+		return PCX_ERROR_OPENING;
+	const auto fsize = PHYSFS_fileLength(PCXfile);
+	if (fsize < 0)
+		return PCX_ERROR_READING;
+	/* One read of the whole file is much cheaper than the byte at a time
+	 * reads the decoder would otherwise make.
+	 */
+	RAIIdmem<uint8_t[]> file;
+	MALLOC(file, uint8_t[], fsize ? fsize : 1);
+	if (!file)
+		return PCX_ERROR_MEMORY;
+	if (PHYSFS_read(PCXfile, file.get(), 1, fsize) != fsize)
+		return PCX_ERROR_READING;
+	PCXfile.reset();
+	victim->pixels.reset();
+	if (const auto r = pcx_decode(file.get(), file.get() + fsize, *victim))
+	{
+		victim->pixels.reset();
+		return r;
+	}
+	victim->name = std::move(key);
+	victim->last_use = use;
+	result = victim;
 	return PCX_ERROR_NONE;
 }
 
+}
+
+int pcx_read_bitmap(const char *const filename, grs_main_bitmap &bmp, palette_array_t &palette)
+{
+	const pcx_cache_entry *entry;
+	if (const auto r = pcx_cache_lookup(filename, entry))
+		return r;
+	const unsigned xsize = entry->w, ysize = entry->h;
+	if (bmp.bm_data == NULL)
+		gr_init_bitmap_alloc(bmp, bm_mode::linear, 0, 0, xsize, ysize, xsize);
+	const auto src = entry->pixels.get();
+	if (bmp.get_type() == bm_mode::linear)
+	{
+		for (unsigned row = 0; row != ysize; ++row)
+			memcpy(&bmp.get_bitmap_data()[bmp.bm_rowsize * row], &src[xsize * row], xsize);
+	}
+	else
+	{
+		for (unsigned row = 0; row != ysize; ++row)
+			for (unsigned col = 0; col != xsize; ++col)
+				gr_bm_pixel(*grd_curcanv, bmp, col, row, src[xsize * row + col]);
+	}
+	if (entry->have_palette)
+		palette = entry->palette;
+	return PCX_ERROR_NONE;
+}
+
+void pcx_preload(const char *const filename)
+{
+	const pcx_cache_entry *entry;
+	pcx_cache_lookup(filename, entry);
+}
+
 #if !DXX_USE_OGL && DXX_USE_SCREENSHOT_FORMAT_LEGACY
 int pcx_write_bitmap(PHYSFS_File *const PCXfile, const grs_bitmap *const bmp, palette_array_t &palette)
 {
@@ -11,6 +11,8 @@
  *
  */
 
+#include <algorithm>
+#include <cmath>
 #include <stdexcept>
 #include <stdlib.h>
 #include "dxxsconf.h"
@@ -24,6 +26,11 @@
 #include "byteutil.h"
 #include "u_mem.h"
 
+#include "compiler-exchange.h"
+#include "compiler-make_unique.h"
+#include "compiler-range_for.h"
+#include "partial_range.h"
+
 namespace dcx {
 
 constexpr std::integral_constant<unsigned, 0> OP_EOF{};   //eof
@@ -70,8 +77,7 @@ static inline int16_t w(const uint8_t *p)
 
 static void rotate_point_list(g3s_point *dest, const vms_vector *src, uint_fast32_t n)
 {
-	while (n--)
-		g3_rotate_point(*dest++,*src++);
+	g3_rotate_points(dest, src, n);
 }
 
 constexpr vms_angvec zero_angles = {0,0,0};
@@ -736,6 +742,70 @@ void g3_draw_polygon_model(grs_bitmap *const *const model_bitmaps, polygon_model
 	iterate_polymodel(p, state);
 }
 
+static void draw_polygon_model_ops(const polymodel_draw_list &list, const uint32_t begin, const uint32_t end, grs_bitmap *const *const model_bitmaps, polygon_model_points &Interp_point_list, grs_canvas &canvas, const submodel_angles anim_angles, const g3s_lrgb model_light, const glow_values_t *const glow_values)
+{
+	/* Each range is one call of the interpreter, so it starts with
+	 * glow off.
+	 */
+	g3_draw_polygon_model_state state(model_bitmaps, Interp_point_list, canvas, anim_angles, model_light, glow_values);
+	for (auto i = begin; i != end;)
+	{
+		auto &o = list.ops[i];
+		const auto p = o.p;
+		switch (o.type)
+		{
+			case polymodel_draw_list::op_type::defpoints:
+				state.op_defpoints(p, o.count);
+				break;
+			case polymodel_draw_list::op_type::defp_start:
+				state.op_defp_start(p, o.count);
+				break;
+			case polymodel_draw_list::op_type::flatpoly:
+				state.op_flatpoly(p, o.count);
+				break;
+			case polymodel_draw_list::op_type::tmappoly:
+				state.op_tmappoly(p, o.count);
+				break;
+			case polymodel_draw_list::op_type::sortnorm:
+				if (g3_check_normal_facing(*vp(p + 16), *vp(p + 4)) > 0)
+				{
+					//draw back then front
+					draw_polygon_model_ops(list, i + 1, o.split, model_bitmaps, Interp_point_list, canvas, anim_angles, model_light, glow_values);
+					draw_polygon_model_ops(list, o.split, o.end, model_bitmaps, Interp_point_list, canvas, anim_angles, model_light, glow_values);
+				}
+				else
+				{
+					draw_polygon_model_ops(list, o.split, o.end, model_bitmaps, Interp_point_list, canvas, anim_angles, model_light, glow_values);
+					draw_polygon_model_ops(list, i + 1, o.split, model_bitmaps, Interp_point_list, canvas, anim_angles, model_light, glow_values);
+				}
+				i = o.end;
+				continue;
+			case polymodel_draw_list::op_type::rodbm:
+				state.op_rodbm(p);
+				break;
+			case polymodel_draw_list::op_type::subcall:
+				g3_start_instance_angles(*vp(p + 4), anim_angles ? anim_angles[w(p + 2)] : zero_angles);
+				/* A submodel entirely outside the view is skipped.  No
+				 * other submodel uses the points that it defines.
+				 */
+				if (o.split == UINT32_MAX || g3_check_sphere_visible(list.spheres[o.split].center, list.spheres[o.split].radius))
+					draw_polygon_model_ops(list, i + 1, o.end, model_bitmaps, Interp_point_list, canvas, anim_angles, model_light, glow_values);
+				g3_done_instance();
+				i = o.end;
+				continue;
+			case polymodel_draw_list::op_type::glow:
+				state.op_glow(p);
+				break;
+		}
+		++i;
+	}
+}
+
+void g3_draw_polygon_model(const polymodel_draw_list &list, grs_bitmap *const *const model_bitmaps, polygon_model_points &Interp_point_list, grs_canvas &canvas, const submodel_angles anim_angles, const g3s_lrgb model_light, const glow_values_t *const glow_values)
+{
+	draw_polygon_model_ops(list, 0, list.ops.size(), model_bitmaps, Interp_point_list, canvas, anim_angles, model_light, glow_values);
+}
+
 #ifndef NDEBUG
 static int nest_count;
 #endif
@@ -765,4 +835,386 @@ int16_t g3_init_polygon_model(void *model_ptr)
 	return init_model_sub(reinterpret_cast<uint8_t *>(model_ptr), -1);
 }
 
+namespace {
+
+/* The box around the points of one submodel frame, and around the
+ * spheres of the submodels it calls.  The sphere returned contains the
+ * box.
+ */
+class submodel_bounds
+{
+	vms_vector mn, mx;
+	bool empty = true;
+public:
+	/* Set if the frame draws points which it does not define, so no
+	 * bounds are known.
+	 */
+	bool unbounded = false;
+	bool has_points() const
+	{
+		return !empty;
+	}
+	void add_point(const vms_vector &p)
+	{
+		if (empty)
+		{
+			mn = mx = p;
+			empty = false;
+			return;
+		}
+		mn = {std::min(mn.x, p.x), std::min(mn.y, p.y), std::min(mn.z, p.z)};
+		mx = {std::max(mx.x, p.x), std::max(mx.y, p.y), std::max(mx.z, p.z)};
+	}
+	void add_sphere(const vms_vector &c, const fix r)
+	{
+		add_point({c.x - r, c.y - r, c.z - r});
+		add_point({c.x + r, c.y + r, c.z + r});
+	}
+	/* A called submodel turns about its offset, so its sphere is
+	 * widened to cover every angle.
+	 */
+	void add_subcall(const vms_vector &offset, const vms_vector &center, const fix radius)
+	{
+		if (radius)
+			add_sphere(offset, static_cast<fix>(vm_vec_mag(center)) + radius);
+	}
+	void get(vms_vector &center, fix &radius) const
+	{
+		if (empty)
+		{
+			center = {};
+			radius = 0;
+			return;
+		}
+		center = vm_vec_avg(mn, mx);
+		/* Round up, so that no point is outside. */
+		radius = static_cast<fix>(vm_vec_dist(mn, mx)) / 2 + 1;
+	}
+};
+
+class g3_build_mesh_state :
+	public interpreter_base
+{
+	polymodel_mesh &mesh;
+	array<vms_vector, MAX_POLYGON_VECS> &points;
+	uint8_t glow_num;
+	void define_points(const unsigned start, const vms_vector *const src, const unsigned n)
+	{
+		if (start + n > points.size())
+		{
+			supported = false;
+			return;
+		}
+		std::copy(src, src + n, &points[start]);
+	}
+public:
+	struct pending_subcall
+	{
+		const uint8_t *p;
+		polymodel_mesh::subcall s;
+	};
+	std::vector<pending_subcall> subcalls;
+	bool supported;
+	g3_build_mesh_state(polymodel_mesh &m, array<vms_vector, MAX_POLYGON_VECS> &pts) :
+		mesh(m), points(pts), glow_num(UINT8_MAX), supported(true)
+	{
+	}
+	void op_defpoints(const uint8_t *const p, const uint_fast32_t n)
+	{
+		define_points(0, vp(p + 4), n);
+	}
+	void op_defp_start(const uint8_t *const p, const uint_fast32_t n)
+	{
+		define_points(w(p + 4), vp(p + 8), n);
+	}
+	void op_flatpoly(const uint8_t *, uint_fast32_t)
+	{
+		supported = false;
+	}
+	void op_tmappoly(const uint8_t *const p, const uint_fast32_t nv)
+	{
+		if (nv > MAX_POINTS_PER_POLY)
+			return;
+		const auto first_vertex = mesh.vertices.size();
+		mesh.polygons.push_back({*vp(p + 4), *vp(p + 16), static_cast<uint16_t>(first_vertex), static_cast<uint8_t>(nv), static_cast<uint8_t>(w(p + 28)), exchange(glow_num, UINT8_MAX)});
+		const auto uvl_list = reinterpret_cast<const g3s_uvl *>(p + 30 + ((nv & ~1) + 1) * 2);
+		for (uint_fast32_t i = 0; i != nv; ++i)
+		{
+			const unsigned pt = wp(p + 30)[i];
+			if (pt >= points.size())
+			{
+				supported = false;
+				return;
+			}
+			mesh.vertices.push_back({points[pt], uvl_list[i].u, uvl_list[i].v, static_cast<uint16_t>(pt)});
+		}
+	}
+	void op_sortnorm(const uint8_t *const p)
+	{
+		/* Drawing relies on the depth buffer, so both sides are used
+		 * and the separating plane is not needed.
+		 */
+		iterate_polymodel(p + w(p + 28), *this);
+		iterate_polymodel(p + w(p + 30), *this);
+	}
+	void op_rodbm(const uint8_t *)
+	{
+		supported = false;
+	}
+	void op_subcall(const uint8_t *const p)
+	{
+		subcalls.push_back({p + w(p + 16), {*vp(p + 4), 0, static_cast<uint8_t>(w(p + 2))}});
+	}
+	void op_glow(const uint8_t *const p)
+	{
+		glow_num = w(p + 2);
+	}
+};
+
+}
+
+namespace {
+
+class g3_build_draw_list_state :
+	public interpreter_base
+{
+	typedef polymodel_draw_list::op_type op_type;
+	polymodel_draw_list &list;
+	std::vector<polymodel_draw_list::op> &ops;
+	submodel_bounds &bounds;
+	const unsigned depth;
+	std::size_t add(const uint8_t *const p, const op_type type, const uint_fast32_t count = 0)
+	{
+		const auto index = ops.size();
+		ops.push_back({p, 0, 0, static_cast<uint16_t>(count), type});
+		return index;
+	}
+	void add_points(const vms_vector *const src, const uint_fast32_t n)
+	{
+		range_for (auto &v, unchecked_partial_range(src, n))
+			bounds.add_point(v);
+	}
+	void add_polygon()
+	{
+		if (!bounds.has_points())
+			bounds.unbounded = true;
+	}
+	void compile(const uint8_t *const p, submodel_bounds &b)
+	{
+		/* The interpreter would recurse forever on a model that calls
+		 * itself.
+		 */
+		if (depth > MAX_POLYGON_VECS)
+			op_default();
+		g3_build_draw_list_state state(list, b, depth + 1);
+		iterate_polymodel(p, state);
+	}
+public:
+	g3_build_draw_list_state(polymodel_draw_list &l, submodel_bounds &b, const unsigned d) :
+		list(l), ops(l.ops), bounds(b), depth(d)
+	{
+	}
+	void op_defpoints(const uint8_t *const p, const uint_fast32_t n)
+	{
+		add(p, op_type::defpoints, n);
+		add_points(vp(p + 4), n);
+	}
+	void op_defp_start(const uint8_t *const p, const uint_fast32_t n)
+	{
+		add(p, op_type::defp_start, n);
+		add_points(vp(p + 8), n);
+	}
+	void op_flatpoly(const uint8_t *const p, const uint_fast32_t nv)
+	{
+		/* Polygons the interpreter skips are left out. */
+		if (nv <= MAX_POINTS_PER_POLY)
+		{
+			add(p, op_type::flatpoly, nv);
+			add_polygon();
+		}
+	}
+	void op_tmappoly(const uint8_t *const p, const uint_fast32_t nv)
+	{
+		if (nv <= MAX_POINTS_PER_POLY)
+		{
+			add(p, op_type::tmappoly, nv);
+			add_polygon();
+		}
+	}
+	void op_sortnorm(const uint8_t *const p)
+	{
+		/* Both sides are in the frame of the caller. */
+		const auto index = add(p, op_type::sortnorm);
+		compile(p + w(p + 30), bounds);
+		ops[index].split = ops.size();
+		compile(p + w(p + 28), bounds);
+		ops[index].end = ops.size();
+	}
+	void op_rodbm(const uint8_t *const p)
+	{
+		add(p, op_type::rodbm);
+		bounds.add_sphere(*vp(p + 20), w(p + 16));
+		bounds.add_sphere(*vp(p + 4), w(p + 32));
+	}
+	void op_subcall(const uint8_t *const p)
+	{
+		const auto index = add(p, op_type::subcall);
+		submodel_bounds b;
+		compile(p + w(p + 16), b);
+		auto &o = ops[index];
+		o.end = ops.size();
+		if (b.unbounded)
+		{
+			o.split = UINT32_MAX;
+			bounds.unbounded = true;
+			return;
+		}
+		polymodel_draw_list::sphere s;
+		b.get(s.center, s.radius);
+		o.split = list.spheres.size();
+		list.spheres.emplace_back(s);
+		bounds.add_subcall(*vp(p + 4), s.center, s.radius);
+	}
+	void op_glow(const uint8_t *const p)
+	{
+		add(p, op_type::glow);
+	}
+};
+
+}
+
+bool g3_build_polygon_model_draw_list(const uint8_t *const model_ptr, polymodel_draw_list &list)
+{
+	list = {};
+	try {
+		submodel_bounds bounds;
+		g3_build_draw_list_state state(list, bounds, 0);
+		iterate_polymodel(model_ptr, state);
+		return true;
+	} catch (const std::runtime_error &) {
+		list = {};
+		return false;
+	}
+}
+
+/* Polygons are dropped from the reduced set of a node smallest first,
+ * while those kept cover at least this part of its area.  Polygons which
+ * glow are always kept.
+ */
+constexpr double polymodel_mesh_lod_area = 0.9;
+
+static double polygon_area(const polymodel_mesh &mesh, const polymodel_mesh::polygon &poly)
+{
+	auto &v = mesh.vertices;
+	const auto &p0 = v[poly.first_vertex].p;
+	double a = 0;
+	for (unsigned j = 1; j + 1 < poly.nv; ++j)
+	{
+		const auto &p1 = v[poly.first_vertex + j].p;
+		const auto &p2 = v[poly.first_vertex + j + 1].p;
+		const double ax = f2db(p1.x - p0.x), ay = f2db(p1.y - p0.y), az = f2db(p1.z - p0.z);
+		const double bx = f2db(p2.x - p0.x), by = f2db(p2.y - p0.y), bz = f2db(p2.z - p0.z);
+		const double cx = ay * bz - az * by, cy = az * bx - ax * bz, cz = ax * by - ay * bx;
+		a += std::sqrt(cx * cx + cy * cy + cz * cz) / 2;
+	}
+	return a;
+}
+
+static void build_polygon_model_mesh_lod(polymodel_mesh &mesh, polymodel_mesh::node &n)
+{
+	std::vector<std::pair<double, uint16_t>> by_area;
+	std::vector<uint16_t> kept;
+	double total = 0;
+	const unsigned end_polygon = n.first_polygon + n.n_polygons;
+	for (unsigned i = n.first_polygon; i != end_polygon; ++i)
+	{
+		auto &poly = mesh.polygons[i];
+		if (poly.glow != UINT8_MAX)
+			kept.emplace_back(i);
+		else
+		{
+			const auto a = polygon_area(mesh, poly);
+			by_area.emplace_back(a, i);
+			total += a;
+		}
+	}
+	std::sort(by_area.begin(), by_area.end(), [](const std::pair<double, uint16_t> &a, const std::pair<double, uint16_t> &b) {
+		return a.first > b.first;
+	});
+	const auto target = total * polymodel_mesh_lod_area;
+	double covered = 0;
+	range_for (auto &i, by_area)
+	{
+		if (covered >= target)
+			break;
+		covered += i.first;
+		kept.emplace_back(i.second);
+	}
+	/* Keep the order of the full set, so that the two draw alike. */
+	std::sort(kept.begin(), kept.end());
+	n.first_lod_polygon = mesh.lod_polygons.size();
+	n.n_lod_polygons = kept.size();
+	mesh.lod_polygons.insert(mesh.lod_polygons.end(), kept.begin(), kept.end());
+}
+
+static bool build_polygon_model_mesh_node(const uint8_t *const p, polymodel_mesh &mesh, array<vms_vector, MAX_POLYGON_VECS> &points, const unsigned depth)
+{
+	if (depth > MAX_SUBMODELS)
+		return false;
+	const auto node = mesh.nodes.size();
+	mesh.nodes.emplace_back();
+	g3_build_mesh_state state(mesh, points);
+	const auto first_polygon = mesh.polygons.size();
+	iterate_polymodel(p, state);
+	if (!state.supported)
+		return false;
+	{
+		auto &n = mesh.nodes[node];
+		n.first_polygon = first_polygon;
+		n.n_polygons = mesh.polygons.size() - first_polygon;
+	}
+	/* Subcalls are compiled after the calling submodel, so that its
+	 * polygons and subcalls are each contiguous.
+	 */
+	range_for (auto &sc, state.subcalls)
+	{
+		sc.s.node = mesh.nodes.size();
+		if (!build_polygon_model_mesh_node(sc.p, mesh, points, depth + 1))
+			return false;
+	}
+	auto &n = mesh.nodes[node];
+	n.first_subcall = mesh.subcalls.size();
+	n.n_subcalls = state.subcalls.size();
+	submodel_bounds bounds;
+	if (n.n_polygons)
+	{
+		/* The vertices of the node are contiguous, and come before those
+		 * of the submodels it calls.
+		 */
+		auto &last = mesh.polygons[n.first_polygon + n.n_polygons - 1];
+		const unsigned end_vertex = last.first_vertex + last.nv;
+		for (unsigned i = mesh.polygons[n.first_polygon].first_vertex; i != end_vertex; ++i)
+			bounds.add_point(mesh.vertices[i].p);
+	}
+	range_for (auto &sc, state.subcalls)
+	{
+		auto &c = mesh.nodes[sc.s.node];
+		bounds.add_subcall(sc.s.offset, c.center, c.radius);
+		mesh.subcalls.emplace_back(sc.s);
+	}
+	bounds.get(n.center, n.radius);
+	build_polygon_model_mesh_lod(mesh, n);
+	return true;
+}
+
+bool g3_build_polygon_model_mesh(const uint8_t *const model_ptr, polymodel_mesh &mesh)
+{
+	mesh = {};
+	auto points = make_unique<array<vms_vector, MAX_POLYGON_VECS>>();
+	if (build_polygon_model_mesh_node(model_ptr, mesh, *points, 0) && mesh.vertices.size() <= UINT16_MAX)
+		return true;
+	mesh = {};
+	return false;
+}
+
 }
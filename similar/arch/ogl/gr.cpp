@@ -72,6 +72,7 @@
 #endif
 
 #include "ogl_sync.h"
+#include "profile.h"
 
 #include "compiler-make_unique.h"
 
@@ -163,15 +164,18 @@ namespace dsx {
 void ogl_swap_buffers_internal(void)
 {
 	sync_helper.before_swap();
+	{
+		const profile_scope profile(profile_phase::swap);
 #if DXX_USE_OGLES
-	eglSwapBuffers(eglDisplay, eglSurface);
+		eglSwapBuffers(eglDisplay, eglSurface);
 #else
 #if SDL_MAJOR_VERSION == 1
-	SDL_GL_SwapBuffers();
+		SDL_GL_SwapBuffers();
 #elif SDL_MAJOR_VERSION == 2
-	SDL_GL_SwapWindow(g_pRebirthSDLMainWindow);
+		SDL_GL_SwapWindow(g_pRebirthSDLMainWindow);
 #endif
 #endif
+	}
 	sync_helper.after_swap();
 }
 
@@ -570,6 +574,7 @@ void gr_toggle_fullscreen()
 
 static void ogl_init_state(void)
 {
+	ogl_state_reset();
 	/* select clearing (background) color   */
 	glClearColor(0.0, 0.0, 0.0, 0.0);
 
@@ -584,7 +589,7 @@ static void ogl_init_state(void)
 	glMatrixMode(GL_MODELVIEW);
 	glLoadIdentity();//clear matrix
 	glEnable(GL_BLEND);
-	glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+	ogl_blend_func(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
 	gr_palette_step_up(0,0,0);//in case its left over from in game
 
 	ogl_init_pixel_buffers(grd_curscreen->get_screen_width(), grd_curscreen->get_screen_height());
@@ -919,6 +924,7 @@ namespace dcx {
 
 void ogl_upixelc(const grs_bitmap &cv_bitmap, unsigned x, unsigned y, unsigned c)
 {
+	ogl_flush_text_batch();
 	array<GLfloat, 2> vertices = {{
 		(x + cv_bitmap.bm_x) / static_cast<float>(last_width),
 		static_cast<GLfloat>(1.0 - (y + cv_bitmap.bm_y) / static_cast<float>(last_height))
@@ -935,19 +941,18 @@ void ogl_upixelc(const grs_bitmap &cv_bitmap, unsigned x, unsigned y, unsigned c
 
 	OGL_DISABLE(TEXTURE_2D);
 	glPointSize(linedotscale);
-	glEnableClientState(GL_VERTEX_ARRAY);
-	glEnableClientState(GL_COLOR_ARRAY);
+	ogl_set_client_arrays(ogl_client_array_vertex | ogl_client_array_color);
 	glVertexPointer(2, GL_FLOAT, 0, vertices.data());
 	glColorPointer(4, GL_FLOAT, 0, color_array);
 	glDrawArrays(GL_POINTS, 0, 1);
-	glDisableClientState(GL_VERTEX_ARRAY);
-	glDisableClientState(GL_COLOR_ARRAY);
 }
 
 unsigned char ogl_ugpixel(const grs_bitmap &bitmap, unsigned x, unsigned y)
 {
 	ubyte buf[4];
 
+	ogl_flush_text_batch();
+
 #if !DXX_USE_OGLES
 	GLint gl_draw_buffer;
 	glGetIntegerv(GL_DRAW_BUFFER, &gl_draw_buffer);
@@ -963,8 +968,8 @@ void ogl_urect(grs_canvas &canvas, const int left, const int top, const int righ
 {
 	GLfloat xo, yo, xf, yf, color_r, color_g, color_b, color_a;
 
-	glEnableClientState(GL_VERTEX_ARRAY);
-	glEnableClientState(GL_COLOR_ARRAY);
+	ogl_flush_text_batch();
+	ogl_set_client_arrays(ogl_client_array_vertex | ogl_client_array_color);
 
 	xo = (left + canvas.cv_bitmap.bm_x) / static_cast<float>(last_width);
 	xf = (right + 1 + canvas.cv_bitmap.bm_x) / static_cast<float>(last_width);
@@ -1000,8 +1005,6 @@ void ogl_urect(grs_canvas &canvas, const int left, const int top, const int righ
 	glVertexPointer(2, GL_FLOAT, 0, vertices.data());
 	glColorPointer(4, GL_FLOAT, 0, color_array.data());
 	glDrawArrays(GL_TRIANGLE_FAN, 0, 4);//replaced GL_QUADS
-	glDisableClientState(GL_VERTEX_ARRAY);
-	glDisableClientState(GL_COLOR_ARRAY);
 }
 
 void ogl_ulinec(grs_canvas &canvas, const int left, const int top, const int right, const int bot, const int c)
@@ -1010,6 +1013,7 @@ void ogl_ulinec(grs_canvas &canvas, const int left, const int top, const int rig
 	GLfloat fade_alpha = (canvas.cv_fade_level >= GR_FADE_OFF)
 		? 1.0
 		: 1.0 - static_cast<float>(canvas.cv_fade_level) / (static_cast<float>(GR_FADE_LEVELS) - 1.0);
+	ogl_flush_text_batch();
 	GLfloat color_array[] = {
 		static_cast<GLfloat>(CPAL2Tr(c)), static_cast<GLfloat>(CPAL2Tg(c)), static_cast<GLfloat>(CPAL2Tb(c)), fade_alpha,
 		static_cast<GLfloat>(CPAL2Tr(c)), static_cast<GLfloat>(CPAL2Tg(c)), static_cast<GLfloat>(CPAL2Tb(c)), fade_alpha,
@@ -1017,8 +1021,7 @@ void ogl_ulinec(grs_canvas &canvas, const int left, const int top, const int rig
 		static_cast<GLfloat>(CPAL2Tr(c)), static_cast<GLfloat>(CPAL2Tg(c)), static_cast<GLfloat>(CPAL2Tb(c)), fade_alpha
 	};
 
-	glEnableClientState(GL_VERTEX_ARRAY);
-	glEnableClientState(GL_COLOR_ARRAY);
+	ogl_set_client_arrays(ogl_client_array_vertex | ogl_client_array_color);
 	
 	xo = (left + canvas.cv_bitmap.bm_x) / static_cast<float>(last_width);
 	xf = (right + canvas.cv_bitmap.bm_x) / static_cast<float>(last_width);
@@ -1037,29 +1040,38 @@ void ogl_ulinec(grs_canvas &canvas, const int left, const int top, const int rig
 	glVertexPointer(2, GL_FLOAT, 0, vertices.data());
 	glColorPointer(4, GL_FLOAT, 0, color_array);
 	glDrawArrays(GL_LINES, 0, 2);
-	glDisableClientState(GL_VERTEX_ARRAY);
-	glDisableClientState(GL_COLOR_ARRAY);
 }
 
-static GLfloat last_r, last_g, last_b;
+/* What the palette step does to every pixel: the frame is multiplied
+ * by palfx_scale, then palfx_add is added to it.
+ */
+static array<GLfloat, 3> palfx_add, palfx_scale;
 static int do_pal_step;
 
+/* Flashes, fades and gamma all come down to one blended pass over the
+ * finished frame.  Nothing else depends on the palette step, so
+ * changing it every frame costs no texture or color table work.
+ */
 void ogl_do_palfx(void)
 {
-	GLfloat color_array[] = { last_r, last_g, last_b, 1.0, last_r, last_g, last_b, 1.0, last_r, last_g, last_b, 1.0, last_r, last_g, last_b, 1.0 };
+	if (!do_pal_step)
+		return;
+	const auto r = palfx_add[0], g = palfx_add[1], b = palfx_add[2];
+	GLfloat color_array[] = { r, g, b, 1.0, r, g, b, 1.0, r, g, b, 1.0, r, g, b, 1.0 };
 
+	ogl_flush_text_batch();
 	OGL_DISABLE(TEXTURE_2D);
 
-	glEnableClientState(GL_VERTEX_ARRAY);
-	glEnableClientState(GL_COLOR_ARRAY);
+	ogl_set_client_arrays(ogl_client_array_vertex | ogl_client_array_color);
  
-	if (do_pal_step)
+	glEnable(GL_BLEND);
+	if (ogl_have_EXT_blend_color)
 	{
-		glEnable(GL_BLEND);
-		glBlendFunc(GL_ONE,GL_ONE);
+		glBlendColorFunc(palfx_scale[0], palfx_scale[1], palfx_scale[2], 1.0);
+		ogl_blend_func(GL_ONE, GL_CONSTANT_COLOR);
 	}
 	else
-		return;
+		ogl_blend_func(GL_ONE, GL_ONE);
 
 	array<GLfloat, 8> vertices = {{
 		0, 0, 0, 1, 1, 1, 1, 0
@@ -1067,10 +1079,8 @@ void ogl_do_palfx(void)
 	glVertexPointer(2, GL_FLOAT, 0, vertices.data());
 	glColorPointer(4, GL_FLOAT, 0, color_array);
 	glDrawArrays(GL_TRIANGLE_FAN, 0, 4);//replaced GL_QUADS
-	glDisableClientState(GL_VERTEX_ARRAY);
-	glDisableClientState(GL_COLOR_ARRAY);
 	glEnable(GL_BLEND);
-	glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+	ogl_blend_func(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
 }
 
 static int ogl_brightness_ok;
@@ -1082,15 +1092,25 @@ void gr_palette_step_up(int r, int g, int b)
 	old_b_g = ogl_brightness_g;
 	old_b_b = ogl_brightness_b;
 
-	ogl_brightness_r = max(r + gr_palette_gamma, 0);
-	ogl_brightness_g = max(g + gr_palette_gamma, 0);
-	ogl_brightness_b = max(b + gr_palette_gamma, 0);
+	ogl_brightness_r = r + gr_palette_gamma;
+	ogl_brightness_g = g + gr_palette_gamma;
+	ogl_brightness_b = b + gr_palette_gamma;
 
 	if (!ogl_brightness_ok)
 	{
-		last_r = ogl_brightness_r / 63.0;
-		last_g = ogl_brightness_g / 63.0;
-		last_b = ogl_brightness_b / 63.0;
+		/* A palette step adds to every palette entry and clamps it.
+		 * Blending adds positive steps the same way.  It cannot
+		 * subtract in the same pass, so negative steps darken the
+		 * frame by scaling instead, when the blend color can do that,
+		 * and are dropped otherwise.
+		 */
+		const array<int, 3> step{{ogl_brightness_r, ogl_brightness_g, ogl_brightness_b}};
+		for (unsigned i = 0; i != step.size(); ++i)
+		{
+			const auto s = step[i];
+			palfx_add[i] = s > 0 ? s / 63.0f : 0;
+			palfx_scale[i] = s < 0 ? max(1 + s / 63.0f, 0.0f) : 1;
+		}
 
 		do_pal_step = (r || g || b || gr_palette_gamma);
 	}
@@ -1102,10 +1122,18 @@ void gr_palette_step_up(int r, int g, int b)
 
 void gr_palette_load( palette_array_t &pal )
 {
-	copy_bound_palette(gr_current_pal, pal);
+	palette_array_t bound_pal;
+	copy_bound_palette(bound_pal, pal);
 
 	gr_palette_step_up(0, 0, 0); // make ogl_setbrightness_internal get run so that menus get brightened too.
-	init_computed_colors();
+	/* The closest color cache only goes stale when the colors change,
+	 * and the same palette is loaded again on many screen changes.
+	 */
+	if (gr_current_pal != bound_pal)
+	{
+		gr_current_pal = bound_pal;
+		init_computed_colors();
+	}
 }
 
 #define GL_BGR_EXT 0x80E0
@@ -1126,6 +1154,7 @@ void write_bmp(PHYSFS_File *const TGAFile, const unsigned w, const unsigned h)
 	RAIIdmem<uint8_t[]> buf;
 	const unsigned buffer_size_TGA = w * h * 3;
 	CALLOC(buf, uint8_t[], buffer_size_TGA);
+	ogl_flush_text_batch();
 
 	RAIIdmem<uint8_t[]> rgbaBuf;
 	CALLOC(rgbaBuf, uint8_t[], w * h * 4);
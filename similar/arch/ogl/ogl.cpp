@@ -42,6 +42,7 @@
 #include "console.h"
 #include "config.h"
 #include "u_mem.h"
+#include "frame_alloc.h"
 
 #include "segment.h"
 #include "textures.h"
@@ -58,7 +59,16 @@
 #include "gauges.h"
 #include "playsave.h"
 #include "object.h"
+#include "gameseg.h"
+#include "interp.h"
+#include "polyobj.h"
+#include "lighting.h"
 #include "args.h"
+#include "ogl_shader.h"
+#include "timer.h"
+#include "profile.h"
+#include "physfsx.h"
+#include "hash.h"
 
 #include "compiler-exchange.h"
 #include "compiler-make_unique.h"
@@ -66,6 +76,9 @@
 #include "partial_range.h"
 
 #include <algorithm>
+#include <cstddef>
+#include <unordered_map>
+#include <vector>
 using std::max;
 
 //change to 1 for lots of spew.
@@ -81,21 +94,39 @@ using std::max;
 
 namespace {
 
-template <unsigned G>
-struct enable_ogl_client_state
+constexpr uint8_t ogl_client_array_bit(const unsigned G)
 {
-	enable_ogl_client_state() noexcept
-	{
-		glEnableClientState(G);
-	}
-	~enable_ogl_client_state() noexcept
+	return G == GL_VERTEX_ARRAY
+		? ogl_client_array_vertex
+		: G == GL_COLOR_ARRAY
+			? ogl_client_array_color
+			: ogl_client_array_texcoord;
+}
+
+template <unsigned... Gs>
+struct ogl_client_array_mask;
+
+template <>
+struct ogl_client_array_mask<> : std::integral_constant<uint8_t, 0>
+{
+};
+
+template <unsigned G, unsigned... Gs>
+struct ogl_client_array_mask<G, Gs...> : std::integral_constant<uint8_t, ogl_client_array_bit(G) | ogl_client_array_mask<Gs...>::value>
+{
+};
+
+template <unsigned... Gs>
+struct enable_ogl_client_states
+{
+	enable_ogl_client_states() noexcept
 	{
-		glDisableClientState(G);
+		ogl_set_client_arrays(ogl_client_array_mask<Gs...>::value);
 	}
 };
 
 template <typename T, unsigned... Gs>
-using ogl_client_states = std::tuple<T, enable_ogl_client_state<Gs>...>;
+using ogl_client_states = std::tuple<T, enable_ogl_client_states<Gs...>>;
 
 }
 
@@ -110,6 +141,57 @@ static std::unique_ptr<GLubyte[]> texbuf;
 
 unsigned last_width=~0u,last_height=~0u;
 int GL_TEXTURE_2D_enabled=-1;
+ogl_state_cache Ogl_state;
+
+void ogl_state_reset()
+{
+	auto &c = Ogl_state;
+	c.texture_2d.fill(ogl_state_cache::unknown_texture);
+	/* Every texture unit switch goes through ogl_active_texture, and
+	 * each one switches back to unit 0 when done.
+	 */
+	c.active_texture = 0;
+	c.client_arrays = ogl_client_array_unknown;
+	c.depth_test = -1;
+	c.blend_src = c.blend_dst = ogl_state_cache::unknown_blend;
+	GL_TEXTURE_2D_enabled = -1;
+}
+
+void ogl_active_texture(const unsigned unit)
+{
+	if (Ogl_state.active_texture == unit)
+	{
+		ogl_state_skipped();
+		return;
+	}
+	Ogl_state.active_texture = unit;
+	glActiveTextureFunc(GL_TEXTURE0 + unit);
+}
+
+void ogl_set_client_arrays(const uint8_t mask)
+{
+	auto &current = Ogl_state.client_arrays;
+	const auto change = (current & ogl_client_array_unknown)
+		? ogl_client_array_vertex | ogl_client_array_color | ogl_client_array_texcoord
+		: current ^ mask;
+	if (!change)
+	{
+		ogl_state_skipped();
+		return;
+	}
+	const auto set = [change, mask](const uint8_t bit, const GLenum array) {
+		if (!(change & bit))
+			return;
+		if (mask & bit)
+			glEnableClientState(array);
+		else
+			glDisableClientState(array);
+	};
+	set(ogl_client_array_vertex, GL_VERTEX_ARRAY);
+	set(ogl_client_array_color, GL_COLOR_ARRAY);
+	set(ogl_client_array_texcoord, GL_TEXTURE_COORD_ARRAY);
+	current = mask;
+}
 
 static int r_texcount = 0, r_cachedtexcount = 0;
 #if DXX_USE_OGLES
@@ -124,23 +206,215 @@ static array<std::unique_ptr<GLfloat[]>, 3> secondary_lva;
 static int r_polyc,r_tpolyc,r_bitmapc,r_ubitbltc;
 #define f2glf(x) (f2fl(x))
 
-#define OGL_BINDTEXTURE(a) glBindTexture(GL_TEXTURE_2D, a);
+#define OGL_BINDTEXTURE(a) ogl_bind_texture_2d(a)
+
+/* Bitmaps keep pointers to their textures, so textures live in chunks
+ * which never move.  Free slots are kept on a stack, and a chunk is
+ * added when the stack is empty, so the list does not fill up.
+ */
+constexpr unsigned ogl_texture_chunk_size = 1024;
+
+namespace {
+
+struct ogl_texture_pool
+{
+	std::vector<std::unique_ptr<array<ogl_texture, ogl_texture_chunk_size>>> chunks;
+	std::vector<unsigned> free_slots;
+	std::vector<bool> in_use;
+	/* Evictable resident textures, most recently drawn first. */
+	ogl_texture *lru_head, *lru_tail;
+	std::size_t resident_bytes;
+	unsigned frame;
+	unsigned evictions, evictions_last_second, evictions_per_second;
+	fix64 rate_time;
+};
+
+}
+
+static ogl_texture_pool ogl_texture_list;
 
-/* I assume this ought to be >= MAX_BITMAP_FILES in piggy.h? */
-static array<ogl_texture, 20000> ogl_texture_list;
-static int ogl_texture_list_cur;
+template <typename F>
+static void ogl_for_each_texture(F f)
+{
+	range_for (auto &c, ogl_texture_list.chunks)
+		range_for (auto &t, *c)
+			f(t);
+}
+
+/* Slot of a texture in the pool, or -1 for a texture which is not in
+ * it, such as the temporary texture of ogl_ubitblt_i.
+ */
+static int ogl_texture_slot(const ogl_texture &t)
+{
+	auto &chunks = ogl_texture_list.chunks;
+	for (unsigned i = 0, n = chunks.size(); i != n; ++i)
+	{
+		const auto b = chunks[i]->data();
+		if (&t >= b && &t < b + ogl_texture_chunk_size)
+			return i * ogl_texture_chunk_size + (&t - b);
+	}
+	return -1;
+}
 
 /* some function prototypes */
 
 #define GL_TEXTURE0_ARB 0x84C0
 static int ogl_loadtexture(const palette_array_t &, const uint8_t *data, int dxo, int dyo, ogl_texture &tex, int bm_flags, int data_format, int texfilt, bool texanis, bool edgepad) __attribute_nonnull();
 static void ogl_freetexture(ogl_texture &gltexture);
+static void ogl_build_texture_array(const std::vector<grs_bitmap *> &candidates);
+static void ogl_gpu_timer_reset();
+static void ogl_dynres_reset();
+static void ogl_movie_reset();
+static void ogl_texcache_close();
+static void ogl_invalidate_terrain_buffer();
+static void ogl_invalidate_automap_buffer();
+static void ogl_flush_sprite_batch();
+static void ogl_flush_model_batch();
 
 static void ogl_loadbmtexture(grs_bitmap &bm, bool edgepad)
 {
 	ogl_loadbmtexture_f(bm, CGameCfg.TexFilt, CGameCfg.TexAnisotropy, edgepad);
 }
 
+/* -gl_asyncupload: once a frame has spent ogl_upload_frame_budget on
+ * texture uploads, textures first needed while drawing get a 1x1
+ * placeholder of their average color.  The real textures are uploaded
+ * after the next buffer swap, again within the budget.
+ */
+struct ogl_pending_upload
+{
+	grs_bitmap *bm;
+	ogl_texture *tex;
+	bool edgepad;
+};
+
+static std::vector<ogl_pending_upload> ogl_pending_uploads;
+static fix64 ogl_upload_frame_time;
+static GLuint ogl_upload_pbo;
+constexpr fix ogl_upload_frame_budget = F1_0 / 250;
+
+static void ogl_timed_loadbmtexture(grs_bitmap &bm, bool edgepad)
+{
+	const auto start = timer_query();
+	ogl_loadbmtexture(bm, edgepad);
+	ogl_upload_frame_time += timer_query() - start;
+}
+
+static void ogl_load_placeholder_texture(grs_bitmap &bm, const bool edgepad)
+{
+	auto &tex = *bm.gltexture;
+	tex.tw = pow2ize(tex.w);
+	tex.th = pow2ize(tex.h);
+	tex.u = static_cast<float>(static_cast<double>(tex.w) / static_cast<double>(tex.tw));
+	tex.v = static_cast<float>(static_cast<double>(tex.h) / static_cast<double>(tex.th));
+	const auto &rgb = gr_palette[bm.avg_color];
+	const array<GLubyte, 4> texel{{
+		static_cast<GLubyte>(rgb.r * 4),
+		static_cast<GLubyte>(rgb.g * 4),
+		static_cast<GLubyte>(rgb.b * 4),
+		static_cast<GLubyte>(bm.get_flag_mask(BM_FLAG_TRANSPARENT | BM_FLAG_SUPER_TRANSPARENT) ? 0 : 255),
+	}};
+	glGenTextures(1, &tex.handle);
+	OGL_BINDTEXTURE(tex.handle);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, 1, 1, 0, GL_RGBA, GL_UNSIGNED_BYTE, texel.data());
+	tex.wrapstate = -1;
+	tex.placeholder = true;
+	r_texcount++;
+	ogl_pending_uploads.emplace_back(ogl_pending_upload{&bm, &tex, edgepad});
+}
+
+static void ogl_loadbmtexture_lazy(grs_bitmap &rbm, bool edgepad)
+{
+	if (!CGameArg.OglAsyncUpload)
+	{
+		ogl_loadbmtexture(rbm, edgepad);
+		return;
+	}
+	if (ogl_upload_frame_time < ogl_upload_frame_budget)
+	{
+		ogl_timed_loadbmtexture(rbm, edgepad);
+		return;
+	}
+	grs_bitmap *bm = &rbm;
+	while (const auto bm_parent = bm->bm_parent)
+		bm = bm_parent;
+	if (!bm->gltexture || bm->gltexture->w == 0)
+	{
+		/* Let ogl_loadbmtexture_f set up the texture sizes. */
+		ogl_timed_loadbmtexture(rbm, edgepad);
+		return;
+	}
+	if (bm->gltexture->handle <= 0)
+		ogl_load_placeholder_texture(*bm, edgepad);
+}
+
+/* Called after each buffer swap. */
+static void ogl_process_pending_uploads()
+{
+	ogl_upload_frame_time = 0;
+	auto &q = ogl_pending_uploads;
+	auto i = q.begin();
+	for (const auto e = q.end(); i != e && ogl_upload_frame_time < ogl_upload_frame_budget; ++i)
+	{
+		auto &bm = *i->bm;
+		auto &tex = *i->tex;
+		if (bm.gltexture != &tex || !tex.placeholder)
+			continue;
+		ogl_delete_texture(tex.handle);
+		tex.handle = 0;
+		tex.wrapstate = -1;
+		tex.placeholder = false;
+		r_texcount--;
+		ogl_timed_loadbmtexture(bm, i->edgepad);
+	}
+	q.erase(q.begin(), i);
+}
+
+/* Copy the pixels of a texture into a pixel buffer object, so that
+ * glTexImage2D can return before the driver has consumed them.  Returns
+ * the pointer to pass to glTexImage2D: an offset into the bound buffer,
+ * or the client memory if the pixels could not be staged.
+ */
+static const GLvoid *ogl_stage_texture_pixels(const GLubyte *const pixels, const GLenum format, const unsigned w, const unsigned h)
+{
+	if (!CGameArg.OglAsyncUpload || !ogl_have_ARB_pixel_buffer_object)
+		return pixels;
+	unsigned bpp;
+	switch (format)
+	{
+		case GL_RGBA:
+			bpp = 4;
+			break;
+		case GL_RGB:
+			bpp = 3;
+			break;
+		case GL_LUMINANCE_ALPHA:
+			bpp = 2;
+			break;
+		case GL_LUMINANCE:
+			bpp = 1;
+			break;
+		default:
+			return pixels;
+	}
+	const std::size_t size = w * h * bpp;
+	if (!ogl_upload_pbo)
+		glGenBuffersFunc(1, &ogl_upload_pbo);
+	glBindBufferFunc(GL_PIXEL_UNPACK_BUFFER, ogl_upload_pbo);
+	/* Orphan the storage used by the previous upload. */
+	glBufferDataFunc(GL_PIXEL_UNPACK_BUFFER, size, nullptr, GL_STREAM_DRAW);
+	if (const auto p = glMapBufferFunc(GL_PIXEL_UNPACK_BUFFER, GL_WRITE_ONLY))
+	{
+		memcpy(p, pixels, size);
+		if (glUnmapBufferFunc(GL_PIXEL_UNPACK_BUFFER))
+			return nullptr;
+	}
+	glBindBufferFunc(GL_PIXEL_UNPACK_BUFFER, 0);
+	return pixels;
+}
+
 }
 
 #if DXX_USE_OGLES
@@ -224,6 +498,12 @@ void ogl_init_texture(ogl_texture &t, int w, int h, int flags)
 	}
 #endif
 	t.wrapstate = -1;
+	t.array_layer = -1;
+	t.placeholder = false;
+	t.evictable = false;
+	t.resident_bytes = 0;
+	t.lru_frame = 0;
+	t.lru_prev = t.lru_next = nullptr;
 	t.lw = t.w = w;
 	t.h = h;
 	ogl_init_texture_stats(t);
@@ -235,41 +515,180 @@ static void ogl_reset_texture(ogl_texture &t)
 }
 
 static void ogl_reset_texture_stats_internal(void){
-	range_for (auto &i, ogl_texture_list)
+	ogl_for_each_texture([](ogl_texture &i) {
 		if (i.handle>0)
 			ogl_init_texture_stats(i);
+	});
 }
 
 void ogl_init_texture_list_internal(void){
-	ogl_texture_list_cur=0;
-	range_for (auto &i, ogl_texture_list)
-		ogl_reset_texture(i);
+	auto &p = ogl_texture_list;
+	ogl_for_each_texture([](ogl_texture &t) {
+		if (t.resident_bytes)
+			mem_account(mem_tag::gl_textures, t.resident_bytes, 0);
+		ogl_reset_texture(t);
+	});
+	p.free_slots.clear();
+	for (unsigned i = p.in_use.size(); i--;)
+	{
+		p.in_use[i] = false;
+		p.free_slots.emplace_back(i);
+	}
+	p.lru_head = p.lru_tail = nullptr;
+	p.resident_bytes = 0;
+}
+
+static void ogl_lru_unlink(ogl_texture &t)
+{
+	auto &p = ogl_texture_list;
+	(t.lru_prev ? t.lru_prev->lru_next : p.lru_head) = t.lru_next;
+	(t.lru_next ? t.lru_next->lru_prev : p.lru_tail) = t.lru_prev;
+	t.lru_prev = t.lru_next = nullptr;
+}
+
+static void ogl_lru_push_front(ogl_texture &t)
+{
+	auto &p = ogl_texture_list;
+	t.lru_prev = nullptr;
+	t.lru_next = p.lru_head;
+	(p.lru_head ? p.lru_head->lru_prev : p.lru_tail) = &t;
+	p.lru_head = &t;
+}
+
+/* Stop counting a texture as resident.  The caller deletes its handle. */
+static void ogl_texture_release(ogl_texture &t)
+{
+	if (!t.resident_bytes)
+		return;
+	auto &p = ogl_texture_list;
+	p.resident_bytes -= t.resident_bytes;
+	mem_account(mem_tag::gl_textures, exchange(t.resident_bytes, 0), 0);
+	if (t.evictable)
+		ogl_lru_unlink(t);
+}
+
+/* Called when a texture is drawn. */
+static void ogl_texture_touch(ogl_texture &t)
+{
+	auto &p = ogl_texture_list;
+	if (t.lru_frame == p.frame)
+		return;
+	t.lru_frame = p.frame;
+	if (t.resident_bytes && t.evictable && &t != p.lru_head)
+	{
+		ogl_lru_unlink(t);
+		ogl_lru_push_front(t);
+	}
+}
+
+/* -gl_vram: free the least recently drawn textures which were not drawn
+ * in this frame until the resident textures fit in the budget.  An
+ * evicted texture keeps its slot and sizes, so the next bind of its
+ * bitmap loads it again.
+ */
+static void ogl_texture_evict()
+{
+	auto &p = ogl_texture_list;
+	const std::size_t budget = static_cast<std::size_t>(CGameArg.OglVramBudget) << 20;
+	if (!budget)
+		return;
+	while (p.resident_bytes > budget)
+	{
+		const auto t = p.lru_tail;
+		/* A texture with queued glyphs was drawn this frame, so the
+		 * text batch never holds an evicted texture.
+		 */
+		if (!t || t->lru_frame == p.frame)
+			break;
+		ogl_texture_release(*t);
+		ogl_delete_texture(t->handle);
+		t->handle = 0;
+		t->wrapstate = -1;
+		r_texcount--;
+		++p.evictions;
+	}
+}
+
+ogl_texture_stats ogl_get_texture_stats()
+{
+	auto &p = ogl_texture_list;
+	return {p.resident_bytes, static_cast<unsigned>(p.in_use.size() - p.free_slots.size()), p.evictions, Ogl_state.skipped_last_frame, ogl_dynres_percent()};
+}
+
+/* Count a texture which was just uploaded by ogl_loadtexture. */
+static void ogl_texture_resident(ogl_texture &t)
+{
+	auto &p = ogl_texture_list;
+	t.resident_bytes = t.bytes > 0 ? t.bytes : 1;
+	p.resident_bytes += t.resident_bytes;
+	mem_account(mem_tag::gl_textures, 0, t.resident_bytes);
+	t.lru_frame = p.frame;
+	if (t.evictable)
+	{
+		if (ogl_texture_slot(t) < 0)
+			t.evictable = false;
+		else
+			ogl_lru_push_front(t);
+	}
+	ogl_texture_evict();
 }
 
 void ogl_smash_texture_list_internal(void){
+	ogl_flush_text_batch();
+	ogl_flush_model_batch();
+	ogl_state_reset();
+	ogl_invalidate_world_buffer();
+	ogl_invalidate_terrain_buffer();
+	ogl_invalidate_automap_buffer();
+	ogl_free_texture_array();
+	ogl_reset_shaders();
+	ogl_movie_reset();
+	ogl_invalidate_polygon_model_meshes();
+	ogl_gpu_timer_reset();
+	ogl_dynres_reset();
+	ogl_occlusion_reset();
+	ogl_pending_uploads.clear();
+	if (ogl_upload_pbo)
+	{
+		glDeleteBuffersFunc(1, &ogl_upload_pbo);
+		ogl_upload_pbo = 0;
+	}
 	sphere_va.reset();
 	circle_va.reset();
 	disk_va.reset();
 	secondary_lva = {};
-	range_for (auto &i, ogl_texture_list)
-	{
+	ogl_for_each_texture([](ogl_texture &i) {
 		if (i.handle>0){
-			glDeleteTextures( 1, &i.handle );
+			ogl_delete_texture(i.handle);
 			i.handle=0;
 		}
 		i.wrapstate = -1;
-	}
+		i.placeholder = false;
+		i.resident_bytes = 0;
+		i.lru_prev = i.lru_next = nullptr;
+	});
+	auto &p = ogl_texture_list;
+	p.lru_head = p.lru_tail = nullptr;
+	p.resident_bytes = 0;
 }
 
 ogl_texture* ogl_get_free_texture(void){
-	for (unsigned i = ogl_texture_list.size(); i--;)
+	auto &p = ogl_texture_list;
+	if (p.free_slots.empty())
 	{
-		if (ogl_texture_list[ogl_texture_list_cur].handle<=0 && ogl_texture_list[ogl_texture_list_cur].w==0)
-			return &ogl_texture_list[ogl_texture_list_cur];
-		if (++ogl_texture_list_cur >= ogl_texture_list.size())
-			ogl_texture_list_cur=0;
+		const unsigned first = p.chunks.size() * ogl_texture_chunk_size;
+		p.chunks.emplace_back(make_unique<array<ogl_texture, ogl_texture_chunk_size>>());
+		range_for (auto &t, *p.chunks.back())
+			ogl_reset_texture(t);
+		p.in_use.resize(first + ogl_texture_chunk_size);
+		/* Hand out the lowest slots first. */
+		for (unsigned i = first + ogl_texture_chunk_size; i-- != first;)
+			p.free_slots.emplace_back(i);
 	}
-	Error("OGL: texture list full!\n");
+	const auto slot = p.free_slots.back();
+	p.free_slots.pop_back();
+	p.in_use[slot] = true;
+	return &(*p.chunks[slot / ogl_texture_chunk_size])[slot % ogl_texture_chunk_size];
 }
 
 static void ogl_texture_stats(void)
@@ -279,8 +698,7 @@ static void ogl_texture_stats(void)
 	int prio0=0,prio1=0,prio2=0,prio3=0,prioh=0;
 	GLint idx, r, g, b, a, dbl, depth;
 	int res, colorsize, depthsize;
-	range_for (auto &i, ogl_texture_list)
-	{
+	ogl_for_each_texture([&](const ogl_texture &i) {
 		if (i.handle>0){
 			used++;
 			datatexel+=i.w*i.h;
@@ -303,6 +721,15 @@ static void ogl_texture_stats(void)
 			else
 				usedother++;
 		}
+	});
+
+	auto &pool = ogl_texture_list;
+	const auto now = timer_query();
+	if (now >= pool.rate_time + F1_0)
+	{
+		pool.evictions_per_second = pool.evictions - pool.evictions_last_second;
+		pool.evictions_last_second = pool.evictions;
+		pool.rate_time = now;
 	}
 
 	res = SWIDTH * SHEIGHT;
@@ -335,197 +762,1998 @@ static void ogl_texture_stats(void)
 	gr_printf(canvas, game_font, fspacx2, fspacy1 + line_spacing, "%i(%i,%i,%i,%i) %iK(%iK wasted) (%i postcachedtex)", used, usedrgba, usedrgb, usedidx, usedother, truebytes / 1024, (truebytes - databytes) / 1024, r_texcount - r_cachedtexcount);
 	gr_printf(canvas, game_font, fspacx2, fspacy1 + (line_spacing * 2), "%ibpp(r%i,g%i,b%i,a%i)x%i=%iK depth%i=%iK", idx, r, g, b, a, dbl, colorsize / 1024, depth, depthsize / 1024);
 	gr_printf(canvas, game_font, fspacx2, fspacy1 + (line_spacing * 3), "total=%iK", (colorsize + depthsize + truebytes) / 1024);
+	gr_printf(canvas, game_font, fspacx2, fspacy1 + (line_spacing * 4), "resident=%uK budget=%uK slots=%u evicted %u/s (%u)", static_cast<unsigned>(pool.resident_bytes / 1024), CGameArg.OglVramBudget * 1024, static_cast<unsigned>(pool.in_use.size() - pool.free_slots.size()), pool.evictions_per_second, pool.evictions);
+	gr_printf(canvas, game_font, fspacx2, fspacy1 + (line_spacing * 5), "%u redundant state calls skipped", Ogl_state.skipped_last_frame);
+	gr_printf(canvas, game_font, fspacx2, fspacy1 + (line_spacing * 6), "3D view at %u%% resolution", ogl_dynres_percent());
+}
+
+static void ogl_bindbmtex(grs_bitmap &bm, bool edgepad){
+	if (bm.gltexture==NULL || bm.gltexture->handle<=0)
+		ogl_loadbmtexture_lazy(bm, edgepad);
+	OGL_BINDTEXTURE(bm.gltexture->handle);
+	bm.gltexture->numrend++;
+	ogl_texture_touch(*bm.gltexture);
+}
+
+//gltexture MUST be bound first
+static void ogl_texwrap(ogl_texture *const gltexture, const int state)
+{
+	if (gltexture->wrapstate != state || gltexture->numrend < 1)
+	{
+		gltexture->wrapstate = state;
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, state);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, state);
+	}
+	else
+		ogl_state_skipped();
+}
+
+//crude texture precaching
+//handles: powerups, walls, weapons, polymodels, etc.
+//it is done with the horrid do_special_effects kludge so that sides that have to be texmerged and have animated textures will be correctly cached.
+//similarly, with the objects(esp weapons), we could just go through and cache em all instead, but that would get ones that might not even be on the level
+//TODO: doors
+
+void ogl_cache_polymodel_textures(const unsigned model_num)
+{
+	auto &Polygon_models = LevelSharedPolygonModelState.Polygon_models;
+	if (model_num >= Polygon_models.size())
+		return;
+	const auto &po = Polygon_models[model_num];
+	unsigned i = po.first_texture;
+	const unsigned last_texture = i + po.n_textures;
+	for (; i != last_texture; ++i)
+	{
+		ogl_loadbmtexture(GameBitmaps[ObjBitmaps[ObjBitmapPtrs[i]].index], 1);
+	}
+}
+
+static void ogl_cache_vclip_textures(const vclip &vc)
+{
+	range_for (auto &i, partial_const_range(vc.frames, vc.num_frames))
+	{
+		PIGGY_PAGE_IN(i);
+		ogl_loadbmtexture(GameBitmaps[i.index], 0);
+	}
+}
+
+static void ogl_cache_vclipn_textures(const d_vclip_array &Vclip, const unsigned i)
+{
+	if (i < Vclip.size())
+		ogl_cache_vclip_textures(Vclip[i]);
+}
+
+static void ogl_cache_weapon_textures(const d_vclip_array &Vclip, const weapon_info_array &Weapon_info, const unsigned weapon_type)
+{
+	if (weapon_type >= Weapon_info.size())
+		return;
+	const auto &w = Weapon_info[weapon_type];
+	ogl_cache_vclipn_textures(Vclip, w.flash_vclip);
+	ogl_cache_vclipn_textures(Vclip, w.robot_hit_vclip);
+	ogl_cache_vclipn_textures(Vclip, w.wall_hit_vclip);
+	if (w.render_type == WEAPON_RENDER_VCLIP)
+		ogl_cache_vclipn_textures(Vclip, w.weapon_vclip);
+	else if (w.render_type == WEAPON_RENDER_POLYMODEL)
+	{
+		ogl_cache_polymodel_textures(w.model_num);
+		ogl_cache_polymodel_textures(w.model_num_inner);
+	}
+}
+
+namespace dsx {
+
+void ogl_cache_level_textures(void)
+{
+	int max_efx=0,ef;
+	std::vector<grs_bitmap *> array_candidates;
+	
+	ogl_reset_texture_stats_internal();//loading a new lev should reset textures
+	
+	range_for (auto &ec, partial_const_range(Effects, Num_effects))
+	{
+		ogl_cache_vclipn_textures(Vclip, ec.dest_vclip);
+		if ((ec.changing_wall_texture == -1) && (ec.changing_object_texture==-1) )
+			continue;
+		if (ec.vc.num_frames>max_efx)
+			max_efx=ec.vc.num_frames;
+	}
+	glmprintf((CON_DEBUG, "max_efx:%i", max_efx));
+	for (ef=0;ef<max_efx;ef++){
+		range_for (eclip &ec, partial_range(Effects, Num_effects))
+		{
+			if ((ec.changing_wall_texture == -1) && (ec.changing_object_texture==-1) )
+				continue;
+			ec.time_left=-1;
+		}
+		do_special_effects();
+
+		range_for (const unique_segment &seg, vcsegptr)
+		{
+			range_for (auto &side, seg.sides)
+			{
+				const auto tmap1 = side.tmap_num;
+				const auto tmap2 = side.tmap_num2;
+				if (tmap1<0 || tmap1>=NumTextures){
+					glmprintf((CON_DEBUG, "ogl_cache_level_textures %p %p %i %i", seg.get_unchecked_pointer(), &side, tmap1, NumTextures));
+					//				tmap1=0;
+					continue;
+				}
+				PIGGY_PAGE_IN(Textures[tmap1]);
+				grs_bitmap *bm = &GameBitmaps[Textures[tmap1].index];
+				if (tmap2 != 0){
+					PIGGY_PAGE_IN(Textures[tmap2&0x3FFF]);
+					auto &bm2 = GameBitmaps[Textures[tmap2&0x3FFF].index];
+					if (CGameArg.DbgUseOldTextureMerge || (bm2.get_flag_mask(BM_FLAG_SUPER_TRANSPARENT) && !ogl_use_overlay_shader()))
+						bm = &texmerge_get_cached_bitmap( tmap1, tmap2 );
+					else {
+						ogl_loadbmtexture(bm2, !bm2.get_flag_mask(BM_FLAG_SUPER_TRANSPARENT));
+					}
+				}
+				ogl_loadbmtexture(*bm, 0);
+				if (tmap2 == 0)
+					array_candidates.emplace_back(bm);
+			}
+		}
+		glmprintf((CON_DEBUG, "finished ef:%i", ef));
+	}
+	reset_special_effects();
+	init_special_effects();
+	{
+		auto &Robot_info = LevelSharedRobotInfoState.Robot_info;
+		// always have lasers, concs, flares.  Always shows player appearance, and at least concs are always available to disappear.
+		ogl_cache_weapon_textures(Vclip, Weapon_info, Primary_weapon_to_weapon_info[primary_weapon_index_t::LASER_INDEX]);
+		ogl_cache_weapon_textures(Vclip, Weapon_info, Secondary_weapon_to_weapon_info[CONCUSSION_INDEX]);
+		ogl_cache_weapon_textures(Vclip, Weapon_info, weapon_id_type::FLARE_ID);
+		ogl_cache_vclipn_textures(Vclip, VCLIP_PLAYER_APPEARANCE);
+		ogl_cache_vclipn_textures(Vclip, VCLIP_POWERUP_DISAPPEARANCE);
+		ogl_cache_polymodel_textures(Player_ship->model_num);
+		ogl_cache_vclipn_textures(Vclip, Player_ship->expl_vclip_num);
+
+		range_for (const auto &&objp, vcobjptridx)
+		{
+			if (objp->type == OBJ_POWERUP && objp->render_type==RT_POWERUP)
+			{
+				ogl_cache_vclipn_textures(Vclip, objp->rtype.vclip_info.vclip_num);
+				const auto id = get_powerup_id(objp);
+				primary_weapon_index_t p;
+				secondary_weapon_index_t s;
+				int w;
+				if (
+					(
+						(
+							(id == POW_VULCAN_WEAPON && (p = primary_weapon_index_t::VULCAN_INDEX, true)) ||
+							(id == POW_SPREADFIRE_WEAPON && (p = primary_weapon_index_t::SPREADFIRE_INDEX, true)) ||
+							(id == POW_PLASMA_WEAPON && (p = primary_weapon_index_t::PLASMA_INDEX, true)) ||
+							(id == POW_FUSION_WEAPON && (p = primary_weapon_index_t::FUSION_INDEX, true))
+						) && (w = Primary_weapon_to_weapon_info[p], true)
+					) ||
+					(
+						(
+							(id == POW_PROXIMITY_WEAPON && (s = secondary_weapon_index_t::PROXIMITY_INDEX, true)) ||
+							((id == POW_HOMING_AMMO_1 || id == POW_HOMING_AMMO_4) && (s = secondary_weapon_index_t::HOMING_INDEX, true)) ||
+							(id == POW_SMARTBOMB_WEAPON && (s = secondary_weapon_index_t::SMART_INDEX, true)) ||
+							(id == POW_MEGA_WEAPON && (s = secondary_weapon_index_t::MEGA_INDEX, true))
+						) && (w = Secondary_weapon_to_weapon_info[s], true)
+					)
+				)
+				{
+					ogl_cache_weapon_textures(Vclip, Weapon_info, w);
+				}
+			}
+			else if (objp->type != OBJ_NONE && objp->render_type==RT_POLYOBJ)
+			{
+				if (objp->type == OBJ_ROBOT)
+				{
+					auto &ri = Robot_info[get_robot_id(objp)];
+					ogl_cache_vclipn_textures(Vclip, ri.exp1_vclip_num);
+					ogl_cache_vclipn_textures(Vclip, ri.exp2_vclip_num);
+					ogl_cache_weapon_textures(Vclip, Weapon_info, ri.weapon_type);
+				}
+				if (objp->rtype.pobj_info.tmap_override != -1)
+				{
+					auto &t = Textures[objp->rtype.pobj_info.tmap_override];
+					PIGGY_PAGE_IN(t);
+					ogl_loadbmtexture(GameBitmaps[t.index], 1);
+				}
+				else
+					ogl_cache_polymodel_textures(objp->rtype.pobj_info.model_num);
+			}
+		}
+	}
+	glmprintf((CON_DEBUG, "finished caching"));
+	r_cachedtexcount = r_texcount;
+	ogl_build_texture_array(array_candidates);
+	ogl_build_world_buffer();
+}
+
+}
+
+namespace dcx {
+
+namespace {
+
+/* One entry per corner of every side in the level.  Positions are in
+ * world space, so the buffer never changes while the level is loaded.
+ * Only the per-vertex light colors are rewritten each frame.
+ */
+struct ogl_world_vertex
+{
+	GLfloat x, y, z;
+	GLfloat u, v, r;
+};
+
+/* Fixed function OpenGL cannot sample array textures, so the level
+ * texture array is a 3D texture with one 64x64 image per layer.  The
+ * third texture coordinate selects the center of a layer.  3D textures
+ * cannot be mipmapped without mixing layers, so the array is only built
+ * for the classic (unfiltered) texture mode.
+ */
+struct ogl_level_texture_array
+{
+	GLuint handle = 0;
+	unsigned depth = 0;
+	std::vector<ogl_texture *> members;
+};
+
+struct ogl_world_batch
+{
+	GLuint vbo = 0;
+	unsigned vertex_count = 0;
+	std::unique_ptr<ogl_world_vertex[]> vertices;
+	std::unique_ptr<GLfloat[]> colors;
+	std::vector<GLuint> indices, overlay_indices;
+	grs_bitmap *bm = nullptr;
+	bool use_array = false;
+	int fade_level = GR_FADE_OFF;
+	array<GLfloat, 16> view_matrix;
+};
+
+/* Glyphs of one font share the texture of the font's parent bitmap, so
+ * a string can be sent as one list of triangles instead of one draw
+ * per character.
+ */
+struct ogl_text_batch
+{
+	ogl_texture *texture = nullptr;
+	std::vector<GLfloat> vertices, texcoords, colors;
+};
+
+/* Lines queued by g3_draw_line between ogl_begin_line_batch and
+ * ogl_end_line_batch, so the automap sends its edges in one draw.
+ */
+struct ogl_line_batch
+{
+	bool active = false;
+	std::vector<GLfloat> vertices, colors;
+};
+
+/* Billboards from g3_draw_bitmap.  Explosions, powerups and weapons
+ * showing the same vclip frame share a texture, so a run of them is sent
+ * as one list of triangles.  Queuing a different texture or any other
+ * draw flushes the run, so sprites still reach the screen in the order
+ * the renderer sorted them.
+ */
+struct ogl_sprite_batch
+{
+	ogl_texture *texture = nullptr;
+	std::vector<GLfloat> vertices, texcoords, colors;
+};
+
+}
+
+static ogl_world_batch ogl_world;
+static ogl_text_batch ogl_text;
+static ogl_line_batch ogl_lines;
+static ogl_sprite_batch ogl_sprites;
+static ogl_level_texture_array ogl_level_textures;
+
+static ogl_texture *ogl_get_root_texture(const grs_bitmap &rbm)
+{
+	const grs_bitmap *bm = &rbm;
+	while (const auto bm_parent = bm->bm_parent)
+		bm = bm_parent;
+	return bm->gltexture;
+}
+
+/* Build the OpenGL modelview matrix equivalent to g3_rotate_point
+ * followed by the z negation done by the immediate mode path.
+ */
+static void ogl_world_set_view_matrix(array<GLfloat, 16> &m)
+{
+	const auto &vm = View_matrix;
+	const auto &vp = View_position;
+	const vms_vector *const rows[3] = {&vm.rvec, &vm.uvec, &vm.fvec};
+	for (unsigned i = 0; i != 3; ++i)
+	{
+		const auto &r = *rows[i];
+		const GLfloat sign = (i == 2) ? -1.0 : 1.0;
+		m[i] = sign * f2glf(r.x);
+		m[i + 4] = sign * f2glf(r.y);
+		m[i + 8] = sign * f2glf(r.z);
+		m[i + 12] = -sign * (f2glf(r.x) * f2glf(vp.x) + f2glf(r.y) * f2glf(vp.y) + f2glf(r.z) * f2glf(vp.z));
+	}
+	m[3] = m[7] = m[11] = 0;
+	m[15] = 1;
+}
+
+static bool ogl_world_upload()
+{
+	auto &w = ogl_world;
+	if (w.vbo)
+		return true;
+	if (!w.vertices || !ogl_have_ARB_vertex_buffer_object)
+		return false;
+	glGenBuffersFunc(1, &w.vbo);
+	glBindBufferFunc(GL_ARRAY_BUFFER, w.vbo);
+	glBufferDataFunc(GL_ARRAY_BUFFER, w.vertex_count * sizeof(ogl_world_vertex), w.vertices.get(), GL_STATIC_DRAW);
+	glBindBufferFunc(GL_ARRAY_BUFFER, 0);
+	return true;
+}
+
+void ogl_invalidate_world_buffer()
+{
+	auto &w = ogl_world;
+	w.indices.clear();
+	w.bm = nullptr;
+	w.use_array = false;
+	if (w.vbo)
+	{
+		glDeleteBuffersFunc(1, &w.vbo);
+		w.vbo = 0;
+	}
+}
+
+void ogl_free_world_buffer()
+{
+	ogl_invalidate_world_buffer();
+	auto &w = ogl_world;
+	w.vertices.reset();
+	w.colors.reset();
+	w.vertex_count = 0;
+	std::vector<GLuint>().swap(w.indices);
+	std::vector<GLuint>().swap(w.overlay_indices);
+}
+
+/* Per pixel lighting (-gl_pixellight).  The vertex colors hold the
+ * static light and what set_dynamic_light still adds per vertex.  The
+ * fragment shader adds the pixel lights, with the same falloff that
+ * apply_light uses, and saturates like render_face does.  One program
+ * samples the 2D texture of a face, the other the level texture array.
+ */
+#define OGL_PIXEL_LIGHT_FRAGMENT_SHADER(SAMPLER, LOOKUP)	\
+	"#version 110\n"	\
+	"uniform " SAMPLER " texture;\n"	\
+	"uniform vec4 light_position[32];\n"	\
+	"uniform vec4 light_color[32];\n"	\
+	"uniform int light_count;\n"	\
+	"uniform float light_scale;\n"	\
+	"varying vec3 world_position;\n"	\
+	"void main()\n"	\
+	"{\n"	\
+	"	vec3 sum = vec3(0.0);\n"	\
+	"	for (int i = 0; i < 32; ++i)\n"	\
+	"	{\n"	\
+	"		if (i >= light_count)\n"	\
+	"			break;\n"	\
+	"		float d = distance(world_position, light_position[i].xyz);\n"	\
+	"		if (d < light_position[i].w)\n"	\
+	"			sum += light_color[i].rgb / max(d, 4.0);\n"	\
+	"	}\n"	\
+	"	vec4 c = vec4(min(gl_Color.rgb + sum * light_scale, 1.0), gl_Color.a);\n"	\
+	"	gl_FragColor = " LOOKUP " * c;\n"	\
+	"}\n"
+
+static_assert(MAX_PIXEL_LIGHTS == 32, "the pixel light shaders declare 32 lights");
+
+static const char ogl_pixel_light_vertex_shader[] =
+	"#version 110\n"
+	"varying vec3 world_position;\n"
+	"void main()\n"
+	"{\n"
+	"	world_position = gl_Vertex.xyz;\n"
+	"	gl_TexCoord[0] = gl_MultiTexCoord0;\n"
+	"	gl_FrontColor = gl_Color;\n"
+	"	gl_Position = ftransform();\n"
+	"}\n";
+
+static const char *const ogl_pixel_light_fragment_shaders[] = {
+	OGL_PIXEL_LIGHT_FRAGMENT_SHADER("sampler2D", "texture2D(texture, gl_TexCoord[0].xy)"),
+	OGL_PIXEL_LIGHT_FRAGMENT_SHADER("sampler3D", "texture3D(texture, gl_TexCoord[0].xyz)"),
+};
+
+#undef OGL_PIXEL_LIGHT_FRAGMENT_SHADER
+
+struct ogl_pixel_light_shader
+{
+	ogl_program program;
+	GLint light_position, light_color, light_count, light_scale;
+	/* The Pixel_light_generation last uploaded, or -1. */
+	int generation = -1;
+};
+
+static array<ogl_pixel_light_shader, 2> ogl_pixel_light_shaders;
+
+bool ogl_use_pixel_light_shader()
+{
+#if DXX_USE_OGLES
+	return false;
+#else
+	if (!CGameArg.OglPixelLight || !CGameArg.OglWorldBuffer || !ogl_have_ARB_shader_objects || !ogl_have_ARB_vertex_buffer_object)
+		return false;
+	for (unsigned i = 0; i != ogl_pixel_light_shaders.size(); ++i)
+	{
+		auto &s = ogl_pixel_light_shaders[i];
+		auto &p = s.program;
+		if (p)
+			continue;
+		if (p.build_failed())
+			return false;
+		if (!p.build("pixel light", ogl_pixel_light_vertex_shader, ogl_pixel_light_fragment_shaders[i]))
+			return false;
+		p.use();
+		glUniform1iFunc(p.uniform("texture"), 0);
+		s.light_position = p.uniform("light_position");
+		s.light_color = p.uniform("light_color");
+		s.light_count = p.uniform("light_count");
+		s.light_scale = p.uniform("light_scale");
+		s.generation = -1;
+		ogl_program::use_fixed_function();
+	}
+	return true;
+#endif
+}
+
+static void ogl_reset_pixel_light_shaders()
+{
+	range_for (auto &s, ogl_pixel_light_shaders)
+		s.program.reset();
+}
+
+/* Select the program for the texture kind and upload the lights if they
+ * changed since it was last used.
+ */
+static void ogl_begin_pixel_light(const bool use_array)
+{
+	auto &s = ogl_pixel_light_shaders[use_array];
+	s.program.use();
+	auto &LightState = LevelUniqueLightState;
+	if (s.generation == LightState.Pixel_light_generation)
+		return;
+	s.generation = LightState.Pixel_light_generation;
+	const unsigned n = LightState.Num_pixel_lights;
+	array<GLfloat, MAX_PIXEL_LIGHTS * 4> positions, colors;
+	for (unsigned i = 0; i != n; ++i)
+	{
+		auto &l = LightState.Pixel_lights[i];
+		const auto p = &positions[i * 4];
+		p[0] = f2glf(l.pos.x);
+		p[1] = f2glf(l.pos.y);
+		p[2] = f2glf(l.pos.z);
+		p[3] = f2glf(l.range);
+		const auto c = &colors[i * 4];
+		c[0] = f2glf(l.emission.r);
+		c[1] = f2glf(l.emission.g);
+		c[2] = f2glf(l.emission.b);
+		c[3] = 0;
+	}
+	if (n)
+	{
+		glUniform4fvFunc(s.light_position, n, positions.data());
+		glUniform4fvFunc(s.light_color, n, colors.data());
+	}
+	glUniform1iFunc(s.light_count, n);
+	glUniform1fFunc(s.light_scale, PlayerCfg.AlphaEffects ? .93 : 1.0);
+}
+
+void ogl_flush_world_buffer()
+{
+	auto &w = ogl_world;
+	if (w.indices.empty())
+		return;
+	const bool pixel_light = ogl_use_pixel_light_shader();
+	ogl_client_states<int, GL_VERTEX_ARRAY, GL_COLOR_ARRAY, GL_TEXTURE_COORD_ARRAY> cs;
+	const auto use_array = w.use_array;
+	if (use_array)
+	{
+		OGL_DISABLE(TEXTURE_2D);
+		glEnable(GL_TEXTURE_3D);
+		glBindTexture(GL_TEXTURE_3D, ogl_level_textures.handle);
+	}
+	else
+	{
+		auto &bm = *w.bm;
+		OGL_ENABLE(TEXTURE_2D);
+		ogl_bindbmtex(bm, 0);
+		ogl_texwrap(bm.gltexture, GL_REPEAT);
+	}
+	glPushMatrix();
+	glMultMatrixf(w.view_matrix.data());
+	glBindBufferFunc(GL_ARRAY_BUFFER, w.vbo);
+	glVertexPointer(3, GL_FLOAT, sizeof(ogl_world_vertex), reinterpret_cast<const GLvoid *>(offsetof(ogl_world_vertex, x)));
+	glTexCoordPointer(use_array ? 3 : 2, GL_FLOAT, sizeof(ogl_world_vertex), reinterpret_cast<const GLvoid *>(offsetof(ogl_world_vertex, u)));
+	glBindBufferFunc(GL_ARRAY_BUFFER, 0);
+	glColorPointer(4, GL_FLOAT, 0, w.colors.get());
+	if (pixel_light)
+		ogl_begin_pixel_light(use_array);
+	glDrawElements(GL_TRIANGLES, w.indices.size(), GL_UNSIGNED_INT, w.indices.data());
+	if (pixel_light)
+		ogl_program::use_fixed_function();
+	glPopMatrix();
+	if (use_array)
+		glDisable(GL_TEXTURE_3D);
+	w.indices.clear();
+	w.bm = nullptr;
+}
+
+#if !DXX_USE_OGLES
+/* Sliding textures move their coordinates, so copy the current ones
+ * into the buffer when they differ.  changed is set by the caller when
+ * it already modified the side's vertices.
+ */
+static void ogl_world_update_side(const unsigned segnum, const unsigned sidenum, const unsigned base, bool changed)
+{
+	auto &w = ogl_world;
+	const auto first = &w.vertices[base];
+#if defined(DXX_BUILD_DESCENT_II)
+	auto &seg = *vcsegptr(static_cast<segnum_t>(segnum));
+	if (seg.slide_textures & (1 << sidenum))
+	{
+		auto &uvls = seg.unique_segment::sides[sidenum].uvls;
+		for (unsigned i = 0; i != 4; ++i)
+		{
+			auto &wv = first[i];
+			const auto u = f2glf(uvls[i].u);
+			const auto v = f2glf(uvls[i].v);
+			if (wv.u != u || wv.v != v)
+			{
+				wv.u = u;
+				wv.v = v;
+				changed = true;
+			}
+		}
+	}
+#else
+	(void)segnum;
+	(void)sidenum;
+#endif
+	if (changed)
+	{
+		glBindBufferFunc(GL_ARRAY_BUFFER, w.vbo);
+		glBufferSubDataFunc(GL_ARRAY_BUFFER, base * sizeof(ogl_world_vertex), 4 * sizeof(ogl_world_vertex), first);
+		glBindBufferFunc(GL_ARRAY_BUFFER, 0);
+	}
+}
+
+static void ogl_world_set_colors(const grs_canvas &canvas, const unsigned base, const unsigned nv, const array<unsigned, 4> &corners, const array<g3s_lrgb, 4> &light_rgb, const bool no_lighting)
+{
+	auto &w = ogl_world;
+	const GLfloat color_alpha = (canvas.cv_fade_level >= GR_FADE_OFF) ? 1.0 : (1.0 - static_cast<float>(canvas.cv_fade_level) / (static_cast<float>(GR_FADE_LEVELS) - 1.0));
+	for (unsigned i = 0; i != nv; ++i)
+	{
+		const auto c = &w.colors[(base + corners[i]) * 4];
+		auto &l = light_rgb[i];
+		c[0] = no_lighting ? 1.0 : f2glf(l.r);
+		c[1] = no_lighting ? 1.0 : f2glf(l.g);
+		c[2] = no_lighting ? 1.0 : f2glf(l.b);
+		c[3] = color_alpha;
+	}
+}
+
+/* Append the triangle fan of a face to indices. */
+static void ogl_world_add_indices(std::vector<GLuint> &indices, const unsigned base, const unsigned nv, const array<unsigned, 4> &corners)
+{
+	for (unsigned i = 1; i + 1 < nv; ++i)
+	{
+		indices.emplace_back(base + corners[0]);
+		indices.emplace_back(base + corners[i]);
+		indices.emplace_back(base + corners[i + 1]);
+	}
+}
+#endif
+
+bool ogl_draw_world_face(grs_canvas &canvas, const unsigned segnum, const unsigned sidenum, const unsigned nv, const array<unsigned, 4> &corners, const array<g3s_lrgb, 4> &light_rgb, grs_bitmap &bm)
+{
+#if DXX_USE_OGLES
+	/* OpenGL ES 1.x cannot draw with 32-bit indices. */
+	(void)canvas;
+	(void)segnum;
+	(void)sidenum;
+	(void)nv;
+	(void)corners;
+	(void)light_rgb;
+	(void)bm;
+	return false;
+#else
+	auto &w = ogl_world;
+	if (tmap_drawer_ptr != draw_tmap)
+		return false;
+	ogl_flush_text_batch();
+	ogl_flush_sprite_batch();
+	ogl_flush_model_batch();
+	const unsigned base = (segnum * MAX_SIDES_PER_SEGMENT + sidenum) * 4;
+	if (base + 4 > w.vertex_count || !ogl_world_upload())
+		return false;
+	const auto gltexture = ogl_get_root_texture(bm);
+	const auto layer = gltexture ? gltexture->array_layer : -1;
+	const bool use_array = (layer >= 0);
+	if (use_array != w.use_array || (!use_array && w.bm != &bm) || w.fade_level != canvas.cv_fade_level)
+	{
+		ogl_flush_world_buffer();
+		w.use_array = use_array;
+		w.fade_level = canvas.cv_fade_level;
+	}
+	w.bm = &bm;
+	const auto first = &w.vertices[base];
+	bool changed = false;
+	if (use_array)
+	{
+		/* Animated walls and doors change the texture of a side, so
+		 * update the layer stored in the buffer when it differs.
+		 */
+		const GLfloat r = (layer + 0.5f) / ogl_level_textures.depth;
+		if (first->r != r)
+		{
+			for (unsigned i = 0; i != 4; ++i)
+				first[i].r = r;
+			changed = true;
+		}
+	}
+	ogl_world_update_side(segnum, sidenum, base, changed);
+	if (w.indices.empty())
+		ogl_world_set_view_matrix(w.view_matrix);
+	r_tpolyc++;
+	ogl_world_set_colors(canvas, base, nv, corners, light_rgb, bm.get_flag_mask(BM_FLAG_NO_LIGHTING));
+	ogl_world_add_indices(w.indices, base, nv, corners);
+	return true;
+#endif
+}
+
+void ogl_flush_text_batch()
+{
+	auto &t = ogl_text;
+	if (t.vertices.empty())
+		return;
+	ogl_client_states<int, GL_VERTEX_ARRAY, GL_COLOR_ARRAY, GL_TEXTURE_COORD_ARRAY> cs;
+	OGL_ENABLE(TEXTURE_2D);
+	OGL_BINDTEXTURE(t.texture->handle);
+	ogl_texwrap(t.texture, GL_CLAMP_TO_EDGE);
+	glVertexPointer(2, GL_FLOAT, 0, t.vertices.data());
+	glColorPointer(4, GL_FLOAT, 0, t.colors.data());
+	glTexCoordPointer(2, GL_FLOAT, 0, t.texcoords.data());
+	glDrawArrays(GL_TRIANGLES, 0, t.vertices.size() / 2);
+	t.vertices.clear();
+	t.texcoords.clear();
+	t.colors.clear();
+	t.texture = nullptr;
+}
+
+static void ogl_flush_line_batch()
+{
+	auto &l = ogl_lines;
+	if (l.vertices.empty())
+		return;
+	ogl_client_states<int, GL_VERTEX_ARRAY, GL_COLOR_ARRAY> cs;
+	OGL_DISABLE(TEXTURE_2D);
+	glVertexPointer(3, GL_FLOAT, 0, l.vertices.data());
+	glColorPointer(4, GL_FLOAT, 0, l.colors.data());
+	glDrawArrays(GL_LINES, 0, l.vertices.size() / 3);
+	l.vertices.clear();
+	l.colors.clear();
+}
+
+static void ogl_flush_sprite_batch()
+{
+	auto &s = ogl_sprites;
+	if (s.vertices.empty())
+		return;
+	ogl_client_states<int, GL_VERTEX_ARRAY, GL_COLOR_ARRAY, GL_TEXTURE_COORD_ARRAY> cs;
+	OGL_ENABLE(TEXTURE_2D);
+	OGL_BINDTEXTURE(s.texture->handle);
+	ogl_texwrap(s.texture, GL_CLAMP_TO_EDGE);
+	glVertexPointer(3, GL_FLOAT, 0, s.vertices.data());
+	glColorPointer(4, GL_FLOAT, 0, s.colors.data());
+	glTexCoordPointer(2, GL_FLOAT, 0, s.texcoords.data());
+	glDrawArrays(GL_TRIANGLES, 0, s.vertices.size() / 3);
+	s.vertices.clear();
+	s.texcoords.clear();
+	s.colors.clear();
+	s.texture = nullptr;
+}
+
+static void ogl_flush_batches()
+{
+	ogl_flush_text_batch();
+	ogl_flush_world_buffer();
+	ogl_flush_line_batch();
+	ogl_flush_sprite_batch();
+	ogl_flush_model_batch();
+}
+
+void ogl_begin_line_batch()
+{
+	ogl_lines.active = true;
+}
+
+void ogl_end_line_batch()
+{
+	ogl_flush_line_batch();
+	ogl_lines.active = false;
+}
+
+/* The endlevel terrain grid (-gl_worldbuffer).  The points are kept in
+ * world space with their light, so a frame only sends the indices of
+ * the cells it draws.
+ */
+namespace {
+
+struct ogl_terrain_vertex
+{
+	GLfloat x, y, z;
+	GLfloat u, v;
+	GLfloat r, g, b, a;
+};
+
+struct ogl_terrain_mesh
+{
+	GLuint vbo = 0;
+	std::vector<ogl_terrain_vertex> vertices;
+};
+
+}
+
+static ogl_terrain_mesh ogl_terrain;
+
+static void ogl_invalidate_terrain_buffer()
+{
+	auto &t = ogl_terrain;
+	if (t.vbo)
+	{
+		glDeleteBuffersFunc(1, &t.vbo);
+		t.vbo = 0;
+	}
+}
+
+void ogl_free_terrain_buffer()
+{
+	ogl_invalidate_terrain_buffer();
+	std::vector<ogl_terrain_vertex>().swap(ogl_terrain.vertices);
+}
+
+bool ogl_build_terrain_buffer(const unsigned count, const vms_vector *const points, const g3s_uvl *const uvls)
+{
+	ogl_free_terrain_buffer();
+	if (!CGameArg.OglWorldBuffer || !ogl_have_ARB_vertex_buffer_object)
+		return false;
+	auto &vertices = ogl_terrain.vertices;
+	vertices.resize(count);
+	for (unsigned i = 0; i != count; ++i)
+	{
+		auto &tv = vertices[i];
+		auto &p = points[i];
+		auto &uvl = uvls[i];
+		tv.x = f2glf(p.x);
+		tv.y = f2glf(p.y);
+		tv.z = f2glf(p.z);
+		tv.u = f2glf(uvl.u);
+		tv.v = f2glf(uvl.v);
+		tv.r = tv.g = tv.b = f2glf(uvl.l);
+		tv.a = 1.0;
+	}
+	return true;
+}
+
+bool ogl_draw_terrain(grs_canvas &canvas, grs_bitmap &bm, const uint16_t *const indices, const unsigned count)
+{
+	auto &t = ogl_terrain;
+	if (t.vertices.empty() || tmap_drawer_ptr != draw_tmap || canvas.cv_fade_level < GR_FADE_OFF || bm.get_flag_mask(BM_FLAG_NO_LIGHTING))
+		return false;
+	ogl_flush_batches();
+	if (!count)
+		return true;
+	if (!t.vbo)
+	{
+		glGenBuffersFunc(1, &t.vbo);
+		glBindBufferFunc(GL_ARRAY_BUFFER, t.vbo);
+		glBufferDataFunc(GL_ARRAY_BUFFER, t.vertices.size() * sizeof(ogl_terrain_vertex), t.vertices.data(), GL_STATIC_DRAW);
+		glBindBufferFunc(GL_ARRAY_BUFFER, 0);
+	}
+	ogl_client_states<int, GL_VERTEX_ARRAY, GL_COLOR_ARRAY, GL_TEXTURE_COORD_ARRAY> cs;
+	OGL_ENABLE(TEXTURE_2D);
+	ogl_bindbmtex(bm, 0);
+	ogl_texwrap(bm.gltexture, GL_REPEAT);
+	array<GLfloat, 16> modelview;
+	ogl_world_set_view_matrix(modelview);
+	glPushMatrix();
+	glMultMatrixf(modelview.data());
+	glBindBufferFunc(GL_ARRAY_BUFFER, t.vbo);
+	glVertexPointer(3, GL_FLOAT, sizeof(ogl_terrain_vertex), reinterpret_cast<const GLvoid *>(offsetof(ogl_terrain_vertex, x)));
+	glTexCoordPointer(2, GL_FLOAT, sizeof(ogl_terrain_vertex), reinterpret_cast<const GLvoid *>(offsetof(ogl_terrain_vertex, u)));
+	glColorPointer(4, GL_FLOAT, sizeof(ogl_terrain_vertex), reinterpret_cast<const GLvoid *>(offsetof(ogl_terrain_vertex, r)));
+	glBindBufferFunc(GL_ARRAY_BUFFER, 0);
+	glDrawElements(GL_TRIANGLES, count, GL_UNSIGNED_SHORT, indices);
+	glPopMatrix();
+	r_tpolyc += count / 3;
+	return true;
+}
+
+namespace {
+
+/* Both end points of every automap edge slot.  Only the colors and the
+ * list of slots to draw change from frame to frame.
+ */
+struct ogl_automap_buffer
+{
+	GLuint vbo = 0;
+	std::vector<GLfloat> positions;
+	std::vector<GLfloat> colors;
+	std::vector<GLuint> indices;
+};
+
+}
+
+static ogl_automap_buffer ogl_automap;
+
+static void ogl_invalidate_automap_buffer()
+{
+	auto &a = ogl_automap;
+	if (a.vbo)
+	{
+		glDeleteBuffersFunc(1, &a.vbo);
+		a.vbo = 0;
+	}
+}
+
+void ogl_free_automap_buffer()
+{
+	ogl_invalidate_automap_buffer();
+	std::vector<GLfloat>().swap(ogl_automap.positions);
+	std::vector<GLfloat>().swap(ogl_automap.colors);
+}
+
+bool ogl_build_automap_buffer(const unsigned count, const vms_vector *const points)
+{
+	ogl_invalidate_automap_buffer();
+	if (!CGameArg.OglWorldBuffer || !ogl_have_ARB_vertex_buffer_object)
+	{
+		ogl_free_automap_buffer();
+		return false;
+	}
+	auto &a = ogl_automap;
+	a.positions.resize(count * 2 * 3);
+	a.colors.resize(count * 2 * 4);
+	auto o = a.positions.begin();
+	for (auto p = points, e = points + count * 2; p != e; ++p)
+	{
+		*o++ = f2glf(p->x);
+		*o++ = f2glf(p->y);
+		*o++ = f2glf(p->z);
+	}
+	return true;
+}
+
+void ogl_draw_automap_edges(const uint32_t *const slots, const uint8_t *const colors, const unsigned count)
+{
+	auto &a = ogl_automap;
+	ogl_flush_batches();
+	if (!count || a.positions.empty())
+		return;
+	if (!a.vbo)
+	{
+		glGenBuffersFunc(1, &a.vbo);
+		glBindBufferFunc(GL_ARRAY_BUFFER, a.vbo);
+		glBufferDataFunc(GL_ARRAY_BUFFER, a.positions.size() * sizeof(GLfloat), a.positions.data(), GL_STATIC_DRAW);
+		glBindBufferFunc(GL_ARRAY_BUFFER, 0);
+	}
+	a.indices.clear();
+	for (unsigned i = 0; i != count; ++i)
+	{
+		const auto slot = slots[i];
+		const auto c = colors[i];
+		const GLfloat r = PAL2Tr(c), g = PAL2Tg(c), b = PAL2Tb(c);
+		auto cp = &a.colors[slot * 8];
+		cp[0] = cp[4] = r;
+		cp[1] = cp[5] = g;
+		cp[2] = cp[6] = b;
+		cp[3] = cp[7] = 1.0;
+		a.indices.emplace_back(slot * 2);
+		a.indices.emplace_back(slot * 2 + 1);
+	}
+	ogl_client_states<int, GL_VERTEX_ARRAY, GL_COLOR_ARRAY> cs;
+	OGL_DISABLE(TEXTURE_2D);
+	array<GLfloat, 16> modelview;
+	ogl_world_set_view_matrix(modelview);
+	glPushMatrix();
+	glMultMatrixf(modelview.data());
+	glBindBufferFunc(GL_ARRAY_BUFFER, a.vbo);
+	glVertexPointer(3, GL_FLOAT, 0, nullptr);
+	glBindBufferFunc(GL_ARRAY_BUFFER, 0);
+	glColorPointer(4, GL_FLOAT, 0, a.colors.data());
+	glDrawElements(GL_LINES, a.indices.size(), GL_UNSIGNED_INT, a.indices.data());
+	glPopMatrix();
+}
+
+/* Dynamic resolution of the main 3D view (-gl_dynres).  The view is
+ * drawn into a framebuffer object the size of its canvas, of which only
+ * a scaled part is used, and that part is stretched over the canvas
+ * before the HUD is drawn at full resolution.  The scale follows the
+ * GPU time of the view, from the timer below, toward the target.  A new
+ * scale allocates nothing, so it may change every frame.
+ */
+namespace {
+
+struct ogl_dynres_state
+{
+	GLuint framebuffer, depth, texture;
+	/* Size of the framebuffer, and of the part of it in use */
+	unsigned width, height, scaled_width, scaled_height;
+	float scale = 1;
+	bool bound, failed;
+};
+
+/* A quarter of the pixels, below which the view is too blurred to be
+ * worth the time saved.
+ */
+constexpr float ogl_dynres_min_scale = 0.5;
+
+}
+
+static ogl_dynres_state ogl_dynres;
+
+static void ogl_dynres_reset()
+{
+	auto &d = ogl_dynres;
+	if (d.framebuffer)
+	{
+		glDeleteFramebuffersFunc(1, &d.framebuffer);
+		glDeleteRenderbuffersFunc(1, &d.depth);
+		ogl_delete_texture(d.texture);
+	}
+	d = {};
+}
+
+static bool ogl_dynres_allocate(const unsigned w, const unsigned h)
+{
+	auto &d = ogl_dynres;
+	if (!d.framebuffer)
+	{
+		glGenFramebuffersFunc(1, &d.framebuffer);
+		glGenRenderbuffersFunc(1, &d.depth);
+		glGenTextures(1, &d.texture);
+	}
+	ogl_bind_texture_2d(d.texture);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, w, h, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+	glBindRenderbufferFunc(GL_RENDERBUFFER, d.depth);
+	glRenderbufferStorageFunc(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, w, h);
+	glBindRenderbufferFunc(GL_RENDERBUFFER, 0);
+	glBindFramebufferFunc(GL_FRAMEBUFFER, d.framebuffer);
+	glFramebufferTexture2DFunc(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, d.texture, 0);
+	glFramebufferRenderbufferFunc(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, d.depth);
+	const auto status = glCheckFramebufferStatusFunc(GL_FRAMEBUFFER);
+	glBindFramebufferFunc(GL_FRAMEBUFFER, 0);
+	if (status != GL_FRAMEBUFFER_COMPLETE)
+	{
+		con_printf(CON_URGENT, "DXX-Rebirth: OpenGL: framebuffer %ux%u incomplete (%#x), -gl_dynres disabled", w, h, status);
+		ogl_dynres_reset();
+		d.failed = true;
+		return false;
+	}
+	d.width = w;
+	d.height = h;
+	return true;
+}
+
+/* Fold in the GPU time of a view drawn at the given scale.  The cost
+ * of the view is about proportional to its area, so the scale which
+ * would have met the target is that times the square root of the
+ * ratio.  The sample is two frames old, so only a quarter of the way is
+ * taken each frame.
+ */
+static void ogl_dynres_sample(const float scale, const GLuint64 ns)
+{
+	const auto target = CGameArg.OglDynresTarget;
+	if (!target || !ns)
+		return;
+	auto &d = ogl_dynres;
+	const float ideal = scale * sqrt(static_cast<double>(target) * 1000000 / ns);
+	d.scale = std::min(1.f, std::max(ogl_dynres_min_scale, d.scale + (ideal - d.scale) / 4));
+}
+
+unsigned ogl_dynres_percent()
+{
+	return CGameArg.OglDynresTarget && !ogl_dynres.failed ? static_cast<unsigned>(ogl_dynres.scale * 100 + 0.5f) : 100;
+}
+
+bool ogl_dynres_begin(const grs_canvas &canvas)
+{
+	auto &d = ogl_dynres;
+	if (!CGameArg.OglDynresTarget || d.failed || !ogl_have_ARB_framebuffer_object || !ogl_have_ARB_timer_query)
+		return false;
+	const unsigned w = canvas.cv_bitmap.bm_w, h = canvas.cv_bitmap.bm_h;
+	if (!w || !h)
+		return false;
+	ogl_flush_batches();
+	if ((w != d.width || h != d.height) && !ogl_dynres_allocate(w, h))
+		return false;
+	d.scaled_width = std::max(1u, static_cast<unsigned>(w * d.scale));
+	d.scaled_height = std::max(1u, static_cast<unsigned>(h * d.scale));
+	glBindFramebufferFunc(GL_FRAMEBUFFER, d.framebuffer);
+	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+	d.bound = true;
+	return true;
+}
+
+void ogl_dynres_end(const grs_canvas &canvas)
+{
+	auto &d = ogl_dynres;
+	ogl_flush_batches();
+	glBindFramebufferFunc(GL_FRAMEBUFFER, 0);
+	d.bound = false;
+	/* g3_end_frame left the viewport on the whole screen, with the
+	 * orthographic projection of the 2D code.
+	 */
+	auto &bm = canvas.cv_bitmap;
+	const float sw = grd_curscreen->get_screen_width(), sh = grd_curscreen->get_screen_height();
+	const GLfloat xo = bm.bm_x / sw, xf = (bm.bm_x + bm.bm_w) / sw;
+	const GLfloat yo = 1.0 - (bm.bm_y + bm.bm_h) / sh, yf = 1.0 - bm.bm_y / sh;
+	const GLfloat u = static_cast<GLfloat>(d.scaled_width) / d.width, v = static_cast<GLfloat>(d.scaled_height) / d.height;
+	const array<GLfloat, 8> vertices{{
+		xo, yo,
+		xf, yo,
+		xf, yf,
+		xo, yf,
+	}};
+	const array<GLfloat, 8> texcoord_array{{
+		0, 0,
+		u, 0,
+		u, v,
+		0, v,
+	}};
+	ogl_client_states<int, GL_VERTEX_ARRAY, GL_TEXTURE_COORD_ARRAY> cs;
+	/* The alpha of the view is whatever its blending left. */
+	glDisable(GL_BLEND);
+	glDisable(GL_ALPHA_TEST);
+	OGL_ENABLE(TEXTURE_2D);
+	ogl_bind_texture_2d(d.texture);
+	glColor4f(1.0, 1.0, 1.0, 1.0);
+	glVertexPointer(2, GL_FLOAT, 0, vertices.data());
+	glTexCoordPointer(2, GL_FLOAT, 0, texcoord_array.data());
+	glDrawArrays(GL_TRIANGLE_FAN, 0, 4);
+	glEnable(GL_ALPHA_TEST);
+	glEnable(GL_BLEND);
+}
+
+/* GL_TIME_ELAPSED queries around the first 3D view of each frame
+ * ("profile gpu", and -gl_dynres).  A query is read back two frames
+ * after it ends, and only if its result is already available, so timing
+ * never stalls the pipeline.
+ */
+namespace {
+
+struct ogl_gpu_timer
+{
+	static constexpr unsigned depth = 3;
+	array<GLuint, depth> queries;
+	array<bool, depth> pending;
+	/* The -gl_dynres scale of the timed view, or 0 for another view */
+	array<float, depth> dynres_scale;
+	unsigned frame;
+	bool active, used_this_frame;
+};
+
+}
+
+static ogl_gpu_timer ogl_gpu_timing;
+
+static void ogl_gpu_timer_begin()
+{
+	auto &t = ogl_gpu_timing;
+	if (!(profile_gpu_timing || CGameArg.OglDynresTarget) || !ogl_have_ARB_timer_query || t.active || t.used_this_frame)
+		return;
+	if (!t.queries[0])
+		glGenQueriesFunc(t.queries.size(), t.queries.data());
+	const auto slot = t.frame % t.depth;
+	/* Its result never became available; do not reuse it yet. */
+	if (t.pending[slot])
+		return;
+	t.dynres_scale[slot] = ogl_dynres.bound ? ogl_dynres.scale : 0;
+	glBeginQueryFunc(GL_TIME_ELAPSED, t.queries[slot]);
+	t.active = true;
+	t.used_this_frame = true;
+}
+
+static void ogl_gpu_timer_end()
+{
+	auto &t = ogl_gpu_timing;
+	if (!t.active)
+		return;
+	glEndQueryFunc(GL_TIME_ELAPSED);
+	t.pending[t.frame % t.depth] = true;
+	t.active = false;
+}
+
+static void ogl_gpu_timer_next_frame()
+{
+	auto &t = ogl_gpu_timing;
+	ogl_gpu_timer_end();
+	t.used_this_frame = false;
+	/* The slot for the next frame was filled two frames ago. */
+	const auto slot = ++t.frame % t.depth;
+	if (!t.pending[slot])
+		return;
+	GLint available = 0;
+	glGetQueryObjectivFunc(t.queries[slot], GL_QUERY_RESULT_AVAILABLE, &available);
+	if (!available)
+		return;
+	GLuint64 ns = 0;
+	glGetQueryObjectui64vFunc(t.queries[slot], GL_QUERY_RESULT, &ns);
+	t.pending[slot] = false;
+	profile_add_time(profile_phase::gpu, ns / 1000);
+	if (const auto scale = t.dynres_scale[slot])
+		ogl_dynres_sample(scale, ns);
+}
+
+static void ogl_gpu_timer_reset()
+{
+	auto &t = ogl_gpu_timing;
+	if (t.queries[0])
+		glDeleteQueriesFunc(t.queries.size(), t.queries.data());
+	t = {};
+}
+
+/* GL_SAMPLES_PASSED queries against the screen space bounds of distant
+ * segments (-gl_occlusion).  The results of one frame decide what the
+ * next frame skips.  Results are collected only once the driver reports
+ * them available, and a segment whose query is still outstanding is not
+ * tested again, so the queries never stall the pipeline.
+ */
+namespace {
+
+struct ogl_occlusion_segment
+{
+	GLuint query;
+	/* The frame which issued its latest query */
+	unsigned frame;
+	bool pending, occluded;
+};
+
+struct ogl_occlusion_state
+{
+	unsigned frame;
+	std::vector<ogl_occlusion_segment> segments;
+	std::vector<unsigned> pending;
+};
+
+}
+
+static ogl_occlusion_state ogl_occlusion;
+
+bool ogl_occlusion_enabled()
+{
+	return CGameArg.OglOcclusionQueries && ogl_have_ARB_occlusion_query;
+}
+
+void ogl_occlusion_reset()
+{
+	auto &o = ogl_occlusion;
+	range_for (auto &s, o.segments)
+		if (s.query)
+			glDeleteQueriesFunc(1, &s.query);
+	std::vector<ogl_occlusion_segment>().swap(o.segments);
+	std::vector<unsigned>().swap(o.pending);
+	o.frame = 0;
+}
+
+void ogl_occlusion_begin_frame(const unsigned segment_count)
+{
+	auto &o = ogl_occlusion;
+	if (o.segments.size() != segment_count)
+	{
+		ogl_occlusion_reset();
+		o.segments.resize(segment_count);
+	}
+	++o.frame;
+	auto &pending = o.pending;
+	const auto e = pending.end();
+	const auto done = std::remove_if(pending.begin(), e, [&o](const unsigned segnum) {
+		auto &s = o.segments[segnum];
+		GLint available = 0;
+		glGetQueryObjectivFunc(s.query, GL_QUERY_RESULT_AVAILABLE, &available);
+		if (!available)
+			return false;
+		GLuint samples = 0;
+		glGetQueryObjectuivFunc(s.query, GL_QUERY_RESULT, &samples);
+		s.pending = false;
+		s.occluded = !samples;
+		return true;
+	});
+	pending.erase(done, e);
+}
+
+bool ogl_occlusion_occluded(const unsigned segnum)
+{
+	auto &o = ogl_occlusion;
+	if (segnum >= o.segments.size())
+		return false;
+	auto &s = o.segments[segnum];
+	/* A result is only trusted if the segment was tested in the last
+	 * frame or the one before, when the view was nearly the same.
+	 */
+	return s.occluded && s.frame + 2 >= o.frame;
+}
+
+void ogl_occlusion_begin_tests()
+{
+	ogl_flush_batches();
+	glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
+	glDepthMask(GL_FALSE);
+	glDisable(GL_CULL_FACE);
+	glDisable(GL_ALPHA_TEST);
+	OGL_DISABLE(TEXTURE_2D);
+	ogl_set_client_arrays(ogl_client_array_vertex);
+}
+
+void ogl_occlusion_test(const unsigned segnum, const GLfloat left, const GLfloat right, const GLfloat bot, const GLfloat top, const GLfloat z)
+{
+	auto &o = ogl_occlusion;
+	if (segnum >= o.segments.size())
+		return;
+	auto &s = o.segments[segnum];
+	if (s.pending)
+		return;
+	if (!s.query)
+		glGenQueriesFunc(1, &s.query);
+	const array<GLfloat, 12> vertices{{
+		left, bot, -z,
+		right, bot, -z,
+		right, top, -z,
+		left, top, -z,
+	}};
+	glBeginQueryFunc(GL_SAMPLES_PASSED, s.query);
+	glVertexPointer(3, GL_FLOAT, 0, vertices.data());
+	glDrawArrays(GL_TRIANGLE_FAN, 0, 4);
+	glEndQueryFunc(GL_SAMPLES_PASSED);
+	s.pending = true;
+	s.occluded = false;
+	s.frame = o.frame;
+	o.pending.emplace_back(segnum);
+}
+
+void ogl_occlusion_end_tests()
+{
+	glEnable(GL_ALPHA_TEST);
+	glEnable(GL_CULL_FACE);
+	glDepthMask(GL_TRUE);
+	glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+}
+
+}
+
+namespace dsx {
+
+void ogl_build_world_buffer()
+{
+	ogl_free_world_buffer();
+	if (!CGameArg.OglWorldBuffer)
+		return;
+	auto &w = ogl_world;
+	const unsigned vertex_count = (Highest_segment_index + 1) * MAX_SIDES_PER_SEGMENT * 4;
+	w.vertices = make_unique<ogl_world_vertex[]>(vertex_count);
+	w.colors = make_unique<GLfloat[]>(vertex_count * 4);
+	w.vertex_count = vertex_count;
+	auto &Vertices = LevelSharedVertexState.get_vertices();
+	auto &vcvertptr = Vertices.vcptr;
+	range_for (const auto &&segp, vcsegptridx)
+	{
+		for (unsigned sidenum = 0; sidenum != MAX_SIDES_PER_SEGMENT; ++sidenum)
+		{
+			const auto &&vertnum_list = get_side_verts(segp, sidenum);
+			auto &uvls = segp->unique_segment::sides[sidenum].uvls;
+			const auto first = &w.vertices[(segp.get_unchecked_index() * MAX_SIDES_PER_SEGMENT + sidenum) * 4];
+			for (unsigned i = 0; i != 4; ++i)
+			{
+				auto &wv = first[i];
+				auto &p = *vcvertptr(vertnum_list[i]);
+				wv.x = f2glf(p.x);
+				wv.y = f2glf(p.y);
+				wv.z = f2glf(p.z);
+				wv.u = f2glf(uvls[i].u);
+				wv.v = f2glf(uvls[i].v);
+				wv.r = -1;
+			}
+		}
+	}
+	w.indices.reserve(4096);
+	con_printf(CON_VERBOSE, "DXX-Rebirth: OpenGL: built world buffer with %u vertices", vertex_count);
+}
+
+}
+
+namespace dcx {
+
+namespace {
+
+/* A polygon model flattened by g3_build_polygon_model_mesh, with its
+ * positions and texture coordinates in a buffer object
+ * (-gl_modelbuffer).  Facing and lighting are still evaluated for each
+ * polygon every frame, exactly as the interpreter does, but no POF
+ * bytecode is walked and no points are rotated on the CPU.  Submodels
+ * outside the view are skipped, and a model farther away than
+ * -gl_modellod times its radius is drawn with the reduced polygon set
+ * of each submodel.
+ *
+ * With -gl_instancing, a second buffer holds every vertex with its
+ * polygon's plane, submodel and glow slot, so that a shader can do the
+ * facing and lighting of each polygon.  All the copies of a model drawn
+ * in a frame are then queued and drawn by one instanced call for each
+ * bitmap, with the transform of each submodel and the light of each
+ * copy in a uniform array.
+ */
+struct ogl_polymodel_mesh
+{
+	struct instance_range
+	{
+		uint8_t bitmap;
+		unsigned first, count;
+	};
+	const uint8_t *source = nullptr;
+	bool usable = false;
+	GLuint vbo = 0;
+	GLuint instance_vbo = 0;
+	/* Bitmaps used by the polygons, so the first n_bitmaps of the model's
+	 * list are what a queued copy must keep.
+	 */
+	unsigned n_bitmaps;
+	/* Indexed by whether the reduced polygon sets are drawn.  The
+	 * indices are sorted by bitmap, so each range is one draw.
+	 */
+	array<std::vector<GLushort>, 2> instance_indices;
+	array<std::vector<instance_range>, 2> instance_ranges;
+	array<unsigned, 2> instance_polygons;
+	polymodel_mesh mesh;
+};
+
+struct ogl_mesh_vertex
+{
+	GLfloat x, y, z;
+	GLfloat u, v;
+};
+
+/* d is the dot product of the polygon's point and normal, which the
+ * facing test compares with that of the eye.  glow is -1 when the
+ * polygon has no glow slot.
+ */
+struct ogl_instanced_mesh_vertex
+{
+	GLfloat x, y, z, d;
+	GLfloat u, v, node, glow;
+	GLfloat nx, ny, nz;
+};
+
+struct ogl_model_instance_group
+{
+	const ogl_polymodel_mesh *mesh;
+	bool lod;
+	unsigned count;
+	std::vector<grs_bitmap *> bitmaps;
+	/* stride vectors of 4 floats for each copy */
+	std::vector<GLfloat> data;
+};
+
+/* The groups are kept between frames, so that their vectors are not
+ * reallocated; only the first n_groups are queued.
+ */
+struct ogl_model_instance_batch
+{
+	unsigned n_groups;
+	std::vector<ogl_model_instance_group> groups;
+};
+
+}
+
+static ogl_model_instance_batch ogl_model_batch;
+
+static std::unordered_map<const polymodel *, ogl_polymodel_mesh> ogl_polymodel_meshes;
+/* Positions of the submodel being morphed, rewritten for every draw. */
+static GLuint ogl_morph_vbo;
+
+static void ogl_delete_polygon_model_mesh_buffers(ogl_polymodel_mesh &m)
+{
+	if (m.vbo)
+	{
+		glDeleteBuffersFunc(1, &m.vbo);
+		m.vbo = 0;
+	}
+	if (m.instance_vbo)
+	{
+		glDeleteBuffersFunc(1, &m.instance_vbo);
+		m.instance_vbo = 0;
+	}
+}
+
+void ogl_invalidate_polygon_model_meshes()
+{
+	if (ogl_morph_vbo)
+	{
+		glDeleteBuffersFunc(1, &ogl_morph_vbo);
+		ogl_morph_vbo = 0;
+	}
+	ogl_flush_model_batch();
+	range_for (auto &i, ogl_polymodel_meshes)
+		ogl_delete_polygon_model_mesh_buffers(i.second);
+}
+
+void ogl_free_polygon_model_mesh(const polymodel &po)
+{
+	const auto i = ogl_polymodel_meshes.find(&po);
+	if (i == ogl_polymodel_meshes.end())
+		return;
+	ogl_flush_model_batch();
+	ogl_delete_polygon_model_mesh_buffers(i->second);
+	ogl_polymodel_meshes.erase(i);
+}
+
+static void ogl_upload_polygon_model_mesh(ogl_polymodel_mesh &m)
+{
+	const auto &vertices = m.mesh.vertices;
+	const auto buffer = make_unique<ogl_mesh_vertex[]>(vertices.size());
+	auto *o = buffer.get();
+	range_for (auto &v, vertices)
+	{
+		o->x = f2glf(v.p.x);
+		o->y = f2glf(v.p.y);
+		o->z = f2glf(v.p.z);
+		o->u = f2glf(v.u);
+		o->v = f2glf(v.v);
+		++o;
+	}
+	glGenBuffersFunc(1, &m.vbo);
+	glBindBufferFunc(GL_ARRAY_BUFFER, m.vbo);
+	glBufferDataFunc(GL_ARRAY_BUFFER, vertices.size() * sizeof(ogl_mesh_vertex), buffer.get(), GL_STATIC_DRAW);
+	glBindBufferFunc(GL_ARRAY_BUFFER, 0);
+}
+
+static void ogl_upload_instanced_polygon_model_mesh(ogl_polymodel_mesh &m)
+{
+	auto &mesh = m.mesh;
+	const auto buffer = make_unique<ogl_instanced_mesh_vertex[]>(mesh.vertices.size());
+	unsigned n_bitmaps = 0;
+	std::vector<std::pair<uint8_t, uint16_t>> sorted;
+	for (unsigned lod = 0; lod != 2; ++lod)
+	{
+		sorted.clear();
+		for (unsigned n = 0, e = mesh.nodes.size(); n != e; ++n)
+		{
+			auto &node = mesh.nodes[n];
+			const unsigned n_polygons = lod ? node.n_lod_polygons : node.n_polygons;
+			for (unsigned k = 0; k != n_polygons; ++k)
+			{
+				const unsigned i = lod ? mesh.lod_polygons[node.first_lod_polygon + k] : node.first_polygon + k;
+				auto &poly = mesh.polygons[i];
+				sorted.emplace_back(poly.bitmap, i);
+				if (lod)
+					continue;
+				n_bitmaps = std::max(n_bitmaps, poly.bitmap + 1u);
+				const GLfloat d = f2glf(vm_vec_dot(poly.point, poly.normal));
+				for (unsigned j = poly.first_vertex, ej = j + poly.nv; j != ej; ++j)
+				{
+					auto &v = mesh.vertices[j];
+					auto &o = buffer[j];
+					o.x = f2glf(v.p.x);
+					o.y = f2glf(v.p.y);
+					o.z = f2glf(v.p.z);
+					o.d = d;
+					o.u = f2glf(v.u);
+					o.v = f2glf(v.v);
+					o.node = n;
+					o.glow = (poly.glow == UINT8_MAX) ? -1.0 : poly.glow;
+					o.nx = f2glf(poly.normal.x);
+					o.ny = f2glf(poly.normal.y);
+					o.nz = f2glf(poly.normal.z);
+				}
+			}
+		}
+		std::sort(sorted.begin(), sorted.end());
+		auto &indices = m.instance_indices[lod];
+		auto &ranges = m.instance_ranges[lod];
+		indices.clear();
+		ranges.clear();
+		m.instance_polygons[lod] = sorted.size();
+		for (auto i = sorted.begin(), e = sorted.end(); i != e;)
+		{
+			const auto bitmap = i->first;
+			const unsigned first = indices.size();
+			for (; i != e && i->first == bitmap; ++i)
+			{
+				auto &poly = mesh.polygons[i->second];
+				const GLushort fv = poly.first_vertex;
+				for (unsigned j = 1; j + 1 < poly.nv; ++j)
+				{
+					indices.emplace_back(fv);
+					indices.emplace_back(fv + j);
+					indices.emplace_back(fv + j + 1);
+				}
+			}
+			ranges.push_back({bitmap, first, static_cast<unsigned>(indices.size() - first)});
+		}
+	}
+	m.n_bitmaps = n_bitmaps;
+	glGenBuffersFunc(1, &m.instance_vbo);
+	glBindBufferFunc(GL_ARRAY_BUFFER, m.instance_vbo);
+	glBufferDataFunc(GL_ARRAY_BUFFER, mesh.vertices.size() * sizeof(ogl_instanced_mesh_vertex), buffer.get(), GL_STATIC_DRAW);
+	glBindBufferFunc(GL_ARRAY_BUFFER, 0);
+}
+
+/* Instanced model shader (-gl_instancing).  Each copy has stride
+ * vectors in instance_data: its light, with the alpha in w; its glow
+ * values and how many there are; then for each submodel the rows of
+ * the view matrix of that submodel and the eye in its frame, with w
+ * set if the submodel is drawn.  The facing test and the light are
+ * those of the interpreter.  A polygon not drawn has all its vertices
+ * moved to one point, so that nothing is rasterized.
+ */
+static ogl_program ogl_model_instance_program;
+static GLint ogl_model_instance_data, ogl_model_instance_stride, ogl_model_instance_no_lighting;
+/* Length of instance_data */
+static unsigned ogl_model_instance_vectors;
+
+static const char ogl_model_instance_vertex_shader[] =
+	"#version 120\n"
+	"#extension GL_ARB_draw_instanced : require\n"
+	"uniform vec4 instance_data[%u];\n"
+	"uniform int stride;\n"
+	"uniform float no_lighting;\n"
+	"void main()\n"
+	"{\n"
+	"	int base = gl_InstanceIDARB * stride;\n"
+	"	int node = base + 2 + int(gl_MultiTexCoord0.z) * 4;\n"
+	"	vec4 r0 = instance_data[node];\n"
+	"	vec4 r1 = instance_data[node + 1];\n"
+	"	vec4 r2 = instance_data[node + 2];\n"
+	"	vec4 eye = instance_data[node + 3];\n"
+	"	vec3 p = gl_Vertex.xyz;\n"
+	"	vec3 n = gl_Normal;\n"
+	"	gl_TexCoord[0] = vec4(gl_MultiTexCoord0.xy, 0.0, 1.0);\n"
+	"	if (eye.w == 0.0 || dot(eye.xyz, n) <= gl_Vertex.w)\n"
+	"	{\n"
+	"		gl_FrontColor = vec4(0.0);\n"
+	"		gl_Position = vec4(0.0, 0.0, 0.0, 1.0);\n"
+	"		return;\n"
+	"	}\n"
+	"	vec4 light = instance_data[base];\n"
+	"	vec4 glow = instance_data[base + 1];\n"
+	"	float g = gl_MultiTexCoord0.w;\n"
+	"	vec3 c;\n"
+	"	if (g >= 0.0 && g < glow.z)\n"
+	"		c = vec3(g < 0.5 ? glow.x : glow.y);\n"
+	"	else\n"
+	"		c = light.rgb * (0.25 - 0.75 * dot(r2.xyz, n));\n"
+	"	gl_FrontColor = vec4(mix(c, vec3(1.0), no_lighting), light.a);\n"
+	"	gl_Position = gl_ProjectionMatrix * vec4(dot(r0.xyz, p) + r0.w, dot(r1.xyz, p) + r1.w, -(dot(r2.xyz, p) + r2.w), 1.0);\n"
+	"}\n";
+
+static const char ogl_model_instance_fragment_shader[] =
+	"#version 120\n"
+	"uniform sampler2D tex;\n"
+	"void main()\n"
+	"{\n"
+	"	gl_FragColor = texture2D(tex, gl_TexCoord[0].xy) * gl_Color;\n"
+	"}\n";
+
+static bool ogl_use_model_instance_shader()
+{
+	if (!CGameArg.OglInstancing || !ogl_have_ARB_draw_instanced || !ogl_have_ARB_shader_objects)
+		return false;
+	auto &p = ogl_model_instance_program;
+	if (p)
+		return true;
+	if (p.build_failed())
+		return false;
+	/* Leave room for the uniforms of the shader itself and for those
+	 * the implementation reserves.  OpenGL 2.0 guarantees 512
+	 * components.
+	 */
+	GLint components = 512;
+	glGetIntegerv(GL_MAX_VERTEX_UNIFORM_COMPONENTS, &components);
+	const unsigned vectors = std::min(std::max(components, 512) / 4 - 32, 1024);
+	array<char, sizeof(ogl_model_instance_vertex_shader) + 8> vertex_shader;
+	snprintf(vertex_shader.data(), vertex_shader.size(), ogl_model_instance_vertex_shader, vectors);
+	if (!p.build("model instance", vertex_shader.data(), ogl_model_instance_fragment_shader))
+		return false;
+	ogl_model_instance_vectors = vectors;
+	p.use();
+	glUniform1iFunc(p.uniform("tex"), 0);
+	ogl_model_instance_data = p.uniform("instance_data");
+	ogl_model_instance_stride = p.uniform("stride");
+	ogl_model_instance_no_lighting = p.uniform("no_lighting");
+	ogl_program::use_fixed_function();
+	return true;
+}
+
+static void ogl_flush_model_batch()
+{
+	auto &b = ogl_model_batch;
+	const unsigned n_groups = b.n_groups;
+	if (!n_groups)
+		return;
+	/* Binding a texture may evict another, which flushes this batch. */
+	b.n_groups = 0;
+	ogl_client_states<int, GL_VERTEX_ARRAY, GL_TEXTURE_COORD_ARRAY> cs;
+	glEnableClientState(GL_NORMAL_ARRAY);
+	OGL_ENABLE(TEXTURE_2D);
+	auto &p = ogl_model_instance_program;
+	p.use();
+	range_for (auto &g, partial_range(b.groups, n_groups))
+	{
+		auto &m = *g.mesh;
+		const unsigned stride = 2 + 4 * m.mesh.nodes.size();
+		const unsigned per_call = ogl_model_instance_vectors / stride;
+		glBindBufferFunc(GL_ARRAY_BUFFER, m.instance_vbo);
+		glVertexPointer(4, GL_FLOAT, sizeof(ogl_instanced_mesh_vertex), reinterpret_cast<const GLvoid *>(offsetof(ogl_instanced_mesh_vertex, x)));
+		glTexCoordPointer(4, GL_FLOAT, sizeof(ogl_instanced_mesh_vertex), reinterpret_cast<const GLvoid *>(offsetof(ogl_instanced_mesh_vertex, u)));
+		glNormalPointer(GL_FLOAT, sizeof(ogl_instanced_mesh_vertex), reinterpret_cast<const GLvoid *>(offsetof(ogl_instanced_mesh_vertex, nx)));
+		glBindBufferFunc(GL_ARRAY_BUFFER, 0);
+		glUniform1iFunc(ogl_model_instance_stride, stride);
+		auto &indices = g.lod ? m.instance_indices[1] : m.instance_indices[0];
+		auto &ranges = g.lod ? m.instance_ranges[1] : m.instance_ranges[0];
+		for (unsigned first = 0; first < g.count; first += per_call)
+		{
+			const unsigned n = std::min(per_call, g.count - first);
+			glUniform4fvFunc(ogl_model_instance_data, n * stride, &g.data[first * stride * 4]);
+			range_for (auto &r, ranges)
+			{
+				auto &bm = *g.bitmaps[r.bitmap];
+				ogl_bindbmtex(bm, 0);
+				ogl_texwrap(bm.gltexture, GL_REPEAT);
+				glUniform1fFunc(ogl_model_instance_no_lighting, bm.get_flag_mask(BM_FLAG_NO_LIGHTING) ? 1.0 : 0.0);
+				glDrawElementsInstancedFunc(GL_TRIANGLES, r.count, GL_UNSIGNED_SHORT, &indices[r.first], n);
+			}
+		}
+		r_tpolyc += g.count * m.instance_polygons[g.lod];
+		g.data.clear();
+	}
+	glDisableClientState(GL_NORMAL_ARRAY);
+	ogl_program::use_fixed_function();
+}
+
+}
+
+namespace dsx {
+
+namespace {
+
+class ogl_mesh_draw_state
+{
+	const polymodel_mesh &mesh;
+	grs_bitmap *const *const model_bitmaps;
+	const submodel_angles anim_angles;
+	const g3s_lrgb model_light;
+	const glow_values_t *const glow_values;
+	const GLfloat alpha;
+	const bool lod;
+	std::vector<GLfloat> &colors;
+	std::vector<std::pair<uint8_t, uint16_t>> visible;
+	std::vector<GLushort> indices;
+	g3s_lrgb get_light(const polymodel_mesh::polygon &poly) const
+	{
+		if (poly.glow != UINT8_MAX && glow_values && poly.glow < glow_values->size())
+		{
+			const auto c = (*glow_values)[poly.glow];
+			return {c, c, c};
+		}
+		const auto negdot = -vm_vec_dot(View_matrix.fvec, poly.normal);
+		const auto color = (f1_0 / 4) + ((negdot * 3) / 4);
+		return {fixmul(color, model_light.r), fixmul(color, model_light.g), fixmul(color, model_light.b)};
+	}
+	void draw_polygons(const polymodel_mesh::node &node, bool check_facing);
+	void draw_subcalls(const polymodel_mesh::node &node);
+public:
+	ogl_mesh_draw_state(const polymodel_mesh &m, grs_bitmap *const *const mbitmaps, const submodel_angles aangles, const g3s_lrgb &mlight, const glow_values_t *const glvalues, const GLfloat a, const bool l, std::vector<GLfloat> &c) :
+		mesh(m), model_bitmaps(mbitmaps), anim_angles(aangles), model_light(mlight), glow_values(glvalues), alpha(a), lod(l), colors(c)
+	{
+	}
+	void draw_node(unsigned node_index);
+	void draw_morphing_node(unsigned node_index, GLuint mesh_vbo, GLuint positions);
+};
+
+void ogl_mesh_draw_state::draw_polygons(const polymodel_mesh::node &node, const bool check_facing)
+{
+	visible.clear();
+	const unsigned n_polygons = lod ? node.n_lod_polygons : node.n_polygons;
+	for (unsigned k = 0; k != n_polygons; ++k)
+	{
+		const unsigned i = lod ? mesh.lod_polygons[node.first_lod_polygon + k] : node.first_polygon + k;
+		auto &poly = mesh.polygons[i];
+		if (check_facing && !g3_check_normal_facing(poly.point, poly.normal))
+			continue;
+		const bool no_lighting = model_bitmaps[poly.bitmap]->get_flag_mask(BM_FLAG_NO_LIGHTING);
+		const auto &&light = get_light(poly);
+		const GLfloat r = no_lighting ? 1.0 : f2glf(light.r);
+		const GLfloat g = no_lighting ? 1.0 : f2glf(light.g);
+		const GLfloat b = no_lighting ? 1.0 : f2glf(light.b);
+		auto c = &colors[poly.first_vertex * 4];
+		for (unsigned j = poly.nv; j--; c += 4)
+		{
+			c[0] = r;
+			c[1] = g;
+			c[2] = b;
+			c[3] = alpha;
+		}
+		visible.emplace_back(poly.bitmap, i);
+	}
+	if (visible.empty())
+		return;
+	std::sort(visible.begin(), visible.end());
+	array<GLfloat, 16> modelview;
+	ogl_world_set_view_matrix(modelview);
+	glLoadMatrixf(modelview.data());
+	for (auto i = visible.begin(), e = visible.end(); i != e;)
+	{
+		const auto bitmap = i->first;
+		indices.clear();
+		for (; i != e && i->first == bitmap; ++i)
+		{
+			auto &poly = mesh.polygons[i->second];
+			const GLushort first = poly.first_vertex;
+			for (unsigned j = 1; j + 1 < poly.nv; ++j)
+			{
+				indices.emplace_back(first);
+				indices.emplace_back(first + j);
+				indices.emplace_back(first + j + 1);
+			}
+			r_tpolyc++;
+		}
+		auto &bm = *model_bitmaps[bitmap];
+		ogl_bindbmtex(bm, 0);
+		ogl_texwrap(bm.gltexture, GL_REPEAT);
+		glDrawElements(GL_TRIANGLES, indices.size(), GL_UNSIGNED_SHORT, indices.data());
+	}
 }
 
-static void ogl_bindbmtex(grs_bitmap &bm, bool edgepad){
-	if (bm.gltexture==NULL || bm.gltexture->handle<=0)
-		ogl_loadbmtexture(bm, edgepad);
-	OGL_BINDTEXTURE(bm.gltexture->handle);
-	bm.gltexture->numrend++;
+void ogl_mesh_draw_state::draw_node(const unsigned node_index)
+{
+	auto &node = mesh.nodes[node_index];
+	if (node.n_polygons)
+		draw_polygons(node, true);
+	draw_subcalls(node);
 }
 
-//gltexture MUST be bound first
-static void ogl_texwrap(ogl_texture *const gltexture, const int state)
+/* The morphing interpreter draws every polygon of the morphing submodel,
+ * facing or not, and the submodels it calls as usual.
+ */
+void ogl_mesh_draw_state::draw_morphing_node(const unsigned node_index, const GLuint mesh_vbo, const GLuint positions)
 {
-	if (gltexture->wrapstate != state || gltexture->numrend < 1)
+	auto &node = mesh.nodes[node_index];
+	if (node.n_polygons)
 	{
-		gltexture->wrapstate = state;
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, state);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, state);
+		glBindBufferFunc(GL_ARRAY_BUFFER, positions);
+		glVertexPointer(3, GL_FLOAT, 0, nullptr);
+		glBindBufferFunc(GL_ARRAY_BUFFER, 0);
+		draw_polygons(node, false);
+		glBindBufferFunc(GL_ARRAY_BUFFER, mesh_vbo);
+		glVertexPointer(3, GL_FLOAT, sizeof(ogl_mesh_vertex), reinterpret_cast<const GLvoid *>(offsetof(ogl_mesh_vertex, x)));
+		glBindBufferFunc(GL_ARRAY_BUFFER, 0);
 	}
+	draw_subcalls(node);
 }
 
-//crude texture precaching
-//handles: powerups, walls, weapons, polymodels, etc.
-//it is done with the horrid do_special_effects kludge so that sides that have to be texmerged and have animated textures will be correctly cached.
-//similarly, with the objects(esp weapons), we could just go through and cache em all instead, but that would get ones that might not even be on the level
-//TODO: doors
-
-void ogl_cache_polymodel_textures(const unsigned model_num)
+void ogl_mesh_draw_state::draw_subcalls(const polymodel_mesh::node &node)
 {
-	auto &Polygon_models = LevelSharedPolygonModelState.Polygon_models;
-	if (model_num >= Polygon_models.size())
-		return;
-	const auto &po = Polygon_models[model_num];
-	unsigned i = po.first_texture;
-	const unsigned last_texture = i + po.n_textures;
-	for (; i != last_texture; ++i)
+	constexpr vms_angvec zero_angles{0, 0, 0};
+	const unsigned end_subcall = node.first_subcall + node.n_subcalls;
+	for (unsigned i = node.first_subcall; i != end_subcall; ++i)
 	{
-		ogl_loadbmtexture(GameBitmaps[ObjBitmaps[ObjBitmapPtrs[i]].index], 1);
+		auto &sc = mesh.subcalls[i];
+		g3_start_instance_angles(sc.offset, anim_angles ? anim_angles[sc.submodel] : zero_angles);
+		auto &child = mesh.nodes[sc.node];
+		if (g3_check_sphere_visible(child.center, child.radius))
+			draw_node(sc.node);
+		g3_done_instance();
 	}
 }
 
-static void ogl_cache_vclip_textures(const vclip &vc)
+}
+
+static ogl_polymodel_mesh *ogl_get_polygon_model_mesh(const polymodel &po)
 {
-	range_for (auto &i, partial_const_range(vc.frames, vc.num_frames))
+	if (!CGameArg.OglModelBuffer || !ogl_have_ARB_vertex_buffer_object || tmap_drawer_ptr != draw_tmap)
+		return nullptr;
+	const auto data = po.model_data.get();
+	if (!data)
+		return nullptr;
+	auto &m = ogl_polymodel_meshes[&po];
+	if (m.source != data)
 	{
-		PIGGY_PAGE_IN(i);
-		ogl_loadbmtexture(GameBitmaps[i.index], 0);
+		ogl_flush_model_batch();
+		ogl_delete_polygon_model_mesh_buffers(m);
+		m.source = data;
+		m.usable = g3_build_polygon_model_mesh(data, m.mesh);
 	}
+	if (!m.usable)
+		return nullptr;
+	if (!m.vbo)
+		ogl_upload_polygon_model_mesh(m);
+	return &m;
 }
 
-static void ogl_cache_vclipn_textures(const d_vclip_array &Vclip, const unsigned i)
+/* Write the transform of a submodel and of the submodels it calls into
+ * the data of a queued copy, in the frame set up by the caller.
+ */
+static void ogl_set_model_instance_nodes(const polymodel_mesh &mesh, const unsigned node_index, const submodel_angles anim_angles, GLfloat *const data)
 {
-	if (i < Vclip.size())
-		ogl_cache_vclip_textures(Vclip[i]);
+	const auto &vm = View_matrix;
+	const auto &vp = View_position;
+	const vms_vector *const rows[3] = {&vm.rvec, &vm.uvec, &vm.fvec};
+	auto o = &data[(2 + 4 * node_index) * 4];
+	range_for (const auto r, rows)
+	{
+		*o++ = f2glf(r->x);
+		*o++ = f2glf(r->y);
+		*o++ = f2glf(r->z);
+		*o++ = -(f2glf(r->x) * f2glf(vp.x) + f2glf(r->y) * f2glf(vp.y) + f2glf(r->z) * f2glf(vp.z));
+	}
+	*o++ = f2glf(vp.x);
+	*o++ = f2glf(vp.y);
+	*o++ = f2glf(vp.z);
+	*o++ = 1.0;
+	constexpr vms_angvec zero_angles{0, 0, 0};
+	auto &node = mesh.nodes[node_index];
+	const unsigned end_subcall = node.first_subcall + node.n_subcalls;
+	for (unsigned i = node.first_subcall; i != end_subcall; ++i)
+	{
+		auto &sc = mesh.subcalls[i];
+		g3_start_instance_angles(sc.offset, anim_angles ? anim_angles[sc.submodel] : zero_angles);
+		auto &child = mesh.nodes[sc.node];
+		if (g3_check_sphere_visible(child.center, child.radius))
+			ogl_set_model_instance_nodes(mesh, sc.node, anim_angles, data);
+		g3_done_instance();
+	}
 }
 
-static void ogl_cache_weapon_textures(const d_vclip_array &Vclip, const weapon_info_array &Weapon_info, const unsigned weapon_type)
+/* Queue an opaque copy of a model for ogl_flush_model_batch.  Copies
+ * of one model are grouped if they use the same bitmaps and polygon
+ * set.  The pose of the submodels is part of the data of each copy, so
+ * it need not match.
+ */
+static bool ogl_queue_polygon_model_instance(ogl_polymodel_mesh &m, const polymodel &po, grs_bitmap *const *const model_bitmaps, const submodel_angles anim_angles, const g3s_lrgb &light, const glow_values_t *const glow_values, const bool lod)
 {
-	if (weapon_type >= Weapon_info.size())
-		return;
-	const auto &w = Weapon_info[weapon_type];
-	ogl_cache_vclipn_textures(Vclip, w.flash_vclip);
-	ogl_cache_vclipn_textures(Vclip, w.robot_hit_vclip);
-	ogl_cache_vclipn_textures(Vclip, w.wall_hit_vclip);
-	if (w.render_type == WEAPON_RENDER_VCLIP)
-		ogl_cache_vclipn_textures(Vclip, w.weapon_vclip);
-	else if (w.render_type == WEAPON_RENDER_POLYMODEL)
+	if (!ogl_use_model_instance_shader())
+		return false;
+	if (!m.instance_vbo)
+		ogl_upload_instanced_polygon_model_mesh(m);
+	const unsigned stride = 2 + 4 * m.mesh.nodes.size();
+	if (stride > ogl_model_instance_vectors || m.n_bitmaps > po.n_textures)
+		return false;
+	auto &b = ogl_model_batch;
+	const auto groups_begin = b.groups.begin();
+	const auto groups_end = groups_begin + b.n_groups;
+	auto g = std::find_if(groups_begin, groups_end, [&m, lod, model_bitmaps](const ogl_model_instance_group &i) {
+		return i.mesh == &m && i.lod == lod && std::equal(i.bitmaps.begin(), i.bitmaps.end(), model_bitmaps);
+	});
+	if (g == groups_end)
 	{
-		ogl_cache_polymodel_textures(w.model_num);
-		ogl_cache_polymodel_textures(w.model_num_inner);
+		if (b.n_groups == b.groups.size())
+			b.groups.emplace_back();
+		g = b.groups.begin() + b.n_groups++;
+		g->mesh = &m;
+		g->lod = lod;
+		g->count = 0;
+		g->bitmaps.assign(model_bitmaps, model_bitmaps + m.n_bitmaps);
+		g->data.clear();
+	}
+	auto &data = g->data;
+	const auto base = data.size();
+	/* Submodels left at 0 are not drawn. */
+	data.resize(base + stride * 4);
+	const auto o = &data[base];
+	o[0] = f2glf(light.r);
+	o[1] = f2glf(light.g);
+	o[2] = f2glf(light.b);
+	o[3] = 1.0;
+	if (glow_values)
+	{
+		for (unsigned i = 0; i != glow_values->size(); ++i)
+			o[4 + i] = f2glf((*glow_values)[i]);
+		o[6] = glow_values->size();
 	}
+	ogl_set_model_instance_nodes(m.mesh, 0, anim_angles, o);
+	++g->count;
+	return true;
 }
 
-namespace dsx {
+template <typename F>
+static void ogl_draw_mesh(grs_canvas &canvas, const ogl_polymodel_mesh &m, F &&draw)
+{
+	ogl_flush_batches();
+	static std::vector<GLfloat> colors;
+	colors.resize(m.mesh.vertices.size() * 4);
+	const GLfloat alpha = (canvas.cv_fade_level >= GR_FADE_OFF) ? 1.0 : (1.0 - static_cast<float>(canvas.cv_fade_level) / (static_cast<float>(GR_FADE_LEVELS) - 1.0));
+	ogl_client_states<int, GL_VERTEX_ARRAY, GL_COLOR_ARRAY, GL_TEXTURE_COORD_ARRAY> cs;
+	OGL_ENABLE(TEXTURE_2D);
+	glBindBufferFunc(GL_ARRAY_BUFFER, m.vbo);
+	glVertexPointer(3, GL_FLOAT, sizeof(ogl_mesh_vertex), reinterpret_cast<const GLvoid *>(offsetof(ogl_mesh_vertex, x)));
+	glTexCoordPointer(2, GL_FLOAT, sizeof(ogl_mesh_vertex), reinterpret_cast<const GLvoid *>(offsetof(ogl_mesh_vertex, u)));
+	glBindBufferFunc(GL_ARRAY_BUFFER, 0);
+	glColorPointer(4, GL_FLOAT, 0, colors.data());
+	draw(colors, alpha);
+	glLoadIdentity();
+}
 
-void ogl_cache_level_textures(void)
+bool ogl_draw_polygon_model_mesh(grs_canvas &canvas, const polymodel &po, grs_bitmap *const *const model_bitmaps, const submodel_angles anim_angles, const g3s_lrgb light, const glow_values_t *const glow_values)
 {
-	int max_efx=0,ef;
-	
-	ogl_reset_texture_stats_internal();//loading a new lev should reset textures
-	
-	range_for (auto &ec, partial_const_range(Effects, Num_effects))
-	{
-		ogl_cache_vclipn_textures(Vclip, ec.dest_vclip);
-		if ((ec.changing_wall_texture == -1) && (ec.changing_object_texture==-1) )
-			continue;
-		if (ec.vc.num_frames>max_efx)
-			max_efx=ec.vc.num_frames;
-	}
-	glmprintf((CON_DEBUG, "max_efx:%i", max_efx));
-	for (ef=0;ef<max_efx;ef++){
-		range_for (eclip &ec, partial_range(Effects, Num_effects))
-		{
-			if ((ec.changing_wall_texture == -1) && (ec.changing_object_texture==-1) )
-				continue;
-			ec.time_left=-1;
-		}
-		do_special_effects();
+	const auto m = ogl_get_polygon_model_mesh(po);
+	if (!m)
+		return false;
+	/* The model is instanced, so View_position is the eye relative to
+	 * the model.
+	 */
+	const bool lod = CGameArg.OglModelLod && static_cast<fix>(vm_vec_mag_quick(View_position)) > static_cast<int64_t>(CGameArg.OglModelLod) * po.rad;
+	if (canvas.cv_fade_level >= GR_FADE_OFF && ogl_queue_polygon_model_instance(*m, po, model_bitmaps, anim_angles, light, glow_values, lod))
+		return true;
+	ogl_draw_mesh(canvas, *m, [&](std::vector<GLfloat> &colors, const GLfloat alpha) {
+		ogl_mesh_draw_state state(m->mesh, model_bitmaps, anim_angles, light, glow_values, alpha, lod, colors);
+		state.draw_node(0);
+	});
+	return true;
+}
 
-		range_for (const unique_segment &seg, vcsegptr)
-		{
-			range_for (auto &side, seg.sides)
-			{
-				const auto tmap1 = side.tmap_num;
-				const auto tmap2 = side.tmap_num2;
-				if (tmap1<0 || tmap1>=NumTextures){
-					glmprintf((CON_DEBUG, "ogl_cache_level_textures %p %p %i %i", seg.get_unchecked_pointer(), &side, tmap1, NumTextures));
-					//				tmap1=0;
-					continue;
-				}
-				PIGGY_PAGE_IN(Textures[tmap1]);
-				grs_bitmap *bm = &GameBitmaps[Textures[tmap1].index];
-				if (tmap2 != 0){
-					PIGGY_PAGE_IN(Textures[tmap2&0x3FFF]);
-					auto &bm2 = GameBitmaps[Textures[tmap2&0x3FFF].index];
-					if (CGameArg.DbgUseOldTextureMerge || bm2.get_flag_mask(BM_FLAG_SUPER_TRANSPARENT))
-						bm = &texmerge_get_cached_bitmap( tmap1, tmap2 );
-					else {
-						ogl_loadbmtexture(bm2, 1);
-					}
-				}
-				ogl_loadbmtexture(*bm, 0);
-			}
-		}
-		glmprintf((CON_DEBUG, "finished ef:%i", ef));
+bool ogl_draw_morphing_submodel_mesh(grs_canvas &canvas, const polymodel &po, const unsigned submodel_num, grs_bitmap *const *const model_bitmaps, const submodel_angles anim_angles, const g3s_lrgb light, const vms_vector *const morph_points, const std::size_t n_morph_points)
+{
+	const auto m = ogl_get_polygon_model_mesh(po);
+	if (!m)
+		return false;
+	auto &mesh = m->mesh;
+	unsigned node_index = 0;
+	if (submodel_num)
+	{
+		const auto i = std::find_if(mesh.subcalls.begin(), mesh.subcalls.end(), [submodel_num](const polymodel_mesh::subcall &sc) {
+			return sc.submodel == submodel_num;
+		});
+		if (i == mesh.subcalls.end())
+			return false;
+		node_index = i->node;
 	}
-	reset_special_effects();
-	init_special_effects();
+	/* The polygons of a node are contiguous, and so are their vertices,
+	 * so only that range of the dynamic buffer is written.
+	 */
+	auto &node = mesh.nodes[node_index];
+	if (node.n_polygons)
 	{
-		auto &Robot_info = LevelSharedRobotInfoState.Robot_info;
-		// always have lasers, concs, flares.  Always shows player appearance, and at least concs are always available to disappear.
-		ogl_cache_weapon_textures(Vclip, Weapon_info, Primary_weapon_to_weapon_info[primary_weapon_index_t::LASER_INDEX]);
-		ogl_cache_weapon_textures(Vclip, Weapon_info, Secondary_weapon_to_weapon_info[CONCUSSION_INDEX]);
-		ogl_cache_weapon_textures(Vclip, Weapon_info, weapon_id_type::FLARE_ID);
-		ogl_cache_vclipn_textures(Vclip, VCLIP_PLAYER_APPEARANCE);
-		ogl_cache_vclipn_textures(Vclip, VCLIP_POWERUP_DISAPPEARANCE);
-		ogl_cache_polymodel_textures(Player_ship->model_num);
-		ogl_cache_vclipn_textures(Vclip, Player_ship->expl_vclip_num);
-
-		range_for (const auto &&objp, vcobjptridx)
+		auto &last = mesh.polygons[node.first_polygon + node.n_polygons - 1];
+		const unsigned first_vertex = mesh.polygons[node.first_polygon].first_vertex;
+		const unsigned end_vertex = last.first_vertex + last.nv;
+		static std::vector<GLfloat> positions;
+		positions.resize((end_vertex - first_vertex) * 3);
+		auto o = positions.begin();
+		for (unsigned i = first_vertex; i != end_vertex; ++i)
 		{
-			if (objp->type == OBJ_POWERUP && objp->render_type==RT_POWERUP)
-			{
-				ogl_cache_vclipn_textures(Vclip, objp->rtype.vclip_info.vclip_num);
-				const auto id = get_powerup_id(objp);
-				primary_weapon_index_t p;
-				secondary_weapon_index_t s;
-				int w;
-				if (
-					(
-						(
-							(id == POW_VULCAN_WEAPON && (p = primary_weapon_index_t::VULCAN_INDEX, true)) ||
-							(id == POW_SPREADFIRE_WEAPON && (p = primary_weapon_index_t::SPREADFIRE_INDEX, true)) ||
-							(id == POW_PLASMA_WEAPON && (p = primary_weapon_index_t::PLASMA_INDEX, true)) ||
-							(id == POW_FUSION_WEAPON && (p = primary_weapon_index_t::FUSION_INDEX, true))
-						) && (w = Primary_weapon_to_weapon_info[p], true)
-					) ||
-					(
-						(
-							(id == POW_PROXIMITY_WEAPON && (s = secondary_weapon_index_t::PROXIMITY_INDEX, true)) ||
-							((id == POW_HOMING_AMMO_1 || id == POW_HOMING_AMMO_4) && (s = secondary_weapon_index_t::HOMING_INDEX, true)) ||
-							(id == POW_SMARTBOMB_WEAPON && (s = secondary_weapon_index_t::SMART_INDEX, true)) ||
-							(id == POW_MEGA_WEAPON && (s = secondary_weapon_index_t::MEGA_INDEX, true))
-						) && (w = Secondary_weapon_to_weapon_info[s], true)
-					)
-				)
-				{
-					ogl_cache_weapon_textures(Vclip, Weapon_info, w);
-				}
-			}
-			else if (objp->type != OBJ_NONE && objp->render_type==RT_POLYOBJ)
-			{
-				if (objp->type == OBJ_ROBOT)
-				{
-					auto &ri = Robot_info[get_robot_id(objp)];
-					ogl_cache_vclipn_textures(Vclip, ri.exp1_vclip_num);
-					ogl_cache_vclipn_textures(Vclip, ri.exp2_vclip_num);
-					ogl_cache_weapon_textures(Vclip, Weapon_info, ri.weapon_type);
-				}
-				if (objp->rtype.pobj_info.tmap_override != -1)
-				{
-					auto &t = Textures[objp->rtype.pobj_info.tmap_override];
-					PIGGY_PAGE_IN(t);
-					ogl_loadbmtexture(GameBitmaps[t.index], 1);
-				}
-				else
-					ogl_cache_polymodel_textures(objp->rtype.pobj_info.model_num);
-			}
+			const unsigned pt = mesh.vertices[i].point;
+			if (pt >= n_morph_points)
+				return false;
+			auto &p = morph_points[pt];
+			*o++ = f2glf(p.x);
+			*o++ = f2glf(p.y);
+			*o++ = f2glf(p.z);
 		}
+		if (!ogl_morph_vbo)
+			glGenBuffersFunc(1, &ogl_morph_vbo);
+		glBindBufferFunc(GL_ARRAY_BUFFER, ogl_morph_vbo);
+		/* Orphan the previous contents, so that the driver need not wait
+		 * for draws that still read them.
+		 */
+		glBufferDataFunc(GL_ARRAY_BUFFER, mesh.vertices.size() * 3 * sizeof(GLfloat), nullptr, GL_STREAM_DRAW);
+		glBufferSubDataFunc(GL_ARRAY_BUFFER, first_vertex * 3 * sizeof(GLfloat), positions.size() * sizeof(GLfloat), positions.data());
+		glBindBufferFunc(GL_ARRAY_BUFFER, 0);
 	}
-	glmprintf((CON_DEBUG, "finished caching"));
-	r_cachedtexcount = r_texcount;
+	ogl_draw_mesh(canvas, *m, [&](std::vector<GLfloat> &colors, const GLfloat alpha) {
+		/* The morphing interpreter ignores glow values. */
+		ogl_mesh_draw_state state(mesh, model_bitmaps, anim_angles, light, nullptr, alpha, false, colors);
+		state.draw_morphing_node(node_index, m->vbo, ogl_morph_vbo);
+	});
+	return true;
 }
 
 }
@@ -537,6 +2765,22 @@ void g3_draw_line(grs_canvas &canvas, const g3s_point &p0, const g3s_point &p1,
 	GLfloat color_r, color_g, color_b;
 	GLfloat color_array[] = { 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0 };
   
+	auto &l = ogl_lines;
+	if (l.active)
+	{
+		ogl_flush_text_batch();
+		ogl_flush_world_buffer();
+		ogl_flush_sprite_batch();
+		ogl_flush_model_batch();
+		const GLfloat r = PAL2Tr(c), g = PAL2Tg(c), b = PAL2Tb(c);
+		l.vertices.insert(l.vertices.end(), {
+			f2glf(p0.p3_vec.x), f2glf(p0.p3_vec.y), -f2glf(p0.p3_vec.z),
+			f2glf(p1.p3_vec.x), f2glf(p1.p3_vec.y), -f2glf(p1.p3_vec.z)
+		});
+		l.colors.insert(l.colors.end(), {r, g, b, 1.0, r, g, b, 1.0});
+		return;
+	}
+	ogl_flush_batches();
 	ogl_client_states<int, GL_VERTEX_ARRAY, GL_COLOR_ARRAY> cs;
 	OGL_DISABLE(TEXTURE_2D);
 	color_r = PAL2Tr(c);
@@ -555,12 +2799,11 @@ void g3_draw_line(grs_canvas &canvas, const g3s_point &p0, const g3s_point &p1,
 	glDrawArrays(GL_LINES, 0, 2);
 }
 
+/* The caller enables the arrays, so that it can add colors. */
 static void ogl_drawcircle(const unsigned nsides, const unsigned type, GLfloat *const vertices)
 {
-	glEnableClientState(GL_VERTEX_ARRAY);
 	glVertexPointer(2, GL_FLOAT, 0, vertices);
 	glDrawArrays(type, 0, nsides);
-	glDisableClientState(GL_VERTEX_ARRAY);
 }
 
 static std::unique_ptr<GLfloat[]> circle_array_init(const unsigned nsides)
@@ -591,6 +2834,7 @@ static std::unique_ptr<GLfloat[]> circle_array_init_2(const unsigned nsides, con
 
 void ogl_draw_vertex_reticle(int cross,int primary,int secondary,int color,int alpha,int size_offs)
 {
+	ogl_flush_batches();
 	int size=270+(size_offs*20);
 	float scale = (static_cast<float>(SWIDTH)/SHEIGHT);
 	const array<float, 4> ret_rgba{{
@@ -642,8 +2886,7 @@ void ogl_draw_vertex_reticle(int cross,int primary,int secondary,int color,int a
 	glLineWidth(linedotscale*2);
 	OGL_DISABLE(TEXTURE_2D);
 	glDisable(GL_CULL_FACE);
-	glEnableClientState(GL_VERTEX_ARRAY);
-	glEnableClientState(GL_COLOR_ARRAY);
+	ogl_set_client_arrays(ogl_client_array_vertex | ogl_client_array_color);
 	
 	//cross
 	array<GLfloat, 8 * 4> cross_lca;
@@ -757,8 +3000,6 @@ void ogl_draw_vertex_reticle(int cross,int primary,int secondary,int color,int a
 	}
 	ogl_drawcircle(16, GL_LINE_LOOP, secondary_lva_ptr);
 	
-	//glDisableClientState(GL_VERTEX_ARRAY);
-	glDisableClientState(GL_COLOR_ARRAY);
 	glPopMatrix();
 	glLineWidth(linedotscale);
 }
@@ -773,6 +3014,7 @@ void g3_draw_sphere(grs_canvas &canvas, cg3s_point &pnt, fix rad, const uint8_t
 	int i;
 	const float scale = (static_cast<float>(canvas.cv_bitmap.bm_w) / canvas.cv_bitmap.bm_h);
 	array<GLfloat, 20 * 4> color_array;
+	ogl_flush_batches();
 	for (i = 0; i < 20*4; i += 4)
 	{
 		color_array[i] = CPAL2Tr(c);
@@ -800,16 +3042,16 @@ void g3_draw_sphere(grs_canvas &canvas, cg3s_point &pnt, fix rad, const uint8_t
 	glScalef(gl1, gl2, f2glf(rad));
 	if(!sphere_va)
 		sphere_va = circle_array_init(20);
-	glEnableClientState(GL_COLOR_ARRAY);
+	ogl_set_client_arrays(ogl_client_array_vertex | ogl_client_array_color);
 	glColorPointer(4, GL_FLOAT, 0, color_array.data());
 	ogl_drawcircle(20, GL_TRIANGLE_FAN, sphere_va.get());
-	glDisableClientState(GL_COLOR_ARRAY);
 	glPopMatrix();
 }
 
 int gr_ucircle(grs_canvas &canvas, const fix xc1, const fix yc1, const fix r1, const uint8_t c)
 {
 	int nsides;
+	ogl_flush_batches();
 	OGL_DISABLE(TEXTURE_2D);
 	glColor4f(CPAL2Tr(c), CPAL2Tg(c), CPAL2Tb(c), (canvas.cv_fade_level >= GR_FADE_OFF)?1.0:1.0 - static_cast<float>(canvas.cv_fade_level) / (static_cast<float>(GR_FADE_LEVELS) - 1.0));
 	glPushMatrix();
@@ -820,6 +3062,7 @@ int gr_ucircle(grs_canvas &canvas, const fix xc1, const fix yc1, const fix r1, c
 	nsides = 10 + 2 * static_cast<int>(M_PI * f2fl(r1) / 19);
 	if(!circle_va)
 		circle_va = circle_array_init(nsides);
+	ogl_set_client_arrays(ogl_client_array_vertex);
 	ogl_drawcircle(nsides, GL_LINE_LOOP, circle_va.get());
 	glPopMatrix();
 	return 0;
@@ -828,6 +3071,7 @@ int gr_ucircle(grs_canvas &canvas, const fix xc1, const fix yc1, const fix r1, c
 int gr_disk(grs_canvas &canvas, const fix x, const fix y, const fix r, const uint8_t c)
 {
 	int nsides;
+	ogl_flush_batches();
 	OGL_DISABLE(TEXTURE_2D);
 	glColor4f(CPAL2Tr(c), CPAL2Tg(c), CPAL2Tb(c), (canvas.cv_fade_level >= GR_FADE_OFF) ? 1.0 : 1.0 - static_cast<float>(canvas.cv_fade_level) / (static_cast<float>(GR_FADE_LEVELS) - 1.0));
 	glPushMatrix();
@@ -838,6 +3082,7 @@ int gr_disk(grs_canvas &canvas, const fix x, const fix y, const fix r, const uin
 	nsides = 10 + 2 * static_cast<int>(M_PI * f2fl(r) / 19);
 	if(!disk_va)
 		disk_va = circle_array_init(nsides);
+	ogl_set_client_arrays(ogl_client_array_vertex);
 	ogl_drawcircle(nsides, GL_TRIANGLE_FAN, disk_va.get());
 	glPopMatrix();
 	return 0;
@@ -858,10 +3103,10 @@ void _g3_draw_poly(grs_canvas &canvas, const uint_fast32_t nv, cg3s_point *const
 		GLfloat r, g, b, a;
 	};
 	static_assert(sizeof(cfloat) == sizeof(GLfloat) * 4, "cfloat size wrong");
-	RAIIdmem<GLfloat[]> color_array;
-
-	auto &&vertices = make_unique<GLfloat[]>(nv * 3);
-	MALLOC(color_array, GLfloat[], nv*4);
+	ogl_flush_batches();
+	frame_alloc_scope scratch;
+	const auto vertices = scratch.allocate<GLfloat>(nv * 3);
+	const auto color_array = scratch.allocate<GLfloat>(nv * 4);
 
 	r_polyc++;
 	ogl_client_states<int, GL_VERTEX_ARRAY, GL_COLOR_ARRAY> cs;
@@ -872,8 +3117,8 @@ void _g3_draw_poly(grs_canvas &canvas, const uint_fast32_t nv, cg3s_point *const
 		? 1.0
 		: 1.0 - static_cast<float>(canvas.cv_fade_level) / (static_cast<float>(GR_FADE_LEVELS) - 1.0);
 
-	vfloat *const varray = reinterpret_cast<vfloat *>(vertices.get());
-	cfloat *const carray = reinterpret_cast<cfloat *>(color_array.get());
+	vfloat *const varray = reinterpret_cast<vfloat *>(vertices);
+	cfloat *const carray = reinterpret_cast<cfloat *>(color_array);
 	for (unsigned c=0; c < nv; ++c)
 	{
 		carray[c].r = color_r;
@@ -887,7 +3132,7 @@ void _g3_draw_poly(grs_canvas &canvas, const uint_fast32_t nv, cg3s_point *const
 	}
 
 	glVertexPointer(3, GL_FLOAT, 0, varray);
-	glColorPointer(4, GL_FLOAT, 0, color_array.get());
+	glColorPointer(4, GL_FLOAT, 0, color_array);
 	glDrawArrays(GL_TRIANGLE_FAN, 0, nv);
 }
 
@@ -899,11 +3144,12 @@ void _g3_draw_tmap(grs_canvas &canvas, const unsigned nv, cg3s_point *const *con
 	int index2, index3, index4;
 	GLfloat color_alpha = 1.0;
 
+	ogl_flush_batches();
 	ogl_client_states<int, GL_VERTEX_ARRAY, GL_COLOR_ARRAY> cs;
 	auto &c = std::get<0>(cs);
 	
 	if (tmap_drawer_ptr == draw_tmap) {
-		glEnableClientState(GL_TEXTURE_COORD_ARRAY);
+		ogl_set_client_arrays(ogl_client_array_vertex | ogl_client_array_color | ogl_client_array_texcoord);
 		OGL_ENABLE(TEXTURE_2D);
 		ogl_bindbmtex(bm, 0);
 		ogl_texwrap(bm.gltexture, GL_REPEAT);
@@ -918,10 +3164,10 @@ void _g3_draw_tmap(grs_canvas &canvas, const unsigned nv, cg3s_point *const *con
 		return;
 	}
 
-	RAIIdmem<GLfloat[]> vertices, color_array, texcoord_array;
-	MALLOC(vertices, GLfloat[], nv*3);
-	MALLOC(color_array, GLfloat[], nv*4);
-	MALLOC(texcoord_array, GLfloat[], nv*2);
+	frame_alloc_scope scratch;
+	const auto vertices = scratch.allocate<GLfloat>(nv * 3);
+	const auto color_array = scratch.allocate<GLfloat>(nv * 4);
+	const auto texcoord_array = scratch.allocate<GLfloat>(nv * 2);
 
 	for (c=0; c<nv; c++) {
 		index2 = c * 2;
@@ -945,17 +3191,133 @@ void _g3_draw_tmap(grs_canvas &canvas, const unsigned nv, cg3s_point *const *con
 		texcoord_array[index2+1] = f2glf(uvl_list[c].v);
 	}
 	
-	glVertexPointer(3, GL_FLOAT, 0, vertices.get());
-	glColorPointer(4, GL_FLOAT, 0, color_array.get());
+	glVertexPointer(3, GL_FLOAT, 0, vertices);
+	glColorPointer(4, GL_FLOAT, 0, color_array);
 	if (tmap_drawer_ptr == draw_tmap) {
-		glTexCoordPointer(2, GL_FLOAT, 0, texcoord_array.get());  
+		glTexCoordPointer(2, GL_FLOAT, 0, texcoord_array);
 	}
 	
 	glDrawArrays(GL_TRIANGLE_FAN, 0, nv);
-	
-	glDisableClientState(GL_VERTEX_ARRAY);
-	glDisableClientState(GL_COLOR_ARRAY);
-	glDisableClientState(GL_TEXTURE_COORD_ARRAY);
+}
+
+}
+
+namespace dcx {
+
+/* Single pass overlay shader (-gl_overlayshader).  The overlay texture
+ * coordinates are rotated by orient in the vertex shader.  Super
+ * transparent overlay pixels, which ogl_filltexbuf stores as white with
+ * zero alpha, cut a hole through both textures.
+ */
+static ogl_program ogl_overlay_program;
+static GLint ogl_overlay_orient, ogl_overlay_super_transparent;
+
+static const char ogl_overlay_vertex_shader[] =
+	"#version 110\n"
+	"uniform int orient;\n"
+	"varying vec2 top_coord;\n"
+	"void main()\n"
+	"{\n"
+	"	vec2 uv = gl_MultiTexCoord0.xy;\n"
+	"	if (orient == 1)\n"
+	"		top_coord = vec2(1.0 - uv.y, uv.x);\n"
+	"	else if (orient == 2)\n"
+	"		top_coord = vec2(1.0 - uv.x, 1.0 - uv.y);\n"
+	"	else if (orient == 3)\n"
+	"		top_coord = vec2(uv.y, 1.0 - uv.x);\n"
+	"	else\n"
+	"		top_coord = uv;\n"
+	"	gl_TexCoord[0] = gl_MultiTexCoord0;\n"
+	"	gl_FrontColor = gl_Color;\n"
+	"	gl_Position = ftransform();\n"
+	"}\n";
+
+static const char ogl_overlay_fragment_shader[] =
+	"#version 110\n"
+	"uniform sampler2D bottom;\n"
+	"uniform sampler2D top;\n"
+	"uniform bool super_transparent;\n"
+	"varying vec2 top_coord;\n"
+	"void main()\n"
+	"{\n"
+	"	vec4 b = texture2D(bottom, gl_TexCoord[0].xy);\n"
+	"	vec4 t = texture2D(top, top_coord);\n"
+	"	if (super_transparent && t.a < 0.5 && t.r + t.g + t.b > 2.5)\n"
+	"		discard;\n"
+	"	gl_FragColor = vec4(mix(b.rgb, t.rgb, t.a), max(b.a, t.a)) * gl_Color;\n"
+	"}\n";
+
+bool ogl_use_overlay_shader()
+{
+	if (!CGameArg.OglOverlayShader || !ogl_have_ARB_shader_objects || !ogl_have_ARB_multitexture)
+		return false;
+	auto &p = ogl_overlay_program;
+	if (p)
+		return true;
+	if (p.build_failed())
+		return false;
+	if (!p.build("overlay", ogl_overlay_vertex_shader, ogl_overlay_fragment_shader))
+		return false;
+	p.use();
+	glUniform1iFunc(p.uniform("bottom"), 0);
+	glUniform1iFunc(p.uniform("top"), 1);
+	ogl_overlay_orient = p.uniform("orient");
+	ogl_overlay_super_transparent = p.uniform("super_transparent");
+	ogl_program::use_fixed_function();
+	return true;
+}
+
+void ogl_reset_shaders()
+{
+	ogl_overlay_program.reset();
+	ogl_model_instance_program.reset();
+	ogl_reset_pixel_light_shaders();
+}
+
+static void ogl_draw_tmap_overlay_shader(grs_canvas &canvas, const unsigned nv, const g3s_point *const *const pointlist, const g3s_uvl *const uvl_list, const g3s_lrgb *const light_rgb, grs_bitmap &bmbot, grs_bitmap &bm, const unsigned orient)
+{
+	ogl_flush_batches();
+	ogl_client_states<int, GL_VERTEX_ARRAY, GL_COLOR_ARRAY, GL_TEXTURE_COORD_ARRAY> cs;
+	r_tpolyc++;
+	OGL_ENABLE(TEXTURE_2D);
+	const bool super_transparent = bm.get_flag_mask(BM_FLAG_SUPER_TRANSPARENT);
+	ogl_active_texture(1);
+	ogl_bindbmtex(bm, !super_transparent);
+	ogl_texwrap(bm.gltexture, GL_REPEAT);
+	ogl_active_texture(0);
+	ogl_bindbmtex(bmbot, 0);
+	ogl_texwrap(bmbot.gltexture, GL_REPEAT);
+
+	const GLfloat alpha = (canvas.cv_fade_level >= GR_FADE_OFF)
+		? 1.0
+		: (1.0 - static_cast<float>(canvas.cv_fade_level) / (static_cast<float>(GR_FADE_LEVELS) - 1.0));
+	const bool no_lighting = bmbot.get_flag_mask(BM_FLAG_NO_LIGHTING);
+	array<GLfloat, MAX_POINTS_PER_POLY * 3> vertices;
+	array<GLfloat, MAX_POINTS_PER_POLY * 4> color_array;
+	array<GLfloat, MAX_POINTS_PER_POLY * 2> texcoord_array;
+	for (unsigned c = 0; c != nv; ++c)
+	{
+		const auto index2 = c * 2, index3 = c * 3, index4 = c * 4;
+		vertices[index3]     = f2glf(pointlist[c]->p3_vec.x);
+		vertices[index3+1]   = f2glf(pointlist[c]->p3_vec.y);
+		vertices[index3+2]   = -f2glf(pointlist[c]->p3_vec.z);
+		color_array[index4]      = no_lighting ? 1.0 : f2glf(light_rgb[c].r);
+		color_array[index4+1]    = no_lighting ? 1.0 : f2glf(light_rgb[c].g);
+		color_array[index4+2]    = no_lighting ? 1.0 : f2glf(light_rgb[c].b);
+		color_array[index4+3]    = alpha;
+		texcoord_array[index2]   = f2glf(uvl_list[c].u);
+		texcoord_array[index2+1] = f2glf(uvl_list[c].v);
+	}
+
+	auto &p = ogl_overlay_program;
+	p.use();
+	glUniform1iFunc(ogl_overlay_orient, orient);
+	glUniform1iFunc(ogl_overlay_super_transparent, super_transparent);
+	glVertexPointer(3, GL_FLOAT, 0, vertices.data());
+	glColorPointer(4, GL_FLOAT, 0, color_array.data());
+	glTexCoordPointer(2, GL_FLOAT, 0, texcoord_array.data());
+	glDrawArrays(GL_TRIANGLE_FAN, 0, nv);
+	ogl_program::use_fixed_function();
 }
 
 }
@@ -963,14 +3325,84 @@ void _g3_draw_tmap(grs_canvas &canvas, const unsigned nv, cg3s_point *const *con
 /*
  * Everything texturemapped with secondary texture (walls with secondary texture)
  */
+/* A wall face with an overlay, drawn with the overlay shader from the
+ * world buffer, so that only its light colors come from the CPU.
+ */
+bool ogl_draw_world_overlay_face(grs_canvas &canvas, const unsigned segnum, const unsigned sidenum, const unsigned nv, const array<unsigned, 4> &corners, const array<g3s_lrgb, 4> &light_rgb, grs_bitmap &bmbot, grs_bitmap &bm, const unsigned orient)
+{
+#if DXX_USE_OGLES
+	(void)canvas;
+	(void)segnum;
+	(void)sidenum;
+	(void)nv;
+	(void)corners;
+	(void)light_rgb;
+	(void)bmbot;
+	(void)bm;
+	(void)orient;
+	return false;
+#else
+	auto &w = ogl_world;
+	const bool no_lighting = bmbot.get_flag_mask(BM_FLAG_NO_LIGHTING);
+	if (tmap_drawer_ptr != draw_tmap || no_lighting != static_cast<bool>(bm.get_flag_mask(BM_FLAG_NO_LIGHTING)))
+		return false;
+	const unsigned base = (segnum * MAX_SIDES_PER_SEGMENT + sidenum) * 4;
+	if (base + 4 > w.vertex_count || !ogl_use_overlay_shader() || !ogl_world_upload())
+		return false;
+	ogl_flush_batches();
+	ogl_world_update_side(segnum, sidenum, base, false);
+	ogl_world_set_colors(canvas, base, nv, corners, light_rgb, no_lighting);
+	auto &indices = w.overlay_indices;
+	indices.clear();
+	ogl_world_add_indices(indices, base, nv, corners);
+
+	ogl_client_states<int, GL_VERTEX_ARRAY, GL_COLOR_ARRAY, GL_TEXTURE_COORD_ARRAY> cs;
+	r_tpolyc++;
+	OGL_ENABLE(TEXTURE_2D);
+	const bool super_transparent = bm.get_flag_mask(BM_FLAG_SUPER_TRANSPARENT);
+	ogl_active_texture(1);
+	ogl_bindbmtex(bm, !super_transparent);
+	ogl_texwrap(bm.gltexture, GL_REPEAT);
+	ogl_active_texture(0);
+	ogl_bindbmtex(bmbot, 0);
+	ogl_texwrap(bmbot.gltexture, GL_REPEAT);
+
+	auto &p = ogl_overlay_program;
+	p.use();
+	glUniform1iFunc(ogl_overlay_orient, orient);
+	glUniform1iFunc(ogl_overlay_super_transparent, super_transparent);
+	array<GLfloat, 16> modelview;
+	ogl_world_set_view_matrix(modelview);
+	glPushMatrix();
+	glMultMatrixf(modelview.data());
+	glBindBufferFunc(GL_ARRAY_BUFFER, w.vbo);
+	glVertexPointer(3, GL_FLOAT, sizeof(ogl_world_vertex), reinterpret_cast<const GLvoid *>(offsetof(ogl_world_vertex, x)));
+	glTexCoordPointer(2, GL_FLOAT, sizeof(ogl_world_vertex), reinterpret_cast<const GLvoid *>(offsetof(ogl_world_vertex, u)));
+	glBindBufferFunc(GL_ARRAY_BUFFER, 0);
+	glColorPointer(4, GL_FLOAT, 0, w.colors.get());
+	glDrawElements(GL_TRIANGLES, indices.size(), GL_UNSIGNED_INT, indices.data());
+	glPopMatrix();
+	ogl_program::use_fixed_function();
+	return true;
+#endif
+}
+
 void _g3_draw_tmap_2(grs_canvas &canvas, const unsigned nv, const g3s_point *const *const pointlist, const g3s_uvl *uvl_list, const g3s_lrgb *light_rgb, grs_bitmap &bmbot, grs_bitmap &bm, const unsigned orient)
 {
 	int index2, index3;
 
-	RAIIdmem<GLfloat[]> vertices, color_array, texcoord_array;
-	MALLOC(vertices, GLfloat[], nv*3);
-	MALLOC(color_array, GLfloat[], nv*4);
-	MALLOC(texcoord_array, GLfloat[], nv*2);
+	if (tmap_drawer_ptr == draw_tmap && nv <= MAX_POINTS_PER_POLY &&
+		bmbot.get_flag_mask(BM_FLAG_NO_LIGHTING) == bm.get_flag_mask(BM_FLAG_NO_LIGHTING) &&
+		ogl_use_overlay_shader())
+	{
+		ogl_draw_tmap_overlay_shader(canvas, nv, pointlist, uvl_list, light_rgb, bmbot, bm, orient);
+		return;
+	}
+
+	frame_alloc_scope scratch;
+	const auto vertices = scratch.allocate<GLfloat>(nv * 3);
+	const auto color_array = scratch.allocate<GLfloat>(nv * 4);
+	const auto texcoord_array = scratch.allocate<GLfloat>(nv * 2);
 
 	_g3_draw_tmap(canvas, nv, pointlist, uvl_list, light_rgb, bmbot);//draw the bottom texture first.. could be optimized with multitexturing..
 	
@@ -988,7 +3420,7 @@ void _g3_draw_tmap_2(grs_canvas &canvas, const unsigned nv, const g3s_point *con
 			GLfloat r, g, b, a;
 		};
 		static_assert(sizeof(rgba) == sizeof(GLfloat) * 4, "padding error");
-		rgba *const ca = reinterpret_cast<rgba *>(color_array.get());
+		rgba *const ca = reinterpret_cast<rgba *>(color_array);
 		const GLfloat alpha = (canvas.cv_fade_level >= GR_FADE_OFF)
 			? 1.0
 			: (1.0 - static_cast<float>(canvas.cv_fade_level) / (static_cast<float>(GR_FADE_LEVELS) - 1.0));
@@ -1043,9 +3475,9 @@ void _g3_draw_tmap_2(grs_canvas &canvas, const unsigned nv, const g3s_point *con
 		vertices[index3+2]   = -f2glf(pointlist[c]->p3_vec.z);
 	}
 	
-	glVertexPointer(3, GL_FLOAT, 0, vertices.get());
-	glColorPointer(4, GL_FLOAT, 0, color_array.get());
-	glTexCoordPointer(2, GL_FLOAT, 0, texcoord_array.get());  
+	glVertexPointer(3, GL_FLOAT, 0, vertices);
+	glColorPointer(4, GL_FLOAT, 0, color_array);
+	glTexCoordPointer(2, GL_FLOAT, 0, texcoord_array);
 	glDrawArrays(GL_TRIANGLE_FAN, 0, nv);
 }
 
@@ -1057,79 +3489,43 @@ namespace dcx {
 void g3_draw_bitmap(grs_canvas &canvas, const vms_vector &pos, const fix iwidth, const fix iheight, grs_bitmap &bm)
 {
 	r_bitmapc++;
-	
-	ogl_client_states<int, GL_VERTEX_ARRAY, GL_COLOR_ARRAY, GL_TEXTURE_COORD_ARRAY> cs;
-	auto &i = std::get<0>(cs);
 
-	OGL_ENABLE(TEXTURE_2D);
-	ogl_bindbmtex(bm, 0);
-	ogl_texwrap(bm.gltexture,GL_CLAMP_TO_EDGE);
+	ogl_flush_text_batch();
+	ogl_flush_world_buffer();
+	ogl_flush_line_batch();
+	ogl_flush_model_batch();
+	if (bm.gltexture==NULL || bm.gltexture->handle<=0)
+		ogl_loadbmtexture_lazy(bm, 0);
+	auto &s = ogl_sprites;
+	if (s.texture != bm.gltexture)
+	{
+		ogl_flush_sprite_batch();
+		s.texture = bm.gltexture;
+	}
+	bm.gltexture->numrend++;
+	ogl_texture_touch(*bm.gltexture);
 
 	const auto width = fixmul(iwidth, Matrix_scale.x);
 	const auto height = fixmul(iheight, Matrix_scale.y);
-	constexpr unsigned point_count = 4;
-	struct fvertex_t
-	{
-		GLfloat x, y, z;
-	};
-	struct fcolor_t
-	{
-		GLfloat r, g, b, a;
-	};
-	struct ftexcoord_t
-	{
-		GLfloat u, v;
-	};
-	array<fvertex_t, point_count> vertices;
-	array<fcolor_t, point_count> color_array;
-	array<ftexcoord_t, point_count> texcoord_array;
 	const auto &v1 = vm_vec_sub(pos,View_position);
 	const auto &rpv = vm_vec_rotate(v1,View_matrix);
-	const auto bmglu = bm.gltexture->u;
-	const auto bmglv = bm.gltexture->v;
-	const auto alpha = canvas.cv_fade_level >= GR_FADE_OFF ? 1.0 : (1.0 - static_cast<float>(canvas.cv_fade_level) / (static_cast<float>(GR_FADE_LEVELS) - 1.0));
-	const auto vert_z = -f2glf(rpv.z);
-	for (i=0;i<4;i++){
-		auto pv = rpv;
-		switch (i){
-			case 0:
-				texcoord_array[i].u = 0.0;
-				texcoord_array[i].v = 0.0;
-				pv.x+=-width;
-				pv.y+=height;
-				break;
-			case 1:
-				texcoord_array[i].u = bmglu;
-				texcoord_array[i].v = 0.0;
-				pv.x+=width;
-				pv.y+=height;
-				break;
-			case 2:
-				texcoord_array[i].u = bmglu;
-				texcoord_array[i].v = bmglv;
-				pv.x+=width;
-				pv.y+=-height;
-				break;
-			case 3:
-				texcoord_array[i].u = 0.0;
-				texcoord_array[i].v = bmglv;
-				pv.x+=-width;
-				pv.y+=-height;
-				break;
-		}
-
-		color_array[i].r = 1.0;
-		color_array[i].g = 1.0;
-		color_array[i].b = 1.0;
-		color_array[i].a = alpha;
-		vertices[i].x = f2glf(pv.x);
-		vertices[i].y = f2glf(pv.y);
-		vertices[i].z = vert_z;
-	}
-	glVertexPointer(3, GL_FLOAT, 0, vertices.data());
-	glColorPointer(4, GL_FLOAT, 0, color_array.data());
-	glTexCoordPointer(2, GL_FLOAT, 0, texcoord_array.data());
-	glDrawArrays(GL_TRIANGLE_FAN, 0, 4); // Replaced GL_QUADS
+	const GLfloat bmglu = bm.gltexture->u;
+	const GLfloat bmglv = bm.gltexture->v;
+	const GLfloat alpha = canvas.cv_fade_level >= GR_FADE_OFF ? 1.0 : (1.0 - static_cast<float>(canvas.cv_fade_level) / (static_cast<float>(GR_FADE_LEVELS) - 1.0));
+	const GLfloat x0 = f2glf(rpv.x - width), x1 = f2glf(rpv.x + width);
+	const GLfloat y0 = f2glf(rpv.y + height), y1 = f2glf(rpv.y - height);
+	const GLfloat vert_z = -f2glf(rpv.z);
+	/* The corners of the old fan 0-1-2-3, as triangles 0-1-2 and 0-2-3. */
+	s.vertices.insert(s.vertices.end(), {
+		x0, y0, vert_z, x1, y0, vert_z, x1, y1, vert_z,
+		x0, y0, vert_z, x1, y1, vert_z, x0, y1, vert_z
+	});
+	s.texcoords.insert(s.texcoords.end(), {
+		0.0, 0.0, bmglu, 0.0, bmglu, bmglv,
+		0.0, 0.0, bmglu, bmglv, 0.0, bmglv
+	});
+	for (unsigned i = 0; i != 6; ++i)
+		s.colors.insert(s.colors.end(), {1.0, 1.0, 1.0, alpha});
 }
 
 /*
@@ -1150,6 +3546,7 @@ bool ogl_ubitblt_i(unsigned dw,unsigned dh,unsigned dx,unsigned dy, unsigned sw,
 			ogl_freetexture(t);
 		}
 	};
+	ogl_flush_batches();
 	ogl_client_states<bitblt_free_ogl_texture, GL_VERTEX_ARRAY, GL_COLOR_ARRAY, GL_TEXTURE_COORD_ARRAY> cs;
 	ogl_texture &tex = std::get<0>(cs).t;
 	r_ubitbltc++;
@@ -1199,6 +3596,171 @@ bool ogl_ubitblt_i(unsigned dw,unsigned dh,unsigned dx,unsigned dy, unsigned sw,
 	return 0;
 }
 
+/* Movies drawn by a shader: the 8 bit frame is streamed into a single
+ * channel texture and the palette into a 256x1 texture, so a frame
+ * costs one upload of its indices instead of a conversion to RGBA and
+ * a new texture.  Bilinear filtering is done in the shader after the
+ * palette lookup, since color indices cannot be interpolated.
+ */
+namespace {
+
+struct ogl_movie_state
+{
+	ogl_program program;
+	GLint size, limit, bilinear;
+	GLuint frame_texture, palette_texture;
+	unsigned tw, th;
+	palette_array_t palette;
+	bool palette_loaded;
+};
+
+}
+
+static ogl_movie_state ogl_movie;
+
+static const char ogl_movie_vertex_shader[] =
+	"#version 110\n"
+	"void main()\n"
+	"{\n"
+	"	gl_TexCoord[0] = gl_MultiTexCoord0;\n"
+	"	gl_Position = ftransform();\n"
+	"}\n";
+
+static const char ogl_movie_fragment_shader[] =
+	"#version 110\n"
+	"uniform sampler2D frame;\n"
+	"uniform sampler2D palette;\n"
+	"uniform vec2 size;\n"
+	"uniform vec2 limit;\n"
+	"uniform bool bilinear;\n"
+	"vec3 texel(vec2 uv)\n"
+	"{\n"
+	"	float i = texture2D(frame, min(uv, limit)).r;\n"
+	"	return texture2D(palette, vec2(i * (255.0 / 256.0) + 0.5 / 256.0, 0.5)).rgb;\n"
+	"}\n"
+	"void main()\n"
+	"{\n"
+	"	vec2 uv = gl_TexCoord[0].xy;\n"
+	"	if (!bilinear)\n"
+	"	{\n"
+	"		gl_FragColor = vec4(texel(uv), 1.0);\n"
+	"		return;\n"
+	"	}\n"
+	"	vec2 p = uv * size - 0.5;\n"
+	"	vec2 f = fract(p);\n"
+	"	vec2 base = (floor(p) + 0.5) / size;\n"
+	"	vec2 d = 1.0 / size;\n"
+	"	vec3 top = mix(texel(base), texel(base + vec2(d.x, 0.0)), f.x);\n"
+	"	vec3 bottom = mix(texel(base + vec2(0.0, d.y)), texel(base + d), f.x);\n"
+	"	gl_FragColor = vec4(mix(top, bottom, f.y), 1.0);\n"
+	"}\n";
+
+static void ogl_movie_reset()
+{
+	auto &m = ogl_movie;
+	m.program.reset();
+	if (m.frame_texture)
+		ogl_delete_texture(m.frame_texture);
+	if (m.palette_texture)
+		ogl_delete_texture(m.palette_texture);
+	m.frame_texture = m.palette_texture = 0;
+	m.tw = m.th = 0;
+	m.palette_loaded = false;
+}
+
+static GLuint ogl_movie_texture(const GLint internalformat, const GLenum format, const unsigned w, const unsigned h)
+{
+	GLuint handle;
+	glGenTextures(1, &handle);
+	ogl_bind_texture_2d(handle);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+	glTexImage2D(GL_TEXTURE_2D, 0, internalformat, w, h, 0, format, GL_UNSIGNED_BYTE, nullptr);
+	return handle;
+}
+
+bool ogl_draw_movie_frame(const uint8_t *const buf, const unsigned sw, const unsigned sh, unsigned dx, unsigned dy, const unsigned dw, const unsigned dh, grs_bitmap &dest, const bool bilinear)
+{
+	if (!ogl_have_ARB_shader_objects || !ogl_have_ARB_multitexture)
+		return false;
+	auto &m = ogl_movie;
+	auto &p = m.program;
+	if (!p)
+	{
+		if (p.build_failed())
+			return false;
+		if (!p.build("movie", ogl_movie_vertex_shader, ogl_movie_fragment_shader))
+			return false;
+		p.use();
+		glUniform1iFunc(p.uniform("frame"), 0);
+		glUniform1iFunc(p.uniform("palette"), 1);
+		m.size = p.uniform("size");
+		m.limit = p.uniform("limit");
+		m.bilinear = p.uniform("bilinear");
+		ogl_program::use_fixed_function();
+	}
+	ogl_flush_batches();
+	ogl_client_states<int, GL_VERTEX_ARRAY, GL_TEXTURE_COORD_ARRAY> cs;
+	r_ubitbltc++;
+	OGL_ENABLE(TEXTURE_2D);
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+
+	ogl_active_texture(1);
+	if (!m.palette_texture)
+		m.palette_texture = ogl_movie_texture(GL_RGB8, GL_RGB, 256, 1);
+	else
+		ogl_bind_texture_2d(m.palette_texture);
+	if (!m.palette_loaded || m.palette != gr_current_pal)
+	{
+		array<GLubyte, 256 * 3> rgb;
+		for (unsigned i = 0; i != 256; ++i)
+		{
+			rgb[i * 3] = gr_current_pal[i].r * 4;
+			rgb[i * 3 + 1] = gr_current_pal[i].g * 4;
+			rgb[i * 3 + 2] = gr_current_pal[i].b * 4;
+		}
+		glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, 256, 1, GL_RGB, GL_UNSIGNED_BYTE, rgb.data());
+		m.palette = gr_current_pal;
+		m.palette_loaded = true;
+	}
+	ogl_active_texture(0);
+
+	if (!m.frame_texture || m.tw < sw || m.th < sh)
+	{
+		if (m.frame_texture)
+			ogl_delete_texture(m.frame_texture);
+		m.tw = pow2ize(sw);
+		m.th = pow2ize(sh);
+		m.frame_texture = ogl_movie_texture(GL_LUMINANCE8, GL_LUMINANCE, m.tw, m.th);
+	}
+	else
+		OGL_BINDTEXTURE(m.frame_texture);
+	glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, sw, sh, GL_LUMINANCE, GL_UNSIGNED_BYTE, buf);
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+
+	dx += dest.bm_x;
+	dy += dest.bm_y;
+	const GLfloat xo = dx / static_cast<float>(last_width);
+	const GLfloat xs = dw / static_cast<float>(last_width);
+	const GLfloat yo = 1.0 - dy / static_cast<float>(last_height);
+	const GLfloat ys = dh / static_cast<float>(last_height);
+	const GLfloat u = sw / static_cast<float>(m.tw), v = sh / static_cast<float>(m.th);
+	const array<GLfloat, 8> vertices{{xo, yo, xo + xs, yo, xo + xs, yo - ys, xo, yo - ys}};
+	const array<GLfloat, 8> texcoord_array{{0, 0, u, 0, u, v, 0, v}};
+
+	p.use();
+	glUniform2fFunc(m.size, m.tw, m.th);
+	glUniform2fFunc(m.limit, (sw - 0.5f) / m.tw, (sh - 0.5f) / m.th);
+	glUniform1iFunc(m.bilinear, bilinear);
+	glVertexPointer(2, GL_FLOAT, 0, vertices.data());
+	glTexCoordPointer(2, GL_FLOAT, 0, texcoord_array.data());
+	glDrawArrays(GL_TRIANGLE_FAN, 0, 4);
+	ogl_program::use_fixed_function();
+	return true;
+}
+
 bool ogl_ubitblt(unsigned w,unsigned h,unsigned dx,unsigned dy, unsigned sx, unsigned sy, const grs_bitmap &src, grs_bitmap &dest){
 	return ogl_ubitblt_i(w,h,dx,dy,w,h,sx,sy,src,dest,0);
 }
@@ -1208,10 +3770,8 @@ bool ogl_ubitblt(unsigned w,unsigned h,unsigned dx,unsigned dy, unsigned sx, uns
  */
 void ogl_toggle_depth_test(int enable)
 {
-	if (enable)
-		glEnable(GL_DEPTH_TEST);
-	else
-		glDisable(GL_DEPTH_TEST);
+	ogl_flush_batches();
+	ogl_depth_test(enable);
 }
 
 /* 
@@ -1219,6 +3779,7 @@ void ogl_toggle_depth_test(int enable)
  */
 void ogl_set_blending(const gr_blend cv_blend_func)
 {
+	ogl_flush_batches();
 	GLenum s, d;
 	switch (cv_blend_func)
 	{
@@ -1236,23 +3797,35 @@ void ogl_set_blending(const gr_blend cv_blend_func)
 			d = GL_ONE_MINUS_SRC_ALPHA;
 			break;
 	}
-	glBlendFunc(s, d);
+	ogl_blend_func(s, d);
 }
 
 void ogl_start_frame(grs_canvas &canvas)
 {
 	r_polyc=0;r_tpolyc=0;r_bitmapc=0;r_ubitbltc=0;
+	ogl_flush_text_batch();
+	ogl_gpu_timer_begin();
 
-	OGL_VIEWPORT(canvas.cv_bitmap.bm_x, canvas.cv_bitmap.bm_y, Canvas_width, Canvas_height);
+	if (ogl_dynres.bound)
+	{
+		/* The framebuffer object holds only this canvas. */
+		auto &d = ogl_dynres;
+		ogl_flush_text_batch();
+		last_width = d.scaled_width;
+		last_height = d.scaled_height;
+		glViewport(0, 0, d.scaled_width, d.scaled_height);
+	}
+	else
+		OGL_VIEWPORT(canvas.cv_bitmap.bm_x, canvas.cv_bitmap.bm_y, Canvas_width, Canvas_height);
 	glClearColor(0.0, 0.0, 0.0, 0.0);
 
 	glLineWidth(linedotscale);
 	glEnable(GL_BLEND);
-	glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+	ogl_blend_func(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
 
 	glEnable(GL_ALPHA_TEST);
 	glAlphaFunc(GL_GEQUAL,0.02);
-	glEnable(GL_DEPTH_TEST);
+	ogl_depth_test(true);
 	glDepthFunc(GL_LEQUAL);
 
 	glClear(GL_DEPTH_BUFFER_BIT);
@@ -1272,6 +3845,8 @@ void ogl_start_frame(grs_canvas &canvas)
 }
 
 void ogl_end_frame(void){
+	ogl_flush_batches();
+	ogl_gpu_timer_end();
 	OGL_VIEWPORT(0, 0, grd_curscreen->get_screen_width(), grd_curscreen->get_screen_height());
 	glMatrixMode(GL_PROJECTION);
 	glLoadIdentity();//clear matrix
@@ -1283,7 +3858,13 @@ void ogl_end_frame(void){
 	glMatrixMode(GL_MODELVIEW);
 	glLoadIdentity();//clear matrix
 	glDisable(GL_CULL_FACE);
-	glDisable(GL_DEPTH_TEST);
+	ogl_depth_test(false);
+}
+
+void ogl_submit_frame()
+{
+	ogl_flush_text_batch();
+	glFlush();
 }
 
 void gr_flip(void)
@@ -1291,9 +3872,14 @@ void gr_flip(void)
 	if (CGameArg.DbgRenderStats)
 		ogl_texture_stats();
 
+	ogl_flush_text_batch();
 	ogl_do_palfx();
+	ogl_gpu_timer_next_frame();
 	ogl_swap_buffers_internal();
+	Ogl_state.skipped_last_frame = exchange(Ogl_state.skipped, 0);
 	glClear(GL_COLOR_BUFFER_BIT);
+	ogl_process_pending_uploads();
+	++ogl_texture_list.frame;
 }
 
 //little hack to find the nearest bigger power of 2 for a given number
@@ -1320,6 +3906,7 @@ void ogl_init_pixel_buffers(unsigned w, unsigned h)
 void ogl_close_pixel_buffers(void)
 {
 	texbuf.reset();
+	ogl_texcache_close();
 }
 
 static void ogl_filltexbuf(const palette_array_t &pal, const uint8_t *const data, GLubyte *texp, const unsigned truewidth, const unsigned width, const unsigned height, const int dxo, const int dyo, const unsigned twidth, const unsigned theight, const int type, const int bm_flags, const int data_format)
@@ -1509,6 +4096,213 @@ static void tex_set_size(ogl_texture &tex)
 	tex_set_size1(tex,bi,a,w,h);
 }
 
+/* -gl_texcache: the pixels of each texture, after palette conversion
+ * and edge bleeding, are kept in texcache.bin in the write directory
+ * together with their mipmaps.  Entries are
+ * keyed by a hash of the source pixels, the palette and every setting
+ * which changes the result, so changed game data or settings only
+ * miss the cache.  The file is read once, on the first texture load,
+ * and new entries are appended as they are made.
+ */
+#define OGL_TEXCACHE_FILENAME	"texcache.bin"
+constexpr uint32_t ogl_texcache_magic = 0x43545844;	// "DXTC"
+constexpr uint32_t ogl_texcache_version = 1;
+/* Stop appending once the file is this large.  The whole file is held
+ * in memory while textures are loaded.
+ */
+constexpr std::size_t ogl_texcache_max_size = 64 * 1024 * 1024;
+
+struct ogl_texcache_header
+{
+	uint64_t key;
+	uint32_t width, height, levels, bpp, size;
+};
+
+struct ogl_texcache_entry
+{
+	std::size_t offset;
+	ogl_texcache_header header;
+};
+
+struct ogl_texcache_state
+{
+	bool loaded;
+	std::size_t file_size;
+	std::vector<uint8_t> data;
+	std::unordered_map<uint64_t, ogl_texcache_entry> index;
+	RAIIPHYSFS_File append;
+};
+
+static ogl_texcache_state ogl_texcache;
+
+static unsigned ogl_texcache_bpp(const GLenum format)
+{
+	switch (format)
+	{
+		case GL_RGBA:
+			return 4;
+		case GL_RGB:
+			return 3;
+		case GL_LUMINANCE_ALPHA:
+			return 2;
+		case GL_LUMINANCE:
+			return 1;
+		default:
+			return 0;
+	}
+}
+
+static void ogl_texcache_load()
+{
+	auto &c = ogl_texcache;
+	c.loaded = true;
+	if (RAIIPHYSFS_File fp{PHYSFS_openRead(OGL_TEXCACHE_FILENAME)})
+	{
+		const auto len = PHYSFS_fileLength(fp);
+		if (len > 0)
+		{
+			c.data.resize(len);
+			if (PHYSFS_read(fp, c.data.data(), 1, len) != len)
+				c.data.clear();
+		}
+	}
+	array<uint32_t, 2> file_header;
+	if (c.data.size() < sizeof(file_header) ||
+		(memcpy(file_header.data(), c.data.data(), sizeof(file_header)), file_header[0] != ogl_texcache_magic || file_header[1] != ogl_texcache_version))
+	{
+		/* Missing, truncated, or written by another version. */
+		c.data.clear();
+		file_header = {{ogl_texcache_magic, ogl_texcache_version}};
+		c.append.reset(PHYSFS_openWrite(OGL_TEXCACHE_FILENAME));
+		if (c.append && PHYSFS_write(c.append, file_header.data(), sizeof(file_header), 1) != 1)
+			c.append.reset();
+		c.file_size = sizeof(file_header);
+		return;
+	}
+	std::size_t offset = sizeof(file_header);
+	for (ogl_texcache_header h; offset + sizeof(h) <= c.data.size();)
+	{
+		memcpy(&h, &c.data[offset], sizeof(h));
+		offset += sizeof(h);
+		if (h.size > c.data.size() - offset)
+			break;
+		c.index[h.key] = ogl_texcache_entry{offset, h};
+		offset += h.size;
+	}
+	/* Entries after a truncated one are lost, but the file stays
+	 * readable up to it, so append only if nothing was cut off.
+	 */
+	c.file_size = offset;
+	if (offset == c.data.size())
+		c.append.reset(PHYSFS_openAppend(OGL_TEXCACHE_FILENAME));
+	con_printf(CON_VERBOSE, "DXX-Rebirth: read %u cached textures from " OGL_TEXCACHE_FILENAME, static_cast<unsigned>(c.index.size()));
+}
+
+static const ogl_texcache_entry *ogl_texcache_find(const uint64_t key)
+{
+	auto &c = ogl_texcache;
+	if (!c.loaded)
+		ogl_texcache_load();
+	const auto i = c.index.find(key);
+	return i == c.index.end() ? nullptr : &i->second;
+}
+
+static void ogl_texcache_store(const ogl_texcache_header &h, const GLubyte *const pixels)
+{
+	auto &c = ogl_texcache;
+	if (!c.append || c.file_size + sizeof(h) + h.size > ogl_texcache_max_size)
+		return;
+	if (PHYSFS_write(c.append, &h, sizeof(h), 1) != 1 ||
+		PHYSFS_write(c.append, pixels, h.size, 1) != 1)
+	{
+		con_printf(CON_URGENT, "DXX-Rebirth: failed to write " OGL_TEXCACHE_FILENAME ": %s", PHYSFS_getLastError());
+		c.append.reset();
+		return;
+	}
+	c.file_size += sizeof(h) + h.size;
+	const auto offset = c.data.size();
+	c.data.insert(c.data.end(), pixels, pixels + h.size);
+	c.index[h.key] = ogl_texcache_entry{offset, h};
+}
+
+static void ogl_texcache_close()
+{
+	auto &c = ogl_texcache;
+	c.append.reset();
+	c.index.clear();
+	c.data.clear();
+	c.data.shrink_to_fit();
+	c.loaded = false;
+}
+
+#if !DXX_USE_OGLES
+/* Append mipmaps of the last level in pixels down to 1x1, averaging
+ * each 2x2 block like gluBuild2DMipmaps.  Returns the number of levels.
+ */
+static unsigned ogl_texcache_build_mipmaps(std::vector<GLubyte> &pixels, unsigned w, unsigned h, const unsigned bpp)
+{
+	unsigned levels = 1;
+	std::size_t src = 0;
+	for (; w > 1 || h > 1; ++levels)
+	{
+		const unsigned nw = w > 1 ? w / 2 : 1, nh = h > 1 ? h / 2 : 1;
+		const unsigned sx = w > 1 ? bpp : 0, sy = h > 1 ? w * bpp : 0;
+		const auto dst = pixels.size();
+		pixels.resize(dst + nw * nh * bpp);
+		for (unsigned y = 0; y != nh; ++y)
+			for (unsigned x = 0; x != nw; ++x)
+			{
+				const auto s = &pixels[src + (y * 2 * w + x * 2) * bpp];
+				const auto d = &pixels[dst + (y * nw + x) * bpp];
+				for (unsigned b = 0; b != bpp; ++b)
+					d[b] = (s[b] + s[b + sx] + s[b + sy] + s[b + sx + sy] + 2) / 4;
+			}
+		src = dst;
+		w = nw;
+		h = nh;
+	}
+	return levels;
+}
+#endif
+
+/* Upload levels stored one after another, as in the cache.  The cache
+ * holds textures before upscaling: the larger levels of an upscaled
+ * texture are the first stored level repeated, which is also what
+ * averaging the upscaled texture would give.
+ */
+static void ogl_texcache_upload(const ogl_texture &tex, const GLubyte *pixels, unsigned w, unsigned h, const unsigned levels, const unsigned bpp, const unsigned rescale)
+{
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+	GLint level = 0;
+	if (rescale > 1)
+	{
+		std::vector<GLubyte> scaled;
+		for (unsigned r = rescale; r > 1 && (level == 0 || levels > 1); r /= 2, ++level)
+		{
+			const unsigned sw = w * r;
+			scaled.resize(sw * h * r * bpp);
+			auto d = scaled.begin();
+			for (unsigned y = 0; y != h * r; ++y)
+			{
+				const auto row = &pixels[(y / r) * w * bpp];
+				for (unsigned x = 0; x != sw; ++x)
+					d = std::copy_n(&row[(x / r) * bpp], bpp, d);
+			}
+			glTexImage2D(GL_TEXTURE_2D, level, tex.internalformat, sw, h * r, 0, tex.format, GL_UNSIGNED_BYTE, scaled.data());
+		}
+	}
+	/* Without mipmaps, only the upscaled level is used. */
+	const unsigned stored = level && levels == 1 ? 0 : levels;
+	for (unsigned i = 0; i != stored; ++i, ++level)
+	{
+		glTexImage2D(GL_TEXTURE_2D, level, tex.internalformat, w, h, 0, tex.format, GL_UNSIGNED_BYTE, pixels);
+		pixels += w * h * bpp;
+		w = w > 1 ? w / 2 : 1;
+		h = h > 1 ? h / 2 : 1;
+	}
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+}
+
 //loads a palettized bitmap into a ogl RGBA texture.
 //Sizes and pads dimensions to multiples of 2 if necessary.
 //In theory this could be a problem for repeating textures, but all real
@@ -1516,6 +4310,7 @@ static void tex_set_size(ogl_texture &tex)
 //stores OpenGL textured id in *texid and u/v values required to get only the real data in *u/*v
 static int ogl_loadtexture(const palette_array_t &pal, const uint8_t *data, const int dxo, int dyo, ogl_texture &tex, const int bm_flags, const int data_format, int texfilt, const bool texanis, const bool edgepad)
 {
+	DXX_TRACE_ZONE("ogl_loadtexture");
 	tex.tw = pow2ize (tex.w);
 	tex.th = pow2ize (tex.h);//calculate smallest texture size that can accomodate us (must be multiples of 2)
 
@@ -1523,8 +4318,26 @@ static int ogl_loadtexture(const palette_array_t &pal, const uint8_t *data, cons
 	tex.u = static_cast<float>(static_cast<double>(tex.w) / static_cast<double>(tex.tw));
 	tex.v = static_cast<float>(static_cast<double>(tex.h) / static_cast<double>(tex.th));
 
+	const unsigned cache_bpp = CGameArg.OglTextureCache && bm_flags >= 0 && !data_format && !dxo && !dyo ? ogl_texcache_bpp(tex.format) : 0;
+	ogl_texcache_header cache_header{};
+	const ogl_texcache_entry *cached = nullptr;
+	if (cache_bpp)
+	{
+		fnv1a_hash key;
+		const array<int, 13> settings{{
+			tex.w, tex.h, tex.lw, tex.tw, tex.th, tex.format, tex.internalformat, bm_flags,
+			texfilt, texanis && ogl_maxanisotropy > 1.0f, edgepad, CGameArg.OglDarkEdges, DXX_USE_OGLES
+		}};
+		key.add(settings);
+		key.add(data, tex.lw * tex.h);
+		key.add(pal);
+		cache_header.key = key.get();
+		cached = ogl_texcache_find(cache_header.key);
+	}
+
 	auto *bufP = texbuf.get();
 	const uint8_t *outP = texbuf.get();
+	if (!cached)
 	{
 		if (bm_flags >= 0)
 			ogl_filltexbuf (pal, data, texbuf.get(), tex.lw, tex.w, tex.h, dxo, dyo, tex.tw, tex.th,
@@ -1553,7 +4366,7 @@ static int ogl_loadtexture(const palette_array_t &pal, const uint8_t *data, cons
 	}
 
 	//bleed color (rgb) into the alpha area, to deal with "dark edges problem"
-	if ((tex.format == GL_RGBA) && texfilt && edgepad && !CGameArg.OglDarkEdges)
+	if (!cached && (tex.format == GL_RGBA) && texfilt && edgepad && !CGameArg.OglDarkEdges)
 	{
 		GLubyte *p = bufP;
 		GLubyte *pdone = p + (4 * tex.tw * tex.th);
@@ -1651,7 +4464,7 @@ static int ogl_loadtexture(const palette_array_t &pal, const uint8_t *data, cons
 		}
 	}
 	GLubyte	*buftemp = NULL;
-	if (rescale > 1)
+	if (rescale > 1 && !cache_bpp)
 	{
 		int rebpp = 3;
 		if (tex.format == GL_RGBA) rebpp = 4;
@@ -1728,8 +4541,35 @@ static int ogl_loadtexture(const palette_array_t &pal, const uint8_t *data, cons
 
 #if DXX_USE_OGLES // in OpenGL ES 1.1 the mipmaps are automatically generated by a parameter
 	glTexParameteri (GL_TEXTURE_2D, GL_GENERATE_MIPMAP, buildmipmap ? GL_TRUE : GL_FALSE);
-#else
-	if (buildmipmap)
+#endif
+	if (cached)
+	{
+		const auto &h = cached->header;
+		ogl_texcache_upload(tex, &ogl_texcache.data[cached->offset], h.width, h.height, h.levels, h.bpp, rescale);
+	}
+	else if (cache_bpp)
+	{
+		const unsigned w = tex.tw, h = tex.th;
+		std::vector<GLubyte> pixels(outP, outP + w * h * cache_bpp);
+		unsigned levels = 1;
+#if !DXX_USE_OGLES
+		if (buildmipmap)
+			levels = ogl_texcache_build_mipmaps(pixels, w, h, cache_bpp);
+#endif
+		ogl_texcache_upload(tex, pixels.data(), w, h, levels, cache_bpp, rescale);
+		cache_header.width = w;
+		cache_header.height = h;
+		cache_header.levels = levels;
+		cache_header.bpp = cache_bpp;
+		cache_header.size = pixels.size();
+		ogl_texcache_store(cache_header, pixels.data());
+	}
+	else
+#if !DXX_USE_OGLES
+	/* Without glGenerateMipmap, the mipmaps are built on the CPU, from
+	 * the upscaled texture when -gl_texfilt upscales.
+	 */
+	if (buildmipmap && !glGenerateMipmapFunc)
 	{
 		gluBuild2DMipmaps (
 				GL_TEXTURE_2D, tex.internalformat, 
@@ -1740,20 +4580,63 @@ static int ogl_loadtexture(const palette_array_t &pal, const uint8_t *data, cons
 	else
 #endif
 	{
+		const auto pixels = ogl_stage_texture_pixels(outP, tex.format, tex.tw * rescale, tex.th * rescale);
 		glTexImage2D (
 			GL_TEXTURE_2D, 0, tex.internalformat,
 			tex.tw * rescale, tex.th * rescale, 0, tex.format, // RGBA textures.
 			GL_UNSIGNED_BYTE, // imageData is a GLubyte pointer.
-			outP);
+			pixels);
+		if (!pixels)
+			glBindBufferFunc(GL_PIXEL_UNPACK_BUFFER, 0);
+#if !DXX_USE_OGLES
+		if (buildmipmap)
+			glGenerateMipmapFunc(GL_TEXTURE_2D);
+#endif
 	}
 
 	tex_set_size(tex);
 	if (buftemp)
 		d_free(buftemp);
 	r_texcount++;
+	ogl_texture_resident(tex);
 	return 0;
 }
 
+static const uint8_t *ogl_get_bitmap_pixels(const grs_bitmap &bm, array<uint8_t, 300*1024> &decodebuf)
+{
+	if (!bm.get_flag_mask(BM_FLAG_RLE))
+		return bm.get_bitmap_data();
+	class bm_rle_expand_state
+	{
+		uint8_t *dbits;
+		uint8_t *const ebits;
+	public:
+		bm_rle_expand_state(uint8_t *const b, uint8_t *const e) :
+			dbits(b), ebits(e)
+		{
+		}
+		uint8_t *get_begin_dbits() const
+		{
+			return dbits;
+		}
+		uint8_t *get_end_dbits() const
+		{
+			return ebits;
+		}
+		void consume_dbits(const unsigned w)
+		{
+			dbits += w;
+		}
+	};
+	decodebuf = {};
+	const unsigned bm_w = bm.bm_w;
+	if (!bm_rle_expand(bm).loop(bm_w, bm_rle_expand_state(begin(decodebuf), end(decodebuf))))
+	{
+		con_printf(CON_URGENT, "error: insufficient space to decode %ux%hu bitmap.  Please report this as a bug.", bm_w, bm.bm_h);
+	}
+	return decodebuf.data();
+}
+
 void ogl_loadbmtexture_f(grs_bitmap &rbm, int texfilt, bool texanis, bool edgepad)
 {
 	assert(!rbm.get_flag_mask(BM_FLAG_PAGED_OUT));
@@ -1779,49 +4662,115 @@ void ogl_loadbmtexture_f(grs_bitmap &rbm, int texfilt, bool texanis, bool edgepa
 	}
 
 	array<uint8_t, 300*1024> decodebuf;
-	if (bm->get_flag_mask(BM_FLAG_RLE))
+	buf = ogl_get_bitmap_pixels(*bm, decodebuf);
+	bm->gltexture->evictable = true;
+	ogl_loadtexture(gr_palette, buf, 0, 0, *bm->gltexture, bm->get_flags(), 0, texfilt, texanis, edgepad);
+}
+
+void ogl_free_texture_array()
+{
+	auto &a = ogl_level_textures;
+	if (a.handle)
 	{
-		class bm_rle_expand_state
-		{
-			uint8_t *dbits;
-			uint8_t *const ebits;
-		public:
-			bm_rle_expand_state(uint8_t *const b, uint8_t *const e) :
-				dbits(b), ebits(e)
-			{
-			}
-			uint8_t *get_begin_dbits() const
-			{
-				return dbits;
-			}
-			uint8_t *get_end_dbits() const
-			{
-				return ebits;
-			}
-			void consume_dbits(const unsigned w)
-			{
-				dbits += w;
-			}
-		};
-		decodebuf = {};
-		buf = decodebuf.data();
-		if (!bm_rle_expand(*bm).loop(bm_w, bm_rle_expand_state(begin(decodebuf), end(decodebuf))))
-		{
-			con_printf(CON_URGENT, "error: insufficient space to decode %ux%hu bitmap.  Please report this as a bug.", bm_w, bm->bm_h);
-		}
+		glDeleteTextures(1, &a.handle);
+		a.handle = 0;
 	}
-	ogl_loadtexture(gr_palette, buf, 0, 0, *bm->gltexture, bm->get_flags(), 0, texfilt, texanis, edgepad);
+	range_for (const auto t, a.members)
+		t->array_layer = -1;
+	a.members.clear();
+	a.depth = 0;
+}
+
+static void ogl_build_texture_array(const std::vector<grs_bitmap *> &candidates)
+{
+	ogl_free_texture_array();
+#if DXX_USE_OGLES
+	(void)candidates;
+#else
+	if (!CGameArg.OglWorldBuffer || !ogl_have_EXT_texture3D)
+		return;
+	if (CGameCfg.TexFilt != OGL_TEXFILT_CLASSIC || (CGameCfg.TexAnisotropy && ogl_maxanisotropy > 1.0f))
+		return;
+	constexpr unsigned layer_size = 64;
+	auto &a = ogl_level_textures;
+	std::vector<grs_bitmap *> layers;
+	range_for (const auto bmp, candidates)
+	{
+		grs_bitmap *bm = bmp;
+		while (const auto bm_parent = bm->bm_parent)
+			bm = bm_parent;
+		if (bm->bm_w != layer_size || bm->bm_h != layer_size || !bm->gltexture)
+			continue;
+		layers.emplace_back(bm);
+	}
+	std::sort(layers.begin(), layers.end());
+	layers.erase(std::unique(layers.begin(), layers.end()), layers.end());
+	if (layers.size() > static_cast<unsigned>(ogl_max_3d_texture_size))
+		layers.resize(ogl_max_3d_texture_size);
+	if (layers.empty())
+		return;
+	const unsigned depth = std::min<unsigned>(pow2ize(layers.size()), ogl_max_3d_texture_size);
+	glGenTextures(1, &a.handle);
+	glBindTexture(GL_TEXTURE_3D, a.handle);
+	glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+	glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+	glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
+	glTexImage3DFunc(GL_TEXTURE_3D, 0, ogl_rgba_internalformat, layer_size, layer_size, depth, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+	array<uint8_t, 300*1024> decodebuf;
+	const auto texp = make_unique<GLubyte[]>(layer_size * layer_size * 4);
+	a.depth = depth;
+	a.members.reserve(layers.size());
+	range_for (const auto bm, layers)
+	{
+		const auto buf = ogl_get_bitmap_pixels(*bm, decodebuf);
+		ogl_filltexbuf(gr_palette, buf, texp.get(), layer_size, layer_size, layer_size, 0, 0, layer_size, layer_size, GL_RGBA, bm->get_flags(), 0);
+		const unsigned layer = a.members.size();
+		glTexSubImage3DFunc(GL_TEXTURE_3D, 0, 0, 0, layer, layer_size, layer_size, 1, GL_RGBA, GL_UNSIGNED_BYTE, texp.get());
+		bm->gltexture->array_layer = layer;
+		a.members.emplace_back(bm->gltexture);
+	}
+	glBindTexture(GL_TEXTURE_3D, 0);
+	con_printf(CON_VERBOSE, "DXX-Rebirth: OpenGL: packed %u level textures into one texture array", static_cast<unsigned>(a.members.size()));
+#endif
 }
 
 static void ogl_freetexture(ogl_texture &gltexture)
 {
+	if (&gltexture == ogl_text.texture)
+		ogl_flush_text_batch();
+	if (&gltexture == ogl_sprites.texture)
+		ogl_flush_sprite_batch();
+	/* Queued model instances hold bitmaps, not textures, so any of
+	 * them may use this one.
+	 */
+	ogl_flush_model_batch();
+	if (gltexture.placeholder)
+	{
+		auto &q = ogl_pending_uploads;
+		q.erase(std::remove_if(q.begin(), q.end(), [&gltexture](const ogl_pending_upload &u) { return u.tex == &gltexture; }), q.end());
+	}
 	if (gltexture.handle>0) {
 		r_texcount--;
 		glmprintf((CON_DEBUG, "ogl_freetexture(%p):%i (%i left)", &gltexture, gltexture.handle, r_texcount));
-		glDeleteTextures( 1, &gltexture.handle );
+		ogl_texture_release(gltexture);
+		ogl_delete_texture(gltexture.handle);
 //		gltexture->handle=0;
 		ogl_reset_texture(gltexture);
 	}
+	/* Evicted textures have no handle, but still hold their slot. */
+	const auto slot = ogl_texture_slot(gltexture);
+	if (slot >= 0)
+	{
+		auto &p = ogl_texture_list;
+		if (p.in_use[slot])
+		{
+			p.in_use[slot] = false;
+			ogl_reset_texture(gltexture);
+			p.free_slots.emplace_back(slot);
+		}
+	}
 }
 
 void ogl_freebmtexture(grs_bitmap &bm)
@@ -1861,20 +4810,10 @@ bool ogl_ubitmapm_cs(grs_canvas &canvas, int x, int y,int dw, int dh, grs_bitmap
 	return ogl_ubitmapm_cs(canvas, x, y, dw, dh, bm, color.init(c), scale);
 }
 
-/*
- * Menu / gauges 
- */
-bool ogl_ubitmapm_cs(grs_canvas &canvas, int x, int y,int dw, int dh, grs_bitmap &bm, const ogl_colors::array_type &color_array, int scale) // to scale bitmaps
+static void ogl_ubitmapm_cs_vertices(const grs_canvas &canvas, int x, int y, int dw, int dh, const grs_bitmap &bm, const int scale, array<GLfloat, 8> &vertices)
 {
-	GLfloat yo,xf,yf,u1,u2,v1,v2,h;
-	ogl_client_states<GLfloat, GL_VERTEX_ARRAY, GL_COLOR_ARRAY, GL_TEXTURE_COORD_ARRAY> cs;
-	auto &xo = std::get<0>(cs);
 	x += canvas.cv_bitmap.bm_x;
 	y += canvas.cv_bitmap.bm_y;
-	xo=x/static_cast<float>(last_width);
-	xf=(bm.bm_w+x)/static_cast<float>(last_width);
-	yo=1.0-y/static_cast<float>(last_height);
-	yf=1.0-(bm.bm_h+y)/static_cast<float>(last_height);
 
 	if (dw < 0)
 		dw = canvas.cv_bitmap.bm_w;
@@ -1885,17 +4824,24 @@ bool ogl_ubitmapm_cs(grs_canvas &canvas, int x, int y,int dw, int dh, grs_bitmap
 	else if (dh == 0)
 		dh = bm.bm_h;
 
-	h = static_cast<double>(scale) / static_cast<double>(F1_0);
+	const GLfloat h = static_cast<double>(scale) / static_cast<double>(F1_0);
 
-	xo = x / (static_cast<double>(last_width) * h);
-	xf = (dw + x) / (static_cast<double>(last_width) * h);
-	yo = 1.0 - y / (static_cast<double>(last_height) * h);
-	yf = 1.0 - (dh + y) / (static_cast<double>(last_height) * h);
+	const GLfloat xo = x / (static_cast<double>(last_width) * h);
+	const GLfloat xf = (dw + x) / (static_cast<double>(last_width) * h);
+	const GLfloat yo = 1.0 - y / (static_cast<double>(last_height) * h);
+	const GLfloat yf = 1.0 - (dh + y) / (static_cast<double>(last_height) * h);
+	vertices = {{
+		xo, yo,
+		xf, yo,
+		xf, yf,
+		xo, yf,
+	}};
+}
 
-	OGL_ENABLE(TEXTURE_2D);
-	ogl_bindbmtex(bm, 0);
-	ogl_texwrap(bm.gltexture,GL_CLAMP_TO_EDGE);
-	
+//bm.gltexture MUST be loaded first
+static void ogl_ubitmapm_cs_texcoords(const grs_bitmap &bm, array<GLfloat, 8> &texcoord_array)
+{
+	GLfloat u1,u2,v1,v2;
 	if (bm.bm_x==0){
 		u1=0;
 		if (bm.bm_w==bm.gltexture->w)
@@ -1916,19 +4862,29 @@ bool ogl_ubitmapm_cs(grs_canvas &canvas, int x, int y,int dw, int dh, grs_bitmap
 		v1=bm.bm_y/static_cast<float>(bm.gltexture->th);
 		v2=(bm.bm_h+bm.bm_y)/static_cast<float>(bm.gltexture->th);
 	}
-
-	const array<GLfloat, 8> vertices{{
-		xo, yo,
-		xf, yo,
-		xf, yf,
-		xo, yf,
-	}};
-	const array<GLfloat, 8> texcoord_array{{
+	texcoord_array = {{
 		u1, v1,
 		u2, v1,
 		u2, v2,
 		u1, v2,
 	}};
+}
+
+/*
+ * Menu / gauges 
+ */
+bool ogl_ubitmapm_cs(grs_canvas &canvas, int x, int y,int dw, int dh, grs_bitmap &bm, const ogl_colors::array_type &color_array, int scale) // to scale bitmaps
+{
+	ogl_flush_batches();
+	ogl_client_states<int, GL_VERTEX_ARRAY, GL_COLOR_ARRAY, GL_TEXTURE_COORD_ARRAY> cs;
+	array<GLfloat, 8> vertices, texcoord_array;
+	ogl_ubitmapm_cs_vertices(canvas, x, y, dw, dh, bm, scale, vertices);
+
+	OGL_ENABLE(TEXTURE_2D);
+	ogl_bindbmtex(bm, 0);
+	ogl_texwrap(bm.gltexture,GL_CLAMP_TO_EDGE);
+	ogl_ubitmapm_cs_texcoords(bm, texcoord_array);
+
 	glVertexPointer(2, GL_FLOAT, 0, vertices.data());
 	glColorPointer(4, GL_FLOAT, 0, color_array.data());
 	glTexCoordPointer(2, GL_FLOAT, 0, texcoord_array.data());
@@ -1936,4 +4892,36 @@ bool ogl_ubitmapm_cs(grs_canvas &canvas, int x, int y,int dw, int dh, grs_bitmap
 	return 0;
 }
 
+/*
+ * Font glyphs: same result as ogl_ubitmapm_cs at unit scale, but the
+ * quad is queued until a different texture or any other draw is used.
+ */
+void ogl_ubitmapm_cs_batched(grs_canvas &canvas, const int x, const int y, const int dw, const int dh, grs_bitmap &bm, const ogl_colors::array_type &color_array)
+{
+	ogl_flush_world_buffer();
+	ogl_flush_sprite_batch();
+	ogl_flush_model_batch();
+	if (bm.gltexture==NULL || bm.gltexture->handle<=0)
+		ogl_loadbmtexture(bm, 0);
+	auto &t = ogl_text;
+	if (t.texture != bm.gltexture)
+	{
+		ogl_flush_text_batch();
+		t.texture = bm.gltexture;
+	}
+	bm.gltexture->numrend++;
+	ogl_texture_touch(*bm.gltexture);
+	array<GLfloat, 8> vertices, texcoord_array;
+	ogl_ubitmapm_cs_vertices(canvas, x, y, dw, dh, bm, F1_0, vertices);
+	ogl_ubitmapm_cs_texcoords(bm, texcoord_array);
+	/* Split the fan 0-1-2-3 into triangles 0-1-2 and 0-2-3. */
+	static const array<uint8_t, 6> corners{{0, 1, 2, 0, 2, 3}};
+	range_for (const unsigned c, corners)
+	{
+		t.vertices.insert(t.vertices.end(), &vertices[c * 2], &vertices[c * 2] + 2);
+		t.texcoords.insert(t.texcoords.end(), &texcoord_array[c * 2], &texcoord_array[c * 2] + 2);
+		t.colors.insert(t.colors.end(), &color_array[c * 4], &color_array[c * 4] + 4);
+	}
+}
+
 }
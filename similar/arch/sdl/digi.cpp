@@ -61,6 +61,8 @@ struct sound_function_table_t
 	int  (*is_channel_playing)(int);
 	void (*stop_all_channels)();
 	void (*set_digi_volume)(int);
+	void (*prefetch_sound)(short);
+	void (*convert_sounds)();
 };
 
 #if DXX_USE_SDLMIXER
@@ -78,6 +80,8 @@ constexpr sound_function_table_t digi_mixer_table{
 	&digi_mixer_is_channel_playing,
 	&digi_mixer_stop_all_channels,
 	&digi_mixer_set_digi_volume,
+	&digi_mixer_prefetch_sound,
+	&digi_mixer_convert_sounds,
 };
 #endif
 
@@ -95,6 +99,8 @@ constexpr sound_function_table_t digi_audio_table{
 	&digi_audio_is_channel_playing,
 	&digi_audio_stop_all_channels,
 	&digi_audio_set_digi_volume,
+	&digi_audio_prefetch_sound,
+	&digi_audio_convert_sounds,
 };
 
 class sound_function_pointers_t
@@ -202,9 +208,19 @@ void digi_set_channel_pan(int channel, int pan) { fptr->set_channel_pan(channel,
 
 int  digi_start_sound(short soundnum, fix volume, int pan, int looping, int loop_start, int loop_end, sound_object *soundobj)
 {
+	if (soundnum >= 0)
+		piggy_sound_page_in(soundnum);
 	return fptr->start_sound(soundnum, volume, pan, looping, loop_start, loop_end, soundobj);
 }
 
+void digi_prefetch_sound(const short soundnum)
+{
+	piggy_sound_page_in(soundnum);
+	fptr->prefetch_sound(soundnum);
+}
+
+void digi_convert_sounds() { fptr->convert_sounds(); }
+
 void digi_stop_sound(int channel) { fptr->stop_sound(channel); }
 void digi_end_sound(int channel) { fptr->end_sound(channel); }
 
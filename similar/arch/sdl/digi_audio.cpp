@@ -11,6 +11,8 @@
  *
  */
 
+#include <algorithm>
+#include <atomic>
 #include <stdlib.h>
 #include <stdio.h>
 #include <string.h>
@@ -26,6 +28,12 @@
 
 #include "compiler-range_for.h"
 
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
 namespace dcx {
 
 //changed on 980905 by adb to increase number of concurrent sounds
@@ -34,86 +42,285 @@ namespace dcx {
 
 #define MIN_VOLUME 10
 
-/* This table is used to add two sound values together and pin
- * the value to avoid overflow.  (used with permission from ARDI)
- * DPH: Taken from SDL/src/SDL_mixer.c.
- */
-constexpr uint8_t mix8[] =
-{
-  0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
-  0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
-  0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
-  0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
-  0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
-  0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
-  0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
-  0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
-  0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
-  0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
-  0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
-  0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x01, 0x02, 0x03,
-  0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0A, 0x0B, 0x0C, 0x0D, 0x0E,
-  0x0F, 0x10, 0x11, 0x12, 0x13, 0x14, 0x15, 0x16, 0x17, 0x18, 0x19,
-  0x1A, 0x1B, 0x1C, 0x1D, 0x1E, 0x1F, 0x20, 0x21, 0x22, 0x23, 0x24,
-  0x25, 0x26, 0x27, 0x28, 0x29, 0x2A, 0x2B, 0x2C, 0x2D, 0x2E, 0x2F,
-  0x30, 0x31, 0x32, 0x33, 0x34, 0x35, 0x36, 0x37, 0x38, 0x39, 0x3A,
-  0x3B, 0x3C, 0x3D, 0x3E, 0x3F, 0x40, 0x41, 0x42, 0x43, 0x44, 0x45,
-  0x46, 0x47, 0x48, 0x49, 0x4A, 0x4B, 0x4C, 0x4D, 0x4E, 0x4F, 0x50,
-  0x51, 0x52, 0x53, 0x54, 0x55, 0x56, 0x57, 0x58, 0x59, 0x5A, 0x5B,
-  0x5C, 0x5D, 0x5E, 0x5F, 0x60, 0x61, 0x62, 0x63, 0x64, 0x65, 0x66,
-  0x67, 0x68, 0x69, 0x6A, 0x6B, 0x6C, 0x6D, 0x6E, 0x6F, 0x70, 0x71,
-  0x72, 0x73, 0x74, 0x75, 0x76, 0x77, 0x78, 0x79, 0x7A, 0x7B, 0x7C,
-  0x7D, 0x7E, 0x7F, 0x80, 0x81, 0x82, 0x83, 0x84, 0x85, 0x86, 0x87,
-  0x88, 0x89, 0x8A, 0x8B, 0x8C, 0x8D, 0x8E, 0x8F, 0x90, 0x91, 0x92,
-  0x93, 0x94, 0x95, 0x96, 0x97, 0x98, 0x99, 0x9A, 0x9B, 0x9C, 0x9D,
-  0x9E, 0x9F, 0xA0, 0xA1, 0xA2, 0xA3, 0xA4, 0xA5, 0xA6, 0xA7, 0xA8,
-  0xA9, 0xAA, 0xAB, 0xAC, 0xAD, 0xAE, 0xAF, 0xB0, 0xB1, 0xB2, 0xB3,
-  0xB4, 0xB5, 0xB6, 0xB7, 0xB8, 0xB9, 0xBA, 0xBB, 0xBC, 0xBD, 0xBE,
-  0xBF, 0xC0, 0xC1, 0xC2, 0xC3, 0xC4, 0xC5, 0xC6, 0xC7, 0xC8, 0xC9,
-  0xCA, 0xCB, 0xCC, 0xCD, 0xCE, 0xCF, 0xD0, 0xD1, 0xD2, 0xD3, 0xD4,
-  0xD5, 0xD6, 0xD7, 0xD8, 0xD9, 0xDA, 0xDB, 0xDC, 0xDD, 0xDE, 0xDF,
-  0xE0, 0xE1, 0xE2, 0xE3, 0xE4, 0xE5, 0xE6, 0xE7, 0xE8, 0xE9, 0xEA,
-  0xEB, 0xEC, 0xED, 0xEE, 0xEF, 0xF0, 0xF1, 0xF2, 0xF3, 0xF4, 0xF5,
-  0xF6, 0xF7, 0xF8, 0xF9, 0xFA, 0xFB, 0xFC, 0xFD, 0xFE, 0xFF, 0xFF,
-  0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
-  0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
-  0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
-  0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
-  0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
-  0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
-  0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
-  0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
-  0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
-  0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
-  0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
-  0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
-};
+// Sounds are resampled to this rate, whatever rate they were loaded at
+#define DIGI_AUDIO_FREQUENCY 44100
+// Frames over which a change of volume or pan is spread, to avoid clicks
+#define DIGI_AUDIO_RAMP_FRAMES 64u
+// Frames mixed per pass of audio_mixcallback
+#define DIGI_AUDIO_MIX_FRAMES 256u
+// Commands which can wait for the audio callback; a power of two
+#define DIGI_AUDIO_QUEUE_SIZE 1024u
 
 static int digi_initialised = 0;
+// Source samples per output frame, as 16.16 fixed point
+static uint32_t digi_audio_step;
 
+/* The game thread's view of a channel.  Only the game thread uses it;
+ * the callback learns of changes through the command queue.
+ */
 struct sound_slot {
 	int soundno;
 	bool playing;   // Is there a sample playing on this channel?
 	bool looped;    // Play this sample looped?
 	bool persistent; // This can't be pre-empted
+	bool stop_pending;	// The stop did not fit in the queue
+	bool param_pending;	// The volume or pan did not fit in the queue
 	fix pan;       // 0 = far left, 1 = far right
 	fix volume;    // 0 = nothing, 1 = fully on
-	//changed on 980905 by adb from char * to unsigned char *
-	unsigned char *samples;
 	sound_object *soundobj;   // Which soundobject is on this channel
+	uint32_t serial;	// Identifies the latest start on this channel
+};
+
+/* The callback's view of a channel.  Only the callback uses it, apart
+ * from done_serial, which it sets when the sample ends.
+ */
+struct sound_voice {
+	bool playing;
+	bool looped;
+	fix pan;
+	fix volume;
+	//changed on 980905 by adb from char * to unsigned char *
+	const unsigned char *samples;
 	//end changes by adb
 	unsigned int length; // Length of the sample
 	unsigned int position; // Position we are at at the moment.
+	uint32_t fraction;	// Position between samples, in 1/65536ths
+	uint32_t step;		// Added to fraction for every output frame
+	int16_t gain_l, gain_r;	// Gains as of the end of the last mix, 1.0 = 32768
+	uint32_t serial;
+	std::atomic<uint32_t> done_serial;
 };
 
-static void digi_audio_stop_sound(sound_slot &s)
+enum class digi_audio_command_type : uint8_t
 {
+	start,
+	stop,
+	param,
+};
+
+struct digi_audio_command
+{
+	digi_audio_command_type type;
+	uint8_t channel;
+	bool looped;
+	uint32_t serial;
+	fix volume, pan;
+	const unsigned char *samples;
+	unsigned length;
+};
+
+/* Single producer, single consumer: the game thread advances head after
+ * filling a command, and the callback advances tail after applying one,
+ * so neither ever waits for the other.
+ */
+struct digi_audio_queue
+{
+	array<digi_audio_command, DIGI_AUDIO_QUEUE_SIZE> commands;
+	alignas(64) std::atomic<unsigned> head;
+	alignas(64) std::atomic<unsigned> tail;
+};
+
+static array<sound_slot, digi_max_channels> SoundSlots;
+static array<sound_voice, digi_max_channels> SoundVoices;
+static digi_audio_queue SoundQueue;
+static uint32_t digi_audio_serial;
+
+static bool digi_audio_post(const digi_audio_command &c)
+{
+	auto &q = SoundQueue;
+	const auto head = q.head.load(std::memory_order_relaxed);
+	if (head - q.tail.load(std::memory_order_acquire) >= DIGI_AUDIO_QUEUE_SIZE)
+		return false;
+	q.commands[head % DIGI_AUDIO_QUEUE_SIZE] = c;
+	q.head.store(head + 1, std::memory_order_release);
+	return true;
+}
+
+static bool digi_audio_post_stop(const unsigned channel)
+{
+	digi_audio_command c{};
+	c.type = digi_audio_command_type::stop;
+	c.channel = channel;
+	return digi_audio_post(c);
+}
+
+static bool digi_audio_post_param(const unsigned channel)
+{
+	auto &s = SoundSlots[channel];
+	digi_audio_command c{};
+	c.type = digi_audio_command_type::param;
+	c.channel = channel;
+	c.volume = s.volume;
+	c.pan = s.pan;
+	return digi_audio_post(c);
+}
+
+/* Retry the commands which found the queue full, before any newer
+ * command is posted.
+ */
+static void digi_audio_post_pending()
+{
+	for (unsigned i = 0; i != digi_max_channels; ++i)
+	{
+		auto &s = SoundSlots[i];
+		if (s.stop_pending)
+		{
+			if (!digi_audio_post_stop(i))
+				return;
+			s.stop_pending = false;
+		}
+		if (s.param_pending)
+		{
+			if (!digi_audio_post_param(i))
+				return;
+			s.param_pending = false;
+		}
+	}
+}
+
+static bool digi_audio_slot_playing(const unsigned channel)
+{
+	const auto &s = SoundSlots[channel];
+	return s.playing && SoundVoices[channel].done_serial.load(std::memory_order_acquire) != s.serial;
+}
+
+static void digi_audio_stop_slot(const unsigned channel)
+{
+	auto &s = SoundSlots[channel];
 	s.playing = 0;
 	s.soundobj = sound_object_none;
 	s.persistent = 0;
+	s.param_pending = false;
+	digi_audio_post_pending();
+	s.stop_pending = !digi_audio_post_stop(channel);
 }
 
-static array<sound_slot, 32> SoundSlots;
+static void digi_audio_gains(const sound_voice &sl, int &gl, int &gr)
+{
+	fix vl, vr;
+	int x;
+	if ((x = sl.pan) & 0x8000) {
+		vl = 0x20000 - x * 2;
+		vr = 0x10000;
+	} else {
+		vl = 0x10000;
+		vr = x * 2;
+	}
+	vl = fixmul(vl, (x = sl.volume));
+	vr = fixmul(vr, x);
+	gl = std::min(vl >> 1, 32767);
+	gr = std::min(vr >> 1, 32767);
+}
+
+/* Resample up to frames frames of sl to 16 bits by linear interpolation.
+ * Returns the number of frames written, which is less than frames if
+ * the sample ended.
+ */
+static unsigned digi_audio_resample(sound_voice &sl, int16_t *const out, const unsigned frames)
+{
+	const auto samples = sl.samples;
+	const auto length = sl.length;
+	auto position = sl.position;
+	auto fraction = sl.fraction;
+	const auto step = sl.step;
+	unsigned i = 0;
+	for (; i != frames; ++i)
+	{
+		if (position >= length)
+		{
+			if (!sl.looped || !length)
+			{
+				sl.playing = 0;
+				break;
+			}
+			position %= length;
+		}
+		const int s0 = samples[position] - 0x80;
+		const auto next = position + 1;
+		const int s1 = next < length ? samples[next] - 0x80 : (sl.looped ? samples[0] - 0x80 : s0);
+		out[i] = (s0 << 8) + (((s1 - s0) * static_cast<int>(fraction)) >> 8);
+		fraction += step;
+		position += fraction >> 16;
+		fraction &= 0xffff;
+	}
+	sl.position = position;
+	sl.fraction = fraction;
+	return i;
+}
+
+// Add mono, scaled by gl and gr, to the interleaved stereo acc.
+static void digi_audio_accumulate(int32_t *const acc, const int16_t *const mono, const unsigned frames, const int gl, const int gr)
+{
+	unsigned i = 0;
+#if defined(__SSE2__)
+	const auto gains = _mm_set_epi16(gr, gl, gr, gl, gr, gl, gr, gl);
+	for (; i + 4 <= frames; i += 4)
+	{
+		const auto m = _mm_loadl_epi64(reinterpret_cast<const __m128i *>(mono + i));
+		const auto mm = _mm_unpacklo_epi16(m, m);
+		const auto lo = _mm_mullo_epi16(mm, gains);
+		const auto hi = _mm_mulhi_epi16(mm, gains);
+		const auto a = reinterpret_cast<__m128i *>(acc + 2 * i);
+		_mm_storeu_si128(a, _mm_add_epi32(_mm_loadu_si128(a), _mm_srai_epi32(_mm_unpacklo_epi16(lo, hi), 15)));
+		_mm_storeu_si128(a + 1, _mm_add_epi32(_mm_loadu_si128(a + 1), _mm_srai_epi32(_mm_unpackhi_epi16(lo, hi), 15)));
+	}
+#elif defined(__ARM_NEON)
+	const int16_t g[4] = {static_cast<int16_t>(gl), static_cast<int16_t>(gr), static_cast<int16_t>(gl), static_cast<int16_t>(gr)};
+	const auto gains = vld1_s16(g);
+	for (; i + 4 <= frames; i += 4)
+	{
+		const auto m = vld1_s16(mono + i);
+		const auto mm = vzip_s16(m, m);
+		const auto a = acc + 2 * i;
+		vst1q_s32(a, vsraq_n_s32(vld1q_s32(a), vmull_s16(mm.val[0], gains), 15));
+		vst1q_s32(a + 4, vsraq_n_s32(vld1q_s32(a + 4), vmull_s16(mm.val[1], gains), 15));
+	}
+#endif
+	for (; i != frames; ++i)
+	{
+		acc[2 * i] += (mono[i] * gl) >> 15;
+		acc[2 * i + 1] += (mono[i] * gr) >> 15;
+	}
+}
+
+/* As digi_audio_accumulate, but first move the gains of sl to gl and gr
+ * over DIGI_AUDIO_RAMP_FRAMES frames.
+ */
+static void digi_audio_accumulate_ramped(int32_t *const acc, const int16_t *const mono, const unsigned frames, sound_voice &sl, const int gl, const int gr)
+{
+	unsigned i = 0;
+	if (sl.gain_l != gl || sl.gain_r != gr)
+	{
+		const int ramp = std::min(frames, DIGI_AUDIO_RAMP_FRAMES);
+		const int l0 = sl.gain_l, r0 = sl.gain_r;
+		for (; i != static_cast<unsigned>(ramp); ++i)
+		{
+			const int t = i + 1;
+			acc[2 * i] += (mono[i] * (l0 + (gl - l0) * t / ramp)) >> 15;
+			acc[2 * i + 1] += (mono[i] * (r0 + (gr - r0) * t / ramp)) >> 15;
+		}
+		if (ramp)
+		{
+			sl.gain_l = gl;
+			sl.gain_r = gr;
+		}
+	}
+	digi_audio_accumulate(acc + 2 * i, mono + i, frames - i, gl, gr);
+}
+
+static void digi_audio_saturate(int16_t *const out, const int32_t *const acc, const unsigned n)
+{
+	unsigned i = 0;
+#if defined(__SSE2__)
+	for (; i + 8 <= n; i += 8)
+		_mm_storeu_si128(reinterpret_cast<__m128i *>(out + i), _mm_packs_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i *>(acc + i)), _mm_loadu_si128(reinterpret_cast<const __m128i *>(acc + i + 4))));
+#elif defined(__ARM_NEON)
+	for (; i + 8 <= n; i += 8)
+		vst1q_s16(out + i, vcombine_s16(vqmovn_s32(vld1q_s32(acc + i)), vqmovn_s32(vld1q_s32(acc + i + 4))));
+#endif
+	for (; i != n; ++i)
+		out[i] = std::min(std::max(acc[i], -32768), 32767);
+}
 
 }
 
@@ -122,55 +329,79 @@ namespace dsx {
 static SDL_AudioSpec WaveSpec;
 static int next_channel = 0;
 
+static void digi_audio_apply(const digi_audio_command &c)
+{
+	auto &v = SoundVoices[c.channel];
+	switch (c.type)
+	{
+		case digi_audio_command_type::start:
+			v.samples = c.samples;
+			v.length = c.length;
+			v.looped = c.looped;
+			v.volume = c.volume;
+			v.pan = c.pan;
+			v.position = 0;
+			v.fraction = 0;
+			v.step = digi_audio_step;
+			v.serial = c.serial;
+			{
+				// Start at full volume rather than ramping up to it
+				int gl, gr;
+				digi_audio_gains(v, gl, gr);
+				v.gain_l = gl;
+				v.gain_r = gr;
+			}
+			v.playing = 1;
+			break;
+		case digi_audio_command_type::stop:
+			v.playing = 0;
+			break;
+		case digi_audio_command_type::param:
+			v.volume = c.volume;
+			v.pan = c.pan;
+			break;
+	}
+}
+
 /* Audio mixing callback */
 //changed on 980905 by adb to cleanup, add pan support and optimize mixer
 static void audio_mixcallback(void *, Uint8 *stream, int len)
 {
-	Uint8 *streamend = stream + len;
 	if (!digi_initialised)
 		return;
 
-	memset(stream, 0x80, len); // fix "static" sound bug on Mac OS X
+	auto out = reinterpret_cast<int16_t *>(stream);
+	unsigned frames = static_cast<unsigned>(len) / (2 * sizeof(int16_t));
 
-	SDL_LockAudio();
+	{
+		auto &q = SoundQueue;
+		const auto head = q.head.load(std::memory_order_acquire);
+		auto tail = q.tail.load(std::memory_order_relaxed);
+		for (; tail != head; ++tail)
+			digi_audio_apply(q.commands[tail % DIGI_AUDIO_QUEUE_SIZE]);
+		q.tail.store(tail, std::memory_order_release);
+	}
 
-	range_for (auto &sl, SoundSlots)
+	while (frames)
 	{
-		if (sl.playing) {
-			Uint8 *sldata = sl.samples + sl.position, *slend = sl.samples + sl.length;
-			Uint8 *sp = stream, s;
-			signed char v;
-			fix vl, vr;
-			int x;
-
-			if ((x = sl.pan) & 0x8000) {
-				vl = 0x20000 - x * 2;
-				vr = 0x10000;
-			} else {
-				vl = 0x10000;
-				vr = x * 2;
-			}
-			vl = fixmul(vl, (x = sl.volume));
-			vr = fixmul(vr, x);
-			while (sp < streamend) {
-				if (sldata == slend) {
-					if (!sl.looped) {
-						sl.playing = 0;
-						break;
-					}
-					sldata = sl.samples;
-				}
-				v = *(sldata++) - 0x80;
-				s = *sp;
-				*(sp++) = mix8[ s + fixmul(v, vl) + 0x80 ];
-				s = *sp;
-				*(sp++) = mix8[ s + fixmul(v, vr) + 0x80 ];
-			}
-			sl.position = sldata - sl.samples;
+		const auto n = std::min(frames, DIGI_AUDIO_MIX_FRAMES);
+		array<int32_t, DIGI_AUDIO_MIX_FRAMES * 2> acc{};
+		array<int16_t, DIGI_AUDIO_MIX_FRAMES> mono;
+		range_for (auto &sl, SoundVoices)
+		{
+			if (!sl.playing)
+				continue;
+			int gl, gr;
+			digi_audio_gains(sl, gl, gr);
+			const auto resampled = digi_audio_resample(sl, mono.data(), n);
+			digi_audio_accumulate_ramped(acc.data(), mono.data(), resampled, sl, gl, gr);
+			if (!sl.playing)
+				sl.done_serial.store(sl.serial, std::memory_order_release);
 		}
+		digi_audio_saturate(out, acc.data(), n * 2);
+		out += n * 2;
+		frames -= n;
 	}
-
-	SDL_UnlockAudio();
 }
 //end changes by adb
 
@@ -182,17 +413,36 @@ int digi_audio_init()
 	}
 
 #if defined(DXX_BUILD_DESCENT_I)
-	WaveSpec.freq = digi_sample_rate;
+	const uint32_t sample_rate = digi_sample_rate;
 #elif defined(DXX_BUILD_DESCENT_II)
-	WaveSpec.freq = GameArg.SndDigiSampleRate;
+	const uint32_t sample_rate = GameArg.SndDigiSampleRate;
 #endif
+	digi_audio_step = (sample_rate << 16) / DIGI_AUDIO_FREQUENCY;
+	WaveSpec.freq = DIGI_AUDIO_FREQUENCY;
 	//added/changed by Sam Lantinga on 12/01/98 for new SDL version
-	WaveSpec.format = AUDIO_U8;
+	WaveSpec.format = AUDIO_S16SYS;
 	WaveSpec.channels = 2;
 	//end this section addition/change - SL
 	WaveSpec.samples = SOUND_BUFFER_SIZE;
 	WaveSpec.callback = audio_mixcallback;
 
+	/* The callback is not running, so the queue and voices can be reset
+	 * directly.
+	 */
+	SoundQueue.head.store(0, std::memory_order_relaxed);
+	SoundQueue.tail.store(0, std::memory_order_relaxed);
+	range_for (auto &v, SoundVoices)
+	{
+		v.playing = 0;
+		v.done_serial.store(v.serial, std::memory_order_relaxed);
+	}
+	range_for (auto &sl, SoundSlots)
+	{
+		sl.playing = 0;
+		sl.stop_pending = false;
+		sl.param_pending = false;
+	}
+
 	if ( SDL_OpenAudio(&WaveSpec, NULL) < 0 ) {
 		//edited on 10/05/98 by Matt Mueller - should keep running, just with no sound.
 		Warning("\nError: Couldn't open audio: %s\n", SDL_GetError());
@@ -211,6 +461,12 @@ int digi_audio_init()
 /* Toggle audio */
 void digi_audio_reset() { }
 
+/* Sounds are resampled from the 8-bit data as they play, so there is
+ * nothing to convert.
+ */
+void digi_audio_prefetch_sound(short) { }
+void digi_audio_convert_sounds() { }
+
 /* Shut down audio */
 void digi_audio_close()
 {
@@ -224,8 +480,8 @@ void digi_audio_close()
 
 void digi_audio_stop_all_channels()
 {
-	range_for (auto &i, SoundSlots)
-		digi_audio_stop_sound(i);
+	for (unsigned i = 0; i != digi_max_channels; ++i)
+		digi_audio_stop_slot(i);
 }
 
 
@@ -238,15 +494,14 @@ int digi_audio_start_sound(short soundnum, fix volume, int pan, int looping, int
 
 	if (soundnum < 0) return -1;
 
-	SDL_LockAudio();
-
 	Assert(GameSounds[soundnum].data != reinterpret_cast<void *>(-1));
 
+	digi_audio_post_pending();
 	starting_channel = next_channel;
 
 	while(1)
 	{
-		if (!SoundSlots[next_channel].playing)
+		if (!digi_audio_slot_playing(next_channel))
 			break;
 
 		if (!SoundSlots[next_channel].persistent)
@@ -256,12 +511,9 @@ int digi_audio_start_sound(short soundnum, fix volume, int pan, int looping, int
 		if (next_channel >= digi_max_channels)
 			next_channel = 0;
 		if (next_channel == starting_channel)
-		{
-			SDL_UnlockAudio();
 			return -1;
-		}
 	}
-	if (SoundSlots[next_channel].playing)
+	if (digi_audio_slot_playing(next_channel))
 	{
 		SoundSlots[next_channel].playing = 0;
 		if (SoundSlots[next_channel].soundobj != sound_object_none)
@@ -276,26 +528,40 @@ int digi_audio_start_sound(short soundnum, fix volume, int pan, int looping, int
 	verify_sound_channel_free(next_channel);
 #endif
 
-	SoundSlots[next_channel].soundno = soundnum;
-	SoundSlots[next_channel].samples = GameSounds[soundnum].data;
-	SoundSlots[next_channel].length = GameSounds[soundnum].length;
-	SoundSlots[next_channel].volume = fixmul(digi_volume, volume);
-	SoundSlots[next_channel].pan = pan;
-	SoundSlots[next_channel].position = 0;
-	SoundSlots[next_channel].looped = looping;
-	SoundSlots[next_channel].playing = 1;
-	SoundSlots[next_channel].soundobj = soundobj;
-	SoundSlots[next_channel].persistent = 0;
+	auto &sl = SoundSlots[next_channel];
+	digi_audio_command c{};
+	c.type = digi_audio_command_type::start;
+	c.channel = next_channel;
+	c.looped = looping;
+	c.serial = ++digi_audio_serial;
+	c.volume = fixmul(digi_volume, volume);
+	c.pan = pan;
+	c.samples = GameSounds[soundnum].data;
+	c.length = GameSounds[soundnum].length;
+	/* A full queue drops the start rather than wait for the callback;
+	 * the channel is left as it was.
+	 */
+	if (!digi_audio_post(c))
+		return -1;
+	// The start replaces whatever the channel was still waiting to send
+	sl.stop_pending = false;
+	sl.param_pending = false;
+	sl.soundno = soundnum;
+	sl.volume = c.volume;
+	sl.pan = pan;
+	sl.serial = c.serial;
+	sl.looped = looping;
+	sl.playing = 1;
+	sl.soundobj = soundobj;
+	sl.persistent = 0;
 	if (soundobj || looping || volume > F1_0)
-		SoundSlots[next_channel].persistent = 1;
+		sl.persistent = 1;
 
 	i = next_channel;
 	next_channel++;
 	if (next_channel >= digi_max_channels)
 		next_channel = 0;
 
-	SDL_UnlockAudio();
-
 	return i;
 }
 
@@ -321,7 +587,17 @@ int digi_audio_is_channel_playing(int channel)
 	if (!digi_initialised)
 		return 0;
 
-	return SoundSlots[channel].playing;
+	return digi_audio_slot_playing(channel);
+}
+
+/* Volume and pan need only their latest value to reach the callback,
+ * so one which finds the queue full is sent again with later commands.
+ */
+static void digi_audio_update_channel(const unsigned channel)
+{
+	auto &s = SoundSlots[channel];
+	digi_audio_post_pending();
+	s.param_pending = !digi_audio_post_param(channel);
 }
 
 void digi_audio_set_channel_volume(int channel, int volume)
@@ -329,10 +605,11 @@ void digi_audio_set_channel_volume(int channel, int volume)
 	if (!digi_initialised)
 		return;
 
-	if (!SoundSlots[channel].playing)
+	if (!digi_audio_slot_playing(channel))
 		return;
 
 	SoundSlots[channel].volume = fixmuldiv(volume, digi_volume, F1_0);
+	digi_audio_update_channel(channel);
 }
 
 void digi_audio_set_channel_pan(int channel, int pan)
@@ -340,15 +617,16 @@ void digi_audio_set_channel_pan(int channel, int pan)
 	if (!digi_initialised)
 		return;
 
-	if (!SoundSlots[channel].playing)
+	if (!digi_audio_slot_playing(channel))
 		return;
 
 	SoundSlots[channel].pan = pan;
+	digi_audio_update_channel(channel);
 }
 
 void digi_audio_stop_sound(int channel)
 {
-	digi_audio_stop_sound(SoundSlots[channel]);
+	digi_audio_stop_slot(channel);
 }
 
 void digi_audio_end_sound(int channel)
@@ -356,7 +634,7 @@ void digi_audio_end_sound(int channel)
 	if (!digi_initialised)
 		return;
 
-	if (!SoundSlots[channel].playing)
+	if (!digi_audio_slot_playing(channel))
 		return;
 
 	SoundSlots[channel].soundobj = sound_object_none;
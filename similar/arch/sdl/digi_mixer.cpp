@@ -14,9 +14,11 @@
  *  -- MD2211 (2006-10-12)
  */
 
+#include <atomic>
 #include <stdlib.h>
 #include <stdio.h>
 #include <string.h>
+#include <vector>
 
 #include <SDL.h>
 #include <SDL_audio.h>
@@ -35,8 +37,10 @@
 #include "maths.h"
 #include "piggy.h"
 #include "u_mem.h"
+#include "jobs.h"
 
 #include "compiler-make_unique.h"
+#include "compiler-range_for.h"
 
 namespace dsx {
 
@@ -69,6 +73,91 @@ static int digi_mixer_max_channels = MAX_SOUND_SLOTS;
 static inline int fix2byte(fix f) { return (f / 256) % 256; }
 static array<RAIIMix_Chunk, MAX_SOUNDS> SoundChunks;
 static array<uint8_t, MAX_SOUND_SLOTS> channels;
+#if defined(DXX_BUILD_DESCENT_II)
+static int mixdigi_out_freq, mixdigi_out_channels;
+static Uint16 mixdigi_out_format;
+#endif
+
+namespace {
+
+/* The formats a conversion reads and writes.  SoundChunks hold data
+ * converted for SoundChunkSpec, and are converted again when the spec
+ * changes.
+ */
+struct mixdigi_spec
+{
+#if defined(DXX_BUILD_DESCENT_II)
+	int in_freq;
+#endif
+	int out_freq;
+	Uint16 out_format;
+	int out_channels;
+	bool operator==(const mixdigi_spec &r) const
+	{
+		return
+#if defined(DXX_BUILD_DESCENT_II)
+			in_freq == r.in_freq &&
+#endif
+			out_freq == r.out_freq && out_format == r.out_format && out_channels == r.out_channels;
+	}
+};
+
+/* Whoever moves a sound out of none or queued converts it, so each
+ * sound is converted exactly once, by either the worker or the game
+ * thread.
+ */
+enum class mixdigi_chunk_state : uint8_t
+{
+	none,
+	queued,
+	converting,
+	done,
+};
+
+struct mixdigi_worker_state
+{
+	SDL_Thread *thread;
+	SDL_mutex *lock;
+	SDL_cond *wake;
+	bool quit;
+	std::vector<short> pending;
+};
+
+}
+
+static array<std::atomic<mixdigi_chunk_state>, MAX_SOUNDS> SoundChunkState;
+static mixdigi_spec SoundChunkSpec;
+static mixdigi_worker_state mixdigi_worker;
+
+static mixdigi_spec mixdigi_output_spec()
+{
+#if defined(DXX_BUILD_DESCENT_I)
+	return {static_cast<int>(digi_sample_rate), MIX_OUTPUT_FORMAT, MIX_OUTPUT_CHANNELS};
+#elif defined(DXX_BUILD_DESCENT_II)
+	return {static_cast<int>(GameArg.SndDigiSampleRate), mixdigi_out_freq, mixdigi_out_format, mixdigi_out_channels};
+#endif
+}
+
+/* Drop the chunks if they were converted for another spec.  No chunk
+ * may be playing, and the worker must be stopped.
+ */
+static bool mixdigi_use_spec(const mixdigi_spec &spec)
+{
+	if (SoundChunkSpec == spec)
+		return false;
+	SoundChunkSpec = spec;
+	range_for (auto &c, SoundChunks)
+	{
+		delete [] c.abuf;
+		static_cast<Mix_Chunk &>(c) = {};
+	}
+	range_for (auto &state, SoundChunkState)
+		state.store(mixdigi_chunk_state::none, std::memory_order_relaxed);
+	return true;
+}
+
+static void mixdigi_worker_start();
+static void mixdigi_worker_stop();
 
 /* Initialise audio */
 int digi_mixer_init()
@@ -93,9 +182,18 @@ int digi_mixer_init()
 
 	digi_mixer_max_channels = Mix_AllocateChannels(digi_mixer_max_channels);
 	channels = {};
+#if defined(DXX_BUILD_DESCENT_II)
+	Mix_QuerySpec(&mixdigi_out_freq, &mixdigi_out_format, &mixdigi_out_channels); // get current output settings
+#endif
 	Mix_Pause(0);
+	mixdigi_use_spec(mixdigi_output_spec());
+	mixdigi_worker_start();
 
 	digi_initialised = 1;
+	/* If the sounds were loaded before a reset, convert them for the
+	 * new spec now.
+	 */
+	digi_mixer_convert_sounds();
 
 	digi_mixer_set_digi_volume( (GameCfg.DigiVolume*32768)/8 );
 
@@ -109,6 +207,7 @@ void digi_mixer_close() {
 #endif
 	if (!digi_initialised) return;
 	digi_initialised = 0;
+	mixdigi_worker_stop();
 	Mix_CloseAudio();
 }
 
@@ -127,7 +226,7 @@ static void digi_mixer_free_channel(int channel_num)
 }
 
 /*
- * Play-time conversion. Performs output conversion only once per sound effect used.
+ * Load-time conversion. Performs output conversion only once per sound effect used.
  * Once the sound sample has been converted, it is cached in SoundChunks[]
  */
 static void mixdigi_convert_sound(int i)
@@ -135,18 +234,14 @@ static void mixdigi_convert_sound(int i)
 	SDL_AudioCVT cvt;
 	Uint8 *data = GameSounds[i].data;
 	Uint32 dlen = GameSounds[i].length;
-	int freq;
-	int out_freq;
-	Uint16 out_format;
-	int out_channels;
+	const auto &spec = SoundChunkSpec;
+	const int out_freq = spec.out_freq;
+	const Uint16 out_format = spec.out_format;
+	const int out_channels = spec.out_channels;
 #if defined(DXX_BUILD_DESCENT_I)
-	out_freq = digi_sample_rate;
-	out_format = MIX_OUTPUT_FORMAT;
-	out_channels = MIX_OUTPUT_CHANNELS;
-	freq = GameSounds[i].freq;
+	const int freq = GameSounds[i].freq;
 #elif defined(DXX_BUILD_DESCENT_II)
-	Mix_QuerySpec(&out_freq, &out_format, &out_channels); // get current output settings
-	freq = GameArg.SndDigiSampleRate;
+	const int freq = spec.in_freq;
 #endif
 
 	if (SoundChunks[i].abuf) return; //proceed only if not converted yet
@@ -176,6 +271,145 @@ static void mixdigi_convert_sound(int i)
 	}
 }
 
+static bool mixdigi_claim_sound(const int i, mixdigi_chunk_state expected)
+{
+	auto &state = SoundChunkState[i];
+	if (!state.compare_exchange_strong(expected, mixdigi_chunk_state::converting, std::memory_order_acquire))
+		return false;
+	mixdigi_convert_sound(i);
+	state.store(mixdigi_chunk_state::done, std::memory_order_release);
+	return true;
+}
+
+static int mixdigi_worker_thread(void *)
+{
+	auto &w = mixdigi_worker;
+	SDL_LockMutex(w.lock);
+	for (;;)
+	{
+		while (!w.quit && w.pending.empty())
+			SDL_CondWait(w.wake, w.lock);
+		if (w.quit)
+			break;
+		const auto i = w.pending.back();
+		w.pending.pop_back();
+		SDL_UnlockMutex(w.lock);
+		mixdigi_claim_sound(i, mixdigi_chunk_state::queued);
+		SDL_LockMutex(w.lock);
+	}
+	SDL_UnlockMutex(w.lock);
+	return 0;
+}
+
+static void mixdigi_worker_start()
+{
+	auto &w = mixdigi_worker;
+	w.quit = false;
+	/* Each sound is queued at most once, so pushing never allocates. */
+	w.pending.reserve(MAX_SOUNDS);
+	if (!(w.lock = SDL_CreateMutex()))
+		return;
+	if (!(w.wake = SDL_CreateCond()))
+	{
+		SDL_DestroyMutex(w.lock);
+		return;
+	}
+#if SDL_MAJOR_VERSION == 2
+	w.thread = SDL_CreateThread(mixdigi_worker_thread, "mixdigi_convert", nullptr);
+#else
+	w.thread = SDL_CreateThread(mixdigi_worker_thread, nullptr);
+#endif
+	if (!w.thread)
+	{
+		SDL_DestroyCond(w.wake);
+		SDL_DestroyMutex(w.lock);
+	}
+}
+
+static void mixdigi_worker_stop()
+{
+	auto &w = mixdigi_worker;
+	if (!w.thread)
+		return;
+	SDL_LockMutex(w.lock);
+	w.quit = true;
+	SDL_CondSignal(w.wake);
+	SDL_UnlockMutex(w.lock);
+	SDL_WaitThread(w.thread, nullptr);
+	w.thread = nullptr;
+	SDL_DestroyCond(w.wake);
+	SDL_DestroyMutex(w.lock);
+	/* Sounds left in the queue are converted by the next stage. */
+	range_for (const auto i, w.pending)
+	{
+		auto expected = mixdigi_chunk_state::queued;
+		SoundChunkState[i].compare_exchange_strong(expected, mixdigi_chunk_state::none);
+	}
+	w.pending.clear();
+}
+
+static bool mixdigi_sound_loaded(const int i)
+{
+	const auto data = GameSounds[i].data;
+	return data && data != reinterpret_cast<void *>(-1);
+}
+
+/* Queue soundnum for conversion on the worker thread, so that its
+ * first play does not stall the frame.
+ */
+void digi_mixer_prefetch_sound(const short soundnum)
+{
+	auto &w = mixdigi_worker;
+	if (!w.thread || soundnum < 0)
+		return;
+	if (!mixdigi_sound_loaded(soundnum))
+		return;
+	auto expected = mixdigi_chunk_state::none;
+	if (!SoundChunkState[soundnum].compare_exchange_strong(expected, mixdigi_chunk_state::queued, std::memory_order_relaxed))
+		return;
+	SDL_LockMutex(w.lock);
+	w.pending.emplace_back(soundnum);
+	SDL_CondSignal(w.wake);
+	SDL_UnlockMutex(w.lock);
+}
+
+/* Convert every loaded sound on the job pool, so that playing a sound
+ * never converts it.  Runs once the sounds are read at startup and
+ * again after each level is paged in, which picks up sounds read by
+ * -lazysounds or loaded with the level.  Sounds which are already
+ * converted for the current spec are skipped.
+ */
+void digi_mixer_convert_sounds()
+{
+	if (!digi_initialised)
+		return;
+	const auto spec = mixdigi_output_spec();
+	if (!(SoundChunkSpec == spec))
+	{
+		mixdigi_worker_stop();
+		digi_mixer_stop_all_channels();
+		mixdigi_use_spec(spec);
+		mixdigi_worker_start();
+	}
+	std::vector<short> todo;
+	for (unsigned i = 0; i != MAX_SOUNDS; ++i)
+		if (SoundChunkState[i].load(std::memory_order_relaxed) != mixdigi_chunk_state::done && mixdigi_sound_loaded(i))
+			todo.emplace_back(i);
+	if (todo.empty())
+		return;
+	job_pool_run(todo.size(), [&todo](const unsigned index, unsigned) {
+		const auto i = todo[index];
+		const auto s = SoundChunkState[i].load(std::memory_order_relaxed);
+		if (s == mixdigi_chunk_state::none || s == mixdigi_chunk_state::queued)
+			mixdigi_claim_sound(i, s);
+	});
+	/* The worker may have claimed some of these first. */
+	range_for (const auto i, todo)
+		while (SoundChunkState[i].load(std::memory_order_acquire) == mixdigi_chunk_state::converting)
+			SDL_Delay(1);
+	con_printf(CON_VERBOSE, "DXX-Rebirth: converted %u sounds for the mixer", static_cast<unsigned>(todo.size()));
+}
+
 // Volume 0-F1_0
 int digi_mixer_start_sound(short soundnum, fix volume, int pan, int looping, int loop_start, int loop_end, sound_object *)
 {
@@ -191,7 +425,17 @@ int digi_mixer_start_sound(short soundnum, fix volume, int pan, int looping, int
 
 	Assert(GameSounds[soundnum].data != reinterpret_cast<void *>(-1));
 
-	mixdigi_convert_sound(soundnum);
+	/* A sound the stages did not convert, such as one first read by
+	 * -lazysounds when it was played, is skipped this time and
+	 * converted on the worker for its next play.
+	 */
+	if (SoundChunkState[soundnum].load(std::memory_order_acquire) != mixdigi_chunk_state::done)
+	{
+		digi_mixer_prefetch_sound(soundnum);
+		return -1;
+	}
+	if (!SoundChunks[soundnum].abuf)
+		return -1;
 
 #if MIX_DIGI_DEBUG
 	con_printf(CON_DEBUG, "digi_start_sound %d, volume %d, pan %d (start=%d, end=%d)", soundnum, mix_vol, mix_pan, loop_start, loop_end);
@@ -39,8 +39,71 @@ static int sdl_video_flags = SDL_SWSURFACE | SDL_HWPALETTE | SDL_DOUBLEBUF;
 static SDL_Surface *screen, *canvas;
 static int gr_installed;
 
+/* With -sdl_scale, the canvas is smaller than the window and is shown
+ * through a YUY2 overlay, which the video hardware scales and filters.
+ * Only the palette lookup is done on the CPU, at the canvas size.  The
+ * lookup tables are rebuilt whenever the palette changes, so fades cost
+ * 256 conversions rather than one per pixel.
+ */
+static SDL_Overlay *overlay;
+static unsigned window_scale = 1;
+static array<uint8_t, 256> overlay_y, overlay_u, overlay_v;
+
+static void gr_set_colors(array<SDL_Color, 256> &colors)
+{
+	SDL_SetColors(canvas, colors.data(), 0, colors.size());
+	if (!overlay)
+		return;
+	for (unsigned i = 0; i != colors.size(); ++i)
+	{
+		const int r = colors[i].r, g = colors[i].g, b = colors[i].b;
+		overlay_y[i] = 16 + ((66 * r + 129 * g + 25 * b + 128) >> 8);
+		overlay_u[i] = 128 + ((-38 * r - 74 * g + 112 * b + 128) >> 8);
+		overlay_v[i] = 128 + ((112 * r - 94 * g - 18 * b + 128) >> 8);
+	}
+}
+
+static void gr_flip_overlay()
+{
+	if (SDL_LockYUVOverlay(overlay) < 0)
+		return;
+	const unsigned w = overlay->w, h = overlay->h;
+	const auto src_pitch = canvas->pitch;
+	const auto dst_pitch = overlay->pitches[0];
+	auto s = static_cast<const uint8_t *>(canvas->pixels);
+	auto d = overlay->pixels[0];
+	for (unsigned y = 0; y != h; ++y, s += src_pitch, d += dst_pitch)
+	{
+		auto o = d;
+		for (unsigned x = 0; x != w; x += 2, o += 4)
+		{
+			const auto a = s[x], b = s[x + 1];
+			o[0] = overlay_y[a];
+			o[1] = (overlay_u[a] + overlay_u[b] + 1) >> 1;
+			o[2] = overlay_y[b];
+			o[3] = (overlay_v[a] + overlay_v[b] + 1) >> 1;
+		}
+	}
+	SDL_UnlockYUVOverlay(overlay);
+	SDL_Rect dest;
+	dest.x = dest.y = 0;
+	dest.w = screen->w;
+	dest.h = screen->h;
+	SDL_DisplayYUVOverlay(overlay, &dest);
+}
+
+unsigned gr_window_scale()
+{
+	return window_scale;
+}
+
 void gr_flip()
 {
+	if (overlay)
+	{
+		gr_flip_overlay();
+		return;
+	}
 	SDL_Rect src, dest;
 
 	dest.x = src.x = dest.y = src.y = 0;
@@ -119,7 +182,40 @@ int gr_set_mode(screen_mode mode)
 		exit(1);
 	}
 
-	canvas = SDL_CreateRGBSurface(sdl_video_flags, w, h, 8, 0, 0, 0, 0);
+	if (overlay)
+	{
+		SDL_FreeYUVOverlay(overlay);
+		overlay = nullptr;
+	}
+	unsigned cw = w, ch = h;
+	const auto scale = CGameArg.SdlRenderScale;
+	if (scale > 1)
+	{
+		/* YUY2 pairs pixels, so the canvas width must be even. */
+		cw = (w / scale) & ~1u;
+		ch = h / scale;
+		if (cw < 320 || ch < 200)
+			con_printf(CON_URGENT, "DXX-Rebirth: %ux%u scaled by %u is below 320x200; drawing at full size", w, h, scale);
+		else if (!(overlay = SDL_CreateYUVOverlay(cw, ch, SDL_YUY2_OVERLAY, screen)))
+			con_printf(CON_URGENT, "DXX-Rebirth: cannot create video overlay: %s; drawing at full size", SDL_GetError());
+		else if (!overlay->hw_overlay)
+		{
+			/* SDL would scale a software overlay on the CPU, which is
+			 * slower than drawing at full size.
+			 */
+			con_printf(CON_URGENT, "DXX-Rebirth: video overlay is not hardware accelerated; drawing at full size");
+			SDL_FreeYUVOverlay(overlay);
+			overlay = nullptr;
+		}
+		if (!overlay)
+		{
+			cw = w;
+			ch = h;
+		}
+	}
+	window_scale = overlay ? scale : 1;
+
+	canvas = SDL_CreateRGBSurface(sdl_video_flags, cw, ch, 8, 0, 0, 0, 0);
 	if (canvas == NULL)
 	{
 		Error("Could not create canvas surface\n");
@@ -127,14 +223,14 @@ int gr_set_mode(screen_mode mode)
 	}
 
 	*grd_curscreen = {};
-	grd_curscreen->set_screen_width_height(w, h);
+	grd_curscreen->set_screen_width_height(cw, ch);
 	grd_curscreen->sc_aspect = fixdiv(grd_curscreen->get_screen_width() * GameCfg.AspectX, grd_curscreen->get_screen_height() * GameCfg.AspectY);
-	gr_init_canvas(grd_curscreen->sc_canvas, reinterpret_cast<unsigned char *>(canvas->pixels), bm_mode::linear, w, h);
+	gr_init_canvas(grd_curscreen->sc_canvas, reinterpret_cast<unsigned char *>(canvas->pixels), bm_mode::linear, cw, ch);
 	window_update_canvases();
 	gr_set_default_canvas();
 
 	SDL_ShowCursor(0);
-	gamefont_choose_game_font(w,h);
+	gamefont_choose_game_font(cw,ch);
 	gr_palette_load(gr_palette);
 	gr_remap_color_fonts();
 
@@ -208,6 +304,11 @@ void gr_close()
 		gr_installed = 0;
 		grd_curscreen.reset();
 		SDL_ShowCursor(1);
+		if (overlay)
+		{
+			SDL_FreeYUVOverlay(overlay);
+			overlay = nullptr;
+		}
 		SDL_FreeSurface(canvas);
 	}
 }
@@ -246,7 +347,7 @@ void gr_palette_step_up( int r, int g, int b )
 		const auto ib = static_cast<int>(p[i].b) + b + gr_palette_gamma;
 		colors[i].b = std::min(std::max(ib, 0), 63) * 4;
 	}
-	SDL_SetColors(canvas, colors.data(), 0, colors.size());
+	gr_set_colors(colors);
 }
 
 void gr_palette_load( palette_array_t &pal )
@@ -282,7 +383,7 @@ void gr_palette_load( palette_array_t &pal )
 		i++;
 	}
 
-	SDL_SetColors(canvas, colors.data(), 0, colors.size());
+	gr_set_colors(colors);
 	init_computed_colors();
 	gr_remap_color_fonts();
 }
@@ -17,6 +17,8 @@
 #include "text.h"
 #include "args.h"
 #include "window.h"
+#include "jobs.h"
+#include "game.h"
 
 namespace dsx {
 
@@ -24,6 +26,9 @@ static void arch_close(void)
 {
 	songs_uninit();
 
+#if DXX_USE_SCREENSHOT
+	screenshot_close();
+#endif
 	gr_close();
 
 	if (!CGameArg.CtlNoJoystick)
@@ -36,6 +41,7 @@ static void arch_close(void)
 	{
 		digi_close();
 	}
+	job_pool_close();
 	SDL_Quit();
 }
 
@@ -43,6 +49,14 @@ void arch_init(void)
 {
 	int t;
 
+#if !DXX_USE_OGL
+	/* The software renderer only needs a surface, which the dummy
+	 * driver provides without a display.  SDL2 builds always use
+	 * OpenGL, so this is SDL1 only.
+	 */
+	if (CGameArg.SysHeadless)
+		SDL_putenv(const_cast<char *>("SDL_VIDEODRIVER=dummy"));
+#endif
 	if (SDL_Init(SDL_INIT_VIDEO) < 0)
 		Error("SDL library initialisation failed: %s.",SDL_GetError());
 #if SDL_MAJOR_VERSION == 2
@@ -79,6 +93,9 @@ void arch_init(void)
 	if ((t = gr_init()) != 0)
 		Error(TXT_CANT_INIT_GFX,t);
 
+	if (!CGameArg.DbgNoJobs)
+		job_pool_init();
+
 	atexit(arch_close);
 }
 
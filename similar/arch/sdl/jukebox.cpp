@@ -22,7 +22,9 @@
 #include "strutil.h"
 #include "u_mem.h"
 #include "physfs_list.h"
+#include "ignorecase.h"
 #include "digi.h"
+#include "digi_mixer_music.h"
 
 #include "compiler-make_unique.h"
 #include "partial_range.h"
@@ -253,6 +255,7 @@ void jukebox_load()
 			void operator()(const char *const p) const noexcept
 			{
 				PHYSFS_removeFromSearchPath(p);
+				PHYSFSEXT_flushCaseCache();
 			}
 		};
 		std::unique_ptr<const char, PHYSFS_path_deleter> new_path;
@@ -276,6 +279,7 @@ void jukebox_load()
 			if (PHYSFSX_isNewPath(p))
 				new_path.reset(p);
 			PHYSFS_addToSearchPath(p, 0);
+			PHYSFSEXT_flushCaseCache();
 
 			// as mountpoints are no option (yet), make sure only files originating from GameCfg.CMLevelMusicPath are aded to the list.
 			JukeboxSongs.list.reset(PHYSFSX_findabsoluteFiles("", p, jukebox_exts));
@@ -305,18 +309,48 @@ void jukebox_load()
 	}
 }
 
+/* The track jukebox_hook_next will play, chosen when the current one
+ * started so that it could be read ahead.  -1 if none was chosen.
+ */
+static int jukebox_next_track = -1;
+
+static int jukebox_choose_next_track()
+{
+	int track;
+	if (GameCfg.CMLevelMusicPlayOrder == MUSIC_CM_PLAYORDER_RAND)
+		track = d_rand() % CGameCfg.CMLevelMusicTrack[1]; // simply a random selection - no check if this song has already been played. But that's how I roll!
+	else
+		track = CGameCfg.CMLevelMusicTrack[0] + 1;
+	if (track + 1 > CGameCfg.CMLevelMusicTrack[1])
+		track = 0;
+	return track;
+}
+
+static RAIIdmem<char[]> jukebox_track_path(const char *const music_filename)
+{
+	size_t size_music_filename = strlen(music_filename);
+	auto &cfgpath = CGameCfg.CMLevelMusicPath;
+	size_t musiclen = strlen(cfgpath.data());
+	const uint_fast32_t size_full_filename = musiclen + size_music_filename + 1;
+	RAIIdmem<char[]> full_filename;
+	CALLOC(full_filename, char[], size_full_filename);
+	const char *LevelMusicPath;
+	if (musiclen > 4 && !d_stricmp(&cfgpath[musiclen - 4], ".m3u"))	// if it's from an M3U playlist
+		LevelMusicPath = "";
+	else											// if it's from a specified path
+		LevelMusicPath = cfgpath.data();
+	snprintf(full_filename.get(), size_full_filename, "%s%s", LevelMusicPath, music_filename);
+	return full_filename;
+}
+
 // To proceed tru our playlist. Usually used for continous play, but can loop as well.
 static void jukebox_hook_next()
 {
 	if (!JukeboxSongs.list || CGameCfg.CMLevelMusicTrack[0] == -1)
 		return;
 
-	if (GameCfg.CMLevelMusicPlayOrder == MUSIC_CM_PLAYORDER_RAND)
-		CGameCfg.CMLevelMusicTrack[0] = d_rand() % CGameCfg.CMLevelMusicTrack[1]; // simply a random selection - no check if this song has already been played. But that's how I roll!
-	else
-		CGameCfg.CMLevelMusicTrack[0]++;
-	if (CGameCfg.CMLevelMusicTrack[0] + 1 > CGameCfg.CMLevelMusicTrack[1])
-		CGameCfg.CMLevelMusicTrack[0] = 0;
+	const auto next = jukebox_next_track;
+	CGameCfg.CMLevelMusicTrack[0] = (next >= 0 && next < CGameCfg.CMLevelMusicTrack[1]) ? next : jukebox_choose_next_track();
 
 	jukebox_play();
 }
@@ -325,8 +359,8 @@ static void jukebox_hook_next()
 int jukebox_play()
 {
 	const char *music_filename;
-	uint_fast32_t size_full_filename = 0;
 
+	jukebox_next_track = -1;
 	if (!JukeboxSongs.list)
 		return 0;
 
@@ -339,25 +373,23 @@ int jukebox_play()
 		return 0;
 
 	size_t size_music_filename = strlen(music_filename);
-	auto &cfgpath = CGameCfg.CMLevelMusicPath;
-	size_t musiclen = strlen(cfgpath.data());
-	size_full_filename = musiclen + size_music_filename + 1;
-	RAIIdmem<char[]> full_filename;
-	CALLOC(full_filename, char[], size_full_filename);
-	const char *LevelMusicPath;
-	if (musiclen > 4 && !d_stricmp(&cfgpath[musiclen - 4], ".m3u"))	// if it's from an M3U playlist
-		LevelMusicPath = "";
-	else											// if it's from a specified path
-		LevelMusicPath = cfgpath.data();
-	snprintf(full_filename.get(), size_full_filename, "%s%s", LevelMusicPath, music_filename);
-
-	int played = songs_play_file(full_filename.get(), (GameCfg.CMLevelMusicPlayOrder == MUSIC_CM_PLAYORDER_LEVEL ? 1 : 0), (GameCfg.CMLevelMusicPlayOrder == MUSIC_CM_PLAYORDER_LEVEL ? nullptr : jukebox_hook_next));
-	full_filename.reset();
+	const bool continuous = GameCfg.CMLevelMusicPlayOrder != MUSIC_CM_PLAYORDER_LEVEL;
+	int played = songs_play_file(jukebox_track_path(music_filename).get(), !continuous, continuous ? jukebox_hook_next : nullptr);
 	if (!played)
 	{
 		return 0;	// whoops, got an error
 	}
 
+	/* Read the next track while this one plays, so that moving to it
+	 * does not wait for the disk.
+	 */
+	if (continuous)
+	{
+		jukebox_next_track = jukebox_choose_next_track();
+		if (const auto next_filename = JukeboxSongs.list[jukebox_next_track])
+			mix_prefetch_file(jukebox_track_path(next_filename).get());
+	}
+
 	// Formatting a pretty message
 	const char *prefix = "...";
 	if (size_music_filename >= MUSIC_HUDMSG_MAXLEN) {
@@ -0,0 +1,483 @@
+/*
+ * Portions of this file are copyright Rebirth contributors and licensed as
+ * described in COPYING.txt.
+ * Portions of this file are copyright Parallax Software and licensed
+ * according to the Parallax license below.
+ * See COPYING.txt for license details.
+
+THE COMPUTER CODE CONTAINED HEREIN IS THE SOLE PROPERTY OF PARALLAX
+SOFTWARE CORPORATION ("PARALLAX").  PARALLAX, IN DISTRIBUTING THE CODE TO
+END-USERS, AND SUBJECT TO ALL OF THE TERMS AND CONDITIONS HEREIN, GRANTS A
+ROYALTY-FREE, PERPETUAL LICENSE TO SUCH END-USERS FOR USE BY SUCH END-USERS
+IN USING, DISPLAYING,  AND CREATING DERIVATIVE WORKS THEREOF, SO LONG AS
+SUCH USE, DISPLAY OR CREATION IS FOR NON-COMMERCIAL, ROYALTY OR REVENUE
+FREE PURPOSES.  IN NO EVENT SHALL THE END-USER USE THE COMPUTER CODE
+CONTAINED HEREIN FOR REVENUE-BEARING PURPOSES.  THE END-USER UNDERSTANDS
+AND AGREES TO THE TERMS HEREIN AND ACCEPTS THE SAME BY USE OF THIS FILE.
+COPYRIGHT 1993-1998 PARALLAX SOFTWARE CORPORATION.  ALL RIGHTS RESERVED.
+*/
+
+/*
+ *
+ * Autosave system:
+ * Saves current mine to disk to prevent loss of work, and keeps the
+ * in-memory undo history.
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <math.h>
+#include <string.h>
+#include <time.h>
+#include <algorithm>
+#include <deque>
+#include <memory>
+#include <type_traits>
+#include <vector>
+
+#include "dxxerror.h"
+
+#include "inferno.h"
+#include "editor.h"
+#include "editor/esegment.h"
+#include "segment.h"
+#include "switch.h"
+#include "wall.h"
+#include "u_mem.h"
+#include "ui.h"
+#include "strutil.h"
+
+#include "compiler-cf_assert.h"
+#include "compiler-range_for.h"
+
+namespace dcx {
+
+#define AUTOSAVE_PERIOD 5			// Number of minutes for timed autosave
+
+static int Autosave_count;
+static int Autosave_total;
+
+static int Timer_save_flag;
+int		Autosave_flag;
+
+}
+
+namespace dsx {
+
+namespace {
+
+#define UNDO_MAX_RECORDS 64			// Older operations are forgotten
+
+struct undo_counts
+{
+	unsigned segments, Num_segments, vertices, Num_vertices, walls, triggers;
+};
+
+struct undo_cursor
+{
+	imsegptridx_t Cursegp = segment_none, Markedsegp = segment_none;
+	int Curside, Markedside;
+};
+
+template <typename T>
+struct undo_entry
+{
+	unsigned index;
+	T value;
+};
+
+template <typename T>
+using undo_entries = std::vector<undo_entry<T>>;
+
+//	The entries one operation changed, with the values they had before it.
+//	Undoing a record swaps those values with the mine, which leaves the
+//	record holding what is needed to redo it.
+struct undo_record
+{
+	const char *status;
+	undo_counts counts;
+	undo_cursor cursor;
+	undo_entries<segment> segments;
+	undo_entries<vertex> vertices;
+	undo_entries<uint8_t> vertex_active;
+	undo_entries<wall> walls;
+	undo_entries<trigger> triggers;
+};
+
+//	The mine as of the last checkpoint.  This is the only full copy; each
+//	record holds just the entries which differed from it.
+struct undo_history
+{
+	undo_counts counts;
+	undo_cursor cursor;
+	std::vector<segment> segments;
+	std::vector<vertex> vertices;
+	std::vector<uint8_t> vertex_active;
+	std::vector<wall> walls;
+	std::vector<trigger> triggers;
+	std::deque<undo_record> undo, redo;
+	//	Label for changes made since the last checkpoint.
+	const char *pending_status;
+	//	Whether the last checkpoint recorded anything, so undo_set_status
+	//	knows whether to label that record or the pending changes.
+	bool checkpoint_recorded;
+};
+
+undo_history Undo_history;
+
+}
+
+//	None of these types define ==, so compare and copy the bytes.  Padding
+//	only matters in that it can add an entry which restores to the same
+//	value.  std::addressof is used because walls and triggers hide their
+//	address from void pointers.
+template <typename T>
+static void undo_copy(T &dest, const T &src)
+{
+	static_assert(std::is_trivially_copyable<T>::value, "undo history can only hold plain data");
+	memcpy(std::addressof(dest), std::addressof(src), sizeof(T));
+}
+
+template <typename T>
+static bool undo_same(const T &a, const T &b)
+{
+	return !memcmp(std::addressof(a), std::addressof(b), sizeof(T));
+}
+
+template <typename T>
+static void undo_copy_all(std::vector<T> &dest, const T *const src, const std::size_t count)
+{
+	dest.resize(count);
+	for (std::size_t i = 0; i != count; ++i)
+		undo_copy(dest[i], src[i]);
+}
+
+template <typename T>
+static void undo_diff(undo_entries<T> &entries, std::vector<T> &base, const T *const live, const unsigned count)
+{
+	for (unsigned i = 0; i != count; ++i)
+	{
+		auto &b = base[i];
+		auto &l = live[i];
+		if (undo_same(b, l))
+			continue;
+		entries.emplace_back();
+		auto &e = entries.back();
+		e.index = i;
+		undo_copy(e.value, b);
+		undo_copy(b, l);
+	}
+}
+
+template <typename T>
+static void undo_swap(undo_entries<T> &entries, std::vector<T> &base, T *const live)
+{
+	range_for (auto &e, entries)
+	{
+		auto &l = live[e.index];
+		T old;
+		undo_copy(old, l);
+		undo_copy(l, e.value);
+		undo_copy(base[e.index], e.value);
+		undo_copy(e.value, old);
+	}
+}
+
+static undo_counts undo_get_counts()
+{
+	auto &Segments = LevelSharedSegmentState.get_segments();
+	auto &Vertices = LevelSharedVertexState.get_vertices();
+	auto &Walls = LevelUniqueWallSubsystemState.Walls;
+	auto &Triggers = LevelUniqueWallSubsystemState.Triggers;
+	return {Segments.get_count(), LevelSharedSegmentState.Num_segments, Vertices.get_count(), LevelSharedVertexState.Num_vertices, Walls.get_count(), Triggers.get_count()};
+}
+
+static void undo_set_counts(const undo_counts &c)
+{
+	LevelSharedSegmentState.get_segments().set_count(c.segments);
+	LevelSharedSegmentState.Num_segments = c.Num_segments;
+	LevelSharedVertexState.get_vertices().set_count(c.vertices);
+	LevelSharedVertexState.Num_vertices = c.Num_vertices;
+	LevelUniqueWallSubsystemState.Walls.set_count(c.walls);
+	LevelUniqueWallSubsystemState.Triggers.set_count(c.triggers);
+}
+
+static undo_cursor undo_get_cursor()
+{
+	undo_cursor c;
+	c.Cursegp = Cursegp;
+	c.Curside = Curside;
+	c.Markedsegp = Markedsegp;
+	c.Markedside = Markedside;
+	return c;
+}
+
+static void undo_set_cursor(const undo_cursor &c)
+{
+	Cursegp = c.Cursegp;
+	Curside = c.Curside;
+	Markedsegp = c.Markedsegp;
+	Markedside = c.Markedside;
+}
+
+//	Move everything which changed since the last checkpoint into r, and
+//	make the current mine the new checkpoint.  Returns whether anything
+//	changed.
+static bool undo_diff_mine(undo_record &r)
+{
+	auto &h = Undo_history;
+	auto &Segments = LevelSharedSegmentState.get_segments();
+	auto &Vertices = LevelSharedVertexState.get_vertices();
+	auto &Walls = LevelUniqueWallSubsystemState.Walls;
+	auto &Triggers = LevelUniqueWallSubsystemState.Triggers;
+	const auto counts = undo_get_counts();
+	r.status = h.pending_status;
+	r.counts = h.counts;
+	r.cursor = h.cursor;
+	const auto segs = Segments.data();
+	const auto nsegs = std::max(h.counts.segments, counts.segments);
+	//	Objects are not part of the history, so their links into the
+	//	segments are neither compared nor restored.
+	for (unsigned i = 0; i != nsegs; ++i)
+		h.segments[i].objects = segs[i].objects;
+	undo_diff(r.segments, h.segments, segs, nsegs);
+	const auto nverts = std::max(h.counts.vertices, counts.vertices);
+	undo_diff(r.vertices, h.vertices, Vertices.data(), nverts);
+	undo_diff(r.vertex_active, h.vertex_active, LevelSharedVertexState.get_vertex_active().data(), nverts);
+	undo_diff(r.walls, h.walls, Walls.data(), std::max(h.counts.walls, counts.walls));
+	undo_diff(r.triggers, h.triggers, Triggers.data(), std::max(h.counts.triggers, counts.triggers));
+	h.counts = counts;
+	h.cursor = undo_get_cursor();
+	return !(r.segments.empty() && r.vertices.empty() && r.vertex_active.empty() && r.walls.empty() && r.triggers.empty() && undo_same(r.counts, counts));
+}
+
+//	Record the changes since the last checkpoint as their own operation.
+//	Returns whether there were any.
+static bool undo_record_pending()
+{
+	auto &h = Undo_history;
+	undo_record r;
+	if (!undo_diff_mine(r))
+		return false;
+	h.pending_status = nullptr;
+	h.redo.clear();
+	h.undo.emplace_back(std::move(r));
+	if (h.undo.size() > UNDO_MAX_RECORDS)
+		h.undo.pop_front();
+	return true;
+}
+
+static void undo_apply(undo_record &r)
+{
+	auto &h = Undo_history;
+	auto &Segments = LevelSharedSegmentState.get_segments();
+	auto &Vertices = LevelSharedVertexState.get_vertices();
+	auto &Walls = LevelUniqueWallSubsystemState.Walls;
+	auto &Triggers = LevelUniqueWallSubsystemState.Triggers;
+	const auto segs = Segments.data();
+	undo_swap(r.segments, h.segments, segs);
+	range_for (auto &e, r.segments)
+	{
+		//	e.value is now the segment as it was before the swap.
+		segs[e.index].objects = h.segments[e.index].objects = e.value.objects;
+	}
+	undo_swap(r.vertices, h.vertices, Vertices.data());
+	undo_swap(r.vertex_active, h.vertex_active, LevelSharedVertexState.get_vertex_active().data());
+	undo_swap(r.walls, h.walls, Walls.data());
+	undo_swap(r.triggers, h.triggers, Triggers.data());
+	const auto counts = h.counts;
+	undo_set_counts(r.counts);
+	h.counts = r.counts;
+	r.counts = counts;
+	const auto cursor = h.cursor;
+	undo_set_cursor(r.cursor);
+	h.cursor = r.cursor;
+	r.cursor = cursor;
+}
+
+void undo_reset()
+{
+	auto &h = Undo_history;
+	auto &Segments = LevelSharedSegmentState.get_segments();
+	auto &Vertices = LevelSharedVertexState.get_vertices();
+	auto &Walls = LevelUniqueWallSubsystemState.Walls;
+	auto &Triggers = LevelUniqueWallSubsystemState.Triggers;
+	h.counts = undo_get_counts();
+	h.cursor = undo_get_cursor();
+	undo_copy_all(h.segments, Segments.data(), Segments.size());
+	undo_copy_all(h.vertices, Vertices.data(), Vertices.size());
+	auto &Vertex_active = LevelSharedVertexState.get_vertex_active();
+	undo_copy_all(h.vertex_active, Vertex_active.data(), Vertex_active.size());
+	undo_copy_all(h.walls, Walls.data(), Walls.size());
+	undo_copy_all(h.triggers, Triggers.data(), Triggers.size());
+	h.undo.clear();
+	h.redo.clear();
+	h.pending_status = nullptr;
+	h.checkpoint_recorded = false;
+}
+
+void undo_checkpoint()
+{
+	Undo_history.checkpoint_recorded = undo_record_pending();
+}
+
+void undo_set_status(const char *const status)
+{
+	auto &h = Undo_history;
+	if (h.checkpoint_recorded)
+		h.undo.back().status = status;
+	else
+		h.pending_status = status;
+}
+
+int undo(const char *&status)
+{
+	auto &h = Undo_history;
+	h.checkpoint_recorded = false;
+	undo_record_pending();
+	if (h.undo.empty())
+		return 1;
+	auto &r = h.undo.back();
+	undo_apply(r);
+	status = r.status;
+	h.redo.emplace_back(std::move(r));
+	h.undo.pop_back();
+	return 0;
+}
+
+int redo(const char *&status)
+{
+	auto &h = Undo_history;
+	h.checkpoint_recorded = false;
+	//	Changes since the last checkpoint replace whatever could be redone.
+	if (undo_record_pending() || h.redo.empty())
+		return 1;
+	auto &r = h.redo.back();
+	undo_apply(r);
+	status = r.status;
+	h.undo.emplace_back(std::move(r));
+	h.redo.pop_back();
+	return 0;
+}
+
+void init_autosave(void) {
+//    int i;
+
+    Autosave_count = 0;
+	 Autosave_flag = 0;
+	undo_reset();
+}
+
+void close_autosave(void) {
+    char *ext;
+
+	const unsigned t = Autosave_total;
+	cf_assert(t < 10);
+	for (unsigned i = 0; i < t; ++i)
+	{
+
+		char delname[PATH_MAX];
+
+        strcpy ( delname, mine_filename );
+        d_strupr( delname );
+	if ( !strcmp(delname, "*.MIN") ) strcpy(delname, "TEMP.MIN");
+
+        ext = strstr(delname, ".MIN");
+        snprintf(ext + 2, 3, "%d", i);
+
+        remove( delname );
+    }
+	auto &h = Undo_history;
+	h = {};
+}
+
+//	Saves current mine to name.miX where name = suffix of mine name and X = Autosave_count.
+//	For example, if name = "cookie.min", and Autosave_count = 3, then writes "cookie.mi3".
+//	Increments Autosave_count, wrapping from 9 to 0.
+//	(If there is no current mine name, assume "temp.min")
+static void autosave_mine(const char *name) {
+    char *ext;
+
+	if (Autosave_flag) {
+	
+		char savename[PATH_MAX];
+
+	
+	    strcpy ( savename, name );
+	    d_strupr( savename );
+	    if ( !strcmp(savename, "*.MIN") ) strcpy(savename, "TEMP.MIN");
+	
+	    ext = strstr(savename, ".MIN");
+	    snprintf(ext + 2, 3, "%d", Autosave_count);
+	
+	    med_save_mine( savename );
+	    Autosave_count++;
+	    if (Autosave_count > 9) Autosave_count -= 10;
+	    if (Autosave_total < 10)
+	        Autosave_total++;
+	
+	}
+
+}
+
+}
+
+namespace dcx {
+
+tm Editor_time_of_day;
+
+static void print_clock()
+{
+	int w, h;
+	gr_set_default_canvas();
+	auto &canvas = *grd_curcanv;
+	gr_set_fontcolor(canvas, CBLACK, CGREY);
+	array<char, 20> message;
+	if (!strftime(message.data(), message.size(), "%m-%d %H:%M:%S", &Editor_time_of_day))
+		message[0] = 0;
+	gr_get_string_size(*canvas.cv_font, message.data(), &w, &h, nullptr);
+	const uint8_t color = CGREY;
+	gr_rect(canvas, 700, 0, 799, h + 1, color);
+	gr_string(canvas, *canvas.cv_font, 700, 0, message.data(), w, h);
+	gr_set_fontcolor(canvas, CBLACK, CWHITE);
+}
+
+void set_editor_time_of_day()
+{
+	time_t	 ltime;
+
+	time( &ltime );
+	Editor_time_of_day = *localtime( &ltime );
+}
+
+}
+
+namespace dsx {
+
+void TimedAutosave(const char *name) 
+{
+	{
+		print_clock();
+	}
+	
+
+#ifndef DEMO
+	const auto &minute = Editor_time_of_day.tm_min;
+	if (minute%AUTOSAVE_PERIOD != 0)
+		Timer_save_flag = 1;
+
+	if ((minute%AUTOSAVE_PERIOD == 0) && (Timer_save_flag) && Autosave_flag) {
+		time_t	 ltime;
+
+		autosave_mine(name);
+		Timer_save_flag = 0;
+		time( &ltime );
+   	diagnostic_message_fmt("Mine Autosaved at %s\n", ctime(&ltime));
+	}
+#endif
+
+}
+
+}
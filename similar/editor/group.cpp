@@ -25,6 +25,7 @@ COPYRIGHT 1993-1998 PARALLAX SOFTWARE CORPORATION.  ALL RIGHTS RESERVED.
 
 #include <stdio.h>
 #include <string.h>
+#include <vector>
 
 #include "gr.h"
 #include "ui.h"
@@ -361,14 +362,25 @@ static inline vms_matrix med_create_group_rotation_matrix(int delta_flag, const
 	return med_create_group_rotation_matrix(result_mat, delta_flag, first_seg, first_side, base_seg, base_side, orient_matrix, orientation), result_mat;
 }
 
+// -----------------------------------------------------------------------------------------
+//	Mark every segment in seglist, so that membership can be tested without searching the list.
+static visited_segment_bitarray_t mark_segments(const count_segment_array_t &seglist)
+{
+	visited_segment_bitarray_t marked;
+	range_for (const auto segnum, seglist)
+		marked[segnum] = true;
+	return marked;
+}
+
 // -----------------------------------------------------------------------------------------
 // Rotate all vertices and objects in group.
 static void med_rotate_group(const vms_matrix &rotmat, group::segment_array_type_t &group_seglist, const vcsegptr_t first_seg, int first_side)
 {
 	array<int8_t, MAX_VERTICES> vertex_list;
+	std::vector<unsigned> group_vertices;
 	auto &Vertices = LevelSharedVertexState.get_vertices();
 	auto &vcvertptr = Vertices.vcptr;
-	auto &vmvertptridx = Vertices.vmptridx;
+	auto &vmvertptr = Vertices.vmptr;
 	const auto &&rotate_center = compute_center_point_on_side(vcvertptr, first_seg, first_side);
 
 	//	Create list of points to rotate.
@@ -379,7 +391,11 @@ static void med_rotate_group(const vms_matrix &rotmat, group::segment_array_type
 		auto &sp = *vmsegptr(gs);
 
 		range_for (const auto v, sp.verts)
-			vertex_list[v] = 1;
+			if (!vertex_list[v])
+			{
+				vertex_list[v] = 1;
+				group_vertices.emplace_back(v);
+			}
 
 		//	Rotate center of all objects in group.
 		range_for (const auto objp, objects_in(sp, vmobjptridx, vcsegptr))
@@ -391,19 +407,21 @@ static void med_rotate_group(const vms_matrix &rotmat, group::segment_array_type
 	}
 
 	// Do the pre-rotation xlate, do the rotation, do the post-rotation xlate
-	range_for (auto &&v, vmvertptridx)
-		if (vertex_list[v]) {
-			const auto &&tv1 = vm_vec_sub(*v, rotate_center);
-			const auto tv = vm_vec_rotate(tv1,rotmat);
-			vm_vec_add(*v, tv, rotate_center);
-		}
+	const auto n = group_vertices.size();
+	std::vector<vms_vector> tv1, tv(n);
+	tv1.reserve(n);
+	range_for (const auto v, group_vertices)
+		tv1.emplace_back(vm_vec_sub(*vcvertptr(v), rotate_center));
+	vm_vec_rotate_n(tv.data(), tv1.data(), n, rotmat);
+	for (std::size_t i = 0; i != n; ++i)
+		vm_vec_add(*vmvertptr(group_vertices[i]), tv[i], rotate_center);
 }
 
 // ------------------------------------------------------------------------------------------------
-static void cgl_aux(const vmsegptridx_t segp, group::segment_array_type_t &seglistp, selected_segment_array_t *ignore_list, visited_segment_bitarray_t &visited)
+static void cgl_aux(const vmsegptridx_t segp, group::segment_array_type_t &seglistp, const visited_segment_bitarray_t *ignore_list, visited_segment_bitarray_t &visited)
 {
 	if (ignore_list)
-		if (ignore_list->contains(segp))
+		if ((*ignore_list)[segp])
 			return;
 
 	if (!visited[segp]) {
@@ -421,7 +439,13 @@ static void cgl_aux(const vmsegptridx_t segp, group::segment_array_type_t &segli
 static void create_group_list(const vmsegptridx_t segp, group::segment_array_type_t &seglistp, selected_segment_array_t *ignore_list)
 {
 	visited_segment_bitarray_t visited;
-	cgl_aux(segp, seglistp, ignore_list, visited);
+	if (ignore_list)
+	{
+		const auto &&ignore = mark_segments(*ignore_list);
+		cgl_aux(segp, seglistp, &ignore, visited);
+	}
+	else
+		cgl_aux(segp, seglistp, nullptr, visited);
 }
 
 
@@ -433,6 +457,7 @@ static void duplicate_group(array<uint8_t, MAX_VERTICES> &vertex_ids, group::seg
 {
 	group::segment_array_type_t new_segments;
 	array<int, MAX_VERTICES> new_vertex_ids;		// If new_vertex_ids[v] != -1, then vertex v has been remapped to new_vertex_ids[v]
+	array<segnum_t, MAX_SEGMENTS> new_segment_ids;	// If new_segment_ids[s] != segment_none, then segment s has been copied to new_segment_ids[s]
 
 	//	duplicate vertices
 	new_vertex_ids.fill(-1);
@@ -449,11 +474,13 @@ static void duplicate_group(array<uint8_t, MAX_VERTICES> &vertex_ids, group::seg
 	}
 
 	//	duplicate segments
+	new_segment_ids.fill(segment_none);
 	range_for(const auto &gs, segments)
 	{
 		const auto &&segp = vmsegptr(gs);
 		const auto &&new_segment_id = med_create_duplicate_segment(Segments, segp);
 		new_segments.emplace_back(new_segment_id);
+		new_segment_ids[gs] = new_segment_id;
 		range_for (const auto objp, objects_in(segp, vmobjptridx, vmsegptr))
 		{
 			if (objp->type != OBJ_PLAYER) {
@@ -470,18 +497,8 @@ static void duplicate_group(array<uint8_t, MAX_VERTICES> &vertex_ids, group::seg
 		auto &sp = *vmsegptr(gs);
 		range_for (auto &seg, sp.children)
 		{
-			if (IS_CHILD(seg)) {
-				group::segment_array_type_t::iterator inew = new_segments.begin();
-				range_for (const auto i, segments)
-				{
-					if (seg == i)
-					{
-						seg = *inew;
-						break;
-					}
-					++inew;
-				}
-			}
+			if (IS_CHILD(seg) && new_segment_ids[seg] != segment_none)
+				seg = new_segment_ids[seg];
 		}	// end for (sidenum=0...
 
 		//	Now fixup vertex ids
@@ -505,16 +522,6 @@ static void duplicate_group(array<uint8_t, MAX_VERTICES> &vertex_ids, group::seg
 }
 
 
-// ------------------------------------------------------------------------------------------------
-static int in_group(segnum_t segnum, int group_num)
-{
-	range_for(const auto& s, GroupList[group_num].segments)
-		if (segnum == s)
-			return 1;
-
-	return 0;
-}
-
 // ------------------------------------------------------------------------------------------------
 //	Copy a group of segments.
 //	The group is defined as all segments accessible from group_seg.
@@ -591,12 +598,13 @@ static int med_copy_group(int delta_flag, const vmsegptridx_t base_seg, int base
 	auto &Vertices = LevelSharedVertexState.get_vertices();
 	auto &vcvertptr = Vertices.vcptr;
 	// Breaking connections between segments in the current group and segments not in the group.
+	const auto &&in_new_group = mark_segments(GroupList[new_current_group].segments);
 	range_for(const auto &gs, GroupList[new_current_group].segments)
 	{
 		const auto &&segp = base_seg.absolute_sibling(gs);
 		for (c=0; c < MAX_SIDES_PER_SEGMENT; c++) 
 			if (IS_CHILD(segp->children[c])) {
-				if (!in_group(segp->children[c], new_current_group)) {
+				if (!in_new_group[segp->children[c]]) {
 					segp->children[c] = segment_none;
 					validate_segment_side(vcvertptr, segp, c);					// we have converted a connection to a side so validate the segment
 				}
@@ -686,9 +694,10 @@ static int med_move_group(int delta_flag, const vmsegptridx_t base_seg, int base
 			in_vertex_list[v] = 1;
 
 	//	For all segments which are not in GroupList[current_group].segments, mark all their vertices in the out list.
+	const auto &&in_group = mark_segments(GroupList[current_group].segments);
 	range_for (const auto &&segp, vmsegptridx)
 	{
-		if (!GroupList[current_group].segments.contains(segp))
+		if (!in_group[segp])
 			{
 				range_for (auto &v, segp->verts)
 					out_vertex_list[v] = 1;
@@ -702,23 +711,29 @@ static int med_move_group(int delta_flag, const vmsegptridx_t base_seg, int base
 	auto &Vertices = LevelSharedVertexState.get_vertices();
 	auto &vcvertptr = Vertices.vcptr;
 	auto &vmvertptridx = Vertices.vmptridx;
+	array<int, MAX_VERTICES> new_vertex_ids;		// If new_vertex_ids[v] != -1, then vertex v has been remapped to new_vertex_ids[v]
+	new_vertex_ids.fill(-1);
+	bool shared_vertices = false;
 	range_for (auto &&v, vmvertptridx)
 		if (in_vertex_list[v])
 			if (out_vertex_list[v]) {
 				const auto new_vertex_id = med_create_duplicate_vertex(*v);
 				in_vertex_list[v] = 0;
 				in_vertex_list[new_vertex_id] = 1;
-
-				// Create a new vertex and assign all occurrences of vertex v in IN list to new vertex number.
-				range_for(const auto &gs, GroupList[current_group].segments)
-				{
-					auto &sp = *vmsegptr(gs);
-					range_for (auto &vv, sp.verts)
-						if (vv == v)
-							vv = new_vertex_id;
-				}
+				new_vertex_ids[v] = new_vertex_id;
+				shared_vertices = true;
 			}
 
+	// Assign all occurrences of each shared vertex in IN list to its new vertex number.
+	if (shared_vertices)
+		range_for(const auto &gs, GroupList[current_group].segments)
+		{
+			auto &sp = *vmsegptr(gs);
+			range_for (auto &vv, sp.verts)
+				if (new_vertex_ids[vv] != -1)
+					vv = new_vertex_ids[vv];
+		}
+
 	range_for(const auto &gs, GroupList[current_group].segments)
 		vmsegptr(gs)->group = current_group;
 
@@ -818,7 +833,7 @@ static int AttachSegmentNewAng(const vms_angvec &pbh)
 	const auto &&nsegp = vmsegptridx(newseg);
 	if (!med_move_group(1, Cursegp, Curside, nsegp, AttachSide, vm_angles_2_matrix(pbh),0))
 	{
-		autosave_mine(mine_filename);
+		undo_checkpoint();
 
 		med_propagate_tmaps_to_segments(Cursegp,nsegp,0);
 		med_propagate_tmaps_to_back_side(nsegp, Side_opposite[AttachSide],0);
@@ -959,7 +974,7 @@ int RotateSegmentNew(vms_angvec *pbh)
 {
 	int	rval;
 
-	autosave_mine(mine_filename);
+	undo_checkpoint();
 
 	rval = rotate_segment_new(*pbh);
 
@@ -1457,7 +1472,7 @@ int LoadGroup()
 		
 	if (!med_move_group(0, Cursegp, Curside, vmsegptridx(Groupsegp[current_group]), Groupside[current_group], vmd_identity_matrix, 0))
 	{
-		autosave_mine(mine_filename);
+		undo_checkpoint();
 		set_view_target_from_segment(Cursegp);
 		Update_flags |= UF_WORLD_CHANGED;
 		mine_changed = 1;
@@ -1589,7 +1604,7 @@ int MoveGroup(void)
 
 	if (!med_move_group(0, Cursegp, Curside, vmsegptridx(Groupsegp[current_group]), Groupside[current_group], vmd_identity_matrix, 0))
 	{
-		autosave_mine(mine_filename);
+		undo_checkpoint();
 		Update_flags |= UF_WORLD_CHANGED;
 		mine_changed = 1;
 		diagnostic_message("Group moved.");
@@ -1623,7 +1638,7 @@ int CopyGroup(void)
 
 	if (!med_copy_group(0, Cursegp, Curside, vcsegptr(Groupsegp[current_group]), Groupside[current_group], vmd_identity_matrix))
 	{
-		autosave_mine(mine_filename);
+		undo_checkpoint();
 		Update_flags |= UF_WORLD_CHANGED;
 		mine_changed = 1;
 		diagnostic_message("Group copied.");
@@ -1672,7 +1687,7 @@ int SubtractFromGroup(void)
 	}
 
 	med_compress_mine();
-	autosave_mine(mine_filename);
+	undo_checkpoint();
 
 	if (num_groups == MAX_GROUPS) {
 		x = ui_messagebox( -2, -2, 2, "Warning: You are about to wipe out a group.", "ARGH! NO!", "No problemo." );
@@ -1729,7 +1744,7 @@ int CreateGroup(void)
 	}
 
 	med_compress_mine();
-	autosave_mine(mine_filename);
+	undo_checkpoint();
 
 	if (num_groups == MAX_GROUPS) {
 		x = ui_messagebox( -2, -2, 2, "Warning: You are about to wipe out a group.", "ARGH! NO!", "No problemo." );
@@ -1770,7 +1785,7 @@ int DeleteGroup( void )
 {
 	int i;
 
-	autosave_mine(mine_filename);
+	undo_checkpoint();
 		
 	if (num_groups==0) return 0;
 
@@ -1795,7 +1810,7 @@ int DeleteGroup( void )
 	if (num_groups==0)
 		current_group = -1;
 
-	undo_status[Autosave_count] = "Delete Group UNDONE.";
+	undo_set_status("Delete Group UNDONE.");
    if (Lock_view_to_cursegp)
 	{
 		auto &Vertices = LevelSharedVertexState.get_vertices();
@@ -1817,12 +1832,12 @@ int MarkGroupSegment( void )
 {
 	if ((Cursegp->group != -1) && (Cursegp->group == current_group))
 		{
-	   autosave_mine(mine_filename);
+	   undo_checkpoint();
 		Groupsegp[current_group] = Cursegp;
 		Groupside[current_group] = Curside;
 		editor_status("Group Segment Marked.");
 		Update_flags |= UF_ED_STATE_CHANGED;
-		undo_status[Autosave_count] = "Mark Group Segment UNDONE.";
+		undo_set_status("Mark Group Segment UNDONE.");
 		mine_changed = 1;
 		return 1;
 		}
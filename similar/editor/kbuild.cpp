@@ -43,9 +43,9 @@ int CreateBridge()
     if (!med_form_bridge_segment(Cursegp,Curside,Markedsegp,Markedside)) {
 		Update_flags |= UF_WORLD_CHANGED;
 		mine_changed = 1;
-    	autosave_mine(mine_filename);
+    	undo_checkpoint();
     	diagnostic_message("Bridge segment formed.");
-		undo_status[Autosave_count] = "Bridge segment UNDONE.";
+		undo_set_status("Bridge segment UNDONE.");
     	warn_if_concave_segments();
 	}
     return 1;
@@ -62,9 +62,9 @@ int FormJoint()
         if (!med_form_joint(Cursegp,Curside,Markedsegp,Markedside)) {
             Update_flags |= UF_WORLD_CHANGED;
             mine_changed = 1;
-            autosave_mine(mine_filename);
+            undo_checkpoint();
             diagnostic_message("Joint formed.");
-			undo_status[Autosave_count] = "Joint undone.";
+			undo_set_status("Joint undone.");
     			warn_if_concave_segments();
         }
 	}
@@ -84,9 +84,9 @@ int CreateAdjacentJoint()
 			med_form_joint(Cursegp,Curside,adj_sp,adj_side);
 			Update_flags |= UF_WORLD_CHANGED;
 			mine_changed = 1;
-         autosave_mine(mine_filename);
+         undo_checkpoint();
          diagnostic_message("Joint segment formed.");
-			undo_status[Autosave_count] = "Joint segment undone.";
+			undo_set_status("Joint segment undone.");
     		warn_if_concave_segments();
 		} else
 			editor_status("Attempted to form joint through connected side -- joint segment not formed (you bozo).");
@@ -114,9 +114,9 @@ int CreateSloppyAdjacentJoint()
 				{
 				Update_flags |= UF_WORLD_CHANGED;
 				mine_changed = 1;
-	         autosave_mine(mine_filename);
+	         undo_checkpoint();
 	         diagnostic_message("Sloppy Joint segment formed.");
-				undo_status[Autosave_count] = "Sloppy Joint segment undone.";
+				undo_set_status("Sloppy Joint segment undone.");
 	    		warn_if_concave_segments();
 				}
 			else editor_status("Could not form sloppy joint.\n");
@@ -134,6 +134,7 @@ int CreateSloppyAdjacentJointsGroup()
 {
 	int		adj_side;
 	int		done_been_a_change = 0;
+	med_segment_index_scope segment_index;
 	range_for(const auto &gs, GroupList[current_group].segments)
 	{
 		auto segp = vmsegptridx(gs);
@@ -155,9 +156,9 @@ int CreateSloppyAdjacentJointsGroup()
 	if (done_been_a_change) {
 		Update_flags |= UF_WORLD_CHANGED;
 		mine_changed = 1;
-		autosave_mine(mine_filename);
+		undo_checkpoint();
 		diagnostic_message("Sloppy Joint segment formed.");
-		undo_status[Autosave_count] = "Sloppy Joint segment undone.";
+		undo_set_status("Sloppy Joint segment undone.");
 		warn_if_concave_segments();
 	}
 
@@ -181,9 +182,9 @@ int CreateAdjacentJointsSegment()
 					med_form_joint(Cursegp,s,adj_sp,adj_side);
 					Update_flags |= UF_WORLD_CHANGED;
 					mine_changed = 1;
-	            autosave_mine(mine_filename);
+	            undo_checkpoint();
 	            diagnostic_message("Adjacent Joint segment formed.");
-				undo_status[Autosave_count] = "Adjacent Joint segment UNDONE.";
+				undo_set_status("Adjacent Joint segment UNDONE.");
 	    			warn_if_concave_segments();
 					}
 	}
@@ -199,6 +200,7 @@ int CreateAdjacentJointsAll()
 	auto &Vertex_active = LevelSharedVertexState.get_vertex_active();
 	med_combine_duplicate_vertices(Vertex_active);
 
+	med_segment_index_scope segment_index;
 	range_for (const auto &&segp, vmsegptridx)
 	{
 		for (int s=0; s<MAX_SIDES_PER_SEGMENT; s++)
@@ -212,9 +214,9 @@ int CreateAdjacentJointsAll()
 
 	Update_flags |= UF_WORLD_CHANGED;
 	mine_changed = 1;
-   autosave_mine(mine_filename);
+   undo_checkpoint();
    diagnostic_message("All Adjacent Joint segments formed.");
-	undo_status[Autosave_count] = "All Adjacent Joint segments UNDONE.";
+	undo_set_status("All Adjacent Joint segments UNDONE.");
  	warn_if_concave_segments();
    return 1;
 }
@@ -45,13 +45,13 @@ int GenerateCurve()
 	if (Markedsegp != segment_none && !IS_CHILD(Markedsegp->children[Markedside]))
 	{
 		r1scale = r4scale = F1_0*20;
-      autosave_mine( mine_filename );
+      undo_checkpoint();
       diagnostic_message("Curve Generated.");
 		Update_flags |= UF_WORLD_CHANGED;
       curve = generate_curve(r1scale, r4scale);
 		mine_changed = 1;
         if (curve == 1) {
-			undo_status[Autosave_count] = "Curve Generation UNDONE.";
+			undo_set_status("Curve Generation UNDONE.");
         }
         if (curve == 0) diagnostic_message("Cannot generate curve -- check Current segment.");
     }
@@ -136,7 +136,7 @@ set_average_light_on_curside();
 int SetCurve()
 {
 	if (curve) curve = 0;
-   //autosave_mine( mine_filename );
+   //undo_checkpoint();
    //strcpy(undo_status[Autosave_count], "Curve Generation UNDONE.\n");
    return 1;
 }
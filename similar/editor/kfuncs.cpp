@@ -248,6 +248,7 @@ const FUNCTION med_functions[] = {
 
 //  In autosave.c
 {   "med-autosave-undo",                0,      UndoCommand },
+{   "med-autosave-redo",                0,      RedoCommand },
 {	 "med-autosave-toggle",					 0,		ToggleAutosave },
 
 //	In texture.c
@@ -348,6 +349,7 @@ const FUNCTION med_functions[] = {
 {   "med-set-player-from-curseg",       0,        SetPlayerFromCursegAndRotate },
 {   "med-set-player-from-curseg-minus-one", 0,        SetPlayerFromCursegMinusOne },
 {   "med-find-concave-segs",            0,        FindConcaveSegs },
+{   "med-check-mine",                   0,        CheckMine },
 {   "med-select-next-found-seg",        0,        SelectNextFoundSeg },
 {   "med-select-prev-found-seg",        0,        SelectPreviousFoundSeg },
 {   "med-stop-slew",                    0,        slew_stop },
@@ -171,6 +171,7 @@ if (SafetyCheck())  {
 		Perm_player_position = ConsoleObject->pos;
 		Perm_player_orient = ConsoleObject->orient;
 		Perm_player_segnum = ConsoleObject->segnum;
+		undo_reset();
 		}
 	}
 	return 1;
@@ -129,6 +129,7 @@ int CreateNewMine()
 		ResetFilename();
 		Game_mode = GM_UNKNOWN;
 		Current_level_num = 1;		// make level 1
+		undo_reset();
 	}
 	return 1;
 }
@@ -169,8 +169,8 @@ int SelectPrevSide()
 
 int CopySegToMarked()
 {
-   autosave_mine(mine_filename);
-	undo_status[Autosave_count] = "Mark Segment UNDONE.";
+   undo_checkpoint();
+	undo_set_status("Mark Segment UNDONE.");
 	Markedsegp = Cursegp;
 	Markedside = Curside;
 	Update_flags |= UF_ED_STATE_CHANGED;
@@ -33,8 +33,8 @@ COPYRIGHT 1993-1998 PARALLAX SOFTWARE CORPORATION.  ALL RIGHTS RESERVED.
 //	Assign CurrentTexture to Curside in *Cursegp
 int AssignTexture(void)
 {
-   autosave_mine( mine_filename );
-	undo_status[Autosave_count] = "Assign Texture UNDONE.";
+   undo_checkpoint();
+	undo_set_status("Assign Texture UNDONE.");
 
 	Cursegp->unique_segment::sides[Curside].tmap_num = CurrentTexture;
 
@@ -52,8 +52,8 @@ int AssignTexture2(void)
 {
 	int texnum, orient, ctexnum, newtexnum;
 
-   autosave_mine( mine_filename );
-	undo_status[Autosave_count] = "Assign Texture 2 UNDONE.";
+   undo_checkpoint();
+	undo_set_status("Assign Texture 2 UNDONE.");
 
 	{
 		const unique_segment &useg = *Cursegp;
@@ -81,8 +81,8 @@ int AssignTexture2(void)
 
 int ClearTexture2(void)
 {
-   autosave_mine( mine_filename );
-	undo_status[Autosave_count] = "Clear Texture 2 UNDONE.";
+   undo_checkpoint();
+	undo_set_status("Clear Texture 2 UNDONE.");
 
 	Cursegp->unique_segment::sides[Curside].tmap_num2 = 0;
 
@@ -100,8 +100,8 @@ int ClearTexture2(void)
 //	If move_flag !0, then move forward to new segment after propagation, else don't
 static int propagate_textures_common(int uv_flag, int move_flag)
 {
-   autosave_mine( mine_filename );
-	undo_status[Autosave_count] = "Propagate Textures UNDONE.";
+   undo_checkpoint();
+	undo_set_status("Propagate Textures UNDONE.");
 	const auto c = Cursegp->children[Curside];
 	if (IS_CHILD(c))
 		med_propagate_tmaps_to_segments(Cursegp, vmsegptridx(c), uv_flag);
@@ -173,8 +173,8 @@ static void pts_aux(const vmsegptridx_t sp, visited_segment_bitarray_t &visited)
 //	until a segment not in Selected_list is reached.
 int PropagateTexturesSelected(void)
 {
-   autosave_mine( mine_filename );
-	undo_status[Autosave_count] = "Propogate Textures Selected UNDONE.";
+   undo_checkpoint();
+	undo_set_status("Propogate Textures Selected UNDONE.");
 
 	visited_segment_bitarray_t visited;
 	visited[Cursegp] = true;
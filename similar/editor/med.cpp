@@ -61,6 +61,7 @@ COPYRIGHT 1993-1998 PARALLAX SOFTWARE CORPORATION.  ALL RIGHTS RESERVED.
 #endif
 #include "u_mem.h"
 #include "render.h"
+#include "lighting.h"
 #include "game.h"
 #include "gamefont.h"
 #include "menu.h"
@@ -204,6 +205,13 @@ void editor_status( const char *text)
 	Editor_status_last_time = Editor_time_of_day;
 }
 
+//	Draw the status line now, for long operations which do not return to the event loop.
+void editor_status_show()
+{
+	print_status_bar(status_line);
+	gr_flip();
+}
+
 // 	int  tm_sec;	/* seconds after the minute -- [0,61] */
 // 	int  tm_min;	/* minutes after the hour	-- [0,59] */
 // 	int  tm_hour;	/* hours after midnight	-- [0,23] */
@@ -674,6 +682,20 @@ int FindConcaveSegs()
 	return 1;
 }
 
+//	Everything the editor checks incrementally after each edit, done for the
+//	whole mine.
+int CheckMine()
+{
+	validate_segment_all(LevelSharedSegmentState);
+	const auto errors = check_segment_connections();
+	find_concave_segs();
+	editor_status_fmt("Mine checked: %s, %u concave segments.", errors ? "connection errors found" : "connections OK", static_cast<unsigned>(Warning_segs.size()));
+
+	Update_flags |= UF_WORLD_CHANGED;
+
+	return 1;
+}
+
 static int ToggleOutlineMode()
 {
 #ifndef NDEBUG
@@ -907,6 +929,12 @@ static void close_editor()
 #endif
 	
 	close_editor_screen();
+
+	//the mine may have been edited
+	render_build_pvs();
+	render_build_segment_tables();
+	build_segment_point_grid();
+	reset_dynamic_light();
 	
 	//kill our camera object
 	
@@ -1049,6 +1077,7 @@ int RestoreGameState()
 	editor_slew_init();
 	
 	gamestate = editor_gamestate::saved;
+	undo_reset();
 
 	editor_status("Gamestate restored.\n");
 
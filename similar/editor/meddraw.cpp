@@ -28,6 +28,8 @@ COPYRIGHT 1993-1998 PARALLAX SOFTWARE CORPORATION.  ALL RIGHTS RESERVED.
 #include <stdlib.h>
 #include <stdarg.h>
 #include <string.h>
+#include <unordered_map>
+#include <vector>
 #include "inferno.h"
 #include "segment.h"
 #include "segpoint.h"
@@ -61,8 +63,6 @@ COPYRIGHT 1993-1998 PARALLAX SOFTWARE CORPORATION.  ALL RIGHTS RESERVED.
 #include "ogl_init.h"
 #endif
 
-using std::min;
-
 //	Colors used in editor for indicating various kinds of segments.
 #define	SELECT_COLOR		BM_XRGB( 63/2 , 41/2 ,  0/2)
 #define	FOUND_COLOR			BM_XRGB(  0/2 , 30/2 , 45/2)
@@ -80,8 +80,6 @@ using std::min;
 #define	ROBOT_COLOR			BM_XRGB( 31   ,  0   ,  0  )
 #define	PLAYER_COLOR		BM_XRGB(  0   ,  0   , 31  )
 
-constexpr std::integral_constant<unsigned, MAX_VERTICES * 4> MAX_EDGES{};
-
 static int     Search_mode=0;                      //if true, searching for segments at given x,y
 static int Search_x,Search_y;
 static int	Automap_test=0;		//	Set to 1 to show wireframe in automap mode.
@@ -136,6 +134,50 @@ static void draw_segment(grs_canvas &canvas, const shared_segment &seg, const ui
 	}
 }
 
+//	Return the sign of the area of p0, p1, (x, y) on the screen.
+static int screen_side_of_edge(const g3s_point &p0, const g3s_point &p1, const fix x, const fix y)
+{
+	const auto cross = static_cast<int64_t>(p1.p3_sx - p0.p3_sx) * (y - p0.p3_sy) - static_cast<int64_t>(p1.p3_sy - p0.p3_sy) * (x - p0.p3_sx);
+	return (cross > 0) - (cross < 0);
+}
+
+//	Whether a facing triangle of seg covers the search pixel.  Returns -1 if a point
+//	is behind the viewer or cannot be projected, since then only clipping can tell.
+static int segment_covers_search_pixel(const shared_segment &seg)
+{
+	auto &svp = seg.verts;
+	range_for (const auto v, svp)
+	{
+		auto &p = Segment_points[v];
+		if (p.p3_codes & CC_BEHIND)
+			return -1;
+		if (!(p.p3_flags & PF_PROJECTED))
+			g3_project_point(p);
+		if (p.p3_flags & PF_OVERFLOW)
+			return -1;
+	}
+	const fix x = i2f(Search_x) + F1_0 / 2, y = i2f(Search_y) + F1_0 / 2;
+	range_for (auto &fn, Side_to_verts)
+	{
+		for (unsigned t = 0; t != 2; ++t)
+		{
+			const array<cg3s_point *, 3> vert_list{{
+				&Segment_points[svp[fn[0]]],
+				&Segment_points[svp[fn[t + 1]]],
+				&Segment_points[svp[fn[t + 2]]],
+			}};
+			if (!do_facing_check(vert_list))
+				continue;
+			const auto s0 = screen_side_of_edge(*vert_list[0], *vert_list[1], x, y);
+			const auto s1 = screen_side_of_edge(*vert_list[1], *vert_list[2], x, y);
+			const auto s2 = screen_side_of_edge(*vert_list[2], *vert_list[0], x, y);
+			if ((s0 >= 0 && s1 >= 0 && s2 >= 0) || (s0 <= 0 && s1 <= 0 && s2 <= 0))
+				return 1;
+		}
+	}
+	return 0;
+}
+
 //for looking for segment under a mouse click
 static void check_segment(const vmsegptridx_t seg)
 {
@@ -144,6 +186,15 @@ static void check_segment(const vmsegptridx_t seg)
 	auto &vcvertptr = Vertices.vcptr;
 	if (!rotate_list(vcvertptr, svp).uand)
 	{		//all off screen?
+		//	Most segments are entirely in front of the viewer, and can be tested without
+		//	drawing them.
+		const auto covers = segment_covers_search_pixel(seg);
+		if (covers >= 0)
+		{
+			if (covers)
+				Found_segs.emplace_back(seg);
+			return;
+		}
 #if DXX_USE_OGL
 		g3_end_frame();
 #endif
@@ -230,28 +281,6 @@ const
 #endif
 array<color_t, 3> edge_colors{{54, 59, 64}};
 
-namespace {
-
-struct seg_edge
-{
-	union {
-		struct {int v0,v1;} __pack__ n;
-		long vv;
-	}v;
-	ushort	type;
-	ubyte		face_count, backface_count;
-};
-
-}
-
-static array<seg_edge, MAX_EDGES> edge_list;
-static array<int, MAX_EDGES> used_list;	//which entries in edge_list have been used
-static int n_used;
-
-static unsigned edge_list_size;		//set each frame
-
-#define HASH(a,b)  ((a*5+b) % edge_list_size)
-
 //define edge numberings
 constexpr int edges[] = {
 		0*8+1,	// edge  0
@@ -290,96 +319,152 @@ constexpr int edges[] = {
 
 using std::swap;
 
-//given two vertex numbers on a segment (range 0..7), tell what edge number it is
-static int find_edge_num(int v0,int v1)
-{
-	int		i;
-	int		vv;
-	const int		*edgep = edges;
-
-	if (v0 > v1) swap(v0,v1);
-
-	vv = v0*8+v1;
-
-//	for (i=0;i<N_EDGES_PER_SEGMENT;i++)
-//		if (edges[i]==vv) return i;
-
-	for (i=N_EDGES_PER_SEGMENT; i; i--)
-		if (*edgep++ == vv)
-			return (N_EDGES_PER_SEGMENT-i);
-
-	Error("Could not find edge for %d,%d",v0,v1);
-
-	//return -1;
-}
-
+namespace {
 
-//finds edge, filling in edge_ptr. if found old edge, returns index, else return -1
-static int find_edge(int v0,int v1,seg_edge **edge_ptr)
+struct seg_edge
 {
-	long vv;
-	int hash,oldhash;
-	int ret;
-
-	vv = (v1<<16) + v0;
-
-	oldhash = hash = HASH(v0,v1);
-
-	ret = -1;
+	unsigned v0, v1;
+	unsigned refs;		//number of segments which have this edge
+	unsigned frame;		//frame in which type and the counts were last set
+	uint8_t type, face_count, backface_count;
+};
 
-	while (ret==-1) {
+//	Every edge of the segments drawn so far, so that a frame can find an edge by
+//	index instead of hashing its vertices.  A segment registers its edges the first
+//	time it is drawn, and again when its vertices change.
+class mine_edge_set
+{
+	struct segment_edges
+	{
+		bool registered;
+		array<unsigned, MAX_VERTICES_PER_SEGMENT> verts;
+		array<unsigned, N_EDGES_PER_SEGMENT> edges;
+	};
+	std::unordered_map<uint64_t, unsigned> index;
+	std::vector<seg_edge> edge_list;
+	std::vector<unsigned> free_edges;
+	std::vector<segment_edges> segments;
+	unsigned frame = 0;
+	unsigned acquire(unsigned v0, unsigned v1);
+	void release(unsigned edge);
+public:
+	std::vector<unsigned> used_list;	//edges added this frame, in the order they were added
+	void begin_frame()
+	{
+		++frame;
+		used_list.clear();
+	}
+	const array<unsigned, N_EDGES_PER_SEGMENT> &get_segment_edges(segnum_t segnum, const shared_segment &seg);
+	void add_edge(unsigned edge, uint8_t type);
+	const seg_edge &operator[](const unsigned edge) const
+	{
+		return edge_list[edge];
+	}
+};
 
-		if (edge_list[hash].type == ET_EMPTY) ret=0;
-		else if (edge_list[hash].v.vv == vv) ret=1;
-		else {
-			if (++hash==edge_list_size) hash=0;
-			if (hash==oldhash) Error("Edge list full!");
+unsigned mine_edge_set::acquire(unsigned v0, unsigned v1)
+{
+	if (v0 > v1) swap(v0,v1);
+	const auto r = index.emplace((static_cast<uint64_t>(v0) << 32) | v1, 0);
+	if (r.second)
+	{
+		unsigned edge;
+		if (free_edges.empty())
+		{
+			edge = edge_list.size();
+			edge_list.emplace_back();
 		}
+		else
+		{
+			edge = free_edges.back();
+			free_edges.pop_back();
+		}
+		edge_list[edge] = {v0, v1, 0, 0, 0, 0, 0};
+		r.first->second = edge;
 	}
+	const auto edge = r.first->second;
+	++edge_list[edge].refs;
+	return edge;
+}
 
-	*edge_ptr = &edge_list[hash];
-
-	if (ret == 0)
-		return -1;
-	else
-		return hash;
-
+void mine_edge_set::release(const unsigned edge)
+{
+	auto &e = edge_list[edge];
+	if (--e.refs)
+		return;
+	index.erase((static_cast<uint64_t>(e.v0) << 32) | e.v1);
+	free_edges.emplace_back(edge);
 }
 
-//adds an edge to the edge list
-static void add_edge(int v0,int v1,ubyte type)
+const array<unsigned, N_EDGES_PER_SEGMENT> &mine_edge_set::get_segment_edges(const segnum_t segnum, const shared_segment &seg)
+{
+	if (segments.empty())
+		segments.resize(MAX_SEGMENTS);
+	auto &s = segments[segnum];
+	if (s.registered && s.verts == seg.verts)
+		return s.edges;
+	//	The segment is new or has been edited.  Acquire the new edges before releasing
+	//	the old ones, so that the edges that did not change keep their index.
+	array<unsigned, N_EDGES_PER_SEGMENT> new_edges;
+	for (unsigned i = 0; i != N_EDGES_PER_SEGMENT; ++i)
+		new_edges[i] = acquire(seg.verts[edges[i] / 8], seg.verts[edges[i] & 7]);
+	if (s.registered)
+		range_for (const auto edge, s.edges)
+			release(edge);
+	s.registered = true;
+	s.verts = seg.verts;
+	s.edges = new_edges;
+	return s.edges;
+}
+
+void mine_edge_set::add_edge(const unsigned edge, const uint8_t type)
 {
-	int found;
+	auto &e = edge_list[edge];
+	if (e.frame != frame)
+	{
+		e.frame = frame;
+		e.type = type;
+		e.face_count = 0;
+		e.backface_count = 0;
+		used_list.emplace_back(edge);
+	}
+	else if (type < e.type)
+		e.type = type;
+	if (type == ET_FACING)
+		e.face_count++;
+	else if (type == ET_NOTFACING)
+		e.backface_count++;
+}
 
-	seg_edge *e;
+}
 
-	if (v0 > v1) swap(v0,v1);
+static mine_edge_set Mine_edges;
 
-	found = find_edge(v0,v1,&e);
-
-	if (found == -1) {
-		e->v.n.v0 = v0;
-		e->v.n.v1 = v1;
-		e->type = type;
-		used_list[n_used] = e - edge_list.begin();
-		if (type == ET_FACING)
-			edge_list[used_list[n_used]].face_count++;
-		else if (type == ET_NOTFACING)
-			edge_list[used_list[n_used]].backface_count++;
-		n_used++;
-	} else {
-		if (type < e->type)
-			e->type = type;
-		if (type == ET_FACING)
-			edge_list[found].face_count++;
-		else if (type == ET_NOTFACING)
-			edge_list[found].backface_count++;
+//given two vertex numbers on a segment (range 0..7), tell what edge number it is
+static const array<array<int8_t, 8>, 8> edge_num_table = []() {
+	array<array<int8_t, 8>, 8> table;
+	range_for (auto &t, table)
+		t.fill(-1);
+	for (unsigned i = 0; i != N_EDGES_PER_SEGMENT; ++i)
+	{
+		const unsigned v0 = edges[i] / 8, v1 = edges[i] & 7;
+		table[v0][v1] = table[v1][v0] = i;
 	}
+	return table;
+}();
+
+static int find_edge_num(int v0,int v1)
+{
+	const int en = edge_num_table[v0][v1];
+	if (en < 0)
+		Error("Could not find edge for %d,%d",v0,v1);
+	return en;
 }
 
 //adds a segment's edges to the edge list
-static void add_edges(const shared_segment &seg)
+static void add_edges(const vcsegptridx_t segp)
 {
+	const shared_segment &seg = *segp;
 	auto &svp = seg.verts;
 	auto &Vertices = LevelSharedVertexState.get_vertices();
 	auto &vcvertptr = Vertices.vcptr;
@@ -430,9 +515,10 @@ static void add_edges(const shared_segment &seg)
 			}
 		}
 
+		auto &seg_edges = Mine_edges.get_segment_edges(segp, seg);
 		for (i=0; i<N_EDGES_PER_SEGMENT; i++)
 			if (i<N_NORMAL_EDGES || (edge_flags[i]!=ET_NOTEXTANT && Show_triangulations))
-				add_edge(seg.verts[edges[i] / 8], seg.verts[edges[i] & 7], edge_flags[i]);
+				Mine_edges.add_edge(seg_edges[i], edge_flags[i]);
 	}
 }
 
@@ -540,28 +626,24 @@ static void draw_mine_sub(const vmsegptridx_t segnum,int depth, visited_segment_
 
 static void draw_mine_edges(int automap_flag)
 {
-	int i,type;
-	seg_edge *e;
+	int type;
 
+#if DXX_USE_OGL
+	ogl_begin_line_batch();
+#endif
 	for (type=ET_NOTUSED;type>=ET_FACING;type--) {
 		const auto color = edge_colors[type];
-		for (i=0;i<n_used;i++) {
-			e = &edge_list[used_list[i]];
-			if (e->type == type)
-				if ((!automap_flag) || (e->face_count == 1))
-					draw_line(*grd_curcanv, e->v.n.v0, e->v.n.v1, color);
+		range_for (const auto i, Mine_edges.used_list)
+		{
+			auto &e = Mine_edges[i];
+			if (e.type == type)
+				if ((!automap_flag) || (e.face_count == 1))
+					draw_line(*grd_curcanv, e.v0, e.v1, color);
 		}
 	}
-}
-
-static void clear_edge_list()
-{
-	range_for (auto &i, partial_range(edge_list, edge_list_size))
-	{
-		i.type = ET_EMPTY;
-		i.face_count = 0;
-		i.backface_count = 0;
-	}
+#if DXX_USE_OGL
+	ogl_end_line_batch();
+#endif
 }
 
 //draws an entire mine
@@ -569,12 +651,7 @@ static void draw_mine(const vmsegptridx_t mine_ptr,int depth)
 {
 	visited_segment_bitarray_t visited;
 
-	edge_list_size = min(LevelSharedSegmentState.Num_segments * 12, MAX_EDGES.value);		//make maybe smaller than max
-
-	// clear edge list
-	clear_edge_list();
-
-	n_used = 0;
+	Mine_edges.begin_frame();
 
 	draw_mine_sub(mine_ptr,depth, visited);
 
@@ -587,12 +664,7 @@ static void draw_mine(const vmsegptridx_t mine_ptr,int depth)
 //	A segment is drawn if its segnum != -1.
 static void draw_mine_all(int automap_flag)
 {
-	edge_list_size = min(LevelSharedSegmentState.Num_segments * 12, MAX_EDGES.value);		//make maybe smaller than max
-
-	// clear edge list
-	clear_edge_list();
-
-	n_used = 0;
+	Mine_edges.begin_frame();
 
 	range_for (const auto &&segp, vmsegptridx)
 	{
@@ -150,8 +150,8 @@ int medlisp_delete_segment(void)
 			auto &vcvertptr = Vertices.vcptr;
             set_view_target_from_segment(vcvertptr, Cursegp);
 		}
-		  autosave_mine(mine_filename);
-		undo_status[Autosave_count] = "Delete Segment UNDONE.";
+		  undo_checkpoint();
+		undo_set_status("Delete Segment UNDONE.");
         Update_flags |= UF_WORLD_CHANGED;
         mine_changed = 1;
         diagnostic_message("Segment deleted.");
@@ -341,28 +341,43 @@ void draw_world_from_game(void)
 		draw_world(Views[0]->ev_canv,Views[0],Cursegp,Big_depth);
 }
 
-int UndoCommand()
-{   int u;
-
-    u = undo();
+static void undo_redo_finished()
+{
     if (Lock_view_to_cursegp)
 	{
 		auto &Vertices = LevelSharedVertexState.get_vertices();
 		auto &vcvertptr = Vertices.vcptr;
 		set_view_target_from_segment(vcvertptr, Cursegp);
 	}
-    if (u == 0) {
-        if (Autosave_count==9) diagnostic_message(undo_status[0]);
-            else
-                diagnostic_message(undo_status[Autosave_count+1]);
-        }
-        else
-	 if (u == 1) diagnostic_message("Can't Undo.");
-        else
-	 if (u == 2) diagnostic_message("Can't Undo - Autosave OFF");
     Update_flags |= UF_WORLD_CHANGED;
 	 mine_changed = 1;
     warn_if_concave_segments();
+}
+
+int UndoCommand()
+{
+	const char *status;
+	if (undo(status))
+	{
+		diagnostic_message("Can't Undo.");
+		return 1;
+	}
+	undo_redo_finished();
+	diagnostic_message(status ? status : "Operation UNDONE.");
+    return 1;
+}
+
+int RedoCommand()
+{
+	const char *status;
+	if (redo(status))
+	{
+		diagnostic_message("Can't Redo.");
+		return 1;
+	}
+	undo_redo_finished();
+	// The labels describe undoing, so they do not fit here.
+	diagnostic_message("Operation REDONE.");
     return 1;
 }
 
@@ -392,8 +407,8 @@ int AttachSegment()
 		vm_angvec_make(&Seg_orientation,0,0,0);
 		Curside = WBACK;
 		Update_flags |= UF_WORLD_CHANGED;
-	   autosave_mine(mine_filename);
-		undo_status[Autosave_count] = "Attach Segment UNDONE.";
+	   undo_checkpoint();
+		undo_set_status("Attach Segment UNDONE.");
 		mine_changed = 1;
 		warn_if_concave_segment(Cursegp);
       }
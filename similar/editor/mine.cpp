@@ -332,7 +332,7 @@ int med_save_mine(const char * filename)
 {
 	char ErrorMessage[256];
 
-	auto SaveFile = PHYSFSX_openWriteBuffered(filename);
+	auto SaveFile = PHYSFSX_openReplaceBuffered(filename);
 	if (!SaveFile)
 	{
 		snprintf(ErrorMessage, sizeof(ErrorMessage), "ERROR: Unable to open %s\n", filename);
@@ -343,6 +343,12 @@ int med_save_mine(const char * filename)
 	save_mine_data(SaveFile);
 	
 	//==================== CLOSE THE FILE =============================
+	if (!PHYSFSX_commitReplace(SaveFile, filename))
+	{
+		snprintf(ErrorMessage, sizeof(ErrorMessage), "ERROR: Unable to write %s\n", filename);
+		ui_messagebox( -2, -2, 1, ErrorMessage, "Ok" );
+		return 1;
+	}
 	return 0;
 }
 
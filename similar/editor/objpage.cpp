@@ -23,6 +23,7 @@ COPYRIGHT 1993-1998 PARALLAX SOFTWARE CORPORATION.  ALL RIGHTS RESERVED.
  *
  */
 
+#include <map>
 #include <memory>
 #include <stdlib.h>
 #include <stdio.h>
@@ -116,38 +117,140 @@ void draw_object_picture(grs_canvas &canvas, const unsigned id, const vms_angvec
 
 }
 
+#if DXX_USE_OGL
+//	OpenGL draws straight to the framebuffer, so there is no picture to keep.
+static bool gr_label_box(int i, bool = true)
+{
+	gr_clear_canvas(*grd_curcanv, BM_XRGB(0,0,0));
+	draw_object_picture(*grd_curcanv, i, objpage_view_orient, Cur_object_type);
+	return true;
+}
+#else
+namespace {
+
+//	What the picture of an object is drawn from, so that a kept picture is not
+//	reused after the game data is reloaded.
+struct object_picture_source
+{
+	const ubyte *model_data;
+	unsigned bitmap;
+	bool operator==(const object_picture_source &r) const
+	{
+		return model_data == r.model_data && bitmap == r.bitmap;
+	}
+};
+
+struct object_thumbnail
+{
+	object_picture_source source;
+	vms_angvec orient;
+	grs_canvas_ptr canvas;
+};
+
+}
+
+//	Pictures of the objects already drawn, by type and id.  Redrawing the editor
+//	copies these instead of rendering each polygon model again.
+static std::map<std::pair<unsigned, unsigned>, object_thumbnail> Object_thumbnails;
+static palette_array_t Object_thumbnail_palette;
+
+static object_picture_source get_object_picture_source(const unsigned id, const unsigned type)
+{
+	auto &Polygon_models = LevelSharedPolygonModelState.Polygon_models;
+	const auto model = [&Polygon_models](const unsigned mn) {
+		return object_picture_source{Polygon_models[mn].model_data.get(), mn};
+	};
+	auto &Robot_info = LevelSharedRobotInfoState.Robot_info;
+	switch (type) {
+		case OBJ_HOSTAGE:
+			return {nullptr, Vclip[Hostage_vclip_num[id]].frames[0].index};
+		case OBJ_POWERUP:
+			if (Powerup_info[id].vclip_num > -1)
+				return {nullptr, Vclip[Powerup_info[id].vclip_num].frames[0].index};
+			break;
+		case OBJ_PLAYER:
+			return model(Player_ship->model_num);
+		case OBJ_ROBOT:
+			return model(Robot_info[id].model_num);
+		case OBJ_CNTRLCEN:
+			return model(get_reactor_model_number(id));
+		case OBJ_CLUTTER:
+			return model(id);
+	}
+	return {nullptr, 0};
+}
+
+//	Draw object i of Cur_object_type from its kept picture.  If there is no up to date
+//	picture, render one only if render_now is set, else leave the box blank for a later
+//	redraw to fill.  Return whether a picture was rendered.
+static bool gr_label_box(const unsigned i, const bool render_now = true)
+{
+	grs_canvas &cc = *grd_curcanv;
+	if (!(Object_thumbnail_palette == gr_palette))
+	{
+		Object_thumbnails.clear();
+		Object_thumbnail_palette = gr_palette;
+	}
+	auto &t = Object_thumbnails[{Cur_object_type, i}];
+	const auto &&source = get_object_picture_source(i, Cur_object_type);
+	const auto w = cc.cv_bitmap.bm_w, h = cc.cv_bitmap.bm_h;
+	const bool current = t.canvas && t.source == source &&
+		t.orient.p == objpage_view_orient.p && t.orient.b == objpage_view_orient.b && t.orient.h == objpage_view_orient.h &&
+		t.canvas->cv_bitmap.bm_w == w && t.canvas->cv_bitmap.bm_h == h;
+	bool rendered = false;
+	if (!current)
+	{
+		if (!render_now)
+		{
+			gr_clear_canvas(cc, BM_XRGB(0,0,0));
+			return false;
+		}
+		if (!t.canvas || t.canvas->cv_bitmap.bm_w != w || t.canvas->cv_bitmap.bm_h != h)
+			t.canvas = gr_create_canvas(w, h);
+		gr_set_current_canvas(*t.canvas);
+		gr_clear_canvas(*grd_curcanv, BM_XRGB(0,0,0));
+		draw_object_picture(*grd_curcanv, i, objpage_view_orient, Cur_object_type);
+		gr_set_current_canvas(cc);
+		t.source = source;
+		t.orient = objpage_view_orient;
+		rendered = true;
+	}
+	gr_ubitmap(cc, t.canvas->cv_bitmap);
+	return rendered;
+}
+#endif
+
 static int redraw_current_object()
 {
 	grs_canvas &cc = *grd_curcanv;
 	gr_set_current_canvas(ObjCurrent->canvas);
-	draw_object_picture(*grd_curcanv, Cur_object_id, objpage_view_orient, Cur_object_type);
+	gr_label_box(Cur_object_id);
 	gr_set_current_canvas(cc);
 	return 1;
 }
 
-static void gr_label_box( int i)
+//	Redraw the boxes of the object page, based on ObjectPage.  Pictures which are not
+//	kept yet are rendered at most one per call, so that turning a page stays responsive
+//	and the rest of the page fills in over the next few frames.
+static void objpage_redraw()
 {
-	gr_clear_canvas(*grd_curcanv, BM_XRGB(0,0,0));
-	draw_object_picture(*grd_curcanv, i, objpage_view_orient, Cur_object_type);
-
-//	char s[20];
-//	sprintf( s, " %d ", i );
-//	gr_clear_canvas( BM_XRGB(0,15,0) );
-//	gr_set_fontcolor( CWHITE, BM_XRGB(0,15,0) );
-//	ui_string_centered(  grd_curcanv->cv_bitmap.bm_w/2, grd_curcanv->cv_bitmap.bm_h/2, Description[i] );
+	bool rendered = false;
+	for (unsigned i = 0; i < OBJS_PER_PAGE; i++)
+	{
+		gr_set_current_canvas(ObjBox[i]->canvas);
+		if (i + ObjectPage*OBJS_PER_PAGE < Num_object_subtypes)
+		{
+			if (gr_label_box(i + ObjectPage*OBJS_PER_PAGE, !rendered))
+				rendered = true;
+		} else
+			gr_clear_canvas(*grd_curcanv, CGREY);
+	}
 }
 
 int objpage_goto_first()
 {
 	ObjectPage=0;
-	for (int i=0;  i<OBJS_PER_PAGE; i++ ) {
-		gr_set_current_canvas(ObjBox[i]->canvas);
-		if (i+ObjectPage*OBJS_PER_PAGE < Num_object_subtypes ) {
-			//gr_ubitmap(0,0, robot_bms[robot_bm_nums[ i+ObjectPage*OBJS_PER_PAGE ] ] );
-			gr_label_box(i+ObjectPage*OBJS_PER_PAGE );
-		} else
-			gr_clear_canvas(*grd_curcanv, CGREY);
-	}
+	objpage_redraw();
 
 	return 1;
 }
@@ -155,17 +258,7 @@ int objpage_goto_first()
 static int objpage_goto_last()
 {
 	ObjectPage=(Num_object_subtypes)/OBJS_PER_PAGE;
-	for (int i=0;  i<OBJS_PER_PAGE; i++ )
-	{
-		gr_set_current_canvas(ObjBox[i]->canvas);
-		if (i+ObjectPage*OBJS_PER_PAGE < Num_object_subtypes )
-		{
-			//gr_ubitmap(0,0, robot_bms[robot_bm_nums[ i+ObjectPage*OBJS_PER_PAGE ] ] );
-			gr_label_box(i+ObjectPage*OBJS_PER_PAGE );
-		} else {
-			gr_clear_canvas(*grd_curcanv, CGREY);
-		}
-	}
+	objpage_redraw();
 	return 1;
 }
 
@@ -173,17 +266,7 @@ static int objpage_goto_prev()
 {
 	if (ObjectPage > 0) {
 		ObjectPage--;
-		for (int i=0;  i<OBJS_PER_PAGE; i++ )
-		{
-			gr_set_current_canvas(ObjBox[i]->canvas);
-			if (i+ObjectPage*OBJS_PER_PAGE < Num_object_subtypes)
-			{
-				//gr_ubitmap(0,0, robot_bms[robot_bm_nums[ i+ObjectPage*OBJS_PER_PAGE ] ] );
-				gr_label_box(i+ObjectPage*OBJS_PER_PAGE );
-			} else {
-				gr_clear_canvas(*grd_curcanv, CGREY);
-			}
-		}
+		objpage_redraw();
 	}
 	return 1;
 }
@@ -192,17 +275,7 @@ static int objpage_goto_next()
 {
 	if ((ObjectPage+1)*OBJS_PER_PAGE < Num_object_subtypes) {
 		ObjectPage++;
-		for (int i=0;  i<OBJS_PER_PAGE; i++ )
-		{
-			gr_set_current_canvas(ObjBox[i]->canvas);
-			if (i+ObjectPage*OBJS_PER_PAGE < Num_object_subtypes)
-			{
-				//gr_ubitmap(0,0, robot_bms[robot_bm_nums[ i+ObjectPage*OBJS_PER_PAGE ] ] );
-				gr_label_box(i+ObjectPage*OBJS_PER_PAGE );
-			} else {
-				gr_clear_canvas(*grd_curcanv, CGREY);
-			}
-		}
+		objpage_redraw();
 	}
 	return 1;
 }
@@ -214,17 +287,7 @@ int objpage_grab_current(int n)
 	ObjectPage = n / OBJS_PER_PAGE;
 	
 	if (ObjectPage*OBJS_PER_PAGE < Num_object_subtypes) {
-		for (int i=0;  i<OBJS_PER_PAGE; i++ )
-		{
-			gr_set_current_canvas(ObjBox[i]->canvas);
-			if (i + ObjectPage*OBJS_PER_PAGE < Num_object_subtypes)
-			{
-				//gr_ubitmap(0,0, robot_bms[robot_bm_nums[ i+ObjectPage*OBJS_PER_PAGE ] ] );
-				gr_label_box(i+ObjectPage*OBJS_PER_PAGE );
-			} else {
-				gr_clear_canvas(*grd_curcanv, CGREY);
-			}
-		}
+		objpage_redraw();
 	}
 
 	Cur_object_id = n;
@@ -354,6 +417,9 @@ void objpage_init( UI_DIALOG *dlg )
 void objpage_close()
 {
 	//gr_free_sub_canvas(ObjnameCanvas);
+#if !DXX_USE_OGL
+	Object_thumbnails.clear();
+#endif
 }
 
 
@@ -363,17 +429,7 @@ int objpage_do(const d_event &event)
 {
 	if (event.type == EVENT_UI_DIALOG_DRAW)
 	{
-		for (int i=0;  i<OBJS_PER_PAGE; i++ )
-		{
-			gr_set_current_canvas(ObjBox[i]->canvas);
-			if (i+ObjectPage*OBJS_PER_PAGE < Num_object_subtypes)
-			{
-				//gr_ubitmap(0,0, robot_bms[robot_bm_nums[ i+ObjectPage*OBJS_PER_PAGE ] ] );
-				gr_label_box(i+ObjectPage*OBJS_PER_PAGE );
-			} else {
-				gr_clear_canvas(*grd_curcanv, CGREY);
-			}
-		}
+		objpage_redraw();
 		
 		// Don't reset robot_type when we return to editor.
 		//	Cur_robot_type = ObjectPage*OBJS_PER_PAGE;
@@ -27,6 +27,10 @@ COPYRIGHT 1993-1998 PARALLAX SOFTWARE CORPORATION.  ALL RIGHTS RESERVED.
 #include <stdlib.h>
 #include <math.h>
 #include <string.h>
+#include <algorithm>
+#include <memory>
+#include <unordered_map>
+#include <vector>
 #include "key.h"
 #include "gr.h"
 #include "inferno.h"
@@ -49,6 +53,7 @@ COPYRIGHT 1993-1998 PARALLAX SOFTWARE CORPORATION.  ALL RIGHTS RESERVED.
 #include "medwall.h"
 #include "hostage.h"
 
+#include "compiler-make_unique.h"
 #include "compiler-range_for.h"
 #include "partial_range.h"
 #include "segiter.h"
@@ -105,6 +110,183 @@ static int vnear(const vms_vector &vp1, const vms_vector &vp2)
 	return fnear(vp1.x, vp2.x) && fnear(vp1.y, vp2.y) && fnear(vp1.z, vp2.z);
 }
 
+namespace dsx {
+
+namespace {
+
+// A cube of space 1 << shift units on a side.  Points closer than that
+// on every axis are in the same or neighbouring cells.
+struct spatial_cell
+{
+	int32_t x, y, z;
+	bool operator==(const spatial_cell &r) const
+	{
+		return x == r.x && y == r.y && z == r.z;
+	}
+};
+
+struct spatial_cell_hash
+{
+	std::size_t operator()(const spatial_cell &c) const
+	{
+		return (static_cast<uint32_t>(c.x) * 73856093u) ^ (static_cast<uint32_t>(c.y) * 19349663u) ^ (static_cast<uint32_t>(c.z) * 83492791u);
+	}
+};
+
+template <typename T>
+using spatial_hash = std::unordered_map<spatial_cell, std::vector<T>, spatial_cell_hash>;
+
+static spatial_cell get_spatial_cell(const vms_vector &v, const unsigned shift)
+{
+	return {v.x >> shift, v.y >> shift, v.z >> shift};
+}
+
+// Call f for every entry in the cells within reach cells of c.
+template <typename T, typename F>
+static void for_each_near_cell(const spatial_hash<T> &h, const spatial_cell &c, const int32_t reach, F &&f)
+{
+	for (int32_t x = c.x - reach; x <= c.x + reach; ++x)
+		for (int32_t y = c.y - reach; y <= c.y + reach; ++y)
+			for (int32_t z = c.z - reach; z <= c.z + reach; ++z)
+			{
+				const auto i = h.find({x, y, z});
+				if (i != h.end())
+					range_for (auto &e, i->second)
+						f(e);
+			}
+}
+
+// Vertices which vnear considers the same are in neighbouring cells.
+constexpr unsigned weld_cell_shift = 4;
+static_assert(FIX_EPSILON < (1 << weld_cell_shift), "welding cells must be larger than FIX_EPSILON");
+
+// Open sides are bucketed by their centers in cells of 16 units, near
+// the thresholds the sloppy joint commands search.
+constexpr unsigned side_cell_shift = 20;
+
+struct indexed_side
+{
+	segnum_t segnum;
+	uint8_t sidenum;
+	vms_vector center;
+};
+
+// Which live segments use each vertex, and where the center of every
+// open side is.  Anything that changes the vertices or children of a
+// segment while the index exists must update() that segment.
+class segment_spatial_index
+{
+	struct indexed_segment
+	{
+		bool live;
+		uint8_t open_sides;
+		array<unsigned, MAX_VERTICES_PER_SEGMENT> verts;
+		array<spatial_cell, MAX_SIDES_PER_SEGMENT> cells;
+	};
+	std::vector<std::vector<segnum_t>> vertex_segments;
+	std::vector<indexed_segment> segments;
+	spatial_hash<indexed_side> sides;
+	void insert(vcsegptridx_t segp);
+	void erase(segnum_t segnum);
+public:
+	segment_spatial_index();
+	void update(const vcsegptridx_t segp)
+	{
+		erase(segp);
+		insert(segp);
+	}
+	// Live segments which use vertex v, lowest segment number first.
+	const std::vector<segnum_t> &segments_using(const unsigned v) const
+	{
+		return vertex_segments[v];
+	}
+	// Call f for every open side whose center may be within reach of p.
+	template <typename F>
+	void for_each_open_side_near(const vms_vector &p, const fix reach, F &&f) const
+	{
+		for_each_near_cell(sides, get_spatial_cell(p, side_cell_shift), (reach >> side_cell_shift) + 1, f);
+	}
+};
+
+segment_spatial_index::segment_spatial_index() :
+	vertex_segments(MAX_VERTICES), segments(MAX_SEGMENTS)
+{
+	range_for (const auto &&segp, vcsegptridx)
+		insert(segp);
+}
+
+void segment_spatial_index::insert(const vcsegptridx_t segp)
+{
+	auto &s = segments[segp];
+	s.live = segp->segnum != segment_none;
+	s.open_sides = 0;
+	if (!s.live)
+		return;
+	s.verts = segp->verts;
+	range_for (const auto v, s.verts)
+	{
+		auto &l = vertex_segments[v];
+		const auto i = std::lower_bound(l.begin(), l.end(), segp);
+		if (i == l.end() || *i != segp)
+			l.insert(i, segp);
+	}
+	auto &vcvertptr = LevelSharedVertexState.get_vertices().vcptr;
+	for (unsigned sidenum = 0; sidenum != MAX_SIDES_PER_SEGMENT; ++sidenum)
+		if (!IS_CHILD(segp->children[sidenum]))
+		{
+			const auto &&center = compute_center_point_on_side(vcvertptr, segp, sidenum);
+			const auto cell = get_spatial_cell(center, side_cell_shift);
+			s.cells[sidenum] = cell;
+			s.open_sides |= 1 << sidenum;
+			sides[cell].push_back({segp, static_cast<uint8_t>(sidenum), center});
+		}
+}
+
+void segment_spatial_index::erase(const segnum_t segnum)
+{
+	auto &s = segments[segnum];
+	if (!s.live)
+		return;
+	s.live = false;
+	range_for (const auto v, s.verts)
+	{
+		auto &l = vertex_segments[v];
+		const auto i = std::lower_bound(l.begin(), l.end(), segnum);
+		if (i != l.end() && *i == segnum)
+			l.erase(i);
+	}
+	for (unsigned sidenum = 0; sidenum != MAX_SIDES_PER_SEGMENT; ++sidenum)
+		if (s.open_sides & (1 << sidenum))
+		{
+			auto &l = sides[s.cells[sidenum]];
+			const auto i = std::find_if(l.begin(), l.end(), [segnum, sidenum](const indexed_side &t) {
+				return t.segnum == segnum && t.sidenum == sidenum;
+			});
+			if (i != l.end())
+				l.erase(i);
+		}
+	s.open_sides = 0;
+}
+
+static std::unique_ptr<segment_spatial_index> Segment_index;
+
+}
+
+med_segment_index_scope::med_segment_index_scope() :
+	owner(!Segment_index)
+{
+	if (owner)
+		Segment_index = make_unique<segment_spatial_index>();
+}
+
+med_segment_index_scope::~med_segment_index_scope()
+{
+	if (owner)
+		Segment_index.reset();
+}
+
+}
+
 // -------------------------------------------------------------------------------
 //	Add the vertex *vp to the global list of vertices, return its index.
 //	Search until a matching vertex is found (has nearly the same coordinates) or until Num_vertices
@@ -548,30 +730,54 @@ static void compress_segments(void)
 //	Combine duplicate vertices.
 //	If two vertices have the same coordinates, within some small tolerance, then assign
 //	the same vertex number to the two vertices, freeing up one of the vertices.
+//	Each vertex becomes the lowest numbered vertex near it, as if it had been compared
+//	with every vertex before it, but only vertices in neighbouring cells are compared.
 void med_combine_duplicate_vertices(array<uint8_t, MAX_VERTICES> &vlp)
 {
 	auto &Vertices = LevelSharedVertexState.get_vertices();
-	auto &vcvertptridx = Vertices.vcptridx;
-	const auto &&range = make_range(vcvertptridx);
-	// Note: ok to do to <, rather than <= because w for loop starts at v+1
-	if (range.m_begin == range.m_end)
+	auto &vcvertptr = Vertices.vcptr;
+	const unsigned count = Vertices.get_count();
+	std::vector<unsigned> remap(count);
+	spatial_hash<unsigned> cells;
+	bool changed = false;
+	for (unsigned v = 0; v != count; ++v)
+	{
+		auto &r = remap[v];
+		r = v;
+		if (!vlp[v])
+			continue;
+		auto &vp = *vcvertptr(v);
+		const auto cell = get_spatial_cell(vp, weld_cell_shift);
+		for_each_near_cell(cells, cell, 1, [&](const unsigned u) {
+			if (u < r && vnear(vp, *vcvertptr(u)))
+				r = u;
+		});
+		if (r != v)
+			changed = true;
+		cells[cell].push_back(v);
+	}
+	if (!changed)
 		return;
-	for (auto i = range.m_begin;;)
+
+	// Fix vertices in groups
+	range_for (auto &g, partial_range(GroupList, num_groups))
+		range_for (auto &v, g.vertices)
+			if (v < count)
+				v = remap[v];
+
+	range_for (const auto &&segp, vmsegptridx)
 	{
-		const auto &&v = *i;
-		if (++i == range.m_end)
-			return;
-		if (vlp[v]) {
-			auto &vvp = *v;
-			auto subrange = range;
-			subrange.m_begin = i;
-			range_for (auto &&w, subrange)
-				if (vlp[w]) {	//	used to be Vertex_active[w]
-					if (vnear(vvp, *w)) {
-						change_vertex_occurrences(v, w);
-					}
-				}
-		}
+		if (segp->segnum == segment_none)
+			continue;
+		bool segment_changed = false;
+		range_for (auto &v, segp->verts)
+			if (v < count && remap[v] != v)
+			{
+				v = remap[v];
+				segment_changed = true;
+			}
+		if (segment_changed && Segment_index)
+			Segment_index->update(segp);
 	}
 }
 
@@ -1110,22 +1316,39 @@ int med_form_joint(const vmsegptridx_t seg1, int side1, const vmsegptridx_t seg2
 	nv = 1;
 	validation_list[0] = seg2;
 
-	for (v=0; v<4; v++)
-		range_for (const auto &&segp, vmsegptridx)
+	const auto remap_segment = [&](const vmsegptridx_t segp) {
+		if (segp->segnum != segment_none)
+			range_for (auto &sv, segp->verts)
+				if (sv == lost_vertices[v]) {
+					sv = remap_vertices[v];
+					// Add segment to list of segments to be validated.
+					for (s1=0; s1<nv; s1++)
+						if (validation_list[s1] == segp)
+							break;
+					if (s1 == nv)
+						validation_list[nv++] = segp;
+					Assert(nv < MAX_VALIDATIONS);
+				}
+	};
+	if (Segment_index)
+	{
+		//	Only the segments which use a lost vertex can change.
+		std::vector<segnum_t> users;
+		range_for (const auto lv, lost_vertices)
 		{
-			if (segp->segnum != segment_none)
-				range_for (auto &sv, segp->verts)
-					if (sv == lost_vertices[v]) {
-						sv = remap_vertices[v];
-						// Add segment to list of segments to be validated.
-						for (s1=0; s1<nv; s1++)
-							if (validation_list[s1] == segp)
-								break;
-						if (s1 == nv)
-							validation_list[nv++] = segp;
-						Assert(nv < MAX_VALIDATIONS);
-					}
+			auto &l = Segment_index->segments_using(lv);
+			users.insert(users.end(), l.begin(), l.end());
 		}
+		std::sort(users.begin(), users.end());
+		users.erase(std::unique(users.begin(), users.end()), users.end());
+		for (v=0; v<4; v++)
+			range_for (const auto segnum, users)
+				remap_segment(seg1.absolute_sibling(segnum));
+	}
+	else
+		for (v=0; v<4; v++)
+			range_for (const auto &&segp, vmsegptridx)
+				remap_segment(segp);
 
 	//	Form new connections.
 	seg1->children[side1] = seg2;
@@ -1141,7 +1364,11 @@ int med_form_joint(const vmsegptridx_t seg1, int side1, const vmsegptridx_t seg2
 		validate_segment(vcvertptr, segp);
 		remap_side_uvs(segp, remap_vertices);	// remap uv coordinates on sides which were reshaped (ie, have a vertex in lost_vertices)
 		warn_if_concave_segment(segp);
+		if (Segment_index)
+			Segment_index->update(segp);
 	}
+	if (Segment_index)
+		Segment_index->update(seg1);
 
 	set_vertex_counts();
 
@@ -1424,23 +1651,105 @@ static int check_seg_concavity(const vcsegptr_t s)
 }
 
 
+namespace {
+
+//	What a segment's checks depend on: whether it is in use, its
+//	connections, and where its vertices are.  A segment whose vertices
+//	moved, or which gained or lost a connection, no longer matches.
+//	Neighbors sharing the moved vertices or the changed connection have
+//	entries of their own which no longer match either.
+struct segment_geometry
+{
+	segnum_t segnum;
+	array<segnum_t, MAX_SIDES_PER_SEGMENT> children;
+	array<vms_vector, MAX_VERTICES_PER_SEGMENT> positions;
+};
+
+//	The geometry of every segment as of the last check, so the next check
+//	can skip the segments which have not changed since.
+class segment_change_tracker
+{
+	std::vector<segment_geometry> state;
+public:
+	void clear()
+	{
+		state.clear();
+	}
+	//	Call f(segp) for each segment which changed since the last call,
+	//	or for every segment after clear().
+	template <typename F>
+		void for_each_changed(F &&f);
+};
+
+template <typename F>
+void segment_change_tracker::for_each_changed(F &&f)
+{
+	auto &Segments = LevelSharedSegmentState.get_segments();
+	auto &Vertices = LevelSharedVertexState.get_vertices();
+	auto &vcvertptr = Vertices.vcptr;
+	const bool all = state.empty();
+	if (all)
+		state.resize(Segments.size());
+	range_for (const auto &&segp, vmsegptridx)
+	{
+		auto &g = state[segp];
+		bool changed = all || g.segnum != segp->segnum || g.children != segp->children;
+		g.segnum = segp->segnum;
+		g.children = segp->children;
+		if (segp->segnum != segment_none)
+			for (unsigned i = 0; i != MAX_VERTICES_PER_SEGMENT; ++i)
+			{
+				auto &p = g.positions[i];
+				auto &v = *vcvertptr(segp->verts[i]);
+				if (p.x != v.x || p.y != v.y || p.z != v.z)
+				{
+					p = v;
+					changed = true;
+				}
+			}
+		if (changed)
+			f(segp);
+	}
+	//	Segments past the end were deleted.  Forget them so that they are
+	//	checked again if the slot is reused.
+	range_for (auto &g, partial_range(state, Segments.get_count(), state.size()))
+		g.segnum = segment_none;
+}
+
+segment_change_tracker Concave_segment_tracker, Validated_segment_tracker;
+array<uint8_t, MAX_SEGMENTS> Concave_segments;
+
+}
+
 // -----------------------------------------------------------------------------
-//	Find all concave segments and add to list
-void find_concave_segs()
+//	Like find_concave_segs, but only checks the segments which changed since
+//	the last check.
+static void find_changed_concave_segs()
 {
+	auto &Segments = LevelSharedSegmentState.get_segments();
+	Concave_segment_tracker.for_each_changed([](const vmsegptridx_t s) {
+		Concave_segments[s] = s->segnum != segment_none && check_seg_concavity(s);
+	});
 	Warning_segs.clear();
-
 	range_for (const auto &&s, vcsegptridx)
-		if (s->segnum != segment_none)
-			if (check_seg_concavity(s))
-				Warning_segs.emplace_back(s);
+		if (Concave_segments[s])
+			Warning_segs.emplace_back(s);
+	range_for (auto &c, partial_range(Concave_segments, Segments.get_count(), Concave_segments.size()))
+		c = 0;
 }
 
+// -----------------------------------------------------------------------------
+//	Find all concave segments and add to list
+void find_concave_segs()
+{
+	Concave_segment_tracker.clear();
+	find_changed_concave_segs();
+}
 
 // -----------------------------------------------------------------------------
 void warn_if_concave_segments(void)
 {
-	find_concave_segs();
+	find_changed_concave_segs();
 
 	if (!Warning_segs.empty())
 	{
@@ -1465,6 +1774,44 @@ void warn_if_concave_segment(const vmsegptridx_t s)
 }
 
 
+// -------------------------------------------------------------------------------
+//	Validate only the segments whose geometry changed since the last call.
+void validate_changed_segments()
+{
+	auto &Segments = LevelSharedSegmentState.get_segments();
+	auto &Vertices = LevelSharedVertexState.get_vertices();
+	auto &vcvertptr = Vertices.vcptr;
+	Validated_segment_tracker.for_each_changed([&vcvertptr](const vmsegptridx_t s) {
+		if (s->segnum != segment_none)
+			validate_segment(vcvertptr, s);
+	});
+	range_for (auto &s, partial_range(Segments, Segments.get_count(), Segments.size()))
+		s.segnum = segment_none;
+}
+
+// -------------------------------------------------------------------------------
+//	Return the side of segp which has the four vertices in abs_verts, or -1 if segp
+//	does not contain all four.
+static int find_side_with_vertices(const shared_segment &segp, const array<int, 4> &abs_verts)
+{
+	range_for (auto &v, abs_verts)
+		if (std::find(segp.verts.begin(), segp.verts.end(), v) == segp.verts.end())
+			return -1;	// This segment doesn't contain the vertex indexed by v
+
+	//	All four vertices in abs_verts are present in segp.
+	//	Determine side and return
+	for (int s=0; s<MAX_SIDES_PER_SEGMENT; s++) {
+		range_for (auto &v, Side_to_verts[s])
+			if (std::find(abs_verts.begin(), abs_verts.end(), segp.verts[v]) == abs_verts.end())
+				goto fass_next_side;	// Couldn't find vertex v in current side, so try next side.
+		// Found all four vertices in current side.  We are done!
+		return s;
+	fass_next_side: ;
+	}
+	Assert(0);	// Impossible -- we identified this segment as containing all 4 vertices of side "side", but we couldn't find them.
+	return -1;
+}
+
 // -------------------------------------------------------------------------------
 //	Find segment adjacent to sp:side.
 //	Adjacent means a segment which shares all four vertices.
@@ -1472,52 +1819,34 @@ void warn_if_concave_segment(const vmsegptridx_t s)
 //	Return false if unable to find, in which case adj_sp and adj_side are undefined.
 int med_find_adjacent_segment_side(const vmsegptridx_t sp, int side, imsegptridx_t &adj_sp, int *adj_side)
 {
-	int			s;
 	array<int, 4> abs_verts;
 
 	//	Stuff abs_verts[4] array with absolute vertex indices
 	for (unsigned v=0; v < 4; v++)
 		abs_verts[v] = sp->verts[Side_to_verts[side][v]];
 
-	//	Scan all segments, looking for a segment which contains the four abs_verts
-	range_for (const auto &&segp, vmsegptridx)
+	const auto try_segment = [&](const vmsegptridx_t segp) {
+		const auto s = find_side_with_vertices(segp, abs_verts);
+		if (s < 0)
+			return false;
+		adj_sp = segp;
+		*adj_side = s;
+		return true;
+	};
+	if (Segment_index)
 	{
-		if (segp != sp)
-		{
-			range_for (auto &v, abs_verts)
-			{												// do for each vertex in abs_verts
-				range_for (auto &vv, segp->verts) // do for each vertex in segment
-					if (v == vv)
-						goto fass_found1;											// Current vertex (indexed by v) is present in segment, try next
-				goto fass_next_seg;												// This segment doesn't contain the vertex indexed by v
-			fass_found1: ;
-			}		// end for v
-
-			//	All four vertices in sp:side are present in segment seg.
-			//	Determine side and return
-			for (s=0; s<MAX_SIDES_PER_SEGMENT; s++) {
-				range_for (auto &v, Side_to_verts[s])
-				{
-					range_for (auto &vv, abs_verts)
-					{
-						if (segp->verts[v] == vv)
-							goto fass_found2;
-					}
-					goto fass_next_side;											// Couldn't find vertex v in current side, so try next side.
-				fass_found2: ;
-				}
-				// Found all four vertices in current side.  We are done!
-				adj_sp = segp;
-				*adj_side = s;
+		//	Every segment which contains the four abs_verts uses the first one.
+		range_for (const auto segnum, Segment_index->segments_using(abs_verts[0]))
+			if (segnum != sp && try_segment(sp.absolute_sibling(segnum)))
 				return 1;
-			fass_next_side: ;
-			}
-			Assert(0);	// Impossible -- we identified this segment as containing all 4 vertices of side "side", but we couldn't find them.
-			return 0;
-		fass_next_seg: ;
-		}
+		return 0;
 	}
 
+	//	Scan all segments, looking for a segment which contains the four abs_verts
+	range_for (const auto &&segp, vmsegptridx)
+		if (segp != sp && try_segment(segp))
+			return 1;
+
 	return 0;
 }
 
@@ -1540,6 +1869,35 @@ int med_find_closest_threshold_segment_side(const vmsegptridx_t sp, int side, im
 	auto &vcvertptr = Vertices.vcptr;
 	const auto &&vsc = compute_center_point_on_side(vcvertptr, sp, side);
 
+	if (Segment_index)
+	{
+		//	Only sides within threshold can be chosen, so only those cells need to be searched.
+		//	Ties go to the lowest segment and side, as in the scan below.
+		bool found = false;
+		segnum_t closest_segnum = segment_none;
+		unsigned closest_sidenum = 0;
+		closest_seg_dist = threshold;
+		Segment_index->for_each_open_side_near(vsc, threshold, [&](const indexed_side &t) {
+			if (t.segnum == sp)
+				return;
+			current_dist = vm_vec_dist(vsc, t.center);
+			if (current_dist < closest_seg_dist ||
+				(found && current_dist == closest_seg_dist &&
+					(t.segnum < closest_segnum || (t.segnum == closest_segnum && t.sidenum < closest_sidenum))))
+			{
+				found = true;
+				closest_segnum = t.segnum;
+				closest_sidenum = t.sidenum;
+				closest_seg_dist = current_dist;
+			}
+		});
+		if (!found)
+			return 0;
+		adj_sp = sp.absolute_sibling(closest_segnum);
+		*adj_side = closest_sidenum;
+		return 1;
+	}
+
 	closest_seg_dist = JOINT_THRESHOLD;
 
 	//	Scan all segments, looking for a segment which contains the four abs_verts
@@ -28,6 +28,7 @@ COPYRIGHT 1993-1998 PARALLAX SOFTWARE CORPORATION.  ALL RIGHTS RESERVED.
 #include <stdarg.h>
 #include <math.h>
 #include <string.h>
+#include <vector>
 #include "inferno.h"
 #include "segment.h"
 #include "editor/editor.h"
@@ -41,11 +42,14 @@ COPYRIGHT 1993-1998 PARALLAX SOFTWARE CORPORATION.  ALL RIGHTS RESERVED.
 #include	"effects.h"     //      Needed for effects_bm_num
 #include "fvi.h"
 #include "seguvs.h"
+#include "event.h"
+#include "jobs.h"
+#include "key.h"
 
 #include "compiler-range_for.h"
 
 namespace dcx {
-static void cast_all_light_in_mine(int quick_flag);
+static bool cast_all_light_in_mine(int quick_flag);
 }
 //--rotate_uvs-- vms_vector Rightvec;
 
@@ -170,8 +174,13 @@ int set_average_light_on_curside(void)
 int set_average_light_on_all(void)
 {
 	Doing_lighting_hack_flag = 1;
-	cast_all_light_in_mine(0);
+	const auto cast = cast_all_light_in_mine(0);
 	Doing_lighting_hack_flag = 0;
+	if (!cast)
+	{
+		editor_status("Lighting cancelled.");
+		return 0;
+	}
 	Update_flags |= UF_WORLD_CHANGED;
 
 //	int seg, side;
@@ -185,7 +194,11 @@ int set_average_light_on_all(void)
 
 int set_average_light_on_all_quick(void)
 {
-	cast_all_light_in_mine(1);
+	if (!cast_all_light_in_mine(1))
+	{
+		editor_status("Lighting cancelled.");
+		return 0;
+	}
 	Update_flags |= UF_WORLD_CHANGED;
 
 	return 0;
@@ -865,10 +878,51 @@ struct hash_info {
 #define	FVI_HASH_SIZE 8
 #define	FVI_HASH_AND_MASK (FVI_HASH_SIZE - 1)
 
-//	Note: This should be malloced.
-//			Also, the vector should not be 12 bytes, you should only care about some smaller portion of it.
-static array<hash_info, FVI_HASH_SIZE> fvi_cache;
-static int Hash_hits=0, Hash_retries=0, Hash_calcs=0;
+//	Destination segments lit by one batch of jobs.  Between batches, the
+//	editor shows progress and checks for a cancel.
+#define	CALIM_BATCH_SIZE	64
+
+namespace {
+
+//	A side which emits light, with the points it casts from.  These only
+//	depend on the light's own segment, so they are computed once instead of
+//	once per receiving segment.
+struct calim_light_source
+{
+	segnum_t segnum;
+	fix intensity;
+	vms_vector segment_center;
+	//	Used by cast_light_from_side: 1 unit from each corner toward the center.
+	array<vms_vector, 4> side_location;
+	//	Used by cast_light_from_side_to_center: 1/64 of the way from each corner to the center.
+	array<vms_vector, 4> center_location;
+};
+
+//	Light received by one segment.  Each job writes only its own segment's
+//	result; the mine is updated after every job has finished.
+struct calim_segment_light
+{
+	array<array<fix, 4>, MAX_SIDES_PER_SEGMENT> l;
+	fix static_light;
+};
+
+}
+
+static int calim_find_intersection(const vms_vector &p0, const segnum_t startseg, const vms_vector &p1)
+{
+	fvi_query fq;
+	fvi_info	hit_data;
+
+	fq.p0						= &p0;
+	fq.startseg				= startseg;
+	fq.p1						= &p1;
+	fq.rad					= 0;
+	fq.thisobjnum			= object_none;
+	fq.ignore_obj_list.first = nullptr;
+	fq.flags					= 0;
+
+	return find_vector_intersection(fq, hit_data);
+}
 
 //	-----------------------------------------------------------------------------------------
 //	Set light from a light source.
@@ -886,253 +940,138 @@ static int Hash_hits=0, Hash_retries=0, Hash_calcs=0;
 //	light surface itself, light will be properly cast on the light surface.  Otherwise, the
 //	vector V would be the null vector.
 //	If quick_light set, then don't use find_vector_intersection
-static void cast_light_from_side(const vmsegptridx_t segp, int light_side, fix light_intensity, int quick_light)
+//	This only lights rsegp, which the caller has already found to be within range of the light.
+static void cast_light_from_side(const calim_light_source &light, const vcsegptr_t rsegp, const vms_vector &r_segment_center, calim_segment_light &result, int quick_light)
 {
 	int			sidenum,vertnum;
 	auto &Vertices = LevelSharedVertexState.get_vertices();
 	auto &vcvertptr = Vertices.vcptr;
 	auto &Walls = LevelUniqueWallSubsystemState.Walls;
 	auto &vcwallptr = Walls.vcptr;
-	const auto segment_center = compute_segment_center(vcvertptr, segp);
 	//	Do for four lights, one just inside each corner of side containing light.
-	range_for (const auto lightnum, Side_to_verts[light_side])
+	range_for (auto &light_location, light.side_location)
 	{
-		// fix			inverse_segment_magnitude;
-
-		const auto light_vertex_num = segp->verts[lightnum];
-		auto light_location = *vcvertptr(light_vertex_num);
-
-	//	New way, 5/8/95: Move towards center irrespective of size of segment.
-		const auto vector_to_center = vm_vec_normalized_quick(vm_vec_sub(segment_center, light_location));
-	vm_vec_add2(light_location, vector_to_center);
-
-// -- Old way, before 5/8/95 --		// -- This way was kind of dumb.  In larger segments, you move LESS towards the center.
-// -- Old way, before 5/8/95 --		//    Main problem, though, is vertices don't illuminate themselves well in oblong segments because the dot product is small.
-// -- Old way, before 5/8/95 --		vm_vec_sub(&vector_to_center, &segment_center, &light_location);
-// -- Old way, before 5/8/95 --		inverse_segment_magnitude = fixdiv(F1_0/5, vm_vec_mag(&vector_to_center));
-// -- Old way, before 5/8/95 --		vm_vec_scale_add(&light_location, &light_location, &vector_to_center, inverse_segment_magnitude);
-
-		range_for (const auto &&rsegp, vmsegptr)
-		{
-			fix			dist_to_rseg;
-
-			range_for (auto &i, fvi_cache)
-				i.flag = 0;
+		array<hash_info, FVI_HASH_SIZE> fvi_cache{};
 
-			//	efficiency hack (I hope!), for faraway segments, don't check each point.
-			const auto r_segment_center = compute_segment_center(vcvertptr, rsegp);
-			dist_to_rseg = vm_vec_dist_quick(r_segment_center, segment_center);
-
-			if (dist_to_rseg <= LIGHT_DISTANCE_THRESHOLD) {
-				for (sidenum=0; sidenum<MAX_SIDES_PER_SEGMENT; sidenum++) {
-					if (WALL_IS_DOORWAY(GameBitmaps, Textures, vcwallptr, rsegp, rsegp, sidenum) != WID_NO_WALL)
-					{
-						auto &srside = rsegp->shared_segment::sides[sidenum];
-						auto &urside = rsegp->unique_segment::sides[sidenum];
-						auto &side_normalp = srside.normals[0];	//	kinda stupid? always use vector 0.
-
-						for (vertnum=0; vertnum<4; vertnum++) {
-							fix			distance_to_point, light_at_point, light_dot;
-
-							const auto abs_vertnum = rsegp->verts[Side_to_verts[sidenum][vertnum]];
-							vms_vector vert_location = *vcvertptr(abs_vertnum);
-							distance_to_point = vm_vec_dist_quick(vert_location, light_location);
-							const auto vector_to_light = vm_vec_normalized(vm_vec_sub(light_location, vert_location));
-
-							//	Hack: In oblong segments, it's possible to get a very small dot product
-							//	but the light source is very nearby (eg, illuminating light itself!).
-							light_dot = vm_vec_dot(vector_to_light, side_normalp);
-							if (distance_to_point < F1_0)
-								if (light_dot > 0)
-									light_dot = (light_dot + F1_0)/2;
-
-							if (light_dot > 0) {
-								light_at_point = fixdiv(fixmul(light_dot, light_dot), distance_to_point);
-								light_at_point = fixmul(light_at_point, Magical_light_constant);
-								if (light_at_point >= 0) {
-									fvi_info	hit_data;
-									int		hit_type;
-									fix		inverse_segment_magnitude;
-
-									const auto r_vector_to_center = vm_vec_sub(r_segment_center, vert_location);
-									inverse_segment_magnitude = fixdiv(F1_0/3, vm_vec_mag(r_vector_to_center));
-									const auto vert_location_1 = vm_vec_scale_add(vert_location, r_vector_to_center, inverse_segment_magnitude);
-									vert_location = vert_location_1;
-
-//if ((segp-Segments == 199) && (rsegp-Segments==199))
-//	Int3();
-// Seg0 = segp-Segments;
-// Seg1 = rsegp-Segments;
-									if (!quick_light) {
-										int hash_value = Side_to_verts[sidenum][vertnum];
-										hash_info	*hashp = &fvi_cache[hash_value];
-										while (1) {
-											if (hashp->flag) {
-												if ((hashp->vector.x == vector_to_light.x) && (hashp->vector.y == vector_to_light.y) && (hashp->vector.z == vector_to_light.z)) {
-													hit_type = hashp->hit_type;
-													Hash_hits++;
-													break;
-												} else {
-													Int3();	// How is this possible?  Should be no hits!
-													Hash_retries++;
-													hash_value = (hash_value+1) & FVI_HASH_AND_MASK;
-													hashp = &fvi_cache[hash_value];
-												}
-											} else {
-												fvi_query fq;
-
-												Hash_calcs++;
-												hashp->vector = vector_to_light;
-												hashp->flag = 1;
-
-												fq.p0						= &light_location;
-												fq.startseg				= segp;
-												fq.p1						= &vert_location;
-												fq.rad					= 0;
-												fq.thisobjnum			= object_none;
-												fq.ignore_obj_list.first = nullptr;
-												fq.flags					= 0;
-
-												hit_type = find_vector_intersection(fq, hit_data);
-												hashp->hit_type = hit_type;
-												break;
-											}
-										}
-									} else
-										hit_type = HIT_NONE;
-									switch (hit_type) {
-										case HIT_NONE:
-											light_at_point = fixmul(light_at_point, light_intensity);
-											urside.uvls[vertnum].l += light_at_point;
-											if (urside.uvls[vertnum].l > F1_0)
-												urside.uvls[vertnum].l = F1_0;
-											break;
-										case HIT_WALL:
-											break;
-										case HIT_OBJECT:
-											Int3();	// Hit object, should be ignoring objects!
-											break;
-										case HIT_BAD_P0:
-											Int3();	//	Ugh, this thing again, what happened, what does it mean?
+		for (sidenum=0; sidenum<MAX_SIDES_PER_SEGMENT; sidenum++) {
+			if (WALL_IS_DOORWAY(GameBitmaps, Textures, vcwallptr, rsegp, rsegp, sidenum) != WID_NO_WALL)
+			{
+				auto &srside = rsegp->shared_segment::sides[sidenum];
+				auto &side_normalp = srside.normals[0];	//	kinda stupid? always use vector 0.
+				auto &side_light = result.l[sidenum];
+
+				for (vertnum=0; vertnum<4; vertnum++) {
+					fix			distance_to_point, light_at_point, light_dot;
+
+					const auto abs_vertnum = rsegp->verts[Side_to_verts[sidenum][vertnum]];
+					vms_vector vert_location = *vcvertptr(abs_vertnum);
+					distance_to_point = vm_vec_dist_quick(vert_location, light_location);
+					const auto vector_to_light = vm_vec_normalized(vm_vec_sub(light_location, vert_location));
+
+					//	Hack: In oblong segments, it's possible to get a very small dot product
+					//	but the light source is very nearby (eg, illuminating light itself!).
+					light_dot = vm_vec_dot(vector_to_light, side_normalp);
+					if (distance_to_point < F1_0)
+						if (light_dot > 0)
+							light_dot = (light_dot + F1_0)/2;
+
+					if (light_dot > 0) {
+						light_at_point = fixdiv(fixmul(light_dot, light_dot), distance_to_point);
+						light_at_point = fixmul(light_at_point, Magical_light_constant);
+						if (light_at_point >= 0) {
+							int		hit_type;
+							fix		inverse_segment_magnitude;
+
+							const auto r_vector_to_center = vm_vec_sub(r_segment_center, vert_location);
+							inverse_segment_magnitude = fixdiv(F1_0/3, vm_vec_mag(r_vector_to_center));
+							const auto vert_location_1 = vm_vec_scale_add(vert_location, r_vector_to_center, inverse_segment_magnitude);
+							vert_location = vert_location_1;
+
+							if (!quick_light) {
+								int hash_value = Side_to_verts[sidenum][vertnum];
+								hash_info	*hashp = &fvi_cache[hash_value];
+								while (1) {
+									if (hashp->flag) {
+										if ((hashp->vector.x == vector_to_light.x) && (hashp->vector.y == vector_to_light.y) && (hashp->vector.z == vector_to_light.z)) {
+											hit_type = hashp->hit_type;
 											break;
+										} else {
+											hash_value = (hash_value+1) & FVI_HASH_AND_MASK;
+											hashp = &fvi_cache[hash_value];
+										}
+									} else {
+										hashp->vector = vector_to_light;
+										hashp->flag = 1;
+										hit_type = calim_find_intersection(light_location, light.segnum, vert_location);
+										hashp->hit_type = hit_type;
+										break;
 									}
-								}	//	end if (light_at_point...
-							}	// end if (light_dot >...
-						}	//	end for (vertnum=0...
-					}	//	end if (rsegp...
-				}	//	end for (sidenum=0...
-			}	//	end if (dist_to_rseg...
-
-		}	//	end for (segnum=0...
+								}
+							} else
+								hit_type = HIT_NONE;
+							//	HIT_OBJECT and HIT_BAD_P0 used to stop in the debugger
+							//	here.  That cannot be done from a worker thread, so
+							//	they are just treated like HIT_WALL.
+							if (hit_type == HIT_NONE) {
+								light_at_point = fixmul(light_at_point, light.intensity);
+								side_light[vertnum] += light_at_point;
+								if (side_light[vertnum] > F1_0)
+									side_light[vertnum] = F1_0;
+							}
+						}	//	end if (light_at_point...
+					}	// end if (light_dot >...
+				}	//	end for (vertnum=0...
+			}	//	end if (rsegp...
+		}	//	end for (sidenum=0...
 
 	}	//	end for (lightnum=0...
 }
 
 
-//	------------------------------------------------------------------------------------------
-//	Zero all lighting values.
-static void calim_zero_light_values(void)
-{
-	range_for (unique_segment &segp, vmsegptr)
-	{
-		range_for (auto &side, segp.sides)
-		{
-			range_for (auto &uvl, side.uvls)
-				uvl.l = F1_0/64;	// Put a tiny bit of light here.
-		}
-		segp.static_light = F1_0 / 64;
-	}
-}
-
-
 //	------------------------------------------------------------------------------------------
 //	Used in setting average light value in a segment, cast light from a side to the center
 //	of all segments.
-static void cast_light_from_side_to_center(const vmsegptridx_t segp, int light_side, fix light_intensity, int quick_light)
+//	This only lights rsegp, which the caller has already found to be within range of the light.
+static void cast_light_from_side_to_center(const calim_light_source &light, const vms_vector &r_segment_center, const fix dist_to_rseg, calim_segment_light &result, int quick_light)
 {
-	auto &Vertices = LevelSharedVertexState.get_vertices();
-	auto &vcvertptr = Vertices.vcptr;
-	const auto &&segment_center = compute_segment_center(vcvertptr, segp);
 	//	Do for four lights, one just inside each corner of side containing light.
-	range_for (const auto lightnum, Side_to_verts[light_side])
+	range_for (auto &light_location, light.center_location)
 	{
-		const auto light_vertex_num = segp->verts[lightnum];
-		auto &vert_light_location = *vcvertptr(light_vertex_num);
-		const auto vector_to_center = vm_vec_sub(segment_center, vert_light_location);
-		const auto light_location = vm_vec_scale_add(vert_light_location, vector_to_center, F1_0/64);
-
-		range_for (const auto &&rsegp, vmsegptr)
-		{
-			fix			dist_to_rseg;
-//if ((segp == &Segments[Bugseg]) && (rsegp == &Segments[Bugseg]))
-//	Int3();
-			const auto r_segment_center = compute_segment_center(vcvertptr, rsegp);
-			dist_to_rseg = vm_vec_dist_quick(r_segment_center, segment_center);
-
-			if (dist_to_rseg <= LIGHT_DISTANCE_THRESHOLD) {
-				fix	light_at_point;
-				if (dist_to_rseg > F1_0)
-					light_at_point = fixdiv(Magical_light_constant, dist_to_rseg);
-				else
-					light_at_point = Magical_light_constant;
-
-				if (light_at_point >= 0) {
-					int		hit_type;
-
-					if (!quick_light) {
-						fvi_query fq;
-						fvi_info	hit_data;
-
-						fq.p0						= &light_location;
-						fq.startseg				= segp;
-						fq.p1						= &r_segment_center;
-						fq.rad					= 0;
-						fq.thisobjnum			= object_none;
-						fq.ignore_obj_list.first = nullptr;
-						fq.flags					= 0;
-
-						hit_type = find_vector_intersection(fq, hit_data);
-					}
-					else
-						hit_type = HIT_NONE;
-
-					switch (hit_type) {
-						case HIT_NONE:
-							light_at_point = fixmul(light_at_point, light_intensity);
-							if (light_at_point >= F1_0)
-								light_at_point = F1_0-1;
-							rsegp->static_light += light_at_point;
-							if (segp->static_light < 0)	// if it went negative, saturate
-								segp->static_light = 0;
-							break;
-						case HIT_WALL:
-							break;
-						case HIT_OBJECT:
-							Int3();	// Hit object, should be ignoring objects!
-							break;
-						case HIT_BAD_P0:
-							Int3();	//	Ugh, this thing again, what happened, what does it mean?
-							break;
-					}
-				}	//	end if (light_at_point...
-			}	//	end if (dist_to_rseg...
-
-		}	//	end for (segnum=0...
+		fix	light_at_point;
+		if (dist_to_rseg > F1_0)
+			light_at_point = fixdiv(Magical_light_constant, dist_to_rseg);
+		else
+			light_at_point = Magical_light_constant;
+
+		if (light_at_point >= 0) {
+			const int hit_type = quick_light ? HIT_NONE : calim_find_intersection(light_location, light.segnum, r_segment_center);
+			if (hit_type == HIT_NONE) {
+				light_at_point = fixmul(light_at_point, light.intensity);
+				if (light_at_point >= F1_0)
+					light_at_point = F1_0-1;
+				result.static_light += light_at_point;
+				if (result.static_light < 0)	// if it went negative, saturate
+					result.static_light = 0;
+			}
+		}	//	end if (light_at_point...
 
 	}	//	end for (lightnum=0...
 
 }
 
 //	------------------------------------------------------------------------------------------
-//	Process all lights.
-static void calim_process_all_lights(int quick_light)
+//	Find all lights.
+static std::vector<calim_light_source> calim_find_all_lights()
 {
 	int	sidenum;
+	std::vector<calim_light_source> lights;
 
 	auto &TmapInfo = LevelUniqueTmapInfoState.TmapInfo;
 	auto &Walls = LevelUniqueWallSubsystemState.Walls;
 	auto &vcwallptr = Walls.vcptr;
-	range_for (const auto &&segp, vmsegptridx)
+	auto &Vertices = LevelSharedVertexState.get_vertices();
+	auto &vcvertptr = Vertices.vcptr;
+	range_for (const auto &&segp, vcsegptridx)
 	{
 		for (sidenum=0; sidenum<MAX_SIDES_PER_SEGMENT; sidenum++) {
 			if (WALL_IS_DOORWAY(GameBitmaps, Textures, vcwallptr, segp, segp, sidenum) != WID_NO_WALL)
@@ -1152,25 +1091,100 @@ static void calim_process_all_lights(int quick_light)
 //				}
 
 				if (light_intensity) {
-					light_intensity /= 4;			// casting light from four spots, so divide by 4.
-					cast_light_from_side(segp, sidenum, light_intensity, quick_light);
-					cast_light_from_side_to_center(segp, sidenum, light_intensity, quick_light);
+					lights.emplace_back();
+					auto &light = lights.back();
+					light.segnum = segp;
+					light.intensity = light_intensity / 4;			// casting light from four spots, so divide by 4.
+					light.segment_center = compute_segment_center(vcvertptr, segp);
+					for (unsigned corner = 0; corner != 4; ++corner)
+					{
+						auto &vert_light_location = *vcvertptr(segp->verts[Side_to_verts[sidenum][corner]]);
+	//	New way, 5/8/95: Move towards center irrespective of size of segment.
+						light.side_location[corner] = vm_vec_add(vert_light_location, vm_vec_normalized_quick(vm_vec_sub(light.segment_center, vert_light_location)));
+
+// -- Old way, before 5/8/95 --		// -- This way was kind of dumb.  In larger segments, you move LESS towards the center.
+// -- Old way, before 5/8/95 --		//    Main problem, though, is vertices don't illuminate themselves well in oblong segments because the dot product is small.
+// -- Old way, before 5/8/95 --		vm_vec_sub(&vector_to_center, &segment_center, &light_location);
+// -- Old way, before 5/8/95 --		inverse_segment_magnitude = fixdiv(F1_0/5, vm_vec_mag(&vector_to_center));
+// -- Old way, before 5/8/95 --		vm_vec_scale_add(&light_location, &light_location, &vector_to_center, inverse_segment_magnitude);
+
+						light.center_location[corner] = vm_vec_scale_add(vert_light_location, vm_vec_sub(light.segment_center, vert_light_location), F1_0/64);
+					}
 				}
 			}
 		}
 	}
+	return lights;
+}
+
+//	------------------------------------------------------------------------------------------
+//	Light one segment from every light in range.  Lights are applied in the
+//	order the single threaded caster used, so the result does not depend on
+//	how the segments are spread over the worker threads.
+static void calim_light_segment(const std::vector<calim_light_source> &lights, const vcsegptr_t rsegp, calim_segment_light &result, int quick_light)
+{
+	auto &Vertices = LevelSharedVertexState.get_vertices();
+	auto &vcvertptr = Vertices.vcptr;
+	range_for (auto &side_light, result.l)
+		side_light.fill(F1_0/64);	// Put a tiny bit of light here.
+	result.static_light = F1_0 / 64;
+	const auto r_segment_center = compute_segment_center(vcvertptr, rsegp);
+	range_for (auto &light, lights)
+	{
+		//	efficiency hack (I hope!), for faraway segments, don't check each point.
+		const fix dist_to_rseg = vm_vec_dist_quick(r_segment_center, light.segment_center);
+		if (dist_to_rseg > LIGHT_DISTANCE_THRESHOLD)
+			continue;
+		cast_light_from_side(light, rsegp, r_segment_center, result, quick_light);
+		cast_light_from_side_to_center(light, r_segment_center, dist_to_rseg, result, quick_light);
+	}
 }
 
 //	------------------------------------------------------------------------------------------
 //	Apply static light in mine.
-//	First, zero all light values.
-//	Then, for all light sources, cast their light.
-static void cast_all_light_in_mine(int quick_flag)
+//	First, find all light sources.
+//	Then, for all segments, cast the light they receive, spread over the
+//	worker threads.  The mine is only changed once every segment is done,
+//	so pressing Escape to cancel leaves the old lighting in place.
+//	Returns false if cancelled.
+static bool cast_all_light_in_mine(int quick_flag)
 {
-	validate_segment_all(LevelSharedSegmentState);
-	calim_zero_light_values();
+	validate_changed_segments();
+
+	const auto &&lights = calim_find_all_lights();
+	auto &Segments = LevelSharedSegmentState.get_segments();
+	const unsigned num_segments = Segments.get_count();
+	std::vector<calim_segment_light> results(num_segments);
+	for (unsigned first = 0; first < num_segments; first += CALIM_BATCH_SIZE)
+	{
+		editor_status_fmt("Casting light: %u of %u segments, %u lights.  Press Escape to cancel.", first, num_segments, static_cast<unsigned>(lights.size()));
+		editor_status_show();
+		if (key_escape_held())
+		{
+			event_flush();
+			key_flush();
+			return false;
+		}
+		const unsigned count = std::min<unsigned>(CALIM_BATCH_SIZE, num_segments - first);
+		job_pool_run(count, [&lights, &results, first, quick_flag](const unsigned index, unsigned) {
+			const unsigned segnum = first + index;
+			calim_light_segment(lights, vcsegptr(static_cast<segnum_t>(segnum)), results[segnum], quick_flag);
+		});
+	}
 
-	calim_process_all_lights(quick_flag);
+	auto r = results.begin();
+	range_for (unique_segment &segp, vmsegptr)
+	{
+		auto &result = *r++;
+		for (unsigned sidenum = 0; sidenum != MAX_SIDES_PER_SEGMENT; ++sidenum)
+		{
+			auto &uvls = segp.sides[sidenum].uvls;
+			for (unsigned vertnum = 0; vertnum != 4; ++vertnum)
+				uvls[vertnum].l = result.l[sidenum][vertnum];
+		}
+		segp.static_light = result.static_light;
+	}
+	return true;
 }
 
 }
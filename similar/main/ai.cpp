@@ -25,6 +25,7 @@ COPYRIGHT 1993-1999 PARALLAX SOFTWARE CORPORATION.  ALL RIGHTS RESERVED.
 
 #include <algorithm>
 #include <cstdlib>
+#include <vector>
 #include <stdio.h>
 #include <time.h>
 
@@ -68,6 +69,8 @@ COPYRIGHT 1993-1999 PARALLAX SOFTWARE CORPORATION.  ALL RIGHTS RESERVED.
 #include "fuelcen.h"
 #include "controls.h"
 #include "kconfig.h"
+#include "jobs.h"
+#include "gamesave.h"
 
 #if DXX_USE_EDITOR
 #include "editor/editor.h"
@@ -81,6 +84,7 @@ COPYRIGHT 1993-1999 PARALLAX SOFTWARE CORPORATION.  ALL RIGHTS RESERVED.
 
 #include "compiler-range_for.h"
 #include "segiter.h"
+#include "profile.h"
 #include "partial_range.h"
 
 using std::min;
@@ -477,6 +481,8 @@ static void boss_init_all_segments(const segment_array &Segments, const object &
 	auto &Boss_teleport_segs = LevelSharedBossState.Teleport_segs;
 	if (!Boss_teleport_segs.empty())
 		return;	// already have boss segs
+	if (level_cache_read_boss_segments(boss_objnum, LevelSharedBossState))
+		return;
 
 	init_boss_segments(Segments, boss_objnum, Boss_gate_segs, 0, 0);
 	
@@ -485,6 +491,7 @@ static void boss_init_all_segments(const segment_array &Segments, const object &
 	if (Boss_teleport_segs.size() < 2)
 		init_boss_segments(Segments, boss_objnum, Boss_teleport_segs, 1, 1);
 #endif
+	level_cache_write_boss_segments(boss_objnum, LevelSharedBossState);
 }
 
 // ---------------------------------------------------------------------------------------------------------------------
@@ -688,6 +695,121 @@ static void ai_turn_randomly(const vms_vector &vec_to_player, object_base &obj,
 //		Decreases wait between fire times by Overall_agitation/64 seconds.
 
 
+#if defined(DXX_BUILD_DESCENT_II)
+namespace {
+
+/* Rays from robots to the player, traced on the worker threads when the
+ * first robot of a frame checks visibility.  player_is_visible_from_object
+ * only uses a result if the ray it would trace is exactly the one which
+ * was traced here and no wall has changed since, so robots still see
+ * what they would have seen tracing the ray themselves, in object order.
+ */
+struct ai_visibility_query
+{
+	objnum_t objnum;
+	segnum_t startseg;
+	vms_vector p0;
+	int hit_type;
+	fvi_info hit_data;
+};
+
+struct ai_visibility_prefetch
+{
+	fix64 time = -1;
+	unsigned wall_generation;
+	vms_vector p1;
+	std::vector<ai_visibility_query> queries;
+};
+
+static ai_visibility_prefetch Ai_visibility;
+
+static bool same_position(const vms_vector &a, const vms_vector &b)
+{
+	return a.x == b.x && a.y == b.y && a.z == b.z;
+}
+
+static void prefetch_player_visibility()
+{
+	auto &v = Ai_visibility;
+	v.time = GameTime64;
+	v.wall_generation = fcd_cache_generation();
+	v.queries.clear();
+	if (job_pool_threads() < 2)
+		return;
+	/* Cloaked players are tracked through Ai_cloak_info, which moves as
+	 * robots look, so the ray cannot be known in advance.
+	 */
+	if (get_local_plrobj().ctype.player_info.powerup_flags & PLAYER_FLAGS_CLOAKED)
+		return;
+	if (cheats.robotskillrobots)
+		return;
+	v.p1 = ConsoleObject->pos;
+	const auto &&player_seg = vcsegptridx(ConsoleObject->segnum);
+	auto &Robot_info = LevelSharedRobotInfoState.Robot_info;
+	range_for (const auto &&objp, vcobjptridx)
+	{
+		if (objp->type != OBJ_ROBOT || objp->control_type != CT_AI)
+			continue;
+		auto &aip = objp->ctype.ai_info;
+		if (aip.SKIP_AI_COUNT || (aip.SUB_FLAGS & SUB_FLAGS_CAMERA_AWAKE))
+			continue;
+		/* player_is_visible_from_object rejects these without a ray. */
+		if (!render_pvs_may_see(vcsegptridx(objp->segnum), player_seg))
+			continue;
+		v.queries.push_back({objp, objp->segnum, objp->pos});
+		auto &robptr = Robot_info[get_robot_id(objp)];
+		if (robptr.n_guns && !robptr.attack_type && vm_vec_dist_quick(v.p1, objp->pos) < F1_0*200)
+		{
+			v.queries.push_back({objp, objp->segnum});
+			calc_gun_point(v.queries.back().p0, objp, aip.CURRENT_GUN);
+		}
+	}
+	job_pool_run(v.queries.size(), [&v](const unsigned i, unsigned) {
+		auto &q = v.queries[i];
+		auto &Segments = LevelSharedSegmentState.get_segments();
+		const auto &&objp = vcobjptr(q.objnum);
+		if (!same_position(q.p0, objp->pos))
+		{
+			const auto &&segnum = find_point_seg(LevelSharedSegmentState, q.p0, Segments.vcptridx(objp->segnum));
+			/* Leave rays from outside the mine for the serial path,
+			 * which moves the robot.
+			 */
+			if (segnum == segment_none)
+			{
+				q.startseg = segment_none;
+				return;
+			}
+			q.startseg = segnum;
+		}
+		fvi_query fq;
+		fq.p0 = &q.p0;
+		fq.startseg = q.startseg;
+		fq.p1 = &v.p1;
+		fq.rad = F1_0/4;
+		fq.thisobjnum = q.objnum;
+		fq.ignore_obj_list.first = nullptr;
+		fq.flags = FQ_TRANSWALL;
+		q.hit_type = find_vector_intersection(fq, q.hit_data);
+	});
+}
+
+static const ai_visibility_query *find_prefetched_visibility(const objnum_t objnum, const vms_vector &p0, const segnum_t startseg)
+{
+	auto &v = Ai_visibility;
+	if (v.time != GameTime64 || v.wall_generation != fcd_cache_generation() || !same_position(v.p1, Believed_player_pos))
+		return nullptr;
+	const auto e = v.queries.end();
+	for (auto i = std::lower_bound(v.queries.begin(), e, objnum, [](const ai_visibility_query &q, const objnum_t o) {
+		return q.objnum < o;
+	}); i != e && i->objnum == objnum; ++i)
+		if (same_position(i->p0, p0) && i->startseg == startseg)
+			return &*i;
+	return nullptr;
+}
+
+}
+#endif
+
 // --------------------------------------------------------------------------------------------------------------------
 //	Returns:
 //		0		Player is not visible from object, obstruction or something.
@@ -726,6 +848,16 @@ int player_is_visible_from_object(const vmobjptridx_t objp, vms_vector &pos, fix
 		}
 	} else
 		fq.startseg			= objp->segnum;
+	//	A player in a segment which cannot be seen from the start segment
+	//	is not visible, whatever walls are open.  Believed_player_pos may
+	//	be anywhere while the player is cloaked, so only use this for the
+	//	player's true position.
+	if (Believed_player_pos.x == ConsoleObject->pos.x && Believed_player_pos.y == ConsoleObject->pos.y && Believed_player_pos.z == ConsoleObject->pos.z &&
+		!render_pvs_may_see(vcsegptridx(fq.startseg), vcsegptridx(ConsoleObject->segnum)))
+	{
+		Hit_pos = pos;
+		return 0;
+	}
 	fq.p1						= &Believed_player_pos;
 	fq.rad					= F1_0/4;
 	fq.thisobjnum			= objp;
@@ -734,9 +866,16 @@ int player_is_visible_from_object(const vmobjptridx_t objp, vms_vector &pos, fix
 	fq.flags					= FQ_TRANSWALL | FQ_CHECK_OBJS;		//what about trans walls???
 #elif defined(DXX_BUILD_DESCENT_II)
 	fq.flags					= FQ_TRANSWALL; // -- Why were we checking objects? | FQ_CHECK_OBJS;		//what about trans walls???
+	if (Ai_visibility.time != GameTime64)
+		prefetch_player_visibility();
+	if (const auto q = find_prefetched_visibility(objp, pos, fq.startseg))
+	{
+		Hit_type = q->hit_type;
+		Hit_data = q->hit_data;
+	}
+	else
 #endif
-
-	Hit_type = find_vector_intersection(fq, Hit_data);
+		Hit_type = find_vector_intersection(fq, Hit_data);
 
 	Hit_pos = Hit_data.hit_pnt;
 
@@ -2055,7 +2194,6 @@ void create_buddy_bot(void)
 //	one_wall_hack added by MK, 10/13/95: A mega-hack!  Set to !0 to ignore the 
 static void init_boss_segments(const segment_array &segments, const object &boss_objp, d_level_shared_boss_state::special_segment_array_t &a, const int size_check, int one_wall_hack)
 {
-	constexpr unsigned QUEUE_SIZE = 256;
 	auto &vcsegptridx = segments.vcptridx;
 	auto &vmsegptr = segments.vmptr;
 #if defined(DXX_BUILD_DESCENT_I)
@@ -2070,33 +2208,22 @@ static void init_boss_segments(const segment_array &segments, const object &boss
 	auto &Vertices = LevelSharedVertexState.get_vertices();
 	auto &Walls = LevelUniqueWallSubsystemState.Walls;
 	auto &vcwallptr = Walls.vcptr;
+	const auto original_boss_seg = boss_objp.segnum;
+	/* List the segments in the order the search reaches them.  Where
+	 * the search goes does not depend on whether the boss fits, so the
+	 * fit tests can be run afterward, in parallel.  The starting segment
+	 * is not marked visited, so it can be listed a second time when the
+	 * search comes back to it.
+	 */
+	std::vector<segnum_t> reached;
+	reached.emplace_back(original_boss_seg);
 	{
-		int			head, tail;
-		array<segnum_t, QUEUE_SIZE> seg_queue;
-
-		const auto original_boss_seg = boss_objp.segnum;
-		head = 0;
-		tail = 0;
-		seg_queue[head++] = original_boss_seg;
-		auto &vcvertptr = Vertices.vcptr;
-
-		if (!size_check || !boss_intersects_wall(vcvertptr, boss_objp, vcsegptridx(original_boss_seg)))
-		{
-			a.emplace_back(original_boss_seg);
-#if DXX_USE_EDITOR
-			Selected_segs.emplace_back(original_boss_seg);
-#endif
-		}
-
 		visited_segment_bitarray_t visited;
-
-		while (tail != head) {
-			int		sidenum;
-			auto &segp = *vmsegptr(seg_queue[tail++]);
-
-			tail &= QUEUE_SIZE-1;
-
-			for (sidenum=0; sidenum<MAX_SIDES_PER_SEGMENT; sidenum++) {
+		for (std::size_t tail = 0; tail != reached.size(); ++tail)
+		{
+			auto &segp = *vmsegptr(reached[tail]);
+			for (unsigned sidenum = 0; sidenum != MAX_SIDES_PER_SEGMENT; ++sidenum)
+			{
 				const auto w = WALL_IS_DOORWAY(GameBitmaps, Textures, vcwallptr, segp, segp, sidenum);
 				if ((w & WID_FLY_FLAG) || one_wall_hack)
 				{
@@ -2116,35 +2243,39 @@ static void init_boss_segments(const segment_array &segments, const object &boss
 					else
 					{
 						v = true;
-						seg_queue[head++] = csegnum;
-						head &= QUEUE_SIZE-1;
-						if (head > tail) {
-							if (head == tail + QUEUE_SIZE-1)
-								Int3();	//	queue overflow.  Make it bigger!
-						} else
-							if (head+QUEUE_SIZE == tail + QUEUE_SIZE-1)
-								Int3();	//	queue overflow.  Make it bigger!
-	
-						if (!size_check || !boss_intersects_wall(vcvertptr, boss_objp, vcsegptridx(csegnum))) {
-							a.emplace_back(csegnum);
-#if DXX_USE_EDITOR
-							Selected_segs.emplace_back(csegnum);
-							#endif
-							if (a.size() >= a.max_size())
-							{
-								tail = head;
-								sidenum=MAX_SIDES_PER_SEGMENT;
-								break;
-							}
-						}
+						reached.emplace_back(csegnum);
 					}
 				}
 			}
 		}
-		// Last resort - add original seg even if boss doesn't fit in it
-		if (a.empty())
-			a.emplace_back(original_boss_seg);
 	}
+
+	//	Test a batch at a time, since the list is usually full long
+	//	before the end of a large mine.
+	constexpr std::size_t batch_size = 128;
+	array<uint8_t, batch_size> fits;
+	auto &vcvertptr = Vertices.vcptr;
+	for (std::size_t first = 0, n; first != reached.size() && a.size() < a.max_size(); first += n)
+	{
+		n = std::min(batch_size, reached.size() - first);
+		if (size_check)
+			job_pool_run(n, [&](const unsigned i, unsigned) {
+				fits[i] = !boss_intersects_wall(vcvertptr, boss_objp, vcsegptridx(reached[first + i]));
+			});
+		for (std::size_t i = 0; i != n && a.size() < a.max_size(); ++i)
+		{
+			if (size_check && !fits[i])
+				continue;
+			const auto segnum = reached[first + i];
+			a.emplace_back(segnum);
+#if DXX_USE_EDITOR
+			Selected_segs.emplace_back(segnum);
+#endif
+		}
+	}
+	// Last resort - add original seg even if boss doesn't fit in it
+	if (a.empty())
+		a.emplace_back(original_boss_seg);
 }
 
 // --------------------------------------------------------------------------------------------------------------------
@@ -2943,9 +3074,120 @@ static bool skip_ai_for_time_splice(const vcobjptridx_t robot, const robot_info
 	return false;
 }
 
+namespace {
+
+/* -ai_lod: robots within CGameArg.SysAiLodDepth segments of the player
+ * run every frame, robots within twice that every 4th frame, and the
+ * rest every 16th frame.  A robot which is skipped keeps the time it
+ * missed and gets all of it as FrameTime when it next runs.
+ */
+struct ai_lod_skipped_time
+{
+	object_signature_t signature;
+	fix time;
+};
+
+struct ai_lod_state
+{
+	fix64 time = -1;
+	unsigned frame;
+	array<uint8_t, MAX_SEGMENTS> depth;
+	array<segnum_t, MAX_SEGMENTS> queue;
+	array<ai_lod_skipped_time, MAX_OBJECTS> skipped;
+};
+
+static ai_lod_state Ai_lod;
+
+static void ai_lod_build_depths(const vcsegidx_t start_seg, const unsigned max_depth)
+{
+	auto &l = Ai_lod;
+	std::fill_n(l.depth.begin(), Highest_segment_index + 1, UINT8_MAX);
+	unsigned head = 0, tail = 0;
+	l.queue[tail++] = start_seg;
+	l.depth[start_seg] = 0;
+	while (head != tail)
+	{
+		const auto curseg = l.queue[head++];
+		const unsigned child_depth = l.depth[curseg] + 1;
+		if (child_depth > max_depth)
+			continue;
+		range_for (const auto childnum, vcsegptr(curseg)->children)
+			if (IS_CHILD(childnum) && l.depth[childnum] == UINT8_MAX)
+			{
+				l.depth[childnum] = child_depth;
+				l.queue[tail++] = childnum;
+			}
+	}
+}
+
+static bool ai_lod_skip(const vcobjptridx_t obj, const robot_info &robptr)
+{
+	const unsigned near_depth = CGameArg.SysAiLodDepth;
+	if (!near_depth || (Game_mode & GM_MULTI))
+		return false;
+	auto &l = Ai_lod;
+	if (l.time != GameTime64)
+	{
+		l.time = GameTime64;
+		++ l.frame;
+		ai_lod_build_depths(ConsoleObject->segnum, std::min(near_depth * 2u, UINT8_MAX - 1u));
+	}
+	auto &ailp = obj->ctype.ai_info.ail;
+	if (ailp.player_awareness_type != player_awareness_type_t::PA_NONE || ailp.previous_visibility || robptr.boss_flag || is_break_object(obj))
+		return false;
+#if defined(DXX_BUILD_DESCENT_II)
+	if (robot_is_companion(robptr) || robot_is_thief(robptr) || obj->ctype.ai_info.dying_start_time)
+		return false;
+#endif
+	const unsigned depth = l.depth[obj->segnum];
+	if (depth <= near_depth)
+		return false;
+	const unsigned interval = depth <= near_depth * 2 ? 4 : 16;
+	if (!((l.frame + obj.get_unchecked_index()) % interval))
+		return false;
+	auto &s = l.skipped[obj];
+	if (s.signature != obj->signature)
+	{
+		s.signature = obj->signature;
+		s.time = 0;
+	}
+	s.time += FrameTime;
+	return true;
+}
+
+/* Run do_ai_frame with the time a robot missed while -ai_lod skipped it
+ * added to FrameTime.
+ */
+class ai_lod_frame_time
+{
+	const fix saved_frame_time;
+public:
+	ai_lod_frame_time(const vcobjptridx_t obj) :
+		saved_frame_time(FrameTime)
+	{
+		auto &s = Ai_lod.skipped[obj];
+		if (s.signature == obj->signature && s.time)
+		{
+			FrameTime += s.time;
+			s.time = 0;
+		}
+	}
+	~ai_lod_frame_time()
+	{
+		FrameTime = saved_frame_time;
+	}
+};
+
+}
+
 // --------------------------------------------------------------------------------------------------------------------
 void do_ai_frame(const vmobjptridx_t obj)
 {
+	auto &Robot_info = LevelSharedRobotInfoState.Robot_info;
+	if (ai_lod_skip(obj, Robot_info[get_robot_id(obj)]))
+		return;
+	DXX_TRACE_ZONE("do_ai_frame");
+	const ai_lod_frame_time lod_frame_time(obj);
 	const objnum_t &objnum = obj;
 	ai_static	*aip = &obj->ctype.ai_info;
 	ai_local &ailp = obj->ctype.ai_info.ail;
@@ -2977,7 +3219,6 @@ void do_ai_frame(const vmobjptridx_t obj)
 		return;
 	}
 
-	auto &Robot_info = LevelSharedRobotInfoState.Robot_info;
 #if defined(DXX_BUILD_DESCENT_II)
 	auto &Station = LevelUniqueFuelcenterState.Station;
 #endif
@@ -4226,65 +4467,109 @@ struct awareness_t : array<player_awareness_type_t, MAX_SEGMENTS>
 }
 
 // ----------------------------------------------------------------------------------
-static void pae_aux(const vcsegptridx_t segnum, const player_awareness_type_t type, const int level, awareness_t &New_awareness)
+//	Every event raises the awareness of its own segment to its type, and
+//	of each segment within Awareness_event_depth connections to its type
+//	after one step, which lowers weapon-robot collisions to player
+//	collisions.  Each distinct stepped type gets one breadth-first search
+//	from all of its events together, so events in the same area do not
+//	walk it again.  The segments which were raised are listed in touched.
+static void process_awareness_events(fvcsegptridx &vcsegptridx, awareness_t &New_awareness, std::vector<segnum_t> &touched)
 {
-	if (New_awareness[segnum] < type)
-		New_awareness[segnum] = type;
-
-	// Process children.
+	if (!(Game_mode & GM_MULTI) || (Game_mode & GM_MULTI_ROBOTS))
+	{
 #if defined(DXX_BUILD_DESCENT_I)
-	if (level <= 4)
+		constexpr unsigned Awareness_event_depth = 4;
 #elif defined(DXX_BUILD_DESCENT_II)
-	if (level <= 3)
+		constexpr unsigned Awareness_event_depth = 3;
 #endif
-	{
-		const auto subtype = (type == player_awareness_type_t::PA_WEAPON_ROBOT_COLLISION)
-			? player_awareness_type_t::PA_PLAYER_COLLISION
-			: type;
-		const auto sublevel = level + 1;
-		range_for (auto &j, segnum->children)
-			if (IS_CHILD(j))
-				pae_aux(segnum.absolute_sibling(j), subtype, sublevel, New_awareness);
-	}
-}
-
-
-// ----------------------------------------------------------------------------------
-static void process_awareness_events(fvcsegptridx &vcsegptridx, awareness_t &New_awareness)
-{
-	if (!(Game_mode & GM_MULTI) || (Game_mode & GM_MULTI_ROBOTS))
-	{
-		New_awareness.fill(player_awareness_type_t::PA_NONE);
+		const auto &&raise = [&New_awareness, &touched](const segnum_t segnum, const player_awareness_type_t type) {
+			auto &a = New_awareness[segnum];
+			if (a < type)
+			{
+				if (a == player_awareness_type_t::PA_NONE)
+					touched.emplace_back(segnum);
+				a = type;
+			}
+		};
+		const auto &&step = [](const player_awareness_type_t type) {
+			return type == player_awareness_type_t::PA_WEAPON_ROBOT_COLLISION
+				? player_awareness_type_t::PA_PLAYER_COLLISION
+				: type;
+		};
 		range_for (auto &i, partial_const_range(Awareness_events, Num_awareness_events))
-			pae_aux(vcsegptridx(i.segnum), i.type, 1, New_awareness);
+			raise(i.segnum, i.type);
+		std::vector<segnum_t> queue;
+		for (auto level = static_cast<unsigned>(player_awareness_type_t::PA_PLAYER_COLLISION); level; --level)
+		{
+			const auto type = static_cast<player_awareness_type_t>(level);
+			visited_segment_bitarray_t visited;
+			queue.clear();
+			range_for (auto &i, partial_const_range(Awareness_events, Num_awareness_events))
+			{
+				if (step(i.type) != type)
+					continue;
+				auto &&v = visited[i.segnum];
+				if (v)
+					continue;
+				v = true;
+				queue.emplace_back(i.segnum);
+			}
+			std::size_t head = 0;
+			for (unsigned depth = 0; depth != Awareness_event_depth && head != queue.size(); ++depth)
+			{
+				for (const auto tail = queue.size(); head != tail; ++head)
+				{
+					range_for (const auto j, vcsegptridx(queue[head])->children)
+					{
+						if (!IS_CHILD(j))
+							continue;
+						auto &&v = visited[j];
+						if (v)
+							continue;
+						v = true;
+						queue.emplace_back(j);
+						raise(j, type);
+					}
+				}
+			}
+		}
 	}
 
 	Num_awareness_events = 0;
 }
 
 // ----------------------------------------------------------------------------------
-static void set_player_awareness_all(fvmobjptr &vmobjptr, fvcsegptridx &vcsegptridx)
+static void set_player_awareness_all(fvmsegptr &vmsegptr, fvcsegptridx &vcsegptridx)
 {
-	awareness_t New_awareness;
+	/* Only the touched entries are ever set, and they are reset below, so
+	 * the array need not be cleared every frame.
+	 */
+	static awareness_t New_awareness;
+	std::vector<segnum_t> touched;
 
-	process_awareness_events(vcsegptridx, New_awareness);
+	process_awareness_events(vcsegptridx, New_awareness, touched);
 
-	range_for (const auto &&objp, vmobjptr)
+	range_for (const auto segnum, touched)
 	{
-		if (objp->type == OBJ_ROBOT && objp->control_type == CT_AI)
+		auto &a = New_awareness[segnum];
+		range_for (const auto objp, objects_in(vmsegptr(segnum), vmobjptridx, vmsegptr))
 		{
-			auto &ailp = objp->ctype.ai_info.ail;
-			if (New_awareness[objp->segnum] > ailp.player_awareness_type) {
-				ailp.player_awareness_type = New_awareness[objp->segnum];
-				ailp.player_awareness_time = PLAYER_AWARENESS_INITIAL_TIME;
-			}
+			if (objp->type == OBJ_ROBOT && objp->control_type == CT_AI)
+			{
+				auto &ailp = objp->ctype.ai_info.ail;
+				if (a > ailp.player_awareness_type) {
+					ailp.player_awareness_type = a;
+					ailp.player_awareness_time = PLAYER_AWARENESS_INITIAL_TIME;
+				}
 
 #if defined(DXX_BUILD_DESCENT_II)
-			// Clear the bit that says this robot is only awake because a camera woke it up.
-			if (New_awareness[objp->segnum] > ailp.player_awareness_type)
-				objp->ctype.ai_info.SUB_FLAGS &= ~SUB_FLAGS_CAMERA_AWAKE;
+				// Clear the bit that says this robot is only awake because a camera woke it up.
+				if (a > ailp.player_awareness_type)
+					objp->ctype.ai_info.SUB_FLAGS &= ~SUB_FLAGS_CAMERA_AWAKE;
 #endif
+			}
 		}
+		a = player_awareness_type_t::PA_NONE;
 	}
 }
 
@@ -4376,7 +4661,7 @@ void do_ai_frame_all(void)
 	dump_ai_objects_all();
 #endif
 
-	set_player_awareness_all(vmobjptr, vcsegptridx);
+	set_player_awareness_all(vmsegptr, vcsegptridx);
 
 #if defined(DXX_BUILD_DESCENT_II)
 	if (Ai_last_missile_camera)
@@ -90,6 +90,45 @@ static void create_random_xlate(array<uint8_t, MAX_SIDES_PER_SEGMENT> &xt)
 
 namespace dsx {
 
+namespace {
+
+//	The sides of a segment which lead to another segment, copied out of
+//	Segments so that create_path_points reads one small record per
+//	segment.  Sides without a wall can always be flown through; sides
+//	with one depend on the wall state and on which robot is asking.
+struct ai_nav_segment
+{
+	array<segnum_t, MAX_SIDES_PER_SEGMENT> children;
+	uint8_t open, walled;
+};
+
+}
+
+static array<ai_nav_segment, MAX_SEGMENTS> Ai_nav_segments;
+
+//	-----------------------------------------------------------------------------------------------------------
+//	Call after the mine is loaded or changed.
+void ai_build_nav_segments()
+{
+	auto &nav = Ai_nav_segments;
+	range_for (const auto &&segp, vcsegptridx)
+	{
+		auto &n = nav[segp];
+		n.open = n.walled = 0;
+		for (unsigned sidenum = 0; sidenum != MAX_SIDES_PER_SEGMENT; ++sidenum)
+		{
+			const auto child = segp->children[sidenum];
+			n.children[sidenum] = child;
+			if (!IS_CHILD(child))
+				continue;
+			if (segp->shared_segment::sides[sidenum].wall_num == wall_none)
+				n.open |= 1 << sidenum;
+			else
+				n.walled |= 1 << sidenum;
+		}
+	}
+}
+
 //	-----------------------------------------------------------------------------------------------------------
 //	Insert the point at the center of the side connecting two segments between the two points.
 // This is messy because we must insert into the list.  The simplest (and not too slow) way to do this is to start
@@ -310,7 +349,8 @@ if ((objp->type == OBJ_ROBOT) && (objp->ctype.ai_info.behavior == ai_behavior::A
 //		depth[i] = 0;
 //	}
 	visited_segment_bitarray_t visited;
-	array<uint16_t, MAX_SEGMENTS> depth{};
+	//	Indexed by queue position, and only read where written.
+	array<uint16_t, MAX_SEGMENTS> depth;
 
 	//	If there is a segment we're not allowed to visit, mark it.
 	if (avoid_seg != segment_none) {
@@ -333,8 +373,16 @@ if ((objp->type == OBJ_ROBOT) && (objp->ctype.ai_info.behavior == ai_behavior::A
 	auto &vcvertptr = Vertices.vcptr;
 	auto &Walls = LevelUniqueWallSubsystemState.Walls;
 	auto &vcwallptr = Walls.vcptr;
+#if DXX_USE_EDITOR
+	//	The mine may have been edited since it was loaded.
+	if (EditorWindow)
+		ai_build_nav_segments();
+#endif
+#if defined(DXX_BUILD_DESCENT_II)
+	auto &player_info = get_local_plrobj().ctype.player_info;
+#endif
 	while (cur_seg != end_seg) {
-		const auto &&segp = vcsegptr(cur_seg);
+		auto &nav = Ai_nav_segments[cur_seg];
 #if defined(DXX_BUILD_DESCENT_II)
 		if (random_flag != create_path_random_flag::nonrandom)
 			if (d_rand() < 8192)
@@ -343,15 +391,24 @@ if ((objp->type == OBJ_ROBOT) && (objp->ctype.ai_info.behavior == ai_behavior::A
 
 		for (sidenum = 0; sidenum < MAX_SIDES_PER_SEGMENT; sidenum++) {
 			const unsigned snum = (random_flag != create_path_random_flag::nonrandom) ? random_xlate[sidenum] : sidenum;
+			const unsigned side_mask = 1 << snum;
 
+			if (!(nav.open & side_mask))
+			{
+				if (!(nav.walled & side_mask))
+					continue;
+				const auto &&segp = vcsegptr(cur_seg);
+				if (!(WALL_IS_DOORWAY(GameBitmaps, Textures, vcwallptr, segp, segp, snum) & WID_FLY_FLAG) &&
 #if defined(DXX_BUILD_DESCENT_I)
-			if ((WALL_IS_DOORWAY(GameBitmaps, Textures, vcwallptr, segp, segp, snum) & WID_FLY_FLAG) || (ai_door_is_openable(objp, segp, snum)))
+					!ai_door_is_openable(objp, segp, snum)
 #elif defined(DXX_BUILD_DESCENT_II)
-			auto &player_info = get_local_plrobj().ctype.player_info;
-			if (IS_CHILD(segp->children[snum]) && ((WALL_IS_DOORWAY(GameBitmaps, Textures, vcwallptr, segp, segp, snum) & WID_FLY_FLAG) || (ai_door_is_openable(objp, player_info.powerup_flags, segp, snum))))
+					!ai_door_is_openable(objp, player_info.powerup_flags, segp, snum)
 #endif
+					)
+					continue;
+			}
 			{
-				auto this_seg = segp->children[snum];
+				auto this_seg = nav.children[snum];
 #if defined(DXX_BUILD_DESCENT_II)
 				Assert(this_seg != segment_none);
 				if (((cur_seg == avoid_seg) || (this_seg == avoid_seg)) && (ConsoleObject->segnum == avoid_seg)) {
@@ -359,7 +416,7 @@ if ((objp->type == OBJ_ROBOT) && (objp->ctype.ai_info.behavior == ai_behavior::A
 					fvi_info		hit_data;
 					int			hit_type;
 	
-					const auto &&center_point = compute_center_point_on_side(vcvertptr, segp, snum);
+					const auto &&center_point = compute_center_point_on_side(vcvertptr, vcsegptr(cur_seg), snum);
 
 					fq.p0						= &objp->pos;
 					fq.startseg				= objp->segnum;
@@ -381,6 +438,11 @@ if ((objp->type == OBJ_ROBOT) && (objp->ctype.ai_info.behavior == ai_behavior::A
 					seg_queue[qtail].end = this_seg;
 					visited[this_seg] = true;
 					depth[qtail++] = cur_depth+1;
+					//	The first time the goal is queued its parent is
+					//	final, so the rest of the breadth-first search
+					//	cannot change the path.
+					if (this_seg == end_seg)
+						goto cpp_found;
 					if (depth[qtail-1] == max_depth) {
 						end_seg = seg_queue[qtail-1].end;
 						goto cpp_done1;
@@ -407,6 +469,7 @@ dont_add: ;
 
 cpp_done1: ;
 	}	//	while (cur_seg ...
+cpp_found:
 
 	if (qtail > 0)
 	{
@@ -623,6 +686,21 @@ void validate_all_paths(void)
 }
 #endif
 
+//	-------------------------------------------------------------------------------------------------------
+//	Called just before the path of aip is replaced.  If the path is the
+//	last one allocated, give its records back, so that the new path is
+//	built over it.  A robot which keeps replanning then reuses the same
+//	records instead of using up Point_segs until the next garbage
+//	collection.
+static void ai_path_release_tail(const ai_static &aip)
+{
+	if (aip.hide_index < 0 || aip.path_length <= 0)
+		return;
+	const std::size_t end = aip.hide_index + aip.path_length;
+	if (end == Point_segs_free_ptr - Point_segs)
+		Point_segs_free_ptr = Point_segs.begin() + aip.hide_index;
+}
+
 //	-------------------------------------------------------------------------------------------------------
 //	Creates a path from the objects current segment (objp->segnum) to the specified segment for the object to
 //	hide in Ai_local_info[objnum].goal_segment.
@@ -649,6 +727,7 @@ void create_path_to_player(const vmobjptridx_t objp, const unsigned max_length,
 	if (end_seg == segment_none) {
 		;
 	} else {
+		ai_path_release_tail(*aip);
 		aip->path_length = create_path_points(objp, start_seg, end_seg, Point_segs_free_ptr, max_length, create_path_random_flag::random, safety_flag, segment_none).second;
 #if defined(DXX_BUILD_DESCENT_II)
 		aip->path_length = polish_path(objp, Point_segs_free_ptr, aip->path_length);
@@ -698,6 +777,7 @@ void create_path_to_segment(const vmobjptridx_t objp, segnum_t goalseg, const un
 	if (end_seg == segment_none) {
 		;
 	} else {
+		ai_path_release_tail(*aip);
 		aip->path_length = create_path_points(objp, start_seg, end_seg, Point_segs_free_ptr, max_length, create_path_random_flag::random, safety_flag, segment_none).second;
 		aip->hide_index = Point_segs_free_ptr - Point_segs;
 		aip->cur_path_index = 0;
@@ -740,6 +820,7 @@ void create_path_to_station(const vmobjptridx_t objp, int max_length)
 	if (end_seg == segment_none) {
 		;
 	} else {
+		ai_path_release_tail(*aip);
 		aip->path_length = create_path_points(objp, start_seg, end_seg, Point_segs_free_ptr, max_length, create_path_random_flag::random, create_path_safety_flag::safe, segment_none).second;
 #if defined(DXX_BUILD_DESCENT_II)
 		aip->path_length = polish_path(objp, Point_segs_free_ptr, aip->path_length);
@@ -778,6 +859,7 @@ void create_n_segment_path(const vmobjptridx_t objp, unsigned path_length, const
 	ai_static	*aip=&objp->ctype.ai_info;
 	ai_local		*ailp = &objp->ctype.ai_info.ail;
 
+	ai_path_release_tail(*aip);
 	const auto &&cr0 = create_path_points(objp, objp->segnum, segment_exit, Point_segs_free_ptr, path_length, create_path_random_flag::random, create_path_safety_flag::unsafe, avoid_seg);
 	aip->path_length = cr0.second;
 	if (cr0.first == create_path_result::early)
@@ -887,6 +969,7 @@ static void create_path(const vmobjptridx_t objp)
 	if (end_seg == segment_none) {
 		;
 	} else {
+		ai_path_release_tail(*aip);
 		aip->path_length = create_path_points(objp, start_seg, end_seg, Point_segs_free_ptr, MAX_PATH_LENGTH, create_path_random_flag::nonrandom, create_path_safety_flag::unsafe, segment_none).second;
 		aip->hide_index = Point_segs_free_ptr - Point_segs;
 		aip->cur_path_index = 0;
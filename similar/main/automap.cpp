@@ -83,6 +83,10 @@ COPYRIGHT 1993-1999 PARALLAX SOFTWARE CORPORATION.  ALL RIGHTS RESERVED.
 #include "playsave.h"
 #include "args.h"
 #include "physics.h"
+#include "hash.h"
+#if DXX_USE_EDITOR
+#include "editor/editor.h"
+#endif
 
 #include "compiler-make_unique.h"
 #include "compiler-range_for.h"
@@ -92,7 +96,6 @@ COPYRIGHT 1993-1999 PARALLAX SOFTWARE CORPORATION.  ALL RIGHTS RESERVED.
 
 #define EF_USED     1   // This edge is used
 #define EF_DEFINING 2   // A structure defining edge that should always draw.
-#define EF_FRONTIER 4   // An edge between the known and the unknown.
 #define EF_SECRET   8   // An edge that is part of a secret wall.
 #define EF_GRATE    16  // A grate... draw it all the time.
 #define EF_NO_FADE  32  // An edge that doesn't fade with distance
@@ -110,8 +113,36 @@ struct Edge_info
 	ubyte flags;        // 1  bytes  // See the EF_??? defines above.
 	color_t color;        // 1  bytes
 	ubyte num_faces;    // 1  bytes  // 31 bytes...
+	uint8_t unknown_faces;	// Solid sides of unvisited segments on this edge.  If nonzero, this is an edge between the known and the unknown.
 };
 
+/* The edge list stays built between automap openings.  Segments which
+ * become visited while playing are queued by automap_visit_segment and
+ * added when the automap opens next.  Anything else which changes what
+ * the list holds makes the next opening rebuild it.
+ */
+struct automap_edge_list
+{
+	unsigned num_edges;
+	unsigned max_edges;
+	unsigned end_valid_edges;
+	std::unique_ptr<Edge_info[]> edges;
+	std::unique_ptr<Edge_info *[]> drawingListBright;
+	std::vector<segnum_t> new_visits;
+	std::vector<Edge_info *> touched;
+	bool valid;
+	bool all_edges;
+	unsigned highest_segment;
+	unsigned player_num;
+	uint32_t walls;
+	/* Changes whenever a slot gets new end points, so that a copy of the
+	 * positions knows when to be rebuilt.
+	 */
+	uint32_t generation;
+};
+
+static automap_edge_list Automap_edges;
+
 }
 
 }
@@ -131,13 +162,6 @@ struct automap : ignore_window_pointer_t
 	int			max_segments_away;
 	int			segment_limit;
 	
-	// Edge list variables
-	int			num_edges;
-	unsigned max_edges; //set each frame
-	unsigned end_valid_edges;
-	std::unique_ptr<Edge_info[]>		edges;
-	std::unique_ptr<Edge_info *[]>			drawingListBright;
-	
 	// Screen canvas variables
 	grs_canvas		automap_view;
 	
@@ -188,6 +212,20 @@ namespace dcx {
 
 int Automap_active = 0;
 static int Automap_debug_show_all_segments;
+
+void automap_queue_visit(const segnum_t segnum)
+{
+	auto &el = Automap_edges;
+	if (el.valid)
+		el.new_visits.emplace_back(segnum);
+}
+
+void automap_invalidate_edges()
+{
+	auto &el = Automap_edges;
+	el.valid = false;
+	el.new_visits.clear();
+}
 }
 
 namespace dsx {
@@ -461,6 +499,7 @@ static void ClearMarkers()
 void automap_clear_visited()	
 {
 	Automap_visited = {};
+	automap_invalidate_edges();
 #ifndef NDEBUG
 	Automap_debug_show_all_segments = 0;
 #endif
@@ -793,10 +832,7 @@ static void draw_automap(fvcobjptr &vcobjptr, automap *am)
 	const auto may_sleep = !CGameArg.SysNoNiceFPS && !vsync;
 	while (am->t2 - am->t1 < bound) // ogl is fast enough that the automap can read the input too fast and you start to turn really slow.  So delay a bit (and free up some cpu :)
 	{
-		if (Game_mode & GM_MULTI)
-			multi_do_frame(); // during long wait, keep packets flowing
-		if (may_sleep)
-			timer_delay(F1_0>>8);
+		timer_delay_until(am->t1 + bound, may_sleep);
 		am->t2 = timer_update();
 	}
 	if (am->pause_game)
@@ -1036,12 +1072,6 @@ void do_automap()
 	am->leave_mode = 0;
 	am->max_segments_away = 0;
 	am->segment_limit = 1;
-	am->num_edges = 0;
-	am->end_valid_edges = 0;
-	const auto max_edges = LevelSharedSegmentState.Num_segments * 12;
-	am->max_edges = max_edges;
-	am->edges = make_unique<Edge_info[]>(max_edges);
-	am->drawingListBright = make_unique<Edge_info *[]>(max_edges);
 	am->zoom = 0x9000;
 	am->farthest_dist = (F1_0 * 20 * 50); // 50 segments away
 	am->viewDist = 0;
@@ -1108,7 +1138,7 @@ void adjust_segment_limit(automap *am, int SegmentLimit)
 	const auto predicate = [&depth_array, SegmentLimit](const segnum_t &e1) {
 		return depth_array[e1] <= SegmentLimit;
 	};
-	range_for (auto &i, unchecked_partial_range(am->edges.get(), am->end_valid_edges))
+	range_for (auto &i, unchecked_partial_range(Automap_edges.edges.get(), Automap_edges.end_valid_edges))
 	{
 		const auto e = &i;
 		// Unchecked for speed
@@ -1120,6 +1150,124 @@ void adjust_segment_limit(automap *am, int SegmentLimit)
 	}
 }
 
+#if DXX_USE_OGL
+namespace {
+
+struct automap_edge_buffer
+{
+	bool valid;
+	uint32_t generation;
+	std::vector<vms_vector> points;
+	std::vector<uint32_t> slots;
+	std::vector<uint8_t> colors;
+	std::vector<std::pair<fix, uint32_t>> bright;
+};
+
+static automap_edge_buffer Automap_edge_buffer;
+
+}
+
+//	Copy the end points of the edge slots into a GL buffer when the edge
+//	list has changed.  Returns false if the edges must be drawn one by one.
+static bool update_automap_edge_buffer(fvcvertptr &vcvertptr)
+{
+	auto &b = Automap_edge_buffer;
+	auto &el = Automap_edges;
+	if (b.valid && b.generation == el.generation
+#if DXX_USE_EDITOR
+		&& !EditorWindow
+#endif
+		)
+		return true;
+	b.generation = el.generation;
+	const unsigned count = el.end_valid_edges;
+	b.points.resize(count * 2);
+	auto o = b.points.begin();
+	range_for (auto &e, unchecked_partial_range(el.edges.get(), count))
+	{
+		*o++ = *vcvertptr(e.verts[0]);
+		*o++ = *vcvertptr(e.verts[1]);
+	}
+	b.valid = ogl_build_automap_buffer(count, b.points.data());
+	std::vector<vms_vector>().swap(b.points);
+	return b.valid;
+}
+
+//	The same choice of edges and colors as the code below, but the points
+//	are transformed by GL.  Only the depth of each point is computed here,
+//	and edges entirely off screen are left for GL to clip.
+static void draw_all_edges_buffered(const automap &am, fvcvertptr &vcvertptr)
+{
+	auto &b = Automap_edge_buffer;
+	b.slots.clear();
+	b.colors.clear();
+	b.bright.clear();
+	const auto point_z = [&vcvertptr](const unsigned v) {
+		return vm_vec_dot(vm_vec_sub(vcvertptr(v), View_position), View_matrix.fvec);
+	};
+	fix min_distance = INT32_MAX;
+	const auto edges = Automap_edges.edges.get();
+	for (uint32_t slot = 0, end = Automap_edges.end_valid_edges; slot != end; ++slot)
+	{
+		const auto e = &edges[slot];
+		if (!(e->flags & EF_USED)) continue;
+
+		if ( e->flags & EF_TOO_FAR) continue;
+
+		if (e->unknown_faces) { 	// A line that is between what we have seen and what we haven't
+			if ( (!(e->flags&EF_SECRET))&&(e->color==am.wall_normal_color))
+				continue; 	// If a line isn't secret and is normal color, then don't draw it
+		}
+		const auto distance = point_z(e->verts[1]);
+
+		if (min_distance>distance )
+			min_distance = distance;
+
+		unsigned nfacing = 0, nnfacing = 0;
+		auto &tv1 = *vcvertptr(e->verts[0]);
+		for (unsigned j = 0; j<e->num_faces && (nfacing==0 || nnfacing==0); ++j)
+		{
+			if (!g3_check_normal_facing(tv1, vcsegptr(e->segnum[j])->shared_segment::sides[e->sides[j]].normals[0]))
+				nfacing++;
+			else
+				nnfacing++;
+		}
+
+		if ( nfacing && nnfacing )	{
+			// a contour line
+			b.bright.emplace_back(point_z(e->verts[0]), slot);
+		} else if ( e->flags&(EF_DEFINING|EF_GRATE) )	{
+			if ( nfacing == 0 )	{
+				b.slots.emplace_back(slot);
+				b.colors.emplace_back((e->flags & EF_NO_FADE)
+					? e->color
+					: gr_fade_table[8][e->color]);
+			} 	else {
+				b.bright.emplace_back(point_z(e->verts[0]), slot);
+			}
+		}
+	}
+
+	if ( min_distance < 0 ) min_distance = 0;
+
+	std::sort(b.bright.begin(), b.bright.end());
+	range_for (auto &i, b.bright)
+	{
+		const auto e = &edges[i.second];
+		// Make distance be 1.0 to 0.0, where 0.0 is 10 segments away;
+		fix dist = i.first - min_distance;
+		if ( dist < 0 ) dist=0;
+		if ( dist >= am.farthest_dist ) continue;
+
+		b.slots.emplace_back(i.second);
+		b.colors.emplace_back((e->flags & EF_NO_FADE)
+			? e->color
+			: gr_fade_table[f2i((F1_0 - fixdiv(dist, am.farthest_dist)) * 31)][e->color]);
+	}
+	ogl_draw_automap_edges(b.slots.data(), b.colors.data(), b.slots.size());
+}
+#endif
+
 void draw_all_edges(grs_canvas &canvas, automap *const am)
 {
 	int j;
@@ -1130,14 +1278,22 @@ void draw_all_edges(grs_canvas &canvas, automap *const am)
 
 	auto &Vertices = LevelSharedVertexState.get_vertices();
 	auto &vcvertptr = Vertices.vcptr;
-	range_for (auto &i, unchecked_partial_range(am->edges.get(), am->end_valid_edges))
+#if DXX_USE_OGL
+	if (update_automap_edge_buffer(vcvertptr))
+	{
+		draw_all_edges_buffered(*am, vcvertptr);
+		return;
+	}
+	ogl_begin_line_batch();
+#endif
+	range_for (auto &i, unchecked_partial_range(Automap_edges.edges.get(), Automap_edges.end_valid_edges))
 	{
 		const auto e = &i;
 		if (!(e->flags & EF_USED)) continue;
 
 		if ( e->flags & EF_TOO_FAR) continue;
 
-		if (e->flags&EF_FRONTIER) { 	// A line that is between what we have seen and what we haven't
+		if (e->unknown_faces) { 	// A line that is between what we have seen and what we haven't
 			if ( (!(e->flags&EF_SECRET))&&(e->color==am->wall_normal_color))
 				continue; 	// If a line isn't secret and is normal color, then don't draw it
 		}
@@ -1161,7 +1317,7 @@ void draw_all_edges(grs_canvas &canvas, automap *const am)
 
 			if ( nfacing && nnfacing )	{
 				// a contour line
-				am->drawingListBright[nbright++] = e;
+				Automap_edges.drawingListBright[nbright++] = e;
 			} else if ( e->flags&(EF_DEFINING|EF_GRATE) )	{
 				if ( nfacing == 0 )	{
 					const uint8_t color = (e->flags & EF_NO_FADE)
@@ -1169,7 +1325,7 @@ void draw_all_edges(grs_canvas &canvas, automap *const am)
 						: gr_fade_table[8][e->color];
 					g3_draw_line(canvas, Segment_points[e->verts[0]], Segment_points[e->verts[1]], color);
 				} 	else {
-					am->drawingListBright[nbright++] = e;
+					Automap_edges.drawingListBright[nbright++] = e;
 				}
 			}
 		}
@@ -1178,7 +1334,7 @@ void draw_all_edges(grs_canvas &canvas, automap *const am)
 	if ( min_distance < 0 ) min_distance = 0;
 
 	// Sort the bright ones using a shell sort
-	const auto &&range = unchecked_partial_range(am->drawingListBright.get(), nbright);
+	const auto &&range = unchecked_partial_range(Automap_edges.drawingListBright.get(), nbright);
 	std::sort(range.begin(), range.end(), [](const Edge_info *const a, const Edge_info *const b) {
 		const auto &v1 = a->verts[0];
 		const auto &v2 = b->verts[0];
@@ -1200,6 +1356,9 @@ void draw_all_edges(grs_canvas &canvas, automap *const am)
 			: gr_fade_table[f2i((F1_0 - fixdiv(dist, am->farthest_dist)) * 31)][e->color];	
 		g3_draw_line(canvas, *p1, *p2, color);
 	}
+#if DXX_USE_OGL
+	ogl_end_line_batch();
+#endif
 }
 
 
@@ -1211,26 +1370,26 @@ void draw_all_edges(grs_canvas &canvas, automap *const am)
 
 
 //finds edge, filling in edge_ptr. if found old edge, returns index, else return -1
-static std::pair<Edge_info &, unsigned> automap_find_edge(automap *const am, const unsigned v0, const unsigned v1)
+static std::pair<Edge_info &, unsigned> automap_find_edge(const unsigned v0, const unsigned v1)
 {
 	long vv, evv;
 	int hash, oldhash;
 
 	vv = (v1<<16) + v0;
 
-	oldhash = hash = ((v0*5+v1) % am->max_edges);
+	oldhash = hash = ((v0*5+v1) % Automap_edges.max_edges);
 	for (;;)
 	{
-		auto &e = am->edges[hash];
+		auto &e = Automap_edges.edges[hash];
 		const auto ev0 = e.verts[0];
 		const auto ev1 = e.verts[1];
 		evv = (ev1<<16)+ev0;
-		if (e.num_faces == 0)
+		if (e.num_faces == 0 && e.unknown_faces == 0)
 			return {e, hash};
 		else if (evv == vv)
 			return {e, UINT32_MAX};
 		else {
-			if (++hash==am->max_edges) hash=0;
+			if (++hash==Automap_edges.max_edges) hash=0;
 			if (hash==oldhash) Error("Edge list full!");
 		}
 	}
@@ -1238,7 +1397,7 @@ static std::pair<Edge_info &, unsigned> automap_find_edge(automap *const am, con
 
 static void add_one_edge(automap *const am, unsigned va, unsigned vb, const uint8_t color, const unsigned side, const segnum_t segnum, const uint8_t flags)
 {
-	if ( am->num_edges >= am->max_edges)	{
+	if ( Automap_edges.num_edges >= Automap_edges.max_edges)	{
 		// GET JOHN! (And tell him that his
 		// MAX_EDGES_FROM_VERTS formula is hosed.)
 		// If he's not around, save the mine,
@@ -1252,10 +1411,11 @@ static void add_one_edge(automap *const am, unsigned va, unsigned vb, const uint
 	if ( va > vb )	{
 		std::swap(va, vb);
 	}
-	const auto &&ef = automap_find_edge(am, va, vb);
+	auto &el = Automap_edges;
+	const auto &&ef = automap_find_edge(va, vb);
 	const auto e = &ef.first;
 		
-	if (ef.second != UINT32_MAX)
+	if (ef.second != UINT32_MAX || !(e->flags & EF_USED))
 	{
 		e->verts[0] = va;
 		e->verts[1] = vb;
@@ -1264,10 +1424,14 @@ static void add_one_edge(automap *const am, unsigned va, unsigned vb, const uint
 		e->flags = EF_USED | EF_DEFINING;			// Assume a normal line
 		e->sides[0] = side;
 		e->segnum[0] = segnum;
-		am->num_edges++;
-		const auto i = ef.second + 1;
-		if (am->end_valid_edges < i)
-			am->end_valid_edges = i;
+		if (ef.second != UINT32_MAX)
+		{
+			++el.generation;
+			el.num_edges++;
+			const auto i = ef.second + 1;
+			if (el.end_valid_edges < i)
+				el.end_valid_edges = i;
+		}
 	} else {
 		if ( color != am->wall_normal_color )
 #if defined(DXX_BUILD_DESCENT_II)
@@ -1279,21 +1443,52 @@ static void add_one_edge(automap *const am, unsigned va, unsigned vb, const uint
 			e->sides[e->num_faces] = side;
 			e->segnum[e->num_faces] = segnum;
 			e->num_faces++;
+			el.touched.emplace_back(e);
 		}
 	}
 
 	e->flags |= flags;
 }
 
-static void add_one_unknown_edge( automap *am, int va, int vb )
+//	Count a solid side of an unvisited segment on this edge.  Edges only
+//	seen from unvisited segments keep their slot, so that the count is
+//	there when a visited neighbour adds the edge.
+static void add_one_unknown_edge(unsigned va, unsigned vb)
 {
 	if ( va > vb )	{
 		std::swap(va, vb);
 	}
 
-	const auto &&ef = automap_find_edge(am, va, vb);
-	if (ef.second == UINT32_MAX)
-		ef.first.flags |= EF_FRONTIER;		// Mark as a border edge
+	auto &el = Automap_edges;
+	const auto &&ef = automap_find_edge(va, vb);
+	auto &e = ef.first;
+	if (ef.second != UINT32_MAX)
+	{
+		if (el.num_edges >= el.max_edges)
+			return;
+		e.verts[0] = va;
+		e.verts[1] = vb;
+		e.num_faces = 0;
+		e.flags = 0;
+		++el.generation;
+		el.num_edges++;
+		const auto i = ef.second + 1;
+		if (el.end_valid_edges < i)
+			el.end_valid_edges = i;
+	}
+	++e.unknown_faces;
+}
+
+static void remove_one_unknown_edge(unsigned va, unsigned vb)
+{
+	if ( va > vb )	{
+		std::swap(va, vb);
+	}
+
+	const auto &&ef = automap_find_edge(va, vb);
+	auto &e = ef.first;
+	if (ef.second == UINT32_MAX && e.unknown_faces)
+		--e.unknown_faces;
 }
 
 static void add_segment_edges(fvcsegptr &vcsegptr, fvcwallptr &vcwallptr, automap *am, const vcsegptridx_t seg)
@@ -1427,7 +1622,8 @@ static void add_segment_edges(fvcsegptr &vcsegptr, fvcwallptr &vcwallptr, automa
 
 // Adds all the edges from a segment we haven't visited yet.
 
-static void add_unknown_segment_edges(automap *am, const shared_segment &seg)
+template <void (*F)(unsigned, unsigned)>
+static void visit_unknown_segment_edges(const shared_segment &seg)
 {
 	for (unsigned sn = 0; sn < MAX_SIDES_PER_SEGMENT; ++sn)
 	{
@@ -1435,27 +1631,113 @@ static void add_unknown_segment_edges(automap *am, const shared_segment &seg)
 		if (seg.children[sn] == segment_none) {
 			const auto vertex_list = get_side_verts(seg, sn);
 	
-			add_one_unknown_edge( am, vertex_list[0], vertex_list[1] );
-			add_one_unknown_edge( am, vertex_list[1], vertex_list[2] );
-			add_one_unknown_edge( am, vertex_list[2], vertex_list[3] );
-			add_one_unknown_edge( am, vertex_list[3], vertex_list[0] );
+			F(vertex_list[0], vertex_list[1]);
+			F(vertex_list[1], vertex_list[2]);
+			F(vertex_list[2], vertex_list[3]);
+			F(vertex_list[3], vertex_list[0]);
 		}
 	}
 }
 
+// Find unnecessary lines (These are lines that don't have to be drawn because they have small curvature)
+static void check_defining_edge(Edge_info &i)
+{
+		const auto e = &i;
+		if (!(e->flags&EF_DEFINING))
+			return;
+
+		const auto num_faces = e->num_faces;
+		if (num_faces < 2)
+			return;
+		for (unsigned e1 = 0; e1 < num_faces; ++e1)
+		{
+			const auto e1segnum = e->segnum[e1];
+			const auto &e1siden0 = vcsegptr(e1segnum)->shared_segment::sides[e->sides[e1]].normals[0];
+			for (unsigned e2 = 1; e2 < num_faces; ++e2)
+			{
+				if (e1 == e2)
+					continue;
+				const auto e2segnum = e->segnum[e2];
+				if (e1segnum == e2segnum)
+					continue;
+				if (vm_vec_dot(e1siden0, vcsegptr(e2segnum)->shared_segment::sides[e->sides[e2]].normals[0]) > (F1_0 - (F1_0 / 10)))
+				{
+					e->flags &= (~EF_DEFINING);
+					break;
+				}
+			}
+			if (!(e->flags & EF_DEFINING))
+				break;
+		}
+}
+
+//	The edges depend on the wall types, which cloaking walls and
+//	multiplayer wall updates can change.
+static uint32_t automap_wall_signature(fvcwallptr &vcwallptr)
+{
+	fnv1a_hash h;
+	range_for (const auto &&w, vcwallptr)
+		h.add(w->type);
+	return h.get();
+}
+
+static void add_visited_segments(automap *const am)
+{
+	auto &el = Automap_edges;
+	auto &Walls = LevelUniqueWallSubsystemState.Walls;
+	auto &vcwallptr = Walls.vcptr;
+	el.touched.clear();
+	range_for (const auto segnum, el.new_visits)
+	{
+		const auto &&segp = vcsegptridx(segnum);
+		add_segment_edges(vcsegptr, vcwallptr, am, segp);
+		visit_unknown_segment_edges<remove_one_unknown_edge>(segp);
+	}
+	el.new_visits.clear();
+	range_for (const auto e, el.touched)
+		check_defining_edge(*e);
+	el.touched.clear();
+}
+
 void automap_build_edge_list(automap *am, int add_all_edges)
 {	
+	auto &el = Automap_edges;
+	auto &Walls = LevelUniqueWallSubsystemState.Walls;
+	auto &vcwallptr = Walls.vcptr;
+	const auto walls = automap_wall_signature(vcwallptr);
+	if (el.valid && !el.all_edges && !add_all_edges && el.walls == walls && el.highest_segment == Highest_segment_index && el.player_num == Player_num
+#if DXX_USE_EDITOR
+		&& !EditorWindow
+#endif
+		)
+	{
+		add_visited_segments(am);
+		return;
+	}
+	el.valid = true;
+	el.all_edges = add_all_edges;
+	el.walls = walls;
+	el.highest_segment = Highest_segment_index;
+	el.player_num = Player_num;
+	el.new_visits.clear();
+	const auto max_edges = LevelSharedSegmentState.Num_segments * 12;
+	if (el.max_edges != max_edges)
+	{
+		el.max_edges = max_edges;
+		el.edges = make_unique<Edge_info[]>(max_edges);
+		el.drawingListBright = make_unique<Edge_info *[]>(max_edges);
+	}
 	// clear edge list
-	range_for (auto &i, unchecked_partial_range(am->edges.get(), am->max_edges))
+	range_for (auto &i, unchecked_partial_range(el.edges.get(), el.max_edges))
 	{
 		i.num_faces = 0;
+		i.unknown_faces = 0;
 		i.flags = 0;
 	}
-	am->num_edges = 0;
-	am->end_valid_edges = 0;
+	el.num_edges = 0;
+	el.end_valid_edges = 0;
+	++el.generation;
 
-	auto &Walls = LevelUniqueWallSubsystemState.Walls;
-	auto &vcwallptr = Walls.vcptr;
 	if (add_all_edges)	{
 		// Cheating, add all edges as visited
 		range_for (const auto &&segp, vcsegptridx)
@@ -1484,41 +1766,15 @@ void automap_build_edge_list(automap *am, int add_all_edges)
 			if (segp->segnum != segment_none)
 #endif
 				if (!Automap_visited[segp]) {
-					add_unknown_segment_edges(am, segp);
+					visit_unknown_segment_edges<add_one_unknown_edge>(segp);
 				}
 		}
 	}
+	el.touched.clear();
 
-	// Find unnecessary lines (These are lines that don't have to be drawn because they have small curvature)
-	range_for (auto &i, unchecked_partial_range(am->edges.get(), am->end_valid_edges))
-	{
-		const auto e = &i;
-		if (!(e->flags&EF_USED)) continue;
-
-		const auto num_faces = e->num_faces;
-		if (num_faces < 2)
-			continue;
-		for (unsigned e1 = 0; e1 < num_faces; ++e1)
-		{
-			const auto e1segnum = e->segnum[e1];
-			const auto &e1siden0 = vcsegptr(e1segnum)->shared_segment::sides[e->sides[e1]].normals[0];
-			for (unsigned e2 = 1; e2 < num_faces; ++e2)
-			{
-				if (e1 == e2)
-					continue;
-				const auto e2segnum = e->segnum[e2];
-				if (e1segnum == e2segnum)
-					continue;
-				if (vm_vec_dot(e1siden0, vcsegptr(e2segnum)->shared_segment::sides[e->sides[e2]].normals[0]) > (F1_0 - (F1_0 / 10)))
-				{
-					e->flags &= (~EF_DEFINING);
-					break;
-				}
-			}
-			if (!(e->flags & EF_DEFINING))
-				break;
-		}
-	}
+	range_for (auto &i, unchecked_partial_range(el.edges.get(), el.end_valid_edges))
+		if (i.flags & EF_USED)
+			check_defining_edge(i);
 }
 
 #if defined(DXX_BUILD_DESCENT_II)
@@ -56,6 +56,7 @@ COPYRIGHT 1993-1999 PARALLAX SOFTWARE CORPORATION.  ALL RIGHTS RESERVED.
 #include "makesig.h"
 #include "interp.h"
 #include "console.h"
+#include "profile.h"
 #include "rle.h"
 #include "physfsx.h"
 #include "internal.h"
@@ -119,6 +120,7 @@ namespace dsx {
 void gamedata_close()
 {
 	free_polygon_models();
+	polymodel_cache_close();
 #if defined(DXX_BUILD_DESCENT_II)
 	bm_free_extra_objbitmaps();
 #endif
@@ -145,6 +147,7 @@ static void tmap_info_read(tmap_info &ti, PHYSFS_File *fp)
 // Initializes game properties data (including texture caching system) and sound data.
 int gamedata_init()
 {
+	const trace_scope trace_phase("gamedata_init");
 	int retval;
 	
 	init_polygon_models();
@@ -153,6 +156,7 @@ int gamedata_init()
 		gamedata_read_tbl(Vclip, retval == PIGGY_PC_SHAREWARE);
 
 	piggy_read_sounds(retval == PIGGY_PC_SHAREWARE);
+	digi_convert_sounds();
 	
 	return 0;
 }
@@ -276,6 +280,7 @@ static void tmap_info_read(tmap_info &ti, PHYSFS_File *fp)
 // Initializes game properties data (including texture caching system) and sound data.
 int gamedata_init()
 {
+	const trace_scope trace_phase("gamedata_init");
 	init_polygon_models();
 
 #if DXX_USE_EDITOR
@@ -287,6 +292,7 @@ int gamedata_init()
 				Error("Cannot open ham file\n");
 
 	piggy_read_sounds();
+	digi_convert_sounds();
 
 	return 0;
 }
@@ -420,6 +426,7 @@ static void bm_free_extra_models()
 //type==1 means 1.1, type==2 means 1.2 (with weapons)
 void bm_read_extra_robots(const char *fname, Mission::descent_version_type type)
 {
+	const trace_scope trace_phase("bm_read_extra_robots", fname);
 	auto &Robot_joints = LevelSharedRobotJointState.Robot_joints;
 	int t,version;
 
@@ -504,6 +511,7 @@ int Robot_replacements_loaded = 0;
 
 void load_robot_replacements(const d_fname &level_name)
 {
+	const trace_scope trace_phase("load_robot_replacements", level_name);
 	auto &Robot_joints = LevelSharedRobotJointState.Robot_joints;
 	int t,i,j;
 	char ifile_name[FILENAME_LEN];
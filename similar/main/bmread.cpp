@@ -26,6 +26,8 @@ COPYRIGHT 1993-1999 PARALLAX SOFTWARE CORPORATION.  ALL RIGHTS RESERVED.
 
 #include <algorithm>
 #include <string>
+#include <type_traits>
+#include <vector>
 #include <stdio.h>
 #include <stdlib.h>
 #include <stdarg.h>
@@ -70,6 +72,7 @@ COPYRIGHT 1993-1999 PARALLAX SOFTWARE CORPORATION.  ALL RIGHTS RESERVED.
 #include "strutil.h"
 #if DXX_USE_EDITOR
 #include "editor/texpage.h"
+#include "hash.h"
 #endif
 
 #include "compiler-range_for.h"
@@ -180,6 +183,128 @@ static void clear_to_end_of_line(void);
 static void verify_textures(void);
 #endif
 
+#if DXX_USE_EDITOR
+/*
+ * Parsing BITMAPS.TBL reads every bitmap, sound and model it names, so
+ * the editor keeps the result in bitmaps.cmp in the write directory:
+ * the tables, and each bitmap and sound the parse registered with the
+ * piggy code.  The cache records the size and modification time of every
+ * file the parse read or looked for, and a key hashing BITMAPS.TBL
+ * itself, the names already in the pig, the palette and the options the
+ * parse depends on.  It is only used when all of them still match.  The
+ * file is in native byte order and structure layout, and is never
+ * shared between builds.
+ */
+#define BM_TBLCACHE_FILENAME	"bitmaps.cmp"
+constexpr uint32_t bm_tblcache_magic = 0x43544244;	// "DBTC"
+constexpr uint32_t bm_tblcache_version = 1;
+
+namespace {
+
+struct bm_tblcache_source
+{
+	std::string name;
+	PHYSFS_sint64 size, mtime;
+};
+
+struct bm_tblcache_bitmap
+{
+	std::string name;
+	grs_bitmap bm;
+	std::unique_ptr<uint8_t[]> data;
+};
+
+struct bm_tblcache_sound
+{
+	std::string name;
+	digi_sound snd;
+	int in_file;
+	std::unique_ptr<uint8_t[]> data;
+};
+
+struct bm_tblcache_state
+{
+	bool recording;
+	/* Set if the parse did something the cache cannot replay. */
+	bool unusable;
+	std::vector<bm_tblcache_source> sources;
+	std::vector<bm_tblcache_bitmap> bitmaps;
+	std::vector<bm_tblcache_sound> sounds;
+};
+
+}
+
+static bm_tblcache_state bm_tblcache;
+
+static void bm_tblcache_depend(const char *const filename)
+{
+	auto &c = bm_tblcache;
+	if (!c.recording)
+		return;
+	PHYSFS_sint64 size = -1, mtime = -1;
+	PHYSFSX_stat(filename, size, mtime);
+	c.sources.emplace_back(bm_tblcache_source{filename, size, mtime});
+}
+
+/* Copy bmp before piggy_register_bitmap converts it, so that loading
+ * the cache can register it again the same way.
+ */
+static void bm_tblcache_record(const grs_bitmap &bmp, const char *const name)
+{
+	auto &c = bm_tblcache;
+	if (!c.recording)
+		return;
+	if (bmp.get_flag_mask(BM_FLAG_RLE) || bmp.get_type() != bm_mode::linear)
+	{
+		c.unusable = true;
+		return;
+	}
+	const std::size_t size = bmp.bm_rowsize * bmp.bm_h;
+	auto data = make_unique<uint8_t[]>(size);
+	memcpy(data.get(), bmp.bm_data, size);
+	c.bitmaps.emplace_back(bm_tblcache_bitmap{name, bmp, std::move(data)});
+}
+
+static void bm_tblcache_record(const digi_sound &snd, const char *const name, const int in_file)
+{
+	auto &c = bm_tblcache;
+	if (!c.recording)
+		return;
+	std::unique_ptr<uint8_t[]> data;
+	/* Only the bogus sound is registered as in the file, and it has
+	 * no data of its own.
+	 */
+	if (!in_file)
+	{
+		data = make_unique<uint8_t[]>(snd.length);
+		memcpy(data.get(), snd.data, snd.length);
+	}
+	c.sounds.emplace_back(bm_tblcache_sound{name, snd, in_file, std::move(data)});
+}
+#else
+static inline void bm_tblcache_depend(const char *) {}
+static inline void bm_tblcache_record(const grs_bitmap &, const char *) {}
+static inline void bm_tblcache_record(const digi_sound &, const char *, int) {}
+#endif
+
+static bitmap_index bm_register_bitmap(grs_bitmap &bmp, const char *const name)
+{
+	bm_tblcache_record(bmp, name);
+	return piggy_register_bitmap(bmp, name, 0);
+}
+
+static int bm_register_sound(digi_sound &snd, const char *const name, const int in_file)
+{
+	bm_tblcache_record(snd, name, in_file);
+	return piggy_register_sound(&snd, name, in_file);
+}
+
+static int bm_load_polygon_model(const char *const filename, const int n_textures, const int first_texture, robot_info *const r)
+{
+	bm_tblcache_depend(filename);
+	return load_polygon_model(filename, n_textures, first_texture, r);
+}
+
 //---------------------------------------------------------------
 int compute_average_pixel(grs_bitmap *n)
 {
@@ -253,6 +378,7 @@ static bitmap_index bm_load_sub(const int skip, const char *const filename)
 	}
 
 	grs_bitmap n;
+	bm_tblcache_depend(filename);
 	iff_error = iff_read_bitmap(filename, n, &newpal);
 	if (iff_error != IFF_NO_ERROR)		{
 		Error("File <%s> - IFF error: %s, line %d",filename,iff_errormsg(iff_error),linenum);
@@ -262,7 +388,7 @@ static bitmap_index bm_load_sub(const int skip, const char *const filename)
 
 	n.avg_color = compute_average_pixel(&n);
 
-	bitmap_num = piggy_register_bitmap(n, fname.data(), 0);
+	bitmap_num = bm_register_bitmap(n, fname.data());
 	return bitmap_num;
 }
 
@@ -276,7 +402,7 @@ static void ab_load(int skip, const char * filename, array<bitmap_index, MAX_BIT
 	if (skip) {
 		Assert( bogus_bitmap_initialized != 0 );
 #if defined(DXX_BUILD_DESCENT_I)
-		bmp[0] = piggy_register_bitmap(bogus_bitmap, "bogus", 0);
+		bmp[0] = bm_register_bitmap(bogus_bitmap, "bogus");
 #elif defined(DXX_BUILD_DESCENT_II)
 		bmp[0].index = 0;		//index of bogus bitmap==0 (I think)		//&bogus_bitmap;
 #endif
@@ -317,6 +443,7 @@ static void ab_load(int skip, const char * filename, array<bitmap_index, MAX_BIT
 //	type mismatch found using lint, will substitute this line with an adjusted
 //	one.  If fatal error, then it can be easily changed.
 	array<std::unique_ptr<grs_main_bitmap>, MAX_BITMAPS_PER_BRUSH> bm;
+	bm_tblcache_depend(filename);
 	iff_error = iff_read_animbrush(filename,bm,nframes,newpal);
 	if (iff_error != IFF_NO_ERROR)	{
 		Error("File <%s> - IFF error: %s, line %d",filename,iff_errormsg(iff_error),linenum);
@@ -336,7 +463,7 @@ static void ab_load(int skip, const char * filename, array<bitmap_index, MAX_BIT
 #endif
 		gr_remap_bitmap_good(*bm[i].get(), newpal, iff_has_transparency ? iff_transparent_color : -1, SuperX);
 		bm[i]->avg_color = compute_average_pixel(bm[i].get());
-		bmp[i] = piggy_register_bitmap(*bm[i].get(), tempname.data(), 0);
+		bmp[i] = bm_register_bitmap(*bm[i].get(), tempname.data());
 	}
 }
 
@@ -348,7 +475,7 @@ int ds_load(int skip, const char * filename )	{
 	if (skip) {
 		// We tell piggy_register_sound it's in the pig file, when in actual fact it's in no file
 		// This just tells piggy_close not to attempt to free it
-		return piggy_register_sound( &bogus_sound, "bogus", 1 );
+		return bm_register_sound(bogus_sound, "bogus", 1);
 	}
 
 	array<char, 20> fname;
@@ -363,6 +490,7 @@ int ds_load(int skip, const char * filename )	{
 	if (i!=255)	{
 		return i;
 	}
+	bm_tblcache_depend(rawname);
 	if (auto cfp = PHYSFSX_openReadBuffered(rawname))
 	{
 		n.length	= PHYSFS_fileLength( cfp );
@@ -373,7 +501,7 @@ int ds_load(int skip, const char * filename )	{
 	} else {
 		return 255;
 	}
-	i = piggy_register_sound(&n, fname.data(), 0);
+	i = bm_register_sound(n, fname.data(), 0);
 	return i;
 }
 
@@ -440,6 +568,340 @@ static int get_texture(char *name)
 
 namespace dsx {
 
+#if DXX_USE_EDITOR
+namespace {
+
+template <typename T>
+static void bm_tblcache_check_plain(const T &)
+{
+	static_assert(std::is_trivially_copyable<T>::value, "cached tables must be plain data");
+}
+
+class bm_tblcache_writer
+{
+	PHYSFS_File *const fp;
+public:
+	bool ok = true;
+	bm_tblcache_writer(PHYSFS_File *const f) :
+		fp(f)
+	{
+	}
+	void write(const void *const p, const std::size_t len)
+	{
+		if (PHYSFS_write(fp, reinterpret_cast<const uint8_t *>(p), len, 1) != 1)
+			ok = false;
+	}
+	template <typename T>
+		void operator()(const T &t)
+		{
+			bm_tblcache_check_plain(t);
+			write(std::addressof(t), sizeof(t));
+		}
+	void operator()(const std::string &str)
+	{
+		(*this)(static_cast<uint32_t>(str.size()));
+		write(str.data(), str.size());
+	}
+};
+
+/* Only used once the header and the file length have matched, so short
+ * reads are not checked.
+ */
+class bm_tblcache_reader
+{
+	PHYSFS_File *const fp;
+public:
+	bm_tblcache_reader(PHYSFS_File *const f) :
+		fp(f)
+	{
+	}
+	void read(void *const p, const std::size_t len)
+	{
+		PHYSFS_read(fp, reinterpret_cast<uint8_t *>(p), len, 1);
+	}
+	template <typename T>
+		void operator()(T &t)
+		{
+			bm_tblcache_check_plain(t);
+			read(std::addressof(t), sizeof(t));
+		}
+	void operator()(std::string &str)
+	{
+		uint32_t len;
+		(*this)(len);
+		str.resize(len);
+		read(&str[0], len);
+	}
+};
+
+struct bm_tblcache_header
+{
+	uint32_t magic, version;
+	uint64_t layout, key, size;
+};
+
+}
+
+/* Pass every table which BITMAPS.TBL parsing fills to f. */
+template <typename F>
+static void bm_tblcache_visit_tables(d_vclip_array &Vclip, F &&f)
+{
+	auto &TmapInfo = LevelUniqueTmapInfoState.TmapInfo;
+	f(NumTextures);
+	f(Textures);
+	f(TmapInfo);
+	f(LevelUniqueTmapInfoState.Num_tmaps);
+	f(TextureMetals);
+	f(TextureLights);
+	f(TextureEffects);
+	f(texture_count);
+	f(tmap_count);
+	f(Sounds);
+	f(AltSounds);
+	f(num_sounds);
+	f(Num_vclips);
+	f(Vclip);
+	f(Num_effects);
+	f(Effects);
+	f(Num_wall_anims);
+	f(WallAnims);
+	f(LevelSharedRobotInfoState.N_robot_types);
+	f(LevelSharedRobotInfoState.Robot_info);
+	f(Robot_names);
+	f(Num_robot_ais);
+	f(N_robot_joints);
+	f(LevelSharedRobotJointState.Robot_joints);
+	f(N_weapon_types);
+	f(Weapon_info);
+	f(N_powerup_types);
+	f(Powerup_info);
+	f(Powerup_names);
+	f(N_polygon_models);
+	f(Pof_names);
+	f(Dying_modelnums);
+	f(Dead_modelnums);
+	f(Gauges);
+	f(N_ObjBitmaps);
+	f(N_ObjBitmapPtrs);
+	f(ObjBitmaps);
+	f(ObjBitmapPtrs);
+	f(only_player_ship);
+	f(Num_cockpits);
+	f(cockpit_bitmap);
+	f(First_multi_bitmap_num);
+	f(Reactors);
+	f(exit_modelnum);
+	f(destroyed_exit_modelnum);
+#if defined(DXX_BUILD_DESCENT_I)
+	f(N_hostage_types);
+	f(Hostage_vclip_num);
+	f(Num_total_object_types);
+	f(ObjType);
+	f(ObjId);
+	f(ObjStrength);
+#elif defined(DXX_BUILD_DESCENT_II)
+	f(Gauges_hires);
+	f(Num_reactors);
+	f(Marker_model_num);
+	f(Num_aliases);
+	f(alias_list);
+#endif
+}
+
+/* Changes whenever a rebuild changes the size of anything cached. */
+static uint64_t bm_tblcache_layout(d_vclip_array &Vclip)
+{
+	fnv1a_hash h;
+	bm_tblcache_visit_tables(Vclip, [&h](const auto &t) {
+		h.add(sizeof(t));
+	});
+	h.add(sizeof(grs_bitmap));
+	h.add(sizeof(digi_sound));
+	return h.get();
+}
+
+static uint64_t bm_tblcache_key(const int pc_shareware)
+{
+	fnv1a_hash h;
+	h.add(piggy_names_hash());
+	h.add(gr_palette);
+	h.add(pc_shareware);
+	h.add(CGameArg.DbgNoCompressPigBitmap);
+#if defined(DXX_BUILD_DESCENT_II)
+	h.add(GameArg.SndDigiSampleRate);
+	h.add(GameArg.EdiMacData);
+#endif
+	/* An edit can keep both the size and the modification time, so
+	 * hash the table itself.
+	 */
+	for (const auto name : {"BITMAPS.TBL", "BITMAPS.BIN"})
+	{
+		auto fp = PHYSFSX_openReadBuffered(name);
+		const PHYSFS_sint64 len = fp ? PHYSFS_fileLength(fp) : -1;
+		h.add(len);
+		if (len > 0)
+		{
+			const auto buf = make_unique<uint8_t[]>(len);
+			if (PHYSFS_read(fp, buf.get(), len, 1) == 1)
+				h.add(buf.get(), len);
+		}
+	}
+	return h.get();
+}
+
+static void bm_tblcache_start()
+{
+	auto &c = bm_tblcache;
+	c.recording = true;
+	c.unusable = false;
+	bm_tblcache_depend("BITMAPS.TBL");
+	bm_tblcache_depend("BITMAPS.BIN");
+}
+
+static bool bm_tblcache_load(d_vclip_array &Vclip, const uint64_t key)
+{
+	auto fp = PHYSFSX_openReadBuffered(BM_TBLCACHE_FILENAME);
+	if (!fp)
+		return false;
+	bm_tblcache_header header;
+	if (PHYSFS_read(fp, reinterpret_cast<uint8_t *>(&header), sizeof(header), 1) != 1 ||
+		header.magic != bm_tblcache_magic ||
+		header.version != bm_tblcache_version ||
+		header.layout != bm_tblcache_layout(Vclip) ||
+		header.key != key ||
+		PHYSFS_fileLength(fp) != static_cast<PHYSFS_sint64>(header.size))
+		return false;
+	bm_tblcache_reader r(fp);
+	uint32_t n;
+	r(n);
+	for (; n; --n)
+	{
+		bm_tblcache_source s;
+		r(s.name);
+		r(s.size);
+		r(s.mtime);
+		PHYSFS_sint64 size = -1, mtime = -1;
+		PHYSFSX_stat(s.name.c_str(), size, mtime);
+		if (size != s.size || mtime != s.mtime)
+		{
+			con_printf(CON_VERBOSE, "DXX-Rebirth: %s changed since " BM_TBLCACHE_FILENAME " was written", s.name.c_str());
+			return false;
+		}
+	}
+	r(n);
+	for (; n; --n)
+	{
+		std::string name;
+		grs_bitmap bm;
+		r(name);
+		r(bm);
+		const std::size_t size = bm.bm_rowsize * bm.bm_h;
+		MALLOC(bm.bm_mdata, uint8_t, size);
+		r.read(bm.bm_mdata, size);
+		bm.bm_parent = nullptr;
+#if DXX_USE_OGL
+		bm.gltexture = nullptr;
+#endif
+		piggy_register_bitmap(bm, name.c_str(), 0);
+	}
+	r(n);
+	for (; n; --n)
+	{
+		std::string name;
+		digi_sound snd;
+		int in_file;
+		r(name);
+		r(snd);
+		r(in_file);
+		if (in_file)
+			piggy_register_sound(&bogus_sound, name.c_str(), 1);
+		else
+		{
+			MALLOC(snd.data, uint8_t, snd.length);
+			r.read(snd.data, snd.length);
+			piggy_register_sound(&snd, name.c_str(), 0);
+		}
+	}
+	bm_tblcache_visit_tables(Vclip, r);
+	auto &Polygon_models = LevelSharedPolygonModelState.Polygon_models;
+	range_for (auto &pm, partial_range(Polygon_models, N_polygon_models))
+	{
+		polymodel_read(&pm, fp);
+		/* The model data was already aligned, swapped and initialized
+		 * before it was written.
+		 */
+		mem_account(mem_tag::models, 0, pm.model_data_size);
+		pm.model_data = make_unique<uint8_t[]>(pm.model_data_size);
+		r.read(pm.model_data.get(), pm.model_data_size);
+	}
+	con_printf(CON_VERBOSE, "DXX-Rebirth: read BITMAPS.TBL from " BM_TBLCACHE_FILENAME);
+	return true;
+}
+
+static void bm_tblcache_save(d_vclip_array &Vclip, const uint64_t key)
+{
+	auto &c = bm_tblcache;
+	if (!c.recording)
+		return;
+	c.recording = false;
+	if (!c.unusable)
+	{
+		if (auto fp = PHYSFSX_openWriteBuffered(BM_TBLCACHE_FILENAME))
+		{
+			/* The header is written last, so an interrupted write leaves
+			 * a file which fails the magic check.
+			 */
+			bm_tblcache_header header{};
+			bm_tblcache_writer w(fp);
+			w(header);
+			w(static_cast<uint32_t>(c.sources.size()));
+			range_for (auto &s, c.sources)
+			{
+				w(s.name);
+				w(s.size);
+				w(s.mtime);
+			}
+			w(static_cast<uint32_t>(c.bitmaps.size()));
+			range_for (auto &b, c.bitmaps)
+			{
+				w(b.name);
+				w(b.bm);
+				w.write(b.data.get(), b.bm.bm_rowsize * b.bm.bm_h);
+			}
+			w(static_cast<uint32_t>(c.sounds.size()));
+			range_for (auto &s, c.sounds)
+			{
+				w(s.name);
+				w(s.snd);
+				w(s.in_file);
+				if (!s.in_file)
+					w.write(s.data.get(), s.snd.length);
+			}
+			bm_tblcache_visit_tables(Vclip, w);
+			auto &Polygon_models = LevelSharedPolygonModelState.Polygon_models;
+			range_for (auto &pm, partial_const_range(Polygon_models, N_polygon_models))
+			{
+				polymodel_write(fp, pm);
+				w.write(pm.model_data.get(), pm.model_data_size);
+			}
+			header.magic = bm_tblcache_magic;
+			header.version = bm_tblcache_version;
+			header.layout = bm_tblcache_layout(Vclip);
+			header.key = key;
+			header.size = PHYSFS_tell(fp);
+			if (!w.ok || PHYSFSX_fseek(fp, 0, SEEK_SET) || PHYSFS_write(fp, reinterpret_cast<const uint8_t *>(&header), sizeof(header), 1) != 1)
+				con_printf(CON_URGENT, "DXX-Rebirth: failed to write " BM_TBLCACHE_FILENAME ": %s", PHYSFS_getLastError());
+		}
+	}
+	c.sources.clear();
+	c.sources.shrink_to_fit();
+	c.bitmaps.clear();
+	c.bitmaps.shrink_to_fit();
+	c.sounds.clear();
+	c.sounds.shrink_to_fit();
+}
+#endif
+
 //-----------------------------------------------------------------
 // Initializes all properties and bitmaps from BITMAPS.TBL file.
 // This is called when the editor is IN.
@@ -521,6 +983,22 @@ int gamedata_read_tbl(d_vclip_array &Vclip, int pc_shareware)
 
 	Installed = 1;
 
+#if DXX_USE_EDITOR
+	uint64_t tblcache_key = 0;
+	if (!GameArg.EdiNoTblCache)
+	{
+		tblcache_key = bm_tblcache_key(pc_shareware);
+		if (bm_tblcache_load(Vclip, tblcache_key))
+		{
+#if defined(DXX_BUILD_DESCENT_II)
+			gr_use_palette_table(D2_DEFAULT_PALETTE);
+#endif
+			return 0;
+		}
+		bm_tblcache_start();
+	}
+#endif
+
 #if defined(DXX_BUILD_DESCENT_I)
 	// Open BITMAPS.TBL for reading.
 	have_bin_tbl = 0;
@@ -790,6 +1268,9 @@ int gamedata_read_tbl(d_vclip_array &Vclip, int pc_shareware)
 	gr_use_palette_table(D2_DEFAULT_PALETTE);
 #endif
 
+#if DXX_USE_EDITOR
+	bm_tblcache_save(Vclip, tblcache_key);
+#endif
 	return 0;
 }
 
@@ -1597,7 +2078,7 @@ void bm_read_robot(int skip)
 
 		n_textures = first_bitmap_num[i+1] - first_bitmap_num[i];
 
-		model_num = load_polygon_model(model_name[i],n_textures,first_bitmap_num[i], (i == 0) ? &current_robot_info : nullptr);
+		model_num = bm_load_polygon_model(model_name[i],n_textures,first_bitmap_num[i], (i == 0) ? &current_robot_info : nullptr);
 
 		if (i==0)
 			current_robot_info.model_num = model_num;
@@ -1754,14 +2235,14 @@ void bm_read_reactor(void)
 	else
 		n_normal_bitmaps = N_ObjBitmapPtrs-first_bitmap_num;
 
-	model_num = load_polygon_model(model_name,n_normal_bitmaps,first_bitmap_num,NULL);
+	model_num = bm_load_polygon_model(model_name,n_normal_bitmaps,first_bitmap_num,NULL);
 
 #if defined(DXX_BUILD_DESCENT_I)
 	if (type == OL_CONTROL_CENTER)
 		read_model_guns(model_name, Reactors[0]);
 #endif
 	if ( model_name_dead )
-		Dead_modelnums[model_num]  = load_polygon_model(model_name_dead,N_ObjBitmapPtrs-first_bitmap_num_dead,first_bitmap_num_dead,NULL);
+		Dead_modelnums[model_num]  = bm_load_polygon_model(model_name_dead,N_ObjBitmapPtrs-first_bitmap_num_dead,first_bitmap_num_dead,NULL);
 	else
 		Dead_modelnums[model_num] = -1;
 
@@ -1821,7 +2302,7 @@ void bm_read_marker()
 
 	n_normal_bitmaps = N_ObjBitmapPtrs-first_bitmap_num;
 
-	Marker_model_num = load_polygon_model(model_name,n_normal_bitmaps,first_bitmap_num,NULL);
+	Marker_model_num = bm_load_polygon_model(model_name,n_normal_bitmaps,first_bitmap_num,NULL);
 }
 
 //read the exit model
@@ -1866,10 +2347,10 @@ void bm_read_exitmodel()
 	else
 		n_normal_bitmaps = N_ObjBitmapPtrs-first_bitmap_num;
 
-	model_num = load_polygon_model(model_name,n_normal_bitmaps,first_bitmap_num,NULL);
+	model_num = bm_load_polygon_model(model_name,n_normal_bitmaps,first_bitmap_num,NULL);
 
 	if ( model_name_dead )
-		Dead_modelnums[model_num]  = load_polygon_model(model_name_dead,N_ObjBitmapPtrs-first_bitmap_num_dead,first_bitmap_num_dead,NULL);
+		Dead_modelnums[model_num]  = bm_load_polygon_model(model_name_dead,N_ObjBitmapPtrs-first_bitmap_num_dead,first_bitmap_num_dead,NULL);
 	else
 		Dead_modelnums[model_num] = -1;
 
@@ -1990,9 +2471,9 @@ void bm_read_player_ship(void)
 		robot_info *pri = NULL;
 		if (i == 0)
 			pri = &ri;
-		model_num = load_polygon_model(model_name[i],n_textures,first_bitmap_num[i],pri);
+		model_num = bm_load_polygon_model(model_name[i],n_textures,first_bitmap_num[i],pri);
 #elif defined(DXX_BUILD_DESCENT_II)
-		model_num = load_polygon_model(model_name[i],n_textures,first_bitmap_num[i],(i==0) ? &ri : nullptr);
+		model_num = bm_load_polygon_model(model_name[i],n_textures,first_bitmap_num[i],(i==0) ? &ri : nullptr);
 #endif
 
 		if (i==0)
@@ -2005,7 +2486,7 @@ void bm_read_player_ship(void)
 
 	if ( model_name_dying ) {
 		Assert(n_models);
-		Dying_modelnums[Player_ship->model_num]  = load_polygon_model(model_name_dying,first_bitmap_num[1]-first_bitmap_num[0],first_bitmap_num[0],NULL);
+		Dying_modelnums[Player_ship->model_num]  = bm_load_polygon_model(model_name_dying,first_bitmap_num[1]-first_bitmap_num[0],first_bitmap_num[0],NULL);
 	}
 
 	Assert(ri.n_guns == N_PLAYER_GUNS);
@@ -2410,7 +2891,7 @@ void bm_read_weapon(int skip, int unused_flag)
 
 		n_textures = first_bitmap_num[i+1] - first_bitmap_num[i];
 
-		model_num = load_polygon_model(model_name[i],n_textures,first_bitmap_num[i],NULL);
+		model_num = bm_load_polygon_model(model_name[i],n_textures,first_bitmap_num[i],NULL);
 
 		if (i==0) {
 			Weapon_info[n].render_type = WEAPON_RENDER_POLYMODEL;
@@ -2424,7 +2905,7 @@ void bm_read_weapon(int skip, int unused_flag)
 
 	if ( pof_file_inner )	{
 		Assert(n_models);
-		Weapon_info[n].model_num_inner = load_polygon_model(pof_file_inner,first_bitmap_num[1]-first_bitmap_num[0],first_bitmap_num[0],NULL);
+		Weapon_info[n].model_num_inner = bm_load_polygon_model(pof_file_inner,first_bitmap_num[1]-first_bitmap_num[0],first_bitmap_num[0],NULL);
 	}
 }
 
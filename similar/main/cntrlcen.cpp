@@ -286,6 +286,7 @@ void do_controlcen_destroyed_stuff(const imobjptridx_t objp)
 
 	// And start the countdown stuff.
 	Control_center_destroyed = 1;
+	prepare_exit_tunnel();
 
 #if defined(DXX_BUILD_DESCENT_II)
 	// If a secret level, delete secret.sgc to indicate that we can't return to our secret level.
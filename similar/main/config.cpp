@@ -85,6 +85,7 @@ Cfg GameCfg;
 #if DXX_USE_ADLMIDI
 #define ADLMIDINumChipsStr	"ADLMIDI_NumberOfChips"
 #define ADLMIDIBankStr	"ADLMIDI_Bank"
+#define ADLMIDIEmulatorStr	"ADLMIDI_Emulator"
 #define ADLMIDIEnabledStr	"ADLMIDI_Enabled"
 #endif
 #define VSyncStr "VSync"
@@ -227,6 +228,8 @@ int ReadConfigFile()
 			convert_integer(CGameCfg.ADLMIDI_num_chips, value);
 		else if (cmp(lb, eq, ADLMIDIBankStr))
 			convert_integer(CGameCfg.ADLMIDI_bank, value);
+		else if (cmp(lb, eq, ADLMIDIEmulatorStr))
+			convert_integer(CGameCfg.ADLMIDI_emulator, value);
 		else if (cmp(lb, eq, ADLMIDIEnabledStr))
 			convert_integer(CGameCfg.ADLMIDI_enabled, value);
 #endif
@@ -292,6 +295,7 @@ int WriteConfigFile()
 #if DXX_USE_ADLMIDI
 	PHYSFSX_printf(infile, "%s=%i\n", ADLMIDINumChipsStr, CGameCfg.ADLMIDI_num_chips);
 	PHYSFSX_printf(infile, "%s=%i\n", ADLMIDIBankStr, CGameCfg.ADLMIDI_bank);
+	PHYSFSX_printf(infile, "%s=%i\n", ADLMIDIEmulatorStr, CGameCfg.ADLMIDI_emulator);
 	PHYSFSX_printf(infile, "%s=%i\n", ADLMIDIEnabledStr, CGameCfg.ADLMIDI_enabled);
 #endif
 	PHYSFSX_printf(infile, "%s=%i\n", VSyncStr, CGameCfg.VSync);
@@ -11,6 +11,7 @@
  */
 
 #include <algorithm>
+#include <atomic>
 #include <stdio.h>
 #include <stdlib.h>
 #include <stdarg.h>
@@ -30,6 +31,9 @@
 #include "timer.h"
 #include "cli.h"
 #include "cvar.h"
+#include "perf.h"
+#include "profile.h"
+#include "u_mem.h"
 
 #include "dxxsconf.h"
 #include "compiler-array.h"
@@ -61,22 +65,134 @@ enum con_state {
 	CON_STATE_OPEN = 2
 };
 
+#ifdef _WIN32
+typedef SYSTEMTIME con_timestamp;
+#else
+typedef struct timeval con_timestamp;
+#endif
+
+/* A line of con_buffer.  sequence is 0 while a thread writes the line
+ * and one more than the line's position in the log once it is complete,
+ * so readers can tell a finished line from one which is being replaced.
+ */
+struct console_ring_line : console_buffer
+{
+	std::atomic<uint32_t> sequence;
+	bool scrub;
+	con_timestamp time;
+};
+
+/* How many lines the renderer keeps measured.  More than it can show. */
+constexpr unsigned CON_DRAW_CACHE_LINES = 32;
+
+struct console_draw_line
+{
+	uint32_t sequence;
+	const grs_font *font;
+	int priority;
+	int w, h;
+	char line[CON_LINE_LENGTH];
+};
+
 static RAIIPHYSFS_File gamelog_fp;
-static array<console_buffer, CON_LINES_MAX> con_buffer;
+/* Any thread may add to con_buffer.  con_head hands out positions, and
+ * the line for position n lives in con_buffer[n % CON_LINES_MAX].
+ */
+static array<console_ring_line, CON_LINES_MAX> con_buffer;
+static std::atomic<uint32_t> con_head;
+/* While the log thread runs, it writes the lines from con_log_tail to
+ * con_head to the log in order.  A new line waits for it rather than
+ * overwrite a line it has not written.
+ */
+static std::atomic<uint32_t> con_log_tail;
+static SDL_Thread *con_log_thread;
+static SDL_sem *con_log_wake;
+static std::atomic<bool> con_log_quit;
+static array<console_draw_line, CON_DRAW_CACHE_LINES> con_draw_cache;
 static con_state con_state;
 static int con_scroll_offset, con_size;
 static void con_force_puts(con_priority priority, char *buffer, size_t len);
+static void con_print_file(const char *buffer, const con_timestamp &t);
 
-static void con_add_buffer_line(const con_priority priority, const char *const buffer, const size_t len)
+static void con_get_timestamp(con_timestamp &t)
 {
-	/* shift con_buffer for one line */
-	std::move(std::next(con_buffer.begin()), con_buffer.end(), con_buffer.begin());
-	console_buffer &c = con_buffer.back();
+#ifdef _WIN32
+	t = {};
+	GetLocalTime(&t);
+#else
+	if (gettimeofday(&t, nullptr))
+		t = {};
+#endif
+}
+
+static void con_scrub_markup(char *buffer);
+
+static void con_log_line(const console_ring_line &c)
+{
+	char buffer[CON_LINE_LENGTH];
+	strcpy(buffer, c.line);
+	if (c.scrub)
+		con_scrub_markup(buffer);
+	con_print_file(buffer, c.time);
+}
+
+static int con_log_worker(void *)
+{
+	for (;;)
+	{
+		SDL_SemWait(con_log_wake);
+		const bool quit = con_log_quit.load(std::memory_order_acquire);
+		auto tail = con_log_tail.load(std::memory_order_relaxed);
+		for (; tail != con_head.load(std::memory_order_acquire); ++tail)
+		{
+			auto &c = con_buffer[tail % CON_LINES_MAX];
+			/* Wait for the writer of this line to post again */
+			if (c.sequence.load(std::memory_order_acquire) != tail + 1)
+				break;
+			con_log_line(c);
+			con_log_tail.store(tail + 1, std::memory_order_release);
+		}
+		if (quit)
+			return 0;
+	}
+}
+
+/* Wait until the log thread has written every line up to position seq. */
+static void con_log_wait(const uint32_t seq)
+{
+	while (static_cast<int32_t>(con_log_tail.load(std::memory_order_acquire) - seq) <= 0)
+	{
+		SDL_SemPost(con_log_wake);
+		SDL_Delay(1);
+	}
+}
+
+static void con_add_buffer_line(const con_priority priority, const char *const buffer, const size_t len, const bool scrub)
+{
+	const auto seq = con_head.fetch_add(1, std::memory_order_relaxed);
+	const bool async = con_log_thread;
+	if (async)
+		con_log_wait(seq - CON_LINES_MAX);
+	console_ring_line &c = con_buffer[seq % CON_LINES_MAX];
+	c.sequence.store(0, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_release);
 	c.priority=priority;
+	c.scrub = scrub;
+	con_get_timestamp(c.time);
 
 	size_t copy = std::min(len, CON_LINE_LENGTH - 1);
 	c.line[copy] = 0;
 	memcpy(&c.line,buffer, copy);
+	c.sequence.store(seq + 1, std::memory_order_release);
+	if (!async)
+	{
+		con_log_line(c);
+		return;
+	}
+	SDL_SemPost(con_log_wake);
+	/* Do not lose the reason for a crash */
+	if (priority <= CON_URGENT)
+		con_log_wait(seq);
 }
 
 void (con_printf)(const con_priority_wrapper priority, const char *const fmt, ...)
@@ -115,7 +231,7 @@ static void con_scrub_markup(char *buffer)
 	*p2 = 0;
 }
 
-static void con_print_file(const char *const buffer)
+static void con_print_file(const char *const buffer, const con_timestamp &t)
 {
 	char buf[1024];
 #if !DXX_CONSOLE_SHOW_TIME_STDOUT
@@ -152,8 +268,7 @@ static void con_print_file(const char *const buffer)
 			tm_hour, tm_min, tm_sec;
 #ifdef _WIN32
 #define DXX_LF	"\r\n"
-		SYSTEMTIME st = {};
-		GetLocalTime(&st);
+		const SYSTEMTIME &st = t;
 #if DXX_CONSOLE_TIME_SHOW_YMD
 		tm_year = st.wYear;
 		tm_month = st.wMonth;
@@ -167,9 +282,7 @@ static void con_print_file(const char *const buffer)
 #endif
 #else
 #define DXX_LF	"\n"
-		struct timeval tv;
-		if (gettimeofday(&tv, nullptr))
-			tv = {};
+		const struct timeval &tv = t;
 		if (const auto lt = localtime(&tv.tv_sec))
 		{
 #if DXX_CONSOLE_TIME_SHOW_YMD
@@ -219,10 +332,8 @@ static void con_print_file(const char *const buffer)
  */
 static void con_force_puts(const con_priority priority, char *const buffer, const size_t len)
 {
-	con_add_buffer_line(priority, buffer, len);
-	con_scrub_markup(buffer);
-	/* Produce a sanitised version and send it to the console */
-	con_print_file(buffer);
+	/* The log gets a sanitised version */
+	con_add_buffer_line(priority, buffer, len, true);
 }
 
 void con_puts(const con_priority_wrapper priority, char *const buffer, const size_t len)
@@ -242,8 +353,7 @@ void con_puts(const con_priority_wrapper priority, const char *const buffer, con
 		typename con_priority_wrapper::scratch_buffer<CON_LINE_LENGTH> scratch_buffer;
 		auto &&b = priority.prepare_buffer(scratch_buffer, buffer, len);
 		/* add given string to con_buffer */
-		con_add_buffer_line(priority, b.first, b.second);
-		con_print_file(b.first);
+		con_add_buffer_line(priority, b.first, b.second, false);
 	}
 }
 
@@ -272,6 +382,36 @@ static color_t get_console_color_by_priority(int priority)
 	return gr_find_closest_color(r, g, b);
 }
 
+/* Lines only change when a new line replaces them, so keep the copy and
+ * the size the renderer measured.  Returns nullptr if another thread is
+ * replacing the line.
+ */
+static const console_draw_line *con_get_draw_line(const uint32_t seq, const grs_font &font)
+{
+	auto &d = con_draw_cache[seq % CON_DRAW_CACHE_LINES];
+	if (d.sequence == seq + 1 && d.font == &font)
+		return &d;
+	d.sequence = 0;
+	auto &c = con_buffer[seq % CON_LINES_MAX];
+	if (c.sequence.load(std::memory_order_acquire) != seq + 1)
+		return nullptr;
+	d.priority = c.priority;
+	strncpy(d.line, c.line, sizeof(d.line) - 1);
+	d.line[sizeof(d.line) - 1] = 0;
+	std::atomic_thread_fence(std::memory_order_acquire);
+	if (c.sequence.load(std::memory_order_relaxed) != seq + 1)
+		return nullptr;
+	gr_get_string_size(font, d.line, &d.w, &d.h, nullptr);
+	d.font = &font;
+	d.sequence = seq + 1;
+	return &d;
+}
+
+static unsigned con_lines_available()
+{
+	return std::min<uint32_t>(con_head.load(std::memory_order_acquire), CON_LINES_MAX);
+}
+
 static void con_draw(void)
 {
 	int i = 0, y = 0;
@@ -297,18 +437,17 @@ static void con_draw(void)
 
 	const auto &&fspacx = FSPACX();
 	const auto &&fspacx1 = fspacx(1);
-	for (;;)
+	const auto head = con_head.load(std::memory_order_acquire);
+	const auto available = std::min<uint32_t>(head, CON_LINES_MAX);
+	/* Only the lines which fit on the screen are copied and measured */
+	for (; y > 0 && static_cast<unsigned>(i) < available; ++i)
 	{
-		auto &b = con_buffer[CON_LINES_MAX - 1 - i];
-		gr_set_fontcolor(canvas, get_console_color_by_priority(b.priority), -1);
-		int w,h;
-		gr_get_string_size(game_font, b.line, &w, &h, nullptr);
-		y -= h + fspacy1;
-		gr_string(canvas, game_font, fspacx1, y, b.line, w, h);
-		i++;
-
-		if (y<=0 || CON_LINES_MAX-1-i <= 0 || i < 0)
-			break;
+		const auto b = con_get_draw_line(head - 1 - i, game_font);
+		if (!b)
+			continue;
+		gr_set_fontcolor(canvas, get_console_color_by_priority(b->priority), -1);
+		y -= b->h + fspacy1;
+		gr_string(canvas, game_font, fspacx1, y, b->line, b->w, b->h);
 	}
 	gr_rect(canvas, 0, 0, SWIDTH, line_spacing, color);
 	gr_set_fontcolor(canvas, BM_XRGB(255, 255, 255),-1);
@@ -353,10 +492,11 @@ static window_event_result con_handler(window *wind,const d_event &event, const
 					break;
 				case KEY_PAGEUP:
 					con_scroll_offset+=CON_SCROLL_OFFSET;
-					if (con_scroll_offset >= CON_LINES_MAX-1)
-						con_scroll_offset = CON_LINES_MAX-1;
-					while (con_buffer[CON_LINES_MAX-1-con_scroll_offset].line[0]=='\0')
-						con_scroll_offset--;
+					{
+						const int available = con_lines_available();
+						if (con_scroll_offset >= available)
+							con_scroll_offset = available ? available - 1 : 0;
+					}
 					break;
 				case KEY_PAGEDOWN:
 					con_scroll_offset-=CON_SCROLL_OFFSET;
@@ -438,16 +578,57 @@ void con_showup(void)
 	}
 }
 
+static void con_close()
+{
+	if (!con_log_thread)
+		return;
+	con_log_quit.store(true, std::memory_order_release);
+	SDL_SemPost(con_log_wake);
+	SDL_WaitThread(con_log_thread, nullptr);
+	con_log_thread = nullptr;
+	SDL_DestroySemaphore(con_log_wake);
+	con_log_wake = nullptr;
+}
+
+/* Writing the log on its own thread keeps verbose logging from stalling
+ * the game.  -safelog writes each line before con_puts returns, so that
+ * it keeps working when the program crashes.
+ */
+static void con_start_log_thread()
+{
+	con_log_wake = SDL_CreateSemaphore(0);
+	if (!con_log_wake)
+		return;
+	con_log_tail.store(con_head.load(std::memory_order_relaxed), std::memory_order_relaxed);
+#if SDL_MAJOR_VERSION == 2
+	con_log_thread = SDL_CreateThread(con_log_worker, "console_log", nullptr);
+#else
+	con_log_thread = SDL_CreateThread(con_log_worker, nullptr);
+#endif
+	if (!con_log_thread)
+	{
+		SDL_DestroySemaphore(con_log_wake);
+		con_log_wake = nullptr;
+		return;
+	}
+	atexit(con_close);
+}
+
 void con_init(void)
 {
-	con_buffer = {};
 	if (CGameArg.DbgSafelog)
 		gamelog_fp.reset(PHYSFS_openWrite("gamelog.txt"));
 	else
+	{
 		gamelog_fp = PHYSFSX_openWriteBuffered("gamelog.txt");
+		con_start_log_thread();
+	}
 
 	cli_init();
 	cmd_init();
 	cvar_init();
+	profile_init();
+	mem_account_init();
+	perf_init();
 
 }
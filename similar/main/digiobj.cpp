@@ -19,7 +19,9 @@ COPYRIGHT 1993-1999 PARALLAX SOFTWARE CORPORATION.  ALL RIGHTS RESERVED.
 
 
 #include <algorithm>
+#include <climits>
 #include <stdexcept>
+#include <vector>
 #include <stdlib.h>
 #include <stdio.h>
 #include <fcntl.h>
@@ -61,6 +63,13 @@ constexpr std::integral_constant<unsigned, 32> SOF_PERMANENT{};		// Part of the
 
 constexpr std::integral_constant<int, -1> RAIIdigi_sound::invalid_channel;
 constexpr std::integral_constant<unsigned, 150> MAX_SOUND_OBJECTS{};
+// find_connected_distance never searches deeper than this
+constexpr std::integral_constant<unsigned, 62> MAX_SOUND_SEARCH_DEPTH{};
+/* Channels which looping sound objects may hold.  The rest are kept for
+ * sounds which play once, so that those are not lost to a level full of
+ * hums and forcefields.
+ */
+constexpr std::integral_constant<unsigned, digi_max_channels - 16> MAX_SOUND_OBJECT_VOICES{};
 
 struct sound_object
 {
@@ -177,7 +186,15 @@ static int digi_unxlat_sound(int soundno)
 	throw std::invalid_argument("sound not loaded");
 }
 
-static void digi_get_sound_loc(const vms_matrix &listener, const vms_vector &listener_pos, const vcsegptridx_t listener_seg, const vms_vector &sound_pos, const vcsegptridx_t sound_seg, fix max_volume, int *volume, int *pan, vm_distance max_distance)
+static int sound_search_depth(vm_distance max_distance)
+{
+	max_distance = (max_distance*5)/4;		// Make all sounds travel 1.25 times as far.
+	const int num_search_segs = f2i(max_distance/20);
+	return num_search_segs < 1 ? 1 : num_search_segs;
+}
+
+template <typename F>
+static void digi_get_sound_loc(const vms_matrix &listener, const vms_vector &listener_pos, const vms_vector &sound_pos, fix max_volume, int *volume, int *pan, vm_distance max_distance, F &&path_distance_fn)
 {
 
 	vms_vector	vector_to_sound;
@@ -191,10 +208,7 @@ static void digi_get_sound_loc(const vms_matrix &listener, const vms_vector &lis
 	auto distance = vm_vec_normalized_dir_quick( vector_to_sound, sound_pos, listener_pos );
 
 	if (distance < max_distance )	{
-		int num_search_segs = f2i(max_distance/20);
-		if ( num_search_segs < 1 ) num_search_segs = 1;
-
-		auto path_distance = find_connected_distance(listener_pos, listener_seg, sound_pos, sound_seg, num_search_segs, WID_RENDPAST_FLAG|WID_FLY_FLAG);
+		const auto path_distance = path_distance_fn();
 		if ( path_distance > -1 )	{
 			*volume = max_volume - fixdiv(path_distance,max_distance);
 			if (*volume > 0 )	{
@@ -210,6 +224,15 @@ static void digi_get_sound_loc(const vms_matrix &listener, const vms_vector &lis
 
 }
 
+static vm_distance sound_path_distance(const vms_vector &listener_pos, vcsegptridx_t listener_seg, const vms_vector &sound_pos, vcsegptridx_t sound_seg, unsigned depth);
+
+static void digi_get_sound_loc(const vms_matrix &listener, const vms_vector &listener_pos, const vcsegptridx_t listener_seg, const vms_vector &sound_pos, const vcsegptridx_t sound_seg, fix max_volume, int *volume, int *pan, vm_distance max_distance)
+{
+	digi_get_sound_loc(listener, listener_pos, sound_pos, max_volume, volume, pan, max_distance, [&]{
+		return sound_path_distance(listener_pos, listener_seg, sound_pos, sound_seg, sound_search_depth(max_distance));
+	});
+}
+
 void digi_play_sample_once( int soundno, fix max_volume )
 {
 	if ( Newdemo_state == ND_STATE_RECORDING )
@@ -255,10 +278,12 @@ void digi_play_sample_3d(int soundno, int angle, int volume)
 static void SoundQ_init();
 static void SoundQ_process();
 static void SoundQ_pause();
+static void sound_paths_reset();
 
 void digi_init_sounds()
 {
 	SoundQ_init();
+	sound_paths_reset();
 
 	digi_stop_all_channels();
 
@@ -351,10 +376,6 @@ static void digi_start_sound_object(sound_object &s)
 		return;
 #endif
 
-	// only use up to half the sound channels for "permanent" sounts
-	if ((s.flags & SOF_PERMANENT) && (N_active_sound_objects >= max(1, digi_max_channels / 4)))
-		return;
-
 	// start the sample playing
 
 	s.channel = digi_start_sound( s.soundnum,
@@ -412,6 +433,7 @@ void digi_link_sound_to_object3(const unsigned org_soundnum, const vcobjptridx_t
 
 	if (soundnum < 0)
 		return;
+	piggy_sound_page_in(soundnum);
 	if (GameSounds[soundnum].data==NULL) {
 		Int3();
 		return;
@@ -457,6 +479,7 @@ static void digi_link_sound_to_pos2(fvcobjptr &vcobjptr, const int org_soundnum,
 
 	if (soundnum < 0)
 		return;
+	piggy_sound_page_in(soundnum);
 	if (GameSounds[soundnum].data==NULL) {
 		Int3();
 		return;
@@ -529,6 +552,296 @@ static void digi_record_sound_objects()
 	}
 }
 
+namespace {
+
+/* Breadth first search from the listener's segment, shared by every
+ * sound which digi_sync_sounds updates or which starts playing.  The
+ * queue order matches find_connected_distance, so a lookup returns what
+ * that function would compute for the same pair of points.
+ *
+ * The search runs over a graph built once per level, which holds each
+ * segment's centre and the centre-to-centre length through each side.
+ * Its result is kept until the listener changes segment, a sound needs
+ * a deeper search, or a wall starts or stops letting sound through.
+ */
+struct sound_path_field
+{
+	struct segment_record
+	{
+		unsigned stamp;
+		unsigned depth;
+		int queue_index;
+		segnum_t parent, first_hop;
+		vm_distance inner;
+		// From the centre of parent to the centre of this segment
+		vm_distance edge;
+	};
+	unsigned stamp;
+	unsigned max_depth;
+	segnum_t listener_seg;
+	bool valid;
+	std::vector<segment_record> segments;
+	std::vector<segnum_t> queue;
+	std::vector<vms_vector> centers;
+	std::vector<array<vm_distance, MAX_SIDES_PER_SEGMENT>> side_lengths;
+	// Whether each wall let sound through when last checked
+	std::vector<uint8_t> wall_passable;
+	/* For each depth, the queue index of the segment which first
+	 * enqueued a segment at that depth.
+	 */
+	array<int, MAX_SOUND_SEARCH_DEPTH + 1> first_parent;
+	void reset()
+	{
+		valid = false;
+		centers.clear();
+		side_lengths.clear();
+		wall_passable.clear();
+	}
+	void build_graph();
+	bool walls_changed();
+	bool covers(const segnum_t seg0, const unsigned depth) const
+	{
+		return valid && listener_seg == seg0 && depth <= max_depth;
+	}
+	void update(vcsegptridx_t seg0, unsigned max_depth);
+	void build(const vcsegptridx_t seg0, unsigned max_depth);
+	vm_distance distance(const vms_vector &p0, const vms_vector &p1, vcsegptridx_t seg1, unsigned max_depth) const;
+};
+
+static sound_path_field Sound_paths;
+
+void sound_path_field::build_graph()
+{
+	auto &Vertices = LevelSharedVertexState.get_vertices();
+	auto &vcvertptr = Vertices.vcptr;
+	const std::size_t nsegs = Highest_segment_index + 1;
+	centers.resize(nsegs);
+	side_lengths.resize(nsegs);
+	for (segnum_t i = 0; i != nsegs; ++i)
+		compute_segment_center(vcvertptr, centers[i], vcsegptr(i));
+	for (segnum_t i = 0; i != nsegs; ++i)
+	{
+		auto &segp = *vcsegptr(i);
+		auto &lengths = side_lengths[i];
+		for (unsigned sidenum = 0; sidenum != MAX_SIDES_PER_SEGMENT; ++sidenum)
+		{
+			const auto child = segp.children[sidenum];
+			lengths[sidenum] = IS_CHILD(child) ? vm_vec_dist_quick(centers[child], centers[i]) : vm_distance{};
+		}
+	}
+}
+
+/* Doors, blastable and illusory walls, cloaking walls and the textures
+ * which decide transparency all change through different paths, so
+ * compare every wall's effect on sound rather than track each of them.
+ */
+bool sound_path_field::walls_changed()
+{
+	auto &Walls = LevelUniqueWallSubsystemState.Walls;
+	auto &vcwallptr = Walls.vcptr;
+	const unsigned count = Walls.get_count();
+	bool changed = wall_passable.size() != count;
+	wall_passable.resize(count);
+	for (unsigned i = 0; i != count; ++i)
+	{
+		auto &w = *vcwallptr(static_cast<wallnum_t>(i));
+		uint8_t passable = 0;
+		if (w.segnum != segment_none)
+		{
+			auto &segp = *vcsegptr(w.segnum);
+			passable = (WALL_IS_DOORWAY(GameBitmaps, Textures, vcwallptr, segp, segp, w.sidenum) & (WID_RENDPAST_FLAG|WID_FLY_FLAG)) ? 1 : 0;
+		}
+		if (wall_passable[i] != passable)
+		{
+			wall_passable[i] = passable;
+			changed = true;
+		}
+	}
+	return changed;
+}
+
+void sound_path_field::update(const vcsegptridx_t seg0, const unsigned depth_limit)
+{
+	if (centers.size() != static_cast<std::size_t>(Highest_segment_index + 1))
+	{
+		build_graph();
+		valid = false;
+	}
+	if (walls_changed())
+		valid = false;
+	if (covers(seg0, depth_limit))
+		return;
+	build(seg0, depth_limit);
+	valid = true;
+}
+
+void sound_path_field::build(const vcsegptridx_t seg0, const unsigned depth_limit)
+{
+	auto &Walls = LevelUniqueWallSubsystemState.Walls;
+	auto &vcwallptr = Walls.vcptr;
+	const std::size_t nsegs = Highest_segment_index + 1;
+	if (segments.size() != nsegs)
+	{
+		segments.assign(nsegs, {});
+		stamp = 0;
+	}
+	if (!++stamp)
+	{
+		range_for (auto &r, segments)
+			r.stamp = 0;
+		stamp = 1;
+	}
+	max_depth = depth_limit;
+	listener_seg = seg0;
+	first_parent.fill(INT_MAX);
+	queue.clear();
+	{
+		auto &r = segments[seg0];
+		r.stamp = stamp;
+		r.depth = 0;
+		r.queue_index = -1;
+		r.parent = r.first_hop = seg0;
+		r.inner = {};
+		r.edge = {};
+	}
+	const auto wid_flag = WID_RENDPAST_FLAG|WID_FLY_FLAG;
+	for (int qhead = -1; qhead < static_cast<int>(queue.size()); ++qhead)
+	{
+		const segnum_t cur_seg = qhead < 0 ? static_cast<segnum_t>(seg0) : queue[qhead];
+		const auto &cur = segments[cur_seg];
+		const auto cur_depth = cur.depth;
+		if (cur_depth >= depth_limit)
+			continue;
+		const auto cur_inner = cur_depth >= 2
+			? cur.inner + cur.edge
+			: vm_distance{};
+		const auto cur_first_hop = cur.first_hop;
+		auto &segp = *vcsegptr(cur_seg);
+		for (unsigned sidenum = 0; sidenum != MAX_SIDES_PER_SEGMENT; ++sidenum)
+		{
+			const auto this_seg = segp.children[sidenum];
+			if (!IS_CHILD(this_seg))
+				continue;
+			if (!(WALL_IS_DOORWAY(GameBitmaps, Textures, vcwallptr, segp, segp, sidenum) & wid_flag))
+				continue;
+			auto &r = segments[this_seg];
+			if (r.stamp == stamp)
+				continue;
+			auto &fp = first_parent[cur_depth + 1];
+			if (fp == INT_MAX)
+				fp = qhead;
+			r.stamp = stamp;
+			r.depth = cur_depth + 1;
+			r.queue_index = queue.size();
+			r.parent = cur_seg;
+			r.first_hop = cur_depth ? cur_first_hop : this_seg;
+			r.inner = cur_inner;
+			r.edge = side_lengths[cur_seg][sidenum];
+			queue.emplace_back(this_seg);
+		}
+	}
+}
+
+vm_distance sound_path_field::distance(const vms_vector &p0, const vms_vector &p1, const vcsegptridx_t seg1, unsigned depth) const
+{
+	if (seg1 == listener_seg)
+		return vm_vec_dist_quick(p0, p1);
+#if defined(DXX_BUILD_DESCENT_II)
+	{
+		auto &Walls = LevelUniqueWallSubsystemState.Walls;
+		auto &vcwallptr = Walls.vcptr;
+		const auto conn_side = find_connect_side(listener_seg, seg1);
+		if (conn_side != side_none && (WALL_IS_DOORWAY(GameBitmaps, Textures, vcwallptr, seg1, seg1, conn_side) & (WID_RENDPAST_FLAG|WID_FLY_FLAG)))
+			return vm_vec_dist_quick(p0, p1);
+	}
+#else
+	if (find_connect_side(listener_seg, seg1) != side_none)
+		return vm_vec_dist_quick(p0, p1);
+#endif
+	if (depth > MAX_SOUND_SEARCH_DEPTH)
+		depth = MAX_SOUND_SEARCH_DEPTH;
+	assert(depth <= max_depth);
+	const auto &r = segments[seg1];
+	/* find_connected_distance gives up as soon as it enqueues a segment
+	 * at the depth limit, even if the goal is already in the queue.
+	 */
+	if (r.stamp != stamp || r.depth > depth || first_parent[depth] < r.queue_index)
+		return vm_distance{-1};
+	return vm_vec_dist_quick(p1, centers[r.parent]) + vm_vec_dist_quick(p0, centers[r.first_hop]) + r.inner;
+}
+
+}
+
+static void sound_paths_reset()
+{
+	Sound_paths.reset();
+}
+
+/* For a sound which starts playing: look the distance up if the last
+ * search still holds, and search only if it does not.
+ */
+static vm_distance sound_path_distance(const vms_vector &listener_pos, const vcsegptridx_t listener_seg, const vms_vector &sound_pos, const vcsegptridx_t sound_seg, const unsigned depth)
+{
+	auto &p = Sound_paths;
+	if (p.covers(listener_seg, std::min<unsigned>(depth, MAX_SOUND_SEARCH_DEPTH)) && !p.walls_changed())
+		return p.distance(listener_pos, sound_pos, sound_seg, depth);
+	p.valid = false;
+	return find_connected_distance(listener_pos, listener_seg, sound_pos, sound_seg, depth, WID_RENDPAST_FLAG|WID_FLY_FLAG);
+}
+
+/* Looping sound objects keep their volume and pan whether or not they
+ * hold a channel.  Bind the loudest of them to channels, and take the
+ * channels of the rest, so that inaudible loops do not hold voices that
+ * louder ones need.  A sound which holds a channel ranks an eighth
+ * louder, so that two sounds of about the same volume do not trade the
+ * channel back and forth.
+ */
+static void digi_sync_voices()
+{
+	array<sound_object *, MAX_SOUND_OBJECTS> candidates;
+	unsigned n = 0, once = 0;
+	range_for (auto &s, SoundObjects)
+	{
+		if (!(s.flags & SOF_USED))
+			continue;
+		if (!(s.flags & SOF_PLAY_FOREVER))
+		{
+			if (s.channel > -1)
+				++once;
+		}
+		else if (s.volume > 0)
+			candidates[n++] = &s;
+	}
+	const unsigned voices = MAX_SOUND_OBJECT_VOICES > once ? MAX_SOUND_OBJECT_VOICES - once : 0;
+	const auto begin = candidates.begin(), end = begin + n;
+	auto bound = end;
+	if (n > voices)
+	{
+		bound = begin + voices;
+		const auto rank = [](const sound_object *const s) {
+			return s->channel > -1 ? s->volume + s->volume / 8 : s->volume;
+		};
+		std::nth_element(begin, bound, end, [&rank](const sound_object *const a, const sound_object *const b) {
+			return rank(a) > rank(b);
+		});
+		// Free the channels first, so that the sounds which replace them can start
+		for (auto i = bound; i != end; ++i)
+		{
+			const auto s = *i;
+			const auto c = s->channel;
+			if (c > -1)
+			{
+				s->channel = -1;
+				digi_stop_sound(c);
+				N_active_sound_objects--;
+			}
+		}
+	}
+	for (auto i = begin; i != bound; ++i)
+		if ((*i)->channel < 0)
+			digi_start_sound_object(**i);
+}
+
 static int was_recording = 0;
 
 void digi_sync_sounds()
@@ -548,6 +861,15 @@ void digi_sync_sounds()
 	if (!Viewer)
 		return;
 	const auto &&viewer = vcobjptr(Viewer);
+	const auto &&viewer_seg = vcsegptridx(viewer->segnum);
+	{
+		unsigned depth = 0;
+		range_for (auto &s, SoundObjects)
+			if (s.flags & (SOF_LINK_TO_POS | SOF_LINK_TO_OBJ))
+				depth = std::max<unsigned>(depth, sound_search_depth(s.max_distance));
+		if (depth)
+			Sound_paths.update(viewer_seg, std::min<unsigned>(depth, MAX_SOUND_SEARCH_DEPTH));
+	}
 	range_for (auto &s, SoundObjects)
 	{
 		if (s.flags & SOF_USED)
@@ -568,8 +890,10 @@ void digi_sync_sounds()
 			}
 
 			if ( s.flags & SOF_LINK_TO_POS )	{
-				digi_get_sound_loc(viewer->orient, viewer->pos, vcsegptridx(viewer->segnum), s.link_type.pos.position, vcsegptridx(s.link_type.pos.segnum), s.max_volume,
-                                &s.volume, &s.pan, s.max_distance );
+				const auto &sound_pos = s.link_type.pos.position;
+				digi_get_sound_loc(viewer->orient, viewer->pos, sound_pos, s.max_volume, &s.volume, &s.pan, s.max_distance, [&]{
+					return Sound_paths.distance(viewer->pos, sound_pos, vcsegptridx(s.link_type.pos.segnum), sound_search_depth(s.max_distance));
+				});
 
 			} else if ( s.flags & SOF_LINK_TO_OBJ )	{
 				const auto objp = [&s]{
@@ -593,8 +917,9 @@ void digi_sync_sounds()
 					s.flags = 0;	// Mark as dead, so some other sound can use this sound
 					continue;		// Go on to next sound...
 				} else {
-					digi_get_sound_loc(viewer->orient, viewer->pos, vcsegptridx(viewer->segnum), objp->pos, vcsegptridx(objp->segnum), s.max_volume,
-                                   &s.volume, &s.pan, s.max_distance );
+					digi_get_sound_loc(viewer->orient, viewer->pos, objp->pos, s.max_volume, &s.volume, &s.pan, s.max_distance, [&]{
+						return Sound_paths.distance(viewer->pos, objp->pos, vcsegptridx(objp->segnum), sound_search_depth(s.max_distance));
+					});
 				}
 			}
 
@@ -619,11 +944,9 @@ void digi_sync_sounds()
 					}
 
 				} else {
-					if (s.channel<0)	{
-						digi_start_sound_object(s);
-					} else {
+					// A looping sound without a channel is left to digi_sync_voices
+					if (s.channel > -1)
 						digi_set_channel_volume( s.channel, s.volume );
-					}
 				}
 			}
 
@@ -634,6 +957,7 @@ void digi_sync_sounds()
 
 		}
 	}
+	digi_sync_voices();
 }
 
 void digi_pause_digi_sounds()
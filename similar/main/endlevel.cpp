@@ -41,6 +41,8 @@ COPYRIGHT 1993-1999 PARALLAX SOFTWARE CORPORATION.  ALL RIGHTS RESERVED.
 #include "palette.h"
 #include "iff.h"
 #include "console.h"
+#include "profile.h"
+#include "level_arena.h"
 #include "texmap.h"
 #include "fvi.h"
 #include "u_mem.h"
@@ -128,6 +130,58 @@ int Endlevel_sequence = 0;
 
 static segnum_t transition_segnum;
 segnum_t exit_segnum;
+static unsigned exit_sidenum;
+static int endlevel_data_loaded;
+
+namespace {
+
+/* The exit tunnel, walked back from the exit segment when the reactor is
+ * destroyed.  Entry k is the segment k steps before the exit segment,
+ * which is left through exit_side and entered from prev_segnum (the
+ * entry k + 1).  The escape then only looks segments up here.
+ */
+struct exit_tunnel_segment
+{
+	segnum_t segnum, prev_segnum;
+	unsigned exit_side;
+	vms_vector center, exit_point, next_center;
+};
+
+static level_arena_vector<exit_tunnel_segment> Exit_tunnel;
+
+/* The bitmaps named by the last endlevel file.  Most levels of a mission
+ * name the same files, so a file is only decoded again when the name, the
+ * file it resolves to, or the palette the bitmaps were remapped to
+ * changes.
+ */
+struct endlevel_file_cache
+{
+	std::string terrain, height, satellite;
+	palette_array_t palette;
+};
+
+static endlevel_file_cache Endlevel_file_cache;
+
+}
+
+static std::string endlevel_file_key(const char *const filename)
+{
+	std::string key(filename);
+	for (auto &c : key)
+		c = tolower(static_cast<unsigned char>(c));
+	key += '\0';
+	if (const auto realdir = PHYSFS_getRealDir(filename))
+		key += realdir;
+	return key;
+}
+
+static const exit_tunnel_segment *find_exit_tunnel_segment(const vcsegidx_t segnum, const vcsegidx_t prev_segnum)
+{
+	const auto i = std::find_if(Exit_tunnel.begin(), Exit_tunnel.end(), [segnum](const exit_tunnel_segment &t) {
+		return t.segnum == segnum;
+	});
+	return i != Exit_tunnel.end() && i->prev_segnum == prev_segnum ? &*i : nullptr;
+}
 
 static object *endlevel_camera;
 
@@ -236,6 +290,48 @@ void free_endlevel_data()
 
 	free_light_table();
 	free_height_array();
+	Endlevel_file_cache = {};
+}
+
+void prepare_exit_tunnel()
+{
+	Exit_tunnel = level_arena_vector<exit_tunnel_segment>();
+	if (!endlevel_data_loaded || exit_segnum == segment_none)
+		return;
+	auto &Vertices = LevelSharedVertexState.get_vertices();
+	auto &vcvertptr = Vertices.vcptr;
+	std::vector<bool> visited(Highest_segment_index + 1);
+	auto segp = vcsegptridx(exit_segnum);
+	unsigned exit_side = exit_sidenum;
+	for (;;)
+	{
+		visited[segp] = true;
+		const auto prev = segp->children[Side_opposite[exit_side]];
+		exit_tunnel_segment t;
+		t.segnum = segp;
+		t.prev_segnum = IS_CHILD(prev) ? prev : segment_none;
+		t.exit_side = exit_side;
+		compute_segment_center(vcvertptr, t.center, segp);
+		compute_center_point_on_side(vcvertptr, t.exit_point, segp, exit_side);
+		const auto next = segp->children[exit_side];
+		t.next_center = next == segment_exit ? t.exit_point : compute_segment_center(vcvertptr, vcsegptr(next));
+		Exit_tunnel.emplace_back(t);
+		if (!IS_CHILD(prev) || visited[prev])
+			break;
+		//	The escape walks each segment out through the side opposite
+		//	the first side joining it to the one before.
+		if (matt_find_connect_side(segp, prev) != Side_opposite[exit_side])
+		{
+			Exit_tunnel.back().prev_segnum = segment_none;
+			break;
+		}
+		const auto &&prevp = vcsegptridx(prev);
+		const auto connect_side = matt_find_connect_side(prevp, segp);
+		if (connect_side >= MAX_SIDES_PER_SEGMENT)
+			break;
+		segp = prevp;
+		exit_side = connect_side;
+	}
 }
 
 static object *external_explosion;
@@ -245,7 +341,6 @@ static vms_angvec exit_angles={-0xa00,0,0};
 
 vms_matrix surface_orient;
 
-static int endlevel_data_loaded;
 
 namespace dsx {
 window_event_result start_endlevel_sequence()
@@ -272,6 +367,8 @@ window_event_result start_endlevel_sequence()
 		(ConsoleObject->flags & OF_SHOULD_BE_DEAD))
 		return window_event_result::ignored;				//don't start if dead!
 	con_puts(CON_NORMAL, "You have escaped the mine!");
+	//	Read the next level while the flythrough and score screens run.
+	read_ahead_next_level();
 
 #if defined(DXX_BUILD_DESCENT_II)
 	auto &Robot_info = LevelSharedRobotInfoState.Robot_info;
@@ -333,47 +430,61 @@ window_event_result start_endlevel_sequence()
 		const auto exit_console_side = find_exit_side(console);
 		auto old_segnum = vcsegptridx(console.segnum);
 		auto child = old_segnum->children[exit_console_side];
-		unsigned tunnel_length = 0;
-		for (;;)
+		//	If the way out is the tunnel found when the reactor blew,
+		//	the segment counts are already known.
+		if (const auto t = IS_CHILD(child) ? find_exit_tunnel_segment(child, old_segnum) : nullptr)
 		{
-			if (child == segment_none)
+			const std::size_t k = t - Exit_tunnel.data();
+			const auto tunnel_length = k + 2;
+			transition_segnum = Exit_tunnel[k - tunnel_length / 3].segnum;
+#ifndef NDEBUG
+			last_segnum = exit_segnum;
+#endif
+		}
+		else
+		{
+			unsigned tunnel_length = 0;
+			for (;;)
 			{
-				return PlayerFinishedLevel(0);		//don't do special sequence
+				if (child == segment_none)
+				{
+					return PlayerFinishedLevel(0);		//don't do special sequence
+				}
+				tunnel_length++;
+				if (child == segment_exit)
+					break;
+				const auto segnum = vcsegptridx(child);
+				const auto entry_side = matt_find_connect_side(segnum, old_segnum);
+				const auto exit_side = Side_opposite[entry_side];
+				old_segnum = segnum;
+				child = segnum->children[exit_side];
 			}
-			tunnel_length++;
-			if (child == segment_exit)
-				break;
-			const auto segnum = vcsegptridx(child);
-			const auto entry_side = matt_find_connect_side(segnum, old_segnum);
-			const auto exit_side = Side_opposite[entry_side];
-			old_segnum = segnum;
-			child = segnum->children[exit_side];
-		}
 #ifndef NDEBUG
-		last_segnum = old_segnum;
+			last_segnum = old_segnum;
 #endif
-		//now pick transition segnum 1/3 of the way in
+			//now pick transition segnum 1/3 of the way in
 
-		old_segnum = vcsegptridx(console.segnum);
-		child = old_segnum->children[exit_console_side];
-		for (auto i = tunnel_length / 3; i; --i)
-		{
-			/*
-			 * No sanity checks here.  If the tunnel ended with
-			 * segment_none, the function would have returned from the
-			 * prior loop.  If the tunnel ended with segment_exit, then
-			 * tunnel_length is the count of segments to reach the exit.
-			 * The termination condition on this loop quits at
-			 * (tunnel_length / 3), so the loop will quit before it
-			 * reaches segment_exit.
-			 */
-			auto segnum = vcsegptridx(child);
-			const auto entry_side = matt_find_connect_side(segnum, old_segnum);
-			const auto exit_side = Side_opposite[entry_side];
-			old_segnum = segnum;
-			child = segnum->children[exit_side];
+			old_segnum = vcsegptridx(console.segnum);
+			child = old_segnum->children[exit_console_side];
+			for (auto i = tunnel_length / 3; i; --i)
+			{
+				/*
+				 * No sanity checks here.  If the tunnel ended with
+				 * segment_none, the function would have returned from the
+				 * prior loop.  If the tunnel ended with segment_exit, then
+				 * tunnel_length is the count of segments to reach the exit.
+				 * The termination condition on this loop quits at
+				 * (tunnel_length / 3), so the loop will quit before it
+				 * reaches segment_exit.
+				 */
+				auto segnum = vcsegptridx(child);
+				const auto entry_side = matt_find_connect_side(segnum, old_segnum);
+				const auto exit_side = Side_opposite[entry_side];
+				old_segnum = segnum;
+				child = segnum->children[exit_side];
+			}
+			transition_segnum = child;
 		}
-		transition_segnum = child;
 	}
 
 	if (Game_mode & GM_MULTI) {
@@ -1173,8 +1284,14 @@ void do_endlevel_flythrough(flythrough_data *flydata)
 		//where we are heading (center of exit_side)
 		auto &Vertices = LevelSharedVertexState.get_vertices();
 		auto &vcvertptr = Vertices.vcptr;
-		auto dest_point = compute_center_point_on_side(vcvertptr, pseg, exit_side);
-		const vms_vector nextcenter = (pseg.children[exit_side] == segment_exit)
+		//	In the tunnel found when the reactor blew, the points are known.
+		auto tunnel = flydata->first_time ? nullptr : find_exit_tunnel_segment(obj->segnum, old_player_seg);
+		if (tunnel && tunnel->exit_side != static_cast<unsigned>(exit_side))
+			tunnel = nullptr;
+		auto dest_point = tunnel ? tunnel->exit_point : compute_center_point_on_side(vcvertptr, pseg, exit_side);
+		const vms_vector nextcenter = tunnel
+			? tunnel->next_center
+			: (pseg.children[exit_side] == segment_exit)
 			? dest_point
 			: compute_segment_center(vcvertptr, vcsegptr(pseg.children[exit_side]));
 
@@ -1211,7 +1328,7 @@ void do_endlevel_flythrough(flythrough_data *flydata)
 		auto step_size = vm_vec_normalize_quick(flydata->step);
 		vm_vec_scale(flydata->step,flydata->speed);
 
-		const auto curcenter = compute_segment_center(vcvertptr, pseg);
+		const auto curcenter = tunnel ? tunnel->center : compute_segment_center(vcvertptr, pseg);
 		vm_vec_sub(flydata->headvec,nextcenter,curcenter);
 
 		const auto dest_orient = vm_vector_2_matrix(flydata->headvec,&pseg.shared_segment::sides[up_side].normals[0],nullptr);
@@ -1265,6 +1382,7 @@ static int convert_ext(d_fname &dest, const char (&ext)[4])
 namespace dsx {
 void load_endlevel_data(int level_num)
 {
+	const trace_scope trace_phase("load_endlevel_data");
 	d_fname filename;
 	char *p;
 	int var;
@@ -1272,6 +1390,15 @@ void load_endlevel_data(int level_num)
 	int have_binary = 0;
 
 	endlevel_data_loaded = 0;		//not loaded yet
+	Exit_tunnel = level_arena_vector<exit_tunnel_segment>();
+
+	auto &cache = Endlevel_file_cache;
+	if (cache.palette != gr_palette)
+	{
+		cache.terrain.clear();
+		cache.satellite.clear();
+		cache.palette = gr_palette;
+	}
 
 try_again:
 	;
@@ -1344,25 +1471,38 @@ try_again:
 		switch (var) {
 
 			case 0: {						//ground terrain
-				int iff_error;
-				palette_array_t pal;
-				terrain_bm_instance.reset();
-				iff_error = iff_read_bitmap(p, terrain_bm_instance, &pal);
-				if (iff_error != IFF_NO_ERROR) {
-					con_printf(CON_DEBUG, "Can't load exit terrain from file %s: IFF error: %s",
+				auto key = endlevel_file_key(p);
+				if (cache.terrain != key)
+				{
+					int iff_error;
+					palette_array_t pal;
+					cache.terrain.clear();
+					terrain_bm_instance.reset();
+					iff_error = iff_read_bitmap(p, terrain_bm_instance, &pal);
+					if (iff_error != IFF_NO_ERROR) {
+						con_printf(CON_DEBUG, "Can't load exit terrain from file %s: IFF error: %s",
                                                 p, iff_errormsg(iff_error));
-					endlevel_data_loaded = 0; // won't be able to play endlevel sequence
-					return;
+						endlevel_data_loaded = 0; // won't be able to play endlevel sequence
+						return;
+					}
+					gr_remap_bitmap_good(terrain_bm_instance, pal, iff_transparent_color, -1);
+					cache.terrain = std::move(key);
 				}
 				terrain_bitmap = &terrain_bm_instance;
-				gr_remap_bitmap_good(terrain_bm_instance, pal, iff_transparent_color, -1);
 				break;
 			}
 
-			case 1:							//height map
-
-				load_terrain(p);
+			case 1: {						//height map
+				auto key = endlevel_file_key(p);
+				if (cache.height != key)
+				{
+					load_terrain(p);
+					cache.height = std::move(key);
+				}
+				else
+					reuse_terrain();
 				break;
+			}
 
 
 			case 2:
@@ -1376,19 +1516,25 @@ try_again:
 				break;
 
 			case 4: {						//planet bitmap
-				int iff_error;
-				palette_array_t pal;
-				satellite_bm_instance.reset();
-				iff_error = iff_read_bitmap(p, satellite_bm_instance, &pal);
-				if (iff_error != IFF_NO_ERROR) {
-					con_printf(CON_DEBUG, "Can't load exit satellite from file %s: IFF error: %s",
+				auto key = endlevel_file_key(p);
+				if (cache.satellite != key)
+				{
+					int iff_error;
+					palette_array_t pal;
+					cache.satellite.clear();
+					satellite_bm_instance.reset();
+					iff_error = iff_read_bitmap(p, satellite_bm_instance, &pal);
+					if (iff_error != IFF_NO_ERROR) {
+						con_printf(CON_DEBUG, "Can't load exit satellite from file %s: IFF error: %s",
                                                 p, iff_errormsg(iff_error));
-					endlevel_data_loaded = 0; // won't be able to play endlevel sequence
-					return;
-				}
+						endlevel_data_loaded = 0; // won't be able to play endlevel sequence
+						return;
+					}
 
+					gr_remap_bitmap_good(satellite_bm_instance, pal, iff_transparent_color, -1);
+					cache.satellite = std::move(key);
+				}
 				satellite_bitmap = &satellite_bm_instance;
-				gr_remap_bitmap_good(satellite_bm_instance, pal, iff_transparent_color, -1);
 
 				break;
 			}
@@ -1440,6 +1586,7 @@ try_again:
 			{
 				exit_segnum = segp;
 				exit_side = sidenum;
+				exit_sidenum = sidenum;
 				break;
 			}
 		if (exit_segnum != segment_none)
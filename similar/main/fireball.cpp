@@ -78,10 +78,12 @@ using std::min;
 namespace dcx {
 
 unsigned Num_exploding_walls;
+exploding_wall_list Exploding_walls;
 
 void init_exploding_walls()
 {
 	Num_exploding_walls = 0;
+	Exploding_walls.clear();
 }
 
 }
@@ -125,6 +127,55 @@ static bool can_collide(const object *const weapon_object, const object_base &it
 	}
 }
 
+/* Collect, in object number order, every object near enough to
+ * position to be caught by a blast of radius maxdistance.  The blast only
+ * damages objects it can see, and the line of sight never leaves the
+ * sphere, so flooding from the blast segment through segments that touch
+ * the sphere finds every object that the old whole-level scan could
+ * damage.  Segments next to a touching segment are also scanned, since an
+ * object can sit slightly outside the segment that lists it.
+ */
+static void find_explosion_damage_candidates(const vcsegptridx_t start, const vms_vector &position, const fix maxdistance, std::vector<objnum_t> &result)
+{
+	auto &Vertices = LevelSharedVertexState.get_vertices();
+	auto &vcvertptr = Vertices.vcptr;
+	/* The damage test uses vm_vec_dist_quick, which can report a distance
+	 * up to about 10% short of the real one.
+	 */
+	const fix reach = maxdistance + (maxdistance >> 2);
+	std::vector<bool> visited(Highest_segment_index + 1);
+	std::vector<segnum_t> queue;
+	queue.emplace_back(start);
+	visited[start] = true;
+	for (std::size_t i = 0; i != queue.size(); ++i)
+	{
+		const auto &&segp = vcsegptridx(queue[i]);
+		range_for (const auto objp, objects_in(segp, vcobjptridx, vcsegptr))
+			result.emplace_back(objp);
+		const auto &&center = compute_segment_center(vcvertptr, segp);
+		fix radius = 0;
+		range_for (const auto v, segp->verts)
+		{
+			const auto d = vm_vec_dist(center, vcvertptr(v));
+			if (radius < d)
+				radius = d;
+		}
+		/* The start segment always floods, in case position has drifted
+		 * outside it.
+		 */
+		if (i && vm_vec_dist(center, position) > reach + radius)
+			continue;
+		range_for (const auto child, segp->children)
+		{
+			if (!IS_CHILD(child) || visited[child])
+				continue;
+			visited[child] = true;
+			queue.emplace_back(child);
+		}
+	}
+	std::sort(result.begin(), result.end());
+}
+
 static imobjptridx_t object_create_explosion_sub(const d_vclip_array &Vclip, fvmobjptridx &vmobjptridx, const imobjptridx_t objp, const vmsegptridx_t segnum, const vms_vector &position, fix size, int vclip_type, fix maxdamage, fix maxdistance, fix maxforce, const icobjptridx_t parent )
 {
 	auto &Robot_info = LevelSharedRobotInfoState.Robot_info;
@@ -149,8 +200,11 @@ static imobjptridx_t object_create_explosion_sub(const d_vclip_array &Vclip, fvm
 		fix damage;
 		// -- now legal for badass explosions on a wall. Assert(objp != NULL);
 
-		range_for (const auto &&obj0p, vmobjptridx)
+		std::vector<objnum_t> candidates;
+		find_explosion_damage_candidates(segnum, obj->pos, maxdistance, candidates);
+		range_for (const auto objnum, candidates)
 		{
+			const auto &&obj0p = vmobjptridx(objnum);
 			//	Weapons used to be affected by badass explosions, but this introduces serious problems.
 			//	When a smart bomb blows up, if one of its children goes right towards a nearby wall, it will
 			//	blow up, blowing up all the children.  So I remove it.  MK, 09/11/94
@@ -1303,6 +1357,7 @@ void explode_wall(fvcvertptr &vcvertptr, const vcsegptridx_t segnum, const unsig
 	w.explode_time_elapsed = 0;
 	w.flags |= WALL_EXPLODING;
 	++ Num_exploding_walls;
+	Exploding_walls.add(segnum->shared_segment::sides[sidenum].wall_num);
 
 	//play one long sound for whole door wall explosion
 	const auto &&pos = compute_center_point_on_side(vcvertptr, segnum, sidenum);
@@ -1467,6 +1522,7 @@ void expl_wall_read_n_swap(fvmwallptr &vmwallptr, PHYSFS_File *const fp, const i
 			w.flags |= WALL_EXPLODING;
 			w.explode_time_elapsed = d.time;
 			++ num_exploding_walls;
+			Exploding_walls.add(vcsegptr(dseg)->shared_segment::sides[w.sidenum].wall_num);
 			break;
 		}
 	}
@@ -352,8 +352,46 @@ imobjptridx_t  create_morph_robot( const vmsegptridx_t segp, const vms_vector &o
 
 }
 
+namespace {
+
+//	Robots alive per robot maker, counted with one pass over the objects
+//	the first time any robot maker needs it in a frame, instead of one
+//	pass for every robot maker that is ready to generate.
+class matcen_robot_counts
+{
+	bool counted = false;
+	array<uint16_t, std::tuple_size<decltype(d_level_unique_fuelcenter_state::Station)>::value> counts;
+public:
+	unsigned get(const unsigned numrobotcen)
+	{
+		if (!counted)
+		{
+			counted = true;
+			counts = {};
+			range_for (const auto &&objp, vcobjptr)
+			{
+				auto &obj = *objp;
+				if (obj.type == OBJ_ROBOT)
+				{
+					const unsigned creator = obj.matcen_creator ^ 0x80;
+					if (creator < counts.size())
+						++ counts[creator];
+				}
+			}
+		}
+		return counts[numrobotcen];
+	}
+	void add(const unsigned numrobotcen)
+	{
+		if (counted)
+			++ counts[numrobotcen];
+	}
+};
+
+}
+
 //	----------------------------------------------------------------------------------------------------------
-static void robotmaker_proc(const d_vclip_array &Vclip, fvmsegptridx &vmsegptridx, FuelCenter *const robotcen, const unsigned numrobotcen)
+static void robotmaker_proc(const d_vclip_array &Vclip, fvmsegptridx &vmsegptridx, FuelCenter *const robotcen, const unsigned numrobotcen, matcen_robot_counts &robot_counts)
 {
 	auto &RobotCenters = LevelSharedRobotcenterState.RobotCenters;
 	int		matcen_num;
@@ -426,24 +464,14 @@ static void robotmaker_proc(const d_vclip_array &Vclip, fvmsegptridx &vmsegptrid
 		}
 
 		if (robotcen->Timer > top_time )	{
-			int	count=0;
-			int	my_station_num = numrobotcen;
-
 			//	Make sure this robotmaker hasn't put out its max without having any of them killed.
-			range_for (const auto &&objp, vcobjptr)
-			{
-				auto &obj = *objp;
-				if (obj.type == OBJ_ROBOT)
-					if ((obj.matcen_creator ^ 0x80) == my_station_num)
-						count++;
-			}
-			if (count > Difficulty_level + 3) {
+			if (robot_counts.get(numrobotcen) > Difficulty_level + 3) {
 				robotcen->Timer /= 2;
 				return;
 			}
 
 			//	Whack on any robot or player in the matcen segment.
-			count=0;
+			int	count=0;
 			auto segnum = robotcen->segnum;
 			const auto &&csegp = vmsegptr(segnum);
 			range_for (const auto objp, objects_in(csegp, vmobjptridx, vmsegptr))
@@ -519,6 +547,7 @@ static void robotmaker_proc(const d_vclip_array &Vclip, fvmsegptridx &vmsegptrid
 					if (Game_mode & GM_MULTI)
 						multi_send_create_robot(numrobotcen, obj, type);
 					obj->matcen_creator = (numrobotcen) | 0x80;
+					robot_counts.add(numrobotcen);
 
 					// Make object faces player...
 					const auto direction = vm_vec_sub(ConsoleObject->pos,obj->pos );
@@ -542,15 +571,16 @@ static void robotmaker_proc(const d_vclip_array &Vclip, fvmsegptridx &vmsegptrid
 // Called once per frame, replenishes fuel supply.
 void fuelcen_update_all()
 {
+	if (Game_suspended & SUSP_ROBOTS)
+		return;
 	auto &Station = LevelUniqueFuelcenterState.Station;
+	matcen_robot_counts robot_counts;
 	range_for (auto &&e, enumerate(partial_range(Station, LevelUniqueFuelcenterState.Num_fuelcenters)))
 	{
 		auto &i = e.value;
-		if (i.Type == SEGMENT_IS_ROBOTMAKER)
-		{
-			if (! (Game_suspended & SUSP_ROBOTS))
-				robotmaker_proc(Vclip, vmsegptridx, &i, e.idx);
-		}
+		//	Idle robot makers cost only this test.
+		if (i.Type == SEGMENT_IS_ROBOTMAKER && i.Enabled)
+			robotmaker_proc(Vclip, vmsegptridx, &i, e.idx, robot_counts);
 	}
 }
 
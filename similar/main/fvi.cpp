@@ -613,6 +613,33 @@ struct fvi_segments_visited_t : public fvi_segment_visit_count_t, public visited
 
 //these vars are used to pass vars from fvi_sub() to find_vector_intersection()
 
+/* Box around the vector from p0 to p1.  An object whose centre is
+ * further outside it than its size plus the vector radius cannot be hit,
+ * so fvi_sub can skip it before the more expensive filters.
+ */
+class fvi_swept_bounds
+{
+	vms_vector mins, maxs;
+public:
+	fvi_swept_bounds(const vms_vector &p0, const vms_vector &p1, const fix rad)
+	{
+		/* Slack for the fixed point error in check_vector_to_sphere_1 */
+		const fix pad = rad + F1_0;
+		mins.x = std::min(p0.x, p1.x) - pad;
+		mins.y = std::min(p0.y, p1.y) - pad;
+		mins.z = std::min(p0.z, p1.z) - pad;
+		maxs.x = std::max(p0.x, p1.x) + pad;
+		maxs.y = std::max(p0.y, p1.y) + pad;
+		maxs.z = std::max(p0.z, p1.z) + pad;
+	}
+	bool excludes(const vms_vector &pos, const fix size) const
+	{
+		return pos.x + size < mins.x || pos.x - size > maxs.x ||
+			pos.y + size < mins.y || pos.y - size > maxs.y ||
+			pos.z + size < mins.z || pos.z - size > maxs.z;
+	}
+};
+
 }
 
 namespace dsx {
@@ -820,8 +847,11 @@ static int fvi_sub(vms_vector &intp, segnum_t &ints, const vms_vector &p0, const
 	if (flags & FQ_CHECK_OBJS)
 	{
 		const auto &collision = CollisionResult[likely(thisobjnum != object_none) ? thisobjnum->type : 0];
+		const fvi_swept_bounds bounds(p0, p1, std::max(rad, 0));
 		range_for (const auto objnum, objects_in(*seg, vcobjptridx, vcsegptr))
 		{
+			if (bounds.excludes(objnum->pos, objnum->size))
+				continue;
 			if (objnum->flags & OF_SHOULD_BE_DEAD)
 				continue;
 			if (thisobjnum != object_none)
@@ -1161,6 +1191,9 @@ fvi_hitpoint find_hitpoint_uv(const vms_vector &pnt, const vcsegptridx_t seg, co
 		k0 = fixdiv(fixmul(-k1,vec1.j) + checkp.j - p1.j,vec0.j);
 
 	array<uvl, 3> uvls;
+#if defined(DXX_BUILD_DESCENT_II)
+	slide_side_texture(vmsegptridx(static_cast<segnum_t>(seg)), sidenum);
+#endif
 	auto &uside = seg->unique_segment::sides[sidenum];
 	for (i=0;i<3;i++)
 		uvls[i] = uside.uvls[vn[facenum * 3 + i].vertnum];
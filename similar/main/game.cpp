@@ -30,6 +30,7 @@ COPYRIGHT 1993-1999 PARALLAX SOFTWARE CORPORATION.  ALL RIGHTS RESERVED.
 #include <stdarg.h>
 #include <SDL.h>
 #include <ctime>
+#include <bitset>
 #if DXX_USE_SCREENSHOT_FORMAT_PNG
 #include <png.h>
 #include "vers_id.h"
@@ -37,6 +38,7 @@ COPYRIGHT 1993-1999 PARALLAX SOFTWARE CORPORATION.  ALL RIGHTS RESERVED.
 
 #if DXX_USE_OGL
 #include "ogl_init.h"
+#include "ogl_extensions.h"
 #endif
 
 #include "pstypes.h"
@@ -97,6 +99,7 @@ COPYRIGHT 1993-1999 PARALLAX SOFTWARE CORPORATION.  ALL RIGHTS RESERVED.
 #include "cntrlcen.h"
 #include "pcx.h"
 #include "state.h"
+#include "replay.h"
 #include "piggy.h"
 #include "multibot.h"
 #include "fvi.h"
@@ -105,6 +108,7 @@ COPYRIGHT 1993-1999 PARALLAX SOFTWARE CORPORATION.  ALL RIGHTS RESERVED.
 #include "playsave.h"
 #include "maths.h"
 #include "hudmsg.h"
+#include "profile.h"
 #if defined(DXX_BUILD_DESCENT_II)
 #include <climits>
 #include "gamepal.h"
@@ -147,7 +151,6 @@ static void powerup_grab_cheat_all();
 
 #if defined(DXX_BUILD_DESCENT_II)
 d_flickering_light_state Flickering_light_state;
-static void slide_textures(void);
 static void flicker_lights(const d_level_shared_destructible_light_state &LevelSharedDestructibleLightState, d_flickering_light_state &fls, fvmsegptridx &vmsegptridx);
 #endif
 
@@ -159,6 +162,7 @@ game_cheats cheats;
 //this is called once per game
 void init_game()
 {
+	const trace_scope trace_phase("init_game");
 	init_objects();
 
 	init_special_effects();
@@ -469,8 +473,25 @@ void reset_time()
 
 }
 
-void calc_frame_time()
+//wait for the frame limiter, then set FrameTime to the time since the
+//previous frame
+static void measure_frame_time()
 {
+	if (CGameArg.SysHeadless && !(Game_mode & GM_MULTI))
+	{
+		//run as fast as possible, with the same step every frame so
+		//that runs are repeatable.  Netgames must run in real time.
+		FrameTime = F1_0 / CGameArg.SysMaxFPS;
+		return;
+	}
+	if ((!CGameArg.SysDemoVideo.empty() || !CGameArg.SysTimeDemo.empty()) && Newdemo_state == ND_STATE_PLAYBACK)
+	{
+		//every written frame is the same step of demo time, however
+		//long it took to render.  -timedemo also skips the frame limit
+		//this way, so that each run renders the same frames.
+		FrameTime = F1_0 / CGameArg.SysDemoVideoFPS;
+		return;
+	}
 	fix last_frametime = FrameTime;
 
 	const auto vsync = CGameCfg.VSync;
@@ -490,10 +511,7 @@ void calc_frame_time()
 			}
 			break;
 		}
-		if (Game_mode & GM_MULTI)
-			multi_do_frame(); // during long wait, keep packets flowing
-		if (may_sleep)
-			timer_delay_ms(1);
+		timer_delay_until(sync_timer_value + bound, may_sleep);
 	}
 
 	if ( cheats.turbo )
@@ -501,7 +519,10 @@ void calc_frame_time()
 
 	if (FrameTime < 0)				//if bogus frametime...
 		FrameTime = (last_frametime==0?1:last_frametime);		//...then use time from last frame
+}
 
+static void advance_game_time()
+{
 	GameTime64 += FrameTime;
 
 	calc_d_tick();
@@ -510,6 +531,136 @@ void calc_frame_time()
 #endif
 }
 
+void calc_frame_time()
+{
+	measure_frame_time();
+	advance_game_time();
+}
+
+namespace dsx {
+
+namespace {
+
+//With -fixedtick, the simulation advances in steps of one tick, and
+//rendering shows the objects part way between the last two ticks.
+//This needs the pose of each object after the previous tick.
+struct fixed_tick_pose
+{
+	object_signature_t signature;
+	vms_vector pos;
+	vms_matrix orient;
+};
+
+struct fixed_tick_state
+{
+	//real time not yet simulated
+	fix pending;
+	array<fixed_tick_pose, MAX_OBJECTS> previous, rendered;
+	//objects which fixed_tick_interpolate moved
+	std::bitset<MAX_OBJECTS> interpolated;
+};
+
+//At most this many ticks run for one rendered frame, so that a long
+//stall is dropped instead of caught up all at once.
+constexpr unsigned fixed_tick_max_steps = 4;
+
+//A move this long in one tick is a teleport, such as a respawn, and is
+//shown without interpolation.
+constexpr fix fixed_tick_teleport_distance = i2f(20);
+
+static fixed_tick_state Fixed_tick;
+
+static bool fixed_tick_active()
+{
+	return CGameArg.SysFixedTickRate && !(Game_mode & GM_MULTI) && Newdemo_state == ND_STATE_NORMAL;
+}
+
+static void fixed_tick_save_previous(fvcobjptridx &vcobjptridx)
+{
+	range_for (const auto &&objp, vcobjptridx)
+	{
+		auto &p = Fixed_tick.previous[objp];
+		p.signature = objp->signature;
+		p.pos = objp->pos;
+		p.orient = objp->orient;
+	}
+}
+
+static vms_vector fixed_tick_lerp(const vms_vector &a, const vms_vector &b, const fix t)
+{
+	return {a.x + fixmul(b.x - a.x, t), a.y + fixmul(b.y - a.y, t), a.z + fixmul(b.z - a.z, t)};
+}
+
+//move each object to where it was t of a tick after the previous tick,
+//and remember its real pose for fixed_tick_restore
+static void fixed_tick_interpolate(fvmobjptridx &vmobjptridx, const fix t)
+{
+	auto &interpolated = Fixed_tick.interpolated;
+	interpolated.reset();
+	range_for (const auto &&objp, vmobjptridx)
+	{
+		if (objp->type == OBJ_NONE)
+			continue;
+		auto &p = Fixed_tick.previous[objp];
+		if (p.signature != objp->signature)
+			continue;
+		if (vm_vec_dist_quick(p.pos, objp->pos) > fixed_tick_teleport_distance)
+			continue;
+		interpolated.set(objp);
+		auto &r = Fixed_tick.rendered[objp];
+		r.pos = objp->pos;
+		r.orient = objp->orient;
+		objp->pos = fixed_tick_lerp(p.pos, r.pos, t);
+		const auto &&fvec = fixed_tick_lerp(p.orient.fvec, r.orient.fvec, t);
+		const auto &&uvec = fixed_tick_lerp(p.orient.uvec, r.orient.uvec, t);
+		vm_vector_2_matrix(objp->orient, fvec, &uvec, nullptr);
+	}
+}
+
+static void fixed_tick_restore(fvmobjptridx &vmobjptridx)
+{
+	auto &interpolated = Fixed_tick.interpolated;
+	range_for (const auto &&objp, vmobjptridx)
+	{
+		if (!interpolated.test(objp))
+			continue;
+		auto &r = Fixed_tick.rendered[objp];
+		objp->pos = r.pos;
+		objp->orient = r.orient;
+	}
+}
+
+static fix fixed_tick_step()
+{
+	return F1_0 / CGameArg.SysFixedTickRate;
+}
+
+//simulate whole ticks for the real time that has passed, and leave
+//FrameTime at the real frame time for the code that runs while
+//rendering
+static window_event_result fixed_tick_process_frame()
+{
+	const auto step = fixed_tick_step();
+	measure_frame_time();
+	const auto frame_time = FrameTime;
+	auto pending = std::min(Fixed_tick.pending + frame_time, step * static_cast<fix>(fixed_tick_max_steps));
+	auto result = window_event_result::ignored;
+	for (; pending >= step; pending -= step)
+	{
+		fixed_tick_save_previous(vcobjptridx);
+		FrameTime = step;
+		advance_game_time();
+		result = std::max(GameProcessFrame(), result);
+	}
+	Fixed_tick.pending = pending;
+	FrameTime = frame_time;
+	return result;
+}
+
+}
+
+}
+
 namespace dsx {
 
 #if DXX_USE_EDITOR
@@ -533,6 +684,33 @@ namespace dcx {
 namespace {
 
 #if DXX_USE_SCREENSHOT_FORMAT_PNG
+/* Everything that goes into a PNG screenshot.  The game thread fills
+ * it in, then the screenshot thread does the compression and the file
+ * write, so that the game does not stall while zlib runs.
+ */
+struct screenshot_job
+{
+	RAIIPHYSFS_File file;
+	std::string savename;
+	bool have_time;
+	struct tm tm;
+#ifdef PNG_TEXT_SUPPORTED
+	bool have_mission;
+	bool have_viewer;
+	std::string mission_path;
+	ntstring<MISSION_NAME_LEN> mission_name;
+	int level_number;
+	unsigned viewer_segment;
+#endif
+	bool fast_compression;
+	unsigned width, height;
+	std::unique_ptr<uint8_t[]> pixels;
+#if !DXX_USE_OGL
+	palette_array_t pal;
+#endif
+	array<char, 128> error;
+};
+
 struct RAIIpng_struct
 {
 	png_struct *png_ptr;
@@ -562,21 +740,24 @@ struct d_screenshot : RAIIpng_struct
 	};
 };
 
+/* These run on the screenshot thread, which must not use the console,
+ * so messages are kept in the job for the game thread to report.
+ */
 void d_screenshot::png_error_cb(png_struct *const png, const char *const str)
 {
 	/* libpng requires that this function not return to its caller, and
 	 * will abort the program if this requirement is violated.  However,
 	 * throwing an exception that unwinds out past libpng is permitted.
 	 */
-	(void)png;
-	con_printf(CON_URGENT, "libpng error: %s", str);
+	auto &error = reinterpret_cast<screenshot_job *>(png_get_error_ptr(png))->error;
+	snprintf(error.data(), error.size(), "libpng error: %s", str);
 	throw png_exception();
 }
 
 void d_screenshot::png_warn_cb(png_struct *const png, const char *const str)
 {
 	(void)png;
-	con_printf(CON_URGENT, "libpng warning: %s", str);
+	(void)str;
 }
 
 void d_screenshot::png_write_cb(png_struct *const png, uint8_t *const buf, const png_size_t size)
@@ -602,20 +783,48 @@ void record_screenshot_time(const struct tm &tm, png_struct *const png_ptr, png_
 	pt.second = tm.tm_sec;
 	png_set_tIME(png_ptr, info_ptr, &pt);
 #else
+	(void)tm;
 	(void)png_ptr;
 	(void)info_ptr;
-	con_printf(CON_NORMAL, "libpng configured without support for time chunk: screenshot will lack time record.");
+#endif
+}
+
+/* Copy the game state named in the text chunks, since it may change
+ * before the screenshot thread gets to the job.
+ */
+void capture_screenshot_metadata(screenshot_job &job, const struct tm *const tm)
+{
+	job.have_time = tm != nullptr;
+	if (tm)
+		job.tm = *tm;
+#ifndef PNG_tIME_SUPPORTED
+	if (tm)
+		con_printf(CON_NORMAL, "libpng configured without support for time chunk: screenshot will lack time record.");
+#endif
+	job.fast_compression = CGameArg.SysFastScreenshots;
+#ifdef PNG_TEXT_SUPPORTED
+	job.have_mission = job.have_viewer = false;
+	if (const auto current_mission = Current_mission.get())
+	{
+		job.have_mission = true;
+		job.mission_path = current_mission->path;
+		job.mission_name = current_mission->mission_name;
+		job.level_number = Current_level_num;
+		if (const auto viewer = Viewer)
+		{
+			job.have_viewer = true;
+			job.viewer_segment = viewer->segnum;
+		}
+	}
 #endif
 }
 
 #ifdef PNG_TEXT_SUPPORTED
-void record_screenshot_text_metadata(png_struct *const png_ptr, png_info *const info_ptr)
+void record_screenshot_text_metadata(png_struct *const png_ptr, png_info *const info_ptr, screenshot_job &job)
 {
 	array<png_text, 6> text_fields{};
 	char descent_version[80];
 	char descent_build_datetime[21];
-	std::string current_mission_path;
-	ntstring<MISSION_NAME_LEN> current_mission_name;
 	char current_level_number[4];
 	char viewer_segment[sizeof("65536")];
 	unsigned idx = 0;
@@ -643,20 +852,18 @@ void record_screenshot_text_metadata(png_struct *const png_ptr, png_info *const
 	char key_current_mission_name[] = "Rebirth.mission.textname";
 	char key_viewer_segment[] = "Rebirth.viewer_segment";
 	char key_current_level_number[] = "Rebirth.current_level_number";
-	if (const auto current_mission = Current_mission.get())
+	if (job.have_mission)
 	{
 		{
 			auto &t = text_fields[idx++];
 			t.key = key_current_mission_path;
-			current_mission_path = current_mission->path;
-			t.text = &current_mission_path[0];
+			t.text = &job.mission_path[0];
 			t.compression = PNG_TEXT_COMPRESSION_NONE;
 		}
 		{
 			auto &t = text_fields[idx++];
 			t.key = key_current_mission_name;
-			current_mission_name = current_mission->mission_name;
-			t.text = current_mission_name.data();
+			t.text = job.mission_name.data();
 			t.compression = PNG_TEXT_COMPRESSION_NONE;
 		}
 		{
@@ -664,41 +871,38 @@ void record_screenshot_text_metadata(png_struct *const png_ptr, png_info *const
 			t.key = key_current_level_number;
 			t.text = current_level_number;
 			t.compression = PNG_TEXT_COMPRESSION_NONE;
-			snprintf(current_level_number, sizeof(current_level_number), "%i", Current_level_num);
+			snprintf(current_level_number, sizeof(current_level_number), "%i", job.level_number);
 		}
-		if (const auto viewer = Viewer)
+		if (job.have_viewer)
 		{
 			auto &t = text_fields[idx++];
 			t.key = key_viewer_segment;
 			t.text = viewer_segment;
 			t.compression = PNG_TEXT_COMPRESSION_NONE;
-			snprintf(viewer_segment, sizeof(viewer_segment), "%hu", viewer->segnum);
+			snprintf(viewer_segment, sizeof(viewer_segment), "%u", job.viewer_segment);
 		}
 	}
 	png_set_text(png_ptr, info_ptr, text_fields.data(), idx);
 }
 #endif
 
-#if DXX_USE_OGL
-#define write_screenshot_png(F,T,B,P)	write_screenshot_png(F,T,B)
-#endif
-unsigned write_screenshot_png(PHYSFS_File *const file, const struct tm *const tm, const grs_bitmap &bitmap, const palette_array_t &pal)
+/* Runs on the screenshot thread.  Returns nonzero if the file is
+ * incomplete.
+ */
+unsigned write_screenshot_png(screenshot_job &job)
 {
-	const unsigned bm_w = ((bitmap.bm_w + 3) & ~3);
-	const unsigned bm_h = ((bitmap.bm_h + 3) & ~3);
+	const unsigned bm_w = job.width;
+	const unsigned bm_h = job.height;
+	const auto begin_byte_buffer = job.pixels.get();
 #if DXX_USE_OGL
 	const unsigned bufsize = bm_w * bm_h * 3;
-	const auto buf = std::make_unique<uint8_t[]>(bufsize);
-	const auto begin_byte_buffer = buf.get();
-	glReadPixels(0, 0, bm_w, bm_h, GL_RGB, GL_UNSIGNED_BYTE, begin_byte_buffer);
 #else
-	const unsigned bufsize = bitmap.bm_rowsize * bm_h;
-	const auto begin_byte_buffer = bitmap.bm_mdata;
+	const unsigned bufsize = bm_w * bm_h;
 #endif
-	d_screenshot ss(png_create_write_struct(PNG_LIBPNG_VER_STRING, &ss, &d_screenshot::png_error_cb, &d_screenshot::png_warn_cb));
+	d_screenshot ss(png_create_write_struct(PNG_LIBPNG_VER_STRING, &job, &d_screenshot::png_error_cb, &d_screenshot::png_warn_cb));
 	if (!ss.png_ptr)
 	{
-		con_puts(CON_URGENT, "Cannot save screenshot: libpng png_create_write_struct failed");
+		snprintf(job.error.data(), job.error.size(), "libpng png_create_write_struct failed");
 		return 1;
 	}
 	/* Assert that Rebirth type rgb_t is layout compatible with
@@ -713,18 +917,30 @@ unsigned write_screenshot_png(PHYSFS_File *const file, const struct tm *const tm
 	static_assert(offsetof(png_color, blue) == offsetof(rgb_t, b), "blue offsetof mismatch");
 	try {
 		ss.info_ptr = png_create_info_struct(ss.png_ptr);
-		if (tm)
-			record_screenshot_time(*tm, ss.png_ptr, ss.info_ptr);
-		png_set_write_fn(ss.png_ptr, file, &d_screenshot::png_write_cb, &d_screenshot::png_flush_cb);
+		if (job.have_time)
+			record_screenshot_time(job.tm, ss.png_ptr, ss.info_ptr);
+		png_set_write_fn(ss.png_ptr, static_cast<PHYSFS_File *>(job.file), &d_screenshot::png_write_cb, &d_screenshot::png_flush_cb);
 #if DXX_USE_OGL
 		const auto color_type = PNG_COLOR_TYPE_RGB;
+		const auto fast_filter = PNG_FILTER_SUB;
 #else
-		png_set_PLTE(ss.png_ptr, ss.info_ptr, reinterpret_cast<const png_color *>(pal.data()), pal.size());
+		png_set_PLTE(ss.png_ptr, ss.info_ptr, reinterpret_cast<const png_color *>(job.pal.data()), job.pal.size());
 		const auto color_type = PNG_COLOR_TYPE_PALETTE;
+		/* Filters rarely help palette images */
+		const auto fast_filter = PNG_FILTER_NONE;
 #endif
 		png_set_IHDR(ss.png_ptr, ss.info_ptr, bm_w, bm_h, 8 /* always 256 colors */, color_type, PNG_INTERLACE_NONE, PNG_COMPRESSION_TYPE_BASE, PNG_FILTER_TYPE_BASE);
+		if (job.fast_compression)
+		{
+			/* Trying every filter on every row and compressing hard
+			 * costs several times as long as one filter at the lowest
+			 * zlib level, for a file only somewhat smaller.
+			 */
+			png_set_filter(ss.png_ptr, PNG_FILTER_TYPE_BASE, fast_filter);
+			png_set_compression_level(ss.png_ptr, 1);
+		}
 #ifdef PNG_TEXT_SUPPORTED
-		record_screenshot_text_metadata(ss.png_ptr, ss.info_ptr);
+		record_screenshot_text_metadata(ss.png_ptr, ss.info_ptr, job);
 #endif
 		png_write_info(ss.png_ptr, ss.info_ptr);
 		array<png_byte *, 1024> row_pointers;
@@ -749,10 +965,11 @@ unsigned write_screenshot_png(PHYSFS_File *const file, const struct tm *const tm
 		{
 #if DXX_USE_OGL
 			p -= stride;
+			*o++ = p;
 #else
+			*o++ = p;
 			p += stride;
 #endif
-			*o++ = p;
 			if (o == row_pointers.end())
 			{
 				/* Internal capacity exhausted.  Flush rows and rewind
@@ -777,21 +994,225 @@ unsigned write_screenshot_png(PHYSFS_File *const file, const struct tm *const tm
 		return 1;
 	}
 }
+
+/* Jobs the game thread is allowed to queue before it waits for the
+ * screenshot thread to catch up.  -demo_video queues one every frame.
+ */
+constexpr unsigned screenshot_queue_depth = 4;
+
+struct screenshot_encoder_state
+{
+	SDL_Thread *thread;
+	SDL_sem *queued;
+	SDL_sem *free_slots;
+	SDL_mutex *lock;
+	unsigned head, tail;
+	array<std::unique_ptr<screenshot_job>, screenshot_queue_depth> queue;
+	/* Guarded by lock: the failures the game thread has not reported
+	 * yet.
+	 */
+	std::string failed;
+};
+
+screenshot_encoder_state screenshot_encoder;
+
+void finish_screenshot_job(std::unique_ptr<screenshot_job> job)
+{
+	if (!write_screenshot_png(*job))
+		return;
+	job->file.reset();
+	PHYSFS_delete(job->savename.c_str());
+	auto &e = screenshot_encoder;
+	char message[256];
+	snprintf(message, sizeof(message), "Failed to write screenshot %s: %s", job->savename.c_str(), job->error.data());
+	if (!e.thread)
+	{
+		con_puts(CON_URGENT, message);
+		return;
+	}
+	SDL_LockMutex(e.lock);
+	if (!e.failed.empty())
+		e.failed += '\n';
+	e.failed += message;
+	SDL_UnlockMutex(e.lock);
+}
+
+int screenshot_encoder_thread(void *)
+{
+	auto &e = screenshot_encoder;
+	for (;;)
+	{
+		SDL_SemWait(e.queued);
+		auto job = std::move(e.queue[e.head]);
+		e.head = (e.head + 1) % screenshot_queue_depth;
+		SDL_SemPost(e.free_slots);
+		/* An empty job tells the thread to stop */
+		if (!job)
+			return 0;
+		finish_screenshot_job(std::move(job));
+	}
+}
+
+bool start_screenshot_encoder()
+{
+	auto &e = screenshot_encoder;
+	if (!(e.queued = SDL_CreateSemaphore(0)))
+		return false;
+	if ((e.free_slots = SDL_CreateSemaphore(screenshot_queue_depth)))
+	{
+		if ((e.lock = SDL_CreateMutex()))
+		{
+			e.head = e.tail = 0;
+#if SDL_MAJOR_VERSION == 2
+			e.thread = SDL_CreateThread(screenshot_encoder_thread, "screenshot", nullptr);
+#else
+			e.thread = SDL_CreateThread(screenshot_encoder_thread, nullptr);
+#endif
+			if (e.thread)
+				return true;
+			SDL_DestroyMutex(e.lock);
+		}
+		SDL_DestroySemaphore(e.free_slots);
+	}
+	SDL_DestroySemaphore(e.queued);
+	return false;
+}
+
+/* Hand a job with its pixels to the screenshot thread, or encode it
+ * here if the thread cannot run.
+ */
+void queue_screenshot_job(std::unique_ptr<screenshot_job> job)
+{
+	auto &e = screenshot_encoder;
+	if (!e.thread && !start_screenshot_encoder())
+		return finish_screenshot_job(std::move(job));
+	SDL_SemWait(e.free_slots);
+	e.queue[e.tail] = std::move(job);
+	e.tail = (e.tail + 1) % screenshot_queue_depth;
+	SDL_SemPost(e.queued);
+}
+
+#if DXX_USE_OGL
+/* With pixel buffer objects, glReadPixels only starts a copy of the
+ * frame.  The game thread collects the pixels a frame or so later,
+ * once the copy is done, instead of stalling for it.
+ */
+struct screenshot_readback_state
+{
+	GLuint pbo;
+	GLsync fence;
+	std::unique_ptr<screenshot_job> job;
+};
+
+screenshot_readback_state screenshot_readback;
+
+void finish_screenshot_readback()
+{
+	auto &r = screenshot_readback;
+	auto job = std::move(r.job);
+	if (r.fence)
+	{
+		glDeleteSyncFunc(r.fence);
+		r.fence = nullptr;
+	}
+	const std::size_t size = job->width * job->height * 3;
+	glBindBufferFunc(GL_PIXEL_PACK_BUFFER, r.pbo);
+	if (const auto p = glMapBufferFunc(GL_PIXEL_PACK_BUFFER, GL_READ_ONLY))
+	{
+		job->pixels = std::make_unique<uint8_t[]>(size);
+		memcpy(job->pixels.get(), p, size);
+		glUnmapBufferFunc(GL_PIXEL_PACK_BUFFER);
+	}
+	glBindBufferFunc(GL_PIXEL_PACK_BUFFER, 0);
+	if (job->pixels)
+		return queue_screenshot_job(std::move(job));
+	con_printf(CON_URGENT, "Failed to write screenshot %s: cannot map pixel buffer", job->savename.c_str());
+	job->file.reset();
+	PHYSFS_delete(job->savename.c_str());
+}
+
+void start_screenshot_readback(std::unique_ptr<screenshot_job> job)
+{
+	const auto bm_w = job->width;
+	const auto bm_h = job->height;
+	const std::size_t size = bm_w * bm_h * 3;
+	ogl_flush_text_batch();
+	if (!ogl_have_ARB_pixel_buffer_object)
+	{
+		job->pixels = std::make_unique<uint8_t[]>(size);
+		glReadPixels(0, 0, bm_w, bm_h, GL_RGB, GL_UNSIGNED_BYTE, job->pixels.get());
+		return queue_screenshot_job(std::move(job));
+	}
+	auto &r = screenshot_readback;
+	/* Only one copy is in flight at a time */
+	if (r.job)
+		finish_screenshot_readback();
+	if (!r.pbo)
+		glGenBuffersFunc(1, &r.pbo);
+	glBindBufferFunc(GL_PIXEL_PACK_BUFFER, r.pbo);
+	glBufferDataFunc(GL_PIXEL_PACK_BUFFER, size, nullptr, GL_STREAM_READ);
+	glReadPixels(0, 0, bm_w, bm_h, GL_RGB, GL_UNSIGNED_BYTE, nullptr);
+	glBindBufferFunc(GL_PIXEL_PACK_BUFFER, 0);
+	if (ogl_have_ARB_sync)
+		r.fence = glFenceSyncFunc(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	r.job = std::move(job);
+}
+#endif
 #endif
 
 }
 
 #if DXX_USE_SCREENSHOT
-void save_screen_shot(int automap_flag)
+void screenshot_service()
 {
+#if DXX_USE_SCREENSHOT_FORMAT_PNG
 #if DXX_USE_OGL
-	if (!CGameArg.DbgGlReadPixelsOk)
-	{
-		if (!automap_flag)
-			HUD_init_message_literal(HM_DEFAULT, "glReadPixels not supported on your configuration");
+	auto &r = screenshot_readback;
+	/* Without a fence, one pass of the event loop is taken as long
+	 * enough for the copy.
+	 */
+	if (r.job && (!r.fence || glClientWaitSyncFunc(r.fence, GL_SYNC_FLUSH_COMMANDS_BIT, 0) != GL_TIMEOUT_EXPIRED))
+		finish_screenshot_readback();
+#endif
+	auto &e = screenshot_encoder;
+	if (!e.thread)
 		return;
+	std::string failed;
+	SDL_LockMutex(e.lock);
+	failed.swap(e.failed);
+	SDL_UnlockMutex(e.lock);
+	if (!failed.empty())
+		con_puts(CON_URGENT, failed.c_str());
+#endif
+}
+
+void screenshot_close()
+{
+#if DXX_USE_SCREENSHOT_FORMAT_PNG
+#if DXX_USE_OGL
+	auto &r = screenshot_readback;
+	if (r.job)
+		finish_screenshot_readback();
+	if (r.pbo)
+	{
+		glDeleteBuffersFunc(1, &r.pbo);
+		r.pbo = 0;
 	}
 #endif
+	auto &e = screenshot_encoder;
+	if (!e.thread)
+		return;
+	/* Let the thread finish everything queued before the stop job */
+	queue_screenshot_job(nullptr);
+	SDL_WaitThread(e.thread, nullptr);
+	screenshot_service();
+	e.thread = nullptr;
+	SDL_DestroyMutex(e.lock);
+	SDL_DestroySemaphore(e.free_slots);
+	SDL_DestroySemaphore(e.queued);
+#endif
+}
+
 #if DXX_USE_SCREENSHOT_FORMAT_PNG
 #define DXX_SCREENSHOT_FILE_EXTENSION	"png"
 #elif DXX_USE_SCREENSHOT_FORMAT_LEGACY
@@ -802,6 +1223,84 @@ void save_screen_shot(int automap_flag)
 #endif
 #endif
 
+/* Write the last completed frame to file, and close it.  Deletes the
+ * file if it is incomplete.  PNG files are written by the screenshot
+ * thread, which reports its own failures.
+ */
+static void write_screen_shot(RAIIPHYSFS_File file, const char *const savename, const struct tm *const tm)
+{
+#if DXX_USE_OGL
+#if !DXX_USE_OGLES
+	glReadBuffer(GL_FRONT);
+#endif
+#if DXX_USE_SCREENSHOT_FORMAT_PNG
+	auto &bitmap = grd_curscreen->sc_canvas.cv_bitmap;
+	auto job = std::make_unique<screenshot_job>();
+	job->file = std::move(file);
+	job->savename = savename;
+	job->width = (bitmap.bm_w + 3) & ~3;
+	job->height = (bitmap.bm_h + 3) & ~3;
+	capture_screenshot_metadata(*job, tm);
+	start_screenshot_readback(std::move(job));
+#elif DXX_USE_SCREENSHOT_FORMAT_LEGACY
+	(void)savename;
+	(void)tm;
+	write_bmp(file, grd_curscreen->get_screen_width(), grd_curscreen->get_screen_height());
+	/* write_bmp never fails */
+#endif
+#else
+	grs_canvas &screen_canv = grd_curscreen->sc_canvas;
+	palette_array_t pal;
+
+	gr_palette_read(pal);		//get actual palette from the hardware
+	// Correct palette colors
+	range_for (auto &i, pal)
+	{
+		i.r <<= 2;
+		i.g <<= 2;
+		i.b <<= 2;
+	}
+#if DXX_USE_SCREENSHOT_FORMAT_PNG
+	auto &bitmap = screen_canv.cv_bitmap;
+	auto job = std::make_unique<screenshot_job>();
+	job->file = std::move(file);
+	job->savename = savename;
+	const unsigned bm_w = job->width = (bitmap.bm_w + 3) & ~3;
+	const unsigned bm_h = job->height = (bitmap.bm_h + 3) & ~3;
+	/* The screen changes while the screenshot thread works, so it
+	 * gets a copy.  Rows past the edge of the screen, for the
+	 * rounding up above, are left black.
+	 */
+	job->pixels = std::make_unique<uint8_t[]>(bm_w * bm_h);
+	for (unsigned y = 0; y != bitmap.bm_h; ++y)
+		memcpy(&job->pixels[y * bm_w], &bitmap.bm_data[y * bitmap.bm_rowsize], bitmap.bm_w);
+	job->pal = pal;
+	capture_screenshot_metadata(*job, tm);
+	queue_screenshot_job(std::move(job));
+#elif DXX_USE_SCREENSHOT_FORMAT_LEGACY
+	(void)tm;
+	const auto &&temp_canv = gr_create_canvas(screen_canv.cv_bitmap.bm_w, screen_canv.cv_bitmap.bm_h);
+	gr_ubitmap(*temp_canv, screen_canv.cv_bitmap);
+	if (pcx_write_bitmap(file, &temp_canv->cv_bitmap, pal))
+	{
+		file.reset();
+		PHYSFS_delete(savename);
+	}
+#endif
+#endif
+}
+
+void save_screen_shot(int automap_flag)
+{
+#if DXX_USE_OGL
+	if (!CGameArg.DbgGlReadPixelsOk)
+	{
+		if (!automap_flag)
+			HUD_init_message_literal(HM_DEFAULT, "glReadPixels not supported on your configuration");
+		return;
+	}
+#endif
+
 	if (!PHYSFSX_exists(SCRNS_DIR,0))
 		PHYSFS_mkdir(SCRNS_DIR); //try making directory
 
@@ -842,46 +1341,12 @@ void save_screen_shot(int automap_flag)
 		snprintf(savename, sizeof(savename), DXX_SCREENSHOT_TIME_FORMAT_STRING ".%02u." DXX_SCREENSHOT_FILE_EXTENSION, DXX_SCREENSHOT_TIME_FORMAT_VALUES, savenum);
 #undef DXX_SCREENSHOT_TIME_FORMAT_VALUES
 #undef DXX_SCREENSHOT_TIME_FORMAT_STRING
-#undef DXX_SCREENSHOT_FILE_EXTENSION
 	}
-	unsigned write_error;
-	if (const auto file = PHYSFSX_openWriteBuffered(savename))
+	if (auto file = PHYSFSX_openWriteBuffered(savename))
 	{
 	if (!automap_flag)
 		HUD_init_message(HM_DEFAULT, "%s '%s'", TXT_DUMPING_SCREEN, &savename[sizeof(SCRNS_DIR) - 1]);
-
-#if DXX_USE_OGL
-#if !DXX_USE_OGLES
-	glReadBuffer(GL_FRONT);
-#endif
-#if DXX_USE_SCREENSHOT_FORMAT_PNG
-	write_error = write_screenshot_png(file, tm, grd_curscreen->sc_canvas.cv_bitmap, void /* unused */);
-#elif DXX_USE_SCREENSHOT_FORMAT_LEGACY
-	write_bmp(file, grd_curscreen->get_screen_width(), grd_curscreen->get_screen_height());
-	/* write_bmp never fails */
-	write_error = 0;
-#endif
-#else
-	grs_canvas &screen_canv = grd_curscreen->sc_canvas;
-	palette_array_t pal;
-
-	const auto &&temp_canv = gr_create_canvas(screen_canv.cv_bitmap.bm_w, screen_canv.cv_bitmap.bm_h);
-	gr_ubitmap(*temp_canv, screen_canv.cv_bitmap);
-
-	gr_palette_read(pal);		//get actual palette from the hardware
-	// Correct palette colors
-	range_for (auto &i, pal)
-	{
-		i.r <<= 2;
-		i.g <<= 2;
-		i.b <<= 2;
-	}
-#if DXX_USE_SCREENSHOT_FORMAT_PNG
-	write_error = write_screenshot_png(file, tm, grd_curscreen->sc_canvas.cv_bitmap, pal);
-#elif DXX_USE_SCREENSHOT_FORMAT_LEGACY
-	write_error = pcx_write_bitmap(file, &temp_canv->cv_bitmap, pal);
-#endif
-#endif
+	write_screen_shot(std::move(file), savename, tm);
 	}
 	else
 	{
@@ -889,11 +1354,29 @@ void save_screen_shot(int automap_flag)
 			HUD_init_message(HM_DEFAULT, "Failed to open screenshot file for writing: %s", &savename[sizeof(SCRNS_DIR) - 1]);
 		else
 			con_printf(CON_URGENT, "Failed to open screenshot file for writing: %s", savename);
-		return;
 	}
-	if (write_error)
-		PHYSFS_delete(savename);
 }
+
+/* Write the frame just shown to directory SCRNS_DIR <demo name>/, for
+ * -demo_video.
+ */
+static void save_demo_video_frame()
+{
+	static unsigned frame;
+	char dirname[sizeof(SCRNS_DIR) + FILENAME_LEN];
+	snprintf(dirname, sizeof(dirname), SCRNS_DIR "%s", CGameArg.SysDemoVideo.c_str());
+	if (const auto ext = strrchr(dirname, '.'))
+		*ext = 0;
+	if (!frame)
+		PHYSFS_mkdir(dirname);
+	char savename[sizeof(dirname) + sizeof("/000000." DXX_SCREENSHOT_FILE_EXTENSION)];
+	snprintf(savename, sizeof(savename), "%s/%06u." DXX_SCREENSHOT_FILE_EXTENSION, dirname, frame++);
+	if (auto file = PHYSFSX_openWriteBuffered(savename))
+		write_screen_shot(std::move(file), savename, nullptr);
+	else
+		con_printf(CON_URGENT, "Failed to open video frame file for writing: %s", savename);
+}
+#undef DXX_SCREENSHOT_FILE_EXTENSION
 #endif
 
 //initialize flying
@@ -1250,7 +1733,8 @@ static int free_help(newmenu *, const d_event &event, newmenu_item *items)
 #if (defined(__APPLE__) || defined(macintosh))
 #define _DXX_HELP_MENU_SAVE_LOAD(VERB)	\
 	DXX_MENUITEM(VERB, TEXT, "Alt-F2/F3 (\x85-SHIFT-s/o)\t  SAVE/LOAD GAME", HELP_AF2_3)	\
-	DXX_MENUITEM(VERB, TEXT, "Alt-Shift-F2/F3 (\x85-s/o)\t  Quick Save/Load", HELP_ASF2_3)
+	DXX_MENUITEM(VERB, TEXT, "Alt-Shift-F2/F3 (\x85-s/o)\t  Quick Save/Load", HELP_ASF2_3)	\
+	DXX_MENUITEM(VERB, TEXT, "Ctrl-F3/Ctrl-Shift-F3\t  Rewind to last/earlier snapshot", HELP_CF3)
 #define _DXX_HELP_MENU_PAUSE(VERB) DXX_MENUITEM(VERB, TEXT, "Pause (\x85-P)\t  Pause", HELP_PAUSE)
 
 #if DXX_USE_SDL_REDBOOK_AUDIO
@@ -1273,7 +1757,8 @@ static int free_help(newmenu *, const d_event &event, newmenu_item *items)
 #else
 #define _DXX_HELP_MENU_SAVE_LOAD(VERB)	\
 	DXX_MENUITEM(VERB, TEXT, "Alt-F2/F3\t  SAVE/LOAD GAME", HELP_AF2_3)	\
-	DXX_MENUITEM(VERB, TEXT, "Alt-Shift-F2/F3\t  Fast Save", HELP_ASF2_3)
+	DXX_MENUITEM(VERB, TEXT, "Alt-Shift-F2/F3\t  Fast Save", HELP_ASF2_3)	\
+	DXX_MENUITEM(VERB, TEXT, "Ctrl-F3/Ctrl-Shift-F3\t  Rewind to last/earlier snapshot", HELP_CF3)
 #define _DXX_HELP_MENU_PAUSE(VERB)	DXX_MENUITEM(VERB, TEXT, TXT_HELP_PAUSE, HELP_PAUSE)
 
 #if DXX_USE_SDL_REDBOOK_AUDIO
@@ -1388,6 +1873,8 @@ void show_netgame_help()
 	DXX_MENUITEM(VERB, TEXT, "SHIFT-LEFT\t  FAST BACKWARD", DEMOHELP_FAST_BACKWARD)	\
 	DXX_MENUITEM(VERB, TEXT, "CTRL-RIGHT\t  JUMP TO END", DEMOHELP_JUMP_END)	\
 	DXX_MENUITEM(VERB, TEXT, "CTRL-LEFT\t  JUMP TO START", DEMOHELP_JUMP_START)	\
+	DXX_MENUITEM(VERB, TEXT, "PAGEDOWN\t  JUMP FORWARD", DEMOHELP_JUMP_FORWARD)	\
+	DXX_MENUITEM(VERB, TEXT, "PAGEUP\t  JUMP BACKWARD", DEMOHELP_JUMP_BACKWARD)	\
 	_DXX_HELP_MENU_HINT_CMD_KEY(VERB, DEMOHELP)	\
 
 enum {
@@ -1545,6 +2032,8 @@ window *game_setup(void)
 	Game_suspended = 0;
 	reset_time();
 	FrameTime = 0;			//make first frame zero
+	Fixed_tick.pending = 0;
+	fixed_tick_save_previous(vcobjptridx);
 
 	fix_object_segs();
 	if (CGameArg.SysAutoRecordDemo && Newdemo_state == ND_STATE_NORMAL)
@@ -1610,19 +2099,68 @@ window_event_result game_handler(window *,const d_event &event, const unused_win
 			return ReadControls(event);
 
 		case EVENT_WINDOW_DRAW:
-			if (!time_paused)
 			{
+			const auto fixed_tick = fixed_tick_active();
+			const auto simulate = [fixed_tick, &result]() {
+				if (time_paused)
+					return;
+				if (fixed_tick)
+					result = fixed_tick_process_frame();
+				else
+				{
 				calc_frame_time();
 				result = GameProcessFrame();
-			}
+				}
+				if (result == window_event_result::ignored)
+					state_rewind_frame();
+			};
+			const auto draw = !Automap_active && !CGameArg.SysHeadless;		// efficiency hack
+#if DXX_USE_OGL
+			/* With -gl_pipeline, draw the state left by the previous
+			 * frame, hand it to the GPU, and simulate while the GPU
+			 * draws.  The buffer swap in gr_flip then waits for
+			 * whichever finishes last, instead of for both in turn.
+			 */
+			const auto pipeline = draw && CGameArg.OglPipeline;
+#else
+			constexpr bool pipeline = false;
+#endif
+			if (!pipeline)
+				simulate();
 
-			if (!Automap_active)		// efficiency hack
+			if (draw)
 			{
+				const profile_scope profile(profile_phase::render);
 				if (force_cockpit_redraw) {			//screen need redrawing?
 					init_cockpit();
 					force_cockpit_redraw=0;
 				}
-				game_render_frame();
+				if (fixed_tick)
+				{
+					fixed_tick_interpolate(vmobjptridx, fixdiv(Fixed_tick.pending, fixed_tick_step()));
+					game_render_frame();
+					fixed_tick_restore(vmobjptridx);
+				}
+				else
+					game_render_frame();
+#if DXX_USE_SCREENSHOT
+				if (!CGameArg.SysDemoVideo.empty() && Newdemo_state == ND_STATE_PLAYBACK)
+					save_demo_video_frame();
+#endif
+			}
+#if DXX_USE_OGL
+			if (pipeline)
+			{
+				ogl_submit_frame();
+				simulate();
+			}
+#endif
+			profile_end_frame();
+			DXX_TRACE_FRAME();
+			//Controls are read between frames, and scaled by FrameTime
+			//for the tick that will use them.
+			if (fixed_tick)
+				FrameTime = fixed_tick_step();
 			}
 			break;
 
@@ -1636,6 +2174,7 @@ window_event_result game_handler(window *,const d_event &event, const unused_win
 
 			if ( Newdemo_state == ND_STATE_PLAYBACK )
 				newdemo_stop_playback();
+			replay_stop();
 
 			songs_play_song( SONG_TITLE, 1 );
 
@@ -1741,6 +2280,7 @@ namespace dsx {
 
 window_event_result GameProcessFrame()
 {
+	DXX_TRACE_ZONE("GameProcessFrame");
 	auto &plrobj = get_local_plrobj();
 	auto &player_info = plrobj.ctype.player_info;
 	auto &local_player_shields_ref = plrobj.shields;
@@ -1748,6 +2288,10 @@ window_event_result GameProcessFrame()
 	const auto player_was_dead = Player_dead_state;
 	auto result = window_event_result::ignored;
 
+	if (replay_frame_begin())
+		return window_event_result::close;
+	if (replay_active() && player_was_dead == player_dead_state::no && !Endlevel_sequence)
+		do_weapon_n_item_stuff(Objects);
 	update_player_stats();
 	diminish_palette_towards_normal();		//	Should leave palette effect up for as long as possible by putting right before render.
 	do_afterburner_stuff(Objects);
@@ -1791,7 +2335,10 @@ window_event_result GameProcessFrame()
 
 	if (Game_mode & GM_MULTI)
 	{
-		result = std::max(multi_do_frame(), result);
+		{
+			const profile_scope profile(profile_phase::network);
+			result = std::max(multi_do_frame(), result);
+		}
 		if (Netgame.PlayTimeAllowed && ThisLevelTime>=i2f((Netgame.PlayTimeAllowed*5*60)))
 			multi_check_for_killgoal_winner();
 	}
@@ -1811,7 +2358,10 @@ window_event_result GameProcessFrame()
 	if ((Game_mode & GM_MULTI) && Netgame.PlayTimeAllowed)
 		ThisLevelTime +=FrameTime;
 
-	digi_sync_sounds();
+	{
+		const profile_scope profile(profile_phase::sound);
+		digi_sync_sounds();
+	}
 
 	if (Endlevel_sequence) {
 		result = std::max(do_endlevel_frame(), result);
@@ -1846,7 +2396,10 @@ window_event_result GameProcessFrame()
 #ifndef NEWHOMER
 		player_info.homing_object_dist = -1; // Assume not being tracked.  Laser_do_weapon_sequence modifies this.
 #endif
-		result = std::max(object_move_all(), result);
+		{
+			const profile_scope profile(profile_phase::physics);
+			result = std::max(object_move_all(), result);
+		}
 		powerup_grab_cheat_all();
 
 		if (Endlevel_sequence)	//might have been started during move
@@ -1854,7 +2407,10 @@ window_event_result GameProcessFrame()
 
 		fuelcen_update_all();
 
-		do_ai_frame_all();
+		{
+			const profile_scope profile(profile_phase::ai);
+			do_ai_frame_all();
+		}
 
 		auto laser_firing_count = FireLaser(player_info);
 		if (auto &Auto_fire_fusion_cannon_time = player_info.Auto_fire_fusion_cannon_time)
@@ -1889,7 +2445,6 @@ window_event_result GameProcessFrame()
 
 #if defined(DXX_BUILD_DESCENT_II)
 	omega_charge_frame(player_info);
-	slide_textures();
 	auto &LevelSharedDestructibleLightState = LevelSharedSegmentState.DestructibleLights;
 	flicker_lights(LevelSharedDestructibleLightState, Flickering_light_state, vmsegptridx);
 
@@ -1909,11 +2464,20 @@ window_event_result GameProcessFrame()
 }
 
 #if defined(DXX_BUILD_DESCENT_II)
+//	Sliding sides are moved when they are drawn or hit, by the game time
+//	which passed since they were last moved, so frames do not pay for
+//	sides nobody sees.  Slide_side_index holds the position in
+//	Slide_side_time of the first sliding side of each segment.
+static array<unsigned, MAX_SEGMENTS> Slide_side_index;
+static std::vector<fix64> Slide_side_time;
+
 void compute_slide_segs()
 {
 	auto &TmapInfo = LevelUniqueTmapInfoState.TmapInfo;
-	range_for (const auto &&segp, vmsegptr)
+	unsigned count = 0;
+	range_for (const auto &&segp, vmsegptridx)
 	{
+		Slide_side_index[segp] = count;
 		uint8_t slide_textures = 0;
 		for (int sidenum=0;sidenum<6;sidenum++) {
 			const auto &sside = segp->shared_segment::sides[sidenum];
@@ -1928,9 +2492,11 @@ void compute_slide_segs()
 				 */
 				continue;
 			slide_textures |= 1 << sidenum;
+			++count;
 		}
 		segp->slide_textures = slide_textures;
 	}
+	Slide_side_time.assign(count, GameTime64);
 }
 
 template <fix uvl::*p>
@@ -1947,35 +2513,46 @@ static void update_uv(array<uvl, 4> &uvls, uvl &i, fix a)
 			j.*p += f1_0;
 }
 
+//	Whole texture repeats look the same, so keep only the fraction.
+static fix slide_distance(const fix64 elapsed, const int rate)
+{
+	return static_cast<fix>(((elapsed * (rate << 8)) >> 16) % F1_0);
+}
+
 //	-----------------------------------------------------------------------------
-static void slide_textures(void)
+void slide_side_texture(const vmsegptridx_t segp, const unsigned sidenum)
 {
+	const unsigned slide_seg = segp->slide_textures;
+	const unsigned side_mask = 1 << sidenum;
+	if (!(slide_seg & side_mask))
+		return;
+	unsigned index = Slide_side_index[segp];
+	for (unsigned s = 0; s != sidenum; ++s)
+		if (slide_seg & (1 << s))
+			++index;
+	if (index >= Slide_side_time.size())
+		return;
+	auto &t = Slide_side_time[index];
+	const auto now = GameTime64;
+	const fix64 elapsed = now - t;
+	t = now;
+	//	A new game resets the game time.
+	if (elapsed <= 0)
+		return;
 	auto &TmapInfo = LevelUniqueTmapInfoState.TmapInfo;
-	range_for (const auto &&segp, vmsegptr)
+	auto &side = segp->unique_segment::sides[sidenum];
+	const auto &ti = TmapInfo[side.tmap_num];
+	const auto tiu = ti.slide_u;
+	const auto tiv = ti.slide_v;
+	if (tiu || tiv)
 	{
-		if (const auto slide_seg = segp->slide_textures)
+		const auto ua = slide_distance(elapsed, tiu);
+		const auto va = slide_distance(elapsed, tiv);
+		auto &uvls = side.uvls;
+		range_for (auto &i, uvls)
 		{
-			for (int sidenum=0;sidenum<6;sidenum++) {
-				if (slide_seg & (1 << sidenum))
-				{
-					auto &side = segp->unique_segment::sides[sidenum];
-					const auto &ti = TmapInfo[side.tmap_num];
-					const auto tiu = ti.slide_u;
-					const auto tiv = ti.slide_v;
-					if (tiu || tiv)
-					{
-						const auto frametime = FrameTime;
-						const auto ua = fixmul(frametime, tiu << 8);
-						const auto va = fixmul(frametime, tiv << 8);
-						auto &uvls = side.uvls;
-						range_for (auto &i, uvls)
-						{
-							update_uv<&uvl::u>(uvls, i, ua);
-							update_uv<&uvl::v>(uvls, i, va);
-						}
-					}
-				}
-			}
+			update_uv<&uvl::u>(uvls, i, ua);
+			update_uv<&uvl::v>(uvls, i, va);
 		}
 	}
 }
@@ -1987,6 +2564,7 @@ static void flicker_lights(const d_level_shared_destructible_light_state &LevelS
 	auto &TmapInfo = LevelUniqueTmapInfoState.TmapInfo;
 	auto &Walls = LevelUniqueWallSubsystemState.Walls;
 	auto &vcwallptr = Walls.vcptr;
+	light_change_batch batch(LevelSharedDestructibleLightState);
 	range_for (auto &f, partial_range(fls.Flickering_lights, fls.Num_flickering_lights))
 	{
 		if (f.timer == flicker_timer_disabled)		//disabled
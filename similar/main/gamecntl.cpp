@@ -89,6 +89,7 @@ COPYRIGHT 1993-1999 PARALLAX SOFTWARE CORPORATION.  ALL RIGHTS RESERVED.
 #include "fuelcen.h"
 #include "pcx.h"
 #include "state.h"
+#include "replay.h"
 #include "piggy.h"
 #include "multibot.h"
 #include "ai.h"
@@ -218,7 +219,7 @@ int which_bomb()
 }
 #endif
 
-static void do_weapon_n_item_stuff(object_array &objects)
+void do_weapon_n_item_stuff(object_array &objects)
 {
 	auto &vmobjptridx = objects.vmptridx;
 	auto &vmobjptr = objects.vmptr;
@@ -523,6 +524,10 @@ static window_event_result HandleDemoKey(int key)
 		case KEY_CTRLED + KEY_LEFT:
 			return newdemo_goto_beginning();
 			break;
+		case KEY_PAGEUP:
+			return newdemo_seek_keyframe(-1);
+		case KEY_PAGEDOWN:
+			return newdemo_seek_keyframe(1);
 
 		KEY_MAC(case KEY_COMMAND+KEY_P:)
 		case KEY_PAUSE:
@@ -841,6 +846,11 @@ static window_event_result HandleSystemKey(int key)
 			if (!((Game_mode & GM_MULTI) && !(Game_mode & GM_MULTI_COOP)))
 				state_restore_all(1, secret_restore::none, nullptr, blind_save::yes);
 			break;
+		case KEY_CTRLED+KEY_F3:
+		case KEY_CTRLED+KEY_SHIFTED+KEY_F3:
+			if (!(Game_mode & GM_MULTI))
+				state_rewind_restore(key & KEY_SHIFTED);
+			break;
 
 #if defined(DXX_BUILD_DESCENT_II)
 		KEY_MAC(case KEY_COMMAND+KEY_SHIFTED+KEY_4:)
@@ -1955,7 +1965,8 @@ window_event_result ReadControls(const d_event &event)
 			return result;
 	}
 
-	if (!Endlevel_sequence && Newdemo_state != ND_STATE_PLAYBACK)
+	// A replay sets the controls of each frame from its stream
+	if (!Endlevel_sequence && Newdemo_state != ND_STATE_PLAYBACK && !replay_playing())
 	{
 		kconfig_read_controls(event, 0);
 		const auto Player_is_dead = Player_dead_state;
@@ -1976,7 +1987,8 @@ window_event_result ReadControls(const d_event &event)
 		}
 		if (Player_is_dead != player_dead_state::no)
 			return window_event_result::ignored;
-		do_weapon_n_item_stuff(Objects);
+		if (!replay_active())
+			do_weapon_n_item_stuff(Objects);
 	}
 	return window_event_result::ignored;
 }
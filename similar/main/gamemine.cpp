@@ -62,15 +62,15 @@ int New_file_format_load = 1; // "new file format" is everything newer than d1 s
 namespace dsx {
 
 /*
- * reads a segment2 structure from a PHYSFS_File
+ * reads a segment2 structure from a buffer
  */
-static void segment2_read(shared_segment &s2, unique_segment &u2, PHYSFS_File *fp)
+static void segment2_read(shared_segment &s2, unique_segment &u2, PHYSFSX_buffer_reader &fp)
 {
-	s2.special = PHYSFSX_readByte(fp);
-	s2.matcen_num = PHYSFSX_readByte(fp);
+	s2.special = fp.readByte();
+	s2.matcen_num = fp.readByte();
 	/* station_idx overwritten by caller */
-	PHYSFSX_readByte(fp);
-	const auto s2_flags = PHYSFSX_readByte(fp);
+	fp.readByte();
+	const auto s2_flags = fp.readByte();
 #if defined(DXX_BUILD_DESCENT_I)
 	(void)s2_flags;	// descent 2 ambient sound handling
 	if (s2.special >= MAX_CENTER_TYPES)
@@ -78,8 +78,19 @@ static void segment2_read(shared_segment &s2, unique_segment &u2, PHYSFS_File *f
 #elif defined(DXX_BUILD_DESCENT_II)
 	s2.s2_flags = s2_flags;
 #endif
-	u2.static_light = PHYSFSX_readFix(fp);
+	u2.static_light = fp.readFix();
+}
+
+#if DXX_USE_EDITOR && defined(DXX_BUILD_DESCENT_II)
+/*
+ * reads a segment2 structure from a PHYSFS_File
+ */
+static void segment2_read(shared_segment &s2, unique_segment &u2, PHYSFS_File *fp)
+{
+	PHYSFSX_buffer_reader r(fp, 9);
+	segment2_read(s2, u2, r);
 }
+#endif
 
 #if defined(DXX_BUILD_DESCENT_I)
 #elif defined(DXX_BUILD_DESCENT_II)
@@ -819,32 +830,32 @@ int load_mine_data(PHYSFS_File *LoadFile)
 
 #define COMPILED_MINE_VERSION 0
 
-static void read_children(shared_segment &segp, const unsigned bit_mask, PHYSFS_File *const LoadFile)
+static void read_children(shared_segment &segp, const unsigned bit_mask, PHYSFSX_buffer_reader &LoadFile)
 {
 	for (int bit=0; bit<MAX_SIDES_PER_SEGMENT; bit++) {
 		if (bit_mask & (1 << bit)) {
-			segp.children[bit] = PHYSFSX_readShort(LoadFile);
+			segp.children[bit] = LoadFile.readShort();
 		} else
 			segp.children[bit] = segment_none;
 	}
 }
 
-static void read_verts(shared_segment &segp, PHYSFS_File *const LoadFile)
+static void read_verts(shared_segment &segp, PHYSFSX_buffer_reader &LoadFile)
 {
 	// Read short Segments[segnum].verts[MAX_VERTICES_PER_SEGMENT]
 	range_for (auto &i, segp.verts)
-		i = PHYSFSX_readShort(LoadFile);
+		i = LoadFile.readShort();
 }
 
-static void read_special(shared_segment &segp, const unsigned bit_mask, PHYSFS_File *const LoadFile)
+static void read_special(shared_segment &segp, const unsigned bit_mask, PHYSFSX_buffer_reader &LoadFile)
 {
 	if (bit_mask & (1 << MAX_SIDES_PER_SEGMENT)) {
 		// Read ubyte	Segments[segnum].special
-		segp.special = PHYSFSX_readByte(LoadFile);
+		segp.special = LoadFile.readByte();
 		// Read byte	Segments[segnum].matcen_num
-		segp.matcen_num = PHYSFSX_readByte(LoadFile);
+		segp.matcen_num = LoadFile.readByte();
 		// Read short	Segments[segnum].value
-		segp.station_idx = PHYSFSX_readShort(LoadFile);
+		segp.station_idx = LoadFile.readShort();
 	} else {
 		segp.special = 0;
 		segp.matcen_num = -1;
@@ -853,7 +864,7 @@ static void read_special(shared_segment &segp, const unsigned bit_mask, PHYSFS_F
 }
 
 namespace dsx {
-int load_mine_data_compiled(PHYSFS_File *LoadFile)
+int load_mine_data_compiled(PHYSFS_File *const fp)
 {
 	ubyte   compiled_version;
 	short   temp_short;
@@ -882,26 +893,31 @@ int load_mine_data_compiled(PHYSFS_File *LoadFile)
 	fuelcen_reset();
 
 	//=============================== Reading part ==============================
-	compiled_version = PHYSFSX_readByte(LoadFile);
+	/* Mine data is at most this large: every segment with all six
+	 * sides textured and walled, plus the segment2 table.
+	 */
+	constexpr std::size_t max_mine_data_size = 1 + 4 + 4 + MAX_VERTICES * 12 + MAX_SEGMENTS * (1 + 6 * 2 + 8 * 2 + 4 + 2 + 1 + 6 + 6 * (2 + 2 + 4 * 6) + 9);
+	PHYSFSX_buffer_reader LoadFile(fp, max_mine_data_size);
+	compiled_version = LoadFile.readByte();
 	(void)compiled_version;
 
 	auto &Vertices = LevelSharedVertexState.get_vertices();
 	DXX_POISON_VAR(Vertices, 0xfc);
 	if (New_file_format_load)
-		LevelSharedVertexState.Num_vertices = PHYSFSX_readShort(LoadFile);
+		LevelSharedVertexState.Num_vertices = LoadFile.readShort();
 	else
-		LevelSharedVertexState.Num_vertices = PHYSFSX_readInt(LoadFile);
+		LevelSharedVertexState.Num_vertices = LoadFile.readInt();
 	assert(LevelSharedVertexState.Num_vertices <= MAX_VERTICES);
 
 	DXX_POISON_VAR(Segments, 0xfc);
 	if (New_file_format_load)
-		LevelSharedSegmentState.Num_segments = PHYSFSX_readShort(LoadFile);
+		LevelSharedSegmentState.Num_segments = LoadFile.readShort();
 	else
-		LevelSharedSegmentState.Num_segments = PHYSFSX_readInt(LoadFile);
+		LevelSharedSegmentState.Num_segments = LoadFile.readInt();
 	assert(LevelSharedSegmentState.Num_segments <= MAX_SEGMENTS);
 
 	range_for (auto &i, partial_range(Vertices, LevelSharedVertexState.Num_vertices))
-		PHYSFSX_readVector(LoadFile, i);
+		LoadFile.readVector(i);
 
 	const auto Num_segments = LevelSharedSegmentState.Num_segments;
 	for (segnum_t segnum=0; segnum < Num_segments; segnum++ )	{
@@ -913,7 +929,7 @@ int load_mine_data_compiled(PHYSFS_File *LoadFile)
 		#endif
 
 		if (New_file_format_load)
-			bit_mask = PHYSFSX_readByte(LoadFile);
+			bit_mask = LoadFile.readByte();
 		else
 			bit_mask = 0x7f; // read all six children and special stuff...
 
@@ -933,14 +949,14 @@ int load_mine_data_compiled(PHYSFS_File *LoadFile)
 
 		if (Gamesave_current_version <= 5) { // descent 1 thru d2 SHAREWARE level
 			// Read fix	Segments[segnum].static_light (shift down 5 bits, write as short)
-			temp_ushort = PHYSFSX_readShort(LoadFile);
+			temp_ushort = LoadFile.readShort();
 			segp->static_light	= static_cast<fix>(temp_ushort) << 4;
 			//PHYSFS_read( LoadFile, &Segments[segnum].static_light, sizeof(fix), 1 );
 		}
 
 		// Read the walls as a 6 byte array
 		if (New_file_format_load)
-			bit_mask = PHYSFSX_readByte(LoadFile);
+			bit_mask = LoadFile.readByte();
 		else
 			bit_mask = 0x3f; // read all six sides
 		for (int sidenum=0; sidenum<MAX_SIDES_PER_SEGMENT; sidenum++) {
@@ -948,7 +964,7 @@ int load_mine_data_compiled(PHYSFS_File *LoadFile)
 
 			auto &sside = segp->shared_segment::sides[sidenum];
 			if (bit_mask & (1 << sidenum)) {
-				byte_wallnum = PHYSFSX_readByte(LoadFile);
+				byte_wallnum = LoadFile.readByte();
 				if ( byte_wallnum == 255 )
 					sside.wall_num = wall_none;
 				else
@@ -961,7 +977,7 @@ int load_mine_data_compiled(PHYSFS_File *LoadFile)
 			auto &uside = segp->unique_segment::sides[sidenum];
 			if (segp->children[sidenum] == segment_none || segp->shared_segment::sides[sidenum].wall_num != wall_none)	{
 				// Read short Segments[segnum].sides[sidenum].tmap_num;
-				temp_ushort = PHYSFSX_readShort(LoadFile);
+				temp_ushort = LoadFile.readShort();
 #if defined(DXX_BUILD_DESCENT_I)
 				uside.tmap_num = convert_tmap(temp_ushort & 0x7fff);
 
@@ -969,7 +985,7 @@ int load_mine_data_compiled(PHYSFS_File *LoadFile)
 					uside.tmap_num2 = 0;
 				else {
 					// Read short Segments[segnum].sides[sidenum].tmap_num2;
-					uside.tmap_num2 = PHYSFSX_readShort(LoadFile);
+					uside.tmap_num2 = LoadFile.readShort();
 					uside.tmap_num2 =
 						(convert_tmap(uside.tmap_num2 & 0x3fff)) |
 						(uside.tmap_num2 & 0xc000);
@@ -987,7 +1003,7 @@ int load_mine_data_compiled(PHYSFS_File *LoadFile)
 					uside.tmap_num2 = 0;
 				else {
 					// Read short Segments[segnum].sides[sidenum].tmap_num2;
-					uside.tmap_num2 = PHYSFSX_readShort(LoadFile);
+					uside.tmap_num2 = LoadFile.readShort();
 					if (Gamesave_current_version <= 1 && uside.tmap_num2 != 0)
 						uside.tmap_num2 = convert_d1_tmap_num(uside.tmap_num2);
 				}
@@ -995,11 +1011,11 @@ int load_mine_data_compiled(PHYSFS_File *LoadFile)
 
 				// Read uvl Segments[segnum].sides[sidenum].uvls[4] (u,v>>5, write as short, l>>1 write as short)
 				range_for (auto &i, uside.uvls) {
-					temp_short = PHYSFSX_readShort(LoadFile);
+					temp_short = LoadFile.readShort();
 					i.u = static_cast<fix>(temp_short) << 5;
-					temp_short = PHYSFSX_readShort(LoadFile);
+					temp_short = LoadFile.readShort();
 					i.v = static_cast<fix>(temp_short) << 5;
-					temp_ushort = PHYSFSX_readShort(LoadFile);
+					temp_ushort = LoadFile.readShort();
 					i.l = static_cast<fix>(temp_ushort) << 1;
 					//PHYSFS_read( LoadFile, &i.l, sizeof(fix), 1 );
 				}
@@ -1014,7 +1030,7 @@ int load_mine_data_compiled(PHYSFS_File *LoadFile)
 	Vertices.set_count(LevelSharedVertexState.Num_vertices);
 	Segments.set_count(Num_segments);
 
-	validate_segment_all(LevelSharedSegmentState);			// Fill in side type and normals.
+	level_cache_validate_segment_all(LevelSharedSegmentState);			// Fill in side type and normals.
 
 	range_for (const auto &&pi, vmsegptridx)
 	{
@@ -1025,6 +1041,7 @@ int load_mine_data_compiled(PHYSFS_File *LoadFile)
 
 	reset_objects(LevelUniqueObjectState, 1);		//one object, the player
 
+	PHYSFSX_fseek(fp, LoadFile.tell(), SEEK_SET);
 	return 0;
 }
 }
@@ -48,6 +48,9 @@ COPYRIGHT 1993-1999 PARALLAX SOFTWARE CORPORATION.  ALL RIGHTS RESERVED.
 #include "newdemo.h"
 #include "text.h"
 #include "multi.h"
+#if DXX_USE_UDP
+#include "net_udp.h"
+#endif
 #include "hudmsg.h"
 #include "endlevel.h"
 #include "cntrlcen.h"
@@ -59,6 +62,8 @@ COPYRIGHT 1993-1999 PARALLAX SOFTWARE CORPORATION.  ALL RIGHTS RESERVED.
 #include "gameseq.h"
 #include "args.h"
 #include "object.h"
+#include "profile.h"
+#include "texmerge.h"
 
 #include "compiler-range_for.h"
 
@@ -107,6 +112,21 @@ static void game_draw_multi_message(grs_canvas &canvas)
 		gr_printf(canvas, game_font, 0x8000, y, "%s #%d: %s_", TXT_MACRO, defining, Network_message.data());
 }
 
+static void show_profile(grs_canvas &canvas)
+{
+	auto &game_font = *GAME_FONT;
+	gr_set_fontcolor(canvas, BM_XRGB(0, 31, 0), -1);
+	const auto &&line_spacing = LINE_SPACING(*canvas.cv_font, game_font);
+	auto y = line_spacing * 8;
+	for (unsigned i = 0; i != profile_phase_count; ++i, y += line_spacing)
+	{
+		const auto p = static_cast<profile_phase>(i);
+		gr_printf(canvas, game_font, FSPACX(2), y, "%s: %u us", profile_phase_name(p), profile_last_frame_time(p));
+	}
+	const auto &&t = texmerge_get_stats();
+	gr_printf(canvas, game_font, FSPACX(2), y, "texmerge: %u hits %u misses (%u entries)", t.hits, t.misses, t.capacity);
+}
+
 static void show_framerate(grs_canvas &canvas)
 {
 	static int fps_count = 0, fps_rate = 0;
@@ -421,6 +441,14 @@ static void game_draw_hud_stuff(grs_canvas &canvas)
 	if (CGameCfg.FPSIndicator && PlayerCfg.CockpitMode[1] != CM_REAR_VIEW)
 		show_framerate(canvas);
 
+	if (profile_overlay)
+		show_profile(canvas);
+
+#if DXX_USE_UDP
+	if (net_udp_stats_overlay && (Game_mode & GM_NETWORK))
+		net_udp_show_stats(canvas);
+#endif
+
 	if (Newdemo_state == ND_STATE_PLAYBACK)
 		Game_mode = Newdemo_game_mode;
 
@@ -744,6 +772,20 @@ int BigWindowSwitch=0;
 
 static void update_cockpits();
 
+//render the view of the big window, which -gl_dynres may draw at a
+//lower resolution than the HUD over it
+static void render_main_view(grs_canvas &canvas, window_rendered_data &window)
+{
+#if DXX_USE_OGL
+	const auto dynres = ogl_dynres_begin(canvas);
+#endif
+	render_frame(canvas, 0, window);
+#if DXX_USE_OGL
+	if (dynres)
+		ogl_dynres_end(canvas);
+#endif
+}
+
 //render a frame for the game
 void game_render_frame_mono()
 {
@@ -770,7 +812,7 @@ void game_render_frame_mono()
 
 		window_rendered_data window;
 		update_rendered_data(window, *Viewer, 0);
-		render_frame(*grd_curcanv, 0, window);
+		render_main_view(*grd_curcanv, window);
 
 		wake_up_rendered_objects(*Viewer, window);
 		show_HUD_names(*grd_curcanv);
@@ -805,7 +847,7 @@ void game_render_frame_mono()
 #if defined(DXX_BUILD_DESCENT_II)
 		update_rendered_data(window, *Viewer, Rear_view);
 #endif
-		render_frame(*grd_curcanv, 0, window);
+		render_main_view(*grd_curcanv, window);
 	}
 
 #if defined(DXX_BUILD_DESCENT_II)
@@ -23,12 +23,15 @@ COPYRIGHT 1993-1999 PARALLAX SOFTWARE CORPORATION.  ALL RIGHTS RESERVED.
  *
  */
 
+#include <algorithm>
 #include <stdexcept>
 #include <stdio.h>
 #include <string.h>
+#include <vector>
 #include "pstypes.h"
 #include "strutil.h"
 #include "console.h"
+#include "profile.h"
 #include "key.h"
 #include "gr.h"
 #include "palette.h"
@@ -47,6 +50,7 @@ COPYRIGHT 1993-1999 PARALLAX SOFTWARE CORPORATION.  ALL RIGHTS RESERVED.
 #include "wall.h"
 #include "gamemine.h"
 #include "robot.h"
+#include "ai.h"
 #include "bm.h"
 #include "menu.h"
 #include "fireball.h"
@@ -66,11 +70,16 @@ COPYRIGHT 1993-1999 PARALLAX SOFTWARE CORPORATION.  ALL RIGHTS RESERVED.
 #include "gamesave.h"
 #include "gamepal.h"
 #include "physics.h"
+#include "render.h"
+#include "lighting.h"
 #include "laser.h"
 #include "multi.h"
 #include "makesig.h"
 #include "textures.h"
 #include "d_enumerate.h"
+#include "args.h"
+#include "hash.h"
+#include "piggy.h"
 
 #include "dxxsconf.h"
 #include "compiler-range_for.h"
@@ -120,6 +129,8 @@ char Gamesave_current_filename[PATH_MAX];
 
 int Gamesave_current_version;
 
+uint64_t Gamesave_current_hash;
+
 #if defined(DXX_BUILD_DESCENT_I)
 #define GAME_VERSION					25
 #elif defined(DXX_BUILD_DESCENT_II)
@@ -1232,6 +1243,406 @@ const char *Level_being_loaded=NULL;
 int no_old_level_file_error=0;
 #endif
 
+/* Tables which are derived from a level each time it is loaded are kept
+ * in the levelcache directory of the write directory, one file per
+ * level.  A file is named after a hash of the level file and of the
+ * game data which the tables depend on, so an edited level or a changed
+ * texture set gets a new file instead of reusing stale tables.  The
+ * side types and normals, the ambient sound flags and the potentially
+ * visible set are computed the first time a level is loaded and read
+ * back afterwards.
+ */
+#define LEVEL_CACHE_DIRECTORY	"levelcache"
+namespace dsx {
+namespace {
+
+constexpr uint32_t level_cache_magic = 0x4c435844;	// "DXCL"
+constexpr uint32_t level_cache_version = 1;
+
+struct level_cache_header
+{
+	uint32_t magic, version;
+	uint64_t key;
+	// hash of everything after the header
+	uint64_t check;
+	uint32_t num_segments;
+	// runs in the potentially visible set, 0 if none is stored
+	uint32_t pvs_runs;
+};
+
+struct level_cache_side
+{
+	array<vms_vector, 2> normals;
+	int16_t tmap_num;
+	uint8_t type;
+	uint8_t pad;
+};
+
+struct level_cache_segment
+{
+	array<level_cache_side, MAX_SIDES_PER_SEGMENT> sides;
+#if defined(DXX_BUILD_DESCENT_II)
+	uint8_t s2_flags;
+	array<uint8_t, 3> pad;
+#endif
+};
+
+struct level_cache_state
+{
+	uint64_t key;
+	// key is for the current level, which may use the cache
+	bool enabled;
+	// the tables below were read from the cache
+	bool hit;
+	std::vector<level_cache_segment> segments;
+	std::vector<uint16_t> pvs_runs;
+	std::vector<uint32_t> pvs_offsets;
+};
+
+static level_cache_state level_cache;
+
+static void level_cache_filename(const uint64_t key, const char *const suffix, array<char, PATH_MAX> &filename)
+{
+	snprintf(filename.data(), filename.size(), LEVEL_CACHE_DIRECTORY "/%08x%08x%s.bin", static_cast<unsigned>(key >> 32), static_cast<unsigned>(key), suffix);
+}
+
+static uint64_t level_content_hash(PHYSFS_File *const fp, const char *const filename)
+{
+	fnv1a_hash h;
+	array<uint8_t, 4096> buf;
+	for (PHYSFS_sint64 n; (n = PHYSFS_read(fp, buf.data(), 1, buf.size())) > 0;)
+		h.add(buf.data(), n);
+	if (!PHYSFS_seek(fp, 0))
+		Error("Cannot rewind level file <%s>: %s", filename, PHYSFS_getLastError());
+	return h.get();
+}
+
+static uint64_t level_cache_key(const char *const filename)
+{
+	fnv1a_hash h;
+	h.add(level_cache_version);
+	/* load_level patches a few retail levels by mission and file name. */
+	if (Current_mission)
+	{
+		const char *const longname = Current_mission_longname;
+		h.add(longname, strlen(longname));
+	}
+	h.add(filename, strlen(filename) + 1);
+	h.add(Gamesave_current_hash);
+	/* Invalid textures are replaced, and the ambient sound flags follow
+	 * the texture flags and which textures can be seen through.
+	 */
+	h.add(NumTextures);
+	auto &TmapInfo = LevelUniqueTmapInfoState.TmapInfo;
+	for (unsigned i = 0; i != NumTextures; ++i)
+	{
+		h.add(TmapInfo[i].flags);
+		h.add(Textures[i]);
+		h.add(GameBitmaps[Textures[i].index].get_flags());
+	}
+	return h.get();
+}
+
+static void level_cache_read(const uint64_t key)
+{
+	auto &c = level_cache;
+	array<char, PATH_MAX> filename;
+	level_cache_filename(key, "", filename);
+	RAIIPHYSFS_File fp{PHYSFS_openRead(filename.data())};
+	if (!fp)
+		return;
+	level_cache_header h;
+	if (PHYSFS_read(fp, &h, sizeof(h), 1) != 1 ||
+		h.magic != level_cache_magic || h.version != level_cache_version || h.key != key ||
+		h.num_segments != static_cast<unsigned>(Highest_segment_index) + 1)
+		return;
+	c.segments.resize(h.num_segments);
+	if (h.pvs_runs)
+	{
+		c.pvs_offsets.resize(h.num_segments + 1);
+		c.pvs_runs.resize(h.pvs_runs);
+	}
+	const std::size_t segments_size = c.segments.size() * sizeof(c.segments[0]);
+	const std::size_t offsets_size = c.pvs_offsets.size() * sizeof(c.pvs_offsets[0]);
+	const std::size_t runs_size = c.pvs_runs.size() * sizeof(c.pvs_runs[0]);
+	fnv1a_hash check;
+	if (PHYSFS_read(fp, c.segments.data(), 1, segments_size) == segments_size &&
+		PHYSFS_read(fp, c.pvs_offsets.data(), 1, offsets_size) == offsets_size &&
+		PHYSFS_read(fp, c.pvs_runs.data(), 1, runs_size) == runs_size &&
+		(check.add(c.segments.data(), segments_size), check.add(c.pvs_offsets.data(), offsets_size), check.add(c.pvs_runs.data(), runs_size), check.get() == h.check))
+	{
+		c.hit = true;
+		return;
+	}
+	c.segments.clear();
+	c.pvs_offsets.clear();
+	c.pvs_runs.clear();
+}
+
+static void level_cache_write()
+{
+	auto &c = level_cache;
+	if (c.segments.size() != static_cast<std::size_t>(Highest_segment_index) + 1)
+		/* The level was not read by load_mine_data_compiled. */
+		return;
+	level_cache_header h{};
+	h.magic = level_cache_magic;
+	h.version = level_cache_version;
+	h.key = c.key;
+	h.num_segments = c.segments.size();
+	h.pvs_runs = c.pvs_runs.size();
+	const std::size_t segments_size = c.segments.size() * sizeof(c.segments[0]);
+	const std::size_t offsets_size = c.pvs_offsets.size() * sizeof(c.pvs_offsets[0]);
+	const std::size_t runs_size = c.pvs_runs.size() * sizeof(c.pvs_runs[0]);
+	fnv1a_hash check;
+	check.add(c.segments.data(), segments_size);
+	check.add(c.pvs_offsets.data(), offsets_size);
+	check.add(c.pvs_runs.data(), runs_size);
+	h.check = check.get();
+	array<char, PATH_MAX> filename;
+	level_cache_filename(c.key, "", filename);
+	PHYSFS_mkdir(LEVEL_CACHE_DIRECTORY);
+	auto fp = PHYSFSX_openReplaceBuffered(filename.data());
+	if (!fp)
+		return;
+	if (PHYSFS_write(fp, &h, sizeof(h), 1) != 1 ||
+		PHYSFS_write(fp, c.segments.data(), 1, segments_size) != segments_size ||
+		PHYSFS_write(fp, c.pvs_offsets.data(), 1, offsets_size) != offsets_size ||
+		PHYSFS_write(fp, c.pvs_runs.data(), 1, runs_size) != runs_size ||
+		!PHYSFSX_commitReplace(fp, filename.data()))
+		con_printf(CON_URGENT, "DXX-Rebirth: failed to write %s: %s", filename.data(), PHYSFS_getLastError());
+}
+
+/* Boss segment lists are built at AI setup, after the level is loaded,
+ * from where the boss starts and from the walls at that time, so they
+ * go in a file of their own with a key for both.
+ */
+struct level_cache_boss_header
+{
+	uint32_t magic, version;
+	uint64_t key, boss_key;
+	// hash of the segment numbers which follow the header
+	uint64_t check;
+	uint32_t gate_segs, teleport_segs;
+};
+
+static bool level_cache_boss_enabled()
+{
+#if DXX_USE_EDITOR
+	/* The mine may have been edited since it was loaded. */
+	if (EditorWindow)
+		return false;
+#endif
+	return level_cache.enabled;
+}
+
+static uint64_t level_cache_boss_key(const object_base &boss)
+{
+	fnv1a_hash h;
+	h.add(boss.segnum);
+	h.add(boss.pos);
+	h.add(boss.size);
+	/* Which sides the boss can pass depends on the walls and the
+	 * textures, which differ from the level file in a saved game.
+	 */
+	auto &Walls = LevelUniqueWallSubsystemState.Walls;
+	range_for (const auto &&w, Walls.vcptr)
+	{
+		h.add(w->type);
+		h.add(w->flags);
+		h.add(w->state);
+	}
+	range_for (const auto &&segp, vcsegptr)
+		range_for (const auto &uside, segp->unique_segment::sides)
+		{
+			h.add(uside.tmap_num);
+			h.add(uside.tmap_num2);
+		}
+	return h.get();
+}
+
+}
+
+bool level_cache_read_boss_segments(const object_base &boss, d_level_shared_boss_state &s)
+{
+	if (!level_cache_boss_enabled())
+		return false;
+	array<char, PATH_MAX> filename;
+	level_cache_filename(level_cache.key, "-boss", filename);
+	RAIIPHYSFS_File fp{PHYSFS_openRead(filename.data())};
+	if (!fp)
+		return false;
+	level_cache_boss_header h;
+	if (PHYSFS_read(fp, &h, sizeof(h), 1) != 1 ||
+		h.magic != level_cache_magic || h.version != level_cache_version ||
+		h.key != level_cache.key || h.boss_key != level_cache_boss_key(boss) ||
+		h.gate_segs > s.Gate_segs.max_size() || !h.teleport_segs || h.teleport_segs > s.Teleport_segs.max_size())
+		return false;
+	std::vector<segnum_t> segs(h.gate_segs + h.teleport_segs);
+	const std::size_t size = segs.size() * sizeof(segs[0]);
+	if (PHYSFS_read(fp, segs.data(), 1, size) != size)
+		return false;
+	fnv1a_hash check;
+	check.add(segs.data(), size);
+	if (check.get() != h.check)
+		return false;
+	if (std::any_of(segs.begin(), segs.end(), [](const segnum_t segnum) { return segnum > Highest_segment_index; }))
+		return false;
+	s.Gate_segs.clear();
+	s.Teleport_segs.clear();
+	range_for (const auto segnum, partial_range(segs, h.gate_segs))
+		s.Gate_segs.emplace_back(segnum);
+	range_for (const auto segnum, partial_range(segs, h.gate_segs, h.gate_segs + h.teleport_segs))
+		s.Teleport_segs.emplace_back(segnum);
+	return true;
+}
+
+void level_cache_write_boss_segments(const object_base &boss, const d_level_shared_boss_state &s)
+{
+	if (!level_cache_boss_enabled())
+		return;
+	std::vector<segnum_t> segs(s.Gate_segs.begin(), s.Gate_segs.end());
+	segs.insert(segs.end(), s.Teleport_segs.begin(), s.Teleport_segs.end());
+	const std::size_t size = segs.size() * sizeof(segs[0]);
+	level_cache_boss_header h{};
+	h.magic = level_cache_magic;
+	h.version = level_cache_version;
+	h.key = level_cache.key;
+	h.boss_key = level_cache_boss_key(boss);
+	fnv1a_hash check;
+	check.add(segs.data(), size);
+	h.check = check.get();
+	h.gate_segs = s.Gate_segs.size();
+	h.teleport_segs = s.Teleport_segs.size();
+	array<char, PATH_MAX> filename;
+	level_cache_filename(level_cache.key, "-boss", filename);
+	PHYSFS_mkdir(LEVEL_CACHE_DIRECTORY);
+	auto fp = PHYSFSX_openReplaceBuffered(filename.data());
+	if (!fp)
+		return;
+	if (PHYSFS_write(fp, &h, sizeof(h), 1) != 1 ||
+		(size && PHYSFS_write(fp, segs.data(), 1, size) != size) ||
+		!PHYSFSX_commitReplace(fp, filename.data()))
+		con_printf(CON_URGENT, "DXX-Rebirth: failed to write %s: %s", filename.data(), PHYSFS_getLastError());
+}
+
+/* Set the key for the level in fp, which must be at its start, and leave
+ * fp there again.  The tables are read later by load_mine_data_compiled,
+ * once the number of segments is known.
+ */
+static void level_cache_begin(const char *const filename)
+{
+	auto &c = level_cache;
+	c.enabled = false;
+	c.hit = false;
+	c.segments.clear();
+	c.pvs_offsets.clear();
+	c.pvs_runs.clear();
+	if (CGameArg.SysNoLevelCache)
+		return;
+#if DXX_USE_EDITOR
+	/* The editor expects degenerate segments to be reported. */
+	if (EditorWindow)
+		return;
+#endif
+	c.key = level_cache_key(filename);
+	c.enabled = true;
+}
+
+//	Write the tables if they were computed for this level, then release
+//	them.  The key is kept for the boss segment lists.
+static void level_cache_end()
+{
+	auto &c = level_cache;
+	if (c.enabled && !c.hit)
+		level_cache_write();
+	c.hit = false;
+	c.segments.clear();
+	c.segments.shrink_to_fit();
+	c.pvs_offsets.clear();
+	c.pvs_offsets.shrink_to_fit();
+	c.pvs_runs.clear();
+	c.pvs_runs.shrink_to_fit();
+}
+
+void level_cache_validate_segment_all(d_level_shared_segment_state &LevelSharedSegmentState)
+{
+	auto &c = level_cache;
+	auto &Segments = LevelSharedSegmentState.get_segments();
+	if (c.enabled)
+		level_cache_read(c.key);
+	if (!c.hit)
+	{
+		validate_segment_all(LevelSharedSegmentState);
+		if (!c.enabled)
+			return;
+		c.segments.resize(Highest_segment_index + 1);
+		range_for (const auto &&segp, Segments.vcptridx)
+		{
+			auto &e = c.segments[segp];
+			for (unsigned sidenum = 0; sidenum != MAX_SIDES_PER_SEGMENT; ++sidenum)
+			{
+				auto &sside = segp->shared_segment::sides[sidenum];
+				auto &cs = e.sides[sidenum];
+				cs = {};
+				cs.normals = sside.normals;
+				cs.tmap_num = segp->unique_segment::sides[sidenum].tmap_num;
+				cs.type = static_cast<uint8_t>(sside.get_type());
+			}
+		}
+		return;
+	}
+	range_for (const auto &&segp, Segments.vmptridx)
+	{
+		auto &e = c.segments[segp];
+		for (unsigned sidenum = 0; sidenum != MAX_SIDES_PER_SEGMENT; ++sidenum)
+		{
+			auto &sside = segp->shared_segment::sides[sidenum];
+			auto &cs = e.sides[sidenum];
+			sside.normals = cs.normals;
+			sside.set_type(cs.type);
+			segp->unique_segment::sides[sidenum].tmap_num = cs.tmap_num;
+		}
+	}
+#if DXX_USE_EDITOR
+	range_for (auto &s, partial_range(Segments, Highest_segment_index + 1, Segments.size()))
+		s.segnum = segment_none;
+#endif
+}
+
+#if defined(DXX_BUILD_DESCENT_II)
+static void level_cache_set_ambient_sound_flags()
+{
+	auto &c = level_cache;
+	if (c.segments.size() != static_cast<std::size_t>(Highest_segment_index) + 1)
+	{
+		set_ambient_sound_flags();
+		return;
+	}
+	if (c.hit)
+	{
+		range_for (const auto &&segp, vmsegptridx)
+			segp->s2_flags = c.segments[segp].s2_flags;
+		return;
+	}
+	set_ambient_sound_flags();
+	range_for (const auto &&segp, vcsegptridx)
+		c.segments[segp].s2_flags = segp->s2_flags;
+}
+#endif
+
+static void level_cache_build_pvs()
+{
+	auto &c = level_cache;
+	if (!CGameArg.DbgNoPVS && c.hit && !c.pvs_runs.empty() && render_set_pvs(std::move(c.pvs_runs), std::move(c.pvs_offsets)))
+		return;
+	render_build_pvs();
+	if (c.enabled && !c.hit)
+		render_get_pvs(c.pvs_runs, c.pvs_offsets);
+}
+
+}
+
 //loads a level (.LVL) file from disk
 //returns 0 if success, else error code
 namespace dsx {
@@ -1241,6 +1652,7 @@ int load_level(
 #endif
 	const char * filename_passed)
 {
+	const trace_scope trace_phase("load_level", filename_passed);
 #if DXX_USE_EDITOR
 	int use_compiled_level=1;
 #endif
@@ -1290,6 +1702,8 @@ int load_level(
 	}
 
 	strcpy( Gamesave_current_filename, filename );
+	Gamesave_current_hash = level_content_hash(LoadFile, filename);
+	level_cache_begin(filename);
 
 	sig                      = PHYSFSX_readInt(LoadFile);
 	Gamesave_current_version = PHYSFSX_readInt(LoadFile);
@@ -1423,6 +1837,8 @@ int load_level(
 	if (mine_err == -1) {   //error!!
 		return 2;
 	}
+	//	Before the objects are placed into segments.
+	build_segment_point_grid();
 
 	PHYSFSX_fseek(LoadFile,gamedata_offset,SEEK_SET);
 	game_err = load_game_data(
@@ -1438,7 +1854,7 @@ int load_level(
 	//======================== CLOSE FILE =============================
 	LoadFile.reset();
 #if defined(DXX_BUILD_DESCENT_II)
-	set_ambient_sound_flags();
+	level_cache_set_ambient_sound_flags();
 #endif
 
 #if DXX_USE_EDITOR
@@ -1487,6 +1903,11 @@ int load_level(
 #if defined(DXX_BUILD_DESCENT_II)
 	compute_slide_segs();
 #endif
+	level_cache_build_pvs();
+	level_cache_end();
+	render_build_segment_tables();
+	ai_build_nav_segments();
+	reset_dynamic_light();
 	return 0;
 }
 }
@@ -1787,7 +2208,7 @@ static int save_level_sub(
 			change_filename_extension(temp_filename, filename, "." D1X_LEVEL_FILE_EXTENSION);
 	}
 
-	auto SaveFile = PHYSFSX_openWriteBuffered(temp_filename);
+	auto SaveFile = PHYSFSX_openReplaceBuffered(temp_filename);
 	if (!SaveFile)
 	{
 		gr_palette_load(gr_palette);
@@ -1898,6 +2319,12 @@ static int save_level_sub(
 #endif
 
 	//==================== CLOSE THE FILE =============================
+	if (!PHYSFSX_commitReplace(SaveFile, temp_filename))
+	{
+		gr_palette_load(gr_palette);
+		nm_messagebox( NULL, 1, "Ok", "ERROR: Cannot write to '%s'.", temp_filename);
+		return 1;
+	}
 
 //	if ( !compiled_version )
 	{
@@ -25,11 +25,14 @@ COPYRIGHT 1993-1999 PARALLAX SOFTWARE CORPORATION.  ALL RIGHTS RESERVED.
 
 #include <algorithm>
 #include <cassert>
+#include <unordered_map>
+#include <vector>
 #include <stdlib.h>
 #include <stdio.h>
 #include <string.h>	//	for memset()
 
 #include "u_mem.h"
+#include "level_arena.h"
 #include "inferno.h"
 #include "game.h"
 #include "dxxerror.h"
@@ -45,6 +48,7 @@ COPYRIGHT 1993-1999 PARALLAX SOFTWARE CORPORATION.  ALL RIGHTS RESERVED.
 #include "byteutil.h"
 #include "lighting.h"
 #include "mission.h"
+#include "hash.h"
 #if DXX_USE_EDITOR
 #include "editor/editor.h"
 #endif
@@ -143,6 +147,20 @@ void compute_segment_center(fvcvertptr &vcvertptr, vms_vector &vp, const shared_
 	compute_segment_center(vcvertptr, vp, sp.verts);
 }
 
+// ------------------------------------------------------------------------------------------
+// Compute the radius of the smallest sphere around center which holds every point of the segment.
+fix compute_segment_radius(fvcvertptr &vcvertptr, const shared_segment &sp, const vms_vector &center)
+{
+	fix r = 0;
+	range_for (auto &v, sp.verts)
+	{
+		const fix d = vm_vec_dist(center, vcvertptr(v));
+		if (r < d)
+			r = d;
+	}
+	return r;
+}
+
 // -----------------------------------------------------------------------------
 //	Given two segments, return the side index in the connecting segment which connects to the base segment
 //	Optimized by MK on 4/21/94 because it is a 2% load.
@@ -275,6 +293,18 @@ uint_fast32_t create_abs_vertex_lists(vertex_array_list_t &vertices, const share
 	return create_vertex_lists_by_predicate(vertices, segp, sidep, abs_vertex_lists_predicate(segp, sidenum));
 }
 
+//distance of the vertex which the two faces of a triangulated side do not
+//share from the plane of the other face, telling whether the side pokes
+//in or out
+template <typename V>
+static fix side_mdist(fvcvertptr &vcvertptr, const shared_side &s, const V &vertex_list, const vms_vector &mvert)
+{
+	auto a = vertex_list[4] < vertex_list[1]
+		? std::make_pair(vertex_list[4], &s.normals[0])
+		: std::make_pair(vertex_list[1], &s.normals[1]);
+	return vm_dist_to_plane(vcvertptr(a.first), *a.second, mvert);
+}
+
 //returns 3 different bitmasks with info telling if this sphere is in
 //this segment.  See segmasks structure for info on fields  
 segmasks get_seg_masks(fvcvertptr &vcvertptr, const vms_vector &checkp, const shared_segment &seg, const fix rad)
@@ -305,11 +335,6 @@ segmasks get_seg_masks(fvcvertptr &vcvertptr, const vms_vector &checkp, const sh
 			const auto vertnum = min(vertex_list[0],vertex_list[2]);
 			const auto &&mvert = vcvertptr(vertnum);
 
-			auto a = vertex_list[4] < vertex_list[1]
-				? std::make_pair(vertex_list[4], &s.normals[0])
-				: std::make_pair(vertex_list[1], &s.normals[1]);
-			const auto mdist = vm_dist_to_plane(vcvertptr(a.first), *a.second, mvert);
-
 			side_count = center_count = 0;
 
 			for (int fn=0;fn<2;fn++,facebit<<=1) {
@@ -325,7 +350,10 @@ segmasks get_seg_masks(fvcvertptr &vcvertptr, const vms_vector &checkp, const sh
 				}
 			}
 
-			if (!(mdist > PLANE_DIST_TOLERANCE)) {		//must be behind both faces
+			//	Whether the side pokes in or out only matters when the
+			//	point is behind exactly one face, so skip the plane test
+			//	which decides it otherwise.
+			if ((side_count == 1 || center_count == 1) && !(side_mdist(vcvertptr, s, vertex_list, mvert) > PLANE_DIST_TOLERANCE)) {		//must be behind both faces
 
 				if (side_count==2)
 					masks.sidemask |= sidebit;
@@ -403,11 +431,6 @@ static uint8_t get_side_dists(fvcvertptr &vcvertptr, const vms_vector &checkp, c
 			const auto vertnum = min(vertex_list[0],vertex_list[2]);
 			auto &mvert = *vcvertptr(vertnum);
 
-			auto a = vertex_list[4] < vertex_list[1]
-				? std::make_pair(vertex_list[4], &s.normals[0])
-				: std::make_pair(vertex_list[1], &s.normals[1]);
-			const auto mdist = vm_dist_to_plane(vcvertptr(a.first), *a.second, mvert);
-
 			center_count = 0;
 
 			for (int fn=0;fn<2;fn++,facebit<<=1) {
@@ -421,7 +444,9 @@ static uint8_t get_side_dists(fvcvertptr &vcvertptr, const vms_vector &checkp, c
 
 			}
 
-			if (!(mdist > PLANE_DIST_TOLERANCE)) {		//must be behind both faces
+			//	As in get_seg_masks, the shape of the side only matters
+			//	when the point is behind exactly one face.
+			if (center_count == 1 && !(side_mdist(vcvertptr, s, vertex_list, mvert) > PLANE_DIST_TOLERANCE)) {		//must be behind both faces
 
 				if (center_count==2) {
 					mask |= sidebit;
@@ -572,6 +597,129 @@ int check_segment_connections(void)
 	return errors;
 }
 
+namespace {
+
+//	Every segment, listed under each cell of a uniform grid which its
+//	bounding box overlaps.  The lists are in segment order, so testing a
+//	cell's list finds the same segment as testing every segment would.
+struct segment_point_grid
+{
+	unsigned num_segments;
+	array<fix, 3> mins;
+	array<unsigned, 3> cells;
+	array<int64_t, 3> cell_size;
+	unsigned generation;
+	level_arena_vector<uint32_t> cell_start;
+	level_arena_vector<segnum_t> segs;
+};
+
+static segment_point_grid Segment_point_grid;
+
+//	Never many more cells along an axis than this, and never cells
+//	smaller than a typical segment.
+constexpr unsigned segment_point_grid_max_cells = 32;
+constexpr fix segment_point_grid_min_cell_size = F1_0 * 20;
+//	A point inside a segment with sides which are not planar may lie a
+//	little outside the box of its vertices.
+constexpr fix segment_point_grid_pad = F1_0;
+
+static array<fix, 3> vector_to_array(const vms_vector &v)
+{
+	return {{v.x, v.y, v.z}};
+}
+
+static unsigned segment_point_grid_index(const segment_point_grid &g, const array<unsigned, 3> &c)
+{
+	return (c[2] * g.cells[1] + c[1]) * g.cells[0] + c[0];
+}
+
+template <typename F>
+static void segment_point_grid_for_each_cell(const segment_point_grid &g, const array<fix, 3> &lo, const array<fix, 3> &hi, F &&f)
+{
+	array<unsigned, 3> clo, chi, c;
+	for (unsigned a = 0; a != 3; ++a)
+	{
+		clo[a] = static_cast<unsigned>((static_cast<int64_t>(lo[a]) - g.mins[a]) / g.cell_size[a]);
+		chi[a] = static_cast<unsigned>((static_cast<int64_t>(hi[a]) - g.mins[a]) / g.cell_size[a]);
+	}
+	for (c[2] = clo[2]; c[2] <= chi[2]; ++c[2])
+		for (c[1] = clo[1]; c[1] <= chi[1]; ++c[1])
+			for (c[0] = clo[0]; c[0] <= chi[0]; ++c[0])
+				f(segment_point_grid_index(g, c));
+}
+
+}
+
+void build_segment_point_grid()
+{
+	auto &g = Segment_point_grid;
+	g.cell_start = level_arena_vector<uint32_t>();
+	g.segs = level_arena_vector<segnum_t>();
+	g.generation = level_arena_generation();
+	const unsigned num_segments = Highest_segment_index + 1;
+	g.num_segments = num_segments;
+	if (!num_segments)
+		return;
+	auto &Vertices = LevelSharedVertexState.get_vertices();
+	auto &vcvertptr = Vertices.vcptr;
+	std::vector<std::pair<array<fix, 3>, array<fix, 3>>> boxes;
+	boxes.reserve(num_segments);
+	array<fix, 3> mins, maxs;
+	mins.fill(INT32_MAX);
+	maxs.fill(INT32_MIN);
+	for (unsigned segnum = 0; segnum != num_segments; ++segnum)
+	{
+		auto &seg = *vcsegptr(static_cast<segnum_t>(segnum));
+		array<fix, 3> lo, hi;
+		lo.fill(INT32_MAX);
+		hi.fill(INT32_MIN);
+		range_for (const auto v, seg.verts)
+		{
+			const auto &&p = vector_to_array(*vcvertptr(v));
+			for (unsigned a = 0; a != 3; ++a)
+			{
+				lo[a] = std::min(lo[a], p[a]);
+				hi[a] = std::max(hi[a], p[a]);
+			}
+		}
+		for (unsigned a = 0; a != 3; ++a)
+		{
+			lo[a] = lo[a] < INT32_MIN + segment_point_grid_pad ? INT32_MIN : lo[a] - segment_point_grid_pad;
+			hi[a] = hi[a] > INT32_MAX - segment_point_grid_pad ? INT32_MAX : hi[a] + segment_point_grid_pad;
+			mins[a] = std::min(mins[a], lo[a]);
+			maxs[a] = std::max(maxs[a], hi[a]);
+		}
+		boxes.emplace_back(lo, hi);
+	}
+	unsigned num_cells = 1;
+	g.mins = mins;
+	for (unsigned a = 0; a != 3; ++a)
+	{
+		const int64_t extent = static_cast<int64_t>(maxs[a]) - mins[a] + 1;
+		const auto want = extent / segment_point_grid_min_cell_size;
+		g.cells[a] = want < 1 ? 1 : (want > segment_point_grid_max_cells ? segment_point_grid_max_cells : static_cast<unsigned>(want));
+		g.cell_size[a] = (extent + g.cells[a] - 1) / g.cells[a];
+		num_cells *= g.cells[a];
+	}
+	//	Count the segments in each cell, then place them.
+	g.cell_start.assign(num_cells + 1, 0);
+	range_for (auto &b, boxes)
+		segment_point_grid_for_each_cell(g, b.first, b.second, [&g](const unsigned cell) {
+			++ g.cell_start[cell + 1];
+		});
+	for (unsigned i = 0; i != num_cells; ++i)
+		g.cell_start[i + 1] += g.cell_start[i];
+	g.segs.resize(g.cell_start.back());
+	std::vector<uint32_t> next(g.cell_start.begin(), g.cell_start.end() - 1);
+	for (unsigned segnum = 0; segnum != num_segments; ++segnum)
+	{
+		auto &b = boxes[segnum];
+		segment_point_grid_for_each_cell(g, b.first, b.second, [&g, &next, segnum](const unsigned cell) {
+			g.segs[next[cell]++] = segnum;
+		});
+	}
+}
+
 // Used to become a constant based on editor, but I wanted to be able to set
 // this for omega blob find_point_seg calls.
 // Would be better to pass a paremeter to the routine...--MK, 01/17/96
@@ -659,6 +807,33 @@ icsegptridx_t find_point_seg(const d_level_shared_segment_state &LevelSharedSegm
 		auto &Segments = LevelSharedSegmentState.get_segments();
 		auto &LevelSharedVertexState = LevelSharedSegmentState.get_vertex_state();
 		auto &Vertices = LevelSharedVertexState.get_vertices();
+		auto &g = Segment_point_grid;
+		if (!g.cell_start.empty() && g.num_segments == static_cast<unsigned>(Highest_segment_index) + 1 && g.generation == level_arena_generation()
+#if DXX_USE_EDITOR
+			//	The mine may have been edited since the grid was built.
+			&& !EditorWindow
+#endif
+			)
+		{
+			const auto &&pa = vector_to_array(p);
+			array<unsigned, 3> c;
+			for (unsigned a = 0; a != 3; ++a)
+			{
+				const int64_t d = static_cast<int64_t>(pa[a]) - g.mins[a];
+				if (d < 0 || d >= g.cell_size[a] * g.cells[a])
+					/* Outside every segment's box */
+					return segment_none;
+				c[a] = static_cast<unsigned>(d / g.cell_size[a]);
+			}
+			const auto cell = segment_point_grid_index(g, c);
+			for (auto i = g.cell_start[cell], e = g.cell_start[cell + 1]; i != e; ++i)
+			{
+				const auto &&segp = Segments.vmptridx(g.segs[i]);
+				if (get_seg_masks(Vertices.vcptr, p, segp, 0).centermask == 0)
+					return segp;
+			}
+			return segment_none;
+		}
 		range_for (const auto &&segp, Segments.vmptridx)
 		{
 			if (get_seg_masks(Vertices.vcptr, p, segp, 0).centermask == 0)
@@ -744,60 +919,88 @@ icsegptridx_t find_point_seg(const d_level_shared_segment_state &LevelSharedSegm
 
 namespace dsx {
 #if defined(DXX_BUILD_DESCENT_I)
-static inline void add_to_fcd_cache(int seg0, int seg1, int depth, vm_distance dist)
+namespace {
+
+struct fcd_key
+{
+};
+
+}
+
+static inline void add_to_fcd_cache(const fcd_key &, int depth, vm_distance dist)
 {
-	(void)(seg0||seg1||depth||dist);
+	(void)(depth||dist);
 }
 #elif defined(DXX_BUILD_DESCENT_II)
 #define	MIN_CACHE_FCD_DIST	(F1_0*80)	//	Must be this far apart for cache lookup to succeed.  Recognizes small changes in distance matter at small distances.
-#define	MAX_FCD_CACHE	8
+#define	MAX_FCD_CACHE	4096	//	Must be a power of 2.
 
 namespace {
 
-struct fcd_data {
+struct fcd_key
+{
 	segnum_t	seg0, seg1;
+	int max_depth;
+	unsigned wid_flag;
+	unsigned slot() const
+	{
+		fnv1a_hash h;
+		h.add(seg0);
+		h.add(seg1);
+		h.add(max_depth);
+		h.add(wid_flag);
+		return h.get() & (MAX_FCD_CACHE - 1);
+	}
+	bool operator==(const fcd_key &k) const
+	{
+		return seg0 == k.seg0 && seg1 == k.seg1 && max_depth == k.max_depth && wid_flag == k.wid_flag;
+	}
+};
+
+struct fcd_data {
+	fcd_key key;
+	unsigned generation;
 	int csd;
 	vm_distance dist;
 };
 
 }
 
-int	Fcd_index = 0;
+//	Entries from an older generation are empty.  Walls opening, closing,
+//	cloaking or being destroyed change the generation, so the paths which
+//	were found stay valid for as long as no wall changes.
+static unsigned Fcd_generation = 1;
 static array<fcd_data, MAX_FCD_CACHE> Fcd_cache;
-fix64	Last_fcd_flush_time;
+static fcd_cache_stats Fcd_stats;
 
 //	----------------------------------------------------------------------------------------------------------
 void flush_fcd_cache(void)
 {
-	Fcd_index = 0;
+	++Fcd_generation;
+}
 
-	range_for (auto &i, Fcd_cache)
-		i.seg0 = segment_none;
+unsigned fcd_cache_generation()
+{
+	return Fcd_generation;
+}
+
+fcd_cache_stats fcd_cache_get_stats()
+{
+	return Fcd_stats;
 }
 
 //	----------------------------------------------------------------------------------------------------------
-static void add_to_fcd_cache(int seg0, int seg1, int depth, vm_distance dist)
+static void add_to_fcd_cache(const fcd_key &key, int depth, vm_distance dist)
 {
+	auto &i = Fcd_cache[key.slot()];
 	if (dist > MIN_CACHE_FCD_DIST) {
-		Fcd_cache[Fcd_index].seg0 = seg0;
-		Fcd_cache[Fcd_index].seg1 = seg1;
-		Fcd_cache[Fcd_index].csd = depth;
-		Fcd_cache[Fcd_index].dist = dist;
-
-		Fcd_index++;
-
-		if (Fcd_index >= MAX_FCD_CACHE)
-			Fcd_index = 0;
-	} else {
+		i.key = key;
+		i.generation = Fcd_generation;
+		i.csd = depth;
+		i.dist = dist;
+	} else if (i.key == key)
 		//	If it's in the cache, remove it.
-		range_for (auto &i, Fcd_cache)
-			if (i.seg0 == seg0)
-				if (i.seg1 == seg1) {
-					Fcd_cache[Fcd_index].seg0 = segment_none;
-					break;
-				}
-	}
-
+		i.generation = 0;
 }
 #endif
 
@@ -842,19 +1045,19 @@ vm_distance find_connected_distance(const vms_vector &p0, const vcsegptridx_t se
 	}
 
 #if defined(DXX_BUILD_DESCENT_II)
-	//	Periodically flush cache.
-	if ((GameTime64 - Last_fcd_flush_time > F1_0*2) || (GameTime64 < Last_fcd_flush_time)) {
-		flush_fcd_cache();
-		Last_fcd_flush_time = GameTime64;
-	}
-
-	else
+	const fcd_key key{seg0, seg1, max_depth, wid_flag.value};
 	//	Can't quickly get distance, so see if in Fcd_cache.
-	range_for (auto &i, Fcd_cache)
-		if (i.seg0 == seg0 && i.seg1 == seg1)
+	{
+		auto &i = Fcd_cache[key.slot()];
+		if (i.generation == Fcd_generation && i.key == key)
 		{
+			++Fcd_stats.hits;
 			return i.dist;
 		}
+		++Fcd_stats.misses;
+	}
+#else
+	const fcd_key key{};
 #endif
 
 	num_points = 0;
@@ -885,7 +1088,7 @@ vm_distance find_connected_distance(const vms_vector &p0, const vcsegptridx_t se
 					if (max_depth != -1) {
 						if (depth[qtail-1] == max_depth) {
 							constexpr auto Connected_segment_distance = 1000;
-							add_to_fcd_cache(seg0, seg1, Connected_segment_distance, fcd_abort_cache_value);
+							add_to_fcd_cache(key, Connected_segment_distance, fcd_abort_cache_value);
 							return fcd_abort_return_value;
 						}
 					} else if (this_seg == seg1) {
@@ -898,7 +1101,7 @@ vm_distance find_connected_distance(const vms_vector &p0, const vcsegptridx_t se
 
 		if (qhead >= qtail) {
 			constexpr auto Connected_segment_distance = 1000;
-			add_to_fcd_cache(seg0, seg1, Connected_segment_distance, fcd_abort_cache_value);
+			add_to_fcd_cache(key, Connected_segment_distance, fcd_abort_cache_value);
 			return fcd_abort_return_value;
 		}
 
@@ -913,7 +1116,7 @@ fcd_done1: ;
 	while (seg_queue[--qtail].end != seg1)
 		if (qtail < 0) {
 			constexpr auto Connected_segment_distance = 1000;
-			add_to_fcd_cache(seg0, seg1, Connected_segment_distance, fcd_abort_cache_value);
+			add_to_fcd_cache(key, Connected_segment_distance, fcd_abort_cache_value);
 			return fcd_abort_return_value;
 		}
 
@@ -949,7 +1152,7 @@ fcd_done1: ;
 			dist += vm_vec_dist_quick(point_segs[i].point, point_segs[i+1].point);
 		}
 
-	add_to_fcd_cache(seg0, seg1, num_points, dist);
+	add_to_fcd_cache(key, num_points, dist);
 
 	return dist;
 
@@ -1620,20 +1823,62 @@ unsigned set_segment_depths(vcsegidx_t start_seg, const array<uint8_t, MAX_SEGME
 #define	LIGHT_DISTANCE_THRESHOLD	(F1_0*80)
 #define	Magical_light_constant  (F1_0*16)
 
-//	------------------------------------------------------------------------------------------
-//cast static light from a segment to nearby segments
-static void apply_light_to_segment(visited_segment_bitarray_t &visited, const vmsegptridx_t segp,const vms_vector &segment_center, fix light_intensity,int recursion_depth)
+namespace {
+
+//	Light changes summed before they are stored, so that sides and
+//	segments lit by several changed lights are only written once, and
+//	segment centers shared by overlapping lights are only found once.
+struct light_change_accumulator
+{
+	std::unordered_map<uint32_t, array<fix, 4>> side_light;
+	std::unordered_map<segnum_t, fix> static_light;
+	std::unordered_map<segnum_t, vms_vector> centers;
+	const vms_vector &center(const vcsegptridx_t segp);
+	void add_static_light(visited_segment_bitarray_t &visited, vcsegptridx_t segp, const vms_vector &segment_center, fix light_intensity, int recursion_depth);
+	void add_segment_light(vcsegptridx_t segp, unsigned sidenum, int dir);
+	void add(const d_level_shared_destructible_light_state &LevelSharedDestructibleLightState, vcsegptridx_t segnum, uint8_t sidenum, int dir);
+	void apply();
+};
+
+struct pending_light_change
+{
+	segnum_t segnum;
+	uint8_t sidenum;
+	int8_t dir;
+};
+
+struct light_change_batch_state
 {
-	fix			dist_to_rseg;
-	segnum_t segnum=segp;
+	//	set while a batch exists
+	const d_level_shared_destructible_light_state *state;
+	std::vector<pending_light_change> changes;
+};
+
+static light_change_batch_state Light_change_batch;
 
-	if (!visited[segnum])
+const vms_vector &light_change_accumulator::center(const vcsegptridx_t segp)
+{
+	const auto &&i = centers.emplace(segp, vms_vector{});
+	if (i.second)
 	{
-		visited[segnum] = true;
 		auto &Vertices = LevelSharedVertexState.get_vertices();
 		auto &vcvertptr = Vertices.vcptr;
-		const auto r_segment_center = compute_segment_center(vcvertptr, segp);
-		dist_to_rseg = vm_vec_dist_quick(r_segment_center, segment_center);
+		compute_segment_center(vcvertptr, i.first->second, segp);
+	}
+	return i.first->second;
+}
+
+//	------------------------------------------------------------------------------------------
+//cast static light from a segment to nearby segments
+void light_change_accumulator::add_static_light(visited_segment_bitarray_t &visited, const vcsegptridx_t segp, const vms_vector &segment_center, const fix light_intensity, const int recursion_depth)
+{
+	if (auto &&v = visited[segp])
+	{
+	}
+	else
+	{
+		v = true;
+		const fix dist_to_rseg = vm_vec_dist_quick(center(segp), segment_center);
 	
 		if (dist_to_rseg <= LIGHT_DISTANCE_THRESHOLD) {
 			fix	light_at_point;
@@ -1642,18 +1887,8 @@ static void apply_light_to_segment(visited_segment_bitarray_t &visited, const vm
 			else
 				light_at_point = Magical_light_constant;
 	
-			if (light_at_point >= 0) {
-				light_at_point = fixmul(light_at_point, light_intensity);
-#if 0   // don't see the point, static_light can be greater than F1_0
-				if (light_at_point >= F1_0)
-					light_at_point = F1_0-1;
-				if (light_at_point <= -F1_0)
-					light_at_point = -(F1_0-1);
-#endif
-				segp->static_light += light_at_point;
-				if (segp->static_light < 0)	// if it went negative, saturate
-					segp->static_light = 0;
-			}	//	end if (light_at_point...
+			if (light_at_point >= 0)
+				static_light[segp] += fixmul(light_at_point, light_intensity);
 		}	//	end if (dist_to_rseg...
 	}
 
@@ -1663,15 +1898,14 @@ static void apply_light_to_segment(visited_segment_bitarray_t &visited, const vm
 		auto &vcwallptr = Walls.vcptr;
 		for (int sidenum=0; sidenum<6; sidenum++) {
 			if (WALL_IS_DOORWAY(GameBitmaps, Textures, vcwallptr, segp, segp, sidenum) & WID_RENDPAST_FLAG)
-				apply_light_to_segment(visited, segp.absolute_sibling(segp->children[sidenum]), segment_center, light_intensity, recursion_depth+1);
+				add_static_light(visited, segp.absolute_sibling(segp->children[sidenum]), segment_center, light_intensity, recursion_depth+1);
 		}
 	}
 }
 
-
 //update the static_light field in a segment, which is used for object lighting
 //this code is copied from the editor routine calim_process_all_lights()
-static void change_segment_light(const vmsegptridx_t segp,int sidenum,int dir)
+void light_change_accumulator::add_segment_light(const vcsegptridx_t segp, const unsigned sidenum, const int dir)
 {
 	auto &TmapInfo = LevelUniqueTmapInfoState.TmapInfo;
 	auto &Walls = LevelUniqueWallSubsystemState.Walls;
@@ -1683,18 +1917,10 @@ static void change_segment_light(const vmsegptridx_t segp,int sidenum,int dir)
 
 		light_intensity = TmapInfo[sidep.tmap_num].lighting + TmapInfo[sidep.tmap_num2 & 0x3fff].lighting;
 		if (light_intensity) {
-			auto &Vertices = LevelSharedVertexState.get_vertices();
-			auto &vcvertptr = Vertices.vcptr;
-			const auto segment_center = compute_segment_center(vcvertptr, segp);
 			visited_segment_bitarray_t visited;
-			apply_light_to_segment(visited, segp, segment_center, light_intensity * dir, 0);
+			add_static_light(visited, segp, center(segp), light_intensity * dir, 0);
 		}
 	}
-
-	//this is a horrible hack to get around the horrible hack used to
-	//smooth lighting values when an object moves between segments
-	old_viewer = NULL;
-
 }
 
 //	------------------------------------------------------------------------------------------
@@ -1702,7 +1928,7 @@ static void change_segment_light(const vmsegptridx_t segp,int sidenum,int dir)
 //	dir = -1 -> subtract light
 //	dir = 17 -> add 17x light
 //	dir =  0 -> you are dumb
-static void change_light(const d_level_shared_destructible_light_state &LevelSharedDestructibleLightState, const vmsegptridx_t segnum, const uint8_t sidenum, const int dir)
+void light_change_accumulator::add(const d_level_shared_destructible_light_state &LevelSharedDestructibleLightState, const vcsegptridx_t segnum, const uint8_t sidenum, const int dir)
 {
 	const fix ds = dir * DL_SCALE;
 	auto &Dl_indices = LevelSharedDestructibleLightState.Dl_indices;
@@ -1715,19 +1941,77 @@ static void change_light(const d_level_shared_destructible_light_state &LevelSha
 			range_for (auto &j, partial_const_range(Delta_lights, idx, idx + i.count))
 			{
 				assert(j.sidenum < MAX_SIDES_PER_SEGMENT);
-				const auto &&segp = vmsegptr(j.segnum);
-				auto &uvls = segp->unique_segment::sides[j.sidenum].uvls;
-				for (int k=0; k<4; k++) {
-					auto &l = uvls[k].l;
-					const fix dl = ds * j.vert_light[k];
-					if ((l += dl) < 0)
-						l = 0;
-				}
+				auto &l = side_light[static_cast<uint32_t>(j.segnum) * MAX_SIDES_PER_SEGMENT + j.sidenum];
+				for (int k=0; k<4; k++)
+					l[k] += ds * j.vert_light[k];
 			}
 	}
 
 	//recompute static light for segment
-	change_segment_light(segnum,sidenum,dir);
+	add_segment_light(segnum, sidenum, dir);
+}
+
+//	Store the summed changes.  Light which would go negative saturates
+//	at 0.
+void light_change_accumulator::apply()
+{
+	range_for (const auto &i, side_light)
+	{
+		auto &uvls = vmsegptr(static_cast<segnum_t>(i.first / MAX_SIDES_PER_SEGMENT))->unique_segment::sides[i.first % MAX_SIDES_PER_SEGMENT].uvls;
+		for (int k=0; k<4; k++) {
+			auto &l = uvls[k].l;
+			if ((l += i.second[k]) < 0)
+				l = 0;
+		}
+	}
+	range_for (const auto &i, static_light)
+	{
+		auto &s = vmsegptr(i.first)->static_light;
+		if ((s += i.second) < 0)	// if it went negative, saturate
+			s = 0;
+	}
+
+	//this is a horrible hack to get around the horrible hack used to
+	//smooth lighting values when an object moves between segments
+	old_viewer = NULL;
+}
+
+}
+
+light_change_batch::light_change_batch(const d_level_shared_destructible_light_state &LevelSharedDestructibleLightState) :
+	owner(!Light_change_batch.state)
+{
+	if (owner)
+		Light_change_batch.state = &LevelSharedDestructibleLightState;
+}
+
+light_change_batch::~light_change_batch()
+{
+	if (!owner)
+		return;
+	auto &b = Light_change_batch;
+	const auto &state = *b.state;
+	b.state = nullptr;
+	if (b.changes.empty())
+		return;
+	light_change_accumulator a;
+	range_for (const auto &c, b.changes)
+		a.add(state, vcsegptridx(c.segnum), c.sidenum, c.dir);
+	b.changes.clear();
+	a.apply();
+}
+
+static void change_light(const d_level_shared_destructible_light_state &LevelSharedDestructibleLightState, const vmsegptridx_t segnum, const uint8_t sidenum, const int dir)
+{
+	auto &b = Light_change_batch;
+	if (b.state)
+	{
+		b.changes.push_back({segnum, sidenum, static_cast<int8_t>(dir)});
+		return;
+	}
+	light_change_accumulator a;
+	a.add(LevelSharedDestructibleLightState, segnum, sidenum, dir);
+	a.apply();
 }
 
 //	Subtract light cast by a light source from all surfaces to which it applies light.
@@ -1762,6 +2046,7 @@ int add_light(const d_level_shared_destructible_light_state &LevelSharedDestruct
 //	Parse the Light_subtracted array, turning on or off all lights.
 void apply_all_changed_light(const d_level_shared_destructible_light_state &LevelSharedDestructibleLightState, fvmsegptridx &vmsegptridx)
 {
+	light_change_batch batch(LevelSharedDestructibleLightState);
 	range_for (const auto &&segp, vmsegptridx)
 	{
 		for (int j=0; j<MAX_SIDES_PER_SEGMENT; j++)
@@ -78,6 +78,8 @@ COPYRIGHT 1993-1999 PARALLAX SOFTWARE CORPORATION.  ALL RIGHTS RESERVED.
 #include "weapon.h"
 #include "sounds.h"
 #include "args.h"
+#include "profile.h"
+#include "level_arena.h"
 #include "gameseq.h"
 #include "gamefont.h"
 #include "newmenu.h"
@@ -849,6 +851,27 @@ static const d_fname &get_level_file(int level_num)
 		return Level_names[level_num-1];
 }
 
+//	Start reading the files of a level which will be loaded after the
+//	current briefing or score screen.  The mission path fallback matches
+//	load_level.
+static void read_ahead_level(const int level_num)
+{
+	if (level_num > Last_level || level_num < Last_secret_level || !level_num)
+		return;
+	const d_fname &level_name = get_level_file(level_num);
+	char mission_level_file[PATH_MAX];
+	snprintf(mission_level_file, sizeof(mission_level_file), "%.*s%s", DXX_ptrdiff_cast_int(std::distance(Current_mission->path.cbegin(), Current_mission->filename)), Current_mission->path.c_str(), static_cast<const char *>(level_name));
+	piggy_read_ahead_level(level_name, mission_level_file);
+}
+
+//	The next level is almost always the following one.  A wrong guess,
+//	such as a secret exit, only wastes the reading.
+void read_ahead_next_level()
+{
+	if (Current_level_num > 0 && Current_level_num != Last_level)
+		read_ahead_level(Current_level_num + 1);
+}
+
 // routine to calculate the checksum of the segments.
 static void do_checksum_calc(const uint8_t *b, int len, unsigned int *s1, unsigned int *s2)
 {
@@ -947,12 +970,15 @@ void load_level_robots(int level_num)
 namespace dsx {
 void LoadLevel(int level_num,int page_in_textures)
 {
+	const trace_scope trace_phase("LoadLevel");
 	preserve_player_object_info p(vcplayerptr(Player_num)->objnum);
+	level_arena_release();
 
 	auto &plr = get_local_player();
 	auto save_player = plr;
 
 	Assert(level_num <= Last_level  && level_num >= Last_secret_level  && level_num != 0);
+	songs_prefetch_level_song(level_num);
 	const d_fname &level_name = get_level_file(level_num);
 #if defined(DXX_BUILD_DESCENT_I)
 	if (!load_level(level_name))
@@ -1613,6 +1639,9 @@ static window_event_result AdvanceLevel(int secret_flag)
 #endif
 	if (Current_level_num != Last_level)
 	{
+		//	Usually already started by start_endlevel_sequence, in
+		//	which case this keeps the reading going.
+		read_ahead_next_level();
 		if (Game_mode & GM_MULTI)
 		{
 			const auto result = multi_endlevel_score();
@@ -1803,6 +1832,7 @@ window_event_result StartNewLevelSub(const int level_num, const int page_in_text
 window_event_result StartNewLevelSub(const int level_num, const int page_in_textures, const secret_restore secret_flag)
 #endif
 {
+	const trace_scope trace_phase("StartNewLevelSub");
 	if (!(Game_mode & GM_MULTI)) {
 		last_drawn_cockpit = -1;
 	}
@@ -1885,6 +1915,7 @@ window_event_result StartNewLevelSub(const int level_num, const int page_in_text
 	reset_palette_add();
 	LevelUniqueStuckObjectState.init_stuck_objects();
 #if defined(DXX_BUILD_DESCENT_II)
+	flush_fcd_cache();
 	init_smega_detonates();
 	init_thief_for_level();
 	if (!(Game_mode & GM_MULTI))
@@ -2036,6 +2067,7 @@ window_event_result StartNewLevel(int level_num)
 	GameTime64 = 0;
 	ThisLevelTime=0;
 
+	read_ahead_level(level_num);
 #if defined(DXX_BUILD_DESCENT_I)
 	if (!(Game_mode & GM_MULTI)) {
 		do_briefing_screens(Briefing_text_filename, level_num);
@@ -2051,9 +2051,62 @@ static void draw_wbu_overlay(const hud_draw_context_hs_mr hudctx)
 }
 }
 
+#if !DXX_USE_OGL
+/* The software renderer redraws the cockpit every frame.  Gauges that
+ * are expensive to draw are kept in an offscreen canvas, which is
+ * redrawn only when the value shown by the gauge changes.
+ */
+class hud_gauge_cache
+{
+	/* The energy bar masks can extend a pixel past either side of the
+	 * gauge bitmap.
+	 */
+	static constexpr unsigned margin = 2;
+	grs_canvas_ptr canvas;
+	const grs_bitmap *gauge_bitmap = nullptr;
+	int key = -1;
+public:
+	template <typename F>
+		void draw(const hud_draw_context_hs_mr hudctx, unsigned x, unsigned y, unsigned gauge, int key, F &&mask);
+	void reset()
+	{
+		canvas.reset();
+		gauge_bitmap = nullptr;
+		key = -1;
+	}
+};
+
+template <typename F>
+void hud_gauge_cache::draw(const hud_draw_context_hs_mr hudctx, const unsigned x, const unsigned y, const unsigned gauge, const int k, F &&mask)
+{
+#if defined(DXX_BUILD_DESCENT_II)
+	auto &multires_gauge_graphic = hudctx.multires_gauge_graphic;
+#endif
+	PAGE_IN_GAUGE(gauge, multires_gauge_graphic);
+	auto &bm = GameBitmaps[GET_GAUGE_INDEX(gauge)];
+	if (!canvas || gauge_bitmap != &bm || key != k)
+	{
+		if (!canvas || gauge_bitmap != &bm)
+			canvas = gr_create_canvas(bm.bm_w + margin * 2, bm.bm_h);
+		gauge_bitmap = &bm;
+		key = k;
+		gr_clear_canvas(*canvas, TRANSPARENCY_COLOR);
+		gr_ubitmapm(*canvas, margin, 0, bm);
+		mask(*canvas, hudctx, margin, 0, k);
+	}
+	gr_ubitmapm(hudctx.canvas, x - margin, y, canvas->cv_bitmap);
+}
+
+static hud_gauge_cache left_energy_gauge_cache, right_energy_gauge_cache;
+#endif
+
 void close_gauges()
 {
 	WinBoxOverlay = {};
+#if !DXX_USE_OGL
+	left_energy_gauge_cache.reset();
+	right_energy_gauge_cache.reset();
+#endif
 }
 
 namespace dsx {
@@ -2064,66 +2117,94 @@ void init_gauges()
 #if defined(DXX_BUILD_DESCENT_II)
 	weapon_box_user[0] = weapon_box_user[1] = WBU_WEAPON;
 #endif
+#if !DXX_USE_OGL
+	left_energy_gauge_cache.reset();
+	right_energy_gauge_cache.reset();
+#endif
 }
 }
 
-static void draw_energy_bar(const hud_draw_context_hs_mr hudctx, const int energy)
+static unsigned energy_bar_not_energy(const hud_draw_context_hs_mr hudctx, const int energy)
 {
 	auto &multires_gauge_graphic = hudctx.multires_gauge_graphic;
-	const int not_energy = hudctx.xscale(multires_gauge_graphic.is_hires() ? (125 - (energy * 125) / 100) : (63 - (energy * 63) / 100));
-	const double aplitscale = static_cast<double>(hudctx.xscale(65) / hudctx.yscale(8)) / (65 / 8); //scale amplitude of energy bar to current resolution aspect
+	return hudctx.xscale(multires_gauge_graphic.is_hires() ? (125 - (energy * 125) / 100) : (63 - (energy * 63) / 100));
+}
 
-	// Draw left energy bar
-	hud_gauge_bitblt(hudctx, LEFT_ENERGY_GAUGE_X, LEFT_ENERGY_GAUGE_Y, GAUGE_ENERGY_LEFT);
+static double energy_bar_aplitscale(const hud_draw_context_hs_mr hudctx)
+{
+	return static_cast<double>(hudctx.xscale(65) / hudctx.yscale(8)) / (65 / 8); //scale amplitude of energy bar to current resolution aspect
+}
 
+/* Black out the empty part of the left energy gauge, which has already
+ * been drawn with its top left corner at (x0, y0) of canvas.
+ */
+static void draw_left_energy_bar_mask(grs_canvas &canvas, const hud_draw_context_hs_mr hudctx, const int x0, const int y0, const int energy)
+{
+	if (energy >= 100)
+		return;
+	auto &multires_gauge_graphic = hudctx.multires_gauge_graphic;
+	const int not_energy = energy_bar_not_energy(hudctx, energy);
+	const double aplitscale = energy_bar_aplitscale(hudctx);
 	const auto color = BM_XRGB(0, 0, 0);
-
-	if (energy < 100)
+	const auto xscale_energy_gauge_w = hudctx.xscale(LEFT_ENERGY_GAUGE_W);
+	const auto xscale_energy_gauge_h2 = hudctx.xscale(LEFT_ENERGY_GAUGE_H - 2);
+	const auto yscale_energy_gauge_h = hudctx.yscale(LEFT_ENERGY_GAUGE_H);
+	for (unsigned y = 0; y < yscale_energy_gauge_h; ++y)
 	{
-		const auto xscale_energy_gauge_x = hudctx.xscale(LEFT_ENERGY_GAUGE_X);
-		const auto xscale_energy_gauge_w = hudctx.xscale(LEFT_ENERGY_GAUGE_W);
-		const auto xscale_energy_gauge_h2 = hudctx.xscale(LEFT_ENERGY_GAUGE_H - 2);
-		const auto yscale_energy_gauge_y = hudctx.yscale(LEFT_ENERGY_GAUGE_Y);
-		const auto yscale_energy_gauge_h = hudctx.yscale(LEFT_ENERGY_GAUGE_H);
-		for (unsigned y = 0; y < yscale_energy_gauge_h; ++y)
-		{
-			const auto bound = xscale_energy_gauge_w - (y * aplitscale) / 3;
-			const auto x1 = xscale_energy_gauge_h2 - y * aplitscale;
-			const auto x2 = std::min(x1 + not_energy, bound);
+		const auto bound = xscale_energy_gauge_w - (y * aplitscale) / 3;
+		const auto x1 = xscale_energy_gauge_h2 - y * aplitscale;
+		const auto x2 = std::min(x1 + not_energy, bound);
 
-			if (x2 > x1)
-			{
-				const auto ly = i2f(y + yscale_energy_gauge_y);
-				gr_uline(*grd_curcanv, i2f(x1 + xscale_energy_gauge_x), ly, i2f(x2 + xscale_energy_gauge_x), ly, color);
-			}
+		if (x2 > x1)
+		{
+			const auto ly = i2f(y + y0);
+			gr_uline(canvas, i2f(x1 + x0), ly, i2f(x2 + x0), ly, color);
 		}
 	}
+}
 
-	// Draw right energy bar
-	hud_gauge_bitblt(hudctx, RIGHT_ENERGY_GAUGE_X, RIGHT_ENERGY_GAUGE_Y, GAUGE_ENERGY_RIGHT);
-
-	if (energy < 100)
+static void draw_right_energy_bar_mask(grs_canvas &canvas, const hud_draw_context_hs_mr hudctx, const int x0, const int y0, const int energy)
+{
+	if (energy >= 100)
+		return;
+	auto &multires_gauge_graphic = hudctx.multires_gauge_graphic;
+	const int not_energy = energy_bar_not_energy(hudctx, energy);
+	const double aplitscale = energy_bar_aplitscale(hudctx);
+	const auto color = BM_XRGB(0, 0, 0);
+	const auto yscale_energy_gauge_h = hudctx.yscale(RIGHT_ENERGY_GAUGE_H);
+	const auto xscale_right_energy = hudctx.xscale(RIGHT_ENERGY_GAUGE_W - RIGHT_ENERGY_GAUGE_H + 2);
+	for (unsigned y = 0; y < yscale_energy_gauge_h; ++y)
 	{
-		const auto xscale_energy_gauge_x = hudctx.xscale(RIGHT_ENERGY_GAUGE_X);
-		const auto yscale_energy_gauge_y = hudctx.yscale(RIGHT_ENERGY_GAUGE_Y);
-		const auto yscale_energy_gauge_h = hudctx.yscale(RIGHT_ENERGY_GAUGE_H);
-		const auto xscale_right_energy = hudctx.xscale(RIGHT_ENERGY_GAUGE_W - RIGHT_ENERGY_GAUGE_H + 2);
-		for (unsigned y = 0; y < yscale_energy_gauge_h; ++y)
-		{
-			const auto bound = (y * aplitscale) / 3;
-			const auto x2 = xscale_right_energy + y * aplitscale;
-			auto x1 = x2 - not_energy;
+		const auto bound = (y * aplitscale) / 3;
+		const auto x2 = xscale_right_energy + y * aplitscale;
+		auto x1 = x2 - not_energy;
 
-			if (x1 < bound)
-				x1 = bound;
+		if (x1 < bound)
+			x1 = bound;
 
-			if (x2 > x1)
-			{
-				const auto ly = i2f(y + yscale_energy_gauge_y);
-				gr_uline(*grd_curcanv, i2f(x1 + xscale_energy_gauge_x), ly, i2f(x2 + xscale_energy_gauge_x), ly, color);
-			}
+		if (x2 > x1)
+		{
+			const auto ly = i2f(y + y0);
+			gr_uline(canvas, i2f(x1 + x0), ly, i2f(x2 + x0), ly, color);
 		}
 	}
+}
+
+static void draw_energy_bar(const hud_draw_context_hs_mr hudctx, const int energy)
+{
+	auto &multires_gauge_graphic = hudctx.multires_gauge_graphic;
+#if DXX_USE_OGL
+	// Draw left energy bar
+	hud_gauge_bitblt(hudctx, LEFT_ENERGY_GAUGE_X, LEFT_ENERGY_GAUGE_Y, GAUGE_ENERGY_LEFT);
+	draw_left_energy_bar_mask(*grd_curcanv, hudctx, hudctx.xscale(LEFT_ENERGY_GAUGE_X), hudctx.yscale(LEFT_ENERGY_GAUGE_Y), energy);
+
+	// Draw right energy bar
+	hud_gauge_bitblt(hudctx, RIGHT_ENERGY_GAUGE_X, RIGHT_ENERGY_GAUGE_Y, GAUGE_ENERGY_RIGHT);
+	draw_right_energy_bar_mask(*grd_curcanv, hudctx, hudctx.xscale(RIGHT_ENERGY_GAUGE_X), hudctx.yscale(RIGHT_ENERGY_GAUGE_Y), energy);
+#else
+	left_energy_gauge_cache.draw(hudctx, LEFT_ENERGY_GAUGE_X, LEFT_ENERGY_GAUGE_Y, GAUGE_ENERGY_LEFT, energy, draw_left_energy_bar_mask);
+	right_energy_gauge_cache.draw(hudctx, RIGHT_ENERGY_GAUGE_X, RIGHT_ENERGY_GAUGE_Y, GAUGE_ENERGY_RIGHT, energy, draw_right_energy_bar_mask);
+#endif
 
 	gr_set_default_canvas();
 }
@@ -3703,6 +3784,7 @@ void do_cockpit_window_view(const int win, const object &viewer, const int rear_
 
 	window_rendered_data window;
 	update_rendered_data(window, viewer, rear_view_flag);
+	window.secondary_view = true;
 
 	weapon_box_user[win] = user;						//say who's using window
 
@@ -56,6 +56,7 @@ char copyright[] = "DESCENT II  COPYRIGHT (C) 1994-1996 PARALLAX SOFTWARE CORPOR
 #include "pstypes.h"
 #include "strutil.h"
 #include "console.h"
+#include "profile.h"
 #include "gr.h"
 #include "key.h"
 #include "3d.h"
@@ -89,6 +90,7 @@ char copyright[] = "DESCENT II  COPYRIGHT (C) 1994-1996 PARALLAX SOFTWARE CORPOR
 #include "playsave.h"
 #include "collide.h"
 #include "newdemo.h"
+#include "state.h"
 #include "joy.h"
 #if !DXX_USE_OGL
 #include "../texmap/scanline.h" //for select_tmap -MM
@@ -158,6 +160,7 @@ static void print_commandline_help()
 	VERB("\n System Options:\n\n")	\
 	VERB("  -nonicefps                    Don't free CPU-cycles\n")	\
 	VERB("  -maxfps <n>                   Set maximum framerate to <n>\n\t\t\t\t(default: " DXX_STRINGIZE(MAXIMUM_FPS) ", available: " DXX_STRINGIZE(MINIMUM_FPS) "-" DXX_STRINGIZE(MAXIMUM_FPS) ")\n")	\
+	VERB("  -fixedtick <n>                Simulate <n> times per second and interpolate\n\t\t\t\tbetween them when rendering, in single player\n\t\t\t\t(default: 0, off, available: " DXX_STRINGIZE(DESIGNATED_GAME_FPS) "-" DXX_STRINGIZE(MAXIMUM_FPS) ")\n")	\
 	VERB("  -hogdir <s>                   set shared data directory to <s>\n")	\
 	DXX_COMMAND_LINE_HELP_unix(	\
 		VERB("  -nohogdir                     don't try to use shared data directory\n")	\
@@ -165,10 +168,29 @@ static void print_commandline_help()
 	VERB("  -add-missions-dir <s>         Add contents of location <s> to the missions directory\n")	\
 	VERB("  -use_players_dir              Put player files and saved games in Players subdirectory\n")	\
 	VERB("  -lowmem                       Lowers animation detail for better performance with\n\t\t\t\tlow memory\n")	\
+	VERB("  -mappig                       Map the PIG and sound files into memory instead of\n\t\t\t\treading bitmaps and sounds into caches\n")	\
+	VERB("  -nomissioncache               Read every mission file when building the mission list\n")	\
+	VERB("  -nomodelcache                 Convert every polygon model instead of using models.bin\n")	\
+	VERB("  -nolevelcache                 Rebuild derived level data instead of using levelcache\n")	\
+	VERB("  -rlecache <n>                 Keep up to <n> MB of expanded RLE textures (default: 4)\n")	\
+	VERB("  -rlepin                       Keep often expanded RLE textures expanded until the\n\t\t\t\tnext level\n")	\
+	VERB("  -ai_lod <n>                   Update unaware robots more than <n> segments away\n\t\t\t\tless often in single player (default: 0, off)\n")	\
+	VERB("  -rewind <n>                   Keep a snapshot of the game every <n> seconds in\n\t\t\t\tsingle player for Ctrl-F3 (default: 0, off)\n")	\
 	VERB("  -pilot <s>                    Select pilot <s> automatically\n")	\
 	VERB("  -auto-record-demo             Start recording on level entry\n")	\
 	VERB("  -record-demo-format           Set demo name automatically\n")	\
+	VERB("  -record-demo-delta            Record objects as changes from earlier frames\n\t\t\t\t(older versions cannot play these demos)\n")	\
 	VERB("  -autodemo                     Start in demo mode\n")	\
+	VERB("  -headless                     Simulate without drawing the game, sound or\n\t\t\t\ta frame limit, and quit after one demo\n")	\
+	VERB("  -demo_stats <s>               Play demo <s> one recorded frame per game frame and\n\t\t\t\twrite its events to a .csv file (use with -headless)\n")	\
+	VERB("  -demo_video <s>               Play demo <s> at a fixed time step and write each\n\t\t\t\tframe to " SCRNS_DIR "<s>/\n")	\
+	VERB("  -demo_video_fps <n>           Frames per second of demo time for -demo_video\n\t\t\t\t(default: 60)\n")	\
+	VERB("  -timedemo <s>                 Play demo <s> as fast as possible at the -demo_video_fps\n\t\t\t\ttime step, log the frame rate and write it to a .json file\n")	\
+	VERB("  -fast_screenshots             Compress screenshots quickly instead of compactly,\n\t\t\t\tfor bursts of captures\n")	\
+	VERB("  -replay_record <s>            Record the controls of the first level played to " DEMO_DIR "<s>\n")	\
+	VERB("  -replay <s>                   Play the controls in " DEMO_DIR "<s> and write a hash of every\n\t\t\t\tobject after each frame to a .hsh file\n")	\
+	VERB("  -replay_check <s>             Play the controls in " DEMO_DIR "<s> and report the first frame\n\t\t\t\tand object which differ from its .hsh file\n")	\
+	VERB("  -demo_batch <s>               Check (verify) or add a seek index to (index) every\n\t\t\t\tdemo, list the results in " DEMO_DIR "batch.csv and quit\n")	\
 	VERB("  -window                       Run the game in a window\n")	\
 	VERB("  -noborders                    Don't show borders in window mode\n")	\
 	DXX_COMMAND_LINE_HELP_D1(	\
@@ -182,9 +204,11 @@ static void print_commandline_help()
 	VERB("  -nomouse                      Deactivate mouse\n")	\
 	VERB("  -nojoystick                   Deactivate joystick\n")	\
 	VERB("  -nostickykeys                 Make CapsLock and NumLock non-sticky\n")	\
+	VERB("  -latelook                     Turn the view by mouse and joystick input which arrived while the frame was simulated\n")	\
 	VERB("\n Sound:\n\n")	\
 	VERB("  -nosound                      Disables sound output\n")	\
 	VERB("  -nomusic                      Disables music output\n")	\
+	VERB("  -lazysounds                   Read sounds when first needed\n")	\
 	DXX_COMMAND_LINE_HELP_D2(	\
 		VERB("  -sound11k                     Use 11KHz sounds\n")	\
 	)	\
@@ -193,6 +217,7 @@ static void print_commandline_help()
 	))	\
 	VERB("\n Graphics:\n\n")	\
 	VERB("  -lowresfont                   Force use of low resolution fonts\n")	\
+	VERB("  -window_depth <n>             Render cockpit window views at most <n> segments deep\n\t\t\t\t(default: 0, as deep as the main view)\n")	\
 	DXX_COMMAND_LINE_HELP_D2(	\
 		VERB("  -lowresgraphics               Force use of low resolution graphics\n")	\
 		VERB("  -lowresmovies                 Play low resolution movies if available (for slow machines)\n")	\
@@ -208,12 +233,28 @@ static void print_commandline_help()
 		VERB("                                    5: Auto: if VSync is enabled and ARB_sync is supported, use mode 2, otherwise mode 0\n")	\
 		VERB("  -gl_syncwait <n>              Wait interval (ms) for sync mode 2 (default: " DXX_STRINGIZE(OGL_SYNC_WAIT_DEFAULT) ")\n")	\
 		VERB("  -gl_darkedges                 Re-enable dark edges around filtered textures (as present in earlier versions of the engine)\n")	\
+		VERB("  -gl_worldbuffer               Keep level geometry, endlevel terrain and automap edges in GPU buffer objects and batch wall drawing\n")	\
+		VERB("  -gl_sortfaces                 Draw opaque walls grouped by texture instead of in visibility order\n")	\
+		VERB("  -gl_overlayshader             Use a GLSL shader to draw overlay wall textures in one pass\n")	\
+		VERB("  -gl_pixellight                Light walls from moving light sources per pixel with a GLSL shader (needs -gl_worldbuffer)\n")	\
+		VERB("  -gl_modelbuffer               Keep polygon models in GPU buffer objects\n")	\
+		VERB("  -gl_asyncupload               Spread texture uploads over several frames to avoid stalls\n")	\
+		VERB("  -gl_occlusion                 Skip distant segments hidden behind nearer geometry, using occlusion queries\n")	\
+		VERB("  -gl_texcache                  Keep converted textures in a cache file to speed up loading\n")	\
+		VERB("  -gl_vram <n>                  Free textures not drawn recently to keep them below <n> MB\n")	\
+		VERB("  -gl_pipeline                  Simulate the next frame while the GPU draws this one (adds a frame of latency)\n")	\
+		VERB("  -gl_dynres <n>                Lower the resolution of the 3D view to draw it in <n> ms of GPU time\n")	\
+		VERB("  -gl_modellod <n>              Draw models farther than <n> times their radius with fewer polygons (needs -gl_modelbuffer)\n")	\
+		VERB("  -gl_instancing                Draw copies of the same polygon model with one instanced call (needs -gl_modelbuffer)\n")	\
 	)	\
 	DXX_if_defined_01(DXX_USE_UDP, (	\
 		VERB("\n Multiplayer:\n\n")	\
 		VERB("  -udp_hostaddr <s>             Use IP address/Hostname <s> for manual game joining\n\t\t\t\t(default: %s)\n", UDP_MANUAL_ADDR_DEFAULT)	\
 		VERB("  -udp_hostport <n>             Use UDP port <n> for manual game joining (default: %hu)\n", UDP_PORT_DEFAULT)	\
 		VERB("  -udp_myport <n>               Set my own UDP port to <n> (default: %hu)\n", UDP_PORT_DEFAULT)	\
+		VERB("  -udp_interp_delay <n>         Show other ships <n> ms in the past, interpolated between\n\t\t\t\tpackets (0-500, default: 0, off)\n")	\
+		VERB("  -udp_autohost <s>             Host mission <s> with the saved netgame settings,\n\t\t\t\twithout menus (use with -headless for a server)\n")	\
+		VERB("  -udp_stats_file <s>           Write network statistics to file <s> when leaving a netgame\n")	\
 		DXX_if_defined_01(DXX_USE_TRACKER, (	\
 			VERB("  -no-tracker                   Disable tracker (unless overridden by later -tracker_hostaddr)\n")	\
 			VERB("  -tracker_hostaddr <n>         Address of tracker server to register/query games to/from\n\t\t\t\t(default: %s)\n", TRACKER_ADDR_DEFAULT)	\
@@ -230,14 +271,19 @@ static void print_commandline_help()
 			VERB("  -macdata                      Read and write Mac data files in editor (swap colors)\n")	\
 			VERB("  -hoarddata                    Make the Hoard ham file from some files, then exit\n")	\
 		)	\
+		VERB("  -notblcache                   Always parse BITMAPS.TBL instead of using bitmaps.cmp\n")	\
 	))	\
 	VERB("\n Debug (use only if you know what you're doing):\n\n")	\
 	VERB("  -debug                        Enable debugging output.\n")	\
 	VERB("  -verbose                      Enable verbose output.\n")	\
 	VERB("  -safelog                      Write gamelog.txt unbuffered.\n\t\t\t\tUse to keep helpful output to trace program crashes.\n")	\
+	VERB("  -tracefile <f>                Write startup and level load times to <f> as a Chrome trace\n")	\
 	VERB("  -norun                        Bail out after initialization\n")	\
 	VERB("  -no-grab                      Never grab keyboard/mouse\n")	\
 	VERB("  -renderstats                  Enable renderstats info by default\n")	\
+	VERB("  -latency                      Report the time from input to the buffer swap which shows it\n")	\
+	VERB("  -nopvs                        Do not cull segments with the potentially visible set\n")	\
+	VERB("  -nojobs                       Do not start worker threads\n")	\
 	VERB("  -text <s>                     Specify alternate .tex file\n")	\
 	VERB("  -showmeminfo                  Show memory statistics\n")	\
 	VERB("  -nodoublebuffer               Disable Doublebuffering\n")	\
@@ -252,9 +298,10 @@ static void print_commandline_help()
 		VERB("  -gl_gettexlevelparam_ok <n>   Override DbgGlGetTexLevelParamOk (default: 1)\n")	\
 	)	\
 	DXX_COMMAND_LINE_HELP_SDL(	\
-		VERB("  -tmap <s>                     Select texmapper <s> to use\n\t\t\t\t(default: c, available: c, fp, quad)\n")	\
+		VERB("  -tmap <s>                     Select texmapper <s> to use\n\t\t\t\t(default: simd where supported, else c;\n\t\t\t\tavailable: c, fp, quad, simd)\n")	\
 		VERB("  -hwsurface                    Use SDL HW Surface\n")	\
 		VERB("  -asyncblit                    Use queued blits over SDL. Can speed up rendering\n")	\
+		VERB("  -sdl_scale <n>                Render at 1/<n> of the window size and scale up\n\t\t\t\twith a hardware video overlay (default: 1)\n")	\
 	)	\
 	VERB("\n Help:\n\n")	\
 	VERB("  -help, -h, -?, ?             View this help screen\n")	\
@@ -418,6 +465,8 @@ static int main(int argc, char *argv[])
 	if (!PHYSFSX_init(argc, argv))
 		return 1;
 	con_init();  // Initialise the console
+	if (!CGameArg.DbgTraceFile.empty())
+		trace_open(CGameArg.DbgTraceFile.c_str());
 
 	setbuf(stdout, NULL); // unbuffered output via printf
 #ifdef _WIN32
@@ -548,7 +597,10 @@ static int main(int argc, char *argv[])
 #endif
 
 	con_puts(CON_VERBOSE, "Going into graphics mode...");
-	gr_set_mode_from_window_size();
+	{
+		const trace_scope trace_phase("gr_set_mode_from_window_size");
+		gr_set_mode_from_window_size();
+	}
 
 	// Load the palette stuff. Returns non-zero if error.
 	con_puts(CON_DEBUG, "Initializing palette system...");
@@ -559,13 +611,17 @@ static int main(int argc, char *argv[])
 #endif
 
 	con_puts(CON_DEBUG, "Initializing font system...");
-	gamefont_init();	// must load after palette data loaded.
+	{
+		const trace_scope trace_phase("gamefont_init");
+		gamefont_init();	// must load after palette data loaded.
+	}
 
 #if defined(DXX_BUILD_DESCENT_II)
 	con_puts(CON_DEBUG, "Initializing movie libraries...");
 	init_movies();		//init movie libraries
 #endif
 
+	mission_catalog_refresh();
 	show_titles();
 
 	set_screen_mode(SCREEN_MENU);
@@ -606,7 +662,10 @@ static int main(int argc, char *argv[])
 		return(0);
 
 	con_puts(CON_DEBUG, "Initializing texture caching system...");
-	texmerge_init();		// 10 cache bitmaps
+	texmerge_init();
+#if DXX_USE_UDP
+	net_udp_stats_init();
+#endif
 
 #if defined(DXX_BUILD_DESCENT_II)
 	piggy_init_pigfile("groupa.pig");	//get correct pigfile
@@ -663,6 +722,9 @@ static int main(int argc, char *argv[])
 		}
 	}
 
+	if (!CGameArg.SysDemoBatch.empty())
+		newdemo_batch(CGameArg.SysDemoBatch.c_str());
+	else
 #if defined(DXX_BUILD_DESCENT_II)
 #if DXX_USE_EDITOR
 	if (!GameArg.EdiAutoLoad.empty()) {
@@ -675,7 +737,12 @@ static int main(int argc, char *argv[])
 #endif
 	{
 		Game_mode = GM_GAME_OVER;
+		trace_mark("main menu");
 		DoMenu();
+#if DXX_USE_UDP
+		if (!CGameArg.MplUdpAutoHost.empty())
+			net_udp_autohost(CGameArg.MplUdpAutoHost.c_str());
+#endif
 	}
 
 	while (window_get_front())
@@ -691,6 +758,8 @@ static int main(int argc, char *argv[])
 			window_close(wind);
 	}
 
+	state_wait_for_writes();
+	player_file_wait_for_writes();
 	WriteConfigFile();
 	show_order_form();
 
@@ -699,8 +768,10 @@ static int main(int argc, char *argv[])
 	texmerge_close();
 	gamedata_close();
 	gamefont_close();
+	mission_catalog_close();
 	Current_mission.reset();
 	PHYSFSX_removeArchiveContent();
+	trace_close();
 
 	return(0);		//presumably successful exit
 }
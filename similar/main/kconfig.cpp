@@ -57,6 +57,7 @@ COPYRIGHT 1993-1999 PARALLAX SOFTWARE CORPORATION.  ALL RIGHTS RESERVED.
 #include "timer.h"
 #include "text.h"
 #include "player.h"
+#include "object.h"
 #include "menu.h"
 #include "automap.h"
 #include "args.h"
@@ -1022,13 +1023,17 @@ static void clamp_symmetric_value(fix& value, const fix& bound)
 }
 
 #if DXX_MAX_AXES_PER_JOYSTICK
-static void convert_raw_joy_axis(const uint_fast32_t player_cfg_index, const uint_fast32_t i)
+static fix scale_raw_joy_axis(const uint_fast32_t player_cfg_index, const fix raw_joy_axis)
 {
-	const auto raw_joy_axis = Controls.raw_joy_axis[i];
 	const auto joy_axis = (abs(raw_joy_axis) <= (128 * PlayerCfg.JoystickLinear[player_cfg_index]) / 16)
 		? (raw_joy_axis * (FrameTime * PlayerCfg.JoystickSpeed[player_cfg_index]) / 16)
 		: (raw_joy_axis * FrameTime);
-	Controls.joy_axis[i] = joy_axis / 128;
+	return joy_axis / 128;
+}
+
+static void convert_raw_joy_axis(const uint_fast32_t player_cfg_index, const uint_fast32_t i)
+{
+	Controls.joy_axis[i] = scale_raw_joy_axis(player_cfg_index, Controls.raw_joy_axis[i]);
 }
 
 static void convert_raw_joy_axis(const uint_fast32_t kcm_index, const uint_fast32_t player_cfg_index, const uint_fast32_t i)
@@ -1037,6 +1042,44 @@ static void convert_raw_joy_axis(const uint_fast32_t kcm_index, const uint_fast3
 		return;
 	convert_raw_joy_axis(player_cfg_index, i);
 }
+
+static int joy_axis_remove_deadzone(const unsigned axis, int value)
+{
+	int joy_null_value = 0;
+	if (axis == PlayerCfg.KeySettings.Joystick[dxx_kconfig_ui_kc_joystick_pitch]) // Pitch U/D Deadzone
+		joy_null_value = PlayerCfg.JoystickDead[1]*8;
+	else if (axis == PlayerCfg.KeySettings.Joystick[dxx_kconfig_ui_kc_joystick_turn]) // Turn L/R Deadzone
+		joy_null_value = PlayerCfg.JoystickDead[0]*8;
+	else if (axis == PlayerCfg.KeySettings.Joystick[dxx_kconfig_ui_kc_joystick_slide_lr]) // Slide L/R Deadzone
+		joy_null_value = PlayerCfg.JoystickDead[2]*8;
+	else if (axis == PlayerCfg.KeySettings.Joystick[dxx_kconfig_ui_kc_joystick_slide_ud]) // Slide U/D Deadzone
+		joy_null_value = PlayerCfg.JoystickDead[3]*8;
+	else if (axis == PlayerCfg.KeySettings.Joystick[dxx_kconfig_ui_kc_joystick_bank]) // Bank Deadzone
+		joy_null_value = PlayerCfg.JoystickDead[4]*8;
+	else if (axis == PlayerCfg.KeySettings.Joystick[dxx_kconfig_ui_kc_joystick_throttle]) // Throttle - default deadzone
+		joy_null_value = PlayerCfg.JoystickDead[5]*3;
+
+	if (value > joy_null_value)
+		return ((value - joy_null_value) * 128) / (128 - joy_null_value);
+	else if (value < -joy_null_value)
+		return ((value + joy_null_value) * 128) / (128 - joy_null_value);
+	else
+		return 0;
+}
+
+/* Add to time the change in one axis' contribution if it moved to the
+ * position of its last queued event.
+ */
+static void adjust_late_joystick_field(fix &time, const unsigned kcm_index, const unsigned player_cfg_index, const unsigned invert)
+{
+	const unsigned axis = kcm_joystick[kcm_index].value;
+	int value;
+	if (axis >= JOY_MAX_AXES || !joy_peek_axis(axis, value))
+		return;
+	array<fix, JOY_MAX_AXES> axes{};
+	axes[axis] = scale_raw_joy_axis(player_cfg_index, joy_axis_remove_deadzone(axis, value)) - Controls.joy_axis[axis];
+	adjust_axis_field(time, axes, axis, invert, PlayerCfg.JoystickSens[player_cfg_index]);
+}
 #endif
 
 static inline void adjust_button_time(fix &o, uint8_t add, uint8_t sub, fix v)
@@ -1169,33 +1212,10 @@ void kconfig_read_controls(const d_event &event, int automap_flag)
 #if DXX_MAX_AXES_PER_JOYSTICK
 		case EVENT_JOYSTICK_MOVED:
 		{
-			int joy_null_value = 0;
 			if (!(PlayerCfg.ControlType & CONTROL_USING_JOYSTICK))
 				break;
 			const auto &av = event_joystick_get_axis(event);
-			const auto &axis = av.axis;
-			auto value = av.value;
-
-			if (axis == PlayerCfg.KeySettings.Joystick[dxx_kconfig_ui_kc_joystick_pitch]) // Pitch U/D Deadzone
-				joy_null_value = PlayerCfg.JoystickDead[1]*8;
-			else if (axis == PlayerCfg.KeySettings.Joystick[dxx_kconfig_ui_kc_joystick_turn]) // Turn L/R Deadzone
-				joy_null_value = PlayerCfg.JoystickDead[0]*8;
-			else if (axis == PlayerCfg.KeySettings.Joystick[dxx_kconfig_ui_kc_joystick_slide_lr]) // Slide L/R Deadzone
-				joy_null_value = PlayerCfg.JoystickDead[2]*8;
-			else if (axis == PlayerCfg.KeySettings.Joystick[dxx_kconfig_ui_kc_joystick_slide_ud]) // Slide U/D Deadzone
-				joy_null_value = PlayerCfg.JoystickDead[3]*8;
-			else if (axis == PlayerCfg.KeySettings.Joystick[dxx_kconfig_ui_kc_joystick_bank]) // Bank Deadzone
-				joy_null_value = PlayerCfg.JoystickDead[4]*8;
-			else if (axis == PlayerCfg.KeySettings.Joystick[dxx_kconfig_ui_kc_joystick_throttle]) // Throttle - default deadzone
-				joy_null_value = PlayerCfg.JoystickDead[5]*3;
-
-			if (value > joy_null_value)
-				value = ((value - joy_null_value) * 128) / (128 - joy_null_value);
-			else if (value < -joy_null_value)
-				value = ((value + joy_null_value) * 128) / (128 - joy_null_value);
-			else
-				value = 0;
-			Controls.raw_joy_axis[axis] = value;
+			Controls.raw_joy_axis[av.axis] = joy_axis_remove_deadzone(av.axis, av.value);
 			break;
 		}
 #endif
@@ -1392,6 +1412,55 @@ void kconfig_read_controls(const d_event &event, int automap_flag)
 	}
 }
 
+void kconfig_late_look(const object_base &plr, vms_angvec &angles)
+{
+	angles = {};
+	if (Controls.state.slide_on)
+		return;
+	fix pitch_time = 0, heading_time = 0;
+	const auto heading = !Controls.state.bank_on;
+#if DXX_MAX_AXES_PER_JOYSTICK
+	if ((PlayerCfg.ControlType & CONTROL_USING_JOYSTICK) && !CGameArg.CtlNoJoystick)
+	{
+		adjust_late_joystick_field(pitch_time, 13, 1, kcm_joystick[14].value);
+		if (heading)
+			adjust_late_joystick_field(heading_time, 15, 0, !kcm_joystick[16].value);
+	}
+#endif
+	/* In flight sim mode, the mouse position sets the turn rate, so a
+	 * late sample would change the view little.
+	 */
+	int dx, dy;
+	if ((PlayerCfg.ControlType & CONTROL_USING_MOUSE) && !PlayerCfg.MouseFlightSim && !CGameArg.CtlNoMouse && mouse_peek_delta(dx, dy))
+	{
+		const auto frametime = FrameTime;
+		/* The next frame replaces mouse_axis with the motion of the
+		 * last event, as kconfig_read_controls does.
+		 */
+		const array<fix, 3> axes{{
+			(dx * frametime) / 8 - Controls.mouse_axis[0],
+			(dy * frametime) / 8 - Controls.mouse_axis[1],
+			0
+		}};
+		adjust_axis_field(pitch_time, axes, kcm_mouse[13].value, kcm_mouse[14].value, PlayerCfg.MouseSens[1]);
+		if (heading)
+			adjust_axis_field(heading_time, axes, kcm_mouse[15].value, !kcm_mouse[16].value, PlayerCfg.MouseSens[0]);
+	}
+	if (!pitch_time && !heading_time)
+		return;
+	const auto &pi = plr.mtype.phys_info;
+	if (!pi.mass)
+		return;
+	/* During the first frame after a change in rotthrust, physics adds
+	 * about accel * (FrameTime / FT) to rotvel, and turns by that much
+	 * times FrameTime.  read_flying_controls scales the time by
+	 * max_rotthrust / FrameTime, which leaves:
+	 */
+	const auto gain = fixmul(fixdiv(Player_ship->max_rotthrust, pi.mass), FrameTime * 64);
+	angles.p = fixmul(pitch_time, gain);
+	angles.h = fixmul(heading_time, gain);
+}
+
 void reset_cruise(void)
 {
 	Cruise_speed=0;
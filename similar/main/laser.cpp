@@ -26,6 +26,7 @@ COPYRIGHT 1993-1999 PARALLAX SOFTWARE CORPORATION.  ALL RIGHTS RESERVED.
 #include <stdlib.h>
 #include <stdio.h>
 #include <time.h>
+#include <vector>
 
 #include "inferno.h"
 #include "game.h"
@@ -990,6 +991,8 @@ int object_to_object_visibility(const vcobjptridx_t obj1, const vcobjptr_t obj2,
 	fvi_query	fq;
 	fvi_info		hit_data;
 
+	if (!render_pvs_may_see(vcsegptridx(obj1->segnum), vcsegptridx(obj2->segnum)))
+		return 0;
 	fq.p0						= &obj1->pos;
 	fq.startseg				= obj1->segnum;
 	fq.p1						= &obj2->pos;
@@ -1129,6 +1132,46 @@ static imobjptridx_t find_homing_object(const vms_vector &curpos, const vmobjptr
 		return call_find_homing_object_complete(curpos, tracker);
 }
 
+namespace {
+
+/* Objects which a homing weapon could ever track, in object number
+ * order, so that ties resolve as they would in a scan of every object.
+ * Players and ghosts are both kept because players become ghosts and
+ * back without being reallocated.  The list is rebuilt every frame and
+ * whenever an object is allocated.
+ */
+struct homing_candidate_list
+{
+	fix64 time = -1;
+	unsigned allocations;
+	std::vector<objnum_t> objects;
+};
+
+static homing_candidate_list Homing_candidates;
+
+static const std::vector<objnum_t> &get_homing_candidates()
+{
+	auto &c = Homing_candidates;
+	if (c.time == GameTime64 && c.allocations == LevelUniqueObjectState.allocations)
+		return c.objects;
+	c.time = GameTime64;
+	c.allocations = LevelUniqueObjectState.allocations;
+	c.objects.clear();
+	range_for (const auto &&objp, vcobjptridx)
+	{
+		const auto type = objp->type;
+		if (type == OBJ_ROBOT || type == OBJ_PLAYER || type == OBJ_GHOST
+#if defined(DXX_BUILD_DESCENT_II)
+			|| (type == OBJ_WEAPON && is_proximity_bomb_or_smart_mine(get_weapon_id(objp)))
+#endif
+		)
+			c.objects.emplace_back(objp);
+	}
+	return c.objects;
+}
+
+}
+
 //	--------------------------------------------------------------------------------------------
 //	Find object to home in on.
 //	Scan list of objects rendered last frame, find one that satisfies function of nearness to center and distance.
@@ -1163,8 +1206,9 @@ imobjptridx_t find_homing_object_complete(const vms_vector &curpos, const vmobjp
 #endif
 
 	imobjptridx_t	best_objnum = object_none;
-	range_for (const auto &&curobjp, vmobjptridx)
+	range_for (const auto objnum, get_homing_candidates())
 	{
+		const auto &&curobjp = vmobjptridx(objnum);
 		int			is_proximity = 0;
 		fix			dot;
 
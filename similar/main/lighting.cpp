@@ -57,6 +57,12 @@ COPYRIGHT 1993-1999 PARALLAX SOFTWARE CORPORATION.  ALL RIGHTS RESERVED.
 #include "bm.h"
 #include "rle.h"
 #include "wall.h"
+#if DXX_USE_OGL
+#include "ogl_init.h"
+#endif
+#if DXX_USE_EDITOR
+#include "editor/editor.h"
+#endif
 
 #include "compiler-range_for.h"
 #include "partial_range.h"
@@ -70,25 +76,175 @@ static int use_fcd_lighting;
 #define	HEADLIGHT_CONE_DOT	(F1_0*9/10)
 #define	HEADLIGHT_SCALE		(F1_0*10)
 
-static void add_light_div(g3s_lrgb &d, const g3s_lrgb &light, const fix &scale)
+static g3s_lrgb light_div(const g3s_lrgb &light, const fix &scale)
 {
-	d.r += fixdiv(light.r, scale);
-	d.g += fixdiv(light.g, scale);
-	d.b += fixdiv(light.b, scale);
+	return {fixdiv(light.r, scale), fixdiv(light.g, scale), fixdiv(light.b, scale)};
 }
 
-static void add_light_dot_square(g3s_lrgb &d, const g3s_lrgb &light, const fix &dot)
+static g3s_lrgb light_dot_square(const g3s_lrgb &light, const fix &dot)
 {
 	auto square = fixmul(dot, dot);
-	d.r += fixmul(square, light.r)/8;
-	d.g += fixmul(square, light.g)/8;
-	d.b += fixmul(square, light.b)/8;
+	return {fixmul(square, light.r)/8, fixmul(square, light.g)/8, fixmul(square, light.b)/8};
+}
+
+namespace {
+
+//	Uniform grid over the level's vertices, so that each light only
+//	visits the vertices near it.  vm_vec_dist_quick is never less than
+//	the largest difference of any one coordinate, so every vertex a light
+//	can reach lies in a cell overlapping the cube around the light whose
+//	half-width is the light's range.
+constexpr unsigned light_grid_max_cells_per_axis = 16;
+constexpr fix light_grid_min_cell_size = F1_0 * 16;
+
+struct light_vertex_grid
+{
+	bool valid;
+	fix cell_size;
+	vms_vector origin;
+	array<unsigned, 3> cells;
+	//	vertices grouped by cell: those of cell c are
+	//	vertices[cell_start[c]] to vertices[cell_start[c + 1]]
+	array<unsigned, light_grid_max_cells_per_axis * light_grid_max_cells_per_axis * light_grid_max_cells_per_axis + 1> cell_start;
+	array<uint16_t, MAX_VERTICES> vertices;
+	array<uint16_t, MAX_VERTICES> vertex_cell;
+	array<segnum_t, MAX_VERTICES> vertex_segnum;	//a segment using each vertex
+	static_assert(MAX_VERTICES <= UINT16_MAX, "vertex numbers do not fit in uint16_t");
+	void build(fvcsegptridx &vcsegptridx, fvcvertptr &vcvertptr, unsigned n_vertices);
+	template <typename F>
+		bool for_each_vertex_near(const vms_vector &pos, int64_t range, F &&f) const;
+};
+
+//	What a light added to Dynamic_light the last time it was applied, so
+//	that it can be taken out again when the light changes.  A light
+//	which has not moved or changed since then is left alone.
+struct light_contribution
+{
+	uint16_t vertnum;
+	g3s_lrgb light;
+};
+
+struct cached_light
+{
+	bool in_use;
+	uint16_t generation;
+	object_signature_t signature;
+	segnum_t segnum;
+	vms_vector pos;
+	g3s_lrgb emission;
+	std::vector<light_contribution> contributions;
+};
+
+struct dynamic_light_cache
+{
+	uint16_t generation;
+	light_vertex_grid grid;
+	array<cached_light, MAX_OBJECTS> objects;
+	array<cached_light, MUZZLE_QUEUE_MAX> muzzles;
+};
+
+static constexpr fix vms_vector::*const light_grid_axes[3]{&vms_vector::x, &vms_vector::y, &vms_vector::z};
+
+static dynamic_light_cache Dynamic_light_cache;
+
+void light_vertex_grid::build(fvcsegptridx &vcsegptridx, fvcvertptr &vcvertptr, const unsigned n_vertices)
+{
+	valid = false;
+	if (!n_vertices)
+		return;
+	vms_vector lo, hi;
+	lo = hi = *vcvertptr(static_cast<vertnum_t>(0));
+	for (unsigned vnum = 1; vnum != n_vertices; ++vnum)
+	{
+		auto &v = *vcvertptr(static_cast<vertnum_t>(vnum));
+		range_for (const auto axis, light_grid_axes)
+		{
+			if (lo.*axis > v.*axis)
+				lo.*axis = v.*axis;
+			if (hi.*axis < v.*axis)
+				hi.*axis = v.*axis;
+		}
+	}
+	int64_t extent = 0;
+	range_for (const auto axis, light_grid_axes)
+		extent = max(extent, static_cast<int64_t>(hi.*axis) - lo.*axis);
+	cell_size = max(light_grid_min_cell_size, static_cast<fix>(extent / light_grid_max_cells_per_axis + 1));
+	origin = lo;
+	for (unsigned a = 0; a != 3; ++a)
+		cells[a] = (static_cast<int64_t>(hi.*light_grid_axes[a]) - lo.*light_grid_axes[a]) / cell_size + 1;
+	const unsigned n_cells = cells[0] * cells[1] * cells[2];
+	std::fill_n(cell_start.begin(), n_cells + 1, 0);
+	for (unsigned vnum = 0; vnum != n_vertices; ++vnum)
+	{
+		auto &v = *vcvertptr(static_cast<vertnum_t>(vnum));
+		const unsigned cx = (static_cast<int64_t>(v.x) - origin.x) / cell_size;
+		const unsigned cy = (static_cast<int64_t>(v.y) - origin.y) / cell_size;
+		const unsigned cz = (static_cast<int64_t>(v.z) - origin.z) / cell_size;
+		const unsigned c = (cz * cells[1] + cy) * cells[0] + cx;
+		vertex_cell[vnum] = c;
+		++cell_start[c];
+	}
+	//	Make cell_start[c] the end of cell c, then fill each cell from
+	//	its end, which leaves cell_start[c] at the start of cell c.
+	for (unsigned c = 1; c != n_cells; ++c)
+		cell_start[c] += cell_start[c - 1];
+	cell_start[n_cells] = n_vertices;
+	for (unsigned vnum = n_vertices; vnum--;)
+		vertices[--cell_start[vertex_cell[vnum]]] = vnum;
+	std::fill_n(vertex_segnum.begin(), n_vertices, segment_none);
+	range_for (const auto &&segp, vcsegptridx)
+		range_for (const auto vnum, segp->verts)
+			if (vnum < n_vertices && vertex_segnum[vnum] == segment_none)
+				vertex_segnum[vnum] = segp;
+	valid = true;
+}
+
+//	Call f with every vertex which might lie within range of pos.
+//	Returns false if the grid is unavailable.
+template <typename F>
+bool light_vertex_grid::for_each_vertex_near(const vms_vector &pos, const int64_t range, F &&f) const
+{
+	if (!valid)
+		return false;
+	array<unsigned, 3> first, last;
+	for (unsigned a = 0; a != 3; ++a)
+	{
+		const int64_t p = static_cast<int64_t>(pos.*light_grid_axes[a]) - origin.*light_grid_axes[a];
+		const int64_t end = static_cast<int64_t>(cells[a]) * cell_size;
+		if (p + range < 0 || p - range >= end)
+			return true;
+		first[a] = p - range < 0 ? 0 : (p - range) / cell_size;
+		last[a] = p + range >= end ? cells[a] - 1 : (p + range) / cell_size;
+	}
+	for (unsigned cz = first[2]; cz <= last[2]; ++cz)
+		for (unsigned cy = first[1]; cy <= last[1]; ++cy)
+		{
+			const unsigned row = (cz * cells[1] + cy) * cells[0];
+			for (auto i = cell_start[row + first[0]], e = cell_start[row + last[0] + 1]; i != e; ++i)
+				f(vertices[i]);
+		}
+	return true;
+}
+
+static void retire_light(array<g3s_lrgb, MAX_VERTICES> &Dynamic_light, cached_light &cl)
+{
+	range_for (const auto &c, cl.contributions)
+	{
+		auto &d = Dynamic_light[c.vertnum];
+		d.r -= c.light.r;
+		d.g -= c.light.g;
+		d.b -= c.light.b;
+	}
+	cl.contributions.clear();
+	cl.in_use = false;
+}
+
 }
 
 // ----------------------------------------------------------------------------------------------
 namespace dsx {
 
-static void apply_light(fvmsegptridx &vmsegptridx, const g3s_lrgb obj_light_emission, const vcsegptridx_t obj_seg, const vms_vector &obj_pos, const unsigned n_render_vertices, array<unsigned, MAX_VERTICES> &render_vertices, const array<segnum_t, MAX_VERTICES> &vert_segnum_list, const icobjptridx_t objnum)
+static void apply_light(fvmsegptridx &vmsegptridx, const g3s_lrgb obj_light_emission, const vcsegptridx_t obj_seg, const vms_vector &obj_pos, std::vector<light_contribution> &contributions, const icobjptridx_t objnum)
 {
 	if (((obj_light_emission.r+obj_light_emission.g+obj_light_emission.b)/3) > 0)
 	{
@@ -102,6 +258,13 @@ static void apply_light(fvmsegptridx &vmsegptridx, const g3s_lrgb obj_light_emis
 		auto &Dynamic_light = LevelUniqueLightState.Dynamic_light;
 		auto &Vertices = LevelSharedVertexState.get_vertices();
 		auto &vcvertptr = Vertices.vcptr;
+		const auto add_light = [&Dynamic_light, &contributions](const unsigned vertnum, const g3s_lrgb &l) {
+			auto &d = Dynamic_light[vertnum];
+			d.r += l.r;
+			d.g += l.g;
+			d.b += l.b;
+			contributions.emplace_back(light_contribution{static_cast<uint16_t>(vertnum), l});
+		};
 		// for pretty dim sources, only process vertices in object's own segment.
 		//	12/04/95, MK, markers only cast light in own segment.
 		if ((abs(obji_64) <= F1_0*8) || is_marker) {
@@ -117,7 +280,7 @@ static void apply_light(fvmsegptridx &vmsegptridx, const g3s_lrgb obj_light_emis
 					if (dist < MIN_LIGHT_DIST)
 						dist = MIN_LIGHT_DIST;
 
-					add_light_div(Dynamic_light[vertnum], obj_light_emission, dist);
+					add_light(vertnum, light_div(obj_light_emission, dist));
 				}
 			}
 		} else {
@@ -154,19 +317,22 @@ static void apply_light(fvmsegptridx &vmsegptridx, const g3s_lrgb obj_light_emis
 					}
 			}
 #endif
-			for (int vv=0; vv<n_render_vertices; vv++) {
+			auto &grid = Dynamic_light_cache.grid;
+			const auto light_vertex = [&](const unsigned vertnum) {
 				fix			dist;
 				int			apply_light = 0;
 
-				const auto vertnum = render_vertices[vv];
-				auto vsegnum = vert_segnum_list[vv];
 				auto &vertpos = *vcvertptr(vertnum);
 
 				if (use_fcd_lighting && abs(obji_64) > F1_0*32)
 				{
-					dist = find_connected_distance(obj_pos, obj_seg, vertpos, vmsegptridx(vsegnum), n_render_vertices, WID_RENDPAST_FLAG|WID_FLY_FLAG);
-					if (dist >= 0)
-						apply_light = 1;
+					const auto vsegnum = grid.vertex_segnum[vertnum];
+					if (vsegnum != segment_none)
+					{
+						dist = find_connected_distance(obj_pos, obj_seg, vertpos, vmsegptridx(vsegnum), -1, WID_RENDPAST_FLAG|WID_FLY_FLAG);
+						if (dist >= 0)
+							apply_light = 1;
+					}
 				}
 				else
 				{
@@ -188,40 +354,83 @@ static void apply_light(fvmsegptridx &vmsegptridx, const g3s_lrgb obj_light_emis
 						if (dot < F1_0/2)
 						{
 							// Do the normal thing, but darken around headlight.
-							add_light_div(Dynamic_light[vertnum], obj_light_emission, fixmul(HEADLIGHT_SCALE, dist));
+							add_light(vertnum, light_div(obj_light_emission, fixmul(HEADLIGHT_SCALE, dist)));
 						}
 						else
 						{
 							if (!(Game_mode & GM_MULTI) || dist < max_headlight_dist)
 							{
-								add_light_dot_square(Dynamic_light[vertnum], obj_light_emission, dot);
+								add_light(vertnum, light_dot_square(obj_light_emission, dot));
 							}
 						}
 					}
 					else
 					{
-						add_light_div(Dynamic_light[vertnum], obj_light_emission, dist);
+						add_light(vertnum, light_div(obj_light_emission, dist));
 					}
 				}
-			}
+			};
+			if (!grid.for_each_vertex_near(obj_pos, static_cast<int64_t>(abs(obji_64)) << headlight_shift, light_vertex))
+				for (unsigned vertnum = 0, n_vertices = Vertices.get_count(); vertnum != n_vertices; ++vertnum)
+					light_vertex(vertnum);
 		}
 	}
 }
+
+//	A light which apply_light would add to every vertex in its range by
+//	distance alone can be applied per pixel instead.  Dim lights, which
+//	only reach their own segment, and lights which are full or need more
+//	than distance stay in Dynamic_light.
+static bool add_pixel_light(const bool pixel_light, const vms_vector &pos, const g3s_lrgb emission)
+{
+	if (!pixel_light)
+		return false;
+	const fix obji_64 = abs(((emission.r + emission.g + emission.b) / 3) * 64);
+	if (obji_64 <= F1_0*8 || (use_fcd_lighting && obji_64 > F1_0*32))
+		return false;
+	auto &LightState = LevelUniqueLightState;
+	if (LightState.Num_pixel_lights == LightState.Pixel_lights.size())
+		return false;
+	LightState.Pixel_lights[LightState.Num_pixel_lights++] = {pos, obji_64, emission};
+	return true;
+}
+
+//	Bring the contribution of one light up to date.  Unless the light is
+//	new or has changed, what it added last time is still right.
+static void update_light(fvmsegptridx &vmsegptridx, cached_light &cl, const bool cacheable, const object_signature_t signature, const vcsegptridx_t segp, const vms_vector &pos, const g3s_lrgb emission, const icobjptridx_t objnum)
+{
+	cl.generation = Dynamic_light_cache.generation;
+	if (cl.in_use && cacheable &&
+		cl.signature == signature &&
+		cl.segnum == segp &&
+		cl.pos.x == pos.x && cl.pos.y == pos.y && cl.pos.z == pos.z &&
+		cl.emission.r == emission.r && cl.emission.g == emission.g && cl.emission.b == emission.b)
+		return;
+	if (cl.in_use)
+		retire_light(LevelUniqueLightState.Dynamic_light, cl);
+	cl.in_use = true;
+	cl.signature = signature;
+	cl.segnum = segp;
+	cl.pos = pos;
+	cl.emission = emission;
+	apply_light(vmsegptridx, emission, segp, pos, cl.contributions, objnum);
+}
 }
 
 #define FLASH_LEN_FIXED_SECONDS (F1_0/3)
 #define FLASH_SCALE             (3*F1_0/FLASH_LEN_FIXED_SECONDS)
 
 // ----------------------------------------------------------------------------------------------
-static void cast_muzzle_flash_light(fvmsegptridx &vmsegptridx, int n_render_vertices, array<unsigned, MAX_VERTICES> &render_vertices, const array<segnum_t, MAX_VERTICES> &vert_segnum_list)
+static void cast_muzzle_flash_light(fvmsegptridx &vmsegptridx, const bool cacheable, const bool pixel_light)
 {
 	fix64 current_time;
 	short time_since_flash;
 
 	current_time = timer_query();
 
-	range_for (auto &i, Muzzle_data)
+	for (unsigned n = 0; n != Muzzle_data.size(); ++n)
 	{
+		auto &i = Muzzle_data[n];
 		if (i.create_time)
 		{
 			time_since_flash = current_time - i.create_time;
@@ -229,7 +438,8 @@ static void cast_muzzle_flash_light(fvmsegptridx &vmsegptridx, int n_render_vert
 			{
 				g3s_lrgb ml;
 				ml.r = ml.g = ml.b = ((FLASH_LEN_FIXED_SECONDS - time_since_flash) * FLASH_SCALE);
-				apply_light(vmsegptridx, ml, vmsegptridx(i.segnum), i.pos, n_render_vertices, render_vertices, vert_segnum_list, object_none);
+				if (!add_pixel_light(pixel_light, i.pos, ml))
+					update_light(vmsegptridx, Dynamic_light_cache.muzzles[n], cacheable, object_signature_t{0}, vmsegptridx(i.segnum), i.pos, ml, object_none);
 			}
 			else
 			{
@@ -479,10 +689,8 @@ static g3s_lrgb compute_light_emission(const d_vclip_array &Vclip, const vmobjpt
 }
 
 // ----------------------------------------------------------------------------------------------
-void set_dynamic_light(render_state_t &rstate)
+void set_dynamic_light()
 {
-	array<unsigned, MAX_VERTICES> render_vertices;
-	array<segnum_t, MAX_VERTICES> vert_segnum_list;
 	static fix light_time; 
 
 #if defined(DXX_BUILD_DESCENT_II)
@@ -497,45 +705,102 @@ void set_dynamic_light(render_state_t &rstate)
 		return;
 	light_time = light_time - (F1_0/60);
 
-	std::bitset<MAX_VERTICES> render_vertex_flags;
-
-	//	Create list of vertices that need to be looked at for setting of ambient light.
-	auto &Dynamic_light = LevelUniqueLightState.Dynamic_light;
-	uint_fast32_t n_render_vertices = 0;
-	auto &Vertices = LevelSharedVertexState.get_vertices();
-	range_for (const auto segnum, partial_const_range(rstate.Render_list, rstate.N_render_segs))
+	auto &cache = Dynamic_light_cache;
+	//	The editor can change the mine under the cache, so there every
+	//	light is applied again and the grid is rebuilt each time.
+#if DXX_USE_EDITOR
+	const bool cacheable = !EditorWindow;
+#else
+	constexpr bool cacheable = true;
+#endif
+	if (!cache.grid.valid || !cacheable)
 	{
-		if (segnum != segment_none) {
-			auto &vp = Segments[segnum].verts;
-			range_for (const auto vnum, vp)
-			{
-				if (vnum > Vertices.get_count() - 1)
-				{
-					Int3();		//invalid vertex number
-					continue;	//ignore it, and go on to next one
-				}
-				auto &&b = render_vertex_flags[vnum];
-				if (!b)
-				{
-					b = true;
-					render_vertices[n_render_vertices] = vnum;
-					vert_segnum_list[n_render_vertices] = segnum;
-					n_render_vertices++;
-					Dynamic_light[vnum] = {};
-				}
-			}
-		}
+		auto &Vertices = LevelSharedVertexState.get_vertices();
+		cache.grid.build(vcsegptridx, Vertices.vcptr, Vertices.get_count());
 	}
+	++cache.generation;
+
+	//	Lights which are applied per pixel are left out of Dynamic_light,
+	//	so the cache retires what they added to it.
+#if DXX_USE_OGL
+	const bool pixel_light = cacheable && ogl_use_pixel_light_shader();
+#else
+	constexpr bool pixel_light = false;
+#endif
+	auto &LightState = LevelUniqueLightState;
+	LightState.Num_pixel_lights = 0;
+	++LightState.Pixel_light_generation;
 
-	cast_muzzle_flash_light(vmsegptridx, n_render_vertices, render_vertices, vert_segnum_list);
+	cast_muzzle_flash_light(vmsegptridx, cacheable, pixel_light);
 
 	range_for (const auto &&obj, vmobjptridx)
 	{
 		const auto &&obj_light_emission = compute_light_emission(Vclip, obj);
 
 		if (((obj_light_emission.r+obj_light_emission.g+obj_light_emission.b)/3) > 0)
-			apply_light(vmsegptridx, obj_light_emission, vmsegptridx(obj->segnum), obj->pos, n_render_vertices, render_vertices, vert_segnum_list, obj);
+		{
+#if defined(DXX_BUILD_DESCENT_II)
+			//	A headlight also depends on which way its player faces.
+			const bool headlight = obj->type == OBJ_PLAYER && (obj->ctype.player_info.powerup_flags & PLAYER_FLAGS_HEADLIGHT_ON);
+#else
+			constexpr bool headlight = false;
+#endif
+#if defined(DXX_BUILD_DESCENT_II)
+			const bool marker = obj->type == OBJ_MARKER;
+#else
+			constexpr bool marker = false;
+#endif
+			if (headlight || marker || !add_pixel_light(pixel_light, obj->pos, obj_light_emission))
+				update_light(vmsegptridx, cache.objects[obj], cacheable && !headlight, obj->signature, vmsegptridx(obj->segnum), obj->pos, obj_light_emission, obj);
+		}
+	}
+
+	//	Take out lights which are gone or no longer shine.
+	auto &Dynamic_light = LevelUniqueLightState.Dynamic_light;
+	range_for (auto &cl, cache.objects)
+		if (cl.in_use && cl.generation != cache.generation)
+			retire_light(Dynamic_light, cl);
+	range_for (auto &cl, cache.muzzles)
+		if (cl.in_use && cl.generation != cache.generation)
+			retire_light(Dynamic_light, cl);
+}
+
+void reset_dynamic_light()
+{
+	auto &cache = Dynamic_light_cache;
+	range_for (auto &cl, cache.objects)
+	{
+		cl.in_use = false;
+		cl.contributions.clear();
+	}
+	range_for (auto &cl, cache.muzzles)
+	{
+		cl.in_use = false;
+		cl.contributions.clear();
+	}
+	cache.grid.valid = false;
+	LevelUniqueLightState.Dynamic_light = {};
+	LevelUniqueLightState.Num_pixel_lights = 0;
+}
+
+g3s_lrgb compute_pixel_light(const vms_vector &pos)
+{
+	g3s_lrgb sum{0, 0, 0};
+	auto &LightState = LevelUniqueLightState;
+	range_for (auto &l, partial_const_range(LightState.Pixel_lights, LightState.Num_pixel_lights))
+	{
+		fix dist = vm_vec_dist_quick(l.pos, pos);
+		if (dist < l.range)
+		{
+			if (dist < MIN_LIGHT_DIST)
+				dist = MIN_LIGHT_DIST;
+			const auto &&d = light_div(l.emission, dist);
+			sum.r += d.r;
+			sum.g += d.g;
+			sum.b += d.b;
+		}
 	}
+	return sum;
 }
 
 // ---------------------------------------------------------
@@ -673,5 +938,24 @@ g3s_lrgb compute_object_light(const vcobjptridx_t obj)
 	light.g += seg_dl.g;
 	light.b += seg_dl.b;
 
+	//	Objects are still lit by the average over their segment's
+	//	vertices, so average the pixel lights there too.
+	if (LevelUniqueLightState.Num_pixel_lights)
+	{
+		auto &Vertices = LevelSharedVertexState.get_vertices();
+		auto &vcvertptr = Vertices.vcptr;
+		g3s_lrgb sum{0, 0, 0};
+		range_for (const auto v, objsegp->verts)
+		{
+			const auto &&l = compute_pixel_light(*vcvertptr(v));
+			sum.r += l.r;
+			sum.g += l.g;
+			sum.b += l.b;
+		}
+		light.r += sum.r >> 3;
+		light.g += sum.g >> 3;
+		light.b += sum.b >> 3;
+	}
+
 	return light;
 }
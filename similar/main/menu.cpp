@@ -34,6 +34,7 @@ COPYRIGHT 1993-1999 PARALLAX SOFTWARE CORPORATION.  ALL RIGHTS RESERVED.
 #include "key.h"
 #include "mouse.h"
 #include "iff.h"
+#include "ignorecase.h"
 #include "u_mem.h"
 #include "dxxerror.h"
 #include "bm.h"
@@ -63,6 +64,7 @@ COPYRIGHT 1993-1999 PARALLAX SOFTWARE CORPORATION.  ALL RIGHTS RESERVED.
 #include "texmap.h"
 #include "polyobj.h"
 #include "state.h"
+#include "replay.h"
 #include "mission.h"
 #include "songs.h"
 #if DXX_USE_SDLMIXER
@@ -299,6 +301,7 @@ static window_event_result player_menu_keycommand( listbox *lb,const d_event &ev
 
 					snprintf(name, sizeof(name), PLAYER_DIRECTORY_STRING("%.8s.plr"), items[citem]);
 
+					player_file_forget();
 					ret = !PHYSFS_delete(name);
 
 					if (!ret)
@@ -506,6 +509,13 @@ static int main_menu_handler(newmenu *menu,const d_event &event, int *menu_choic
 			{
 				keyd_time_when_last_pressed = timer_query();			// Reset timer so that disk won't thrash if no demos.
 
+				// -replay and -replay_check start a game once, in place of the first demo
+				if (CGameArg.SysAutoDemo && (!CGameArg.SysReplay.empty() || !CGameArg.SysReplayCheck.empty()))
+				{
+					CGameArg.SysAutoDemo = false;
+					replay_start();
+					break;
+				}
 #if defined(DXX_BUILD_DESCENT_II)
 				int n_demos = newdemo_count_demos();
 				if ((d_rand() % (n_demos+1)) == 0 && !CGameArg.SysAutoDemo)
@@ -520,7 +530,9 @@ static int main_menu_handler(newmenu *menu,const d_event &event, int *menu_choic
 				else
 #endif
 				{
-					newdemo_start_playback(NULL);		// Randomly pick a file, assume native endian (crashes if not)
+					// Randomly pick a file unless -demo_stats, -demo_video or -timedemo named one, assume native endian (crashes if not)
+					const auto &name = !CGameArg.SysDemoStats.empty() ? CGameArg.SysDemoStats : (!CGameArg.SysDemoVideo.empty() ? CGameArg.SysDemoVideo : CGameArg.SysTimeDemo);
+					newdemo_start_playback(name.empty() ? nullptr : name.c_str());
 #if defined(DXX_BUILD_DESCENT_II)
 					if (Newdemo_state == ND_STATE_PLAYBACK)
 						return 0;
@@ -1846,7 +1858,10 @@ static window_event_result select_file_handler(listbox *menu,const d_event &even
 		}
 		case EVENT_WINDOW_CLOSE:
 			if (b->new_path)
+			{
 				PHYSFS_removeFromSearchPath(b->view_path);
+				PHYSFSEXT_flushCaseCache();
+			}
 
 			std::default_delete<browser>()(b);
 			break;
@@ -1929,6 +1944,7 @@ static int select_file_recursive2(const char *title, const char *orig_path, cons
 			return 0;
 		}
 	}
+	PHYSFSEXT_flushCaseCache();
 	
 	if (!list_directory(b.get()))
 	{
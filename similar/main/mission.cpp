@@ -24,7 +24,10 @@ COPYRIGHT 1993-1999 PARALLAX SOFTWARE CORPORATION.  ALL RIGHTS RESERVED.
  */
 
 #include <algorithm>
+#include <atomic>
+#include <unordered_map>
 #include <vector>
+#include <SDL.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -32,6 +35,7 @@ COPYRIGHT 1993-1999 PARALLAX SOFTWARE CORPORATION.  ALL RIGHTS RESERVED.
 #include <limits.h>
 
 #include "pstypes.h"
+#include "args.h"
 #include "strutil.h"
 #include "inferno.h"
 #include "window.h"
@@ -41,6 +45,7 @@ COPYRIGHT 1993-1999 PARALLAX SOFTWARE CORPORATION.  ALL RIGHTS RESERVED.
 #include "titles.h"
 #include "piggy.h"
 #include "console.h"
+#include "profile.h"
 #include "songs.h"
 #include "polyobj.h"
 #include "dxxerror.h"
@@ -421,28 +426,115 @@ static bool ml_sort_func(const mle &e0,const mle &e1)
 	return d_stricmp(e0.mission_name,e1.mission_name) < 0;
 }
 
-//returns 1 if file read ok, else 0
+namespace {
+
+/* Catalog of the mission files already read, kept in missions.cat in
+ * the write directory.  An entry is reused while its file keeps the
+ * same size and modification time, so building the mission list only
+ * opens new or changed missions.  mission_catalog_refresh brings the
+ * catalog up to date in a thread while the title screens show.
+ */
+#define MISSION_CATALOG_FILENAME	"missions.cat"
+
+struct mission_catalog_entry
+{
+	PHYSFS_sint64 size, mtime;
+	bool valid, anarchy_only, seen;
+	ntstring<75> mission_name;
+};
+
+struct mission_catalog_state
+{
+	bool loaded, dirty;
+	SDL_mutex *lock;
+	SDL_Thread *thread;
+	std::atomic<bool> stop;
+	std::unordered_map<std::string, mission_catalog_entry> entries;
+};
+
+class mission_catalog_lock
+{
+	SDL_mutex *const m;
+public:
+	mission_catalog_lock(SDL_mutex *const l) :
+		m(l)
+	{
+		if (m)
+			SDL_LockMutex(m);
+	}
+	~mission_catalog_lock()
+	{
+		if (m)
+			SDL_UnlockMutex(m);
+	}
+	mission_catalog_lock(const mission_catalog_lock &) = delete;
+	mission_catalog_lock &operator=(const mission_catalog_lock &) = delete;
+};
+
+}
+
+static mission_catalog_state mission_catalog;
+
+/* Call with the lock held. */
+static void mission_catalog_load()
+{
+	auto &c = mission_catalog;
+	if (c.loaded)
+		return;
+	c.loaded = true;
+	auto fp = PHYSFSX_openReadBuffered(MISSION_CATALOG_FILENAME);
+	if (!fp)
+		return;
+	PHYSFSX_gets_line_t<PATH_MAX + 128> line;
+	while (PHYSFSX_fgets(line, fp))
+	{
+		long long size, mtime;
+		unsigned flags;
+		int n;
+		if (sscanf(line, "%lld %lld %u %n", &size, &mtime, &flags, &n) != 3)
+			continue;
+		const char *const pathname = &line[n];
+		const auto tab = strchr(pathname, '\t');
+		if (!tab)
+			continue;
+		mission_catalog_entry e{};
+		e.size = size;
+		e.mtime = mtime;
+		e.valid = flags & 1;
+		e.anarchy_only = flags & 2;
+		e.mission_name.copy_if(tab + 1, e.mission_name.size() - 1);
+		c.entries.emplace(std::string(pathname, tab), e);
+	}
+}
+
+/* Call with the lock held, after a scan of every mission file, so that
+ * entries of deleted files are dropped.
+ */
+static void mission_catalog_save()
+{
+	auto &c = mission_catalog;
+	if (!c.dirty)
+		return;
+	c.dirty = false;
+	auto fp = PHYSFSX_openWriteBuffered(MISSION_CATALOG_FILENAME);
+	if (!fp)
+		return;
+	range_for (auto &i, c.entries)
+	{
+		auto &e = i.second;
+		if (!e.seen)
+			continue;
+		PHYSFSX_printf(fp, "%lld %lld %u %s\t%s\n", static_cast<long long>(e.size), static_cast<long long>(e.mtime), (e.valid ? 1u : 0u) | (e.anarchy_only ? 2u : 0u), i.first.c_str(), e.mission_name.data());
+	}
+}
+
+//reads the name and type of a mission.  returns 1 if file read ok, else 0
 namespace dsx {
-static int read_mission_file(mission_list_type &mission_list, mission_candidate_search_path &pathname)
+static bool read_mission_name(const char *const pathname, mission_catalog_entry &entry)
 {
-	if (const auto mfile = PHYSFSX_openReadBuffered(pathname.data()))
+	if (const auto mfile = PHYSFSX_openReadBuffered(pathname))
 	{
-		std::string str_pathname = pathname.data();
-		const auto idx_last_slash = str_pathname.find_last_of('/');
-		const auto idx_filename = (idx_last_slash == str_pathname.npos) ? 0 : idx_last_slash + 1;
-		const auto idx_file_extension = str_pathname.find_first_of('.', idx_filename);
-		if (idx_file_extension == str_pathname.npos)
-			return 0;	//missing extension
-		str_pathname.resize(idx_file_extension);
-		mission_list.emplace_back(Mission_path(std::move(str_pathname), idx_filename));
-		mle *mission = &mission_list.back();
-#if defined(DXX_BUILD_DESCENT_II)
-		// look if it's .mn2 or .msn
-		mission->descent_version = (pathname[idx_file_extension + 3] == MISSION_EXTENSION_DESCENT_II[3])
-			? Mission::descent_version_type::descent2
-			: Mission::descent_version_type::descent1;
-#endif
-		mission->anarchy_only_flag = 0;
+		entry.anarchy_only = false;
 
 		PHYSFSX_gets_line_t<80> buf;
 		auto p = get_parm_value(buf, "name",mfile);
@@ -471,12 +563,10 @@ static int read_mission_file(mission_list_type &mission_list, mission_candidate_
 			t = p + strlen(p)-1;
 			while (isspace(*t))
 				*t-- = 0; // remove trailing whitespace
-			mission->mission_name.copy_if(p, mission->mission_name.size() - 1);
-		}
-		else {
-			mission_list.pop_back();
-			return 0;
+			entry.mission_name.copy_if(p, entry.mission_name.size() - 1);
 		}
+		else
+			return false;
 
 		{
 			PHYSFSX_gets_line_t<4096> temp;
@@ -487,14 +577,67 @@ static int read_mission_file(mission_list_type &mission_list, mission_candidate_
 				p = get_value(temp);
 				//get mission type
 				if (p)
-					mission->anarchy_only_flag = istok(p,"anarchy");
+					entry.anarchy_only = istok(p,"anarchy");
 			}
 		}
 		}
-		return 1;
+		return true;
 	}
 
-	return 0;
+	return false;
+}
+
+static bool mission_catalog_read(const char *const pathname, mission_catalog_entry &entry)
+{
+	auto &c = mission_catalog;
+	PHYSFS_sint64 size, mtime;
+	if (CGameArg.SysNoMissionCache || !PHYSFSX_stat(pathname, size, mtime))
+		return read_mission_name(pathname, entry);
+	{
+		const mission_catalog_lock lock(c.lock);
+		mission_catalog_load();
+		const auto i = c.entries.find(pathname);
+		if (i != c.entries.end() && i->second.size == size && i->second.mtime == mtime)
+		{
+			i->second.seen = true;
+			entry = i->second;
+			return entry.valid;
+		}
+	}
+	entry.valid = read_mission_name(pathname, entry);
+	entry.size = size;
+	entry.mtime = mtime;
+	entry.seen = true;
+	const mission_catalog_lock lock(c.lock);
+	c.entries[pathname] = entry;
+	c.dirty = true;
+	return entry.valid;
+}
+
+//returns 1 if file read ok, else 0
+static int read_mission_file(mission_list_type &mission_list, mission_candidate_search_path &pathname)
+{
+	std::string str_pathname = pathname.data();
+	const auto idx_last_slash = str_pathname.find_last_of('/');
+	const auto idx_filename = (idx_last_slash == str_pathname.npos) ? 0 : idx_last_slash + 1;
+	const auto idx_file_extension = str_pathname.find_first_of('.', idx_filename);
+	if (idx_file_extension == str_pathname.npos)
+		return 0;	//missing extension
+	mission_catalog_entry entry;
+	if (!mission_catalog_read(pathname.data(), entry))
+		return 0;
+	str_pathname.resize(idx_file_extension);
+	mission_list.emplace_back(Mission_path(std::move(str_pathname), idx_filename));
+	mle *mission = &mission_list.back();
+#if defined(DXX_BUILD_DESCENT_II)
+	// look if it's .mn2 or .msn
+	mission->descent_version = (pathname[idx_file_extension + 3] == MISSION_EXTENSION_DESCENT_II[3])
+		? Mission::descent_version_type::descent2
+		: Mission::descent_version_type::descent1;
+#endif
+	mission->anarchy_only_flag = entry.anarchy_only;
+	mission->mission_name = entry.mission_name;
+	return 1;
 }
 }
 
@@ -668,6 +811,57 @@ static void add_missions_to_list(mission_list_type &mission_list, mission_candid
 }
 }
 
+namespace dsx {
+
+static void mission_catalog_scan(mission_candidate_search_path &path, const mission_candidate_search_path::iterator rel_path)
+{
+	/* Same path handling as add_missions_to_list. */
+	const std::size_t space_remaining = std::distance(rel_path, path.end());
+	range_for (const auto i, PHYSFSX_uncounted_list{PHYSFS_enumerateFiles(path.data())})
+	{
+		if (mission_catalog.stop.load(std::memory_order_relaxed))
+			return;
+		const std::size_t il = strlen(i) + 1;
+		if (il + 1 >= space_remaining)
+			continue;	// path is too long
+		auto j = std::copy_n(i, il, rel_path);
+		const char *ext;
+		if (PHYSFS_isDirectory(path.data()))
+		{
+			auto null = std::prev(j);
+			*j = 0;
+			*null = '/';
+			mission_catalog_scan(path, j);
+		}
+		else if (il > 5 &&
+			((ext = &i[il - 5], !d_strnicmp(ext, MISSION_EXTENSION_DESCENT_I))
+#if defined(DXX_BUILD_DESCENT_II)
+				|| !d_strnicmp(ext, MISSION_EXTENSION_DESCENT_II)
+#endif
+			))
+		{
+			mission_catalog_entry entry;
+			mission_catalog_read(path.data(), entry);
+		}
+		*rel_path = 0;	// chop off the entry
+	}
+}
+
+static int mission_catalog_thread(void *)
+{
+	mission_candidate_search_path search_str = {{MISSION_DIR}};
+	mission_catalog_scan(search_str, search_str.begin() + sizeof(MISSION_DIR) - 1);
+	auto &c = mission_catalog;
+	if (!c.stop.load(std::memory_order_relaxed))
+	{
+		const mission_catalog_lock lock(c.lock);
+		mission_catalog_save();
+	}
+	return 0;
+}
+
+}
+
 /* move <mission_name> to <place> on mission list, increment <place> */
 static void promote (mission_list_type &mission_list, const char *const name, std::size_t &top_place)
 {
@@ -700,6 +894,7 @@ Mission::~Mission()
 namespace dsx {
 static mission_list_type build_mission_list(int anarchy_mode)
 {
+	const trace_scope trace_phase("build_mission_list");
 
 	//now search for levels on disk
 
@@ -736,10 +931,45 @@ static mission_list_type build_mission_list(int anarchy_mode)
 
 	if (mission_list.size() > top_place)
 		std::sort(next(begin(mission_list), top_place), end(mission_list), ml_sort_func);
+	{
+		const mission_catalog_lock lock(mission_catalog.lock);
+		mission_catalog_save();
+	}
 	return mission_list;
 }
 }
 
+void mission_catalog_refresh()
+{
+	auto &c = mission_catalog;
+	if (CGameArg.SysNoMissionCache || c.thread)
+		return;
+	if (!c.lock && !(c.lock = SDL_CreateMutex()))
+		return;
+	c.stop.store(false, std::memory_order_relaxed);
+#if SDL_MAJOR_VERSION == 2
+	c.thread = SDL_CreateThread(mission_catalog_thread, "mission_catalog", nullptr);
+#else
+	c.thread = SDL_CreateThread(mission_catalog_thread, nullptr);
+#endif
+}
+
+void mission_catalog_close()
+{
+	auto &c = mission_catalog;
+	if (c.thread)
+	{
+		c.stop.store(true, std::memory_order_relaxed);
+		SDL_WaitThread(c.thread, nullptr);
+		c.thread = nullptr;
+	}
+	if (c.lock)
+	{
+		SDL_DestroyMutex(c.lock);
+		c.lock = nullptr;
+	}
+}
+
 #if defined(DXX_BUILD_DESCENT_II)
 //values for built-in mission
 
@@ -825,6 +1055,7 @@ namespace dsx {
 
 static const char *load_mission(const mle *const mission)
 {
+	const trace_scope trace_phase("load_mission", mission->path.c_str());
 	char *v;
 
 #if defined(DXX_BUILD_DESCENT_II)
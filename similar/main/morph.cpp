@@ -39,6 +39,9 @@ COPYRIGHT 1993-1998 PARALLAX SOFTWARE CORPORATION.  ALL RIGHTS RESERVED.
 #include "piggy.h"
 #include "bm.h"
 #include "interp.h"
+#if DXX_USE_OGL
+#include "ogl_init.h"
+#endif
 
 #include "compiler-range_for.h"
 #include "partial_range.h"
@@ -205,22 +208,34 @@ static void update_points(polymodel *pm,int submodel_num,morph_data *md)
 	else
 		i = 0;				//start at zero
 
-	auto vp = reinterpret_cast<const vms_vector *>(data);
-
-	while (nverts--) {
+	const auto vp = reinterpret_cast<const vms_vector *>(data);
+	const fix frame_time = FrameTime;
+	const auto vecs = &md->morph_vecs[i];
+	const auto deltas = &md->morph_deltas[i];
+	const auto times = &md->morph_times[i];
+	unsigned arrived_count = 0;
 
-		if (md->morph_times[i])		//not done yet
-		{
-			if ((md->morph_times[i] -= FrameTime) <= 0) {
-				md->morph_vecs[i] = *vp;
-				md->morph_times[i] = 0;
-				md->n_morphing_points[submodel_num]--;
-			}
-			else
-				vm_vec_scale_add2(md->morph_vecs[i],md->morph_deltas[i],FrameTime);
-		}
-		vp++; i++;
+	//the points are independent, so advance them all with selects instead
+	//of branches and let the compiler vectorize the loop
+	for (unsigned j = 0; j != nverts; ++j)
+	{
+		const fix t = times[j];
+		const fix left = t - frame_time;
+		const bool moving = t != 0;		//0 means done
+		const bool arrived = moving && left <= 0;
+		auto &v = vecs[j];
+		const auto &d = deltas[j];
+		const auto &target = vp[j];
+		const fix x = v.x + fixmul(d.x, frame_time);
+		const fix y = v.y + fixmul(d.y, frame_time);
+		const fix z = v.z + fixmul(d.z, frame_time);
+		v.x = arrived ? target.x : (moving ? x : v.x);
+		v.y = arrived ? target.y : (moving ? y : v.y);
+		v.z = arrived ? target.z : (moving ? z : v.z);
+		times[j] = (moving && !arrived) ? left : 0;
+		arrived_count += arrived;
 	}
+	md->n_morphing_points[submodel_num] -= arrived_count;
 }
 
 
@@ -387,6 +402,9 @@ static void draw_model(grs_canvas &canvas, polygon_model_points &robot_points, p
 			// Hmmm... cache got flushed in the middle of paging all these in,
 			// so we need to reread them all in.
 			// Make sure that they can all fit in memory.
+#if DXX_USE_OGL
+			if (!ogl_draw_morphing_submodel_mesh(canvas, *pm, submodel_num, &texture_list[0], anim_angles, light, md->morph_vecs.data(), md->morph_vecs.size()))
+#endif
 			g3_draw_morphing_model(canvas, &pm->model_data[pm->submodel_ptrs[submodel_num]], &texture_list[0], anim_angles, light, &md->morph_vecs[md->submodel_startpoints[submodel_num]], robot_points);
 		}
 		else {
@@ -157,9 +157,28 @@ array<msgsend_state_t, MAX_PLAYERS> multi_sending_message;
 int multi_defining_message = 0;
 static int multi_message_index;
 
-static array<array<objnum_t, MAX_OBJECTS>, MAX_PLAYERS> remote_to_local;  // Remote object number for each local object
-static array<uint16_t, MAX_OBJECTS> local_to_remote;
-array<sbyte, MAX_OBJECTS> object_owner;   // Who created each object in my universe, -1 = loaded at start
+namespace {
+
+// Entries stamped with a generation other than object_map_generation are
+// unmapped, so reset_network_objects does not need to clear the tables.
+struct local_object_map_entry
+{
+	uint16_t generation;
+	int8_t owner;	// Who created this object in my universe, -1 = loaded at start
+	uint16_t remote;
+};
+
+struct remote_object_map_entry
+{
+	uint16_t generation;
+	objnum_t local;
+};
+
+}
+
+static uint16_t object_map_generation = 1;
+static array<array<remote_object_map_entry, MAX_OBJECTS>, MAX_PLAYERS> remote_to_local;  // Local object number for each remote object of each owner
+static array<local_object_map_entry, MAX_OBJECTS> local_to_remote;
 
 unsigned   Net_create_loc;       // pointer into previous array
 array<objnum_t, MAX_NET_CREATE_OBJECTS>   Net_create_objnums; // For tracking object creation that will be sent to remote
@@ -326,8 +345,8 @@ objnum_t objnum_remote_to_local(uint16_t remote_objnum, int8_t owner)
 	if (remote_objnum >= MAX_OBJECTS)
 		return(object_none);
 
-	auto result = remote_to_local[owner][remote_objnum];
-	return(result);
+	auto &e = remote_to_local[owner][remote_objnum];
+	return e.generation == object_map_generation ? e.local : object_none;
 }
 
 owned_remote_objnum objnum_local_to_remote(objnum_t local_objnum)
@@ -337,10 +356,11 @@ owned_remote_objnum objnum_local_to_remote(objnum_t local_objnum)
 	{
 		return {owner_none, 0xffff};
 	}
-	auto owner = object_owner[local_objnum];
-	if (owner == owner_none)
-		return {owner, local_objnum};
-	auto result = local_to_remote[local_objnum];
+	auto &e = local_to_remote[local_objnum];
+	if (e.generation != object_map_generation || e.owner == owner_none)
+		return {owner_none, local_objnum};
+	const auto owner = e.owner;
+	const auto result = e.remote;
 	const char *emsg;
 	if (
 		((owner >= N_players || owner < -1) && (emsg = "illegal object owner", true)) ||
@@ -368,10 +388,9 @@ void map_objnum_local_to_remote(const int local_objnum, const int remote_objnum,
 	Assert(owner > -1);
 	Assert(owner != Player_num);
 
-	object_owner[local_objnum] = owner;
-
-	remote_to_local[owner][remote_objnum] = local_objnum;
-	local_to_remote[local_objnum] = remote_objnum;
+	const auto generation = object_map_generation;
+	remote_to_local[owner][remote_objnum] = {generation, static_cast<objnum_t>(local_objnum)};
+	local_to_remote[local_objnum] = {generation, static_cast<int8_t>(owner), static_cast<uint16_t>(remote_objnum)};
 
 	return;
 }
@@ -381,19 +400,38 @@ void map_objnum_local_to_local(objnum_t local_objnum)
 	// Add a mapping for our locally created objects
 	Assert(local_objnum < MAX_OBJECTS);
 
-	object_owner[local_objnum] = Player_num;
-	remote_to_local[Player_num][local_objnum] = local_objnum;
-	local_to_remote[local_objnum] = local_objnum;
+	const auto generation = object_map_generation;
+	remote_to_local[Player_num][local_objnum] = {generation, local_objnum};
+	local_to_remote[local_objnum] = {generation, static_cast<int8_t>(Player_num), local_objnum};
 
 	return;
 }
 
+int8_t multi_object_owner(const objnum_t local_objnum)
+{
+	if (local_objnum >= MAX_OBJECTS)
+		return owner_none;
+	auto &e = local_to_remote[local_objnum];
+	return e.generation == object_map_generation ? e.owner : owner_none;
+}
+
+void multi_clear_object_owner(const objnum_t local_objnum)
+{
+	Assert(local_objnum < MAX_OBJECTS);
+	local_to_remote[local_objnum] = {object_map_generation, owner_none, 0xffff};
+}
+
 void reset_network_objects()
 {
-	local_to_remote.fill(-1);
-	range_for (auto &i, remote_to_local)
-		i.fill(object_none);
-	object_owner.fill(-1);
+	/* Only clear the tables when the generation wraps, so that a
+	 * stale entry can never match.
+	 */
+	if (!++object_map_generation)
+	{
+		local_to_remote = {};
+		remote_to_local = {};
+		object_map_generation = 1;
+	}
 }
 
 int multi_objnum_is_past(objnum_t objnum)
@@ -2142,6 +2180,7 @@ static void multi_do_door_open(fvmwallptr &vmwallptr, const uint8_t *const buf)
 	}
 #if defined(DXX_BUILD_DESCENT_II)
 	w.flags = flag;
+	flush_fcd_cache();
 #endif
 
 }
@@ -3934,6 +3973,7 @@ static void multi_do_wall_status(fvmwallptr &vmwallptr, const uint8_t *const buf
 	w.flags = flag;
 	//Assert(state <= 4);
 	w.state = state;
+	flush_fcd_cache();
 
 	if (w.type == WALL_OPEN)
 	{
@@ -4095,6 +4135,7 @@ static void multi_do_light (const ubyte *buf)
 			side_array[i].tmap_num2 = GET_INTEL_SHORT(&buf[4 + (2 * i)]);
 		}
 	}
+	flush_fcd_cache();
 }
 
 static void multi_do_flags(fvmobjptr &vmobjptr, const playernum_t pnum, const uint8_t *const buf)
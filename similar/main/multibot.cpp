@@ -88,6 +88,11 @@ constexpr serial::endian_access::native_endian_type serial::endian_access::nativ
 
 #define MIN_TO_ADD	60
 
+// Position updates for robots no other player is near are sent at most
+// this often.
+#define ROBOT_IRRELEVANT_SEND_INTERVAL	(F1_0/2)
+#define ROBOT_RELEVANT_DISTANCE	(F1_0*200)
+
 array<objnum_t, MAX_ROBOTS_CONTROLLED> robot_controlled;
 array<int, MAX_ROBOTS_CONTROLLED> robot_agitation,
 	robot_send_pending,
@@ -95,6 +100,7 @@ array<int, MAX_ROBOTS_CONTROLLED> robot_agitation,
 array<fix64, MAX_ROBOTS_CONTROLLED> robot_controlled_time,
 	robot_last_send_time,
 	robot_last_message_time;
+static array<fix64, MAX_ROBOTS_CONTROLLED> robot_last_position_time;
 ubyte robot_fire_buf[MAX_ROBOTS_CONTROLLED][18+3];
 
 #define MULTI_ROBOT_PRIORITY(objnum, pnum) (((objnum % 4) + pnum) % N_players)
@@ -239,6 +245,78 @@ void multi_strip_robots(const int playernum)
 
 }
 
+namespace {
+
+// When this player would claim a robot which another player is much
+// nearer and has a free slot for, leave it for MIN_CONTROL_TIME so that
+// the nearer player can claim it.  Claims are first-come, so without
+// this whoever notices a robot first keeps it, which is usually the
+// host.  Once that time passes the robot is claimed as before, since
+// the nearer player may not be aware of the robot at all.
+struct robot_claim_deferral
+{
+	fix64 owner_count_time = -1;
+	array<unsigned, MAX_PLAYERS> owner_count;
+	array<fix64, MAX_OBJECTS> defer_until;
+	unsigned controlled_by(playernum_t pnum);
+	bool defer(const vcobjptridx_t robot);
+};
+
+static robot_claim_deferral Robot_claim_deferral;
+
+unsigned robot_claim_deferral::controlled_by(const playernum_t pnum)
+{
+	if (owner_count_time != GameTime64)
+	{
+		owner_count_time = GameTime64;
+		owner_count = {};
+		range_for (const auto &&objp, vcobjptr)
+		{
+			auto &obj = *objp;
+			if (obj.type == OBJ_ROBOT)
+			{
+				const unsigned owner = obj.ctype.ai_info.REMOTE_OWNER;
+				if (owner < owner_count.size())
+					++ owner_count[owner];
+			}
+		}
+	}
+	return owner_count[pnum];
+}
+
+bool robot_claim_deferral::defer(const vcobjptridx_t robot)
+{
+	auto &until = defer_until[robot];
+	if (until > GameTime64 + MIN_CONTROL_TIME)
+		/* Left over from an earlier level */
+		until = 0;
+	if (GameTime64 < until)
+		return true;
+	if (GameTime64 < until + ROBOT_TIMEOUT)
+		return false;
+	const auto my_dist = vm_vec_dist_quick(vcobjptr(get_local_player().objnum)->pos, robot->pos);
+	for (playernum_t i = 0; i < N_players; ++i)
+	{
+		if (i == Player_num)
+			continue;
+		auto &plr = *vcplayerptr(i);
+		if (plr.connected != CONNECT_PLAYING)
+			continue;
+		auto &plrobj = *vcobjptr(plr.objnum);
+		if (plrobj.type != OBJ_PLAYER)
+			continue;
+		if (vm_vec_dist_quick(plrobj.pos, robot->pos) >= my_dist / 2)
+			continue;
+		if (controlled_by(i) >= MAX_ROBOTS_CONTROLLED)
+			continue;
+		until = GameTime64 + MIN_CONTROL_TIME;
+		return true;
+	}
+	return false;
+}
+
+}
+
 namespace dsx {
 int multi_add_controlled_robot(const vmobjptridx_t objnum, int agitation)
 {
@@ -260,6 +338,9 @@ int multi_add_controlled_robot(const vmobjptridx_t objnum, int agitation)
 		return 0;
 	}
 
+	if (agitation < ROBOT_FIRE_AGITATION && Robot_claim_deferral.defer(objnum))
+		return 0;
+
 	for (i = 0; i < MAX_ROBOTS_CONTROLLED; i++)
 	{
 		if (robot_controlled[i] == object_none || vcobjptr(robot_controlled[i])->type != OBJ_ROBOT) {
@@ -310,6 +391,7 @@ int multi_add_controlled_robot(const vmobjptridx_t objnum, int agitation)
 	objnum->ctype.ai_info.REMOTE_SLOT_NUM = i;
 	robot_controlled_time[i] = GameTime64;
 	robot_last_send_time[i] = robot_last_message_time[i] = GameTime64;
+	robot_last_position_time[i] = 0;
 	return(1);
 }	
 }
@@ -378,6 +460,30 @@ void multi_send_release_robot(const vmobjptridx_t objnum)
 
 #define MIN_ROBOT_COM_GAP F1_0/12
 
+// Whether another player is close enough to see the robot move: in the
+// same or an adjacent segment, or within ROBOT_RELEVANT_DISTANCE.
+static bool multi_robot_is_relevant(const object_base &robot)
+{
+	const auto &robot_seg = *vcsegptr(robot.segnum);
+	for (playernum_t i = 0; i < N_players; ++i)
+	{
+		if (i == Player_num)
+			continue;
+		auto &plr = *vcplayerptr(i);
+		if (plr.connected != CONNECT_PLAYING)
+			continue;
+		auto &plrobj = *vcobjptr(plr.objnum);
+		if (plrobj.segnum == robot.segnum)
+			return true;
+		range_for (const auto childnum, robot_seg.children)
+			if (childnum == plrobj.segnum)
+				return true;
+		if (vm_vec_dist_quick(plrobj.pos, robot.pos) < ROBOT_RELEVANT_DISTANCE)
+			return true;
+	}
+	return false;
+}
+
 int multi_send_robot_frame(int sent)
 {
 	static int last_sent = 0;
@@ -390,9 +496,17 @@ int multi_send_robot_frame(int sent)
 		int sending = (last_sent+1+i)%MAX_ROBOTS_CONTROLLED;
 		if (robot_controlled[sending] != object_none && (robot_send_pending[sending] > sent || robot_fired[sending] > sent))
 		{
+			const auto &&robot_objp = vmobjptridx(robot_controlled[sending]);
+			// Keep an unforced update of a robot nobody is near for later.
+			if (robot_send_pending[sending] == 1 && !robot_fired[sending] &&
+				GameTime64 < robot_last_position_time[sending] + ROBOT_IRRELEVANT_SEND_INTERVAL &&
+				GameTime64 >= robot_last_position_time[sending] &&
+				!multi_robot_is_relevant(robot_objp))
+				continue;
 			if (robot_send_pending[sending])
 			{
-				multi_send_robot_position_sub(vmobjptridx(robot_controlled[sending]), (exchange(robot_send_pending[sending], 0) > 1));
+				robot_last_position_time[sending] = GameTime64;
+				multi_send_robot_position_sub(robot_objp, (exchange(robot_send_pending[sending], 0) > 1));
 			}
 
 			if (robot_fired[sending])
@@ -13,7 +13,11 @@
 #include <stdio.h>
 #include <string.h>
 #include <stdlib.h>
+#include <algorithm>
+#include <atomic>
 #include <random>
+#include <string>
+#include <SDL.h>
 
 #include "pstypes.h"
 #include "window.h"
@@ -60,6 +64,9 @@
 #include "config.h"
 #include "vers_id.h"
 #include "u_mem.h"
+#include "cmd.h"
+#include "physfsx.h"
+#include "multiinternal.h"
 
 #include "dxxsconf.h"
 #include "compiler-array.h"
@@ -68,6 +75,7 @@
 #include "compiler-range_for.h"
 #include "compiler-lengthof.h"
 #include "partial_range.h"
+#include "profile.h"
 
 #if defined(DXX_BUILD_DESCENT_I)
 #define UDP_REQ_ID "D1XR" // ID string for a request packet
@@ -109,6 +117,7 @@ static void net_udp_process_mdata (uint8_t *data, uint_fast32_t data_len, const
 static void net_udp_send_pdata();
 static void net_udp_process_pdata (const uint8_t *data, uint_fast32_t data_len, const _sockaddr &sender_addr);
 static void net_udp_read_pdata_packet(UDP_frame_info *pd);
+static void net_udp_interpolate_players(fix64 now);
 static void net_udp_timeout_check(fix64 time);
 static int net_udp_get_new_player_num ();
 static void net_udp_noloss_got_ack(const uint8_t *data, uint_fast32_t data_len);
@@ -127,15 +136,54 @@ static int net_udp_start_game(void);
 // Variables
 static int UDP_num_sendto, UDP_len_sendto, UDP_num_recvfrom, UDP_len_recvfrom;
 static UDP_mdata_info		UDP_MData;
+// Highest priority of the messages waiting in UDP_MData.  While playing,
+// urgent messages are not sent at once, but together with the others
+// from the same frame at the start of the next net_udp_do_frame, so a
+// firefight sends one datagram per frame instead of one per message.
+static uint8_t UDP_MData_priority;
 static UDP_sequence_packet UDP_Seq;
-static unsigned UDP_mdata_queue_highest;
+// UDP_mdata_queue is a ring: UDP_mdata_queue_highest entries, starting
+// at slot UDP_mdata_queue_first.
+static unsigned UDP_mdata_queue_first, UDP_mdata_queue_highest;
 static array<UDP_mdata_store, UDP_MDATA_STOR_QUEUE_SIZE> UDP_mdata_queue;
 static array<UDP_mdata_check, MAX_PLAYERS> UDP_mdata_trace;
 static UDP_sequence_packet UDP_sync_player; // For rejoin object syncing
+
+namespace {
+
+// With -udp_interp_delay, the last few positions received from each
+// player, with the time each arrived.
+struct udp_pdata_snapshot
+{
+	fix64 time;
+	quaternionpos qpp;
+};
+
+struct udp_pdata_history
+{
+	unsigned count, next;
+	array<udp_pdata_snapshot, 8> snapshots;
+	const udp_pdata_snapshot &newest(const unsigned age) const
+	{
+		return snapshots[(next + snapshots.size() - 1 - age) % snapshots.size()];
+	}
+};
+
+}
+
+static array<udp_pdata_history, MAX_PLAYERS> UDP_pdata_history;
 static array<UDP_netgame_info_lite, UDP_MAX_NETGAMES> Active_udp_games;
+/* Set from Active_udp_games_next_serial whenever the entry of
+ * Active_udp_games at the same index is written, so that the game
+ * browser only formats again the rows whose game changed.  0 is never
+ * used.
+ */
+static array<unsigned, UDP_MAX_NETGAMES> Active_udp_games_serial;
+static unsigned Active_udp_games_next_serial;
 static unsigned num_active_udp_games;
 static int num_active_udp_changed;
 static uint16_t UDP_MyPort;
+static bool UDP_autohost; // Starting a game for -udp_autohost, with no menus
 static sockaddr_in GBcast; // global Broadcast address clients and hosts will use for lite_info exchange over LAN
 #define UDP_BCAST_ADDR "255.255.255.255"
 #if DXX_USE_IPv6
@@ -161,6 +209,7 @@ static int udp_tracker_unregister();
 namespace dsx {
 static int udp_tracker_register();
 static int udp_tracker_reqgames();
+static void udp_tracker_poll_resolver();
 }
 static int udp_tracker_process_game( ubyte *data, int data_len, const _sockaddr &sender_addr );
 static void udp_tracker_process_ack( ubyte *data, int data_len, const _sockaddr &sender_addr );
@@ -363,6 +412,207 @@ static bool operator!=(const _sockaddr &l, const _sockaddr &r)
 	return !(l == r);
 }
 
+/* Network statistics - START */
+namespace {
+
+struct udp_type_stats
+{
+	uint32_t packets, bytes;
+	void add(const uint32_t len)
+	{
+		++packets;
+		bytes += len;
+	}
+};
+
+constexpr unsigned udp_rtt_bucket_count = 8;
+// Upper bounds, in milliseconds, of the round trip time histogram buckets
+// but the last.
+constexpr array<uint16_t, udp_rtt_bucket_count - 1> udp_rtt_bucket_limit{{25, 50, 100, 150, 200, 300, 500}};
+
+struct udp_peer_stats
+{
+	udp_type_stats sent, received;
+	// Packets queued to it with UPID_MDATA_PNEEDACK, how many of those
+	// were resent, and how many it ACK'd.
+	uint32_t queued, resent, acked;
+	uint32_t rtt_samples, rtt_total, rtt_max;
+	array<uint32_t, udp_rtt_bucket_count> rtt_histogram;
+};
+
+struct udp_stats
+{
+	fix64 start_time;
+	unsigned queue_depth_max;
+	array<udp_type_stats, 32> upid_sent, upid_received;
+	array<udp_type_stats, 256> multi_sent;
+	array<udp_peer_stats, MAX_PLAYERS> peer;
+};
+
+constexpr const char *multi_command_names[] = {
+#define define_multiplayer_command_name(NAME,SIZE)	#NAME,
+	for_each_multiplayer_command(define_multiplayer_command_name)
+#undef define_multiplayer_command_name
+};
+
+}
+
+static udp_stats UDP_stats;
+bool net_udp_stats_overlay;
+
+static udp_peer_stats *net_udp_stats_peer(const _sockaddr &addr)
+{
+	for (unsigned i = 0; i != MAX_PLAYERS; ++i)
+		if (Netgame.players[i].protocol.udp.addr == addr)
+			return &UDP_stats.peer[i];
+	return nullptr;
+}
+
+static void net_udp_stats_sent(const _sockaddr &to, const uint8_t *const buf, const uint32_t len)
+{
+	if (buf[0] < UDP_stats.upid_sent.size())
+		UDP_stats.upid_sent[buf[0]].add(len);
+	if (const auto p = net_udp_stats_peer(to))
+		p->sent.add(len);
+}
+
+static void net_udp_stats_received(const _sockaddr &from, const uint8_t *const buf, const uint32_t len)
+{
+	if (buf[0] < UDP_stats.upid_received.size())
+		UDP_stats.upid_received[buf[0]].add(len);
+	if (const auto p = net_udp_stats_peer(from))
+		p->received.add(len);
+}
+
+static void net_udp_stats_add_rtt(const unsigned pnum, const uint32_t ms)
+{
+	auto &p = UDP_stats.peer[pnum];
+	++p.rtt_samples;
+	p.rtt_total += ms;
+	if (p.rtt_max < ms)
+		p.rtt_max = ms;
+	const auto b = std::find_if(udp_rtt_bucket_limit.begin(), udp_rtt_bucket_limit.end(), [ms](const uint16_t limit) { return ms < limit; });
+	++p.rtt_histogram[std::distance(udp_rtt_bucket_limit.begin(), b)];
+}
+
+static void net_udp_stats_reset()
+{
+	UDP_stats = {};
+	UDP_stats.start_time = timer_query();
+}
+
+static unsigned net_udp_stats_resend_permille(const udp_peer_stats &p)
+{
+	return p.queued ? static_cast<unsigned>(uint64_t(p.resent) * 1000 / p.queued) : 0;
+}
+
+static void net_udp_stats_write(PHYSFS_File *const file)
+{
+	array<char, 256> line;
+	const auto print = [file, &line]() {
+		if (file)
+			PHYSFSX_printf(file, "%s\n", line.data());
+		else
+			con_puts(CON_NORMAL, line.data());
+	};
+	snprintf(line.data(), line.size(), "network statistics for %u seconds, MData store depth max %u of %u", static_cast<unsigned>(f2i(timer_query() - UDP_stats.start_time)), UDP_stats.queue_depth_max, UDP_MDATA_STOR_QUEUE_SIZE);
+	print();
+	snprintf(line.data(), line.size(), "%-8s %8s %10s %8s %10s %7s %7s %7s %6s %6s %6s  %s", "player", "sent", "bytes", "recv", "bytes", "queued", "resent", "acked", "pings", "avg", "max", "rtt histogram <25 <50 <100 <150 <200 <300 <500 more");
+	print();
+	for (unsigned i = 0; i != MAX_PLAYERS; ++i)
+	{
+		auto &p = UDP_stats.peer[i];
+		if (!p.sent.packets && !p.received.packets)
+			continue;
+		auto &h = p.rtt_histogram;
+		snprintf(line.data(), line.size(), "%-8s %8u %10u %8u %10u %7u %7u %7u %6u %6u %6u  %u %u %u %u %u %u %u %u", static_cast<const char *>(Netgame.players[i].callsign), p.sent.packets, p.sent.bytes, p.received.packets, p.received.bytes, p.queued, p.resent, p.acked, p.rtt_samples, p.rtt_samples ? p.rtt_total / p.rtt_samples : 0, p.rtt_max, h[0], h[1], h[2], h[3], h[4], h[5], h[6], h[7]);
+		print();
+	}
+	for (unsigned i = 0; i != UDP_stats.upid_sent.size(); ++i)
+	{
+		auto &s = UDP_stats.upid_sent[i];
+		auto &r = UDP_stats.upid_received[i];
+		if (!s.packets && !r.packets)
+			continue;
+		snprintf(line.data(), line.size(), "UPID %2u: sent %u packets %u bytes, received %u packets %u bytes", i, s.packets, s.bytes, r.packets, r.bytes);
+		print();
+	}
+	for (unsigned i = 0; i != UDP_stats.multi_sent.size(); ++i)
+	{
+		auto &s = UDP_stats.multi_sent[i];
+		if (!s.packets)
+			continue;
+		snprintf(line.data(), line.size(), "%s: sent %u messages %u bytes", i < lengthof(multi_command_names) ? multi_command_names[i] : "MULTI_?", s.packets, s.bytes);
+		print();
+	}
+}
+
+static void net_udp_stats_dump(const char *const filename)
+{
+	if (!filename)
+	{
+		net_udp_stats_write(nullptr);
+		return;
+	}
+	auto file = PHYSFSX_openWriteBuffered(filename);
+	if (!file)
+	{
+		con_printf(CON_URGENT, "DXX-Rebirth: failed to open network statistics file \"%s\": %s", filename, PHYSFS_getLastError());
+		return;
+	}
+	net_udp_stats_write(file);
+}
+
+void net_udp_show_stats(grs_canvas &canvas)
+{
+	auto &game_font = *GAME_FONT;
+	gr_set_fontcolor(canvas, BM_XRGB(0, 31, 0), -1);
+	const auto &&line_spacing = LINE_SPACING(*canvas.cv_font, game_font);
+	auto y = line_spacing * 18;
+	gr_printf(canvas, game_font, FSPACX(2), y, "MData store: %u (max %u)", UDP_mdata_queue_highest, UDP_stats.queue_depth_max);
+	for (unsigned i = 0; i != MAX_PLAYERS; ++i)
+	{
+		if (i == Player_num || vcplayerptr(i)->connected == CONNECT_DISCONNECTED)
+			continue;
+		auto &p = UDP_stats.peer[i];
+		y += line_spacing;
+		const auto resend = net_udp_stats_resend_permille(p);
+		gr_printf(canvas, game_font, FSPACX(2), y, "%s: out %uK in %uK rtt %u/%ums resent %u.%u%%", static_cast<const char *>(vcplayerptr(i)->callsign), p.sent.bytes / 1024, p.received.bytes / 1024, p.rtt_samples ? p.rtt_total / p.rtt_samples : 0, p.rtt_max, resend / 10, resend % 10);
+	}
+}
+
+static void net_udp_stats_cmd(unsigned long argc, const char *const *const argv)
+{
+	if (argc == 2 || argc == 3)
+	{
+		const auto a = argv[1];
+		if (!d_stricmp(a, "dump"))
+		{
+			net_udp_stats_dump(argc == 3 ? argv[2] : nullptr);
+			return;
+		}
+		if (argc == 2 && !d_stricmp(a, "show"))
+		{
+			net_udp_stats_overlay = !net_udp_stats_overlay;
+			return;
+		}
+		if (argc == 2 && !d_stricmp(a, "reset"))
+		{
+			net_udp_stats_reset();
+			return;
+		}
+	}
+	cmd_insertf("help %s", argv[0]);
+}
+
+void net_udp_stats_init()
+{
+	cmd_addcommand("netstat", net_udp_stats_cmd, "netstat dump [file]\n"  "    write traffic, round trip times and resends per player and per packet type to the console or <file>\n"
+	                                             "netstat show\n"         "    toggle the on-screen network statistics overlay\n"
+	                                             "netstat reset\n"        "    discard the statistics gathered so far");
+}
+/* Network statistics - END */
+
 template <std::size_t N>
 static void copy_from_ntstring(uint8_t *const buf, uint_fast32_t &len, const ntstring<N> &in)
 {
@@ -555,7 +805,10 @@ ssize_t dxx_sendto_t::apply(int sockfd, const void *msg, size_t len, int flags,
 
 	UDP_num_sendto++;
 	if (rv > 0)
+	{
 		UDP_len_sendto += rv;
+		net_udp_stats_sent(reinterpret_cast<const _sockaddr &>(to), reinterpret_cast<const uint8_t *>(msg), rv);
+	}
 
 	return rv;
 }
@@ -573,6 +826,69 @@ ssize_t dxx_recvfrom_t::apply(int sockfd, void *buf, size_t len, int flags, sock
 constexpr csockaddr_dispatch_t<socket_array_dispatch_t<dxx_sendto_t>> dxx_sendto{};
 constexpr sockaddr_dispatch_t<dxx_recvfrom_t> dxx_recvfrom{};
 
+/* Linux can send or receive several datagrams in one system call.
+ * MSG_WAITFORONE is only defined where recvmmsg is declared.
+ */
+#if defined(__linux__) && defined(MSG_WAITFORONE)
+#define DXX_UDP_USE_MMSG	1
+#else
+#define DXX_UDP_USE_MMSG	0
+#endif
+
+constexpr socklen_t udp_sockaddr_size =
+#if DXX_USE_IPv6
+	sizeof(sockaddr_in6);
+#else
+	sizeof(sockaddr_in);
+#endif
+
+// Send the same datagram to several peers, in one system call where
+// the platform allows it.
+class udp_fanout
+{
+	unsigned count = 0;
+	array<const _sockaddr *, MAX_PLAYERS> to;
+public:
+	void add(const _sockaddr &addr)
+	{
+		to[count++] = &addr;
+	}
+	void send(int sock, const uint8_t *buf, size_t len) const;
+};
+
+void udp_fanout::send(const int sock, const uint8_t *const buf, const size_t len) const
+{
+#if DXX_UDP_USE_MMSG
+	array<iovec, MAX_PLAYERS> iov;
+	array<mmsghdr, MAX_PLAYERS> msgs;
+	for (unsigned i = 0; i != count; ++i)
+	{
+		iov[i].iov_base = const_cast<uint8_t *>(buf);
+		iov[i].iov_len = len;
+		msgs[i] = {};
+		auto &h = msgs[i].msg_hdr;
+		h.msg_name = const_cast<sockaddr *>(&to[i]->sa);
+		h.msg_namelen = udp_sockaddr_size;
+		h.msg_iov = &iov[i];
+		h.msg_iovlen = 1;
+	}
+	for (unsigned sent = 0; sent < count;)
+	{
+		const int rv = sendmmsg(sock, &msgs[sent], count - sent, 0);
+		if (rv <= 0)
+			break;
+		for (int i = 0; i != rv; ++i)
+			net_udp_stats_sent(*to[sent + i], buf, len);
+		sent += rv;
+		UDP_num_sendto += rv;
+		UDP_len_sendto += rv * len;
+	}
+#else
+	for (unsigned i = 0; i != count; ++i)
+		dxx_sendto(*to[i], sock, buf, len, 0);
+#endif
+}
+
 }
 
 static void udp_traffic_stat()
@@ -595,8 +911,16 @@ public:
 	static int apply(sockaddr &addr, socklen_t addrlen, int ai_family, const char *host, uint16_t port, bool numeric_only, bool silent);
 };
 
-// Resolve address
-int udp_dns_filladdr_t::apply(sockaddr &addr, socklen_t addrlen, int ai_family, const char *host, uint16_t port, bool numeric_only, bool silent)
+enum class udp_dns_result : uint8_t
+{
+	ok,
+	not_found,
+	too_big,
+};
+
+// Resolve address without reporting errors, so that a worker thread can
+// use it.
+static udp_dns_result udp_dns_resolve(sockaddr &addr, socklen_t addrlen, int ai_family, const char *host, uint16_t port, bool numeric_only)
 {
 #ifdef DXX_HAVE_GETADDRINFO
 	// Variables
@@ -624,20 +948,14 @@ int udp_dns_filladdr_t::apply(sockaddr &addr, socklen_t addrlen, int ai_family,
 	RAIIaddrinfo result;
 	if (result.getaddrinfo(host, sPort, &hints) != 0)
 	{
-		con_printf( CON_URGENT, "udp_dns_filladdr (getaddrinfo) failed for host %s", host );
-		if (!silent)
-			nm_messagebox( TXT_ERROR, 1, TXT_OK, "Could not resolve address\n%s", host );
 		addr.sa_family = AF_UNSPEC;
-		return -1;
+		return udp_dns_result::not_found;
 	}
 	
 	if (result->ai_addrlen > addrlen)
 	{
-		con_printf(CON_URGENT, "Address too big for host %s", host);
-		if (!silent)
-			nm_messagebox(TXT_ERROR, 1, TXT_OK, "Address too big for host\n%s", host);
 		addr.sa_family = AF_UNSPEC;
-		return -1;
+		return udp_dns_result::too_big;
 	}
 	// Now copy it over
 	memcpy(&addr, result->ai_addr, addrlen = result->ai_addrlen);
@@ -659,24 +977,144 @@ int udp_dns_filladdr_t::apply(sockaddr &addr, socklen_t addrlen, int ai_family,
 	(void)numeric_only;
 	sockaddr_in &sai = reinterpret_cast<sockaddr_in &>(addr);
 	if (addrlen < sizeof(sai))
-		return -1;
+		return udp_dns_result::too_big;
 	const auto he = gethostbyname(host);
 	if (!he)
 	{
-		con_printf(CON_URGENT, "udp_dns_filladdr (gethostbyname) failed for host %s", host);
-		if (!silent)
-			nm_messagebox(TXT_ERROR, 1, TXT_OK, "Could not resolve IPv4 address\n%s", host);
 		addr.sa_family = AF_UNSPEC;
-		return -1;
+		return udp_dns_result::not_found;
 	}
 	sai = {};
 	sai.sin_family = ai_family;
 	sai.sin_port = htons(port);
 	sai.sin_addr = *reinterpret_cast<const in_addr *>(he->h_addr);
 #endif
+	return udp_dns_result::ok;
+}
+
+static int udp_dns_report(const udp_dns_result r, const char *const host, const bool silent)
+{
+	switch (r)
+	{
+		case udp_dns_result::ok:
+			return 0;
+		case udp_dns_result::not_found:
+			con_printf(CON_URGENT, "udp_dns_filladdr failed for host %s", host);
+			if (!silent)
+				nm_messagebox(TXT_ERROR, 1, TXT_OK, "Could not resolve address\n%s", host);
+			break;
+		case udp_dns_result::too_big:
+			con_printf(CON_URGENT, "Address too big for host %s", host);
+			if (!silent)
+				nm_messagebox(TXT_ERROR, 1, TXT_OK, "Address too big for host\n%s", host);
+			break;
+	}
+	return -1;
+}
+
+// Resolve address
+int udp_dns_filladdr_t::apply(sockaddr &addr, socklen_t addrlen, int ai_family, const char *host, uint16_t port, bool numeric_only, bool silent)
+{
+	return udp_dns_report(udp_dns_resolve(addr, addrlen, ai_family, host, port, numeric_only), host, silent);
+}
+
+/* Resolve a host name on a worker thread, so that a slow name server
+ * cannot stall the menus or the game.  Start a lookup with start(),
+ * then call poll() from the menu or game loop until it stops returning
+ * pending.  A lookup that is abandoned keeps running; the next start()
+ * waits for it.
+ */
+class udp_dns_async
+{
+	SDL_Thread *thread = nullptr;
+	std::atomic<bool> finished{false};
+	std::string host;
+	uint16_t port;
+	udp_dns_result result;
+	_sockaddr addr;
+	bool active = false;
+	static int run(void *);
+	void resolve()
+	{
+		result = udp_dns_resolve(addr.sa, udp_sockaddr_size,
+#if DXX_USE_IPv6
+			AF_INET6,
+#else
+			AF_INET,
+#endif
+			host.c_str(), port, false);
+	}
+public:
+	enum class state : uint8_t
+	{
+		idle,
+		pending,
+		done,
+		failed,
+	};
+	void start(const char *host, uint16_t port);
+	void cancel()
+	{
+		active = false;
+	}
+	/* Returns done or failed once for every start().  On done, to holds
+	 * the address.  On failed, the error has been reported.
+	 */
+	state poll(_sockaddr &to, bool silent);
+};
+
+int udp_dns_async::run(void *const data)
+{
+	const auto self = reinterpret_cast<udp_dns_async *>(data);
+	self->resolve();
+	self->finished.store(true, std::memory_order_release);
 	return 0;
 }
 
+void udp_dns_async::start(const char *const h, const uint16_t p)
+{
+	if (thread)
+		SDL_WaitThread(thread, nullptr);
+	thread = nullptr;
+	host = h;
+	port = p;
+	active = true;
+	finished.store(false, std::memory_order_relaxed);
+#ifdef DXX_HAVE_GETADDRINFO
+#if SDL_MAJOR_VERSION == 2
+	thread = SDL_CreateThread(run, "udp_dns", this);
+#else
+	thread = SDL_CreateThread(run, this);
+#endif
+#endif
+	/* gethostbyname is not thread safe, and a thread may not start.
+	 * Either way, resolve here.
+	 */
+	if (!thread)
+	{
+		resolve();
+		finished.store(true, std::memory_order_relaxed);
+	}
+}
+
+udp_dns_async::state udp_dns_async::poll(_sockaddr &to, const bool silent)
+{
+	if (!active)
+		return state::idle;
+	if (!finished.load(std::memory_order_acquire))
+		return state::pending;
+	if (thread)
+	{
+		SDL_WaitThread(thread, nullptr);
+		thread = nullptr;
+	}
+	active = false;
+	if (udp_dns_report(result, host.c_str(), silent) < 0)
+		return state::failed;
+	to = addr;
+	return state::done;
+}
+
 template <typename F>
 class sockaddr_resolve_family_dispatch_t : sockaddr_dispatch_t<F>
 {
@@ -843,15 +1281,36 @@ struct manual_join : direct_join, manual_join_user_inputs
 {
 	static manual_join_user_inputs s_last_inputs;
 	array<newmenu_item, 7> m;
+	bool resolving;
 };
 
+static udp_dns_async manual_join_resolver;
+
 struct list_join : direct_join
 {
 	enum {
 		entries = ((UDP_NETGAMES_PPAGE + 5) * 2) + 1,
 	};
+	enum class sort_order : uint8_t
+	{
+		received,
+		players,
+		name,
+	};
 	array<newmenu_item, entries> m;
 	array<array<char, 92>, entries> ljtext;
+	array<char, 48> view_text;
+	/* Indices into Active_udp_games of the games listed, after sorting
+	 * and filtering.  Rebuilt only when the games change.
+	 */
+	array<uint16_t, UDP_MAX_NETGAMES> view;
+	unsigned n_view;
+	/* Serial of the game formatted into each row of the page, 0 for an
+	 * empty row, or UINT_MAX if the row must be formatted again.
+	 */
+	array<unsigned, UDP_NETGAMES_PPAGE> row_serial;
+	sort_order order;
+	bool hide_full;
 };
 
 manual_join_user_inputs manual_join::s_last_inputs;
@@ -939,15 +1398,44 @@ static int manual_join_game_handler(newmenu *const menu, const d_event &event, m
 	switch (event.type)
 	{
 		case EVENT_KEY_COMMAND:
-			if (dj->connecting && event_key_get(event) == KEY_ESC)
+			if ((dj->connecting || dj->resolving) && event_key_get(event) == KEY_ESC)
 			{
 				dj->connecting = 0;
+				dj->resolving = false;
+				manual_join_resolver.cancel();
 				nm_set_item_text(items[6], "");
 				return 1;
 			}
 			break;
 			
 		case EVENT_IDLE:
+			if (dj->resolving)
+			{
+				switch (manual_join_resolver.poll(dj->host_addr, false))
+				{
+					case udp_dns_async::state::idle:
+					case udp_dns_async::state::pending:
+						break;
+					case udp_dns_async::state::failed:
+						dj->resolving = false;
+						nm_set_item_text(items[6], "");
+						break;
+					case udp_dns_async::state::done:
+						dj->resolving = false;
+						dj->s_last_inputs = *dj;
+						multi_new_game();
+						N_players = 0;
+						change_playernum_to(1);
+						dj->start_time = timer_query();
+						dj->last_time = 0;
+
+						Netgame.players[0].protocol.udp.addr = dj->host_addr;
+
+						dj->connecting = 1;
+						nm_set_item_text(items[6], "Connecting...");
+						break;
+				}
+			}
 			if (dj->connecting)
 			{
 				if (net_udp_game_connect(dj))
@@ -972,31 +1460,15 @@ static int manual_join_game_handler(newmenu *const menu, const d_event &event, m
 			uint16_t hostport;
 			if (!convert_text_portstring(dj->hostportbuf, hostport, true, false))
 				return 1;
-			// Resolve address
-			if (udp_dns_filladdr(dj->host_addr, &dj->addrbuf[0], hostport, false, false) < 0)
-			{
-				return 1;
-			}
-			else
-			{
-				dj->s_last_inputs = *dj;
-				multi_new_game();
-				N_players = 0;
-				change_playernum_to(1);
-				dj->start_time = timer_query();
-				dj->last_time = 0;
-				
-				Netgame.players[0].protocol.udp.addr = dj->host_addr;
-				
-				dj->connecting = 1;
-				nm_set_item_text(items[6], "Connecting...");
-				return 1;
-			}
-
-			break;
+			// Resolve address.  EVENT_IDLE connects once that is done.
+			manual_join_resolver.start(&dj->addrbuf[0], hostport);
+			dj->resolving = true;
+			nm_set_item_text(items[6], "Resolving...");
+			return 1;
 		}
 			
 		case EVENT_WINDOW_CLOSE:
+			manual_join_resolver.cancel();
 			if (!Game_wind) // they cancelled
 				net_udp_close();
 			std::default_delete<manual_join>()(dj);
@@ -1075,6 +1547,93 @@ static void copy_truncate_string(const grs_font &cv_font, const font_x_scaled_fl
 	out[k] = 0;
 }
 
+static void net_udp_clear_active_games()
+{
+	Active_udp_games = {};
+	num_active_udp_changed = 1;
+	num_active_udp_games = 0;
+}
+
+static void net_udp_list_join_build_view(list_join &dj)
+{
+	unsigned n = 0;
+	for (unsigned i = 0; i != num_active_udp_games; ++i)
+	{
+		auto &g = Active_udp_games[i];
+		if (dj.hide_full && g.numconnected >= g.max_numplayers)
+			continue;
+		dj.view[n++] = i;
+	}
+	dj.n_view = n;
+	const auto b = dj.view.begin(), e = std::next(b, n);
+	if (dj.order == list_join::sort_order::players)
+		std::stable_sort(b, e, [](const uint16_t l, const uint16_t r) {
+			return Active_udp_games[l].numconnected > Active_udp_games[r].numconnected;
+		});
+	else if (dj.order == list_join::sort_order::name)
+		std::stable_sort(b, e, [](const uint16_t l, const uint16_t r) {
+			return d_stricmp(Active_udp_games[l].game_name.data(), Active_udp_games[r].game_name.data()) < 0;
+		});
+}
+
+static void net_udp_list_join_set_view_text(list_join &dj)
+{
+	const char *const order = (dj.order == list_join::sort_order::players)
+		? "players"
+		: (dj.order == list_join::sort_order::name) ? "name" : "arrival";
+	auto &t = dj.view_text;
+	snprintf(t.data(), t.size(), "\tSorted by %s%s", order, dj.hide_full ? ", full games hidden" : "");
+}
+
+static void net_udp_list_join_format_row(array<char, 92> &p, const unsigned number, const UDP_netgame_info_lite &augi)
+{
+	int game_status = augi.game_status;
+	int nplayers = 0;
+	char levelname[8];
+
+	// These next two loops protect against menu skewing
+	// if missiontitle or gamename contain a tab
+
+	const auto &&fspacx = FSPACX();
+	const auto &cv_font = *grd_curcanv->cv_font;
+	array<char, 25> MissName, GameName;
+	const auto &&fspacx55 = fspacx(55);
+	copy_truncate_string(cv_font, fspacx55, MissName, augi.mission_title);
+	copy_truncate_string(cv_font, fspacx55, GameName, augi.game_name);
+
+	nplayers = augi.numconnected;
+
+	const int levelnum = augi.levelnum;
+	if (levelnum < 0)
+	{
+		cf_assert(-levelnum < MAX_SECRET_LEVELS_PER_MISSION);
+		snprintf(levelname, sizeof(levelname), "S%d", -levelnum);
+	}
+	else
+	{
+		cf_assert(levelnum < MAX_LEVELS_PER_MISSION);
+		snprintf(levelname, sizeof(levelname), "%d", levelnum);
+	}
+
+	const char *status;
+	if (game_status == NETSTAT_STARTING)
+		status = "FORMING ";
+	else if (game_status == NETSTAT_PLAYING)
+	{
+		if (augi.RefusePlayers)
+			status = "RESTRICT";
+		else if (augi.game_flag.closed)
+			status = "CLOSED  ";
+		else
+			status = "OPEN    ";
+	}
+	else
+		status = "BETWEEN ";
+	
+	unsigned gamemode = augi.gamemode;
+	snprintf(&p[0], p.size(), "%u.\t%.24s \t%.7s \t%3u/%u \t%.24s \t %s \t%s", number, GameName.data(), (gamemode < sizeof(GMNamesShrt) / sizeof(GMNamesShrt[0])) ? GMNamesShrt[gamemode] : "INVALID", nplayers, augi.max_numplayers, MissName.data(), levelname, status);
+}
+
 static int net_udp_list_join_poll(newmenu *menu, const d_event &event, list_join *const dj)
 {
 	// Polling loop for Join Game menu
@@ -1086,9 +1645,7 @@ static int net_udp_list_join_poll(newmenu *menu, const d_event &event, list_join
 		case EVENT_WINDOW_ACTIVATED:
 		{
 			Netgame.protocol.udp.valid = 0;
-			Active_udp_games = {};
-			num_active_udp_changed = 1;
-			num_active_udp_games = 0;
+			net_udp_clear_active_games();
 			net_udp_request_game_info(GBcast, 1);
 #if DXX_USE_IPv6
 			net_udp_request_game_info(GMcast_v6, 1);
@@ -1112,12 +1669,14 @@ static int net_udp_list_join_poll(newmenu *menu, const d_event &event, list_join
 		case EVENT_KEY_COMMAND:
 		{
 			int key = event_key_get(event);
+			/* Flip only through the pages which list a game. */
+			const int pages = std::max(1u, (dj->n_view + UDP_NETGAMES_PPAGE - 1) / UDP_NETGAMES_PPAGE);
 			if (key == KEY_PAGEUP)
 			{
 				NLPage--;
 				newpage++;
 				if (NLPage < 0)
-					NLPage = UDP_NETGAMES_PAGES-1;
+					NLPage = pages - 1;
 				key = 0;
 				break;
 			}
@@ -1125,17 +1684,31 @@ static int net_udp_list_join_poll(newmenu *menu, const d_event &event, list_join
 			{
 				NLPage++;
 				newpage++;
-				if (NLPage >= UDP_NETGAMES_PAGES)
+				if (NLPage >= pages)
 					NLPage = 0;
 				key = 0;
 				break;
 			}
+			if (key == KEY_F7)
+			{
+				dj->order = (dj->order == list_join::sort_order::received)
+					? list_join::sort_order::players
+					: (dj->order == list_join::sort_order::players) ? list_join::sort_order::name : list_join::sort_order::received;
+				net_udp_list_join_set_view_text(*dj);
+				num_active_udp_changed = 1;
+				break;
+			}
+			if (key == KEY_F8)
+			{
+				dj->hide_full = !dj->hide_full;
+				net_udp_list_join_set_view_text(*dj);
+				num_active_udp_changed = 1;
+				break;
+			}
 			if( key == KEY_F4 )
 			{
 				// Empty the list
-				Active_udp_games = {};
-				num_active_udp_changed = 1;
-				num_active_udp_games = 0;
+				net_udp_clear_active_games();
 				
 				// Request LAN games
 				net_udp_request_game_info(GBcast, 1);
@@ -1151,9 +1724,7 @@ static int net_udp_list_join_poll(newmenu *menu, const d_event &event, list_join
 #if DXX_USE_TRACKER
 			if (key == KEY_F5)
 			{
-				Active_udp_games = {};
-				num_active_udp_changed = 1;
-				num_active_udp_games = 0;
+				net_udp_clear_active_games();
 				net_udp_request_game_info(GBcast, 1);
 
 #if DXX_USE_IPv6
@@ -1165,9 +1736,7 @@ static int net_udp_list_join_poll(newmenu *menu, const d_event &event, list_join
 			if( key == KEY_F6 )
 			{
 				// Zero the list
-				Active_udp_games = {};
-				num_active_udp_changed = 1;
-				num_active_udp_games = 0;
+				net_udp_clear_active_games();
 				
 				// Request from the tracker
 				udp_tracker_reqgames();
@@ -1191,18 +1760,22 @@ static int net_udp_list_join_poll(newmenu *menu, const d_event &event, list_join
 		case EVENT_NEWMENU_SELECTED:
 		{
 			auto &citem = static_cast<const d_select_event &>(event).citem;
-			if (((citem+(NLPage*UDP_NETGAMES_PPAGE)) >= 4) && (((citem+(NLPage*UDP_NETGAMES_PPAGE))-3) <= num_active_udp_games))
+			const unsigned row = citem - 4;
+			const unsigned position = row + (NLPage * UDP_NETGAMES_PPAGE);
+			/* A game may have been removed since the view was built. */
+			if (citem >= 4 && row < UDP_NETGAMES_PPAGE && position < dj->n_view && dj->view[position] < num_active_udp_games)
 			{
+				auto &game = Active_udp_games[dj->view[position]];
 				multi_new_game();
 				N_players = 0;
 				change_playernum_to(1);
 				dj->start_time = timer_query();
 				dj->last_time = 0;
-				dj->host_addr = Active_udp_games[(citem+(NLPage*UDP_NETGAMES_PPAGE))-4].game_addr;
+				dj->host_addr = game.game_addr;
 				Netgame.players[0].protocol.udp.addr = dj->host_addr;
 				dj->connecting = 1;
 #if DXX_USE_TRACKER
-				dj->gameid = Active_udp_games[(citem+(NLPage*UDP_NETGAMES_PPAGE))-4].TrackerGameID;
+				dj->gameid = game.TrackerGameID;
 #endif
 				nm_set_item_text(menus[UDP_NETGAMES_PPAGE+4], "\tConnecting. Please wait...");
 				return 1;
@@ -1230,68 +1803,38 @@ static int net_udp_list_join_poll(newmenu *menu, const d_event &event, list_join
 
 	net_udp_listen();
 
-	if (!num_active_udp_changed && !newpage)
-		return 0;
-
-	num_active_udp_changed = 0;
-
-	// Copy the active games data into the menu options
-	for (int i = 0; i < UDP_NETGAMES_PPAGE; i++)
+	if (num_active_udp_changed)
 	{
-		const auto &augi = Active_udp_games[(i + (NLPage * UDP_NETGAMES_PPAGE))];
-		int game_status = augi.game_status;
-		int nplayers = 0;
-		char levelname[8];
-
-		if ((i+(NLPage*UDP_NETGAMES_PPAGE)) >= num_active_udp_games)
+		num_active_udp_changed = 0;
+		net_udp_list_join_build_view(*dj);
+		/* Filtering may have removed the page shown. */
+		if (NLPage * UDP_NETGAMES_PPAGE >= dj->n_view && NLPage)
 		{
-			auto &p = dj->ljtext[i];
-			snprintf(&p[0], p.size(), "%d.                                                                      ", (i + (NLPage * UDP_NETGAMES_PPAGE)) + 1);
-			continue;
-		}
-
-		// These next two loops protect against menu skewing
-		// if missiontitle or gamename contain a tab
-
-		const auto &&fspacx = FSPACX();
-		const auto &cv_font = *grd_curcanv->cv_font;
-		array<char, 25> MissName, GameName;
-		const auto &&fspacx55 = fspacx(55);
-		copy_truncate_string(cv_font, fspacx55, MissName, augi.mission_title);
-		copy_truncate_string(cv_font, fspacx55, GameName, augi.game_name);
-
-		nplayers = augi.numconnected;
-
-		const int levelnum = augi.levelnum;
-		if (levelnum < 0)
-		{
-			cf_assert(-levelnum < MAX_SECRET_LEVELS_PER_MISSION);
-			snprintf(levelname, sizeof(levelname), "S%d", -levelnum);
-		}
-		else
-		{
-			cf_assert(levelnum < MAX_LEVELS_PER_MISSION);
-			snprintf(levelname, sizeof(levelname), "%d", levelnum);
+			NLPage = dj->n_view ? (dj->n_view - 1) / UDP_NETGAMES_PPAGE : 0;
+			newpage++;
 		}
+	}
+	else if (!newpage)
+		return 0;
+	if (newpage)
+		dj->row_serial.fill(UINT_MAX);
 
-		const char *status;
-		if (game_status == NETSTAT_STARTING)
-			status = "FORMING ";
-		else if (game_status == NETSTAT_PLAYING)
+	// Copy the active games data into the menu options, formatting only
+	// the rows which show a different game or new data for it
+	for (unsigned i = 0; i < UDP_NETGAMES_PPAGE; i++)
+	{
+		const unsigned position = i + (NLPage * UDP_NETGAMES_PPAGE);
+		const unsigned serial = (position < dj->n_view) ? Active_udp_games_serial[dj->view[position]] : 0;
+		if (dj->row_serial[i] == serial)
+			continue;
+		dj->row_serial[i] = serial;
+		auto &p = dj->ljtext[i];
+		if (!serial)
 		{
-			if (augi.RefusePlayers)
-				status = "RESTRICT";
-			else if (augi.game_flag.closed)
-				status = "CLOSED  ";
-			else
-				status = "OPEN    ";
+			snprintf(&p[0], p.size(), "%u.                                                                      ", position + 1);
+			continue;
 		}
-		else
-			status = "BETWEEN ";
-		
-		unsigned gamemode = augi.gamemode;
-		auto &p = dj->ljtext[i];
-		snprintf(&p[0], p.size(), "%d.\t%.24s \t%.7s \t%3u/%u \t%.24s \t %s \t%s", (i + (NLPage * UDP_NETGAMES_PPAGE)) + 1, GameName.data(), (gamemode < sizeof(GMNamesShrt) / sizeof(GMNamesShrt[0])) ? GMNamesShrt[gamemode] : "INVALID", nplayers, augi.max_numplayers, MissName.data(), levelname, status);
+		net_udp_list_join_format_row(p, position + 1, Active_udp_games[dj->view[position]]);
 	}
 	return 0;
 }
@@ -1335,8 +1878,9 @@ void net_udp_list_join_game()
 #else
 	nm_set_item_text(m[0], "\tF4: (Re)Scan for LAN Games." );
 #endif
-	nm_set_item_text(m[1], "\tPgUp/PgDn: Flip Pages." );
-	nm_set_item_text(m[2], " " );
+	nm_set_item_text(m[1], "\tPgUp/PgDn: Flip Pages.  F7: Sort.  F8: Hide Full Games." );
+	net_udp_list_join_set_view_text(*dj);
+	nm_set_item_text(m[2], dj->view_text.data());
 	nm_set_item_text(m[3],  "\tGAME \tMODE \t#PLYRS \tMISSION \tLEV \tSTATUS");
 
 	for (int i = 0; i < UDP_NETGAMES_PPAGE; i++) {
@@ -1345,6 +1889,7 @@ void net_udp_list_join_game()
 		snprintf(&p[0], p.size(), "%d.                                                                      ", i + 1);
 	}
 	nm_set_item_text(m[UDP_NETGAMES_PPAGE+4], "\t" );
+	dj->row_serial.fill(UINT_MAX);
 
 	num_active_udp_changed = 1;
 	newmenu_dotiny("NETGAMES", nullptr, UDP_NETGAMES_PPAGE + 5, &m[0], 1, net_udp_list_join_poll, dj.release());
@@ -1394,7 +1939,10 @@ void net_udp_init()
 	Netgame = {};
 	UDP_Seq = {};
 	UDP_MData = {};
+	UDP_MData_priority = 0;
 	net_udp_noloss_init_mdata_queue();
+	UDP_pdata_history = {};
+	net_udp_stats_reset();
 	UDP_Seq.type = UPID_REQUEST;
 	UDP_Seq.player.callsign = get_local_player().callsign;
 
@@ -1759,7 +2307,8 @@ int net_udp_objnum_is_past(objnum_t objnum)
 	// to a re-joining player.
 	
 	int player_num = UDP_sync_player.player.connected;
-	int obj_mode = !((object_owner[objnum] == -1) || (object_owner[objnum] == player_num));
+	const auto owner = multi_object_owner(objnum);
+	int obj_mode = !((owner == -1) || (owner == player_num));
 
 	if (!Network_send_objects)
 		return 0; // We're not sending objects to a new player
@@ -1932,17 +2481,66 @@ static void net_udp_stop_resync(UDP_sequence_packet *their)
 	}
 }
 
+/* Objects are sent with each run of zero bytes replaced by a zero and
+ * the length of the run, since most fields of most objects are zero.
+ * This never more than doubles the size.
+ */
+static unsigned net_udp_pack_zero_runs(uint8_t *const dst, const uint8_t *const src, const unsigned len)
+{
+	unsigned out = 0;
+	for (unsigned i = 0; i < len;)
+	{
+		if (src[i])
+		{
+			dst[out++] = src[i++];
+			continue;
+		}
+		unsigned run = 1;
+		while (i + run < len && run < UINT8_MAX && !src[i + run])
+			++run;
+		dst[out++] = 0;
+		dst[out++] = run;
+		i += run;
+	}
+	return out;
+}
+
+/* Returns how many bytes of src were used, or 0 if src is too short or
+ * does not unpack to exactly len bytes.
+ */
+static unsigned net_udp_unpack_zero_runs(uint8_t *const dst, const unsigned len, const uint8_t *const src, const unsigned srclen)
+{
+	unsigned in = 0;
+	for (unsigned i = 0; i < len;)
+	{
+		if (in >= srclen)
+			return 0;
+		const uint8_t b = src[in++];
+		if (b)
+		{
+			dst[i++] = b;
+			continue;
+		}
+		if (in >= srclen)
+			return 0;
+		const unsigned run = src[in++];
+		if (!run || run > len - i)
+			return 0;
+		std::fill_n(&dst[i], run, 0);
+		i += run;
+	}
+	return in;
+}
+
 namespace dsx {
-void net_udp_send_objects(void)
+// Object packets sent to a joining player per pacing interval
+#define UDP_OBJECT_PACKETS_PER_SEND	4
+
+static void net_udp_send_objects_packet()
 {
 	sbyte owner, player_num = UDP_sync_player.player.connected;
 	static int obj_count = 0;
 	int loc = 0, remote_objnum = 0, obj_count_frame = 0;
-	static fix64 last_send_time = 0;
-	
-	if (last_send_time + (F1_0/50) > timer_query())
-		return;
-	last_send_time = timer_query();
 
 	// Send clear objects array trigger and send player num
 
@@ -1987,28 +2585,33 @@ void net_udp_send_objects(void)
 #endif
 				)
 			continue;
-		if ((Network_send_object_mode == 0) && ((object_owner[i] != -1) && (object_owner[i] != player_num)))
+		const auto object_owner = multi_object_owner(i);
+		if ((Network_send_object_mode == 0) && ((object_owner != -1) && (object_owner != player_num)))
 			continue;
-		if ((Network_send_object_mode == 1) && ((object_owner[i] == -1) || (object_owner[i] == player_num)))
+		if ((Network_send_object_mode == 1) && ((object_owner == -1) || (object_owner == player_num)))
 			continue;
 
-		if ( loc + sizeof(object_rw) + 9 > UPID_MAX_SIZE-1 )
+		// use object_rw to send objects for now. if object sometime contains some day contains something useful the client should know about, we should use it. but by now it's also easier to use object_rw because then we also do not need fix64 timer values.
+		object_rw objrw{};
+		multi_object_to_object_rw(objp, &objrw);
+		if (words_bigendian)
+			object_rw_swap(&objrw, 1);
+		array<uint8_t, sizeof(object_rw) * 2> packed;
+		const auto packed_len = net_udp_pack_zero_runs(packed.data(), reinterpret_cast<const uint8_t *>(&objrw), sizeof(objrw));
+		if (loc + packed_len + 9 > UPID_MAX_SIZE-1)
 			break; // Not enough room for another object
 
 		obj_count_frame++;
 		obj_count++;
 
 		remote_objnum = objnum_local_to_remote(i, &owner);
-		Assert(owner == object_owner[i]);
+		Assert(owner == object_owner);
 
 		PUT_INTEL_INT(&object_buffer[loc], i);                        loc += 4;
 		object_buffer[loc] = owner;                                 loc += 1;
 		PUT_INTEL_INT(&object_buffer[loc], remote_objnum);            loc += 4;
-		// use object_rw to send objects for now. if object sometime contains some day contains something useful the client should know about, we should use it. but by now it's also easier to use object_rw because then we also do not need fix64 timer values.
-		multi_object_to_object_rw(vmobjptr(i), reinterpret_cast<object_rw *>(&object_buffer[loc]));
-		if (words_bigendian)
-			object_rw_swap(reinterpret_cast<object_rw *>(&object_buffer[loc]), 1);
-		loc += sizeof(object_rw);
+		memcpy(&object_buffer[loc], packed.data(), packed_len);
+		loc += packed_len;
 	}
 
 	if (obj_count_frame) // Send any objects we've buffered
@@ -2059,6 +2662,18 @@ void net_udp_send_objects(void)
 		} // mode == 1;
 	} // i > Highest_object_index
 }
+
+void net_udp_send_objects(void)
+{
+	static fix64 last_send_time = 0;
+	
+	if (last_send_time + (F1_0/50) > timer_query())
+		return;
+	last_send_time = timer_query();
+
+	for (unsigned n = 0; n != UDP_OBJECT_PACKETS_PER_SEND && Network_send_objects; ++n)
+		net_udp_send_objects_packet();
+}
 }
 
 static int net_udp_verify_objects(int remote, int local)
@@ -2080,17 +2695,22 @@ static int net_udp_verify_objects(int remote, int local)
 	return(1);
 }
 
-static void net_udp_read_object_packet( ubyte *data )
+static void net_udp_read_object_packet(const uint8_t *const data, const unsigned data_len)
 {
 	// Object from another net player we need to sync with
 	sbyte obj_owner;
 	static int mode = 0, object_count = 0, my_pnum = 0;
-	int remote_objnum = 0, nobj = 0, loc = 5;
+	int remote_objnum = 0, nobj = 0;
+	unsigned loc = 5;
 	
+	if (data_len < loc)
+		return;
 	nobj = GET_INTEL_INT(data + 1);
 
 	for (int i = 0; i < nobj; i++)
 	{
+		if (data_len < loc + 9)
+			return;
 		objnum_t objnum = GET_INTEL_INT(data + loc);                         loc += 4;
 		obj_owner = data[loc];                                      loc += 1;
 		remote_objnum = GET_INTEL_INT(data + loc);                  loc += 4;
@@ -2126,6 +2746,11 @@ static void net_udp_read_object_packet( ubyte *data )
 		}
 		else 
 		{
+			object_rw objrw;
+			const auto used = net_udp_unpack_zero_runs(reinterpret_cast<uint8_t *>(&objrw), sizeof(objrw), &data[loc], data_len - loc);
+			if (!used)
+				return;
+			loc += used;
 			object_count++;
 			if ((obj_owner == my_pnum) || (obj_owner == -1)) 
 			{
@@ -2150,9 +2775,8 @@ static void net_udp_read_object_packet( ubyte *data )
 				}
 				Assert(objnum < MAX_OBJECTS);
 				if (words_bigendian)
-					object_rw_swap(reinterpret_cast<object_rw *>(&data[loc]), 1);
-				multi_object_rw_to_object(reinterpret_cast<object_rw *>(&data[loc]), obj);
-				loc += sizeof(object_rw);
+					object_rw_swap(&objrw, 1);
+				multi_object_rw_to_object(&objrw, obj);
 				auto segnum = obj->segnum;
 				obj->attached_obj = object_none;
 				if (segnum != segment_none)
@@ -2164,7 +2788,7 @@ static void net_udp_read_object_packet( ubyte *data )
 				else if (obj_owner != -1)
 					map_objnum_local_to_remote(objnum, remote_objnum, obj_owner);
 				else
-					object_owner[objnum] = -1;
+					multi_clear_object_owner(objnum);
 			}
 		} // For a standard onbject
 	} // For each object in packet
@@ -2530,7 +3154,78 @@ static uint_fast32_t net_udp_prepare_light_game_info(game_info_light &info)
 	return len;
 }
 
-static uint_fast32_t net_udp_prepare_heavy_game_info(const _sockaddr *addr, ubyte info_upid, game_info_heavy &info)
+/* The heavy game info stores its counters as unsigned LEB128: 7 bits
+ * in each byte, low bits first, with the high bit set in every byte but
+ * the last.  Signed counters are zigzag encoded first.
+ */
+static void net_udp_put_varint(uint8_t *const buf, uint_fast32_t &len, uint32_t v)
+{
+	for (; v >= 0x80; v >>= 7)
+		buf[len++] = static_cast<uint8_t>(v | 0x80);
+	buf[len++] = static_cast<uint8_t>(v);
+}
+
+static void net_udp_put_signed_varint(uint8_t *const buf, uint_fast32_t &len, const int32_t v)
+{
+	net_udp_put_varint(buf, len, (static_cast<uint32_t>(v) << 1) ^ static_cast<uint32_t>(v >> 31));
+}
+
+/* Reads past end return 0, so a truncated packet cannot run the reader
+ * off the end of the buffer.
+ */
+static uint32_t net_udp_get_varint(const uint8_t *const data, uint_fast32_t &len, const uint_fast32_t end)
+{
+	uint32_t v = 0;
+	for (unsigned shift = 0; shift < 35 && len < end; shift += 7)
+	{
+		const uint8_t b = data[len++];
+		v |= static_cast<uint32_t>(b & 0x7f) << shift;
+		if (!(b & 0x80))
+			break;
+	}
+	return v;
+}
+
+static int32_t net_udp_get_signed_varint(const uint8_t *const data, uint_fast32_t &len, const uint_fast32_t end)
+{
+	const uint32_t v = net_udp_get_varint(data, len, end);
+	return static_cast<int32_t>(v >> 1) ^ -static_cast<int32_t>(v & 1);
+}
+
+/* A player slot is left out of the heavy game info when it has no
+ * callsign, is not connected and has no score, so that the receiver
+ * restores it by zeroing it.
+ */
+static bool net_udp_game_info_slot_used(const unsigned i)
+{
+	auto &p = Netgame.players[i];
+	if (p.callsign[0] || p.connected || p.rank || Netgame.killed[i] || Netgame.player_kills[i] || Netgame.player_score[i])
+		return true;
+	for (unsigned j = 0; j != MAX_PLAYERS; ++j)
+		if (Netgame.kills[i][j] || Netgame.kills[j][i])
+			return true;
+	return false;
+}
+
+/* Where net_udp_prepare_heavy_game_info puts your_index */
+constexpr std::size_t game_info_heavy_your_index = 7;
+
+static uint8_t net_udp_find_your_index(const _sockaddr *const addr)
+{
+	uint8_t your_index = MULTI_PNUM_UNDEF;
+	if (addr)
+		for (unsigned i = 0; i < Netgame.players.size(); ++i)
+			if (*addr == Netgame.players[i].protocol.udp.addr)
+				your_index = i;
+	return your_index;
+}
+
+/* Since protocol 12, the heavy game info sends only the player slots in
+ * use, as given by a mask after your_index, and sends its kill and
+ * score counters as varints.  your_index is left undefined, for
+ * net_udp_game_info_packet to fill in for each recipient.
+ */
+static uint_fast32_t net_udp_prepare_heavy_game_info(ubyte info_upid, game_info_heavy &info)
 {
 	uint8_t *const buf = info.buf.data();
 	uint_fast32_t len = 0;
@@ -2539,15 +3234,20 @@ static uint_fast32_t net_udp_prepare_heavy_game_info(const _sockaddr *addr, ubyt
 		PUT_INTEL_SHORT(buf + len, DXX_VERSION_MAJORi); 						len += 2;
 		PUT_INTEL_SHORT(buf + len, DXX_VERSION_MINORi); 						len += 2;
 		PUT_INTEL_SHORT(buf + len, DXX_VERSION_MICROi); 						len += 2;
-		ubyte &your_index = buf[len++];
-		your_index = MULTI_PNUM_UNDEF;
-		for (int i = 0; i < Netgame.players.size(); i++)
+		buf[len++] = MULTI_PNUM_UNDEF;
+		static_assert(MAX_PLAYERS <= 8, "slot mask must fit in one byte");
+		uint8_t slots = 0;
+		for (unsigned i = 0; i < Netgame.players.size(); i++)
+			if (net_udp_game_info_slot_used(i))
+				slots |= 1 << i;
+		buf[len++] = slots;
+		for (unsigned i = 0; i < Netgame.players.size(); i++)
 		{
+			if (!(slots & (1 << i)))
+				continue;
 			memcpy(&buf[len], Netgame.players[i].callsign.buffer(), CALLSIGN_LEN+1); 	len += CALLSIGN_LEN+1;
 			buf[len] = Netgame.players[i].connected;				len++;
 			buf[len] = Netgame.players[i].rank;					len++;
-			if (addr && *addr == Netgame.players[i].protocol.udp.addr)
-				your_index = i;
 		}
 		PUT_INTEL_INT(buf + len, Netgame.levelnum);					len += 4;
 		buf[len] = Netgame.gamemode;							len++;
@@ -2593,36 +3293,31 @@ static uint_fast32_t net_udp_prepare_heavy_game_info(const _sockaddr *addr, ubyt
 			len += CALLSIGN_LEN + 1;
 		}
 		range_for (auto &i, Netgame.locations)
-		{
-			PUT_INTEL_INT(buf + len, i);				len += 4;
-		}
-		range_for (auto &i, Netgame.kills)
-		{
-			range_for (auto &j, i)
+			net_udp_put_varint(buf, len, i);
+		for (unsigned i = 0; i != MAX_PLAYERS; ++i)
+			if (slots & (1 << i))
+				for (unsigned j = 0; j != MAX_PLAYERS; ++j)
+					if (slots & (1 << j))
+						net_udp_put_varint(buf, len, Netgame.kills[i][j]);
+		PUT_INTEL_SHORT(buf + len, Netgame.segments_checksum);			len += 2;
+		PUT_INTEL_INT(buf + len, static_cast<uint32_t>(Netgame.level_hash));			len += 4;
+		PUT_INTEL_INT(buf + len, static_cast<uint32_t>(Netgame.level_hash >> 32));			len += 4;
+		net_udp_put_signed_varint(buf, len, Netgame.team_kills[0]);
+		net_udp_put_signed_varint(buf, len, Netgame.team_kills[1]);
+		for (unsigned i = 0; i != MAX_PLAYERS; ++i)
+			if (slots & (1 << i))
 			{
-				PUT_INTEL_SHORT(buf + len, j);		len += 2;
+				net_udp_put_varint(buf, len, Netgame.killed[i]);
+				net_udp_put_varint(buf, len, Netgame.player_kills[i]);
 			}
-		}
-		PUT_INTEL_SHORT(buf + len, Netgame.segments_checksum);			len += 2;
-		PUT_INTEL_SHORT(buf + len, Netgame.team_kills[0]);				len += 2;
-		PUT_INTEL_SHORT(buf + len, Netgame.team_kills[1]);				len += 2;
-		range_for (auto &i, Netgame.killed)
-		{
-			PUT_INTEL_SHORT(buf + len, i);				len += 2;
-		}
-		range_for (auto &i, Netgame.player_kills)
-		{
-			PUT_INTEL_SHORT(buf + len, i);			len += 2;
-		}
 		PUT_INTEL_INT(buf + len, Netgame.KillGoal);					len += 4;
 		PUT_INTEL_INT(buf + len, Netgame.PlayTimeAllowed);				len += 4;
 		PUT_INTEL_INT(buf + len, Netgame.level_time);					len += 4;
 		PUT_INTEL_INT(buf + len, Netgame.control_invul_time);				len += 4;
 		PUT_INTEL_INT(buf + len, Netgame.monitor_vector);				len += 4;
-		range_for (auto &i, Netgame.player_score)
-		{
-			PUT_INTEL_INT(buf + len, i);			len += 4;
-		}
+		for (unsigned i = 0; i != MAX_PLAYERS; ++i)
+			if (slots & (1 << i))
+				net_udp_put_varint(buf, len, Netgame.player_score[i]);
 		range_for (auto &i, Netgame.net_player_flags)
 		{
 			buf[len] = static_cast<uint8_t>(i.get_player_flags());
@@ -2638,27 +3333,48 @@ static uint_fast32_t net_udp_prepare_heavy_game_info(const _sockaddr *addr, ubyt
 	return len;
 }
 
-void net_udp_send_game_info_t::apply(const sockaddr &sender_addr, socklen_t senderlen, const _sockaddr *player_address, ubyte info_upid)
+/* Game info built once and sent to any number of recipients, who
+ * differ only in the your_index of the heavy info.
+ */
+class net_udp_game_info_packet
 {
-	// Send game info to someone who requested it
-	net_udp_update_netgame(); // Update the values in the netgame struct
 	union {
 		game_info_light light;
 		game_info_heavy heavy;
 	};
+	const bool lite;
 	std::size_t len;
-	const uint8_t *info;
-	if (info_upid == UPID_GAME_INFO_LITE)
+public:
+	net_udp_game_info_packet(const ubyte info_upid) :
+		lite(info_upid == UPID_GAME_INFO_LITE)
 	{
-		len = net_udp_prepare_light_game_info(light);
-		info = light.buf.data();
+		net_udp_update_netgame(); // Update the values in the netgame struct
+		len = lite
+			? net_udp_prepare_light_game_info(light)
+			: net_udp_prepare_heavy_game_info(info_upid, heavy);
 	}
-	else
+	void send(const sockaddr &to, const socklen_t tolen, const _sockaddr *const player_address)
+	{
+		const uint8_t *info;
+		if (lite)
+			info = light.buf.data();
+		else
+		{
+			heavy.buf[game_info_heavy_your_index] = net_udp_find_your_index(player_address);
+			info = heavy.buf.data();
+		}
+		dxx_sendto(to, tolen, UDP_Socket[0], info, len, 0);
+	}
+	void send(const _sockaddr &to, const _sockaddr *const player_address)
 	{
-		len = net_udp_prepare_heavy_game_info(player_address, info_upid, heavy);
-		info = heavy.buf.data();
+		send(reinterpret_cast<const sockaddr &>(to), sizeof(to), player_address);
 	}
-	dxx_sendto(sender_addr, senderlen, UDP_Socket[0], info, len, 0);
+};
+
+void net_udp_send_game_info_t::apply(const sockaddr &sender_addr, socklen_t senderlen, const _sockaddr *player_address, ubyte info_upid)
+{
+	// Send game info to someone who requested it
+	net_udp_game_info_packet(info_upid).send(sender_addr, senderlen, player_address);
 }
 
 }
@@ -2670,21 +3386,26 @@ static unsigned MouselookMPFlag(const unsigned game_mode)
 
 static void net_udp_broadcast_game_info(ubyte info_upid)
 {
-	net_udp_send_game_info(GBcast, nullptr, info_upid);
+	net_udp_game_info_packet packet(info_upid);
+	packet.send(reinterpret_cast<const sockaddr &>(GBcast), sizeof(GBcast), nullptr);
 #if DXX_USE_IPv6
-	net_udp_send_game_info(GMcast_v6, nullptr, info_upid);
+	packet.send(reinterpret_cast<const sockaddr &>(GMcast_v6), sizeof(GMcast_v6), nullptr);
 #endif
 }
 
 /* Send game info to all players in this game. Also send lite_info for people watching the netlist */
 void net_udp_send_netgame_update()
 {
+	/* Built on first use, since there may be no one to send it to. */
+	std::unique_ptr<net_udp_game_info_packet> packet;
 	for (unsigned i = 1; i < N_players; ++i)
 	{
 		if (vcplayerptr(i)->connected == CONNECT_DISCONNECTED)
 			continue;
+		if (!packet)
+			packet = make_unique<net_udp_game_info_packet>(UPID_GAME_INFO);
 		const auto &addr = Netgame.players[i].protocol.udp.addr;
-		net_udp_send_game_info(addr, &addr, UPID_GAME_INFO);
+		packet->send(addr, &addr);
 	}
 	net_udp_broadcast_game_info(UPID_GAME_INFO_LITE);
 }
@@ -2709,7 +3430,7 @@ static unsigned net_udp_send_request(void)
 }
 
 namespace dsx {
-static void net_udp_process_game_info(const uint8_t *data, uint_fast32_t, const _sockaddr &game_addr, int lite_info, uint16_t TrackerGameID)
+static void net_udp_process_game_info(const uint8_t *data, uint_fast32_t data_len, const _sockaddr &game_addr, int lite_info, uint16_t TrackerGameID)
 {
 	uint_fast32_t len = 0;
 	if (lite_info)
@@ -2751,6 +3472,9 @@ static void net_udp_process_game_info(const uint8_t *data, uint_fast32_t, const
 		}
 		
 		*i = std::move(recv_game);
+		if (!++Active_udp_games_next_serial)
+			++Active_udp_games_next_serial;
+		Active_udp_games_serial[std::distance(Active_udp_games.begin(), i)] = Active_udp_games_next_serial;
 #if defined(DXX_BUILD_DESCENT_II)
 		// See if this is really a Hoard game
 		// If so, adjust all the data accordingly
@@ -2779,6 +3503,8 @@ static void net_udp_process_game_info(const uint8_t *data, uint_fast32_t, const
 		{
 			// Delete this game
 			std::move(std::next(i), r.end(), i);
+			const auto s = std::next(Active_udp_games_serial.begin(), std::distance(Active_udp_games.begin(), i));
+			std::move(std::next(s), std::next(Active_udp_games_serial.begin(), num_active_udp_games), s);
 			num_active_udp_games--;
 		}
 	}
@@ -2791,8 +3517,17 @@ static void net_udp_process_game_info(const uint8_t *data, uint_fast32_t, const
 		Netgame.protocol.udp.program_iver[1] = GET_INTEL_SHORT(&(data[len]));		len += 2;
 		Netgame.protocol.udp.program_iver[2] = GET_INTEL_SHORT(&(data[len]));		len += 2;
 		Netgame.protocol.udp.your_index = data[len]; ++len;
-		range_for (auto &i, Netgame.players)
+		const uint8_t slots = data[len++];
+		for (unsigned n = 0; n != Netgame.players.size(); ++n)
 		{
+			auto &i = Netgame.players[n];
+			if (!(slots & (1 << n)))
+			{
+				i.callsign.fill(0);
+				i.connected = 0;
+				i.rank = 0;
+				continue;
+			}
 			i.callsign.copy_lower(reinterpret_cast<const char *>(&data[len]), CALLSIGN_LEN);
 			len += CALLSIGN_LEN+1;
 			i.connected = data[len];				len++;
@@ -2836,36 +3571,27 @@ static void net_udp_process_game_info(const uint8_t *data, uint_fast32_t, const
 			len += CALLSIGN_LEN + 1;
 		}
 		range_for (auto &i, Netgame.locations)
-		{
-			i = GET_INTEL_INT(&(data[len]));			len += 4;
-		}
-		range_for (auto &i, Netgame.kills)
-		{
-			range_for (auto &j, i)
-			{
-				j = GET_INTEL_SHORT(&(data[len]));		len += 2;
-			}
-		}
+			i = net_udp_get_varint(data, len, data_len);
+		for (unsigned i = 0; i != MAX_PLAYERS; ++i)
+			for (unsigned j = 0; j != MAX_PLAYERS; ++j)
+				Netgame.kills[i][j] = ((slots & (1 << i)) && (slots & (1 << j))) ? net_udp_get_varint(data, len, data_len) : 0;
 		Netgame.segments_checksum = GET_INTEL_SHORT(&(data[len]));			len += 2;
-		Netgame.team_kills[0] = GET_INTEL_SHORT(&(data[len]));				len += 2;	
-		Netgame.team_kills[1] = GET_INTEL_SHORT(&(data[len]));				len += 2;
-		range_for (auto &i, Netgame.killed)
+		Netgame.level_hash = GET_INTEL_INT(&(data[len])) | (static_cast<uint64_t>(GET_INTEL_INT(&(data[len + 4]))) << 32);			len += 8;
+		Netgame.team_kills[0] = net_udp_get_signed_varint(data, len, data_len);
+		Netgame.team_kills[1] = net_udp_get_signed_varint(data, len, data_len);
+		for (unsigned i = 0; i != MAX_PLAYERS; ++i)
 		{
-			i = GET_INTEL_SHORT(&(data[len]));			len += 2;
-		}
-		range_for (auto &i, Netgame.player_kills)
-		{
-			i = GET_INTEL_SHORT(&(data[len]));		len += 2;
+			const bool used = slots & (1 << i);
+			Netgame.killed[i] = used ? net_udp_get_varint(data, len, data_len) : 0;
+			Netgame.player_kills[i] = used ? net_udp_get_varint(data, len, data_len) : 0;
 		}
 		Netgame.KillGoal = GET_INTEL_INT(&(data[len]));					len += 4;
 		Netgame.PlayTimeAllowed = GET_INTEL_INT(&(data[len]));				len += 4;
 		Netgame.level_time = GET_INTEL_INT(&(data[len]));				len += 4;
 		Netgame.control_invul_time = GET_INTEL_INT(&(data[len]));			len += 4;
 		Netgame.monitor_vector = GET_INTEL_INT(&(data[len]));				len += 4;
-		range_for (auto &i, Netgame.player_score)
-		{
-			i = GET_INTEL_INT(&(data[len]));			len += 4;
-		}
+		for (unsigned i = 0; i != MAX_PLAYERS; ++i)
+			Netgame.player_score[i] = (slots & (1 << i)) ? net_udp_get_varint(data, len, data_len) : 0;
 		range_for (auto &i, Netgame.net_player_flags)
 		{
 			i = player_flags(data[len]);
@@ -2932,6 +3658,8 @@ static void net_udp_process_packet(ubyte *data, const _sockaddr &sender_addr, in
 {
 	UDP_sequence_packet their{};
 
+	net_udp_stats_received(sender_addr, data, length);
+
 	switch (data[0])
 	{
 		case UPID_VERSION_DENY:
@@ -3029,7 +3757,7 @@ static void net_udp_process_packet(ubyte *data, const _sockaddr &sender_addr, in
 		case UPID_OBJECT_DATA:
 			if (multi_i_am_master() || length > UPID_MAX_SIZE || Network_status != NETSTAT_WAITING)
 				break;
-			net_udp_read_object_packet(data);
+			net_udp_read_object_packet(data, length);
 			break;
 		case UPID_PING:
 			if (multi_i_am_master() || length != UPID_PING_SIZE)
@@ -3861,13 +4589,10 @@ static int net_udp_game_param_handler( newmenu *menu,const d_event &event, param
 }
 
 namespace dsx {
-window_event_result net_udp_setup_game()
+//set Netgame up for a new game hosted by this player, from the defaults
+//and the saved netgame profile
+static void net_udp_init_netgame()
 {
-	int optnum;
-	param_opt opt;
-	auto &m = opt.m;
-	char level_text[32];
-
 	net_udp_init();
 
 	multi_new_game();
@@ -3918,6 +4643,27 @@ window_event_result net_udp_setup_game()
 	Netgame.mission_title = Current_mission_longname;
 
 	Netgame.levelnum = 1;
+}
+
+#if DXX_USE_TRACKER
+static void net_udp_check_tracker_enabled()
+{
+	/* Force off _after_ writing profile, so that command line does not
+	 * change ngp file.
+	 */
+	if (CGameArg.MplTrackerAddr.empty())
+		Netgame.Tracker = 0;
+}
+#endif
+
+window_event_result net_udp_setup_game()
+{
+	int optnum;
+	param_opt opt;
+	auto &m = opt.m;
+	char level_text[32];
+
+	net_udp_init_netgame();
 
 	optnum = 0;
 	opt.start_game=optnum;
@@ -4009,15 +4755,36 @@ window_event_result net_udp_setup_game()
 
 	write_netgame_profile(&Netgame);
 #if DXX_USE_TRACKER
-	/* Force off _after_ writing profile, so that command line does not
-	 * change ngp file.
-	 */
-	if (CGameArg.MplTrackerAddr.empty())
-		Netgame.Tracker = 0;
+	net_udp_check_tracker_enabled();
 #endif
 
 	return (i >= 0) ? window_event_result::close : window_event_result::handled;
 }
+
+void net_udp_autohost(const char *const mission)
+{
+	if (const auto errstr = load_mission_by_name(mission))
+	{
+		con_printf(CON_URGENT, "Cannot host mission \"%s\": %s", mission, errstr);
+		return;
+	}
+	net_udp_init_netgame();
+	/* Nobody is at the host to approve players, so everyone joins the
+	 * game in progress.
+	 */
+	Netgame.game_flag.closed = 0;
+	Netgame.RefusePlayers = 0;
+#if DXX_USE_TRACKER
+	net_udp_check_tracker_enabled();
+#endif
+	UDP_autohost = true;
+	if (!net_udp_start_game())
+	{
+		con_printf(CON_URGENT, "Cannot host mission \"%s\"", mission);
+		net_udp_close();
+	}
+	UDP_autohost = false;
+}
 }
 
 namespace dsx {
@@ -4070,11 +4837,17 @@ void net_udp_read_sync_packet(const uint8_t * data, uint_fast32_t data_len, cons
 	Difficulty_level = Netgame.difficulty;
 	Network_status = Netgame.game_status;
 
-	if (Netgame.segments_checksum != my_segments_checksum)
+	if (Netgame.segments_checksum != my_segments_checksum || Netgame.level_hash != Gamesave_current_hash)
 	{
 		Network_status = NETSTAT_MENU;
 		net_udp_close();
-		nm_messagebox(TXT_ERROR, 1, TXT_OK, TXT_NETLEVEL_NMATCH);
+		/* Equal segment checksums with different files are a different
+		 * version of the same mission.
+		 */
+		if (Netgame.segments_checksum == my_segments_checksum)
+			nm_messagebox(TXT_ERROR, 1, TXT_OK, "%s\n\nThe host has a different\nversion of %s.", TXT_NETLEVEL_NMATCH, Netgame.mission_title.data());
+		else
+			nm_messagebox(TXT_ERROR, 1, TXT_OK, TXT_NETLEVEL_NMATCH);
 		throw multi::level_checksum_mismatch();
 	}
 
@@ -4206,6 +4979,7 @@ static int net_udp_send_sync(void)
 	net_udp_update_netgame();
 	Netgame.game_status = NETSTAT_PLAYING;
 	Netgame.segments_checksum = my_segments_checksum;
+	Netgame.level_hash = Gamesave_current_hash;
 
 	for (unsigned i = 0; i < N_players; ++i)
 	{
@@ -4349,7 +5123,10 @@ static int net_udp_select_players()
 #endif
 
 GetPlayersAgain:
-	j = newmenu_do1(nullptr, title, spd.m.size(), spd.m.data(), net_udp_start_poll, &spd, 1);
+	/* An automatic host starts alone, as if the host pressed Enter at
+	 * once.
+	 */
+	j = UDP_autohost ? 1 : newmenu_do1(nullptr, title, spd.m.size(), spd.m.data(), net_udp_start_poll, &spd, 1);
 
 	save_nplayers = N_players;
 
@@ -4445,7 +5222,7 @@ abort:
 	    Netgame.gamemode == NETGAME_CAPTURE_FLAG ||
 		 Netgame.gamemode == NETGAME_TEAM_HOARD)
 #endif
-		 if (!net_udp_select_teams())
+		 if (!UDP_autohost && !net_udp_select_teams())
 			goto abort;
 	return(1);
 }
@@ -4602,7 +5379,9 @@ window_event_result net_udp_level_sync()
 	int result = 0;
 
 	UDP_MData = {};
+	UDP_MData_priority = 0;
 	net_udp_noloss_init_mdata_queue();
+	UDP_pdata_history = {};
 
 	net_udp_flush(); // Flush any old packets
 
@@ -4728,6 +5507,9 @@ void net_udp_leave_game()
 	write_player_file();
 #endif
 
+	if (!CGameArg.MplUdpStatsFile.empty())
+		net_udp_stats_dump(CGameArg.MplUdpStatsFile.c_str());
+
 	net_udp_flush();
 	net_udp_close();
 }
@@ -4756,6 +5538,47 @@ static void net_udp_listen(RAIIsocket &sock)
 {
 	if (!sock)
 		return;
+#if DXX_UDP_USE_MMSG
+	/* The buffers are on the stack, so a packet handler which listens
+	 * again cannot overwrite packets that are not processed yet.
+	 */
+	constexpr unsigned batch = 16;
+	array<array<uint8_t, UPID_MAX_SIZE>, batch> packets;
+	array<_sockaddr, batch> senders;
+	array<iovec, batch> iov;
+	array<mmsghdr, batch> msgs;
+	for (;;)
+	{
+		for (unsigned i = 0; i != batch; ++i)
+		{
+			iov[i].iov_base = packets[i].data();
+			iov[i].iov_len = packets[i].size();
+			msgs[i] = {};
+			auto &h = msgs[i].msg_hdr;
+			h.msg_name = &senders[i].sa;
+			h.msg_namelen = sizeof(senders[i]);
+			h.msg_iov = &iov[i];
+			h.msg_iovlen = 1;
+		}
+		const int n = recvmmsg(sock, msgs.data(), batch, MSG_DONTWAIT, nullptr);
+		if (n <= 0)
+			return;
+		UDP_num_recvfrom += n;
+		for (int i = 0; i != n; ++i)
+		{
+			const unsigned size = msgs[i].msg_len;
+			UDP_len_recvfrom += size;
+			if (!size)
+				continue;
+			auto &packet = packets[i];
+			if (size < packet.size())
+				packet[size] = 0;
+			net_udp_process_packet(packet.data(), senders[i], size);
+		}
+		if (n < static_cast<int>(batch))
+			return;
+	}
+#else
 	struct _sockaddr sender_addr;
 	std::array<uint8_t, UPID_MAX_SIZE> packet;
 	for (;;)
@@ -4765,10 +5588,15 @@ static void net_udp_listen(RAIIsocket &sock)
 			break;
 		net_udp_process_packet(packet.data(), sender_addr, size);
 	}
+#endif
 }
 
 void net_udp_listen()
 {
+	DXX_TRACE_ZONE("net_udp_listen");
+#if DXX_USE_TRACKER
+	udp_tracker_poll_resolver();
+#endif
 	range_for (auto &s, UDP_Socket)
 		net_udp_listen(s);
 }
@@ -4780,9 +5608,11 @@ void net_udp_send_data(const uint8_t *const ptr, const unsigned len, const int p
 #endif
 	char check;
 
+	UDP_stats.multi_sent[ptr[0]].add(len);
 	if ((UDP_MData.mbuf_size+len) > UPID_MDATA_BUF_SIZE )
 	{
 		check = ptr[0];
+		// Sent with an ACK if any waiting message needs one
 		net_udp_send_mdata(0, timer_query());
 		if (UDP_MData.mbuf_size != 0)
 			Int3();
@@ -4796,7 +5626,12 @@ void net_udp_send_data(const uint8_t *const ptr, const unsigned len, const int p
 	UDP_MData.mbuf_size += len;
 
 	if (priority)
-		net_udp_send_mdata((priority==2)?1:0, timer_query());
+	{
+		if (Network_status == NETSTAT_PLAYING)
+			UDP_MData_priority = std::max(UDP_MData_priority, static_cast<uint8_t>(priority));
+		else
+			net_udp_send_mdata((priority==2)?1:0, timer_query());
+	}
 }
 
 void net_udp_timeout_check(fix64 time)
@@ -4826,6 +5661,7 @@ void net_udp_timeout_check(fix64 time)
 namespace dsx {
 void net_udp_do_frame(int force, int listen)
 {
+	DXX_TRACE_ZONE("net_udp_do_frame");
 	static fix64 last_pdata_time = 0, last_mdata_time = 16, last_endlevel_time = 32, last_bcast_time = 48, last_resync_time = 64;
 
 	if (!(Game_mode&GM_NETWORK) || !UDP_Socket[0])
@@ -4833,6 +5669,10 @@ void net_udp_do_frame(int force, int listen)
 
 	const fix64 time = timer_update();
 
+	// Send the urgent messages of the previous frame together
+	if (UDP_MData_priority)
+		net_udp_send_mdata(0, time);
+
 	if (WaitForRefuseAnswer && time>(RefuseTimeLimit+(F1_0*12)))
 		WaitForRefuseAnswer=0;
 
@@ -4893,12 +5733,41 @@ void net_udp_do_frame(int force, int listen)
 			net_udp_send_extras();
 	}
 
+	if (CGameArg.MplUdpInterpDelay && Network_status == NETSTAT_PLAYING)
+		net_udp_interpolate_players(time);
+
 	udp_traffic_stat();
 }
 }
 
 /* CODE FOR PACKET LOSS PREVENTION - START */
 /* This code tries to make sure that packets with opcode UPID_MDATA_PNEEDACK aren't lost and sent and received in order. */
+
+/* The i-th oldest packet in the store */
+static UDP_mdata_store &net_udp_noloss_queue_entry(const unsigned i)
+{
+	return UDP_mdata_queue[(UDP_mdata_queue_first + i) % UDP_MDATA_STOR_QUEUE_SIZE];
+}
+
+/* Remove the oldest packet from the store */
+static void net_udp_noloss_pop_queue()
+{
+	UDP_mdata_queue[UDP_mdata_queue_first] = {};
+	UDP_mdata_queue_first = (UDP_mdata_queue_first + 1) % UDP_MDATA_STOR_QUEUE_SIZE;
+	UDP_mdata_queue_highest--;
+}
+
+/* How many packets after from the packet to is, allowing for the roll over of pkt_num */
+static uint32_t net_udp_noloss_distance(const uint32_t from, const uint32_t to)
+{
+	return (to + UDP_MDATA_PKT_NUM_MAX - from) % UDP_MDATA_PKT_NUM_MAX;
+}
+
+static uint32_t net_udp_noloss_next_pkt_num(const uint32_t pkt_num)
+{
+	return pkt_num >= UDP_MDATA_PKT_NUM_MAX ? UDP_MDATA_PKT_NUM_MIN : pkt_num + 1;
+}
+
 /*
  * Adds a packet to our queue. Should be called when an IMPORTANT mdata packet is created.
  * player_ack is an array which should contain 0 for each player that needs to send an ACK signal.
@@ -4917,11 +5786,9 @@ static void net_udp_noloss_add_queue_pkt(fix64 time, const ubyte *data, ushort d
 		if (multi_i_am_master()) // I am host. I will kick everyone who did not ACK the first packet and then remove it.
 		{
 			for ( int i=1; i<N_players; i++ )
-				if (UDP_mdata_queue[0].player_ack[i] == 0)
+				if (net_udp_noloss_queue_entry(0).player_ack[i] == 0)
 					net_udp_dump_player(Netgame.players[i].protocol.udp.addr, DUMP_PKTTIMEOUT);
-			std::move(std::next(UDP_mdata_queue.begin()), UDP_mdata_queue.end(), UDP_mdata_queue.begin());
-			UDP_mdata_queue[UDP_MDATA_STOR_QUEUE_SIZE - 1] = {};
-			UDP_mdata_queue_highest--;
+			net_udp_noloss_pop_queue();
 		}
 		else // I am just a client. I gotta go.
 		{
@@ -4938,24 +5805,38 @@ static void net_udp_noloss_add_queue_pkt(fix64 time, const ubyte *data, ushort d
 	}
 
 	con_printf(CON_VERBOSE, "P#%u: Adding MData pkt_num [%i,%i,%i,%i,%i,%i,%i,%i], type %i from P#%i to MData store list", Player_num, UDP_mdata_trace[0].pkt_num_tosend,UDP_mdata_trace[1].pkt_num_tosend,UDP_mdata_trace[2].pkt_num_tosend,UDP_mdata_trace[3].pkt_num_tosend,UDP_mdata_trace[4].pkt_num_tosend,UDP_mdata_trace[5].pkt_num_tosend,UDP_mdata_trace[6].pkt_num_tosend,UDP_mdata_trace[7].pkt_num_tosend, data[0], pnum);
-	UDP_mdata_queue[UDP_mdata_queue_highest].used = 1;
-	UDP_mdata_queue[UDP_mdata_queue_highest].pkt_initial_timestamp = time;
+	const uint16_t slot = (UDP_mdata_queue_first + UDP_mdata_queue_highest) % UDP_MDATA_STOR_QUEUE_SIZE;
+	auto &entry = UDP_mdata_queue[slot];
+	entry.used = 1;
+	entry.pkt_initial_timestamp = time;
 	for (unsigned i = 0; i < MAX_PLAYERS; ++i)
 	{
 		if (i == Player_num || player_ack[i] || vcplayerptr(i)->connected == CONNECT_DISCONNECTED) // if player me, is not playing or does not require an ACK, do not add timestamp or increment pkt_num
 			continue;
 		
-		UDP_mdata_queue[UDP_mdata_queue_highest].pkt_timestamp[i] = time;
-		UDP_mdata_queue[UDP_mdata_queue_highest].pkt_num[i] = UDP_mdata_trace[i].pkt_num_tosend;
-		UDP_mdata_trace[i].pkt_num_tosend++;
-		if (UDP_mdata_trace[i].pkt_num_tosend > UDP_MDATA_PKT_NUM_MAX)
-			UDP_mdata_trace[i].pkt_num_tosend = UDP_MDATA_PKT_NUM_MIN;
-	}
-	UDP_mdata_queue[UDP_mdata_queue_highest].Player_num = pnum;
-	memcpy( &UDP_mdata_queue[UDP_mdata_queue_highest].player_ack, player_ack, sizeof(ubyte)*MAX_PLAYERS); 
-	memcpy( &UDP_mdata_queue[UDP_mdata_queue_highest].data, data, sizeof(char)*data_size );
-	UDP_mdata_queue[UDP_mdata_queue_highest].data_size = data_size;
+		auto &trace = UDP_mdata_trace[i];
+		entry.pkt_timestamp[i] = time;
+		entry.pkt_num[i] = trace.pkt_num_tosend;
+		++UDP_stats.peer[i].queued;
+		trace.queue_slot[trace.pkt_num_tosend % UDP_MDATA_STOR_QUEUE_SIZE] = slot;
+		trace.pkt_num_tosend = net_udp_noloss_next_pkt_num(trace.pkt_num_tosend);
+	}
+	entry.Player_num = pnum;
+	memcpy( &entry.player_ack, player_ack, sizeof(ubyte)*MAX_PLAYERS); 
+	memcpy( &entry.data, data, sizeof(char)*data_size );
+	entry.data_size = data_size;
 	UDP_mdata_queue_highest++;
+	if (UDP_stats.queue_depth_max < UDP_mdata_queue_highest)
+		UDP_stats.queue_depth_max = UDP_mdata_queue_highest;
+
+	// I am host. Do not let a single player with a bad connection use up the store for everyone.
+	if (multi_i_am_master())
+		for (playernum_t i = 1; i < N_players; i++)
+			if (net_udp_noloss_distance(UDP_mdata_trace[i].pkt_num_unacked, UDP_mdata_trace[i].pkt_num_tosend) > UDP_MDATA_PEER_MAX_PENDING)
+			{
+				con_printf(CON_VERBOSE, "P#%u: pnum %i has too many MData packets without ACK", Player_num, i);
+				net_udp_dump_player(Netgame.players[i].protocol.udp.addr, DUMP_PKTTIMEOUT);
+			}
 }
 
 /*
@@ -4984,16 +5865,16 @@ static int net_udp_noloss_validate_mdata(uint32_t pkt_num, ubyte sender_pnum, co
 	PUT_INTEL_INT(&buf[len], pkt_num);										len += 4;
 
         // Make sure this is the packet we are expecting!
-        if (UDP_mdata_trace[sender_pnum].pkt_num_torecv != pkt_num)
+	auto &trace = UDP_mdata_trace[sender_pnum];
+        if (trace.pkt_num_torecv != pkt_num)
         {
-                range_for (auto &i, partial_const_range(UDP_mdata_trace[sender_pnum].pkt_num, static_cast<uint32_t>(UDP_MDATA_STOR_QUEUE_SIZE)))
+		// Packets arrive in order, so the ones just before pkt_num_torecv are those we got already.
+		const auto behind = net_udp_noloss_distance(pkt_num, trace.pkt_num_torecv);
+		if (behind && behind <= trace.recv_count) // We got this packet already - need to REsend ACK
                 {
-                        if (pkt_num == i) // We got this packet already - need to REsend ACK
-                        {
-                                con_printf(CON_VERBOSE, "P#%u: Resending MData ACK for pkt %i we already got by pnum %i",Player_num, pkt_num, sender_pnum);
-                                dxx_sendto(sender_addr, UDP_Socket[0], buf, 0);
-                                return 0;
-                        }
+                        con_printf(CON_VERBOSE, "P#%u: Resending MData ACK for pkt %i we already got by pnum %i",Player_num, pkt_num, sender_pnum);
+                        dxx_sendto(sender_addr, UDP_Socket[0], buf, 0);
+                        return 0;
                 }
                 con_printf(CON_VERBOSE, "P#%u: Rejecting MData pkt %i - expected %i by pnum %i",Player_num, pkt_num, UDP_mdata_trace[sender_pnum].pkt_num_torecv, sender_pnum);
                 return 0; // Not the right packet and we haven't gotten it, yet either. So bail out and wait for the right one.
@@ -5002,17 +5883,17 @@ static int net_udp_noloss_validate_mdata(uint32_t pkt_num, ubyte sender_pnum, co
 	con_printf(CON_VERBOSE, "P#%u: Sending MData ACK for pkt %i by pnum %i",Player_num, pkt_num, sender_pnum);
 	dxx_sendto(sender_addr, UDP_Socket[0], buf, 0);
 
-	UDP_mdata_trace[sender_pnum].cur_slot++;
-	if (UDP_mdata_trace[sender_pnum].cur_slot >= UDP_MDATA_STOR_QUEUE_SIZE)
-		UDP_mdata_trace[sender_pnum].cur_slot = 0;
-	UDP_mdata_trace[sender_pnum].pkt_num[UDP_mdata_trace[sender_pnum].cur_slot] = pkt_num;
-	UDP_mdata_trace[sender_pnum].pkt_num_torecv++;
-	if (UDP_mdata_trace[sender_pnum].pkt_num_torecv > UDP_MDATA_PKT_NUM_MAX)
-		UDP_mdata_trace[sender_pnum].pkt_num_torecv = UDP_MDATA_PKT_NUM_MIN;
+	if (trace.recv_count < UDP_MDATA_STOR_QUEUE_SIZE)
+		trace.recv_count++;
+	trace.pkt_num_torecv = net_udp_noloss_next_pkt_num(pkt_num);
 	return 1;
 }
 
-/* We got an ACK by a player. Set this player slot to positive! */
+/*
+ * We got an ACK by a player. Set this player slot to positive!
+ * Players accept packets only in order, so the ACK also covers every
+ * older packet, even if their own ACKs got lost.
+ */
 void net_udp_noloss_got_ack(const uint8_t *data, uint_fast32_t data_len)
 {
 	int len = 0;
@@ -5027,21 +5908,33 @@ void net_udp_noloss_got_ack(const uint8_t *data, uint_fast32_t data_len)
 	dest_pnum = data[len];												len++;
 	pkt_num = GET_INTEL_INT(&data[len]);										len += 4;
 
-	for (int i = 0; i < UDP_mdata_queue_highest; i++)
+	if (sender_pnum >= MAX_PLAYERS)
+		return;
+	auto &trace = UDP_mdata_trace[sender_pnum];
+	// Ignore repeated ACKs and ACKs for packets we never sent.
+	const auto acked = net_udp_noloss_distance(trace.pkt_num_unacked, pkt_num);
+	if (acked >= net_udp_noloss_distance(trace.pkt_num_unacked, trace.pkt_num_tosend))
+		return;
+	con_printf(CON_VERBOSE, "P#%u: Got MData ACK for pkt_num %i from pnum %i for pnum %i",Player_num, pkt_num, sender_pnum, dest_pnum);
+	for (uint32_t n = trace.pkt_num_unacked;; n = net_udp_noloss_next_pkt_num(n))
 	{
-		if ((pkt_num == UDP_mdata_queue[i].pkt_num[sender_pnum]) && (dest_pnum == UDP_mdata_queue[i].Player_num))
+		auto &entry = UDP_mdata_queue[trace.queue_slot[n % UDP_MDATA_STOR_QUEUE_SIZE]];
+		// The packet may have been removed already after a timeout.
+		if (entry.used && entry.pkt_num[sender_pnum] == n)
 		{
-			con_printf(CON_VERBOSE, "P#%u: Got MData ACK for pkt_num %i from pnum %i for pnum %i",Player_num, pkt_num, sender_pnum, dest_pnum);
-			UDP_mdata_queue[i].player_ack[sender_pnum] = 1;
-			break;
+			entry.player_ack[sender_pnum] = 1;
+			++UDP_stats.peer[sender_pnum].acked;
 		}
+		if (n == pkt_num)
+			break;
 	}
+	trace.pkt_num_unacked = net_udp_noloss_next_pkt_num(pkt_num);
 }
 
 /* Init/Free the queue. Call at start and end of a game or level. */
 void net_udp_noloss_init_mdata_queue(void)
 {
-	UDP_mdata_queue_highest=0;
+	UDP_mdata_queue_first = UDP_mdata_queue_highest = 0;
 	con_printf(CON_VERBOSE, "P#%u: Clearing MData store/trace list",Player_num);
 	UDP_mdata_queue = {};
 	for (int i = 0; i < MAX_PLAYERS; i++)
@@ -5052,10 +5945,11 @@ void net_udp_noloss_init_mdata_queue(void)
 void net_udp_noloss_clear_mdata_trace(ubyte player_num)
 {
 	con_printf(CON_VERBOSE, "P#%u: Clearing trace list for %i",Player_num, player_num);
-	UDP_mdata_trace[player_num].pkt_num = {};
-	UDP_mdata_trace[player_num].cur_slot = 0;
-	UDP_mdata_trace[player_num].pkt_num_torecv = UDP_MDATA_PKT_NUM_MIN;
-	UDP_mdata_trace[player_num].pkt_num_tosend = UDP_MDATA_PKT_NUM_MIN;
+	auto &trace = UDP_mdata_trace[player_num];
+	trace.recv_count = 0;
+	trace.pkt_num_torecv = UDP_MDATA_PKT_NUM_MIN;
+	trace.pkt_num_tosend = UDP_MDATA_PKT_NUM_MIN;
+	trace.pkt_num_unacked = UDP_MDATA_PKT_NUM_MIN;
 }
 
 /*
@@ -5072,12 +5966,13 @@ void net_udp_noloss_process_queue(fix64 time)
 	if (!Netgame.PacketLossPrevention)
 		return;
 
-	for (int queuec = 0; queuec < UDP_mdata_queue_highest; queuec++)
+	for (unsigned queuei = 0; queuei < UDP_mdata_queue_highest; queuei++)
 	{
+		auto &entry = net_udp_noloss_queue_entry(queuei);
 		int needack = 0;
 
 		// This might happen if we get out ACK's in the wrong order. So ignore that packet for now. It'll resolve itself.
-		if (!UDP_mdata_queue[queuec].used)
+		if (!entry.used)
 			continue;
 
 		// Check if at least one connected player has not ACK'd the packet
@@ -5085,27 +5980,34 @@ void net_udp_noloss_process_queue(fix64 time)
 		{
 			// If player is not playing anymore, we can remove him from list. Also remove *me* (even if that should have been done already). Also make sure Clients do not send to anyone else than Host
 			if ((vcplayerptr(plc)->connected != CONNECT_PLAYING || plc == Player_num) || (!multi_i_am_master() && plc > 0))
-				UDP_mdata_queue[queuec].player_ack[plc] = 1;
+			{
+				// No ACK will come for it, so do not count it as pending.
+				auto &trace = UDP_mdata_trace[plc];
+				if (!entry.player_ack[plc] && entry.pkt_num[plc] == trace.pkt_num_unacked)
+					trace.pkt_num_unacked = net_udp_noloss_next_pkt_num(trace.pkt_num_unacked);
+				entry.player_ack[plc] = 1;
+			}
 
-			if (!UDP_mdata_queue[queuec].player_ack[plc])
+			if (!entry.player_ack[plc])
 			{
 				// Resend if enough time has passed.
-				if (UDP_mdata_queue[queuec].pkt_timestamp[plc] + (F1_0/4) <= time)
+				if (entry.pkt_timestamp[plc] + (F1_0/4) <= time)
 				{
 					ubyte buf[sizeof(UDP_mdata_info)];
 					int len = 0;
 					
-					con_printf(CON_VERBOSE, "P#%u: Resending pkt_num %i from pnum %i to pnum %i",Player_num, UDP_mdata_queue[queuec].pkt_num[plc], UDP_mdata_queue[queuec].Player_num, plc);
+					con_printf(CON_VERBOSE, "P#%u: Resending pkt_num %i from pnum %i to pnum %i",Player_num, entry.pkt_num[plc], entry.Player_num, plc);
 					
-					UDP_mdata_queue[queuec].pkt_timestamp[plc] = time;
+					entry.pkt_timestamp[plc] = time;
+					++UDP_stats.peer[plc].resent;
 					memset(&buf, 0, sizeof(UDP_mdata_info));
 					
 					// Prepare the packet and send it
 					buf[len] = UPID_MDATA_PNEEDACK;													len++;
-					buf[len] = UDP_mdata_queue[queuec].Player_num;								len++;
-					PUT_INTEL_INT(buf + len, UDP_mdata_queue[queuec].pkt_num[plc]);					len += 4;
-					memcpy(&buf[len], UDP_mdata_queue[queuec].data.data(), sizeof(char)*UDP_mdata_queue[queuec].data_size);
-																								len += UDP_mdata_queue[queuec].data_size;
+					buf[len] = entry.Player_num;								len++;
+					PUT_INTEL_INT(buf + len, entry.pkt_num[plc]);					len += 4;
+					memcpy(&buf[len], entry.data.data(), sizeof(char)*entry.data_size);
+																								len += entry.data_size;
 					dxx_sendto(Netgame.players[plc].protocol.udp.addr, UDP_Socket[0], buf, len, 0);
 					total_len += len;
 				}
@@ -5114,14 +6016,14 @@ void net_udp_noloss_process_queue(fix64 time)
 		}
 
 		// Check if we can remove that packet due to to it had no resend's or Timeout
-		if (needack==0 || (UDP_mdata_queue[queuec].pkt_initial_timestamp + UDP_TIMEOUT <= time))
+		if (needack==0 || (entry.pkt_initial_timestamp + UDP_TIMEOUT <= time))
 		{
 			if (needack) // packet timed out but still not all have ack'd.
 			{
 				if (multi_i_am_master()) // We are host, so we kick the remaining players.
 				{
 					for ( int plc=1; plc<N_players; plc++ )
-						if (UDP_mdata_queue[queuec].player_ack[plc] == 0)
+						if (entry.player_ack[plc] == 0)
 							net_udp_dump_player(Netgame.players[plc].protocol.udp.addr, DUMP_PKTTIMEOUT);
 				}
 				else // We are client, so we gotta go.
@@ -5136,8 +6038,8 @@ void net_udp_noloss_process_queue(fix64 time)
 					game_leave_menus();
 				}
 			}
-			con_printf(CON_VERBOSE, "P#%u: Removing stored pkt_num [%i,%i,%i,%i,%i,%i,%i,%i] - missing ACKs: %i",Player_num, UDP_mdata_queue[queuec].pkt_num[0],UDP_mdata_queue[queuec].pkt_num[1],UDP_mdata_queue[queuec].pkt_num[2],UDP_mdata_queue[queuec].pkt_num[3],UDP_mdata_queue[queuec].pkt_num[4],UDP_mdata_queue[queuec].pkt_num[5],UDP_mdata_queue[queuec].pkt_num[6],UDP_mdata_queue[queuec].pkt_num[7], needack); // Just *marked* for removal. The actual process happens further below.
-			UDP_mdata_queue[queuec].used = 0;
+			con_printf(CON_VERBOSE, "P#%u: Removing stored pkt_num [%i,%i,%i,%i,%i,%i,%i,%i] - missing ACKs: %i",Player_num, entry.pkt_num[0],entry.pkt_num[1],entry.pkt_num[2],entry.pkt_num[3],entry.pkt_num[4],entry.pkt_num[5],entry.pkt_num[6],entry.pkt_num[7], needack); // Just *marked* for removal. The actual process happens further below.
+			entry.used = 0;
 		}
 
 		// Send up to half our max packet size
@@ -5146,12 +6048,8 @@ void net_udp_noloss_process_queue(fix64 time)
 	}
 
 	// Now that we are done processing the queue, actually remove all unused packets from the top of the list.
-	while (!UDP_mdata_queue[0].used && UDP_mdata_queue_highest > 0)
-	{
-		std::move(std::next(UDP_mdata_queue.begin()), UDP_mdata_queue.end(), UDP_mdata_queue.begin());
-		UDP_mdata_queue[UDP_MDATA_STOR_QUEUE_SIZE - 1] = {};
-		UDP_mdata_queue_highest--;
-	}
+	while (UDP_mdata_queue_highest > 0 && !net_udp_noloss_queue_entry(0).used)
+		net_udp_noloss_pop_queue();
 }
 /* CODE FOR PACKET LOSS PREVENTION - END */
 
@@ -5205,6 +6103,12 @@ void net_udp_send_mdata(int needack, fix64 time)
 	if (!(Game_mode&GM_NETWORK) || !UDP_Socket[0])
 		return;
 
+	// Everything waiting goes in this packet, so it must be ACKed if
+	// any waiting message needs that.
+	if (UDP_MData_priority == 2)
+		needack = 1;
+	UDP_MData_priority = 0;
+
 	if (!(UDP_MData.mbuf_size > 0))
 		return;
 
@@ -5323,7 +6227,7 @@ void net_udp_process_mdata(uint8_t *data, uint_fast32_t data_len, const _sockadd
 
 void net_udp_send_pdata()
 {
-	array<uint8_t, 3 + quaternionpos::packed_size::value> buf;
+	array<uint8_t, 4 + quaternionpos::packed_size::value> buf;
 	int len = 0;
 
 	if (!(Game_mode&GM_NETWORK) || !UDP_Socket[0])
@@ -5340,6 +6244,12 @@ void net_udp_send_pdata()
 
 	quaternionpos qpp{};
 	create_quaternionpos(qpp, vmobjptr(plr.objnum));
+	// A ship at rest, or not turning, sends no velocity or rotational
+	// velocity.  This keeps every packet self-contained, so a lost
+	// packet never leaves a peer with a stale baseline.
+	const uint8_t fields = ((qpp.vel.x || qpp.vel.y || qpp.vel.z) ? UPID_PDATA_HAS_VELOCITY : 0) |
+		((qpp.rotvel.x || qpp.rotvel.y || qpp.rotvel.z) ? UPID_PDATA_HAS_ROTVEL : 0);
+	buf[len] = fields;								len++;
 	PUT_INTEL_SHORT(&buf[len], qpp.orient.w);							len += 2;
 	PUT_INTEL_SHORT(&buf[len], qpp.orient.x);							len += 2;
 	PUT_INTEL_SHORT(&buf[len], qpp.orient.y);							len += 2;
@@ -5347,23 +6257,31 @@ void net_udp_send_pdata()
 	PUT_INTEL_INT(&buf[len], qpp.pos.x);							len += 4;
 	PUT_INTEL_INT(&buf[len], qpp.pos.y);							len += 4;
 	PUT_INTEL_INT(&buf[len], qpp.pos.z);							len += 4;
-	PUT_INTEL_SHORT(&buf[len], qpp.segment);							len += 2;
+	PUT_INTEL_SHORT(&buf[len], qpp.segment);							len += 2; // 26
+	if (fields & UPID_PDATA_HAS_VELOCITY)
+	{
 	PUT_INTEL_INT(&buf[len], qpp.vel.x);							len += 4;
 	PUT_INTEL_INT(&buf[len], qpp.vel.y);							len += 4;
 	PUT_INTEL_INT(&buf[len], qpp.vel.z);							len += 4;
+	}
+	if (fields & UPID_PDATA_HAS_ROTVEL)
+	{
 	PUT_INTEL_INT(&buf[len], qpp.rotvel.x);							len += 4;
 	PUT_INTEL_INT(&buf[len], qpp.rotvel.y);							len += 4;
-	PUT_INTEL_INT(&buf[len], qpp.rotvel.z);							len += 4; // 46 + 3 = 49
+	PUT_INTEL_INT(&buf[len], qpp.rotvel.z);							len += 4; // at most 26 + 24 = 50
+	}
 
 	if (multi_i_am_master())
 	{
+		udp_fanout peers;
 		for (unsigned i = 1; i < MAX_PLAYERS; ++i)
 			if (vcplayerptr(i)->connected != CONNECT_DISCONNECTED)
-				dxx_sendto(Netgame.players[i].protocol.udp.addr, UDP_Socket[0], buf, 0);
+				peers.add(Netgame.players[i].protocol.udp.addr);
+		peers.send(UDP_Socket[0], buf.data(), len);
 	}
 	else
 	{
-		dxx_sendto(Netgame.players[0].protocol.udp.addr, UDP_Socket[0], buf, 0);
+		dxx_sendto(Netgame.players[0].protocol.udp.addr, UDP_Socket[0], buf.data(), len, 0);
 	}
 }
 
@@ -5381,7 +6299,10 @@ void net_udp_process_pdata(const uint8_t *data, uint_fast32_t data_len, const _s
 	
 	if (data_len > sizeof(UDP_frame_info))
 		return;
-	if (data_len != UPID_PDATA_SIZE)
+	if (data_len < UPID_PDATA_SIZE)
+		return;
+	const uint8_t fields = data[3];
+	if (data_len != UPID_PDATA_SIZE + ((fields & UPID_PDATA_HAS_VELOCITY) ? UPID_PDATA_VECTOR_SIZE : 0) + ((fields & UPID_PDATA_HAS_ROTVEL) ? UPID_PDATA_VECTOR_SIZE : 0))
 		return;
 
 	if (sender_addr != Netgame.players[((multi_i_am_master())?(data[len]):(0))].protocol.udp.addr)
@@ -5389,6 +6310,7 @@ void net_udp_process_pdata(const uint8_t *data, uint_fast32_t data_len, const _s
 
 	pd.Player_num = data[len];								len++;
 	pd.connected = data[len];								len++;
+	len++;	// fields
 	pd.qpp.orient.w = GET_INTEL_SHORT(&data[len]);					len += 2;
 	pd.qpp.orient.x = GET_INTEL_SHORT(&data[len]);					len += 2;
 	pd.qpp.orient.y = GET_INTEL_SHORT(&data[len]);					len += 2;
@@ -5397,18 +6319,25 @@ void net_udp_process_pdata(const uint8_t *data, uint_fast32_t data_len, const _s
 	pd.qpp.pos.y = GET_INTEL_INT(&data[len]);						len += 4;
 	pd.qpp.pos.z = GET_INTEL_INT(&data[len]);						len += 4;
 	pd.qpp.segment = GET_INTEL_SHORT(&data[len]);					len += 2;
+	if (fields & UPID_PDATA_HAS_VELOCITY)
+	{
 	pd.qpp.vel.x = GET_INTEL_INT(&data[len]);						len += 4;
 	pd.qpp.vel.y = GET_INTEL_INT(&data[len]);						len += 4;
 	pd.qpp.vel.z = GET_INTEL_INT(&data[len]);						len += 4;
+	}
+	if (fields & UPID_PDATA_HAS_ROTVEL)
+	{
 	pd.qpp.rotvel.x = GET_INTEL_INT(&data[len]);					len += 4;
 	pd.qpp.rotvel.y = GET_INTEL_INT(&data[len]);					len += 4;
 	pd.qpp.rotvel.z = GET_INTEL_INT(&data[len]);					len += 4;
+	}
 	
 	if (multi_i_am_master()) // I am host - must relay this packet to others!
 	{
 		const unsigned ppn = pd.Player_num;
 		if (ppn > 0 && ppn <= N_players && vcplayerptr(ppn)->connected == CONNECT_PLAYING) // some checking whether this packet is legal
 		{
+			udp_fanout peers;
 			for (unsigned i = 1; i < MAX_PLAYERS; ++i)
 			{
 				// not to sender or disconnected/waiting players - right.
@@ -5416,8 +6345,9 @@ void net_udp_process_pdata(const uint8_t *data, uint_fast32_t data_len, const _s
 					continue;
 				auto &iplr = *vcplayerptr(i);
 				if (iplr.connected != CONNECT_DISCONNECTED && iplr.connected != CONNECT_WAITING)
-					dxx_sendto(Netgame.players[i].protocol.udp.addr, UDP_Socket[0], data, data_len, 0);
+					peers.add(Netgame.players[i].protocol.udp.addr);
 			}
+			peers.send(UDP_Socket[0], data, data_len);
 		}
 	}
 
@@ -5484,11 +6414,126 @@ void net_udp_read_pdata_packet(UDP_frame_info *pd)
 	if (vcplayerptr(Player_num)->connected == CONNECT_DISCONNECTED || vcplayerptr(Player_num)->connected == CONNECT_WAITING)
                 return;
 	//------------ Read the player's ship's object info ----------------------
+	if (CGameArg.MplUdpInterpDelay)
+	{
+		// Applied by net_udp_interpolate_players
+		auto &h = UDP_pdata_history[TheirPlayernum];
+		h.snapshots[h.next] = {timer_query(), pd->qpp};
+		h.next = (h.next + 1) % h.snapshots.size();
+		if (h.count < h.snapshots.size())
+			++h.count;
+		return;
+	}
 	extract_quaternionpos(TheirObj, pd->qpp);
 	if (TheirObj->movement_type == MT_PHYSICS)
 		set_thrust_from_velocity(TheirObj);
 }
 
+/* Ships further apart than this between two packets have respawned or
+ * teleported, so they are not moved through the space between.
+ */
+#define UDP_INTERP_TELEPORT_DISTANCE	(F1_0*80)
+// How far past the newest packet a ship may be extrapolated
+#define UDP_INTERP_MAX_EXTRAPOLATION	(F1_0/4)
+
+static void net_udp_interpolate_orient(vms_quaternion &r, const vms_quaternion &a, const vms_quaternion &b, const fix u)
+{
+	// q and -q are the same rotation.  Take the shorter way round.
+	const int sign = (a.w * b.w + a.x * b.x + a.y * b.y + a.z * b.z) < 0 ? -1 : 1;
+	const auto lerp = [u, sign](const short from, const short to) {
+		return static_cast<short>(from + fixmul(sign * to - from, u));
+	};
+	/* vms_matrix_from_quaternion normalizes, so the components need
+	 * not be renormalized here.
+	 */
+	r.w = lerp(a.w, b.w);
+	r.x = lerp(a.x, b.x);
+	r.y = lerp(a.y, b.y);
+	r.z = lerp(a.z, b.z);
+}
+
+/* Cubic Hermite interpolation between two snapshots, using their
+ * velocities as tangents.
+ */
+static void net_udp_interpolate_snapshot(quaternionpos &r, const udp_pdata_snapshot &a, const udp_pdata_snapshot &b, const fix64 when)
+{
+	const fix dt = static_cast<fix>(b.time - a.time);
+	const fix u = fixdiv(static_cast<fix>(when - a.time), dt);
+	const fix u2 = fixmul(u, u), u3 = fixmul(u2, u);
+	const fix h01 = 3 * u2 - 2 * u3;
+	const fix h10 = u3 - 2 * u2 + u;
+	const fix h11 = u3 - u2;
+	r = b.qpp;
+	auto &p = r.pos;
+	p = a.qpp.pos;
+	vm_vec_scale_add2(p, vm_vec_sub(b.qpp.pos, a.qpp.pos), h01);
+	vm_vec_scale_add2(p, a.qpp.vel, fixmul(h10, dt));
+	vm_vec_scale_add2(p, b.qpp.vel, fixmul(h11, dt));
+	r.vel = a.qpp.vel;
+	vm_vec_scale_add2(r.vel, vm_vec_sub(b.qpp.vel, a.qpp.vel), u);
+	r.rotvel = a.qpp.rotvel;
+	vm_vec_scale_add2(r.rotvel, vm_vec_sub(b.qpp.rotvel, a.qpp.rotvel), u);
+	net_udp_interpolate_orient(r.orient, a.qpp.orient, b.qpp.orient, u);
+}
+
+/* Place every other ship where it was -udp_interp_delay ago, between the
+ * two packets around that time, or a little past the newest one if no
+ * packet is that recent.
+ */
+static void net_udp_interpolate_players(const fix64 now)
+{
+	const fix64 when = now - (i2f(CGameArg.MplUdpInterpDelay) / 1000);
+	for (unsigned pnum = 0; pnum != N_players; ++pnum)
+	{
+		auto &h = UDP_pdata_history[pnum];
+		if (!h.count)
+			continue;
+		auto &plr = *vcplayerptr(pnum);
+		if (pnum == Player_num || plr.connected != CONNECT_PLAYING)
+		{
+			h.count = 0;
+			continue;
+		}
+		// The newest packet from before when
+		unsigned age = 0;
+		while (age + 1 < h.count && h.newest(age).time > when)
+			++age;
+		const auto &a = h.newest(age);
+		quaternionpos qpp;
+		if (a.time > when)
+			// Only packets from after when: show the oldest until then.
+			qpp = a.qpp;
+		else if (!age)
+		{
+			qpp = a.qpp;
+			const fix ahead = static_cast<fix>(std::min<fix64>(when - a.time, UDP_INTERP_MAX_EXTRAPOLATION));
+			vm_vec_scale_add2(qpp.pos, a.qpp.vel, ahead);
+		}
+		else
+		{
+			const auto &b = h.newest(age - 1);
+			if (vm_vec_dist_quick(a.qpp.pos, b.qpp.pos) > UDP_INTERP_TELEPORT_DISTANCE)
+				qpp = b.qpp;
+			else
+				net_udp_interpolate_snapshot(qpp, a, b, when);
+		}
+		/* The snapshots only name the segment of their own position. */
+		const auto &&objp = vmobjptridx(plr.objnum);
+		const auto &&segp = find_point_seg(LevelSharedSegmentState, qpp.pos, Segments.vcptridx(qpp.segment));
+		if (segp == segment_none)
+		{
+			const auto &newest = h.newest(0);
+			qpp.pos = newest.qpp.pos;
+			qpp.segment = newest.qpp.segment;
+		}
+		else
+			qpp.segment = segp;
+		extract_quaternionpos(objp, qpp);
+		if (objp->movement_type == MT_PHYSICS)
+			set_thrust_from_velocity(objp);
+	}
+}
+
 #if defined(DXX_BUILD_DESCENT_II)
 static void net_udp_send_smash_lights (const playernum_t pnum)
  {
@@ -5563,6 +6608,9 @@ void net_udp_process_ping(const uint8_t *data, const _sockaddr &sender_addr)
 	{
 		i.ping = GET_INTEL_INT(&(data[len]));		len += 4;
 	}
+	// The host measured the time to us, which is all a client can know.
+	if (Player_num > 0 && Player_num < MAX_PLAYERS)
+		net_udp_stats_add_rtt(0, Netgame.players[Player_num].ping);
 	
 	buf[0] = UPID_PONG;
 	buf[1] = Player_num;
@@ -5597,6 +6645,7 @@ void net_udp_process_pong(const uint8_t *data, const _sockaddr &sender_addr)
 	else
 		result = 0;
 	Netgame.players[playernum].ping = result;
+	net_udp_stats_add_rtt(playernum, result);
 }
 
 namespace dsx {
@@ -5838,6 +6887,8 @@ int net_udp_show_game_info()
 /* Tracker stuff, begin! */
 #if DXX_USE_TRACKER
 
+static udp_dns_async TrackerResolver;
+
 /* Tracker initialization */
 static int udp_tracker_init()
 {
@@ -5849,14 +6900,21 @@ static int udp_tracker_init()
 
 	const char *tracker_addr = CGameArg.MplTrackerAddr.c_str();
 
-	// Fill the address
-	if (udp_dns_filladdr(TrackerSocket, tracker_addr, CGameArg.MplTrackerPort, false, true) < 0)
-		return -1;
+	// Fill the address.  Nothing is sent to the tracker until
+	// udp_tracker_poll_resolver finds it done.
+	TrackerSocket = {};
+	TrackerSocket.sa.sa_family = AF_UNSPEC;
+	TrackerResolver.start(tracker_addr, CGameArg.MplTrackerPort);
 
 	// Yay
 	return 0;
 }
 
+static bool udp_tracker_resolved()
+{
+	return TrackerSocket.sa.sa_family != AF_UNSPEC;
+}
+
 /* Compares sender to tracker. Returns 1 if address matches, Returns 2 is address and port matches. */
 static int sender_is_tracker(const _sockaddr &sender, const _sockaddr &tracker)
 {
@@ -5912,6 +6970,8 @@ static int sender_is_tracker(const _sockaddr &sender, const _sockaddr &tracker)
 /* Unregister from the tracker */
 static int udp_tracker_unregister()
 {
+	if (!udp_tracker_resolved())
+		return -1;
 	array<uint8_t, 1> pBuf;
 
 	pBuf[0] = UPID_TRACKER_REMOVE;
@@ -5923,6 +6983,8 @@ namespace dsx {
 /* Register or update (i.e. keep alive) a game on the tracker */
 static int udp_tracker_register()
 {
+	if (!udp_tracker_resolved())
+		return -1;
 	net_udp_update_netgame();
 
 	game_info_light light;
@@ -5939,6 +7001,8 @@ static int udp_tracker_register()
 /* Ask the tracker to send us a list of games */
 static int udp_tracker_reqgames()
 {
+	if (!udp_tracker_resolved())
+		return -1;
 	array<uint8_t, 2 + sizeof(UDP_REQ_ID) + sizeof("00000.00000.00000.00000")> pBuf = {};
 	int len = 1;
 
@@ -5947,6 +7011,21 @@ static int udp_tracker_reqgames()
 
 	return dxx_sendto(TrackerSocket, UDP_Socket[0], &pBuf, len, 0);
 }
+
+/* Once the tracker address is known, send what had to wait for it */
+static void udp_tracker_poll_resolver()
+{
+	if (TrackerResolver.poll(TrackerSocket, true) != udp_dns_async::state::done)
+		return;
+	if (Network_status == NETSTAT_BROWSING)
+		udp_tracker_reqgames();
+	else if (Netgame.Tracker && multi_i_am_master() && (Network_status == NETSTAT_STARTING || Network_status == NETSTAT_PLAYING))
+	{
+		TrackerAckStatus = TrackerAckState::TACK_NOCONNECTION;
+		TrackerAckTime = timer_query();
+		udp_tracker_register();
+	}
+}
 }
 
 /* The tracker has sent us a game.  Let's list it. */
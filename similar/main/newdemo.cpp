@@ -23,13 +23,18 @@ COPYRIGHT 1993-1999 PARALLAX SOFTWARE CORPORATION.  ALL RIGHTS RESERVED.
  *
  */
 
+#include <algorithm>
 #include <cstdlib>
 #include <ctime>
 #include <stdio.h>
 #include <stdarg.h>
 #include <errno.h>
 #include <ctype.h>
+#include <deque>
 #include <type_traits>
+#include <unordered_map>
+#include <vector>
+#include <SDL.h>
 
 #include "u_mem.h"
 #include "inferno.h"
@@ -88,6 +93,7 @@ COPYRIGHT 1993-1999 PARALLAX SOFTWARE CORPORATION.  ALL RIGHTS RESERVED.
 #include "console.h"
 #include "controls.h"
 #include "playsave.h"
+#include "profile.h"
 
 #if DXX_USE_EDITOR
 #include "editor/editor.h"
@@ -145,6 +151,7 @@ COPYRIGHT 1993-1999 PARALLAX SOFTWARE CORPORATION.  ALL RIGHTS RESERVED.
 #define ND_EVENT_LASER_LEVEL			42	// with old/new level
 #define ND_EVENT_LINK_SOUND_TO_OBJ		43	// record digi_link_sound_to_object3
 #define ND_EVENT_KILL_SOUND_TO_OBJ		44	// record digi_kill_sound_linked_to_object
+#define ND_EVENT_RENDER_OBJECT_DELTA		45	// Followed by a base offset, length, change mask and the changed bytes
 #elif defined(DXX_BUILD_DESCENT_II)
 #define ND_EVENT_LASER_LEVEL			42	// no data
 #define ND_EVENT_PLAYER_AFTERBURNER		43	// followed by byte old ab, current ab
@@ -155,6 +162,7 @@ COPYRIGHT 1993-1999 PARALLAX SOFTWARE CORPORATION.  ALL RIGHTS RESERVED.
 #define ND_EVENT_SECRET_THINGY			48	// 0/1 = secret exit functional/non-functional
 #define ND_EVENT_LINK_SOUND_TO_OBJ		49	// record digi_link_sound_to_object3
 #define ND_EVENT_KILL_SOUND_TO_OBJ		50	// record digi_kill_sound_linked_to_object
+#define ND_EVENT_RENDER_OBJECT_DELTA		51	// Followed by a base offset, length, change mask and the changed bytes
 #endif
 
 #define NORMAL_PLAYBACK 			0
@@ -176,6 +184,20 @@ COPYRIGHT 1993-1999 PARALLAX SOFTWARE CORPORATION.  ALL RIGHTS RESERVED.
 
 #define DEMO_MAX_LEVELS				29
 
+// Record the full game state at least this often, so that playback can
+// seek without replaying every frame
+#define ND_KEYFRAME_INTERVAL			200	// frames
+#define ND_KEYFRAME_INDEX_MAX			1024
+// Most ND_EVENT_RENDER_OBJECT_DELTA base records kept during playback
+#define ND_DELTA_BASE_CACHE_MAX			8192
+
+// Markers for data carried in the red component of ND_EVENT_PALETTE_EFFECT.
+// Versions which do not know them play the data as a palette flash, which
+// the event after it clears again.
+constexpr int16_t ND_META_KEYFRAME = 0x1080;
+constexpr int16_t ND_META_INDEX = 0x1180;
+constexpr int16_t ND_META_INDEX_FOOTER = 0x1280;
+
 const array<file_extension_t, 1> demo_file_extensions{{DEMO_EXT}};
 
 // In- and Out-files
@@ -198,6 +220,9 @@ static void nd_render_extras (ubyte which,const vcobjptr_t obj);
 
 // local var used for swapping endian demos
 static int swap_endian = 0;
+// Set while newdemo_batch adds a seek index to a demo being rewritten
+static bool nd_rewrite_index;
+static int nd_rewrite_level;
 
 // playback variables
 static unsigned int nd_playback_v_demosize;
@@ -214,6 +239,33 @@ static ubyte nd_playback_v_guided = 0;
 int nd_playback_v_juststarted=0;
 #endif
 
+struct nd_keyframe_entry
+{
+	int offset;		// of the ND_EVENT_START_FRAME of the keyframe
+	int frame;
+	int8_t level;
+};
+
+static std::vector<nd_keyframe_entry> nd_playback_v_keyframes;
+static sbyte nd_playback_v_apply_keyframe;
+
+// Base records of ND_EVENT_RENDER_OBJECT_DELTA, by file offset
+static std::unordered_map<int, std::vector<uint8_t>> nd_playback_v_delta_bases;
+// Set while nd_read_object reads a record rebuilt from a delta
+static const uint8_t *nd_playback_v_record, *nd_playback_v_record_end;
+
+// -demo_stats output, and the frame and time of the events being read
+static RAIIPHYSFS_File nd_stats_file;
+static int nd_stats_frame;
+static float nd_stats_time;
+
+static void nd_stats_event(const char *const event, const int a, const int b = 0, const int c = 0)
+{
+	if (!nd_stats_file || Newdemo_vcr_state != ND_STATE_PLAYBACK)
+		return;
+	PHYSFSX_printf(nd_stats_file, "%i,%.3f,%s,%i,%i,%i,0\n", nd_stats_frame, nd_stats_time, event, a, b, c);
+}
+
 // record variables
 #define REC_DELAY F1_0/20
 static int nd_record_v_start_frame = -1;
@@ -237,6 +289,19 @@ static int nd_record_v_weapon_num = -1;
 static fix nd_record_v_homing_distance = -1;
 static int nd_record_v_primary_ammo = -1;
 static int nd_record_v_secondary_ammo = -1;
+static std::vector<nd_keyframe_entry> nd_record_v_keyframes;
+static int nd_record_v_keyframe_interval;
+static int nd_record_v_next_keyframe;
+
+/* For -record-demo-delta, the last record written in full for each
+ * signature and the file offset it starts at.
+ */
+struct nd_delta_base
+{
+	int offset;
+	std::vector<uint8_t> record;
+};
+static std::unordered_map<uint16_t, nd_delta_base> nd_record_v_delta_bases;
 
 namespace dsx {
 static void newdemo_record_oneframeevent_update(int wallupdate);
@@ -252,7 +317,7 @@ int newdemo_get_percent_done()	{
 		return (PHYSFS_tell(infile) * 100) / nd_playback_v_demosize;
 	}
 	if ( Newdemo_state == ND_STATE_RECORDING ) {
-		return PHYSFS_tell(outfile);
+		return Newdemo_num_written;
 	}
 	return 0;
 }
@@ -292,6 +357,18 @@ static void my_extract_shortpos(object_base &objp, const shortpos *const spp)
 static int _newdemo_read( void *buffer, int elsize, int nelem )
 {
 	int num_read;
+	if (nd_playback_v_record)
+	{
+		const std::size_t size = elsize * nelem;
+		if (static_cast<std::size_t>(nd_playback_v_record_end - nd_playback_v_record) < size)
+		{
+			nd_playback_v_bad_read = -1;
+			return 0;
+		}
+		memcpy(buffer, nd_playback_v_record, size);
+		nd_playback_v_record += size;
+		return nelem;
+	}
 	num_read = (PHYSFS_read)(infile, buffer, elsize, nelem);
 	if (num_read < nelem || PHYSFS_eof(infile))
 		nd_playback_v_bad_read = -1;
@@ -305,19 +382,187 @@ static typename std::enable_if<std::is_integral<T>::value, int>::type newdemo_re
 	return _newdemo_read(buffer, elsize, nelem);
 }
 
-icobjptridx_t newdemo_find_object(object_signature_t signature)
+namespace {
+
+/* Objects by signature, which in a demo fits in 16 bits.  An entry is
+ * valid only if its generation is current.  Playback creates every
+ * object with obj_allocate, so the table is rebuilt on the first lookup
+ * after an allocation.  An object deleted since then fails the check
+ * in newdemo_find_object.
+ */
+struct nd_signature_entry
 {
+	uint16_t generation;
+	objnum_t objnum;
+};
+
+struct nd_signature_map_state
+{
+	uint16_t generation;
+	bool built;
+	unsigned allocations;
+	array<nd_signature_entry, 1 << 16> entries;
+};
+
+}
+
+static nd_signature_map_state nd_signature_map;
+
+static void nd_signature_map_build()
+{
+	auto &m = nd_signature_map;
+	if (!++m.generation)
+	{
+		m.entries = {};
+		m.generation = 1;
+	}
+	const auto generation = m.generation;
 	range_for (const auto &&objp, vcobjptridx)
 	{
-		if ( (objp->type != OBJ_NONE) && (objp->signature == signature))
+		if (objp->type == OBJ_NONE)
+			continue;
+		// Like the scan this replaces, the lowest numbered object wins
+		auto &e = m.entries[objp->signature.get()];
+		if (e.generation != generation)
+		{
+			e.generation = generation;
+			e.objnum = objp;
+		}
+	}
+	m.built = true;
+	m.allocations = LevelUniqueObjectState.allocations;
+}
+
+icobjptridx_t newdemo_find_object(object_signature_t signature)
+{
+	auto &m = nd_signature_map;
+	if (!m.built || m.allocations != LevelUniqueObjectState.allocations)
+		nd_signature_map_build();
+	auto &e = m.entries[signature.get()];
+	if (e.generation == m.generation && e.objnum < Objects.get_count())
+	{
+		const auto &&objp = vcobjptridx(e.objnum);
+		if (objp->type != OBJ_NONE && objp->signature == signature)
 			return objp;
 	}
 	return object_none;
 }
 
+/*
+ * The nd_write_* helpers only append to nd_record_v_buffer.  Once per
+ * frame the buffer is handed to a worker thread which writes it to
+ * outfile, so that a slow disk does not stall the game.  If the thread
+ * cannot be started, the buffer is written on the calling thread.
+ */
+struct nd_writer_state
+{
+	SDL_Thread *thread;
+	SDL_mutex *lock;
+	SDL_cond *wake;
+	bool quit;
+	bool failed;
+	std::deque<std::vector<uint8_t>> pending;
+};
+
+static nd_writer_state nd_writer;
+static std::vector<uint8_t> nd_record_v_buffer;
+
+static int nd_writer_thread(void *)
+{
+	auto &w = nd_writer;
+	SDL_LockMutex(w.lock);
+	for (;;)
+	{
+		while (!w.quit && w.pending.empty())
+			SDL_CondWait(w.wake, w.lock);
+		if (w.pending.empty())
+			break;
+		auto buffer = std::move(w.pending.front());
+		w.pending.pop_front();
+		SDL_UnlockMutex(w.lock);
+		const bool ok = !w.failed && (PHYSFS_write)(outfile, buffer.data(), 1, buffer.size()) == static_cast<PHYSFS_sint64>(buffer.size());
+		SDL_LockMutex(w.lock);
+		if (!ok)
+			w.failed = true;
+	}
+	SDL_UnlockMutex(w.lock);
+	return 0;
+}
+
+static void nd_writer_start()
+{
+	auto &w = nd_writer;
+	nd_record_v_buffer.clear();
+	w.quit = w.failed = false;
+	if (!(w.lock = SDL_CreateMutex()))
+		return;
+	if (!(w.wake = SDL_CreateCond()))
+	{
+		SDL_DestroyMutex(w.lock);
+		return;
+	}
+#if SDL_MAJOR_VERSION == 2
+	w.thread = SDL_CreateThread(nd_writer_thread, "newdemo_write", nullptr);
+#else
+	w.thread = SDL_CreateThread(nd_writer_thread, nullptr);
+#endif
+	if (!w.thread)
+	{
+		SDL_DestroyCond(w.wake);
+		SDL_DestroyMutex(w.lock);
+	}
+}
+
+// Returns false if an earlier write failed.
+static bool nd_writer_flush()
+{
+	auto &w = nd_writer;
+	if (!w.thread)
+	{
+		if (!nd_record_v_buffer.empty())
+		{
+			if ((PHYSFS_write)(outfile, nd_record_v_buffer.data(), 1, nd_record_v_buffer.size()) != static_cast<PHYSFS_sint64>(nd_record_v_buffer.size()))
+				w.failed = true;
+			nd_record_v_buffer.clear();
+		}
+		return !w.failed;
+	}
+	SDL_LockMutex(w.lock);
+	if (!nd_record_v_buffer.empty())
+	{
+		w.pending.emplace_back(std::move(nd_record_v_buffer));
+		nd_record_v_buffer.clear();
+		SDL_CondSignal(w.wake);
+	}
+	const bool failed = w.failed;
+	SDL_UnlockMutex(w.lock);
+	return !failed;
+}
+
+// Write everything still buffered and stop the thread.  Returns false
+// if any write failed.
+static bool nd_writer_stop()
+{
+	auto &w = nd_writer;
+	nd_writer_flush();
+	if (w.thread)
+	{
+		SDL_LockMutex(w.lock);
+		w.quit = true;
+		SDL_CondSignal(w.wake);
+		SDL_UnlockMutex(w.lock);
+		SDL_WaitThread(w.thread, nullptr);
+		w.thread = nullptr;
+		SDL_DestroyCond(w.wake);
+		SDL_DestroyMutex(w.lock);
+		w.pending.clear();
+	}
+	return !w.failed;
+}
+
 static int _newdemo_write(const void *buffer, int elsize, int nelem )
 {
-	int num_written, total_size;
+	int total_size;
 
 	if (unlikely(nd_record_v_no_space))
 		return -1;
@@ -326,14 +571,9 @@ static int _newdemo_write(const void *buffer, int elsize, int nelem )
 	nd_record_v_framebytes_written += total_size;
 	Newdemo_num_written += total_size;
 	Assert(outfile);
-	num_written = (PHYSFS_write)(outfile, buffer, elsize, nelem);
-
-	if (likely(num_written == nelem))
-		return num_written;
-
-	nd_record_v_no_space=2;
-	newdemo_stop_recording();
-	return -1;
+	const auto p = static_cast<const uint8_t *>(buffer);
+	nd_record_v_buffer.insert(nd_record_v_buffer.end(), p, p + total_size);
+	return nelem;
 }
 
 template <typename T>
@@ -1026,6 +1266,298 @@ static void nd_rbe()
 	newdemo_write(buf, 1, sizeof(buf));
 }
 
+static void nd_write_meta_chunk(const int16_t marker, const int16_t a, const int16_t b)
+{
+	nd_write_byte(ND_EVENT_PALETTE_EFFECT);
+	nd_write_short(marker);
+	nd_write_short(a);
+	nd_write_short(b);
+}
+
+// Write values two at a time as events with the given marker, followed
+// by an event which resets the palette flash.
+static void nd_write_meta_stream(const int16_t marker, const std::vector<int16_t> &values)
+{
+	for (std::size_t i = 0; i < values.size(); i += 2)
+		nd_write_meta_chunk(marker, values[i], i + 1 < values.size() ? values[i + 1] : 0);
+	nd_write_meta_chunk(0, 0, 0);
+}
+
+// Read the rest of a stream written by nd_write_meta_stream, whose first
+// event carried a and b.  Returns 0 if the stream is damaged.
+static int nd_read_meta_stream(const int16_t marker, int16_t a, int16_t b, std::vector<int16_t> &values)
+{
+	for (;;)
+	{
+		values.push_back(a);
+		values.push_back(b);
+		int8_t c;
+		int16_t r;
+		nd_read_byte(&c);
+		if (c != ND_EVENT_PALETTE_EFFECT)
+			return 0;
+		nd_read_short(&r);
+		nd_read_short(&a);
+		nd_read_short(&b);
+		if (nd_playback_v_bad_read)
+			return 0;
+		if (r != marker)
+			return !r && !a && !b;
+	}
+}
+
+static void nd_meta_put_int(std::vector<int16_t> &values, const int i)
+{
+	values.push_back(static_cast<int16_t>(i & 0xffff));
+	values.push_back(static_cast<int16_t>(static_cast<uint32_t>(i) >> 16));
+}
+
+static int nd_meta_get_int(const int16_t lo, const int16_t hi)
+{
+	return static_cast<uint16_t>(lo) | (static_cast<uint32_t>(static_cast<uint16_t>(hi)) << 16);
+}
+
+/* Keep the index small enough for the frame that carries it by
+ * dropping every other keyframe from it.
+ */
+static void nd_add_keyframe_entry(const int offset, const int frame, const int level)
+{
+	if (nd_record_v_keyframes.size() >= ND_KEYFRAME_INDEX_MAX)
+	{
+		std::size_t j = 0;
+		for (std::size_t i = 0; i < nd_record_v_keyframes.size(); i += 2)
+			nd_record_v_keyframes[j++] = nd_record_v_keyframes[i];
+		nd_record_v_keyframes.resize(j);
+		nd_record_v_keyframe_interval *= 2;
+	}
+	nd_record_v_keyframes.push_back({offset, frame, static_cast<int8_t>(level)});
+	nd_record_v_next_keyframe = frame + nd_record_v_keyframe_interval;
+}
+
+namespace dsx {
+
+/*
+ * Record the state which the demo otherwise only carries as changes
+ * from frame to frame, right after the ND_EVENT_START_FRAME of the
+ * current frame.  The objects are recorded in full every frame anyway.
+ */
+static void newdemo_record_keyframe(const int offset, const int frame)
+{
+	auto &Walls = LevelUniqueWallSubsystemState.Walls;
+	auto &vcwallptr = Walls.vcptr;
+	auto &plrobj = get_local_plrobj();
+	auto &player_info = plrobj.ctype.player_info;
+	std::vector<int16_t> kf;
+	kf.push_back(Current_level_num);
+	kf.push_back((Player_dead_state != player_dead_state::no ? 1 : 0) |
+		(Rear_view ? 2 : 0) |
+#if defined(DXX_BUILD_DESCENT_II)
+		(Viewer == LevelUniqueObjectState.Guided_missile.get_player_active_guided_missile(LevelUniqueObjectState.get_objects().vmptr, Player_num) ? 4 : 0) |
+#endif
+		(Control_center_destroyed ? 8 : 0));
+	kf.push_back(f2ir(player_info.energy));
+	kf.push_back(f2ir(plrobj.shields));
+	nd_meta_put_int(kf, player_info.powerup_flags.get_player_flags());
+	kf.push_back(static_cast<int>(static_cast<primary_weapon_index_t>(player_info.Primary_weapon)) | (static_cast<int>(static_cast<secondary_weapon_index_t>(player_info.Secondary_weapon)) << 8));
+	kf.push_back(static_cast<uint8_t>(player_info.laser_level));
+	kf.push_back(player_info.vulcan_ammo);
+	range_for (auto &i, player_info.secondary_ammo)
+		kf.push_back(i);
+	if (Game_mode & GM_MULTI)
+	{
+		kf.push_back(N_players);
+		range_for (auto &i, partial_const_range(Players, N_players))
+		{
+			auto &pl_info = vcobjptr(i.objnum)->ctype.player_info;
+			kf.push_back(i.connected | ((pl_info.powerup_flags & PLAYER_FLAGS_CLOAKED) ? 0x100 : 0));
+			if (Game_mode & GM_MULTI_COOP)
+				nd_meta_put_int(kf, pl_info.mission.score);
+			else
+			{
+				kf.push_back(pl_info.net_killed_total);
+				kf.push_back(pl_info.net_kills_total);
+			}
+		}
+	}
+	kf.push_back(Walls.get_count());
+	range_for (const auto &&wp, vcwallptr)
+	{
+		auto &w = *wp;
+		const auto &side = vcsegptr(w.segnum)->unique_segment::sides[w.sidenum];
+		kf.push_back(w.type | (w.flags << 8));
+		kf.push_back(w.state);
+		kf.push_back(side.tmap_num);
+		kf.push_back(side.tmap_num2);
+	}
+	nd_write_meta_stream(ND_META_KEYFRAME, kf);
+	nd_add_keyframe_entry(offset, frame, Current_level_num);
+	// Write every object in full again, so that deltas stay small
+	nd_record_v_delta_bases.clear();
+}
+
+static void nd_apply_keyframe(const std::vector<int16_t> &kf)
+{
+	std::size_t pos = 0;
+	const auto get = [&kf, &pos]() -> int16_t {
+		return pos < kf.size() ? kf[pos++] : 0;
+	};
+	const int level = get();
+	if (level != Current_level_num)
+	{
+		if ((level < Last_secret_level) || (level > Last_level))
+			return;
+		LoadLevel(level, 1);
+	}
+	const auto flags = get();
+	nd_playback_v_dead = (flags & 1) ? 1 : 0;
+	nd_playback_v_rear = (flags & 2) ? 1 : 0;
+#if defined(DXX_BUILD_DESCENT_II)
+	nd_playback_v_guided = (flags & 4) ? 1 : 0;
+#endif
+	nd_playback_v_cntrlcen_destroyed = (flags & 8) ? 1 : 0;
+
+	auto &plrobj = get_local_plrobj();
+	auto &player_info = plrobj.ctype.player_info;
+	player_info.energy = i2f(get());
+	plrobj.shields = i2f(get());
+	{
+		const auto lo = get();
+		player_info.powerup_flags = player_flags(nd_meta_get_int(lo, get()));
+	}
+	if (player_info.powerup_flags & PLAYER_FLAGS_CLOAKED)
+		player_info.cloak_time = GameTime64 - (CLOAK_TIME_MAX / 2);
+	if (player_info.powerup_flags & PLAYER_FLAGS_INVULNERABLE)
+		player_info.invulnerable_time = GameTime64 - (INVULNERABLE_TIME_MAX / 2);
+	{
+		const auto weapons = get();
+		player_info.Primary_weapon = static_cast<primary_weapon_index_t>(weapons & 0xff);
+		player_info.Secondary_weapon = static_cast<secondary_weapon_index_t>((weapons >> 8) & 0xff);
+	}
+	{
+		const stored_laser_level laser_level(static_cast<uint8_t>(get()));
+		if (player_info.laser_level != laser_level)
+		{
+			player_info.laser_level = laser_level;
+			update_laser_weapon_info();
+		}
+	}
+	player_info.vulcan_ammo = get();
+	range_for (auto &i, player_info.secondary_ammo)
+		i = get();
+	if (Newdemo_game_mode & GM_MULTI)
+	{
+		N_players = get();
+		range_for (auto &i, partial_range(Players, N_players))
+		{
+			const auto connected = get();
+			i.connected = connected & 0xff;
+			auto &pl_info = vmobjptr(i.objnum)->ctype.player_info;
+			if (connected & 0x100)
+			{
+				pl_info.powerup_flags |= PLAYER_FLAGS_CLOAKED;
+				pl_info.cloak_time = GameTime64 - (CLOAK_TIME_MAX / 2);
+			}
+			else
+				pl_info.powerup_flags &= ~PLAYER_FLAGS_CLOAKED;
+			if (Newdemo_game_mode & GM_MULTI_COOP)
+			{
+				const auto lo = get();
+				pl_info.mission.score = nd_meta_get_int(lo, get());
+			}
+			else
+			{
+				pl_info.net_killed_total = get();
+				pl_info.net_kills_total = get();
+			}
+		}
+	}
+	auto &Walls = LevelUniqueWallSubsystemState.Walls;
+	auto &vmwallptr = Walls.vmptr;
+	if (static_cast<unsigned>(get()) != Walls.get_count())
+		return;
+	range_for (const auto &&wp, vmwallptr)
+	{
+		auto &w = *wp;
+		const auto type_flags = get();
+		w.type = type_flags & 0xff;
+		w.flags = (type_flags >> 8) & 0xff;
+		w.state = get();
+		auto &side = vmsegptr(w.segnum)->unique_segment::sides[w.sidenum];
+		side.tmap_num = get();
+		side.tmap_num2 = get();
+	}
+}
+
+// Written just before ND_EVENT_EOF, so that a player can find it from
+// the end of the file.
+static void newdemo_write_keyframe_index()
+{
+	if (nd_record_v_keyframes.empty())
+		return;
+	std::vector<int16_t> index;
+	range_for (auto &k, nd_record_v_keyframes)
+	{
+		nd_meta_put_int(index, k.offset);
+		nd_meta_put_int(index, k.frame);
+		index.push_back(k.level);
+	}
+	const int offset = Newdemo_num_written;
+	nd_write_meta_stream(ND_META_INDEX, index);
+	nd_write_meta_chunk(ND_META_INDEX_FOOTER, static_cast<int16_t>(offset & 0xffff), static_cast<int16_t>(static_cast<uint32_t>(offset) >> 16));
+	nd_write_meta_chunk(0, 0, 0);
+}
+
+}
+
+// Demos recorded before keyframes were added, or cut by
+// newdemo_strip_frames, have no index and seek frame by frame instead.
+static void nd_read_keyframe_index()
+{
+	nd_playback_v_keyframes.clear();
+	if (shareware)
+		return;
+	const auto start = PHYSFS_tell(infile);
+	const auto size = PHYSFS_fileLength(infile);
+	int16_t byte_count;
+	PHYSFSX_fseek(infile, -4, SEEK_END);
+	nd_read_short(&byte_count);
+	// The footer and the event after it are the last before ND_EVENT_EOF
+	const auto footer = size - 4 - byte_count - 1 - 14;
+	if (!nd_playback_v_bad_read && byte_count > 0 && footer > start)
+	{
+		int8_t c = 0;
+		int16_t r = 0, a = 0, b = 0;
+		PHYSFS_seek(infile, footer);
+		nd_read_byte(&c);
+		nd_read_short(&r);
+		nd_read_short(&a);
+		nd_read_short(&b);
+		const auto offset = nd_meta_get_int(a, b);
+		if (!nd_playback_v_bad_read && c == ND_EVENT_PALETTE_EFFECT && r == ND_META_INDEX_FOOTER && offset > start && offset < footer)
+		{
+			std::vector<int16_t> index;
+			PHYSFS_seek(infile, offset);
+			nd_read_byte(&c);
+			nd_read_short(&r);
+			nd_read_short(&a);
+			nd_read_short(&b);
+			if (!nd_playback_v_bad_read && c == ND_EVENT_PALETTE_EFFECT && r == ND_META_INDEX && nd_read_meta_stream(ND_META_INDEX, a, b, index))
+				for (std::size_t i = 0; i + 5 <= index.size(); i += 5)
+				{
+					const nd_keyframe_entry k{nd_meta_get_int(index[i], index[i + 1]), nd_meta_get_int(index[i + 2], index[i + 3]), static_cast<int8_t>(index[i + 4])};
+					if (k.offset < start || k.offset >= offset)
+					{
+						nd_playback_v_keyframes.clear();
+						break;
+					}
+					nd_playback_v_keyframes.push_back(k);
+				}
+		}
+	}
+	nd_playback_v_bad_read = 0;
+	PHYSFS_seek(infile, start);
+}
+
 namespace dsx {
 void newdemo_record_start_demo()
 {
@@ -1117,6 +1649,13 @@ void newdemo_record_start_frame(fix frame_time )
 		return;
 	}
 
+	if (!nd_writer_flush())
+	{
+		nd_record_v_no_space=2;
+		newdemo_stop_recording();
+		return;
+	}
+
 	// Make demo recording waste a bit less space.
 	// First check if if at least REC_DELAY has passed since last recorded frame. If yes, record frame and set nd_record_v_recordframe true.
 	// nd_record_v_recordframe will be used for various other frame-by-frame events to drop some unnecessary bytes.
@@ -1145,12 +1684,16 @@ void newdemo_record_start_frame(fix frame_time )
 #endif
 		nd_record_v_frame_number -= nd_record_v_start_frame;
 
+		const int frame_offset = Newdemo_num_written;
+		const int frame_number = nd_record_v_frame_number;
 		nd_write_byte(ND_EVENT_START_FRAME);
 		nd_write_short(nd_record_v_framebytes_written - 1);        // from previous frame
 		nd_record_v_framebytes_written=3;
 		nd_write_int(nd_record_v_frame_number);
 		nd_record_v_frame_number++;
 		nd_write_int(frame_time);
+		if (frame_number >= nd_record_v_next_keyframe)
+			newdemo_record_keyframe(frame_offset, frame_number);
 	}
 	else
 	{
@@ -1160,6 +1703,100 @@ void newdemo_record_start_frame(fix frame_time )
 }
 }
 
+/*
+ * With -record-demo-delta, a record which has the same length as the
+ * last one written in full for the same signature is written as the
+ * bytes which differ from it.  Playback reads the base record from the
+ * file, so it does not matter in which order frames are played.
+ */
+static void nd_write_render_object(const vcobjptr_t obj)
+{
+	nd_write_byte(ND_EVENT_RENDER_OBJECT);
+	if (!CGameArg.SysRecordDemoDelta)
+	{
+		nd_write_object(obj);
+		return;
+	}
+	auto &buffer = nd_record_v_buffer;
+	const auto start = buffer.size();
+	const int offset = Newdemo_num_written;
+	nd_write_object(obj);
+	const std::size_t n = buffer.size() - start;
+	if (!n || n > UINT8_MAX)
+		return;
+	const uint8_t *const r = &buffer[start];
+	auto &base = nd_record_v_delta_bases[obj->signature.get()];
+	array<uint8_t, 5 + (UINT8_MAX + 7) / 8 + UINT8_MAX> delta{};
+	std::size_t used = 5 + (n + 7) / 8;
+	if (base.record.size() == n)
+		for (std::size_t i = 0; i != n; ++i)
+			if (r[i] != base.record[i])
+			{
+				delta[5 + (i >> 3)] |= 1 << (i & 7);
+				delta[used++] = r[i];
+			}
+	if (base.record.size() != n || used >= n)
+	{
+		// Keep the full record, and make it the base of later deltas
+		base.offset = offset;
+		base.record.assign(r, r + n);
+		return;
+	}
+	memcpy(&delta[0], &base.offset, sizeof(base.offset));
+	delta[4] = n;
+	buffer.resize(start - 1);
+	Newdemo_num_written -= n + 1;
+	nd_record_v_framebytes_written -= n + 1;
+	nd_write_byte(ND_EVENT_RENDER_OBJECT_DELTA);
+	newdemo_write(delta.data(), 1, used);
+}
+
+/*
+ * Rebuild the record of an ND_EVENT_RENDER_OBJECT_DELTA.  Returns its
+ * length, or 0 if it could not be read.
+ */
+static std::size_t nd_read_render_object_delta(array<uint8_t, UINT8_MAX> &record)
+{
+	int offset;
+	uint8_t n;
+	nd_read_int(&offset);
+	nd_read_byte(&n);
+	array<uint8_t, (UINT8_MAX + 7) / 8> mask;
+	newdemo_read(mask.data(), 1, (n + 7) / 8);
+	if (nd_playback_v_bad_read || !n)
+		return 0;
+	auto &cache = nd_playback_v_delta_bases;
+	auto i = cache.find(offset);
+	if (i == cache.end())
+	{
+		if (cache.size() >= ND_DELTA_BASE_CACHE_MAX)
+			cache.clear();
+		std::vector<uint8_t> base(n);
+		const auto here = PHYSFS_tell(infile);
+		if (!PHYSFS_seek(infile, offset))
+			return 0;
+		newdemo_read(base.data(), 1, n);
+		PHYSFS_seek(infile, here);
+		if (nd_playback_v_bad_read)
+			return 0;
+		i = cache.emplace(offset, std::move(base)).first;
+	}
+	auto &base = i->second;
+	if (base.size() != n)
+		return 0;
+	unsigned changed = 0;
+	for (std::size_t j = 0; j != n; ++j)
+		if (mask[j >> 3] & (1 << (j & 7)))
+			++changed;
+	array<uint8_t, UINT8_MAX> bytes;
+	newdemo_read(bytes.data(), 1, changed);
+	if (nd_playback_v_bad_read)
+		return 0;
+	for (std::size_t j = 0, k = 0; j != n; ++j)
+		record[j] = (mask[j >> 3] & (1 << (j & 7))) ? bytes[k++] : base[j];
+	return n;
+}
+
 namespace dsx {
 void newdemo_record_render_object(const vmobjptridx_t obj)
 {
@@ -1174,8 +1811,7 @@ void newdemo_record_render_object(const vmobjptridx_t obj)
 	nd_record_v_objs[obj] = 1;
 #endif
 	pause_game_world_time p;
-	nd_write_byte(ND_EVENT_RENDER_OBJECT);
-	nd_write_object(obj);
+	nd_write_render_object(obj);
 }
 }
 
@@ -1987,12 +2623,28 @@ static void newdemo_pop_ctrlcen_triggers()
 }
 
 namespace dsx {
+static void nd_stats_write_frame()
+{
+	auto &plrobj = get_local_plrobj();
+	auto &player_info = plrobj.ctype.player_info;
+	PHYSFSX_printf(nd_stats_file, "%i,%.3f,player,%i,%i,%i,%i\n", nd_stats_frame, nd_stats_time, Player_num, f2ir(plrobj.shields), f2ir(player_info.energy), player_info.mission.score);
+	range_for (const auto &&objp, vcobjptr)
+	{
+		if (objp->type != OBJ_PLAYER)
+			continue;
+		const auto &pos = objp->pos;
+		PHYSFSX_printf(nd_stats_file, "%i,%.3f,position,%i,%.2f,%.2f,%.2f\n", nd_stats_frame, nd_stats_time, get_player_id(objp), f2fl(pos.x), f2fl(pos.y), f2fl(pos.z));
+	}
+}
+
 static int newdemo_read_frame_information(int rewrite)
 {
 	int done, angle, volume;
 	sbyte c;
 
 	done = 0;
+	nd_stats_frame = nd_playback_v_framecount + 1;
+	nd_stats_time = f2fl(nd_recorded_total);
 
 	if (Newdemo_vcr_state != ND_STATE_PAUSED)
 		range_for (const auto &&segp, vmsegptr)
@@ -2015,8 +2667,9 @@ static int newdemo_read_frame_information(int rewrite)
 	while( !done ) {
 		nd_read_byte(&c);
 		if (nd_playback_v_bad_read) { done = -1; break; }
+		// A rewrite writes every object in full, since it moves the base records
 		if (rewrite && (c != ND_EVENT_EOF))
-			nd_write_byte(c);
+			nd_write_byte(c == ND_EVENT_RENDER_OBJECT_DELTA ? ND_EVENT_RENDER_OBJECT : c);
 
 		switch( c ) {
 
@@ -2030,6 +2683,12 @@ static int newdemo_read_frame_information(int rewrite)
 			if (nd_playback_v_bad_read) { done = -1; break; }
 			if (rewrite)
 			{
+				/* Without keyframe state, a seek to one of these
+				 * frames shows the objects at once and the rest as
+				 * later events change it.
+				 */
+				if (nd_rewrite_index && nd_playback_v_framecount >= nd_record_v_next_keyframe)
+					nd_add_keyframe_entry(Newdemo_num_written - 1, nd_playback_v_framecount, nd_rewrite_level);
 				nd_write_short(last_frame_length);
 				nd_record_v_framebytes_written = 3;
 				nd_write_int(nd_playback_v_framecount);
@@ -2096,11 +2755,29 @@ static int newdemo_read_frame_information(int rewrite)
 			break;
 
 		case ND_EVENT_RENDER_OBJECT:       // Followed by an object structure
+		case ND_EVENT_RENDER_OBJECT_DELTA:
 		{
+			array<uint8_t, UINT8_MAX> record;
+			std::size_t record_length = 0;
+			if (c == ND_EVENT_RENDER_OBJECT_DELTA && !(record_length = nd_read_render_object_delta(record)))
+			{
+				done = -1;
+				break;
+			}
 			const auto &&obj = obj_allocate(LevelUniqueObjectState);
 			if (obj==object_none)
 				break;
-			nd_read_object(obj);
+			if (record_length)
+			{
+				nd_playback_v_record = record.data();
+				nd_playback_v_record_end = record.data() + record_length;
+				nd_read_object(obj);
+				if (nd_playback_v_record != nd_playback_v_record_end)
+					nd_playback_v_bad_read = -1;
+				nd_playback_v_record = nd_playback_v_record_end = nullptr;
+			}
+			else
+				nd_read_object(obj);
 			if (nd_playback_v_bad_read) { done = -1; break; }
 			if (rewrite)
 			{
@@ -2288,6 +2965,7 @@ static int newdemo_read_frame_information(int rewrite)
 				nd_write_int(shot);
 #endif
 			}
+			nd_stats_event("trigger", segnum, side, objnum);
 
                         const auto &&segp = vmsegptridx(segnum);
                         /* Demo recording is buggy.  Descent records
@@ -2343,6 +3021,7 @@ static int newdemo_read_frame_information(int rewrite)
 				nd_write_int(hostage_number);
 				break;
 			}
+			nd_stats_event("hostage_rescued", hostage_number);
 			if (Newdemo_vcr_state != ND_STATE_PAUSED)
 				hostage_rescue();
 			break;
@@ -2390,6 +3069,7 @@ static int newdemo_read_frame_information(int rewrite)
 				nd_write_int(side);
 				break;
 			}
+			nd_stats_event("wall_toggle", segnum, side);
 			if (Newdemo_vcr_state != ND_STATE_PAUSED)
 				wall_toggle(vmwallptr, vmsegptridx(segnum), side);
 		}
@@ -2404,6 +3084,7 @@ static int newdemo_read_frame_information(int rewrite)
 				nd_write_int(Countdown_seconds_left);
 				break;
 			}
+			nd_stats_event("control_center_destroyed", Countdown_seconds_left);
 			if (!nd_playback_v_cntrlcen_destroyed) {
 				newdemo_pop_ctrlcen_triggers();
 				nd_playback_v_cntrlcen_destroyed = 1;
@@ -2420,6 +3101,12 @@ static int newdemo_read_frame_information(int rewrite)
 				nd_write_string(&(hud_msg[0]));
 				break;
 			}
+			if (nd_stats_file && Newdemo_vcr_state == ND_STATE_PLAYBACK)
+			{
+				// Keep the message within its quoted field
+				std::replace(std::begin(hud_msg), std::end(hud_msg), '"', '\'');
+				PHYSFSX_printf(nd_stats_file, "%i,%.3f,hud_message,\"%s\",0,0,0\n", nd_stats_frame, nd_stats_time, hud_msg);
+			}
 			if (Newdemo_vcr_state != ND_STATE_PAUSED)
 				HUD_init_message_literal( HM_DEFAULT, hud_msg );
 			break;
@@ -2455,6 +3142,23 @@ static int newdemo_read_frame_information(int rewrite)
 				nd_write_short(b);
 				break;
 			}
+			if (r == ND_META_KEYFRAME)
+			{
+				if (nd_playback_v_apply_keyframe)
+				{
+					nd_playback_v_apply_keyframe = 0;
+					std::vector<int16_t> kf;
+					if (!nd_read_meta_stream(ND_META_KEYFRAME, g, b, kf))
+					{
+						done = -1;
+						break;
+					}
+					nd_apply_keyframe(kf);
+				}
+				break;
+			}
+			if (r == ND_META_INDEX || r == ND_META_INDEX_FOOTER)
+				break;
 			PALETTE_FLASH_SET(r,g,b);
 			break;
 		}
@@ -2639,6 +3343,7 @@ static int newdemo_read_frame_information(int rewrite)
 				nd_write_byte(old_weapon);
 				break;
 			}
+			nd_stats_event("weapon", weapon_type, weapon_num);
 			auto &player_info = get_local_plrobj().ctype.player_info;
 			if ((Newdemo_vcr_state == ND_STATE_PLAYBACK) || (Newdemo_vcr_state == ND_STATE_FASTFORWARD) || (Newdemo_vcr_state == ND_STATE_ONEFRAMEFORWARD)) {
 				if (weapon_type == 0)
@@ -2788,6 +3493,7 @@ static int newdemo_read_frame_information(int rewrite)
 				auto &tmap_num2 = s0.unique_segment::sides[side].tmap_num2;
 				assert(tmap_num2 != 0);
 				tmap_num2 = vmsegptr(cseg)->unique_segment::sides[cside].tmap_num2 = tmap;
+				flush_fcd_cache();
 			}
 			break;
 		}
@@ -2801,6 +3507,7 @@ static int newdemo_read_frame_information(int rewrite)
 				nd_write_byte(pnum);
 				break;
 			}
+			nd_stats_event("cloak", pnum);
 			auto &player_info = get_local_plrobj().ctype.player_info;
 			if ((Newdemo_vcr_state == ND_STATE_REWINDING) || (Newdemo_vcr_state == ND_STATE_ONEFRAMEBACKWARD)) {
 				player_info.powerup_flags &= ~PLAYER_FLAGS_CLOAKED;
@@ -2821,6 +3528,7 @@ static int newdemo_read_frame_information(int rewrite)
 				nd_write_byte(pnum);
 				break;
 			}
+			nd_stats_event("decloak", pnum);
 
 			auto &player_info = get_local_plrobj().ctype.player_info;
 			if ((Newdemo_vcr_state == ND_STATE_REWINDING) || (Newdemo_vcr_state == ND_STATE_ONEFRAMEBACKWARD)) {
@@ -2842,6 +3550,7 @@ static int newdemo_read_frame_information(int rewrite)
 				nd_write_byte(pnum);
 				break;
 			}
+			nd_stats_event("death", pnum);
 			auto &player_info = vmobjptr(vcplayerptr(static_cast<unsigned>(pnum))->objnum)->ctype.player_info;
 			if ((Newdemo_vcr_state == ND_STATE_REWINDING) || (Newdemo_vcr_state == ND_STATE_ONEFRAMEBACKWARD))
 				player_info.net_killed_total--;
@@ -2861,6 +3570,7 @@ static int newdemo_read_frame_information(int rewrite)
 				nd_write_byte(kill);
 				break;
 			}
+			nd_stats_event("kill", pnum, kill);
 			auto &player_info = vmobjptr(vcplayerptr(static_cast<unsigned>(pnum))->objnum)->ctype.player_info;
 			if ((Newdemo_vcr_state == ND_STATE_REWINDING) || (Newdemo_vcr_state == ND_STATE_ONEFRAMEBACKWARD)) {
 				player_info.net_kills_total -= kill;
@@ -2902,6 +3612,7 @@ static int newdemo_read_frame_information(int rewrite)
 				nd_write_string(static_cast<const char *>(new_callsign));
 				break;
 			}
+			nd_stats_event("connect", pnum, new_player);
 			auto &plr = *vmplayerptr(static_cast<unsigned>(pnum));
 			auto &player_info = vmobjptr(plr.objnum)->ctype.player_info;
 			if ((Newdemo_vcr_state == ND_STATE_REWINDING) || (Newdemo_vcr_state == ND_STATE_ONEFRAMEBACKWARD)) {
@@ -2933,6 +3644,7 @@ static int newdemo_read_frame_information(int rewrite)
 				nd_write_byte(pnum);
 				break;
 			}
+			nd_stats_event("reconnect", pnum);
 			if ((Newdemo_vcr_state == ND_STATE_REWINDING) || (Newdemo_vcr_state == ND_STATE_ONEFRAMEBACKWARD))
 				vmplayerptr(static_cast<unsigned>(pnum))->connected = CONNECT_DISCONNECTED;
 			else if ((Newdemo_vcr_state == ND_STATE_PLAYBACK) || (Newdemo_vcr_state == ND_STATE_FASTFORWARD) || (Newdemo_vcr_state == ND_STATE_ONEFRAMEFORWARD))
@@ -2949,6 +3661,7 @@ static int newdemo_read_frame_information(int rewrite)
 				nd_write_byte(pnum);
 				break;
 			}
+			nd_stats_event("disconnect", pnum);
 #if defined(DXX_BUILD_DESCENT_I)
 			if ((Newdemo_vcr_state == ND_STATE_REWINDING) || (Newdemo_vcr_state == ND_STATE_ONEFRAMEBACKWARD))
 				vmplayerptr(static_cast<unsigned>(pnum))->connected = CONNECT_DISCONNECTED;
@@ -2975,6 +3688,7 @@ static int newdemo_read_frame_information(int rewrite)
 				nd_write_int(score);
 				break;
 			}
+			nd_stats_event("score", pnum, score);
 			auto &player_info = get_local_plrobj().ctype.player_info;
 			if ((Newdemo_vcr_state == ND_STATE_REWINDING) || (Newdemo_vcr_state == ND_STATE_ONEFRAMEBACKWARD))
 				player_info.mission.score -= score;
@@ -2995,6 +3709,7 @@ static int newdemo_read_frame_information(int rewrite)
 				nd_write_int(score);
 				break;
 			}
+			nd_stats_event("score", Player_num, score);
 			auto &player_info = get_local_plrobj().ctype.player_info;
 			if ((Newdemo_vcr_state == ND_STATE_REWINDING) || (Newdemo_vcr_state == ND_STATE_ONEFRAMEBACKWARD))
 				player_info.mission.score -= score;
@@ -3015,6 +3730,7 @@ static int newdemo_read_frame_information(int rewrite)
 				nd_write_short(new_ammo);
 				break;
 			}
+			nd_stats_event("primary_ammo", old_ammo, new_ammo);
 
 			unsigned short value;
 			// NOTE: Used (Primary_weapon==GAUSS_INDEX?VULCAN_INDEX:Primary_weapon) because game needs VULCAN_INDEX updated to show Gauss ammo
@@ -3046,6 +3762,7 @@ static int newdemo_read_frame_information(int rewrite)
 				nd_write_short(new_ammo);
 				break;
 			}
+			nd_stats_event("secondary_ammo", old_ammo, new_ammo);
 
 			auto &player_info = get_local_plrobj().ctype.player_info;
 			if ((Newdemo_vcr_state == ND_STATE_REWINDING) || (Newdemo_vcr_state == ND_STATE_ONEFRAMEBACKWARD))
@@ -3067,6 +3784,7 @@ static int newdemo_read_frame_information(int rewrite)
 				nd_write_byte(side);
 				break;
 			}
+			nd_stats_event("door_opening", segnum, side);
 			if ((Newdemo_vcr_state == ND_STATE_REWINDING) || (Newdemo_vcr_state == ND_STATE_ONEFRAMEBACKWARD)) {
 				const auto &&segp = vmsegptridx(segnum);
 				const auto &&csegp = vmsegptr(segp->children[side]);
@@ -3091,6 +3809,7 @@ static int newdemo_read_frame_information(int rewrite)
 				nd_write_byte(new_level);
 				break;
 			}
+			nd_stats_event("laser_level", old_level, new_level);
 			auto &player_info = get_local_plrobj().ctype.player_info;
 			if ((Newdemo_vcr_state == ND_STATE_REWINDING) || (Newdemo_vcr_state == ND_STATE_ONEFRAMEBACKWARD)) {
 				player_info.laser_level = stored_laser_level(old_level);
@@ -3155,6 +3874,7 @@ static int newdemo_read_frame_information(int rewrite)
 				uvl[2].l = (static_cast<int>(l2)) << 8;
 				uvl[3].l = (static_cast<int>(l3)) << 8;
 			}
+			flush_fcd_cache();
 			break;
 		}
 #endif
@@ -3168,6 +3888,7 @@ static int newdemo_read_frame_information(int rewrite)
 			{
 				nd_write_byte (new_level);
 				nd_write_byte (old_level);
+				nd_rewrite_level = new_level;
 #if defined(DXX_BUILD_DESCENT_I)
 				break;
 #elif defined(DXX_BUILD_DESCENT_II)
@@ -3178,6 +3899,7 @@ static int newdemo_read_frame_information(int rewrite)
 			{
 				if (Newdemo_vcr_state == ND_STATE_PAUSED)
 					break;
+				nd_stats_event("new_level", new_level, old_level);
 
 				pause_game_world_time p;
 				if ((Newdemo_vcr_state == ND_STATE_REWINDING) || (Newdemo_vcr_state == ND_STATE_ONEFRAMEBACKWARD))
@@ -3272,6 +3994,9 @@ static int newdemo_read_frame_information(int rewrite)
 		}
 	}
 
+	if (done == 1 && !rewrite && nd_stats_file && Newdemo_vcr_state == ND_STATE_PLAYBACK)
+		nd_stats_write_frame();
+
 	// Now set up cockpit and views according to what we read out. Note that the demo itself cannot determinate the right views since it does not use a good portion of the real game code.
 	if (nd_playback_v_dead)
 	{
@@ -3520,6 +4245,81 @@ static window_event_result newdemo_back_frames(int frames)
 	return window_event_result::handled;
 }
 
+namespace dsx {
+window_event_result newdemo_seek_keyframe(const int direction)
+{
+	const int frame = nd_playback_v_framecount;
+	if (nd_playback_v_keyframes.empty())
+	{
+		if (direction < 0)
+		{
+			if (nd_playback_v_framecount <= ND_KEYFRAME_INTERVAL)
+				return newdemo_goto_beginning();
+			if (nd_playback_v_at_eof)
+				PHYSFS_seek(infile, PHYSFS_tell(infile) + (shareware ? -2 : +11));
+			return newdemo_back_frames(ND_KEYFRAME_INTERVAL);
+		}
+		const int level = Current_level_num;
+		for (int i = 0; i < ND_KEYFRAME_INTERVAL && !nd_playback_v_at_eof; i++)
+			if (newdemo_read_frame_information(0) == -1 && !nd_playback_v_at_eof)
+			{
+				newdemo_stop_playback();
+				return window_event_result::close;
+			}
+		if (level != Current_level_num)
+			newdemo_pop_ctrlcen_triggers();
+		return window_event_result::handled;
+	}
+	const nd_keyframe_entry *target = nullptr;
+	if (direction < 0)
+	{
+		// Skip a keyframe that was only just passed, so that repeated
+		// presses keep going back
+		range_for (auto &k, nd_playback_v_keyframes)
+		{
+			if (k.frame + ND_KEYFRAME_INTERVAL / 4 >= frame)
+				break;
+			target = &k;
+		}
+		if (!target)
+			return newdemo_goto_beginning();
+	}
+	else
+	{
+		range_for (auto &k, nd_playback_v_keyframes)
+			if (k.frame > frame)
+			{
+				target = &k;
+				break;
+			}
+		if (!target)
+			return newdemo_goto_end(0);
+	}
+	const auto vcr_state = Newdemo_vcr_state;
+	PHYSFS_seek(infile, target->offset);
+	nd_playback_v_at_eof = 0;
+	Newdemo_vcr_state = ND_STATE_PLAYBACK;
+	// The first read stops after the ND_EVENT_START_FRAME, the second
+	// reads the events of the keyframe.
+	auto r = newdemo_read_frame_information(0);
+	if (r == 1)
+	{
+		nd_playback_v_apply_keyframe = 1;
+		r = newdemo_read_frame_information(0);
+		nd_playback_v_apply_keyframe = 0;
+	}
+	Newdemo_vcr_state = (vcr_state == ND_STATE_PAUSED) ? ND_STATE_PAUSED : ND_STATE_PLAYBACK;
+	if (r == -1)
+	{
+		newdemo_stop_playback();
+		return window_event_result::close;
+	}
+	nd_playback_total = nd_recorded_total;
+	nd_playback_v_style = NORMAL_PLAYBACK;
+	return window_event_result::handled;
+}
+}
+
 /*
  *  routine to interpolate the viewer position.  the current position is
  *  stored in the Viewer object.  Save this position, and read the next
@@ -3557,52 +4357,51 @@ static window_event_result interpolate_frame(fix d_play, fix d_recorded)
 	if (InterpolStep <= 0)
 	{
 		range_for (auto &i, partial_range(cur_objs, num_cur_objs)) {
-			range_for (const auto &&objp, vmobjptr)
-			{
-				if (i.signature == objp->signature) {
-					sbyte render_type = i.render_type;
-					fix delta_x, delta_y, delta_z;
-
-					//  Extract the angles from the object orientation matrix.
-					//  Some of this code taken from ai_turn_towards_vector
-					//  Don't do the interpolation on certain render types which don't use an orientation matrix
-
-					if (!((render_type == RT_LASER) || (render_type == RT_FIREBALL) || (render_type == RT_POWERUP))) {
-						vms_vector  fvec1, fvec2, rvec1, rvec2;
-						fix         mag1;
-
-						fvec1 = i.orient.fvec;
-						vm_vec_scale(fvec1, F1_0-factor);
-						fvec2 = objp->orient.fvec;
-						vm_vec_scale(fvec2, factor);
-						vm_vec_add2(fvec1, fvec2);
-						mag1 = vm_vec_normalize_quick(fvec1);
-						if (mag1 > F1_0/256) {
-							rvec1 = i.orient.rvec;
-							vm_vec_scale(rvec1, F1_0-factor);
-							rvec2 = objp->orient.rvec;
-							vm_vec_scale(rvec2, factor);
-							vm_vec_add2(rvec1, rvec2);
-							vm_vec_normalize_quick(rvec1); // Note: Doesn't matter if this is null, if null, vm_vector_2_matrix will just use fvec1
-							vm_vector_2_matrix(i.orient, fvec1, nullptr, &rvec1);
-						}
+			const auto &&found = newdemo_find_object(i.signature);
+			if (found != object_none) {
+				const auto &&objp = vmobjptr(found.get_unchecked_index());
+				sbyte render_type = i.render_type;
+				fix delta_x, delta_y, delta_z;
+
+				//  Extract the angles from the object orientation matrix.
+				//  Some of this code taken from ai_turn_towards_vector
+				//  Don't do the interpolation on certain render types which don't use an orientation matrix
+
+				if (!((render_type == RT_LASER) || (render_type == RT_FIREBALL) || (render_type == RT_POWERUP))) {
+					vms_vector  fvec1, fvec2, rvec1, rvec2;
+					fix         mag1;
+
+					fvec1 = i.orient.fvec;
+					vm_vec_scale(fvec1, F1_0-factor);
+					fvec2 = objp->orient.fvec;
+					vm_vec_scale(fvec2, factor);
+					vm_vec_add2(fvec1, fvec2);
+					mag1 = vm_vec_normalize_quick(fvec1);
+					if (mag1 > F1_0/256) {
+						rvec1 = i.orient.rvec;
+						vm_vec_scale(rvec1, F1_0-factor);
+						rvec2 = objp->orient.rvec;
+						vm_vec_scale(rvec2, factor);
+						vm_vec_add2(rvec1, rvec2);
+						vm_vec_normalize_quick(rvec1); // Note: Doesn't matter if this is null, if null, vm_vector_2_matrix will just use fvec1
+						vm_vector_2_matrix(i.orient, fvec1, nullptr, &rvec1);
 					}
+				}
 
-					// Interpolate the object position.  This is just straight linear
-					// interpolation.
+				// Interpolate the object position.  This is just straight linear
+				// interpolation.
 
-					delta_x = objp->pos.x - i.pos.x;
-					delta_y = objp->pos.y - i.pos.y;
-					delta_z = objp->pos.z - i.pos.z;
+				delta_x = objp->pos.x - i.pos.x;
+				delta_y = objp->pos.y - i.pos.y;
+				delta_z = objp->pos.z - i.pos.z;
 
-					delta_x = fixmul(delta_x, factor);
-					delta_y = fixmul(delta_y, factor);
-					delta_z = fixmul(delta_z, factor);
+				delta_x = fixmul(delta_x, factor);
+				delta_y = fixmul(delta_y, factor);
+				delta_z = fixmul(delta_z, factor);
 
-					i.pos.x += delta_x;
-					i.pos.y += delta_y;
-					i.pos.z += delta_z;
-				}
+				i.pos.x += delta_x;
+				i.pos.y += delta_y;
+				i.pos.z += delta_z;
 			}
 		}
 		InterpolStep = fl2f(.01);
@@ -3722,6 +4521,14 @@ window_event_result newdemo_playback_one_frame()
 		} else
 			Newdemo_vcr_state = ND_STATE_PAUSED;
 	}
+	else if (nd_stats_file && Newdemo_vcr_state == ND_STATE_PLAYBACK) {
+		// Analysis reads one recorded frame per game frame, however
+		// long it took to record.
+		if (newdemo_read_frame_information(0) == -1) {
+			newdemo_stop_playback();
+			return window_event_result::close;
+		}
+	}
 	else {
 
 		//  First, uptate the total playback time to date.  Then we check to see
@@ -3781,13 +4588,12 @@ window_event_result newdemo_playback_one_frame()
 					//  interpolated position and orientation can be preserved.
 
 					range_for (auto &i, partial_const_range(cur_objs, 1 + num_objs)) {
-						range_for (const auto &&objp, vmobjptr)
+						const auto &&objp = newdemo_find_object(i.signature);
+						if (objp != object_none)
 						{
-							if (i.signature == objp->signature) {
-								objp->orient = i.orient;
-								objp->pos = i.pos;
-								break;
-							}
+							auto &o = *vmobjptr(objp.get_unchecked_index());
+							o.orient = i.orient;
+							o.pos = i.pos;
 						}
 					}
 					d_recorded += nd_recorded_time;
@@ -3820,6 +4626,10 @@ window_event_result newdemo_playback_one_frame()
 void newdemo_start_recording()
 {
 	Newdemo_num_written = 0;
+	nd_record_v_keyframes.clear();
+	nd_record_v_keyframe_interval = ND_KEYFRAME_INTERVAL;
+	nd_record_v_next_keyframe = 0;
+	nd_record_v_delta_bases.clear();
 	nd_record_v_no_space=0;
 	Newdemo_state = ND_STATE_RECORDING;
 
@@ -3833,7 +4643,10 @@ void newdemo_start_recording()
 		nm_messagebox(NULL, 1, TXT_OK, "Cannot open demo temp file");
 	}
 	else
+	{
+		nd_writer_start();
 		newdemo_record_start_demo();
+	}
 }
 
 static void newdemo_write_end()
@@ -4002,9 +4815,12 @@ void newdemo_stop_recording()
 	if (!nd_record_v_no_space)
 	{
 		newdemo_record_oneframeevent_update(0);
+		newdemo_write_keyframe_index();
 		newdemo_write_end();
 	}
 
+	if (!nd_writer_stop() && !nd_record_v_no_space)
+		nd_record_v_no_space=2;
 	outfile.reset();
 	Newdemo_state = ND_STATE_NORMAL;
 	gr_palette_load( gr_palette );
@@ -4122,6 +4938,7 @@ void newdemo_start_playback(const char * filename)
 	}
 
 	infile = PHYSFSX_openReadBuffered(filename2);
+	nd_playback_v_delta_bases.clear();
 
 	if (!infile) {
 		return;
@@ -4138,6 +4955,20 @@ void newdemo_start_playback(const char * filename)
 		infile.reset();
 		return;
 	}
+	nd_read_keyframe_index();
+	if (!CGameArg.SysDemoStats.empty())
+	{
+		char statspath[PATH_MAX+FILENAME_LEN];
+		change_filename_extension(statspath, filename2, "csv");
+		if ((nd_stats_file = PHYSFSX_openWriteBuffered(statspath)))
+			PHYSFSX_puts_literal(nd_stats_file, "frame,time,event,a,b,c,d\n");
+	}
+	if (!CGameArg.SysTimeDemo.empty())
+	{
+		char reportpath[PATH_MAX+FILENAME_LEN];
+		change_filename_extension(reportpath, filename2, "json");
+		profile_timedemo_begin(reportpath);
+	}
 
 	Game_mode = GM_NORMAL;
 	Newdemo_state = ND_STATE_PLAYBACK;
@@ -4173,6 +5004,7 @@ namespace dsx {
 void newdemo_stop_playback()
 {
 	infile.reset();
+	nd_stats_file.reset();
 	Newdemo_state = ND_STATE_NORMAL;
 	change_playernum_to(0);             //this is reality
 	get_local_player().callsign = nd_playback_v_save_callsign;
@@ -4185,6 +5017,13 @@ void newdemo_stop_playback()
 	
 	// Required for the editor
 	obj_relink_all();
+	profile_timedemo_end();
+	// A headless run, a video capture or a timedemo ends with its demo
+	if (CGameArg.SysHeadless || !CGameArg.SysDemoVideo.empty() || !CGameArg.SysTimeDemo.empty())
+	{
+		CGameArg.SysAutoDemo = false;
+		Quitting = 1;
+	}
 }
 }
 
@@ -4200,6 +5039,7 @@ int newdemo_swap_endian(const char *filename)
 		return 0;
 
 	infile = PHYSFSX_openReadBuffered(inpath);
+	nd_playback_v_delta_bases.clear();
 	if (!infile)
 		goto read_error;
 
@@ -4216,21 +5056,24 @@ int newdemo_swap_endian(const char *filename)
 	swap_endian = 1;
 	nd_playback_v_at_eof = 0;
 	Newdemo_state = ND_STATE_NORMAL;	// not doing anything special really
+	nd_writer_start();
 
 	if (newdemo_read_demo_start(PURPOSE_REWRITE)) {
+		nd_writer_stop();
 		infile.reset();
 		outfile.reset();
 		swap_endian = 0;
 		return 0;
 	}
 
-	while (newdemo_read_frame_information(1) == 1) {}	// rewrite all frames
+	while (newdemo_read_frame_information(1) == 1)	// rewrite all frames
+		nd_writer_flush();
 
 	newdemo_goto_end(1);	// get end of demo data
 	newdemo_write_end();	// and write it
 
 	swap_endian = 0;
-	complete = nd_playback_v_demosize == Newdemo_num_written;
+	complete = nd_writer_stop() && nd_playback_v_demosize == Newdemo_num_written;
 	infile.reset();
 	outfile.reset();
 
@@ -4254,6 +5097,114 @@ read_error:
 	return nd_playback_v_at_eof;
 }
 
+/* Rewrite demo inpath to DEMO_FILENAME frame by frame, as
+ * newdemo_swap_endian does, but without swapping.  If index, add a seek
+ * index unless the demo has one.  Returns a word for the report.
+ */
+static const char *nd_batch_rewrite(const char *const inpath, const bool index, int &frames)
+{
+	infile = PHYSFSX_openReadBuffered(inpath);
+	nd_playback_v_delta_bases.clear();
+	if (!infile)
+		return "unreadable";
+	nd_playback_v_demosize = PHYSFS_fileLength(infile);
+	outfile = PHYSFSX_openWriteBuffered(DEMO_FILENAME);
+	if (!outfile)
+	{
+		infile.reset();
+		return "write_error";
+	}
+	Newdemo_num_written = 0;
+	nd_playback_v_bad_read = 0;
+	nd_playback_v_at_eof = 0;
+	Newdemo_state = ND_STATE_NORMAL;
+	nd_record_v_keyframes.clear();
+	nd_record_v_keyframe_interval = ND_KEYFRAME_INTERVAL;
+	nd_record_v_next_keyframe = 0;
+	nd_writer_start();
+	const char *result;
+	if (newdemo_read_demo_start(PURPOSE_REWRITE))
+		result = "corrupt";
+	else if (nd_read_keyframe_index(), index && !nd_playback_v_keyframes.empty())
+		result = "indexed";
+	else
+	{
+		nd_rewrite_index = index;
+		nd_rewrite_level = Current_level_num;
+		while (newdemo_read_frame_information(1) == 1)
+		{
+			++frames;
+			nd_writer_flush();
+		}
+		nd_rewrite_index = false;
+		if (nd_playback_v_at_eof)
+			result = "corrupt";
+		else
+		{
+			if (index)
+				newdemo_write_keyframe_index();
+			newdemo_goto_end(1);
+			newdemo_write_end();
+			result = nullptr;
+		}
+	}
+	if (!nd_writer_stop() && !result)
+		result = "write_error";
+	infile.reset();
+	if (!outfile.close() && !result)
+		result = "write_error";
+	outfile.reset();
+	/* A demo which reads back cleanly rewrites to the same bytes. */
+	if (!result && !index && nd_playback_v_demosize != Newdemo_num_written)
+		result = "corrupt";
+	return result;
+}
+
+/* Run operation op, verify or index, over every demo in DEMO_DIR, and
+ * list the outcome for each in DEMO_DIR "batch.csv".  Demos are
+ * processed one at a time, since reading a demo uses the game state.
+ */
+void newdemo_batch(const char *const op)
+{
+	const bool index = !d_stricmp(op, "index");
+	if (!index && d_stricmp(op, "verify"))
+	{
+		con_printf(CON_URGENT, "DXX-Rebirth: unknown -demo_batch operation \"%s\"", op);
+		return;
+	}
+	auto report = PHYSFSX_openWriteBuffered(DEMO_DIR "batch.csv");
+	if (!report)
+	{
+		con_printf(CON_URGENT, "DXX-Rebirth: cannot write " DEMO_DIR "batch.csv: %s", PHYSFS_getLastError());
+		return;
+	}
+	PHYSFSX_puts_literal(report, "demo,result,frames\n");
+	const auto tmpname = &DEMO_FILENAME[sizeof(DEMO_DIR) - 1];
+	range_for (const auto i, PHYSFSX_findFiles(DEMO_DIR, demo_file_extensions))
+	{
+		if (!d_stricmp(i, tmpname))
+			continue;
+		char inpath[PATH_MAX+FILENAME_LEN];
+		snprintf(inpath, sizeof(inpath), DEMO_DIR "%s", i);
+		int frames = 0;
+		auto result = nd_batch_rewrite(inpath, index, frames);
+		if (!result)
+		{
+			if (index)
+			{
+				char bakpath[PATH_MAX+FILENAME_LEN];
+				change_filename_extension(bakpath, inpath, DEMO_BACKUP_EXT);
+				result = PHYSFSX_rename(inpath, bakpath) && PHYSFSX_rename(DEMO_FILENAME, inpath) ? "ok" : "write_error";
+			}
+			else
+				result = "ok";
+		}
+		PHYSFS_delete(DEMO_FILENAME);
+		PHYSFSX_printf(report, "%s,%s,%i\n", i, result, frames);
+	}
+	Newdemo_state = ND_STATE_NORMAL;
+}
+
 #ifndef NDEBUG
 
 #define BUF_SIZE 16384
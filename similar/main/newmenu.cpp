@@ -105,6 +105,7 @@ struct newmenu : embed_window_pointer_t
 	int				mouse_state, dblclick_flag;
 	int				*rval;			// Pointer to return value (for polling newmenus)
 	void			*userdata;		// For whatever - like with window system
+	uint32_t		drawn_state;	// newmenu_redraw_state() as of the last draw
 	partial_range_t<newmenu_item *> item_range()
 	{
 		return unchecked_partial_range(items, nitems);
@@ -1413,6 +1414,65 @@ static void newmenu_create_structure( newmenu *menu )
 	gr_set_current_canvas(save_canvas);
 }
 
+namespace {
+
+// FNV-1a hash of everything that decides what a menu looks like, so that
+// idle menus can tell whether anything changed since they were drawn.
+class redraw_state
+{
+	uint32_t h = 2166136261u;
+	void step(const uint8_t c)
+	{
+		h = (h ^ c) * 16777619u;
+	}
+public:
+	void add(const uint32_t v)
+	{
+		step(v);
+		step(v >> 8);
+		step(v >> 16);
+		step(v >> 24);
+	}
+	void add(const char *s)
+	{
+		if (!s)
+			return step(0);
+		for (; *s; ++s)
+			step(*s);
+		step(0);
+	}
+	uint32_t value() const
+	{
+		return h;
+	}
+};
+
+}
+
+static uint32_t newmenu_redraw_state(const newmenu *const menu)
+{
+	redraw_state r;
+	r.add(menu->citem);
+	r.add(menu->scroll_offset);
+	r.add(menu->title);
+	r.add(menu->subtitle);
+	for (int i = menu->scroll_offset; i < menu->max_displayable + menu->scroll_offset; ++i)
+	{
+		auto &item = menu->items[i];
+		r.add(item.type);
+		r.add(item.value);
+		r.add(item.text);
+	}
+	if (!menu->all_text)
+	{
+		// The cursor of the input box being edited blinks
+		auto &item = menu->items[menu->citem];
+		if (item.type == NM_TYPE_INPUT || (item.type == NM_TYPE_INPUT_MENU && item.nm_private_imenu.group))
+			r.add(!!(timer_query() & 0x8000));
+	}
+	return r.value();
+}
+
 static window_event_result newmenu_draw(window *wind, newmenu *menu)
 {
 	grs_canvas &menu_canvas = window_get_canvas(*wind);
@@ -1488,12 +1548,17 @@ static window_event_result newmenu_draw(window *wind, newmenu *menu)
 			(*menu->subfunction)(menu, d_event{EVENT_NEWMENU_DRAW}, menu->userdata);
 
 	gr_set_current_canvas(save_canvas);
+	menu->drawn_state = newmenu_redraw_state(menu);
 
 	return window_event_result::handled;
 }
 
 static window_event_result newmenu_handler(window *wind,const d_event &event, newmenu *menu)
 {
+	// Catch changes made outside of input handling, such as network
+	// status updates from the subfunction
+	if (event.type == EVENT_IDLE && newmenu_redraw_state(menu) != menu->drawn_state)
+		window_request_redraw();
 	if (menu->subfunction)
 	{
 		int rval = (*menu->subfunction)(menu, event, menu->userdata);
@@ -1599,6 +1664,7 @@ newmenu *newmenu_do4( const char * title, const char * subtitle, uint_fast32_t n
 		delete menu;
 		return NULL;
 	}
+	wind->set_redraw_on_demand(true);
 	return menu;
 }
 }
@@ -1692,6 +1758,7 @@ struct listbox : embed_window_pointer_t
 	int mouse_state;
 	marquee::ptr marquee;
 	void *userdata;
+	uint32_t drawn_state;	// listbox_redraw_state() as of the last draw
 };
 
 window *listbox_get_window(listbox *const lb)
@@ -2014,6 +2081,21 @@ static void listbox_create_structure( listbox *lb)
 	lb->fntscaley = FNTScaleY;
 }
 
+static uint32_t listbox_redraw_state(const listbox *const lb)
+{
+	redraw_state r;
+	r.add(lb->citem);
+	r.add(lb->first_item);
+	r.add(lb->nitems);
+	r.add(lb->title);
+	for (unsigned i = lb->first_item; i < lb->first_item + lb->items_on_screen && i < lb->nitems; ++i)
+		r.add(lb->item[i]);
+	// Scrolling marquee text changes on its own
+	if (lb->marquee)
+		r.add(timer_query() / (F1_0 / 3));
+	return r.value();
+}
+
 static window_event_result listbox_draw(window *, listbox *lb)
 {
 	if (lb->swidth != SWIDTH || lb->sheight != SHEIGHT || lb->fntscalex != FNTScaleX || lb->fntscaley != FNTScaleY)
@@ -2089,6 +2171,7 @@ static window_event_result listbox_draw(window *, listbox *lb)
 		}
 	}
 
+	lb->drawn_state = listbox_redraw_state(lb);
 		if ( lb->listbox_callback )
 			return (*lb->listbox_callback)(lb, d_event{EVENT_NEWMENU_DRAW}, lb->userdata);
 	return window_event_result::handled;
@@ -2096,6 +2179,8 @@ static window_event_result listbox_draw(window *, listbox *lb)
 
 static window_event_result listbox_handler(window *wind,const d_event &event, listbox *lb)
 {
+	if (event.type == EVENT_IDLE && listbox_redraw_state(lb) != lb->drawn_state)
+		window_request_redraw();
 	if (lb->listbox_callback)
 	{
 		auto rval = (*lb->listbox_callback)(lb, event, lb->userdata);
@@ -2161,5 +2246,7 @@ listbox *newmenu_listbox1(const char *const title, const uint_fast32_t nitems, c
 	{
 		lb.reset();
 	}
+	else
+		wind->set_redraw_on_demand(true);
 	return lb.release();
 }
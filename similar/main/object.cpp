@@ -623,6 +623,15 @@ void create_small_fireball_on_object(const vmobjptridx_t objp, fix size_scale, i
 
 // -----------------------------------------------------------------------------
 //	Render an object.  Calls one of several routines based on type
+void render_object_outside_view(const vmobjptridx_t obj)
+{
+	if (obj == Viewer)
+		return;
+	//a robot is still "warned" if it is being shot at
+	if (obj->render_type == RT_POLYOBJ && obj->type == OBJ_ROBOT)
+		set_robot_location_info(obj);
+}
+
 void render_object(grs_canvas &canvas, const vmobjptridx_t obj)
 {
 	if (unlikely(obj == Viewer))
@@ -945,6 +954,7 @@ imobjptridx_t obj_allocate(d_level_unique_object_state &LevelUniqueObjectState)
 		return object_none;
 
 	const auto objnum = LevelUniqueObjectState.free_obj_list[LevelUniqueObjectState.num_objects++];
+	++ LevelUniqueObjectState.allocations;
 	if (objnum >= Objects.get_count())
 	{
 		Objects.set_count(objnum + 1);
@@ -27,6 +27,8 @@ COPYRIGHT 1993-1999 PARALLAX SOFTWARE CORPORATION.  ALL RIGHTS RESERVED.
 #include <stdlib.h>
 #include <math.h>
 #include <string.h>
+#include <algorithm>
+#include <vector>
 
 #include "pstypes.h"
 #include "inferno.h"
@@ -37,6 +39,7 @@ COPYRIGHT 1993-1999 PARALLAX SOFTWARE CORPORATION.  ALL RIGHTS RESERVED.
 #include "gamemine.h"
 #include "dxxerror.h"
 #include "console.h"
+#include "profile.h"
 #include "gameseg.h"
 #include "game.h"
 #include "piggy.h"
@@ -57,11 +60,22 @@ COPYRIGHT 1993-1999 PARALLAX SOFTWARE CORPORATION.  ALL RIGHTS RESERVED.
 #include "fuelcen.h"
 #include "mission.h"
 #include "ai.h"
+#include "digi.h"
 
 #include "compiler-range_for.h"
 #include "partial_range.h"
 #include "segiter.h"
 
+/* Read (under -lazysounds) and convert the sounds this level can play
+ * now instead of when they are first heard.
+ */
+static void paging_touch_sound(const int game_sound)
+{
+	const auto soundnum = digi_xlat_sound(game_sound);
+	if (soundnum >= 0)
+		digi_prefetch_sound(soundnum);
+}
+
 static void paging_touch_vclip(const vclip &vc, const unsigned line)
 #define paging_touch_vclip(V)	paging_touch_vclip(V, __LINE__)
 {
@@ -84,6 +98,7 @@ static void paging_touch_vclip(const vclip &vc, const unsigned line)
 	{
 		PIGGY_PAGE_IN(i);
 	}
+	paging_touch_sound(vc.sound_num);
 }
 
 static void paging_touch_wall_effects(const d_eclip_array &Effects, const Textures_array &Textures, const d_vclip_array &Vclip, const int tmap_num)
@@ -108,6 +123,36 @@ static void paging_touch_wall_effects(const d_eclip_array &Effects, const Textur
 	}
 }
 
+/* Number of bitmaps shown for wall texture `tmap_num`: the frames of
+ * the effect which animates it, or 1 if none does.
+ */
+static unsigned paging_wall_texture_frames(const d_eclip_array &Effects, const int tmap_num)
+{
+	range_for (auto &i, partial_const_range(Effects, Num_effects))
+		if (i.changing_wall_texture == tmap_num)
+			return std::max(i.vc.num_frames, 1u);
+	return 1;
+}
+
+/* Count the merged textures which the sides of the mine can show, so
+ * that the texmerge cache can hold all of them before they are merged.
+ * Each animation frame of either texture is merged separately.
+ */
+static unsigned paging_count_merged_textures(const d_eclip_array &Effects, const fvcsegptr &vcsegptr)
+{
+	std::vector<uint32_t> pairs;
+	range_for (const unique_segment &seg, vcsegptr)
+		range_for (auto &side, seg.sides)
+			if (const auto tmap2 = side.tmap_num2)
+				pairs.emplace_back((static_cast<uint32_t>(side.tmap_num) << 16) | tmap2);
+	std::sort(pairs.begin(), pairs.end());
+	pairs.erase(std::unique(pairs.begin(), pairs.end()), pairs.end());
+	unsigned count = 0;
+	range_for (const auto p, pairs)
+		count += paging_wall_texture_frames(Effects, p >> 16) * paging_wall_texture_frames(Effects, p & 0x3fff);
+	return count;
+}
+
 static void paging_touch_object_effects( int tmap_num )
 {
 	range_for (auto &i, partial_const_range(Effects, Num_effects))
@@ -141,6 +186,9 @@ static void paging_touch_weapon(const d_vclip_array &Vclip, const weapon_info &w
 		PIGGY_PAGE_IN(weapon.picture);
 	}		
 	
+	paging_touch_sound(weapon.flash_sound);
+	paging_touch_sound(weapon.robot_hit_sound);
+	paging_touch_sound(weapon.wall_hit_sound);
 	if (weapon.flash_vclip > -1)
 		paging_touch_vclip(Vclip[weapon.flash_vclip]);
 	if (weapon.wall_hit_vclip > -1)
@@ -186,6 +234,15 @@ static void paging_touch_robot(const d_level_shared_robot_info_state::d_robot_in
 		paging_touch_vclip(Vclip[ri.exp1_vclip_num]);
 	if (ri.exp2_vclip_num > -1)
 		paging_touch_vclip(Vclip[ri.exp2_vclip_num]);
+	paging_touch_sound(ri.exp1_sound_num);
+	paging_touch_sound(ri.exp2_sound_num);
+	paging_touch_sound(ri.see_sound);
+	paging_touch_sound(ri.attack_sound);
+	paging_touch_sound(ri.claw_sound);
+#if defined(DXX_BUILD_DESCENT_II)
+	paging_touch_sound(ri.taunt_sound);
+	paging_touch_sound(ri.deathroll_sound);
+#endif
 
 	// Page in his weapons
 	paging_touch_weapon(Vclip, Weapon_info, ri.weapon_type);
@@ -320,6 +377,8 @@ static void paging_touch_walls(const Textures_array &Textures, const wall_animat
 			const auto &anim = WallAnims[w.clip_num];
 			range_for (auto &j, partial_range(anim.frames, anim.num_frames))
 				PIGGY_PAGE_IN(Textures[j]);
+			paging_touch_sound(anim.open_sound);
+			paging_touch_sound(anim.close_sound);
 		}
 	}
 }
@@ -327,12 +386,14 @@ static void paging_touch_walls(const Textures_array &Textures, const wall_animat
 namespace dsx {
 void paging_touch_all(const d_vclip_array &Vclip)
 {
+	const trace_scope trace_phase("paging_touch_all");
 	pause_game_world_time p;
 
 #if defined(DXX_BUILD_DESCENT_I)
 	show_boxed_message(TXT_LOADING, 0);
 #endif
 	auto &Robot_info = LevelSharedRobotInfoState.Robot_info;
+	texmerge_reserve(paging_count_merged_textures(Effects, vcsegptr));
 	range_for (const auto &&segp, vcsegptr)
 	{
 		paging_touch_segment(Effects, Robot_info, Textures, Vclip, Weapon_info, vcobjptridx, vcsegptr, segp);
@@ -345,6 +406,7 @@ void paging_touch_all(const d_vclip_array &Vclip)
 	{
 		if ( s.vclip_num > -1 )	
 			paging_touch_vclip(Vclip[s.vclip_num]);
+		paging_touch_sound(s.hit_sound);
 	}
 
 	range_for (auto &w, partial_const_range(Weapon_info, N_weapon_types))
@@ -370,3 +432,57 @@ void paging_touch_all(const d_vclip_array &Vclip)
 	reset_cockpit();		//force cockpit redraw next time
 }
 }
+
+namespace {
+
+//	How many portals beyond the given segments to look, and how many
+//	bitmaps to read per call, so that prefetching never costs a frame.
+constexpr unsigned paging_prefetch_depth = 3;
+constexpr unsigned paging_prefetch_budget = 4;
+
+}
+
+namespace dsx {
+void paging_prefetch_beyond(const partial_range_t<const segnum_t *> segments)
+{
+	static std::vector<segnum_t> current, next;
+	visited_segment_bitarray_t visited;
+	current.clear();
+	range_for (const auto segnum, segments)
+		if (segnum != segment_none && !visited[segnum])
+		{
+			visited[segnum] = true;
+			current.emplace_back(segnum);
+		}
+	unsigned budget = paging_prefetch_budget;
+	const auto prefetch = [&budget](const bitmap_index bi) {
+		if (piggy_bitmap_prefetch(bi))
+			--budget;
+		return budget;
+	};
+	for (unsigned depth = 0; depth != paging_prefetch_depth && !current.empty(); ++depth)
+	{
+		next.clear();
+		range_for (const auto segnum, current)
+		{
+			const auto &&segp = vcsegptr(segnum);
+			range_for (const auto ch, segp->children)
+			{
+				if (!IS_CHILD(ch) || visited[ch])
+					continue;
+				visited[ch] = true;
+				next.emplace_back(ch);
+				range_for (auto &uside, vcsegptr(ch)->unique_segment::sides)
+				{
+					if (!prefetch(Textures[uside.tmap_num]))
+						return;
+					if (const auto tmap2 = uside.tmap_num2)
+						if (!prefetch(Textures[tmap2 & 0x3FFF]))
+							return;
+				}
+			}
+		}
+		std::swap(current, next);
+	}
+}
+}
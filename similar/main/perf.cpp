@@ -0,0 +1,155 @@
+/*
+ * This file is part of the DXX-Rebirth project <https://www.dxx-rebirth.com/>.
+ * It is copyright by its individual contributors, as recorded in the
+ * project's Git history.  See COPYING.txt at the top level for license
+ * terms and a link to the Git history.
+ */
+/*
+ *
+ * Console variables for the performance settings, and the perf_report
+ * command
+ *
+ */
+
+#include <string>
+
+#include "perf.h"
+#include "args.h"
+#include "cmd.h"
+#include "console.h"
+#include "cvar.h"
+#include "game.h"
+#include "gameseg.h"
+#include "jobs.h"
+#include "profile.h"
+#include "render.h"
+#include "render_state.h"
+#include "rle.h"
+#include "texmerge.h"
+#if DXX_USE_OGL
+#include "ogl_init.h"
+#endif
+
+#include "compiler-array.h"
+#include "compiler-range_for.h"
+
+/* Each cvar keeps the setting it controls in step: setting the cvar
+ * from the console changes the setting, clamped to its range.  Settings
+ * which are only read while loading, such as -lowmem, are not here,
+ * and neither are fixed table sizes such as that of the
+ * find_connected_distance cache.
+ */
+
+namespace dsx {
+
+namespace {
+
+struct perf_cvar
+{
+	cvar_t cvar;
+	int minimum, maximum;
+	int (*get)();
+	void (*set)(int);
+};
+
+}
+
+static void perf_cvar_changed(cvar_t &);
+
+#define DXX_PERF_CVAR(NAME, MINIMUM, MAXIMUM, GET, SET)	\
+	{{NAME, {}, CVAR_NONE, 0, 0, perf_cvar_changed}, MINIMUM, MAXIMUM, []() -> int { return GET; }, [](const int v) { SET; }}
+
+static array<perf_cvar, 7 + DXX_USE_OGL * 3> perf_cvars{{
+	/* The budget is checked when the next texture is expanded. */
+	DXX_PERF_CVAR("rle_cache_mb", 1, 1024, CGameArg.SysRleCacheSize, CGameArg.SysRleCacheSize = v),
+	DXX_PERF_CVAR("rle_pin", 0, 1, CGameArg.SysRlePin, CGameArg.SysRlePin = v),
+	/* A new size empties the cache. */
+	DXX_PERF_CVAR("texmerge_size", 1, texmerge_max_capacity, texmerge_get_stats().capacity, texmerge_set_capacity(v)),
+	DXX_PERF_CVAR("ai_lod", 0, MAX_SEGMENTS, CGameArg.SysAiLodDepth, CGameArg.SysAiLodDepth = v),
+	DXX_PERF_CVAR("render_depth", 1, MAX_RENDER_SEGS, Render_depth, Render_depth = v),
+	/* The potentially visible set is built when a level loads. */
+	DXX_PERF_CVAR("pvs", 0, 1, !CGameArg.DbgNoPVS, CGameArg.DbgNoPVS = !v),
+	DXX_PERF_CVAR("max_fps", MINIMUM_FPS, MAXIMUM_FPS, CGameArg.SysMaxFPS, CGameArg.SysMaxFPS = v),
+#if DXX_USE_OGL
+	/* 0 keeps every texture resident. */
+	DXX_PERF_CVAR("gl_vram_mb", 0, 65536, CGameArg.OglVramBudget, CGameArg.OglVramBudget = v),
+	/* 0 draws the 3D view at full resolution. */
+	DXX_PERF_CVAR("gl_dynres_ms", 0, 1000, CGameArg.OglDynresTarget, CGameArg.OglDynresTarget = v),
+	/* 0 draws every polygon of a model at any distance. */
+	DXX_PERF_CVAR("gl_model_lod", 0, 1000, CGameArg.OglModelLod, CGameArg.OglModelLod = v),
+#endif
+}};
+
+#undef DXX_PERF_CVAR
+
+static void perf_cvar_changed(cvar_t &cvar)
+{
+	range_for (auto &p, perf_cvars)
+	{
+		if (&p.cvar != &cvar)
+			continue;
+		const auto v = cvar.intval;
+		if (v < p.minimum)
+			cvar = p.minimum;
+		else if (v > p.maximum)
+			cvar = p.maximum;
+		else
+			p.set(v);
+		/* An out of range value was replaced, which called this again
+		 * with the clamped value.
+		 */
+		return;
+	}
+}
+
+static unsigned perf_percent(const unsigned hits, const unsigned misses)
+{
+	const auto lookups = static_cast<uint64_t>(hits) + misses;
+	return lookups ? static_cast<unsigned>(uint64_t(hits) * 100 / lookups) : 0;
+}
+
+static void perf_report_cmd(unsigned long, const char *const *)
+{
+	profile_dump();
+	{
+		const auto &&t = texmerge_get_stats();
+		con_printf(CON_NORMAL, "perf: texmerge %u entries, %u hits, %u misses (%u%% hit)", t.capacity, t.hits, t.misses, perf_percent(t.hits, t.misses));
+	}
+	{
+		const auto &&r = rle_cache_get_stats();
+		con_printf(CON_NORMAL, "perf: rle cache %u bitmaps, %zu of %zu KiB, %zu KiB pinned, %u hits, %u misses (%u%% hit)", r.entries, r.bytes / 1024, r.budget / 1024, r.pinned_bytes / 1024, r.hits, r.misses, perf_percent(r.hits, r.misses));
+	}
+#if defined(DXX_BUILD_DESCENT_II)
+	{
+		const auto &&f = fcd_cache_get_stats();
+		con_printf(CON_NORMAL, "perf: connected distance cache %u hits, %u misses (%u%% hit)", f.hits, f.misses, perf_percent(f.hits, f.misses));
+	}
+#endif
+#if DXX_USE_OGL
+	{
+		const auto &&o = ogl_get_texture_stats();
+		con_printf(CON_NORMAL, "perf: gl textures %u, %zu KiB resident, %u evicted", o.textures, o.resident_bytes / 1024, o.evictions);
+		con_printf(CON_NORMAL, "perf: gl state calls skipped %u in the last frame", o.state_calls_skipped);
+		con_printf(CON_NORMAL, "perf: gl 3D view at %u%% resolution", o.dynres_percent);
+	}
+#endif
+	{
+		const auto &&r = render_get_object_stats();
+		con_printf(CON_NORMAL, "perf: objects drawn %u, %u outside the view skipped in the last frame", r.drawn, r.culled);
+	}
+	con_printf(CON_NORMAL, "perf: %u threads", job_pool_threads());
+	range_for (auto &p, perf_cvars)
+		con_printf(CON_NORMAL, "perf: %s %s", p.cvar.name, p.cvar.string.c_str());
+}
+
+void perf_init()
+{
+	range_for (auto &p, perf_cvars)
+	{
+		p.cvar.string = std::to_string(p.get());
+		cvar_registervariable(p.cvar);
+	}
+	cmd_addcommand("perf_report", perf_report_cmd, "perf_report\n" "    show the frame times, the cache hit rates and the performance settings");
+}
+
+}
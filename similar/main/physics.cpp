@@ -26,6 +26,8 @@ COPYRIGHT 1993-1999 PARALLAX SOFTWARE CORPORATION.  ALL RIGHTS RESERVED.
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <algorithm>
+#include <array>
 
 #include "joy.h"
 #include "dxxerror.h"
@@ -48,6 +50,7 @@ COPYRIGHT 1993-1999 PARALLAX SOFTWARE CORPORATION.  ALL RIGHTS RESERVED.
 #if defined(DXX_BUILD_DESCENT_II)
 #include "bm.h"
 #include "player.h"
+#include "profile.h"
 #define MAX_OBJECT_VEL	i2f(100)
 #endif
 
@@ -160,6 +163,55 @@ int	Dont_move_ai_objects=0;
 
 #define FT (f1_0/64)
 
+namespace {
+
+// The drag steps depend only on FrameTime and the drag value, and a
+// level uses only a few distinct drag values, so compute each once per
+// frame instead of once per moving object.  The arithmetic is the same
+// as the per-object loops it replaces, so results do not change.
+class physics_drag_step
+{
+	struct drag_entry
+	{
+		fix drag;
+		fix total;
+	};
+	fix frame_time = 0;
+	unsigned used = 0;
+	std::array<drag_entry, 8> entries;
+public:
+	int count;
+	fix k;
+	void update(const fix ft)
+	{
+		if (frame_time == ft)
+			return;
+		frame_time = ft;
+		used = 0;
+		count = ft / FT;
+		k = fixdiv(ft % FT, FT);
+	}
+	fix total_drag(const fix drag)
+	{
+		const auto b = entries.begin(), e = std::next(b, used);
+		const auto i = std::find_if(b, e, [drag](const drag_entry &d) { return d.drag == drag; });
+		if (i != e)
+			return i->total;
+		fix total = f1_0;
+		for (auto c = count; c--;)
+			total = fixmul(total, f1_0 - drag);
+		//do linear scale on remaining bit of time
+		total = fixmul(total, f1_0 - fixmul(k, drag));
+		if (used < entries.size())
+			entries[used++] = {drag, total};
+		return total;
+	}
+};
+
+static physics_drag_step Physics_drag_step;
+
+}
+
 //	-----------------------------------------------------------------------------------------------------------
 // add rotational velocity & acceleration
 namespace dsx {
@@ -178,12 +230,11 @@ static void do_physics_sim_rot(object_base &obj)
 
 	if (obj.mtype.phys_info.drag)
 	{
-		int count;
-		fix drag,r,k;
-
-		count = FrameTime / FT;
-		r = FrameTime % FT;
-		k = fixdiv(r,FT);
+		auto &step = Physics_drag_step;
+		step.update(FrameTime);
+		int count = step.count;
+		const fix k = step.k;
+		fix drag;
 
 		drag = (obj.mtype.phys_info.drag * 5) / 2;
 
@@ -205,16 +256,7 @@ static void do_physics_sim_rot(object_base &obj)
 			if (! (obj.mtype.phys_info.flags & PF_FREE_SPINNING))
 #endif
 		{
-			fix total_drag=f1_0;
-
-			while (count--)
-				total_drag = fixmul(total_drag,f1_0-drag);
-
-			//do linear scale on remaining bit of time
-
-			total_drag = fixmul(total_drag,f1_0-fixmul(k,drag));
-
-			vm_vec_scale(obj.mtype.phys_info.rotvel, total_drag);
+			vm_vec_scale(obj.mtype.phys_info.rotvel, step.total_drag(drag));
 		}
 
 	}
@@ -314,6 +356,7 @@ public:
 namespace dsx {
 window_event_result do_physics_sim(const vmobjptridx_t obj, phys_visited_seglist *const phys_segs)
 {
+	DXX_TRACE_ZONE("do_physics_sim");
 	ignore_objects_array_t ignore_obj_list;
 	int try_again;
 	int fate=0;
@@ -362,12 +405,11 @@ window_event_result do_physics_sim(const vmobjptridx_t obj, phys_visited_seglist
 	//do thrust & drag
 	if ((drag = obj->mtype.phys_info.drag) != 0) {
 
-		int count;
-		fix r,k,have_accel;
-
-		count = FrameTime / FT;
-		r = FrameTime % FT;
-		k = fixdiv(r,FT);
+		auto &step = Physics_drag_step;
+		step.update(FrameTime);
+		int count = step.count;
+		const fix k = step.k;
+		fix have_accel;
 
 		if (obj->mtype.phys_info.flags & PF_USES_THRUST) {
 
@@ -388,18 +430,7 @@ window_event_result do_physics_sim(const vmobjptridx_t obj, phys_visited_seglist
 				vm_vec_scale(obj->mtype.phys_info.velocity,f1_0-fixmul(k,drag));
 		}
 		else if (drag)
-		{
-			fix total_drag=f1_0;
-
-			while (count--)
-				total_drag = fixmul(total_drag,f1_0-drag);
-
-			//do linear scale on remaining bit of time
-
-			total_drag = fixmul(total_drag,f1_0-fixmul(k,drag));
-
-			vm_vec_scale(obj->mtype.phys_info.velocity,total_drag);
-		}
+			vm_vec_scale(obj->mtype.phys_info.velocity, step.total_drag(drag));
 	}
 
 	int count = 0;
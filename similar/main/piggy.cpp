@@ -23,8 +23,14 @@ COPYRIGHT 1993-1999 PARALLAX SOFTWARE CORPORATION.  ALL RIGHTS RESERVED.
  *
  */
 
+#include <algorithm>
+#include <atomic>
+#include <bitset>
 #include <stdio.h>
 #include <string.h>
+#include <string>
+#include <vector>
+#include <SDL.h>
 
 #include "pstypes.h"
 #include "strutil.h"
@@ -50,6 +56,7 @@ COPYRIGHT 1993-1999 PARALLAX SOFTWARE CORPORATION.  ALL RIGHTS RESERVED.
 #include "gamemine.h"
 #include "textures.h"
 #include "texmerge.h"
+#include "texmap.h"
 #include "paging.h"
 #include "game.h"
 #include "text.h"
@@ -57,6 +64,7 @@ COPYRIGHT 1993-1999 PARALLAX SOFTWARE CORPORATION.  ALL RIGHTS RESERVED.
 #include "newmenu.h"
 #include "makesig.h"
 #include "console.h"
+#include "profile.h"
 #include "compiler-cf_assert.h"
 #include "compiler-range_for.h"
 #include "compiler-make_unique.h"
@@ -95,6 +103,21 @@ int Piggy_hamfile_version = 0;
 
 static std::unique_ptr<ubyte[]> BitmapBits;
 static std::unique_ptr<ubyte[]> SoundBits;
+static mem_account_buffer BitmapBits_account{mem_tag::textures};
+static mem_account_buffer SoundBits_account{mem_tag::sounds};
+/* -lazysounds: piggy_read_sounds only marks the sounds which are
+ * needed, and piggy_sound_page_in reads each one when it is first
+ * played or prefetched.
+ */
+static array<uint8_t, MAX_SOUND_FILES> SoundPagedOut;
+static array<std::unique_ptr<uint8_t[]>, MAX_SOUND_FILES> SoundLazyData;
+#if defined(DXX_BUILD_DESCENT_I)
+static int Sound_pc_shareware;
+#elif defined(DXX_BUILD_DESCENT_II)
+static RAIIPHYSFS_File Sound_fp;
+/* With -mappig, the sound file, which the sounds point into. */
+static PHYSFSX_mapped_file Sound_map;
+#endif
 
 struct SoundFile
 {
@@ -145,6 +168,10 @@ static array<uint16_t, MAX_BITMAP_FILES> GameBitmapXlat;
 #define PIGGY_SMALL_BUFFER_SIZE (1400*1024)		// size of buffer when CGameArg.SysLowMem is set
 
 static RAIIPHYSFS_File Piggy_fp;
+/* With -mappig, Piggy_map covers the same file as Piggy_fp and paging in
+ * a bitmap only points it into the mapping.
+ */
+static PHYSFSX_mapped_file Piggy_map;
 
 ubyte bogus_bitmap_initialized=0;
 array<uint8_t, 64 * 64> bogus_data;
@@ -161,8 +188,6 @@ static array<int, MAX_SOUND_FILES> SoundCompressed;
 char Current_pigfile[FILENAME_LEN] = "";
 int Pigfile_initialized=0;
 
-static std::unique_ptr<ubyte[]> Bitmap_replacement_data;
-
 #define BM_FLAGS_TO_COPY (BM_FLAG_TRANSPARENT | BM_FLAG_SUPER_TRANSPARENT \
                          | BM_FLAG_NO_LIGHTING | BM_FLAG_RLE | BM_FLAG_RLE_BIG)
 #endif
@@ -200,6 +225,7 @@ struct DiskSoundHeader
 
 #if defined(DXX_BUILD_DESCENT_II)
 static void free_bitmap_replacements();
+static void bitmap_replacements_forget();
 static void free_d1_tmap_nums();
 #if DXX_USE_EDITOR
 static int piggy_is_substitutable_bitmap(char * name, char (&subst_name)[32]);
@@ -412,9 +438,205 @@ int piggy_find_sound(const char *name)
 	return i;
 }
 
+#if DXX_USE_EDITOR
+uint64_t piggy_names_hash()
+{
+	fnv1a_hash h;
+	h.add(Num_bitmap_files);
+	range_for (auto &i, partial_const_range(AllBitmaps, Num_bitmap_files))
+		h.add(i.name.data(), strlen(i.name.data()) + 1);
+	h.add(Num_sound_files);
+	for (unsigned i = 0; i != Num_sound_files; ++i)
+		h.add(AllSounds[i].name, strnlen(AllSounds[i].name, sizeof(AllSounds[i].name)));
+	return h.get();
+}
+#endif
+
+static void piggy_map_file(const char *const filename)
+{
+	if (!CGameArg.SysMapPigFile)
+		return;
+	Piggy_map = PHYSFSX_mapRead(filename);
+	if (!Piggy_map)
+		con_printf(CON_VERBOSE, "Cannot map %s, reading bitmaps into the cache instead", filename);
+}
+
+/* Point bm at its data in the mapped pig.  On disk, an RLE bitmap is
+ * laid out as in memory, starting with its total size.
+ */
+static bool piggy_page_in_mapped(grs_bitmap &bm, const unsigned offset, const uint8_t flags)
+{
+	if (!Piggy_map)
+		return false;
+	const auto size = Piggy_map.size();
+	if (offset >= size)
+		return false;
+	const auto data = Piggy_map.data() + offset;
+	std::size_t length;
+	if (flags & BM_FLAG_RLE)
+	{
+		if (size - offset < sizeof(uint32_t))
+			return false;
+		length = GET_INTEL_INT(data);
+	}
+	else
+		length = bm.bm_w * bm.bm_h;
+	if (length > size - offset)
+		return false;
+	gr_set_bitmap_flags(bm, flags);
+	gr_set_bitmap_data(bm, data);
+	return true;
+}
+
+/* Read ahead for an upcoming level.  While a briefing or the score
+ * screen is shown, a thread reads the level file and the PIG file its
+ * textures come from, so that loading the level finds both in the
+ * operating system's file cache.  The thread uses only its own file
+ * handles, and reads the mapping of the open PIG file, if any, without
+ * changing any bitmap.
+ */
+namespace {
+
+struct piggy_read_ahead_state
+{
+	SDL_Thread *thread;
+	std::atomic<bool> stop;
+	array<char, PATH_MAX> level_file, mission_level_file;
+	array<char, FILENAME_LEN> pig_file;
+	const uint8_t *map_data;
+	std::size_t map_size;
+};
+
+}
+
+static piggy_read_ahead_state Piggy_read_ahead;
+
+static bool piggy_read_ahead_file(piggy_read_ahead_state &r, const char *const filename, std::vector<uint8_t> *const keep)
+{
+	RAIIPHYSFS_File fp{PHYSFS_openRead(filename)};
+	if (!fp)
+		return false;
+	array<uint8_t, 64 * 1024> buffer;
+	for (;;)
+	{
+		if (r.stop.load(std::memory_order_relaxed))
+			return true;
+		const auto n = PHYSFS_read(fp, buffer.data(), 1, buffer.size());
+		if (n <= 0)
+			return true;
+		if (keep)
+			keep->insert(keep->end(), buffer.data(), buffer.data() + n);
+	}
+}
+
+#if defined(DXX_BUILD_DESCENT_II)
+/* Find the PIG file named by the level's palette, as load_palette
+ * does.  The header layout matches load_level.
+ */
+static bool piggy_read_ahead_level_pig(const std::vector<uint8_t> &level, array<char, FILENAME_LEN> &pig_file)
+{
+	if (level.size() < 16)
+		return false;
+	const auto version = GET_INTEL_INT(&level[4]);
+	if (version <= 1)
+		return false;
+	std::size_t pos = 16;
+	if (version < 5)
+		pos += 4;
+	if (version >= 8)
+		pos += 7;
+	const auto e = level.size();
+	auto end = pos;
+	while (end != e && level[end] != '\n' && level[end] != '\r' && end - pos < 13)
+		++end;
+	if (end == pos)
+		return false;
+	array<char, 14> palette{};
+	std::copy(&level[pos], &level[0] + end, palette.begin());
+	struct splitpath_t path;
+	d_splitpath(palette.data(), &path);
+	snprintf(pig_file.data(), pig_file.size(), "%.*s.pig", DXX_ptrdiff_cast_int(path.base_end - path.base_start), path.base_start);
+	return true;
+}
+#endif
+
+static int piggy_read_ahead_thread(void *)
+{
+	auto &r = Piggy_read_ahead;
+	std::vector<uint8_t> level;
+	if (!piggy_read_ahead_file(r, r.level_file.data(), &level))
+		piggy_read_ahead_file(r, r.mission_level_file.data(), &level);
+#if defined(DXX_BUILD_DESCENT_II)
+	array<char, FILENAME_LEN> level_pig;
+	if (piggy_read_ahead_level_pig(level, level_pig) && d_stricmp(level_pig.data(), r.pig_file.data()))
+	{
+		piggy_read_ahead_file(r, level_pig.data(), nullptr);
+		return 0;
+	}
+#endif
+	if (r.map_data)
+	{
+		/* Touch each page so that the first page in does not wait for
+		 * the disk.
+		 */
+		uint8_t sum = 0;
+		for (std::size_t i = 0; i < r.map_size && !r.stop.load(std::memory_order_relaxed); i += 4096)
+			sum += static_cast<const volatile uint8_t *>(r.map_data)[i];
+		(void)sum;
+	}
+	else
+		piggy_read_ahead_file(r, r.pig_file.data(), nullptr);
+	return 0;
+}
+
+void piggy_read_ahead_stop()
+{
+	auto &r = Piggy_read_ahead;
+	if (!r.thread)
+		return;
+	r.stop.store(true, std::memory_order_relaxed);
+	SDL_WaitThread(r.thread, nullptr);
+	r.thread = nullptr;
+}
+
+void piggy_read_ahead_level(const char *const level_file, const char *const mission_level_file)
+{
+	auto &r = Piggy_read_ahead;
+#if defined(DXX_BUILD_DESCENT_I)
+	const char *const pig_file = DEFAULT_PIGFILE_REGISTERED;
+#elif defined(DXX_BUILD_DESCENT_II)
+	const char *const pig_file = Current_pigfile[0] ? Current_pigfile : DEFAULT_PIGFILE_REGISTERED;
+#endif
+	/* The same level may be asked for when the player leaves the mine,
+	 * at the score screen and at its briefing.  Reading it again would
+	 * only start over.
+	 */
+	if (r.thread && !strcmp(r.level_file.data(), level_file) && !strcmp(r.mission_level_file.data(), mission_level_file) && !strcmp(r.pig_file.data(), pig_file) && r.map_data == Piggy_map.data())
+		return;
+	piggy_read_ahead_stop();
+	snprintf(r.level_file.data(), r.level_file.size(), "%s", level_file);
+	snprintf(r.mission_level_file.data(), r.mission_level_file.size(), "%s", mission_level_file);
+	snprintf(r.pig_file.data(), r.pig_file.size(), "%s", pig_file);
+	r.map_data = Piggy_map.data();
+	r.map_size = Piggy_map.size();
+	r.stop.store(false, std::memory_order_relaxed);
+#if SDL_MAJOR_VERSION == 2
+	r.thread = SDL_CreateThread(piggy_read_ahead_thread, "piggy_read_ahead", nullptr);
+#else
+	r.thread = SDL_CreateThread(piggy_read_ahead_thread, nullptr);
+#endif
+}
+
 namespace dsx {
 static void piggy_close_file()
 {
+	piggy_read_ahead_stop();
+	if (Piggy_map)
+	{
+		/* Nothing may keep pointing into the mapping. */
+		piggy_bitmap_page_out_all();
+		Piggy_map.reset();
+	}
 	if (Piggy_fp)
 	{
 		Piggy_fp.reset();
@@ -428,6 +650,7 @@ static void piggy_close_file()
 #if defined(DXX_BUILD_DESCENT_I)
 int properties_init()
 {
+	const trace_scope trace_phase("properties_init");
 	int sbytes = 0;
 	array<char, 13> temp_name;
 	digi_sound temp_sound;
@@ -510,6 +733,9 @@ int properties_init()
 	}
 	
 	HiresGFXAvailable = MacPig;	// for now at least
+	//	Mac bitmaps are converted in place as they are paged in.
+	if (!MacPig)
+		piggy_map_file(DEFAULT_PIGFILE_REGISTERED);
 
 	if (PCSharePig)
 		retval = PIGGY_PC_SHAREWARE;	// run gamedata_read_tbl in shareware mode
@@ -604,7 +830,11 @@ int properties_init()
                 sbytes += sndh.length;
 	}
 
-		SoundBits = make_unique<ubyte[]>(sbytes + 16);
+		if (!CGameArg.SndLazyLoad)
+		{
+			SoundBits = make_unique<ubyte[]>(sbytes + 16);
+			SoundBits_account.set(sbytes + 16);
+		}
 	}
 
 #if 1	//def EDITOR
@@ -616,6 +846,7 @@ int properties_init()
 		Piggy_bitmap_cache_size = PIGGY_SMALL_BUFFER_SIZE;
 #endif
 	BitmapBits = make_unique<ubyte[]>(Piggy_bitmap_cache_size);
+	BitmapBits_account.set(Piggy_bitmap_cache_size);
 	Piggy_bitmap_cache_data = BitmapBits.get();
 	Piggy_bitmap_cache_next = 0;
 
@@ -623,10 +854,33 @@ int properties_init()
 }
 #elif defined(DXX_BUILD_DESCENT_II)
 
+//	Mac bitmaps are converted in place as they are paged in, so they
+//	cannot be used straight from a mapping.
+static bool piggy_is_mac_pigsize(const int pigsize)
+{
+#ifndef MACDATA
+	switch (pigsize) {
+	case MAC_ALIEN1_PIGSIZE:
+	case MAC_ALIEN2_PIGSIZE:
+	case MAC_FIRE_PIGSIZE:
+	case MAC_GROUPA_PIGSIZE:
+	case MAC_ICE_PIGSIZE:
+	case MAC_WATER_PIGSIZE:
+		return true;
+	default:
+		return GameArg.EdiMacData;
+	}
+#else
+	(void)pigsize;
+	return false;
+#endif
+}
+
 //initialize a pigfile, reading headers
 //returns the size of all the bitmap data
 void piggy_init_pigfile(const char *filename)
 {
+	const trace_scope trace_phase("piggy_init_pigfile", filename);
 	int i;
 	array<char, 13> temp_name;
 	DiskBitmapHeader bmh;
@@ -637,11 +891,12 @@ void piggy_init_pigfile(const char *filename)
 
 	piggy_close_file();             //close old pig if still open
 
-	Piggy_fp = PHYSFSX_openReadBuffered(filename);
+	const char *pigfile_opened = filename;
+	Piggy_fp = PHYSFSX_openReadBuffered(pigfile_opened);
 	
 	//try pigfile for shareware
 	if (!Piggy_fp)
-		Piggy_fp = PHYSFSX_openReadBuffered(DEFAULT_PIGFILE_SHAREWARE);
+		Piggy_fp = PHYSFSX_openReadBuffered(pigfile_opened = DEFAULT_PIGFILE_SHAREWARE);
 
 	if (Piggy_fp) {                         //make sure pig is valid type file & is up-to-date
 		int pig_id,pig_version;
@@ -653,6 +908,8 @@ void piggy_init_pigfile(const char *filename)
 			                        //..so pretend it's not here
 		}
 	}
+	if (Piggy_fp && !piggy_is_mac_pigsize(PHYSFS_fileLength(Piggy_fp)))
+		piggy_map_file(pigfile_opened);
 
 	if (!Piggy_fp) {
 
@@ -693,6 +950,8 @@ void piggy_init_pigfile(const char *filename)
 		Assert( (i+1) == Num_bitmap_files );
 		piggy_register_bitmap(*bm, temp_name.data(), 1);
 	}
+	/* Slots registered by an earlier pig may have held other names. */
+	hashtable_rehash(&AllBitmapsNames);
 
 #if DXX_USE_EDITOR
 	Piggy_bitmap_cache_size = data_size + (data_size/10);   //extra mem for new bitmaps
@@ -703,6 +962,7 @@ void piggy_init_pigfile(const char *filename)
 		Piggy_bitmap_cache_size = PIGGY_SMALL_BUFFER_SIZE;
 #endif
 	BitmapBits = make_unique<ubyte[]>(Piggy_bitmap_cache_size);
+	BitmapBits_account.set(Piggy_bitmap_cache_size);
 	Piggy_bitmap_cache_data = BitmapBits.get();
 	Piggy_bitmap_cache_next = 0;
 
@@ -723,9 +983,12 @@ void piggy_new_pigfile(char *pigname)
 
 	d_strlwr(pigname);
 
-	if (d_strnicmp(Current_pigfile, pigname, sizeof(Current_pigfile)) == 0 // correct pig already loaded
-	    && !Bitmap_replacement_data) // no need to reload: no bitmaps were altered
+	/* Replaced bitmaps are put back by the next level's replacements,
+	 * so they need not be reloaded here.
+	 */
+	if (d_strnicmp(Current_pigfile, pigname, sizeof(Current_pigfile)) == 0) // correct pig already loaded
 		return;
+	bitmap_replacements_forget();
 
 	if (!Pigfile_initialized) {                     //have we ever opened a pigfile?
 		piggy_init_pigfile(pigname);            //..no, so do initialization stuff
@@ -738,11 +1001,12 @@ void piggy_new_pigfile(char *pigname)
 
 	strncpy(Current_pigfile,pigname,sizeof(Current_pigfile));
 
-	Piggy_fp = PHYSFSX_openReadBuffered(pigname);
+	const char *pigfile_opened = pigname;
+	Piggy_fp = PHYSFSX_openReadBuffered(pigfile_opened);
 
 	//try pigfile for shareware
 	if (!Piggy_fp)
-		Piggy_fp = PHYSFSX_openReadBuffered(DEFAULT_PIGFILE_SHAREWARE);
+		Piggy_fp = PHYSFSX_openReadBuffered(pigfile_opened = DEFAULT_PIGFILE_SHAREWARE);
 	
 	if (Piggy_fp) {  //make sure pig is valid type file & is up-to-date
 		int pig_id,pig_version;
@@ -754,6 +1018,8 @@ void piggy_new_pigfile(char *pigname)
 			                        //..so pretend it's not here
 		}
 	}
+	if (Piggy_fp && !piggy_is_mac_pigsize(PHYSFS_fileLength(Piggy_fp)))
+		piggy_map_file(pigfile_opened);
 
 #if !DXX_USE_EDITOR
 	if (!Piggy_fp)
@@ -796,6 +1062,7 @@ void piggy_new_pigfile(char *pigname)
 	
 			GameBitmapOffset[i] = bmh.offset + data_start;
 		}
+		hashtable_rehash(&AllBitmapsNames);
 	}
 	else
 		N_bitmaps = 0;          //no pigfile, so no bitmaps
@@ -943,6 +1210,7 @@ void piggy_new_pigfile(char *pigname)
 
 int read_hamfile()
 {
+	const trace_scope trace_phase("read_hamfile");
 	int ham_id;
 	int sound_offset = 0;
 	int shareware = 0;
@@ -1042,7 +1310,11 @@ int read_hamfile()
 			if (piggy_is_needed(i))
 				sbytes += sndh.length;
 		}
-		SoundBits = make_unique<ubyte[]>(sbytes + 16);
+		if (!CGameArg.SndLazyLoad)
+		{
+			SoundBits = make_unique<ubyte[]>(sbytes + 16);
+			SoundBits_account.set(sbytes + 16);
+		}
 	}
 	return 1;
 }
@@ -1088,12 +1360,17 @@ static int read_sndfile()
 		if (piggy_is_needed(i))
 			sbytes += sndh.length;
 	}
-	SoundBits = make_unique<ubyte[]>(sbytes + 16);
+	if (!CGameArg.SndLazyLoad)
+	{
+		SoundBits = make_unique<ubyte[]>(sbytes + 16);
+		SoundBits_account.set(sbytes + 16);
+	}
 	return 1;
 }
 
 int properties_init(void)
 {
+	const trace_scope trace_phase("properties_init");
 	int ham_ok=0,snd_ok=0;
 	for (unsigned i = 0; i < MAX_SOUND_FILES; ++i)
 	{
@@ -1153,9 +1430,35 @@ static int piggy_is_needed(int soundnum)
 	return 0;
 }
 
+/* With -mappig, point the needed sounds into the mapping of the file
+ * which holds them, instead of reading them into SoundBits.  Pages which
+ * are only read stay shared with the page cache, so every game process
+ * on a host uses the same copy of the sound data.  Returns false, with
+ * nothing changed, if any sound is outside the mapping.
+ */
+static bool piggy_map_sounds(const PHYSFSX_mapped_file &map)
+{
+	if (!map)
+		return false;
+	const auto size = map.size();
+	for (unsigned i = 0; i != Num_sound_files; ++i)
+	{
+		const unsigned offset = SoundOffset[i];
+		if (offset > 0 && piggy_is_needed(i) && (offset > size || size - offset < GameSounds[i].length))
+			return false;
+	}
+	for (unsigned i = 0; i != Num_sound_files; ++i)
+		if (SoundOffset[i] > 0 && piggy_is_needed(i))
+			GameSounds[i].data = map.data() + SoundOffset[i];
+	SoundBits.reset();
+	SoundBits_account.set(0);
+	return true;
+}
+
 #if defined(DXX_BUILD_DESCENT_I)
 void piggy_read_sounds(int pc_shareware)
 {
+	const trace_scope trace_phase("piggy_read_sounds");
 	uint8_t * ptr;
 	int i, sbytes;
 	int lastsize = 0;
@@ -1189,6 +1492,22 @@ void piggy_read_sounds(int pc_shareware)
 		return;
 	}
 
+	/* Shareware sounds are compressed, so they must be read. */
+	if (!pc_shareware && piggy_map_sounds(Piggy_map))
+		return;
+
+	if (CGameArg.SndLazyLoad)
+	{
+		Sound_pc_shareware = pc_shareware;
+		for (i = 0; i < Num_sound_files; i++)
+			if (SoundOffset[i] > 0 && piggy_is_needed(i))
+			{
+				GameSounds[i].data = nullptr;
+				SoundPagedOut[i] = 1;
+			}
+		return;
+	}
+
 	ptr = SoundBits.get();
 	sbytes = 0;
 
@@ -1234,9 +1553,19 @@ void piggy_read_sounds(int pc_shareware)
 #elif defined(DXX_BUILD_DESCENT_II)
 void piggy_read_sounds(void)
 {
+	const trace_scope trace_phase("piggy_read_sounds");
 	uint8_t * ptr;
 	int i, sbytes;
 
+	if (CGameArg.SysMapPigFile)
+	{
+		Sound_map = PHYSFSX_mapRead(DEFAULT_SNDFILE);
+		if (piggy_map_sounds(Sound_map))
+			return;
+		Sound_map.reset();
+		con_printf(CON_VERBOSE, "Cannot map %s, reading sounds instead", DEFAULT_SNDFILE);
+	}
+
 	ptr = SoundBits.get();
 	sbytes = 0;
 	auto fp = PHYSFSX_openReadBuffered(DEFAULT_SNDFILE);
@@ -1247,7 +1576,12 @@ void piggy_read_sounds(void)
 		digi_sound *snd = &GameSounds[i];
 
 		if ( SoundOffset[i] > 0 )       {
-			if ( piggy_is_needed(i) )       {
+			if (piggy_is_needed(i) && CGameArg.SndLazyLoad)
+			{
+				snd->data = nullptr;
+				SoundPagedOut[i] = 1;
+			}
+			else if ( piggy_is_needed(i) )       {
 				PHYSFSX_fseek( fp, SoundOffset[i], SEEK_SET );
 
 				// Read in the sound data!!!
@@ -1260,12 +1594,48 @@ void piggy_read_sounds(void)
 				snd->data = reinterpret_cast<uint8_t *>(-1);
 		}
 	}
+	if (CGameArg.SndLazyLoad)
+		Sound_fp = std::move(fp);
 }
 #endif
 
+void piggy_sound_page_in(const int soundnum)
+{
+	if (!SoundPagedOut[soundnum])
+		return;
+	SoundPagedOut[soundnum] = 0;
+	auto &snd = GameSounds[soundnum];
+	/* Custom sounds may have replaced a sound which was not read yet. */
+	if (snd.data)
+		return;
+#if defined(DXX_BUILD_DESCENT_I)
+	PHYSFS_File *const fp = Piggy_fp;
+#elif defined(DXX_BUILD_DESCENT_II)
+	PHYSFS_File *const fp = Sound_fp;
+#endif
+	if (!fp)
+		return;
+	auto data = make_unique<uint8_t[]>(snd.length);
+	PHYSFSX_fseek(fp, SoundOffset[soundnum], SEEK_SET);
+#if defined(DXX_BUILD_DESCENT_I)
+	if (Sound_pc_shareware)
+	{
+		const auto compressed = make_unique<uint8_t[]>(SoundCompressed[soundnum]);
+		PHYSFS_read(fp, compressed.get(), SoundCompressed[soundnum], 1);
+		sound_decompress(compressed.get(), SoundCompressed[soundnum], data.get());
+	}
+	else
+#endif
+		PHYSFS_read(fp, data.get(), snd.length, 1);
+	snd.data = data.get();
+	SoundLazyData[soundnum] = std::move(data);
+	mem_account(mem_tag::sounds, 0, snd.length);
+}
+
 namespace dsx {
 void piggy_bitmap_page_in( bitmap_index bitmap )
 {
+	DXX_TRACE_ZONE("piggy_bitmap_page_in");
 	grs_bitmap * bmp;
 	int i,org_i;
 
@@ -1295,6 +1665,8 @@ void piggy_bitmap_page_in( bitmap_index bitmap )
 	{
 		pause_game_world_time p;
 
+		if (piggy_page_in_mapped(*bmp, GameBitmapOffset[i], GameBitmapFlags[i]))
+			goto paged_in;
 	ReDoIt:
 		PHYSFSX_fseek( Piggy_fp, GameBitmapOffset[i], SEEK_SET );
 
@@ -1408,6 +1780,7 @@ void piggy_bitmap_page_in( bitmap_index bitmap )
 		//@@#endif
 		//@@}
 
+paged_in:
 		compute_average_rgb(bmp, bmp->avg_color_rgb);
 
 	}
@@ -1429,11 +1802,40 @@ void piggy_bitmap_page_in( bitmap_index bitmap )
 }
 }
 
+namespace dsx {
+bool piggy_bitmap_prefetch(const bitmap_index bitmap)
+{
+	unsigned i = bitmap.index;
+	if (i < 1 || i >= Num_bitmap_files || !GameBitmapOffset[i])
+		return false;
+	if (!GameBitmaps[i].get_flag_mask(BM_FLAG_PAGED_OUT))
+		return false;
+	if (!Piggy_map)
+	{
+		if (CGameArg.SysLowMem)
+			i = GameBitmapXlat[i];
+		auto &bm = GameBitmaps[i];
+		//	No RLE bitmap is larger than every pixel stored as a run.
+		const unsigned size = (GameBitmapFlags[i] & BM_FLAG_RLE)
+			? 4 + 2 * bm.bm_h + 2 * bm.bm_w * bm.bm_h
+			: bm.bm_w * bm.bm_h;
+		if (Piggy_bitmap_cache_next + size >= Piggy_bitmap_cache_size)
+			return false;
+	}
+	piggy_bitmap_page_in(bitmap);
+	return true;
+}
+}
+
 namespace dsx {
 void piggy_bitmap_page_out_all()
 {
 	int i;
 	
+#if !DXX_USE_OGL
+	//	Pending texture maps may use bitmaps in the cache about to be reused.
+	draw_tmap_flush();
+#endif
 	Piggy_bitmap_cache_next = 0;
 
 	texmerge_flush();
@@ -1451,8 +1853,10 @@ void piggy_bitmap_page_out_all()
 
 void piggy_load_level_data()
 {
+	const trace_scope trace_phase("piggy_load_level_data");
 	piggy_bitmap_page_out_all();
 	paging_touch_all(Vclip);
+	digi_convert_sounds();
 }
 
 #if defined(DXX_BUILD_DESCENT_II)
@@ -1584,6 +1988,19 @@ void piggy_close()
 	piggy_close_file();
 	BitmapBits.reset();
 	SoundBits.reset();
+	BitmapBits_account.set(0);
+	SoundBits_account.set(0);
+	SoundPagedOut = {};
+	for (unsigned i = 0; i != SoundLazyData.size(); ++i)
+		if (auto &d = SoundLazyData[i])
+		{
+			d.reset();
+			mem_account(mem_tag::sounds, GameSounds[i].length, 0);
+		}
+#if defined(DXX_BUILD_DESCENT_II)
+	Sound_fp.reset();
+	Sound_map.reset();
+#endif
 	for (i = 0; i < Num_sound_files; i++)
 		if (SoundOffset[i] == 0)
 			d_free(GameSounds[i].data);
@@ -1602,14 +2019,14 @@ void remove_char( char * s, char c )
 
 #if defined(DXX_BUILD_DESCENT_II)
 #if DXX_USE_EDITOR
-static const BitmapFile *piggy_does_bitmap_exist_slow(const char *const name)
+static const BitmapFile *piggy_does_bitmap_exist(const char *const name)
 {
-	range_for (auto &i, partial_const_range(AllBitmaps, Num_bitmap_files))
-	{
-		if (!strcmp(i.name.data(), name))
-			return &i;
-	}
-	return nullptr;
+	const auto i = hashtable_search(&AllBitmapsNames, name);
+	if (i < 0 || i >= Num_bitmap_files)
+		return nullptr;
+	auto &b = AllBitmaps[i];
+	/* The index ignores case, but this check never did. */
+	return strcmp(b.name.data(), name) ? nullptr : &b;
 }
 
 
@@ -1670,7 +2087,7 @@ static int piggy_is_substitutable_bitmap(char * name, char (&subst_name)[32])
 		strcpy( base_name, subst_name );
 		if ( !piggy_is_gauge_bitmap( base_name )) {
 			snprintf(subst_name, sizeof(subst_name), "%s#%d", base_name, frame + 1);
-			if ( piggy_does_bitmap_exist_slow( subst_name )  ) {
+			if ( piggy_does_bitmap_exist( subst_name )  ) {
 				if ( frame & 1 ) {
 					snprintf(subst_name, sizeof(subst_name), "%s#%d", base_name, frame - 1);
 					return 1;
@@ -1690,19 +2107,200 @@ static int piggy_is_substitutable_bitmap(char * name, char (&subst_name)[32])
  *  2) From descent.pig (for loading d1 levels)
  */
 
+/* Replacement sets, decoded once and kept for later levels which use
+ * the same file: every Descent 1 level uses the same set, and a level of
+ * a mission may be played again.  A set is keyed by where its file is,
+ * the size and time of the file and, for Descent 1, the palette it was
+ * mapped to.  Applying a set saves the bitmaps it replaces, and the next
+ * set puts back only those it does not replace itself, so the pig is
+ * not reloaded for a level with other replacements.
+ */
+namespace {
+
+struct bitmap_replacement
+{
+	uint16_t index;
+	uint16_t width, height;
+	uint8_t flags, pig_flags, avg_color;
+	/* of the pixels in the set's data */
+	std::size_t offset;
+};
+
+struct bitmap_replacement_set
+{
+	std::string file;
+	PHYSFS_sint64 size, mtime;
+	uint64_t palette;
+	/* Descent 1 bitmaps also change how the pig would page them in. */
+	bool sets_pig_flags;
+	std::unique_ptr<uint8_t[]> data;
+	std::vector<bitmap_replacement> entries;
+	mem_account_buffer account{mem_tag::textures};
+	~bitmap_replacement_set()
+	{
+		account.set(0);
+	}
+	bool same_file(const bitmap_replacement_set &o) const
+	{
+		return file == o.file && size == o.size && mtime == o.mtime && palette == o.palette;
+	}
+};
+
+/* A bitmap as it was before the applied set replaced it */
+struct bitmap_replacement_original
+{
+	uint16_t index;
+	uint8_t pig_flags;
+	int offset;
+	grs_bitmap bitmap;
+};
+
+struct bitmap_replacement_state
+{
+	/* Most recently used first */
+	std::vector<std::unique_ptr<bitmap_replacement_set>> sets;
+	const bitmap_replacement_set *applied;
+	std::vector<bitmap_replacement_original> originals;
+};
+
+constexpr std::size_t bitmap_replacement_max_sets = 4;
+
+}
+
+static bitmap_replacement_state Bitmap_replacements;
+
 static void free_bitmap_replacements()
 {
-	Bitmap_replacement_data.reset();
+	auto &r = Bitmap_replacements;
+	r.applied = nullptr;
+	r.originals.clear();
+	r.sets.clear();
+}
+
+/* The pig was reloaded, which put back every bitmap. */
+static void bitmap_replacements_forget()
+{
+	auto &r = Bitmap_replacements;
+	r.applied = nullptr;
+	r.originals.clear();
+}
+
+/* Fill in the key of a set read from the open file, and return the
+ * cached set with that key, if any.
+ */
+static const bitmap_replacement_set *bitmap_replacement_find(bitmap_replacement_set &key, const char *const name, PHYSFS_File *const fp, const uint64_t palette)
+{
+	if (const auto dir = PHYSFS_getRealDir(name))
+		key.file = dir;
+	key.file += '/';
+	key.file += name;
+	key.size = PHYSFS_fileLength(fp);
+	PHYSFS_sint64 size;
+	if (!PHYSFSX_stat(name, size, key.mtime))
+		key.mtime = -1;
+	key.palette = palette;
+	auto &sets = Bitmap_replacements.sets;
+	const auto i = std::find_if(sets.begin(), sets.end(), [&key](const std::unique_ptr<bitmap_replacement_set> &s) {
+		return s->same_file(key);
+	});
+	if (i == sets.end())
+		return nullptr;
+	std::rotate(sets.begin(), i, std::next(i));
+	return sets.front().get();
+}
+
+static const bitmap_replacement_set *bitmap_replacement_insert(std::unique_ptr<bitmap_replacement_set> set)
+{
+	auto &r = Bitmap_replacements;
+	r.sets.insert(r.sets.begin(), std::move(set));
+	if (r.sets.size() > bitmap_replacement_max_sets)
+	{
+		/* GameBitmaps points into the applied set. */
+		auto victim = std::prev(r.sets.end());
+		if (victim->get() == r.applied)
+			--victim;
+		r.sets.erase(victim);
+	}
+	return r.sets.front().get();
+}
+
+/* Make set, or no set, the replacements in GameBitmaps. */
+static void bitmap_replacements_apply(const bitmap_replacement_set *const set)
+{
+	auto &r = Bitmap_replacements;
+	if (set == r.applied)
+		return;
+	std::bitset<MAX_BITMAP_FILES> replaced;
+	if (set)
+		range_for (auto &e, set->entries)
+			replaced.set(e.index);
+	std::bitset<MAX_BITMAP_FILES> saved;
+	auto kept = r.originals.begin();
+	range_for (auto &o, r.originals)
+	{
+		if (replaced.test(o.index))
+		{
+			saved.set(o.index);
+			*kept++ = o;
+			continue;
+		}
+		auto &bm = GameBitmaps[o.index];
+		gr_set_bitmap_data(bm, NULL);	// free ogl texture
+		bm = o.bitmap;
+		GameBitmapOffset[o.index] = o.offset;
+		GameBitmapFlags[o.index] = o.pig_flags;
+	}
+	r.originals.erase(kept, r.originals.end());
+	r.applied = set;
+	if (set)
+		range_for (auto &e, set->entries)
+		{
+			const auto i = e.index;
+			auto &bm = GameBitmaps[i];
+			if (!saved.test(i))
+			{
+				saved.set(i);
+				auto b = bm;
+#if DXX_USE_OGL
+				b.gltexture = nullptr;
+#endif
+				/* The pig cache may be reused before it is put back. */
+				if (GameBitmapOffset[i])
+				{
+					b.bm_data = nullptr;
+					b.set_flags(BM_FLAG_PAGED_OUT);
+				}
+				r.originals.emplace_back(bitmap_replacement_original{i, GameBitmapFlags[i], GameBitmapOffset[i], b});
+			}
+			gr_set_bitmap_data(bm, NULL);	// free ogl texture
+			gr_init_bitmap(bm, bm_mode::linear, 0, 0, e.width, e.height, e.width, &set->data[e.offset]);
+			bm.avg_color = e.avg_color;
+			gr_set_bitmap_flags(bm, e.flags);
+			GameBitmapOffset[i] = 0; // don't try to read bitmap from current pigfile
+			if (set->sets_pig_flags)
+				GameBitmapFlags[i] = e.pig_flags;
+		}
+	texmerge_flush();       //for re-merging with new textures
+	rle_cache_flush();
 }
 
 void load_bitmap_replacements(const char *level_name)
 {
 	char ifile_name[FILENAME_LEN];
-	//first, free up data allocated for old bitmaps
-	free_bitmap_replacements();
 
 	change_filename_extension(ifile_name, level_name, ".POG" );
-	if (auto ifile = PHYSFSX_openReadBuffered(ifile_name))
+	auto ifile = PHYSFSX_openReadBuffered(ifile_name);
+	if (!ifile)
+	{
+		bitmap_replacements_apply(nullptr);
+		return;
+	}
+	auto set = make_unique<bitmap_replacement_set>();
+	if (const auto cached = bitmap_replacement_find(*set, ifile_name, ifile, 0))
+	{
+		bitmap_replacements_apply(cached);
+		return;
+	}
 	{
 		int id,version;
 		unsigned n_bitmaps;
@@ -1712,6 +2310,7 @@ void load_bitmap_replacements(const char *level_name)
 		version = PHYSFSX_readInt(ifile);
 
 		if (id != MAKE_SIG('G','O','P','D') || version != 1) {
+			bitmap_replacements_apply(nullptr);
 			return;
 		}
 
@@ -1724,37 +2323,23 @@ void load_bitmap_replacements(const char *level_name)
 			i = PHYSFSX_readShort(ifile);
 
 		bitmap_data_size = PHYSFS_fileLength(ifile) - PHYSFS_tell(ifile) - sizeof(DiskBitmapHeader) * n_bitmaps;
-		Bitmap_replacement_data = make_unique<ubyte[]>(bitmap_data_size);
+		set->data = make_unique<ubyte[]>(bitmap_data_size);
+		set->account.set(bitmap_data_size);
 
+		set->entries.reserve(n_bitmaps);
 		range_for (const auto i, unchecked_partial_range(indices.get(), n_bitmaps))
 		{
 			DiskBitmapHeader bmh;
-			grs_bitmap *bm = &GameBitmaps[i];
-			int width;
-
 			DiskBitmapHeader_read(&bmh, ifile);
 
-			width = bmh.width + (static_cast<short>(bmh.wh_extra & 0x0f) << 8);
-			gr_set_bitmap_data(*bm, NULL);	// free ogl texture
-			gr_init_bitmap(*bm, bm_mode::linear, 0, 0, width, bmh.height + (static_cast<short>(bmh.wh_extra & 0xf0) << 4), width, NULL);
-			bm->avg_color = bmh.avg_color;
-			bm->bm_data = reinterpret_cast<uint8_t *>(static_cast<uintptr_t>(bmh.offset));
-
-			gr_set_bitmap_flags(*bm, bmh.flags & BM_FLAGS_TO_COPY);
-
-			GameBitmapOffset[i] = 0; // don't try to read bitmap from current pigfile
+			const uint16_t width = bmh.width + (static_cast<short>(bmh.wh_extra & 0x0f) << 8);
+			const uint16_t height = bmh.height + (static_cast<short>(bmh.wh_extra & 0xf0) << 4);
+			set->entries.emplace_back(bitmap_replacement{i, width, height, static_cast<uint8_t>(bmh.flags & BM_FLAGS_TO_COPY), 0, bmh.avg_color, static_cast<std::size_t>(bmh.offset)});
 		}
 
-		PHYSFS_read(ifile,Bitmap_replacement_data,1,bitmap_data_size);
-
-		range_for (const auto i, unchecked_partial_range(indices.get(), n_bitmaps))
-		{
-			grs_bitmap *bm = &GameBitmaps[i];
-			gr_set_bitmap_data(*bm, &Bitmap_replacement_data[reinterpret_cast<uintptr_t>(bm->bm_data)]);
-		}
-		last_palette_loaded_pig[0]= 0;  //force pig re-load
-		texmerge_flush();       //for re-merging with new textures
+		PHYSFS_read(ifile, set->data.get(), 1, bitmap_data_size);
 	}
+	bitmap_replacements_apply(bitmap_replacement_insert(std::move(set)));
 }
 
 /* calculate table to translate d1 bitmaps to current palette,
@@ -1988,11 +2573,19 @@ void load_d1_bitmap_replacements()
 #define D1_PIG_LOAD_FAILED "Failed loading " D1_PIGFILE
 	if (!d1_Piggy_fp) {
 		Warning(D1_PIG_LOAD_FAILED);
+		bitmap_replacements_apply(nullptr);
 		return;
 	}
 
-	//first, free up data allocated for old bitmaps
-	free_bitmap_replacements();
+	/* The colormap maps to the palette of the level. */
+	fnv1a_hash palette;
+	palette.add(gr_palette);
+	auto set = make_unique<bitmap_replacement_set>();
+	if (const auto cached = bitmap_replacement_find(*set, D1_PIGFILE, d1_Piggy_fp, palette.get()))
+	{
+		bitmap_replacements_apply(cached);
+		return;
+	}
 
 	array<color_t, 256> colormap;
 	if (get_d1_colormap( d1_palette, colormap ) != 0)
@@ -2033,13 +2626,11 @@ void load_d1_bitmap_replacements()
 		bitmap_data_start = bitmap_header_start + header_size;
 	}
 
-	Bitmap_replacement_data = make_unique<ubyte[]>(D1_BITMAPS_SIZE);
-	if (!Bitmap_replacement_data) {
-		Warning(D1_PIG_LOAD_FAILED);
-		return;
-	}
+	set->data = make_unique<ubyte[]>(D1_BITMAPS_SIZE);
+	set->account.set(D1_BITMAPS_SIZE);
+	set->sets_pig_flags = true;
 
-	next_bitmap = Bitmap_replacement_data.get();
+	next_bitmap = set->data.get();
 
 	for (d1_index = 1; d1_index <= N_bitmaps; d1_index++ ) {
 		d2_index = d2_index_for_d1_index(d1_index);
@@ -2048,10 +2639,11 @@ void load_d1_bitmap_replacements()
 			PHYSFSX_fseek(d1_Piggy_fp, bitmap_header_start + (d1_index-1) * DISKBITMAPHEADER_D1_SIZE, SEEK_SET);
 			DiskBitmapHeader_d1_read(&bmh, d1_Piggy_fp);
 
-			bitmap_read_d1( &GameBitmaps[d2_index], d1_Piggy_fp, bitmap_data_start, &bmh, &next_bitmap, d1_palette, colormap );
-			Assert(next_bitmap - Bitmap_replacement_data.get() < D1_BITMAPS_SIZE);
-			GameBitmapOffset[d2_index] = 0; // don't try to read bitmap from current d2 pigfile
-			GameBitmapFlags[d2_index] = bmh.flags;
+			grs_bitmap bm{};
+			bitmap_read_d1( &bm, d1_Piggy_fp, bitmap_data_start, &bmh, &next_bitmap, d1_palette, colormap );
+			Assert(next_bitmap - set->data.get() < D1_BITMAPS_SIZE);
+			bitmap_replacement e{static_cast<uint16_t>(d2_index), bm.bm_w, bm.bm_h, bm.get_flags(), bmh.flags, bm.avg_color, static_cast<std::size_t>(bm.get_bitmap_data() - set->data.get())};
+			set->entries.emplace_back(e);
 
 			auto &abname = AllBitmaps[d2_index].name;
 			if ((p = strchr(abname.data(), '#')) /* d2 BM is animated */
@@ -2060,17 +2652,13 @@ void load_d1_bitmap_replacements()
 				for (i = 0; i < Num_bitmap_files; i++)
 					if (i != d2_index && ! memcmp(abname.data(), AllBitmaps[i].name.data(), len))
 					{
-						gr_set_bitmap_data(GameBitmaps[i], NULL);	// free ogl texture
-						GameBitmaps[i] = GameBitmaps[d2_index];
-						GameBitmapOffset[i] = 0;
-						GameBitmapFlags[i] = bmh.flags;
+						e.index = i;
+						set->entries.emplace_back(e);
 					}
 			}
 		}
 	}
-	last_palette_loaded_pig[0]= 0;  //force pig re-load
-
-	texmerge_flush();       //for re-merging with new textures
+	bitmap_replacements_apply(bitmap_replacement_insert(std::move(set)));
 }
 
 
@@ -23,7 +23,9 @@ COPYRIGHT 1993-1999 PARALLAX SOFTWARE CORPORATION.  ALL RIGHTS RESERVED.
  *
  */
 
+#include <memory>
 #include <stdexcept>
+#include <string>
 #include <stdio.h>
 #include <string.h>
 #if !defined(_MSC_VER) && !defined(macintosh)
@@ -32,6 +34,7 @@ COPYRIGHT 1993-1999 PARALLAX SOFTWARE CORPORATION.  ALL RIGHTS RESERVED.
 #include <errno.h>
 #include <ctype.h>
 #include <inttypes.h>
+#include <SDL.h>
 
 #include "dxxerror.h"
 #include "strutil.h"
@@ -193,6 +196,80 @@ static array<saved_game_sw, N_SAVE_SLOTS> saved_games;
 static inline void plyr_read_stats() {}
 static int get_lifetime_checksum (int a,int b);
 #endif
+
+namespace {
+
+/* Everything the .plr and .plx files are written from. */
+struct player_file_contents
+{
+	callsign_t callsign;
+	player_config cfg;
+#if defined(DXX_BUILD_DESCENT_I)
+	array<saved_game_sw, N_SAVE_SLOTS> saved_games;
+#endif
+};
+
+/* The profile as it is on disk, or will be once the pending write
+ * finishes.  read_player_file restores from this instead of reading the
+ * files again, and write_player_file skips writing an unchanged
+ * profile.
+ */
+struct player_file_cache_state
+{
+	bool valid;
+	player_file_contents contents;
+};
+
+struct player_file_writer_state
+{
+	SDL_Thread *thread;
+	std::string error;
+	player_file_contents contents;
+};
+
+}
+
+static player_file_cache_state player_file_cache;
+static player_file_writer_state player_file_writer;
+
+/* player_config is copied bytewise so that unchanged padding compares
+ * equal.
+ */
+static void player_file_capture(player_file_contents &c)
+{
+	c.callsign = get_local_player().callsign;
+	std::memcpy(std::addressof(c.cfg), std::addressof(PlayerCfg), sizeof(PlayerCfg));
+#if defined(DXX_BUILD_DESCENT_I)
+	c.saved_games = saved_games;
+#endif
+}
+
+static void player_file_copy(player_file_contents &dst, const player_file_contents &src)
+{
+	dst.callsign = src.callsign;
+	std::memcpy(std::addressof(dst.cfg), std::addressof(src.cfg), sizeof(dst.cfg));
+#if defined(DXX_BUILD_DESCENT_I)
+	dst.saved_games = src.saved_games;
+#endif
+}
+
+static void player_file_restore(const player_file_contents &c)
+{
+	std::memcpy(std::addressof(PlayerCfg), std::addressof(c.cfg), sizeof(PlayerCfg));
+#if defined(DXX_BUILD_DESCENT_I)
+	saved_games = c.saved_games;
+#endif
+}
+
+static bool player_file_same(const player_file_contents &a, const player_file_contents &b)
+{
+	return a.callsign.a == b.callsign.a &&
+		!std::memcmp(std::addressof(a.cfg), std::addressof(b.cfg), sizeof(a.cfg))
+#if defined(DXX_BUILD_DESCENT_I)
+		&& !std::memcmp(a.saved_games.data(), b.saved_games.data(), sizeof(a.saved_games))
+#endif
+		;
+}
 }
 
 template <std::size_t N>
@@ -656,6 +733,12 @@ void plyr_save_stats()
 	char filename[PATH_MAX];
 	array<uint8_t, 16> buf, buf2;
 	uint8_t a;
+	auto &cache = player_file_cache;
+	if (cache.valid && cache.contents.callsign.a == get_local_player().callsign.a)
+	{
+		cache.contents.cfg.NetlifeKills = PlayerCfg.NetlifeKills;
+		cache.contents.cfg.NetlifeKilled = PlayerCfg.NetlifeKilled;
+	}
 	memset(filename, '\0', PATH_MAX);
 	snprintf(filename,sizeof(filename),PLAYER_EFFECTIVENESS_FILENAME_FORMAT,static_cast<const char *>(get_local_player().callsign));
 	auto f = PHYSFSX_openWriteBuffered(filename);
@@ -725,7 +808,7 @@ void plyr_save_stats()
 }
 #endif
 
-static int write_player_dxx(const char *filename)
+static int write_player_dxx(const char *filename, const player_config &cfg)
 {
 	int rc=0;
 	char tempfile[PATH_MAX];
@@ -745,71 +828,71 @@ static int write_player_dxx(const char *filename)
 		PHYSFSX_printf(fout,PLX_OPTION_HEADER_TEXT "\n");
 #if defined(DXX_BUILD_DESCENT_I)
 		PHYSFSX_printf(fout,WEAPON_REORDER_HEADER_TEXT "\n");
-		PHYSFSX_printf(fout,WEAPON_REORDER_PRIMARY_NAME_TEXT "=" WEAPON_REORDER_PRIMARY_VALUE_TEXT "\n",PlayerCfg.PrimaryOrder[0], PlayerCfg.PrimaryOrder[1], PlayerCfg.PrimaryOrder[2],PlayerCfg.PrimaryOrder[3], PlayerCfg.PrimaryOrder[4], PlayerCfg.PrimaryOrder[5]);
-		PHYSFSX_printf(fout,WEAPON_REORDER_SECONDARY_NAME_TEXT "=" WEAPON_REORDER_SECONDARY_VALUE_TEXT "\n",PlayerCfg.SecondaryOrder[0], PlayerCfg.SecondaryOrder[1], PlayerCfg.SecondaryOrder[2],PlayerCfg.SecondaryOrder[3], PlayerCfg.SecondaryOrder[4], PlayerCfg.SecondaryOrder[5]);
+		PHYSFSX_printf(fout,WEAPON_REORDER_PRIMARY_NAME_TEXT "=" WEAPON_REORDER_PRIMARY_VALUE_TEXT "\n",cfg.PrimaryOrder[0], cfg.PrimaryOrder[1], cfg.PrimaryOrder[2],cfg.PrimaryOrder[3], cfg.PrimaryOrder[4], cfg.PrimaryOrder[5]);
+		PHYSFSX_printf(fout,WEAPON_REORDER_SECONDARY_NAME_TEXT "=" WEAPON_REORDER_SECONDARY_VALUE_TEXT "\n",cfg.SecondaryOrder[0], cfg.SecondaryOrder[1], cfg.SecondaryOrder[2],cfg.SecondaryOrder[3], cfg.SecondaryOrder[4], cfg.SecondaryOrder[5]);
 		PHYSFSX_printf(fout,END_TEXT "\n");
 #endif
 		PHYSFSX_printf(fout,KEYBOARD_HEADER_TEXT "\n");
-		print_pattern_array(fout, SENSITIVITY_NAME_TEXT, PlayerCfg.KeyboardSens);
+		print_pattern_array(fout, SENSITIVITY_NAME_TEXT, cfg.KeyboardSens);
 		PHYSFSX_printf(fout,END_TEXT "\n");
 		PHYSFSX_printf(fout,JOYSTICK_HEADER_TEXT "\n");
-		print_pattern_array(fout, SENSITIVITY_NAME_TEXT, PlayerCfg.JoystickSens);
-		print_pattern_array(fout, LINEAR_NAME_TEXT, PlayerCfg.JoystickLinear);
-		print_pattern_array(fout, SPEED_NAME_TEXT, PlayerCfg.JoystickSpeed);
-		print_pattern_array(fout, DEADZONE_NAME_TEXT, PlayerCfg.JoystickDead);
+		print_pattern_array(fout, SENSITIVITY_NAME_TEXT, cfg.JoystickSens);
+		print_pattern_array(fout, LINEAR_NAME_TEXT, cfg.JoystickLinear);
+		print_pattern_array(fout, SPEED_NAME_TEXT, cfg.JoystickSpeed);
+		print_pattern_array(fout, DEADZONE_NAME_TEXT, cfg.JoystickDead);
 		PHYSFSX_printf(fout,END_TEXT "\n");
 		PHYSFSX_printf(fout,MOUSE_HEADER_TEXT "\n");
-		PHYSFSX_printf(fout,MOUSE_FLIGHTSIM_NAME_TEXT "=" MOUSE_FLIGHTSIM_VALUE_TEXT "\n",PlayerCfg.MouseFlightSim);
-		print_pattern_array(fout, SENSITIVITY_NAME_TEXT, PlayerCfg.MouseSens);
-                print_pattern_array(fout, MOUSE_OVERRUN_NAME_TEXT, PlayerCfg.MouseOverrun);
-		PHYSFSX_printf(fout,MOUSE_FSDEAD_NAME_TEXT "=" MOUSE_FSDEAD_VALUE_TEXT "\n",PlayerCfg.MouseFSDead);
-		PHYSFSX_printf(fout,MOUSE_FSINDICATOR_NAME_TEXT "=" MOUSE_FSINDICATOR_VALUE_TEXT "\n",PlayerCfg.MouseFSIndicator);
+		PHYSFSX_printf(fout,MOUSE_FLIGHTSIM_NAME_TEXT "=" MOUSE_FLIGHTSIM_VALUE_TEXT "\n",cfg.MouseFlightSim);
+		print_pattern_array(fout, SENSITIVITY_NAME_TEXT, cfg.MouseSens);
+                print_pattern_array(fout, MOUSE_OVERRUN_NAME_TEXT, cfg.MouseOverrun);
+		PHYSFSX_printf(fout,MOUSE_FSDEAD_NAME_TEXT "=" MOUSE_FSDEAD_VALUE_TEXT "\n",cfg.MouseFSDead);
+		PHYSFSX_printf(fout,MOUSE_FSINDICATOR_NAME_TEXT "=" MOUSE_FSINDICATOR_VALUE_TEXT "\n",cfg.MouseFSIndicator);
 		PHYSFSX_printf(fout,END_TEXT "\n");
 		PHYSFSX_printf(fout,WEAPON_KEYv2_HEADER_TEXT "\n");
-		PHYSFSX_printf(fout,"1=" WEAPON_KEYv2_VALUE_TEXT "\n",PlayerCfg.KeySettingsRebirth[0],PlayerCfg.KeySettingsRebirth[1],PlayerCfg.KeySettingsRebirth[2]);
-		PHYSFSX_printf(fout,"2=" WEAPON_KEYv2_VALUE_TEXT "\n",PlayerCfg.KeySettingsRebirth[3],PlayerCfg.KeySettingsRebirth[4],PlayerCfg.KeySettingsRebirth[5]);
-		PHYSFSX_printf(fout,"3=" WEAPON_KEYv2_VALUE_TEXT "\n",PlayerCfg.KeySettingsRebirth[6],PlayerCfg.KeySettingsRebirth[7],PlayerCfg.KeySettingsRebirth[8]);
-		PHYSFSX_printf(fout,"4=" WEAPON_KEYv2_VALUE_TEXT "\n",PlayerCfg.KeySettingsRebirth[9],PlayerCfg.KeySettingsRebirth[10],PlayerCfg.KeySettingsRebirth[11]);
-		PHYSFSX_printf(fout,"5=" WEAPON_KEYv2_VALUE_TEXT "\n",PlayerCfg.KeySettingsRebirth[12],PlayerCfg.KeySettingsRebirth[13],PlayerCfg.KeySettingsRebirth[14]);
-		PHYSFSX_printf(fout,"6=" WEAPON_KEYv2_VALUE_TEXT "\n",PlayerCfg.KeySettingsRebirth[15],PlayerCfg.KeySettingsRebirth[16],PlayerCfg.KeySettingsRebirth[17]);
-		PHYSFSX_printf(fout,"7=" WEAPON_KEYv2_VALUE_TEXT "\n",PlayerCfg.KeySettingsRebirth[18],PlayerCfg.KeySettingsRebirth[19],PlayerCfg.KeySettingsRebirth[20]);
-		PHYSFSX_printf(fout,"8=" WEAPON_KEYv2_VALUE_TEXT "\n",PlayerCfg.KeySettingsRebirth[21],PlayerCfg.KeySettingsRebirth[22],PlayerCfg.KeySettingsRebirth[23]);
-		PHYSFSX_printf(fout,"9=" WEAPON_KEYv2_VALUE_TEXT "\n",PlayerCfg.KeySettingsRebirth[24],PlayerCfg.KeySettingsRebirth[25],PlayerCfg.KeySettingsRebirth[26]);
-		PHYSFSX_printf(fout,"0=" WEAPON_KEYv2_VALUE_TEXT "\n",PlayerCfg.KeySettingsRebirth[27],PlayerCfg.KeySettingsRebirth[28],PlayerCfg.KeySettingsRebirth[29]);
+		PHYSFSX_printf(fout,"1=" WEAPON_KEYv2_VALUE_TEXT "\n",cfg.KeySettingsRebirth[0],cfg.KeySettingsRebirth[1],cfg.KeySettingsRebirth[2]);
+		PHYSFSX_printf(fout,"2=" WEAPON_KEYv2_VALUE_TEXT "\n",cfg.KeySettingsRebirth[3],cfg.KeySettingsRebirth[4],cfg.KeySettingsRebirth[5]);
+		PHYSFSX_printf(fout,"3=" WEAPON_KEYv2_VALUE_TEXT "\n",cfg.KeySettingsRebirth[6],cfg.KeySettingsRebirth[7],cfg.KeySettingsRebirth[8]);
+		PHYSFSX_printf(fout,"4=" WEAPON_KEYv2_VALUE_TEXT "\n",cfg.KeySettingsRebirth[9],cfg.KeySettingsRebirth[10],cfg.KeySettingsRebirth[11]);
+		PHYSFSX_printf(fout,"5=" WEAPON_KEYv2_VALUE_TEXT "\n",cfg.KeySettingsRebirth[12],cfg.KeySettingsRebirth[13],cfg.KeySettingsRebirth[14]);
+		PHYSFSX_printf(fout,"6=" WEAPON_KEYv2_VALUE_TEXT "\n",cfg.KeySettingsRebirth[15],cfg.KeySettingsRebirth[16],cfg.KeySettingsRebirth[17]);
+		PHYSFSX_printf(fout,"7=" WEAPON_KEYv2_VALUE_TEXT "\n",cfg.KeySettingsRebirth[18],cfg.KeySettingsRebirth[19],cfg.KeySettingsRebirth[20]);
+		PHYSFSX_printf(fout,"8=" WEAPON_KEYv2_VALUE_TEXT "\n",cfg.KeySettingsRebirth[21],cfg.KeySettingsRebirth[22],cfg.KeySettingsRebirth[23]);
+		PHYSFSX_printf(fout,"9=" WEAPON_KEYv2_VALUE_TEXT "\n",cfg.KeySettingsRebirth[24],cfg.KeySettingsRebirth[25],cfg.KeySettingsRebirth[26]);
+		PHYSFSX_printf(fout,"0=" WEAPON_KEYv2_VALUE_TEXT "\n",cfg.KeySettingsRebirth[27],cfg.KeySettingsRebirth[28],cfg.KeySettingsRebirth[29]);
 		PHYSFSX_printf(fout,END_TEXT "\n");
 		PHYSFSX_printf(fout,COCKPIT_HEADER_TEXT "\n");
 #if defined(DXX_BUILD_DESCENT_I)
-		PHYSFSX_printf(fout,COCKPIT_MODE_NAME_TEXT "=%i\n",PlayerCfg.CockpitMode[0]);
+		PHYSFSX_printf(fout,COCKPIT_MODE_NAME_TEXT "=%i\n",cfg.CockpitMode[0]);
 #endif
-		PHYSFSX_printf(fout,COCKPIT_HUD_NAME_TEXT "=%u\n", static_cast<unsigned>(PlayerCfg.HudMode));
-		PHYSFSX_printf(fout,COCKPIT_RETICLE_TYPE_NAME_TEXT "=%i\n",PlayerCfg.ReticleType);
-		PHYSFSX_printf(fout,COCKPIT_RETICLE_COLOR_NAME_TEXT "=%i,%i,%i,%i\n",PlayerCfg.ReticleRGBA[0],PlayerCfg.ReticleRGBA[1],PlayerCfg.ReticleRGBA[2],PlayerCfg.ReticleRGBA[3]);
-		PHYSFSX_printf(fout,COCKPIT_RETICLE_SIZE_NAME_TEXT "=%i\n",PlayerCfg.ReticleSize);
+		PHYSFSX_printf(fout,COCKPIT_HUD_NAME_TEXT "=%u\n", static_cast<unsigned>(cfg.HudMode));
+		PHYSFSX_printf(fout,COCKPIT_RETICLE_TYPE_NAME_TEXT "=%i\n",cfg.ReticleType);
+		PHYSFSX_printf(fout,COCKPIT_RETICLE_COLOR_NAME_TEXT "=%i,%i,%i,%i\n",cfg.ReticleRGBA[0],cfg.ReticleRGBA[1],cfg.ReticleRGBA[2],cfg.ReticleRGBA[3]);
+		PHYSFSX_printf(fout,COCKPIT_RETICLE_SIZE_NAME_TEXT "=%i\n",cfg.ReticleSize);
 		PHYSFSX_printf(fout,END_TEXT "\n");
 		PHYSFSX_printf(fout,TOGGLES_HEADER_TEXT "\n");
 #if defined(DXX_BUILD_DESCENT_I)
-		PHYSFSX_printf(fout,TOGGLES_BOMBGAUGE_NAME_TEXT "=%i\n",PlayerCfg.BombGauge);
+		PHYSFSX_printf(fout,TOGGLES_BOMBGAUGE_NAME_TEXT "=%i\n",cfg.BombGauge);
 #elif defined(DXX_BUILD_DESCENT_II)
-		PHYSFSX_printf(fout,TOGGLES_ESCORTHOTKEYS_NAME_TEXT "=%i\n",PlayerCfg.EscortHotKeys);
-		PHYSFSX_printf(fout, TOGGLES_THIEF_ABSENCE_SP "=%i\n", PlayerCfg.ThiefModifierFlags & ThiefModifier::Absent);
-		PHYSFSX_printf(fout, TOGGLES_THIEF_NO_ENERGY_WEAPONS_SP "=%i\n", PlayerCfg.ThiefModifierFlags & ThiefModifier::NoEnergyWeapons);
+		PHYSFSX_printf(fout,TOGGLES_ESCORTHOTKEYS_NAME_TEXT "=%i\n",cfg.EscortHotKeys);
+		PHYSFSX_printf(fout, TOGGLES_THIEF_ABSENCE_SP "=%i\n", cfg.ThiefModifierFlags & ThiefModifier::Absent);
+		PHYSFSX_printf(fout, TOGGLES_THIEF_NO_ENERGY_WEAPONS_SP "=%i\n", cfg.ThiefModifierFlags & ThiefModifier::NoEnergyWeapons);
 #endif
-		PHYSFSX_printf(fout,TOGGLES_PERSISTENTDEBRIS_NAME_TEXT "=%i\n",PlayerCfg.PersistentDebris);
-		PHYSFSX_printf(fout,TOGGLES_PRSHOT_NAME_TEXT "=%i\n",PlayerCfg.PRShot);
-		PHYSFSX_printf(fout,TOGGLES_NOREDUNDANCY_NAME_TEXT "=%i\n",PlayerCfg.NoRedundancy);
-		PHYSFSX_printf(fout,TOGGLES_MULTIMESSAGES_NAME_TEXT "=%i\n",PlayerCfg.MultiMessages);
-		PHYSFSX_printf(fout,TOGGLES_MULTIPINGHUD_NAME_TEXT "=%i\n",PlayerCfg.MultiPingHud);
-		PHYSFSX_printf(fout,TOGGLES_NORANKINGS_NAME_TEXT "=%i\n",PlayerCfg.NoRankings);
-		PHYSFSX_printf(fout,TOGGLES_AUTOMAPFREEFLIGHT_NAME_TEXT "=%i\n",PlayerCfg.AutomapFreeFlight);
-		PHYSFSX_printf(fout,TOGGLES_NOFIREAUTOSELECT_NAME_TEXT "=%i\n",static_cast<unsigned>(PlayerCfg.NoFireAutoselect));
-		PHYSFSX_printf(fout,TOGGLES_CYCLEAUTOSELECTONLY_NAME_TEXT "=%i\n",PlayerCfg.CycleAutoselectOnly);
-                PHYSFSX_printf(fout,TOGGLES_CLOAKINVULTIMER_NAME_TEXT "=%i\n",PlayerCfg.CloakInvulTimer);
-		PHYSFSX_printf(fout,TOGGLES_RESPAWN_ANY_KEY "=%i\n",static_cast<unsigned>(PlayerCfg.RespawnMode));
-		PHYSFSX_printf(fout, TOGGLES_MOUSELOOK "=%i\n", PlayerCfg.MouselookFlags);
+		PHYSFSX_printf(fout,TOGGLES_PERSISTENTDEBRIS_NAME_TEXT "=%i\n",cfg.PersistentDebris);
+		PHYSFSX_printf(fout,TOGGLES_PRSHOT_NAME_TEXT "=%i\n",cfg.PRShot);
+		PHYSFSX_printf(fout,TOGGLES_NOREDUNDANCY_NAME_TEXT "=%i\n",cfg.NoRedundancy);
+		PHYSFSX_printf(fout,TOGGLES_MULTIMESSAGES_NAME_TEXT "=%i\n",cfg.MultiMessages);
+		PHYSFSX_printf(fout,TOGGLES_MULTIPINGHUD_NAME_TEXT "=%i\n",cfg.MultiPingHud);
+		PHYSFSX_printf(fout,TOGGLES_NORANKINGS_NAME_TEXT "=%i\n",cfg.NoRankings);
+		PHYSFSX_printf(fout,TOGGLES_AUTOMAPFREEFLIGHT_NAME_TEXT "=%i\n",cfg.AutomapFreeFlight);
+		PHYSFSX_printf(fout,TOGGLES_NOFIREAUTOSELECT_NAME_TEXT "=%i\n",static_cast<unsigned>(cfg.NoFireAutoselect));
+		PHYSFSX_printf(fout,TOGGLES_CYCLEAUTOSELECTONLY_NAME_TEXT "=%i\n",cfg.CycleAutoselectOnly);
+                PHYSFSX_printf(fout,TOGGLES_CLOAKINVULTIMER_NAME_TEXT "=%i\n",cfg.CloakInvulTimer);
+		PHYSFSX_printf(fout,TOGGLES_RESPAWN_ANY_KEY "=%i\n",static_cast<unsigned>(cfg.RespawnMode));
+		PHYSFSX_printf(fout, TOGGLES_MOUSELOOK "=%i\n", cfg.MouselookFlags);
 		PHYSFSX_printf(fout,END_TEXT "\n");
 		PHYSFSX_printf(fout,GRAPHICS_HEADER_TEXT "\n");
-		PHYSFSX_printf(fout,GRAPHICS_ALPHAEFFECTS_NAME_TEXT "=%i\n",PlayerCfg.AlphaEffects);
-		PHYSFSX_printf(fout,GRAPHICS_DYNLIGHTCOLOR_NAME_TEXT "=%i\n",PlayerCfg.DynLightColor);
+		PHYSFSX_printf(fout,GRAPHICS_ALPHAEFFECTS_NAME_TEXT "=%i\n",cfg.AlphaEffects);
+		PHYSFSX_printf(fout,GRAPHICS_DYNLIGHTCOLOR_NAME_TEXT "=%i\n",cfg.DynLightColor);
 		PHYSFSX_printf(fout,END_TEXT "\n");
 		PHYSFSX_printf(fout,PLX_VERSION_HEADER_TEXT "\n");
 		PHYSFSX_printf(fout,"plx version=" DXX_VERSION_STR "\n");
@@ -845,6 +928,15 @@ int read_player_file()
 
 	Assert(Player_num < MAX_PLAYERS);
 
+	auto &cache = player_file_cache;
+	if (cache.valid && cache.contents.callsign.a == get_local_player().callsign.a)
+	{
+		player_file_restore(cache.contents);
+		kc_set_controls();
+		return EZERO;
+	}
+	player_file_wait_for_writes();
+
 	memset(filename, '\0', PATH_MAX);
 	snprintf(filename, sizeof(filename), PLAYER_DIRECTORY_STRING("%.8s.plr"), static_cast<const char *>(get_local_player().callsign));
 	if (!PHYSFSX_exists(filename,0))
@@ -1145,16 +1237,18 @@ int read_player_file()
 	}
 #endif
 
-#if defined(DXX_BUILD_DESCENT_II)
-	if (rewrite_it)
-		write_player_file();
-#endif
-
 	filename[strlen(filename) - 4] = 0;
 	strcat(filename, ".plx");
 	read_player_dxx(filename);
 	kc_set_controls();
 
+#if defined(DXX_BUILD_DESCENT_II)
+	if (rewrite_it)
+		write_player_file();
+#endif
+	player_file_capture(cache.contents);
+	cache.valid = true;
+
 	return EZERO;
 
  read_player_file_failed:
@@ -1221,59 +1315,45 @@ int get_highest_level(void)
 	return i;
 }
 
-//write out player's saved games.  returns errno (0 == no error)
 namespace dsx {
-void write_player_file()
+/* Write the .plr file.  Returns the reason for a failure that the user
+ * should see, or an empty string.  Runs on the player file writer
+ * thread, so it must not touch anything but contents.
+ */
+static std::string write_player_plr(const char *const filename, const player_file_contents &contents)
 {
-	char filename[PATH_MAX];
-	int errno_ret;
-
-	if ( Newdemo_state == ND_STATE_PLAYBACK )
-		return;
-
-	errno_ret = WriteConfigFile();
-
-	auto &plr = get_local_player();
-	snprintf(filename, sizeof(filename), PLAYER_DIRECTORY_STRING("%.8s.plx"), static_cast<const char *>(plr.callsign));
-	write_player_dxx(filename);
-	snprintf(filename, sizeof(filename), PLAYER_DIRECTORY_STRING("%.8s.plr"), static_cast<const char *>(plr.callsign));
+	auto &cfg = contents.cfg;
 	auto file = PHYSFSX_openWriteBuffered(filename);
 	if (!file)
-		return;
+		return {};
 
 	//Write out player's info
 	PHYSFS_writeULE32(file, SAVE_FILE_ID);
 #if defined(DXX_BUILD_DESCENT_I)
 	PHYSFS_writeULE16(file, SAVED_GAME_VERSION);
 	PHYSFS_writeULE16(file, PLAYER_STRUCT_VERSION);
-	PHYSFS_writeSLE32(file, PlayerCfg.NHighestLevels);
-	PHYSFS_writeSLE32(file, PlayerCfg.DefaultDifficulty);
-	PHYSFS_writeSLE32(file, PlayerCfg.AutoLeveling);
-	errno_ret = EZERO;
+	PHYSFS_writeSLE32(file, cfg.NHighestLevels);
+	PHYSFS_writeSLE32(file, cfg.DefaultDifficulty);
+	PHYSFS_writeSLE32(file, cfg.AutoLeveling);
+	int errno_ret = EZERO;
 
 	//write higest level info
-	if ((PHYSFS_write( file, PlayerCfg.HighestLevels, sizeof(hli), PlayerCfg.NHighestLevels) != PlayerCfg.NHighestLevels)) {
-		errno_ret = errno;
-		return;
-	}
+	if ((PHYSFS_write( file, cfg.HighestLevels, sizeof(hli), cfg.NHighestLevels) != cfg.NHighestLevels))
+		return {};
 
-	if (PHYSFS_write( file, saved_games,sizeof(saved_games),1) != 1) {
-		errno_ret = errno;
-		return;
-	}
+	if (PHYSFS_write( file, contents.saved_games,sizeof(contents.saved_games),1) != 1)
+		return {};
 
-	range_for (auto &i, PlayerCfg.NetworkMessageMacro)
-		if (PHYSFS_write(file, i.data(), i.size(), 1) != 1) {
-		errno_ret = errno;
-		return;
-	}
+	range_for (auto &i, cfg.NetworkMessageMacro)
+		if (PHYSFS_write(file, i.data(), i.size(), 1) != 1)
+		return {};
 
 	//write kconfig info
 	{
-		if (PHYSFS_write(file, PlayerCfg.KeySettings.Keyboard, sizeof(PlayerCfg.KeySettings.Keyboard), 1) != 1)
+		if (PHYSFS_write(file, cfg.KeySettings.Keyboard, sizeof(cfg.KeySettings.Keyboard), 1) != 1)
 			errno_ret=errno;
 #if DXX_MAX_JOYSTICKS
-		auto &KeySettingsJoystick = PlayerCfg.KeySettings.Joystick;
+		auto &KeySettingsJoystick = cfg.KeySettings.Joystick;
 #else
 		const array<uint8_t, MAX_CONTROLS> KeySettingsJoystick{};
 #endif
@@ -1282,7 +1362,7 @@ void write_player_file()
 		for (unsigned i = 0; i < MAX_CONTROLS*3; i++)
 			if (PHYSFS_write(file, "0", sizeof(ubyte), 1) != 1) // Skip obsolete Flightstick/Thrustmaster/Gravis map fields
 				errno_ret=errno;
-		if (PHYSFS_write(file, PlayerCfg.KeySettings.Mouse, sizeof(PlayerCfg.KeySettings.Mouse), 1) != 1)
+		if (PHYSFS_write(file, cfg.KeySettings.Mouse, sizeof(cfg.KeySettings.Mouse), 1) != 1)
 			errno_ret=errno;
 		{
 			std::array<uint8_t, MAX_CONTROLS> cyberman{};
@@ -1293,7 +1373,7 @@ void write_player_file()
 		if(errno_ret == EZERO)
 		{
 			ubyte old_avg_joy_sensitivity = 8;
-			if (PHYSFS_write( file,  &PlayerCfg.ControlType, sizeof(ubyte), 1 )!=1)
+			if (PHYSFS_write( file,  &cfg.ControlType, sizeof(ubyte), 1 )!=1)
 				errno_ret=errno;
 			else if (PHYSFS_write( file, &old_avg_joy_sensitivity, sizeof(ubyte), 1 )!=1)
 				errno_ret=errno;
@@ -1305,30 +1385,30 @@ void write_player_file()
 
 	if (errno_ret != EZERO) {
 		PHYSFS_delete(filename);			//delete bogus file
-		nm_messagebox(TXT_ERROR, 1, TXT_OK, "%s\n\n%s",TXT_ERROR_WRITING_PLR, strerror(errno_ret));
+		return strerror(errno_ret);
 	}
+	return {};
 #elif defined(DXX_BUILD_DESCENT_II)
-	(void)errno_ret;
 	PHYSFS_writeULE16(file, PLAYER_FILE_VERSION);
 
 	
 	PHYSFS_seek(file,PHYSFS_tell(file)+2*(sizeof(PHYSFS_uint16))); // skip Game_window_w, Game_window_h
-	PHYSFSX_writeU8(file, PlayerCfg.DefaultDifficulty);
-	PHYSFSX_writeU8(file, PlayerCfg.AutoLeveling);
-	PHYSFSX_writeU8(file, PlayerCfg.ReticleType==RET_TYPE_NONE?0:1);
-	PHYSFSX_writeU8(file, PlayerCfg.CockpitMode[0]);
+	PHYSFSX_writeU8(file, cfg.DefaultDifficulty);
+	PHYSFSX_writeU8(file, cfg.AutoLeveling);
+	PHYSFSX_writeU8(file, cfg.ReticleType==RET_TYPE_NONE?0:1);
+	PHYSFSX_writeU8(file, cfg.CockpitMode[0]);
 	PHYSFS_seek(file,PHYSFS_tell(file)+sizeof(PHYSFS_uint8)); // skip Default_display_mode
-	PHYSFSX_writeU8(file, static_cast<uint8_t>(PlayerCfg.MissileViewEnabled));
-	PHYSFSX_writeU8(file, PlayerCfg.HeadlightActiveDefault);
-	PHYSFSX_writeU8(file, PlayerCfg.GuidedInBigWindow);
+	PHYSFSX_writeU8(file, static_cast<uint8_t>(cfg.MissileViewEnabled));
+	PHYSFSX_writeU8(file, cfg.HeadlightActiveDefault);
+	PHYSFSX_writeU8(file, cfg.GuidedInBigWindow);
 	PHYSFS_seek(file,PHYSFS_tell(file)+sizeof(PHYSFS_uint8)); // skip Automap_always_hires
 
 	//write higest level info
-	PHYSFS_writeULE16(file, PlayerCfg.NHighestLevels);
-	if ((PHYSFS_write(file, PlayerCfg.HighestLevels, sizeof(hli), PlayerCfg.NHighestLevels) != PlayerCfg.NHighestLevels))
+	PHYSFS_writeULE16(file, cfg.NHighestLevels);
+	if ((PHYSFS_write(file, cfg.HighestLevels, sizeof(hli), cfg.NHighestLevels) != cfg.NHighestLevels))
 		goto write_player_file_failed;
 
-	range_for (auto &i, PlayerCfg.NetworkMessageMacro)
+	range_for (auto &i, cfg.NetworkMessageMacro)
 		if (PHYSFS_write(file, i.data(), i.size(), 1) != 1)
 		goto write_player_file_failed;
 
@@ -1336,12 +1416,12 @@ void write_player_file()
 	{
 
 		ubyte old_avg_joy_sensitivity = 8;
-		ubyte control_type_dos = PlayerCfg.ControlType;
+		ubyte control_type_dos = cfg.ControlType;
 
-		if (PHYSFS_write(file, PlayerCfg.KeySettings.Keyboard, sizeof(PlayerCfg.KeySettings.Keyboard), 1) != 1)
+		if (PHYSFS_write(file, cfg.KeySettings.Keyboard, sizeof(cfg.KeySettings.Keyboard), 1) != 1)
 			goto write_player_file_failed;
 #if DXX_MAX_JOYSTICKS
-		auto &KeySettingsJoystick = PlayerCfg.KeySettings.Joystick;
+		auto &KeySettingsJoystick = cfg.KeySettings.Joystick;
 #else
 		const array<uint8_t, MAX_CONTROLS> KeySettingsJoystick{};
 #endif
@@ -1350,7 +1430,7 @@ void write_player_file()
 		for (unsigned i = 0; i < MAX_CONTROLS*3; i++)
 			if (PHYSFS_write(file, "0", sizeof(ubyte), 1) != 1) // Skip obsolete Flightstick/Thrustmaster/Gravis map fields
 				goto write_player_file_failed;
-		if (PHYSFS_write(file, PlayerCfg.KeySettings.Mouse, sizeof(PlayerCfg.KeySettings.Mouse), 1) != 1)
+		if (PHYSFS_write(file, cfg.KeySettings.Mouse, sizeof(cfg.KeySettings.Mouse), 1) != 1)
 			goto write_player_file_failed;
 		for (unsigned i = 0; i < MAX_CONTROLS*2; i++)
 			if (PHYSFS_write(file, "0", sizeof(ubyte), 1) != 1) // Skip obsolete Cyberman/Winjoy map fields
@@ -1365,21 +1445,21 @@ void write_player_file()
 
 		for (unsigned i = 0; i < 11; i++)
 		{
-			PHYSFS_write(file, &PlayerCfg.PrimaryOrder[i], sizeof(ubyte), 1);
-			PHYSFS_write(file, &PlayerCfg.SecondaryOrder[i], sizeof(ubyte), 1);
+			PHYSFS_write(file, &cfg.PrimaryOrder[i], sizeof(ubyte), 1);
+			PHYSFS_write(file, &cfg.SecondaryOrder[i], sizeof(ubyte), 1);
 		}
 
-		PHYSFS_writeULE32(file, PlayerCfg.Cockpit3DView[0]);
-		PHYSFS_writeULE32(file, PlayerCfg.Cockpit3DView[1]);
+		PHYSFS_writeULE32(file, cfg.Cockpit3DView[0]);
+		PHYSFS_writeULE32(file, cfg.Cockpit3DView[1]);
 
-		PHYSFS_writeULE32(file, PlayerCfg.NetlifeKills);
-		PHYSFS_writeULE32(file, PlayerCfg.NetlifeKilled);
-		int i=get_lifetime_checksum (PlayerCfg.NetlifeKills,PlayerCfg.NetlifeKilled);
+		PHYSFS_writeULE32(file, cfg.NetlifeKills);
+		PHYSFS_writeULE32(file, cfg.NetlifeKilled);
+		int i=get_lifetime_checksum (cfg.NetlifeKills,cfg.NetlifeKilled);
 		PHYSFS_writeULE32(file, i);
 	}
 
 	//write guidebot name
-	PHYSFSX_writeString(file, PlayerCfg.GuidebotNameReal);
+	PHYSFSX_writeString(file, cfg.GuidebotNameReal);
 
 	{
 		char buf[128];
@@ -1390,16 +1470,81 @@ void write_player_file()
 	if (!file.close())
 		goto write_player_file_failed;
 
-	return;
+	return {};
 
  write_player_file_failed:
-	nm_messagebox(TXT_ERROR, 1, TXT_OK, "%s\n\n%s", TXT_ERROR_WRITING_PLR, PHYSFS_getLastError());
+	const char *const e = PHYSFS_getLastError();
+	std::string error(e ? e : "");
 	if (file)
 	{
 		file.reset();
 		PHYSFS_delete(filename);        //delete bogus file
 	}
+	return error;
+#endif
+}
+
+static int player_file_write_thread(void *)
+{
+	auto &w = player_file_writer;
+	char filename[PATH_MAX];
+	snprintf(filename, sizeof(filename), PLAYER_DIRECTORY_STRING("%.8s.plx"), static_cast<const char *>(w.contents.callsign));
+	write_player_dxx(filename, w.contents.cfg);
+	snprintf(filename, sizeof(filename), PLAYER_DIRECTORY_STRING("%.8s.plr"), static_cast<const char *>(w.contents.callsign));
+	w.error = write_player_plr(filename, w.contents);
+	return 0;
+}
+
+void player_file_wait_for_writes()
+{
+	auto &w = player_file_writer;
+	if (w.thread)
+	{
+		SDL_WaitThread(w.thread, nullptr);
+		w.thread = nullptr;
+	}
+	if (w.error.empty())
+		return;
+	/* Whatever is on disk now, the next write must not be skipped. */
+	player_file_cache.valid = false;
+	std::string error;
+	swap(error, w.error);
+	nm_messagebox(TXT_ERROR, 1, TXT_OK, "%s\n\n%s", TXT_ERROR_WRITING_PLR, error.c_str());
+}
+
+void player_file_forget()
+{
+	player_file_wait_for_writes();
+	player_file_cache.valid = false;
+}
+
+//write out player's saved games.  The files are only written if they
+//changed, and are written on a worker thread.
+void write_player_file()
+{
+	if ( Newdemo_state == ND_STATE_PLAYBACK )
+		return;
+
+	WriteConfigFile();
+
+	player_file_wait_for_writes();
+	auto &w = player_file_writer;
+	auto &cache = player_file_cache;
+	player_file_capture(w.contents);
+	if (cache.valid && player_file_same(cache.contents, w.contents))
+		return;
+	player_file_copy(cache.contents, w.contents);
+	cache.valid = true;
+#if SDL_MAJOR_VERSION == 2
+	w.thread = SDL_CreateThread(player_file_write_thread, "player_file_write", nullptr);
+#else
+	w.thread = SDL_CreateThread(player_file_write_thread, nullptr);
 #endif
+	if (!w.thread)
+	{
+		player_file_write_thread(nullptr);
+		player_file_wait_for_writes();
+	}
 }
 
 #if defined(DXX_BUILD_DESCENT_II)
@@ -27,6 +27,8 @@ COPYRIGHT 1993-1999 PARALLAX SOFTWARE CORPORATION.  ALL RIGHTS RESERVED.
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <unordered_map>
+#include <vector>
 
 #include "inferno.h"
 #include "robot.h"
@@ -36,6 +38,8 @@ COPYRIGHT 1993-1999 PARALLAX SOFTWARE CORPORATION.  ALL RIGHTS RESERVED.
 #include "dxxerror.h"
 #include "u_mem.h"
 #include "args.h"
+#include "console.h"
+#include "hash.h"
 #include "physfs-serial.h"
 #include "physfsx.h"
 #ifndef DRIVE
@@ -251,6 +255,7 @@ static void align_polygon_model_data(polymodel *pm)
 			    && &pm->model_data[pm->submodel_ptrs[i]] < cur_old + chunk_len)
 				pm->submodel_ptrs[i] += (cur_new - tmp.get()) - (cur_old - pm->model_data.get());
  	}
+	mem_account(mem_tag::models, pm->model_data_size, pm->model_data_size + total_correction);
 	pm->model_data_size += total_correction;
 	pm->model_data = make_unique<ubyte[]>(pm->model_data_size);
 	Assert(pm->model_data != NULL);
@@ -397,6 +402,7 @@ static polymodel *read_model_file(polymodel *pm,const char *filename,robot_info
 			}
 			
 			case ID_IDTA:		//Interpreter data
+				mem_account(mem_tag::models, pm->model_data ? pm->model_data_size : 0, len);
 				pm->model_data_size = len;
 				pm->model_data = make_unique<ubyte[]>(pm->model_data_size);
 
@@ -412,12 +418,6 @@ static polymodel *read_model_file(polymodel *pm,const char *filename,robot_info
 		if ( version >= 8 )		// Version 8 needs 4-byte alignment!!!
 			pof_cfseek(model_buf,next_chunk,SEEK_SET);
 	}
-
-#if DXX_WORDS_NEED_ALIGNMENT
-	align_polygon_model_data(pm);
-#endif
-	if (words_bigendian)
-	swap_polygon_model_data(pm->model_data.get());
 	return pm;
 }
 
@@ -484,12 +484,48 @@ void read_model_guns(const char *filename, reactor &r)
 	r.n_guns = n_guns;
 }
 
+namespace {
+
+/* The draw list compiled from a model's data, built the first time the
+ * model is drawn.  source is the model data it was compiled from.
+ */
+struct polygon_model_draw_list
+{
+	const uint8_t *source = nullptr;
+	bool usable = false;
+	polymodel_draw_list list;
+};
+
+}
+
+static std::unordered_map<const polymodel *, polygon_model_draw_list> Polygon_model_draw_lists;
+
+static const polymodel_draw_list *get_polygon_model_draw_list(const polymodel &po)
+{
+	const auto data = po.model_data.get();
+	if (!data)
+		return nullptr;
+	auto &d = Polygon_model_draw_lists[&po];
+	if (d.source != data)
+	{
+		d.source = data;
+		d.usable = g3_build_polygon_model_draw_list(data, d.list);
+	}
+	return d.usable ? &d.list : nullptr;
+}
+
 //free up a model, getting rid of all its memory
 #if defined(DXX_BUILD_DESCENT_I)
 static
 #endif
 void free_model(polymodel &po)
 {
+#if DXX_USE_OGL
+	ogl_free_polygon_model_mesh(po);
+#endif
+	Polygon_model_draw_lists.erase(&po);
+	if (po.model_data)
+		mem_account(mem_tag::models, po.model_data_size, 0);
 	po.model_data.reset();
 }
 
@@ -547,8 +583,17 @@ void draw_polygon_model(grs_canvas &canvas, const vms_vector &pos, const vms_mat
 	polygon_model_points robot_points;
 
 	if (flags == 0)		//draw entire object
-
-		g3_draw_polygon_model(&texture_list[0], robot_points, canvas, anim_angles, light, glow_values, po->model_data.get());
+	{
+#if DXX_USE_OGL
+		if (!ogl_draw_polygon_model_mesh(canvas, *po, &texture_list[0], anim_angles, light, glow_values))
+#endif
+		{
+			if (const auto list = get_polygon_model_draw_list(*po))
+				g3_draw_polygon_model(*list, &texture_list[0], robot_points, canvas, anim_angles, light, glow_values);
+			else
+				g3_draw_polygon_model(&texture_list[0], robot_points, canvas, anim_angles, light, glow_values, po->model_data.get());
+		}
+	}
 
 	else {
 		for (int i=0;flags;flags>>=1,i++)
@@ -640,6 +685,235 @@ static void polyobj_find_min_max(polymodel *pm)
 	}
 }
 
+/* Polygon model data after alignment and byte swapping, and the bounds
+ * found for models read from POF files, are kept in models.bin in the
+ * write directory.  Entries are keyed by a hash of the data as read
+ * from the game files, so each model is only converted the first time
+ * it is seen.  Where this host needs no conversion, an entry holds only
+ * the bounds.  The file is read once, when the first model is loaded,
+ * and new entries are appended as they are made.
+ */
+#define POLYMODEL_CACHE_FILENAME	"models.bin"
+constexpr uint32_t polymodel_cache_magic = 0x4d505844;	// "DXPM"
+constexpr uint32_t polymodel_cache_version = 1;
+/* The conversions this build applies.  A file written by a build which
+ * converts differently is discarded.
+ */
+constexpr uint32_t polymodel_cache_host = (DXX_WORDS_BIGENDIAN ? 1 : 0) | (DXX_WORDS_NEED_ALIGNMENT ? 2 : 0);
+
+struct polymodel_cache_header
+{
+	uint64_t key;
+	// hash of the entry which follows the header
+	uint64_t check;
+	// bytes of converted model data, 0 if conversion changed nothing
+	uint32_t data_size;
+	uint32_t has_bounds;
+};
+
+struct polymodel_cache_bounds
+{
+	array<vms_vector, MAX_SUBMODELS> submodel_mins, submodel_maxs;
+	vms_vector mins, maxs;
+};
+
+struct polymodel_cache_entry
+{
+	std::size_t offset;
+	polymodel_cache_header header;
+};
+
+struct polymodel_cache_state
+{
+	bool loaded;
+	std::vector<uint8_t> data;
+	std::unordered_map<uint64_t, polymodel_cache_entry> index;
+	RAIIPHYSFS_File append;
+};
+
+static polymodel_cache_state polymodel_cache;
+
+static std::size_t polymodel_cache_entry_size(const polymodel_cache_header &h)
+{
+	return (h.data_size ? sizeof(polymodel::submodel_ptrs) + h.data_size : 0) + (h.has_bounds ? sizeof(polymodel_cache_bounds) : 0);
+}
+
+static void polymodel_cache_append(std::vector<uint8_t> &v, const void *const p, const std::size_t len)
+{
+	const auto b = reinterpret_cast<const uint8_t *>(p);
+	v.insert(v.end(), b, b + len);
+}
+
+static void polymodel_cache_load()
+{
+	auto &c = polymodel_cache;
+	c.loaded = true;
+	if (RAIIPHYSFS_File fp{PHYSFS_openRead(POLYMODEL_CACHE_FILENAME)})
+	{
+		const auto len = PHYSFS_fileLength(fp);
+		if (len > 0)
+		{
+			c.data.resize(len);
+			if (PHYSFS_read(fp, c.data.data(), 1, len) != len)
+				c.data.clear();
+		}
+	}
+	array<uint32_t, 3> file_header;
+	if (c.data.size() < sizeof(file_header) ||
+		(memcpy(file_header.data(), c.data.data(), sizeof(file_header)), file_header[0] != polymodel_cache_magic || file_header[1] != polymodel_cache_version || file_header[2] != polymodel_cache_host))
+	{
+		/* Missing, truncated, or written by another build. */
+		c.data.clear();
+		file_header = {{polymodel_cache_magic, polymodel_cache_version, polymodel_cache_host}};
+		c.append.reset(PHYSFS_openWrite(POLYMODEL_CACHE_FILENAME));
+		if (c.append && PHYSFS_write(c.append, file_header.data(), sizeof(file_header), 1) != 1)
+			c.append.reset();
+		return;
+	}
+	std::size_t offset = sizeof(file_header);
+	for (polymodel_cache_header h; offset + sizeof(h) <= c.data.size();)
+	{
+		memcpy(&h, &c.data[offset], sizeof(h));
+		offset += sizeof(h);
+		const auto size = polymodel_cache_entry_size(h);
+		if (size > c.data.size() - offset)
+			break;
+		fnv1a_hash check;
+		check.add(&c.data[offset], size);
+		if (check.get() != h.check)
+			break;
+		c.index[h.key] = polymodel_cache_entry{offset, h};
+		offset += size;
+	}
+	/* Entries after a damaged one are lost, so append only if the
+	 * whole file was read.
+	 */
+	if (offset == c.data.size())
+		c.append.reset(PHYSFS_openAppend(POLYMODEL_CACHE_FILENAME));
+	con_printf(CON_VERBOSE, "DXX-Rebirth: read %u cached polygon models from " POLYMODEL_CACHE_FILENAME, static_cast<unsigned>(c.index.size()));
+}
+
+static uint64_t polymodel_cache_key(const polymodel &pm, const bool bounds)
+{
+	fnv1a_hash h;
+	h.add(pm.model_data_size);
+	h.add(pm.model_data.get(), pm.model_data_size);
+	/* Alignment moves the submodels, and the bounds depend on where
+	 * each submodel is placed.
+	 */
+	h.add(pm.submodel_ptrs);
+	const uint8_t has_bounds = bounds;
+	h.add(has_bounds);
+	if (bounds)
+	{
+		h.add(pm.n_models);
+		h.add(pm.submodel_offsets);
+	}
+	return h.get();
+}
+
+static void polymodel_cache_apply(polymodel &pm, const polymodel_cache_entry &e)
+{
+	auto p = &polymodel_cache.data[e.offset];
+	const auto &h = e.header;
+	if (h.data_size)
+	{
+		memcpy(pm.submodel_ptrs.data(), p, sizeof(pm.submodel_ptrs));
+		p += sizeof(pm.submodel_ptrs);
+		mem_account(mem_tag::models, pm.model_data ? pm.model_data_size : 0, h.data_size);
+		pm.model_data_size = h.data_size;
+		pm.model_data = make_unique<ubyte[]>(h.data_size);
+		memcpy(pm.model_data.get(), p, h.data_size);
+		p += h.data_size;
+	}
+	if (h.has_bounds)
+	{
+		polymodel_cache_bounds b;
+		memcpy(&b, p, sizeof(b));
+		pm.submodel_mins = b.submodel_mins;
+		pm.submodel_maxs = b.submodel_maxs;
+		pm.mins = b.mins;
+		pm.maxs = b.maxs;
+	}
+}
+
+static void polymodel_cache_store(const uint64_t key, const polymodel &pm, const bool bounds)
+{
+	auto &c = polymodel_cache;
+	if (!c.append)
+		return;
+	polymodel_cache_header h{};
+	h.key = key;
+	h.data_size = polymodel_cache_host ? pm.model_data_size : 0;
+	h.has_bounds = bounds;
+	const auto offset = c.data.size();
+	if (h.data_size)
+	{
+		polymodel_cache_append(c.data, pm.submodel_ptrs.data(), sizeof(pm.submodel_ptrs));
+		polymodel_cache_append(c.data, pm.model_data.get(), h.data_size);
+	}
+	if (bounds)
+	{
+		const polymodel_cache_bounds b{pm.submodel_mins, pm.submodel_maxs, pm.mins, pm.maxs};
+		polymodel_cache_append(c.data, &b, sizeof(b));
+	}
+	const auto size = c.data.size() - offset;
+	fnv1a_hash check;
+	check.add(&c.data[offset], size);
+	h.check = check.get();
+	if (PHYSFS_write(c.append, &h, sizeof(h), 1) != 1 ||
+		(size && PHYSFS_write(c.append, &c.data[offset], size, 1) != 1))
+	{
+		con_printf(CON_URGENT, "DXX-Rebirth: failed to write " POLYMODEL_CACHE_FILENAME ": %s", PHYSFS_getLastError());
+		c.append.reset();
+		c.data.resize(offset);
+		return;
+	}
+	c.index[key] = polymodel_cache_entry{offset, h};
+}
+
+void polymodel_cache_close()
+{
+	auto &c = polymodel_cache;
+	c.append.reset();
+	c.index.clear();
+	c.data.clear();
+	c.data.shrink_to_fit();
+	c.loaded = false;
+}
+
+/* Align and byte swap model data just read from the game files, and if
+ * bounds is set, find the bounds of the model.  Both come from
+ * models.bin when this data has been seen before.
+ */
+static void polygon_model_data_convert(polymodel &pm, const bool bounds)
+{
+	const bool use_cache = !CGameArg.SysNoModelCache;
+	uint64_t key = 0;
+	if (use_cache)
+	{
+		auto &c = polymodel_cache;
+		if (!c.loaded)
+			polymodel_cache_load();
+		key = polymodel_cache_key(pm, bounds);
+		const auto i = c.index.find(key);
+		if (i != c.index.end())
+		{
+			polymodel_cache_apply(pm, i->second);
+			return;
+		}
+	}
+#if DXX_WORDS_NEED_ALIGNMENT
+	align_polygon_model_data(&pm);
+#endif
+	if (words_bigendian)
+	swap_polygon_model_data(pm.model_data.get());
+	if (bounds)
+		polyobj_find_min_max(&pm);
+	if (use_cache)
+		polymodel_cache_store(key, pm, bounds);
+}
+
 }
 
 namespace dsx {
@@ -660,7 +934,7 @@ int load_polygon_model(const char *filename,int n_textures,int first_texture,rob
 	auto &model = Polygon_models[n_models];
 	read_model_file(&model, filename, r);
 
-	polyobj_find_min_max(&model);
+	polygon_model_data_convert(model, true);
 
 	const auto highest_texture_num = g3_init_polygon_model(model.model_data.get());
 
@@ -732,13 +1006,15 @@ ASSERT_SERIAL_UDT_MESSAGE_SIZE(polymodel, 12 + (10 * 4) + (10 * 3 * sizeof(vms_v
  */
 void polymodel_read(polymodel *pm, PHYSFS_File *fp)
 {
+	if (pm->model_data)
+		mem_account(mem_tag::models, pm->model_data_size, 0);
 	pm->model_data.reset();
 	PHYSFSX_serialize_read(fp, *pm);
 }
 
 }
 
-#if 0
+#if DXX_USE_EDITOR
 void polymodel_write(PHYSFS_File *fp, const polymodel &pm)
 {
 	PHYSFSX_serialize_write(fp, pm);
@@ -751,13 +1027,13 @@ void polymodel_write(PHYSFS_File *fp, const polymodel &pm)
 namespace dsx {
 void polygon_model_data_read(polymodel *pm, PHYSFS_File *fp)
 {
+	/* polymodel_read released the previous data, and set the size of
+	 * this data.
+	 */
+	mem_account(mem_tag::models, 0, pm->model_data_size);
 	pm->model_data = make_unique<ubyte[]>(pm->model_data_size);
 	PHYSFS_read(fp, pm->model_data, sizeof(ubyte), pm->model_data_size);
-#if DXX_WORDS_NEED_ALIGNMENT
-	align_polygon_model_data(pm);
-#endif
-	if (words_bigendian)
-	swap_polygon_model_data(pm->model_data.get());
+	polygon_model_data_convert(*pm, false);
 #if defined(DXX_BUILD_DESCENT_II)
 	g3_init_polygon_model(pm->model_data.get());
 #endif
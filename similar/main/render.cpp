@@ -47,6 +47,7 @@ COPYRIGHT 1993-1999 PARALLAX SOFTWARE CORPORATION.  ALL RIGHTS RESERVED.
 #include "texmerge.h"
 #include "physics.h"
 #include "3d.h"
+#include "common/3d/globvars.h"
 #include "gameseg.h"
 #include "vclip.h"
 #include "lighting.h"
@@ -55,12 +56,16 @@ COPYRIGHT 1993-1999 PARALLAX SOFTWARE CORPORATION.  ALL RIGHTS RESERVED.
 #include "automap.h"
 #include "endlevel.h"
 #include "key.h"
+#include "kconfig.h"
 #include "newmenu.h"
 #include "u_mem.h"
 #include "piggy.h"
+#include "paging.h"
 #include "timer.h"
 #include "effects.h"
 #include "playsave.h"
+#include "console.h"
+#include "jobs.h"
 #if DXX_USE_OGL
 #include "ogl_init.h"
 #endif
@@ -70,6 +75,9 @@ COPYRIGHT 1993-1999 PARALLAX SOFTWARE CORPORATION.  ALL RIGHTS RESERVED.
 #include "compiler-range_for.h"
 #include "partial_range.h"
 #include "segiter.h"
+#include "profile.h"
+#include "level_arena.h"
+#include "frame_alloc.h"
 
 #if DXX_USE_EDITOR
 #include "editor/editor.h"
@@ -116,7 +124,7 @@ int	Bottom_bitmap_num = 9;
 namespace dcx {
 
 //Global vars for window clip test
-int Window_clip_left,Window_clip_top,Window_clip_right,Window_clip_bot;
+thread_local int Window_clip_left,Window_clip_top,Window_clip_right,Window_clip_bot;
 
 }
 
@@ -214,13 +222,40 @@ static inline int is_alphablend_eclip(int eclip_num)
 	return eclip_num == ECLIP_NUM_FUELCEN;
 }
 
+#if DXX_USE_OGL
+//	Faces which the pixel light shader does not draw get the pixel lights
+//	at their corners instead.
+static void add_pixel_lights(const unsigned nv, const array<unsigned, 4> &vp, array<g3s_lrgb, 4> &dyn_light)
+{
+	if (!LevelUniqueLightState.Num_pixel_lights)
+		return;
+	auto &Vertices = LevelSharedVertexState.get_vertices();
+	auto &vcvertptr = Vertices.vcptr;
+	for (uint_fast32_t i = 0; i < nv; i++)
+	{
+		auto &&l = compute_pixel_light(*vcvertptr(vp[i]));
+		if (PlayerCfg.AlphaEffects)
+		{
+			l.r *= .93;
+			l.g *= .93;
+			l.b *= .93;
+		}
+		auto &dli = dyn_light[i];
+		dli.r = std::min<fix>(dli.r + l.r, MAX_LIGHT);
+		dli.g = std::min<fix>(dli.g + l.g, MAX_LIGHT);
+		dli.b = std::min<fix>(dli.b + l.b, MAX_LIGHT);
+	}
+}
+#endif
+
 // ----------------------------------------------------------------------------
 //	Render a face.
 //	It would be nice to not have to pass in segnum and sidenum, but
 //	they are used for our hideously hacked in headlight system.
 //	vp is a pointer to vertex ids.
+//	corners are the side corners which vp was taken from.
 //	tmap1, tmap2 are texture map ids.  tmap2 is the pasty one.
-static void render_face(grs_canvas &canvas, const shared_segment &segp, const unsigned sidenum, const unsigned nv, const array<unsigned, 4> &vp, const unsigned tmap1, const unsigned tmap2, array<g3s_uvl, 4> uvl_copy, const WALL_IS_DOORWAY_result_t wid_flags)
+static void render_face(grs_canvas &canvas, const vcsegptridx_t segp, const unsigned sidenum, const unsigned nv, const array<unsigned, 4> &vp, const array<unsigned, 4> &corners, const unsigned tmap1, const unsigned tmap2, array<g3s_uvl, 4> uvl_copy, const WALL_IS_DOORWAY_result_t wid_flags)
 {
 	auto &TmapInfo = LevelUniqueTmapInfoState.TmapInfo;
 	grs_bitmap  *bm;
@@ -242,7 +277,7 @@ static void render_face(grs_canvas &canvas, const shared_segment &segp, const un
 #elif defined(DXX_BUILD_DESCENT_II)
 	//handle cloaked walls
 	if (wid_flags & WID_CLOAKED_FLAG) {
-		const auto wall_num = segp.shared_segment::sides[sidenum].wall_num;
+		const auto wall_num = segp->shared_segment::sides[sidenum].wall_num;
 		auto &Walls = LevelUniqueWallSubsystemState.Walls;
 		auto &vcwallptr = Walls.vcptr;
 		gr_settransblend(canvas, vcwallptr(wall_num)->cloak_value, GR_BLEND_NORMAL);
@@ -269,7 +304,7 @@ static void render_face(grs_canvas &canvas, const shared_segment &segp, const un
 		if (tmap2){
 			PIGGY_PAGE_IN(Textures[tmap2&0x3FFF]);
 			bm2 = &GameBitmaps[Textures[tmap2&0x3FFF].index];
-			if (bm2->get_flag_mask(BM_FLAG_SUPER_TRANSPARENT))
+			if (bm2->get_flag_mask(BM_FLAG_SUPER_TRANSPARENT) && !ogl_use_overlay_shader())
 			{
 				bm2 = nullptr;
 			bm = &texmerge_get_cached_bitmap( tmap1, tmap2 );
@@ -356,10 +391,29 @@ static void render_face(grs_canvas &canvas, const shared_segment &segp, const un
 
 #if DXX_USE_OGL
 		if (bm2){
-			g3_draw_tmap_2(canvas, nv, pointlist, uvl_copy, dyn_light, *bm, *bm2, ((tmap2 & 0xC000) >> 14) & 3);
-		}else
+			const unsigned orient = ((tmap2 & 0xC000) >> 14) & 3;
+			add_pixel_lights(nv, vp, dyn_light);
+			if (
+#if DXX_USE_EDITOR
+				EditorWindow ||
+#endif
+				!ogl_draw_world_overlay_face(canvas, segp, sidenum, nv, corners, dyn_light, *bm, *bm2, orient))
+				g3_draw_tmap_2(canvas, nv, pointlist, uvl_copy, dyn_light, *bm, *bm2, orient);
+		}else if (
+#if DXX_USE_EDITOR
+			EditorWindow ||
 #endif
+			!ogl_draw_world_face(canvas, segp, sidenum, nv, corners, dyn_light, *bm))
+		{
+			add_pixel_lights(nv, vp, dyn_light);
+			g3_draw_tmap(canvas, nv, pointlist, uvl_copy, dyn_light, *bm);
+		}
+#else
 			g3_draw_tmap(canvas, nv, pointlist, uvl_copy, dyn_light, *bm);
+#endif
+#if !DXX_USE_OGL
+	(void)corners;
+#endif
 
 	if (alpha)
 		gr_settransblend(canvas, GR_FADE_OFF, GR_BLEND_NORMAL); // revert any transparency / blending setting back to normal
@@ -440,10 +494,11 @@ template <std::size_t... N>
 static inline void check_render_face(grs_canvas &canvas, index_sequence<N...>, const vcsegptridx_t segnum, const unsigned sidenum, const unsigned facenum, const array<unsigned, 4> &ovp, const unsigned tmap1, const unsigned tmap2, const array<uvl, 4> &uvlp, const WALL_IS_DOORWAY_result_t wid_flags, const std::size_t nv)
 {
 	const array<unsigned, 4> vp{{ovp[N]...}};
+	const array<unsigned, 4> corners{{N...}};
 	const array<g3s_uvl, 4> uvl_copy{{
 		{uvlp[N].u, uvlp[N].v, uvlp[N].l}...
 	}};
-	render_face(canvas, segnum, sidenum, nv, vp, tmap1, tmap2, uvl_copy, wid_flags);
+	render_face(canvas, segnum, sidenum, nv, vp, corners, tmap1, tmap2, uvl_copy, wid_flags);
 	check_face(canvas, segnum, sidenum, facenum, nv, vp, tmap1, tmap2, uvl_copy);
 }
 
@@ -492,6 +547,9 @@ static void render_side(fvcvertptr &vcvertptr, grs_canvas &canvas, const vcsegpt
 	//	========== Mark: Here is the change...beginning here: ==========
 
 	index_sequence<0, 1, 2, 3> is_quad;
+#if defined(DXX_BUILD_DESCENT_II)
+	slide_side_texture(vmsegptridx(static_cast<segnum_t>(segp)), sidenum);
+#endif
 	const auto &uside = segp->unique_segment::sides[sidenum];
 	if (sside.get_type() == SIDE_IS_QUAD) {
 
@@ -611,7 +669,7 @@ static void render_object_search(grs_canvas &canvas, const vmobjptridx_t obj)
 #endif
 
 namespace dsx {
-static void do_render_object(grs_canvas &canvas, const vmobjptridx_t obj, window_rendered_data &window)
+static void do_render_object(grs_canvas &canvas, const vmobjptridx_t obj, window_rendered_data &window, const bool outside_view)
 {
 #if DXX_USE_EDITOR
 	int save_3d_outline=0;
@@ -663,6 +721,12 @@ static void do_render_object(grs_canvas &canvas, const vmobjptridx_t obj, window
 	}
 	#endif
 
+	if (outside_view)
+	{
+		render_object_outside_view(obj);
+		return;
+	}
+
 #if DXX_USE_EDITOR
 	if (_search_mode)
 		render_object_search(canvas, obj);
@@ -696,6 +760,7 @@ static void do_render_object(grs_canvas &canvas, const vmobjptridx_t obj, window
 //This must be called at the start of the frame if rotate_list() will be used
 void render_start_frame()
 {
+	frame_alloc_start_frame();
 	if (s_current_generation == std::numeric_limits<decltype(s_current_generation)>::max())
 	{
 		Segment_points = {};
@@ -714,22 +779,45 @@ g3s_codes rotate_list(fvcvertptr &vcvertptr, const std::size_t nv, const unsigne
 		? 0.0f /* unused */
 		: 2.0f * (static_cast<float>(timer_query()) / F1_0);
 
-	range_for (const auto pnum, unchecked_partial_range(pointnumlist, nv))
+	/* Points not yet rotated this frame are collected and rotated
+	 * together, a batch at a time.
+	 */
+	array<g3s_point *, 8> dest;
+	array<const vms_vector *, 8> src;
+	array<vertex, 8> acid;
+	std::size_t pending = 0;
+	const auto pointnums = unchecked_partial_range(pointnumlist, nv);
+	range_for (const auto pnum, pointnums)
 	{
 		auto &pnt = Segment_points[pnum];
 		if (pnt.p3_last_generation != current_generation)
 		{
 			pnt.p3_last_generation = current_generation;
 			auto &v = *vcvertptr(pnum);
-			vertex tmpv;
-			g3_rotate_point(pnt, likely(!cheats_acid) ? v : (
-				tmpv = v,
-				tmpv.x += fl2f(sinf(f + f2fl(tmpv.x))),
-				tmpv.y += fl2f(sinf(f * 1.5f + f2fl(tmpv.y))),
-				tmpv.z += fl2f(sinf(f * 2.5f + f2fl(tmpv.z))),
-				tmpv
-			));
+			dest[pending] = &pnt;
+			if (likely(!cheats_acid))
+				src[pending] = &v;
+			else
+			{
+				auto &tmpv = acid[pending];
+				tmpv = v;
+				tmpv.x += fl2f(sinf(f + f2fl(tmpv.x)));
+				tmpv.y += fl2f(sinf(f * 1.5f + f2fl(tmpv.y)));
+				tmpv.z += fl2f(sinf(f * 2.5f + f2fl(tmpv.z)));
+				src[pending] = &tmpv;
+			}
+			if (++pending == dest.size())
+			{
+				g3_rotate_points(dest.data(), src.data(), pending);
+				pending = 0;
+			}
 		}
+	}
+	if (pending)
+		g3_rotate_points(dest.data(), src.data(), pending);
+	range_for (const auto pnum, pointnums)
+	{
+		auto &pnt = Segment_points[pnum];
 		cc.uand &= pnt.p3_codes;
 		cc.uor  |= pnt.p3_codes;
 	}
@@ -764,7 +852,7 @@ static void render_segment(const vms_vector &Viewer_eye, grs_canvas &canvas, con
 		if (Viewer->type != OBJ_ROBOT)
 #endif
 		{
-		Automap_visited[seg]=1;
+		automap_visit_segment(seg);
 		}
 
 		for (sn=0; sn<MAX_SIDES_PER_SEGMENT; sn++)
@@ -988,22 +1076,13 @@ static void sort_seg_children(fvcvertptr &vcvertptr, const vms_vector &Viewer_ey
 		std::sort(r.begin(), r.end(), predicate);
 }
 
-static void add_obj_to_seglist(render_state_t &rstate, objnum_t objnum, segnum_t segnum)
-{
-	auto p = rstate.render_seg_map.emplace(segnum, render_state_t::per_segment_state_t{});
-	auto &o = p.first->second.objects;
-	if (p.second)
-		o.reserve(16);
-	o.emplace_back(render_state_t::per_segment_state_t::distant_object{objnum});
-}
-
 namespace {
 
 using visited_twobit_array_t = visited_segment_mask_t<2>;
 
 class render_compare_context_t
 {
-	typedef render_state_t::per_segment_state_t::distant_object distant_object;
+	typedef render_state_t::distant_object distant_object;
 	struct element
 	{
 		fix64 dist_squared;
@@ -1016,9 +1095,10 @@ class render_compare_context_t
 public:
 	array_t::reference operator[](std::size_t i) { return m_array[i]; }
 	array_t::const_reference operator[](std::size_t i) const { return m_array[i]; }
-	render_compare_context_t(fvcobjptr &vcobjptr, const vms_vector &Viewer_eye, const render_state_t::per_segment_state_t &segstate)
+	template <typename R>
+	render_compare_context_t(fvcobjptr &vcobjptr, const vms_vector &Viewer_eye, const R &objects)
 	{
-		range_for (const auto t, segstate.objects)
+		range_for (const auto t, objects)
 		{
 			const auto objnum = t.objnum;
 			auto &objp = *vcobjptr(objnum);
@@ -1074,10 +1154,12 @@ bool render_compare_context_t::operator()(const distant_object &a, const distant
 
 }
 
-static void sort_segment_object_list(fvcobjptr &vcobjptr, const vms_vector &Viewer_eye, render_state_t::per_segment_state_t &segstate)
+static void sort_segment_object_list(fvcobjptr &vcobjptr, const vms_vector &Viewer_eye, render_state_t &rstate, const render_state_t::per_segment_state_t &segstate)
 {
-	render_compare_context_t context(vcobjptr, Viewer_eye, segstate);
-	auto &v = segstate.objects;
+	const auto &&v = rstate.segment_objects(segstate);
+	if (v.size() < 2)
+		return;
+	render_compare_context_t context(vcobjptr, Viewer_eye, v);
 	std::sort(v.begin(), v.end(), std::cref(context));
 }
 
@@ -1085,13 +1167,34 @@ namespace dsx {
 
 static void build_object_lists(object_array &Objects, fvcsegptr &vcsegptr, const vms_vector &Viewer_eye, render_state_t &rstate)
 {
-	int nn;
 	const auto viewer = Viewer;
 	auto &Vertices = LevelSharedVertexState.get_vertices();
 	auto &vcvertptr = Vertices.vcptr;
 	auto &Walls = LevelUniqueWallSubsystemState.Walls;
 	auto &vcwallptr = Walls.vcptr;
-	for (nn=0;nn < rstate.N_render_segs;nn++) {
+	//objects found, with the Render_list position of the segment each is drawn with
+	struct found_object
+	{
+		objnum_t objnum;
+		uint16_t list_pos;
+		bool inside_segment;
+	};
+	//each thread keeps the objects it finds in its own buffer, and
+	//found_ranges records where each Render_list entry's objects went
+	struct found_range
+	{
+		uint16_t thread;
+		uint16_t begin, end;
+	};
+	array<array<found_object, MAX_OBJECTS>, MAX_JOB_THREADS> thread_found_objects;
+	array<unsigned, MAX_JOB_THREADS> thread_n_found_objects{};
+	array<found_range, MAX_RENDER_SEGS> found_ranges;
+	auto gather_segment_objects = [&](const unsigned nn, const unsigned thread) {
+		auto &found_objects = thread_found_objects[thread];
+		auto &n_found_objects = thread_n_found_objects[thread];
+		auto &range = found_ranges[nn];
+		range.thread = thread;
+		range.begin = n_found_objects;
 		const auto segnum = rstate.Render_list[nn];
 		if (segnum != segment_none) {
 			range_for (const auto obj, objects_in(vcsegptr(segnum), Objects.vcptridx, vcsegptr))
@@ -1109,6 +1212,9 @@ static void build_object_lists(object_array &Objects, fvcsegptr &vcsegptr, const
 
 				auto new_segnum = segnum;
 				list_pos = nn;
+				//the sides crossed by the object, in sidemask_segnum
+				uint_fast32_t last_sidemask = 0;
+				segnum_t sidemask_segnum = segment_none;
 
 #if defined(DXX_BUILD_DESCENT_I)
 				int did_migrate;
@@ -1122,6 +1228,8 @@ static void build_object_lists(object_array &Objects, fvcsegptr &vcsegptr, const
 					did_migrate = 0;
 #endif
 					const uint_fast32_t sidemask = get_seg_masks(vcvertptr, obj->pos, vcsegptr(new_segnum), obj->size).sidemask;
+					last_sidemask = sidemask;
+					sidemask_segnum = new_segnum;
 	
 					if (sidemask) {
 						int sn,sf;
@@ -1155,18 +1263,43 @@ static void build_object_lists(object_array &Objects, fvcsegptr &vcsegptr, const
 					}
 	
 				} while (did_migrate);
-				add_obj_to_seglist(rstate, obj, new_segnum);
+				if (sidemask_segnum != new_segnum)
+					last_sidemask = get_seg_masks(vcvertptr, obj->pos, vcsegptr(new_segnum), obj->size).sidemask;
+				found_objects[n_found_objects++] = {obj, static_cast<uint16_t>(list_pos), !last_sidemask};
 			}
 		}
+		range.end = n_found_objects;
+	};
+	job_pool_run(rstate.N_render_segs, gather_segment_objects);
+
+	//give each segment a slice of rstate.objects, then fill in the slices,
+	//visiting the found objects in Render_list order so that the result
+	//does not depend on which thread found them
+	const auto &&seg_state_range = partial_range(rstate.render_seg_state, rstate.N_render_segs);
+	range_for (auto &s, seg_state_range)
+		s.num_objects = 0;
+	range_for (const auto &r, partial_const_range(found_ranges, rstate.N_render_segs))
+		range_for (const auto &f, partial_const_range(thread_found_objects[r.thread], r.begin, r.end))
+			++rstate.render_seg_state[f.list_pos].num_objects;
+	unsigned first_object = 0;
+	range_for (auto &s, seg_state_range)
+	{
+		s.first_object = first_object;
+		first_object += s.num_objects;
+		s.num_objects = 0;
 	}
+	range_for (const auto &r, partial_const_range(found_ranges, rstate.N_render_segs))
+		range_for (const auto &f, partial_const_range(thread_found_objects[r.thread], r.begin, r.end))
+		{
+			auto &s = rstate.render_seg_state[f.list_pos];
+			rstate.objects[s.first_object + s.num_objects++] = {f.objnum, f.inside_segment};
+		}
 
 	//now that there's a list for each segment, sort the items in those lists
-	range_for (const auto segnum, partial_const_range(rstate.Render_list, rstate.N_render_segs))
-	{
-		if (segnum != segment_none) {
-			sort_segment_object_list(Objects.vcptr, Viewer_eye, rstate.render_seg_map[segnum]);
-		}
-	}
+	auto sort_segment_objects = [&](const unsigned nn, unsigned) {
+		sort_segment_object_list(Objects.vcptr, Viewer_eye, rstate, rstate.render_seg_state[nn]);
+	};
+	job_pool_run(rstate.N_render_segs, sort_segment_objects);
 }
 }
 
@@ -1176,6 +1309,7 @@ namespace dsx {
 //renders onto current canvas
 void render_frame(grs_canvas &canvas, fix eye_offset, window_rendered_data &window)
 {
+	DXX_TRACE_ZONE("render_frame");
 	if (Endlevel_sequence) {
 		render_endlevel_frame(canvas, eye_offset);
 		return;
@@ -1215,10 +1349,21 @@ void render_frame(grs_canvas &canvas, fix eye_offset, window_rendered_data &wind
 	if (start_seg_num==segment_none)
 		start_seg_num = viewer_segp;
 
+	const auto late_look = [](const object_base &viewer) {
+		/* Show the turn from input which arrived while this frame was
+		 * simulated.  The ship itself turns when the next frame reads
+		 * the input.
+		 */
+		vms_angvec angles;
+		kconfig_late_look(viewer, angles);
+		return vm_matrix_x_matrix(viewer.orient, vm_angles_2_matrix(angles));
+	};
 	g3_set_view_matrix(Viewer_eye,
 		(Rear_view && Viewer == ConsoleObject)
 		? vm_matrix_x_matrix(Viewer->orient, vm_angles_2_matrix(vms_angvec{0, 0, INT16_MAX}))
-		: Viewer->orient, Render_zoom);
+		: (CGameArg.CtlLateLook && Viewer == ConsoleObject && Player_dead_state == player_dead_state::no && Newdemo_state != ND_STATE_PLAYBACK)
+			? late_look(*Viewer)
+			: Viewer->orient, Render_zoom);
 
 	if (Clear_window == 1) {
 		if (Clear_window_color == -1)
@@ -1244,10 +1389,432 @@ void update_rendered_data(window_rendered_data &window, const object &viewer, in
 }
 #endif
 
+namespace {
+
+//	Potentially visible set: for each segment, the set of segments which
+//	could be seen from anywhere inside it.  A line of sight which leaves
+//	a segment through one of its sides never comes back to the near side
+//	of that side's plane, so a segment which can only be reached through
+//	portals lying entirely behind the plane of the first portal cannot
+//	be visible.  Walls are ignored while building the set, so it stays
+//	valid as doors open and close; only the mine geometry matters.
+struct render_pvs_t
+{
+	//	Each row is a list of alternating runs of not visible and
+	//	visible segments, starting with a not visible run.  Row s is
+	//	runs[offsets[s]] to runs[offsets[s + 1]].
+	std::vector<uint16_t> runs;
+	std::vector<uint32_t> offsets;
+	std::bitset<MAX_SEGMENTS> row;
+	segnum_t row_segnum = segment_none;
+	mem_account_buffer account{mem_tag::level};
+	void update_account()
+	{
+		account.set(runs.capacity() * sizeof(runs[0]) + offsets.capacity() * sizeof(offsets[0]));
+	}
+};
+
+static render_pvs_t render_pvs;
+
+//	Return the expanded row for start_seg_num, or nullptr if the set
+//	cannot be used for this view.
+static const std::bitset<MAX_SEGMENTS> *render_pvs_row(fvcvertptr &vcvertptr, const vms_vector &Viewer_eye, const vcsegptridx_t start_seg_num)
+{
+	auto &pvs = render_pvs;
+	if (pvs.offsets.size() != static_cast<std::size_t>(Highest_segment_index) + 2)
+		return nullptr;
+	//	The set only holds for an eye inside the start segment, which is
+	//	not the case during the exit sequence and in the editor.
+	if (Endlevel_sequence)
+		return nullptr;
+#if DXX_USE_EDITOR
+	if (EditorWindow)
+		return nullptr;
+#endif
+	if (get_seg_masks(vcvertptr, Viewer_eye, start_seg_num, 0).centermask)
+		return nullptr;
+	if (pvs.row_segnum != start_seg_num)
+	{
+		pvs.row.reset();
+		unsigned s = 0;
+		bool visible = false;
+		for (auto i = pvs.offsets[start_seg_num], e = pvs.offsets[start_seg_num + 1]; i != e; ++i, visible = !visible)
+		{
+			const unsigned run = pvs.runs[i];
+			if (visible)
+				for (unsigned j = s; j != s + run; ++j)
+					pvs.row.set(j);
+			s += run;
+		}
+		pvs.row_segnum = start_seg_num;
+	}
+	return &pvs.row;
+}
+
+}
+
+void render_build_pvs()
+{
+	auto &pvs = render_pvs;
+	pvs.runs.clear();
+	pvs.offsets.clear();
+	pvs.row_segnum = segment_none;
+	if (CGameArg.DbgNoPVS)
+	{
+		pvs.update_account();
+		return;
+	}
+	auto &Vertices = LevelSharedVertexState.get_vertices();
+	auto &vcvertptr = Vertices.vcptr;
+	const unsigned num_segments = Highest_segment_index + 1;
+	const unsigned num_vertices = Vertices.get_count();
+	std::vector<uint8_t> vertex_beyond(num_vertices);
+	std::vector<segnum_t> queue;
+	std::bitset<MAX_SEGMENTS> visible, reached;
+	pvs.offsets.reserve(num_segments + 1);
+	pvs.offsets.emplace_back(0);
+	for (unsigned segnum = 0; segnum != num_segments; ++segnum)
+	{
+		const shared_segment &seg = *vcsegptr(static_cast<segnum_t>(segnum));
+		const auto &&center = compute_segment_center(vcvertptr, seg);
+		visible.reset();
+		visible.set(segnum);
+		for (unsigned side0 = 0; side0 != MAX_SIDES_PER_SEGMENT; ++side0)
+		{
+			const auto ch0 = seg.children[side0];
+			if (!IS_CHILD(ch0))
+				continue;
+			visible.set(ch0);
+			//	Orient the plane of the first portal so that positive
+			//	distances are on the far side from this segment.
+			auto &sside = seg.sides[side0];
+			auto normal = vm_vec_normalized_quick(vm_vec_add(sside.normals[0], sside.normals[1]));
+			const auto &&point = compute_center_point_on_side(vcvertptr, seg, side0);
+			if (vm_vec_dot(vm_vec_sub(center, point), normal) > 0)
+				vm_vec_negate(normal);
+			//	Allow for sides which are not planar, plus a little for
+			//	an eye which is not quite inside the segment.
+			fix tolerance = F1_0 / 4;
+			range_for (const auto i, Side_to_verts[side0])
+			{
+				const fix d = abs(vm_vec_dot(vm_vec_sub(*vcvertptr(seg.verts[i]), point), normal));
+				if (tolerance < d + F1_0 / 4)
+					tolerance = d + F1_0 / 4;
+			}
+			tolerance *= 2;
+			for (unsigned v = 0; v != num_vertices; ++v)
+				vertex_beyond[v] = vm_vec_dot(vm_vec_sub(*vcvertptr(static_cast<vertnum_t>(v)), point), normal) > -tolerance;
+			reached.reset();
+			reached.set(segnum);
+			reached.set(ch0);
+			queue.clear();
+			queue.emplace_back(ch0);
+			for (std::size_t qi = 0; qi != queue.size(); ++qi)
+			{
+				const shared_segment &cseg = *vcsegptr(queue[qi]);
+				visible.set(queue[qi]);
+				for (unsigned c = 0; c != MAX_SIDES_PER_SEGMENT; ++c)
+				{
+					const auto ch = cseg.children[c];
+					if (!IS_CHILD(ch) || reached[ch])
+						continue;
+					const auto &sv = Side_to_verts[c];
+					if (!(vertex_beyond[cseg.verts[sv[0]]] || vertex_beyond[cseg.verts[sv[1]]] || vertex_beyond[cseg.verts[sv[2]]] || vertex_beyond[cseg.verts[sv[3]]]))
+						continue;
+					reached.set(ch);
+					queue.emplace_back(ch);
+				}
+			}
+		}
+		uint16_t run = 0;
+		bool state = false;
+		for (unsigned s = 0; s != num_segments; ++s)
+		{
+			if (visible[s] != state)
+			{
+				pvs.runs.emplace_back(run);
+				run = 0;
+				state = !state;
+			}
+			++run;
+		}
+		pvs.runs.emplace_back(run);
+		pvs.offsets.emplace_back(pvs.runs.size());
+	}
+	pvs.update_account();
+	con_printf(CON_VERBOSE, "Built potentially visible set for %u segments in %zu runs", num_segments, pvs.runs.size());
+}
+
+void render_get_pvs(std::vector<uint16_t> &runs, std::vector<uint32_t> &offsets)
+{
+	auto &pvs = render_pvs;
+	runs = pvs.runs;
+	offsets = pvs.offsets;
+}
+
+bool render_set_pvs(std::vector<uint16_t> &&runs, std::vector<uint32_t> &&offsets)
+{
+	auto &pvs = render_pvs;
+	pvs.runs.clear();
+	pvs.offsets.clear();
+	pvs.row_segnum = segment_none;
+	const unsigned num_segments = Highest_segment_index + 1;
+	if (offsets.size() != num_segments + 1 || offsets.front() != 0 || offsets.back() != runs.size())
+		return false;
+	//	Every row must cover exactly the segments of this mine.
+	for (unsigned segnum = 0; segnum != num_segments; ++segnum)
+	{
+		const auto b = offsets[segnum], e = offsets[segnum + 1];
+		if (b > e || e > runs.size())
+			return false;
+		unsigned total = 0;
+		for (auto i = b; i != e; ++i)
+			total += runs[i];
+		if (total != num_segments)
+			return false;
+	}
+	pvs.runs = std::move(runs);
+	pvs.offsets = std::move(offsets);
+	pvs.update_account();
+	return true;
+}
+
+bool render_pvs_may_see(const vcsegptridx_t from, const vcsegptridx_t to)
+{
+	auto &pvs = render_pvs;
+	if (pvs.offsets.size() != static_cast<std::size_t>(Highest_segment_index) + 2)
+		return true;
+#if DXX_USE_EDITOR
+	//	The geometry may have changed since the set was built.
+	if (EditorWindow)
+		return true;
+#endif
+	const auto &&row_has = [&pvs, from](const segnum_t segnum) -> bool {
+		if (pvs.row_segnum == from)
+			return pvs.row[segnum];
+		unsigned s = 0;
+		bool visible = false;
+		for (auto i = pvs.offsets[from], e = pvs.offsets[from + 1]; i != e; ++i, visible = !visible)
+		{
+			s += pvs.runs[i];
+			if (segnum < s)
+				return visible;
+		}
+		return false;
+	};
+	if (row_has(to))
+		return true;
+	range_for (const auto c, to->children)
+		if (IS_CHILD(c) && row_has(c))
+			return true;
+	return false;
+}
+
 //build a list of segments to be rendered
 //fills in Render_list & N_render_segs
-static void build_segment_list(render_state_t &rstate, const vms_vector &Viewer_eye, visited_twobit_array_t &visited, unsigned &first_terminal_seg, const vcsegidx_t start_seg_num)
+namespace {
+
+struct render_segment_sphere
+{
+	vms_vector center;
+	fix radius;
+};
+
+//	The parts of a segment which build_segment_list reads for every
+//	segment it visits, packed into one line instead of spread over the
+//	whole of a segment.  The full segment is only read for sides with a
+//	wall, and to order the children of the segments it will draw.
+struct render_segment_links
 {
+	array<segnum_t, MAX_SIDES_PER_SEGMENT> children;
+	array<wallnum_t, MAX_SIDES_PER_SEGMENT> wall_num;
+	array<unsigned, MAX_VERTICES_PER_SEGMENT> verts;
+};
+
+//	Bounding spheres and links of segments 0 to Highest_segment_index,
+//	if they match the current mine.  Both are built together, so they
+//	are valid together.
+static level_arena_vector<render_segment_sphere> render_segment_spheres;
+static level_arena_vector<render_segment_links> render_segment_links_table;
+static unsigned render_segment_spheres_generation;
+
+//	The view, as build_segment_list needs it to test spheres.  The rows of
+//	View_matrix are scaled by Matrix_scale, so a sphere becomes an axis
+//	aligned ellipsoid in view space.
+//	The projected extent of a sphere which is entirely in front of the
+//	eye.  left, right, top and bot are ratios x/z and y/z.
+struct render_sphere_bounds
+{
+	double near_z, left, right, top, bot;
+};
+
+class render_sphere_view
+{
+	double scale_x, scale_y, scale_z, scale_xz, scale_yz;
+	double canv_w2, canv_h2;
+	bool bounds(const g3s_point &p, double r, render_sphere_bounds &b) const;
+public:
+	render_sphere_view(const grs_canvas &canvas) :
+		scale_x(f2db(vm_vec_mag(View_matrix.rvec))),
+		scale_y(f2db(vm_vec_mag(View_matrix.uvec))),
+		scale_z(f2db(vm_vec_mag(View_matrix.fvec))),
+		scale_xz(sqrt(scale_x * scale_x + scale_z * scale_z)),
+		scale_yz(sqrt(scale_y * scale_y + scale_z * scale_z)),
+		canv_w2(canvas.cv_bitmap.bm_w / 2.0),
+		canv_h2(canvas.cv_bitmap.bm_h / 2.0)
+	{
+	}
+	bool visible(const render_segment_sphere &s, const rect &w) const;
+	bool bounds(const render_segment_sphere &s, render_sphere_bounds &b) const
+	{
+		g3s_point p;
+		g3_rotate_point(p, s.center);
+		return bounds(p, s.radius, b);
+	}
+};
+
+//	Return false if the sphere crosses the eye plane, since it can then
+//	reach any part of the view.
+bool render_sphere_view::bounds(const g3s_point &p, const double r, render_sphere_bounds &b) const
+{
+	const double x = p.p3_x, y = p.p3_y, z = p.p3_z;
+	const double rx = r * scale_x, ry = r * scale_y, rz = r * scale_z;
+	const double near_z = z - rz, far_z = z + rz;
+	if (near_z <= 0)
+		return false;
+	b.near_z = near_z;
+	b.right = (x + rx) / (x + rx > 0 ? near_z : far_z);
+	b.left = (x - rx) / (x - rx < 0 ? near_z : far_z);
+	b.top = (y + ry) / (y + ry > 0 ? near_z : far_z);
+	b.bot = (y - ry) / (y - ry < 0 ? near_z : far_z);
+	return true;
+}
+
+//	Return false if no part of the sphere can be in the view frustum or,
+//	once projected, inside window w.
+bool render_sphere_view::visible(const render_segment_sphere &s, const rect &w) const
+{
+	g3s_point p;
+	g3_rotate_point(p, s.center);
+	const double x = p.p3_x, y = p.p3_y, z = p.p3_z, r = s.radius;
+	if (z + r * scale_z < 0)
+		return false;
+	if (x - z > r * scale_xz || -x - z > r * scale_xz)
+		return false;
+	if (y - z > r * scale_yz || -y - z > r * scale_yz)
+		return false;
+	render_sphere_bounds b;
+	if (!bounds(p, r, b))
+		return true;
+	//	Allow a pixel for the rounding of projected points.
+	if (canv_w2 + b.right * canv_w2 < w.left - 1 || canv_w2 + b.left * canv_w2 > w.right + 1)
+		return false;
+	if (canv_h2 - b.top * canv_h2 > w.bot + 1 || canv_h2 - b.bot * canv_h2 < w.top - 1)
+		return false;
+	return true;
+}
+
+//	The objects drawn and skipped by the last main view.
+static render_object_stats render_last_object_stats;
+
+//	Counts the objects of one view, and decides which can be skipped.
+class render_object_cull
+{
+	const render_sphere_view view;
+	const rect canvas_window;
+	const bool enabled;
+public:
+	render_object_stats stats{};
+	render_object_cull(const grs_canvas &canvas) :
+		view(canvas),
+		canvas_window{0, 0, static_cast<short>(canvas.cv_bitmap.bm_w - 1), static_cast<short>(canvas.cv_bitmap.bm_h - 1)},
+		enabled(!_search_mode)
+	{
+	}
+	bool outside_view(vmobjptridx_t obj, const render_state_t::distant_object &d, const rect &segment_window);
+};
+
+//	True if neither the object nor anything attached to it can be seen.
+//	An object which stays inside its segment can only be seen through
+//	the window of that segment; any other object may reach into segments
+//	seen through other windows, so it is only tested against the view.
+bool render_object_cull::outside_view(const vmobjptridx_t obj, const render_state_t::distant_object &d, const rect &segment_window)
+{
+	if (!enabled)
+	{
+		++stats.drawn;
+		return false;
+	}
+	const auto &w = d.inside_segment ? segment_window : canvas_window;
+	if (view.visible({obj->pos, obj->size}, w))
+	{
+		++stats.drawn;
+		return false;
+	}
+	for (auto n = obj->attached_obj; n != object_none;)
+	{
+		const auto &&o = obj.absolute_sibling(n);
+		if (view.visible({o->pos, o->size}, canvas_window))
+		{
+			++stats.drawn;
+			return false;
+		}
+		n = o->ctype.expl_info.next_attach;
+	}
+	++stats.culled;
+	return true;
+}
+
+}
+
+render_object_stats render_get_object_stats()
+{
+	return render_last_object_stats;
+}
+
+void render_build_segment_tables()
+{
+	auto &Vertices = LevelSharedVertexState.get_vertices();
+	auto &vcvertptr = Vertices.vcptr;
+	auto &spheres = render_segment_spheres;
+	auto &links = render_segment_links_table;
+	spheres = level_arena_vector<render_segment_sphere>();
+	links = level_arena_vector<render_segment_links>();
+	render_segment_spheres_generation = level_arena_generation();
+	spheres.reserve(Highest_segment_index + 1);
+	links.reserve(Highest_segment_index + 1);
+	range_for (const auto &&seg, vcsegptr)
+	{
+		const shared_segment &sseg = *seg;
+		spheres.emplace_back();
+		auto &s = spheres.back();
+		compute_segment_center(vcvertptr, s.center, sseg);
+		s.radius = compute_segment_radius(vcvertptr, sseg, s.center);
+		links.emplace_back();
+		auto &l = links.back();
+		l.children = sseg.children;
+		l.verts = sseg.verts;
+		for (unsigned side = 0; side != MAX_SIDES_PER_SEGMENT; ++side)
+			l.wall_num[side] = sseg.sides[side].wall_num;
+	}
+}
+
+//	As WALL_IS_DOORWAY, reading the segment only if the side has a wall.
+static WALL_IS_DOORWAY_result_t render_link_is_doorway(fvcwallptr &vcwallptr, const render_segment_links &l, const segment &seg, const unsigned side)
+{
+	const auto child = l.children[side];
+	if (unlikely(child == segment_none))
+		return WID_WALL;
+	if (unlikely(child == segment_exit))
+		return WID_EXTERNAL;
+	if (likely(l.wall_num[side] == wall_none))
+		return WID_NO_WALL;
+	return wall_is_doorway(GameBitmaps, Textures, vcwallptr, seg.shared_segment::sides[side], seg.unique_segment::sides[side]);
+}
+
+static void build_segment_list(render_state_t &rstate, const vms_vector &Viewer_eye, visited_twobit_array_t &visited, unsigned &first_terminal_seg, const vcsegidx_t start_seg_num, const int render_depth)
+{
+	DXX_TRACE_ZONE("build_segment_list");
 	int	lcnt,scnt,ecnt;
 	int	l;
 
@@ -1261,7 +1828,9 @@ static void build_segment_list(render_state_t &rstate, const vms_vector &Viewer_
 	ecnt = lcnt;
 	rstate.render_pos[start_seg_num] = 0;
 	{
-		auto &rsm_start_seg = rstate.render_seg_map[start_seg_num];
+		auto &rsm_start_seg = rstate.render_seg_state[0];
+		rsm_start_seg.Seg_depth = 0;
+		rsm_start_seg.processed = false;
 		auto &rw = rsm_start_seg.render_window;
 		rw.left = rw.top = 0;
 		rw.right = grd_curcanv->cv_bitmap.bm_w-1;
@@ -1276,7 +1845,18 @@ static void build_segment_list(render_state_t &rstate, const vms_vector &Viewer_
 	auto &vcvertptr = Vertices.vcptr;
 	auto &Walls = LevelUniqueWallSubsystemState.Walls;
 	auto &vcwallptr = Walls.vcptr;
-	for (l=0;l<Render_depth;l++) {
+	const auto pvs = render_pvs_row(vcvertptr, Viewer_eye, vcsegptridx(start_seg_num));
+	const render_sphere_view sphere_view(*grd_curcanv);
+	//	The editor changes the mine without rebuilding the spheres.
+	const auto spheres = render_segment_spheres.size() == static_cast<std::size_t>(Highest_segment_index) + 1
+		&& render_segment_spheres_generation == level_arena_generation()
+#if DXX_USE_EDITOR
+		&& !EditorWindow
+#endif
+		? render_segment_spheres.data()
+		: nullptr;
+	const auto links = spheres ? render_segment_links_table.data() : nullptr;
+	for (l=0;l<render_depth;l++) {
 		for (scnt=0;scnt < ecnt;scnt++) {
 			auto segnum = rstate.Render_list[scnt];
 			if (unlikely(segnum == segment_none))
@@ -1285,7 +1865,7 @@ static void build_segment_list(render_state_t &rstate, const vms_vector &Viewer_
 				continue;
 			}
 
-			auto &srsm = rstate.render_seg_map[segnum];
+			auto &srsm = rstate.render_seg_state[scnt];
 			auto &processed = srsm.processed;
 			if (processed)
 				continue;
@@ -1294,7 +1874,10 @@ static void build_segment_list(render_state_t &rstate, const vms_vector &Viewer_
 			processed = true;
 
 			const auto &&seg = vcsegptridx(segnum);
-			const auto uor = rotate_list(vcvertptr, seg->verts).uor & CC_BEHIND;
+			const auto link = links ? &links[segnum] : nullptr;
+			const auto &children = link ? link->children : seg->children;
+			const auto &verts = link ? link->verts : seg->verts;
+			const auto uor = rotate_list(vcvertptr, verts).uor & CC_BEHIND;
 
 			//look at all sides of this segment.
 			//tricky code to look at sides in correct order follows
@@ -1302,13 +1885,17 @@ static void build_segment_list(render_state_t &rstate, const vms_vector &Viewer_
 			sort_child_array_t child_list;		//list of ordered sides to process
 			uint_fast32_t n_children = 0;							//how many sides in child_list
 			for (uint_fast32_t c = 0;c < MAX_SIDES_PER_SEGMENT;c++) {		//build list of sides
-				const auto wid = WALL_IS_DOORWAY(GameBitmaps, Textures, vcwallptr, seg, seg, c);
+				const auto wid = link
+					? render_link_is_doorway(vcwallptr, *link, seg, c)
+					: WALL_IS_DOORWAY(GameBitmaps, Textures, vcwallptr, seg, seg, c);
 				if (wid & WID_RENDPAST_FLAG)
 				{
+					if (pvs && !(*pvs)[children[c]])
+						continue;
 					if (auto codes_and = uor)
 					{
 						range_for (const auto i, Side_to_verts[c])
-							codes_and &= Segment_points[seg->verts[i]].p3_codes;
+							codes_and &= Segment_points[verts[i]].p3_codes;
 						if (codes_and)
 							continue;
 					}
@@ -1321,10 +1908,10 @@ static void build_segment_list(render_state_t &rstate, const vms_vector &Viewer_
 			//now order the sides in some magical way
 			const auto &&child_range = partial_range(child_list, n_children);
 			sort_seg_children(vcvertptr, Viewer_eye, seg, child_range);
-			project_list(seg->verts);
+			project_list(verts);
 			range_for (const auto siden, child_range)
 			{
-				const auto ch = seg->children[siden];
+				const auto ch = children[siden];
 				{
 					{
 						short min_x=32767,max_x=-32767,min_y=32767,max_y=-32767;
@@ -1332,7 +1919,7 @@ static void build_segment_list(render_state_t &rstate, const vms_vector &Viewer_
 						uint8_t codes_and_3d = 0xff, codes_and_2d = codes_and_3d;
 						range_for (const auto i, Side_to_verts[siden])
 						{
-							g3s_point *pnt = &Segment_points[seg->verts[i]];
+							g3s_point *pnt = &Segment_points[verts[i]];
 
 							if (! (pnt->p3_flags&PF_PROJECTED)) {no_proj_flag=1; break;}
 
@@ -1358,11 +1945,13 @@ static void build_segment_list(render_state_t &rstate, const vms_vector &Viewer_
 								nw.top   = max(check_w.top,min_y);
 								nw.bot   = min(check_w.bot,max_y);
 							}
+							if (spheres && !sphere_view.visible(spheres[ch], nw))
+								goto no_add;
 
 							//see if this seg already visited, and if so, does current window
 							//expand the old window?
 							if (rp != -1) {
-								auto &old_w = rstate.render_seg_map[rstate.Render_list[rp]].render_window;
+								auto &old_w = rstate.render_seg_state[rp].render_window;
 								if (nw.left < old_w.left ||
 										 nw.top < old_w.top ||
 										 nw.right > old_w.right ||
@@ -1375,7 +1964,7 @@ static void build_segment_list(render_state_t &rstate, const vms_vector &Viewer_
 
 									{
 										//no_render_flag[lcnt] = 1;
-										rstate.render_seg_map[ch].processed = false;		//force reprocess
+										rstate.render_seg_state[rp].processed = false;		//force reprocess
 										rstate.Render_list[lcnt] = segment_none;
 										old_w = nw;		//get updated window
 										goto no_add;
@@ -1386,8 +1975,9 @@ static void build_segment_list(render_state_t &rstate, const vms_vector &Viewer_
 							rstate.render_pos[ch] = lcnt;
 							rstate.Render_list[lcnt] = ch;
 							{
-								auto &chrsm = rstate.render_seg_map[ch];
+								auto &chrsm = rstate.render_seg_state[lcnt];
 								chrsm.Seg_depth = l;
+								chrsm.processed = false;
 								chrsm.render_window = nw;
 							}
 							lcnt++;
@@ -1413,6 +2003,78 @@ done_list:
 
 }
 
+#if DXX_USE_OGL
+namespace {
+
+/* A side deferred by the sorted opaque pass (-gl_sortfaces).  The key
+ * orders sides by blend mode, then base texture, then overlay texture.
+ */
+struct deferred_side
+{
+	uint32_t key;
+	segnum_t segnum;
+	uint8_t sidenum;
+	WALL_IS_DOORWAY_result_t wid;
+	bool operator<(const deferred_side &rhs) const
+	{
+		return key < rhs.key;
+	}
+};
+
+}
+
+static uint32_t build_deferred_side_key(const d_level_unique_tmap_info_state::TmapInfo_array &TmapInfo, const unique_side &uside)
+{
+	const uint32_t tmap1 = uside.tmap_num;
+	const uint32_t tmap2 = static_cast<uint16_t>(uside.tmap_num2);
+	const uint32_t blend = (PlayerCfg.AlphaBlendEClips && is_alphablend_eclip(TmapInfo[tmap1].eclip_num)) ? 1 : 0;
+	return (blend << 31) | (tmap1 << 16) | tmap2;
+}
+
+static void render_deferred_sides(fvcvertptr &vcvertptr, grs_canvas &canvas, std::vector<deferred_side> &sides, const vms_vector &Viewer_eye)
+{
+	std::sort(sides.begin(), sides.end());
+	range_for (auto &d, sides)
+		render_side(vcvertptr, canvas, vcsegptridx(d.segnum), d.sidenum, d.wid, Viewer_eye);
+	sides.clear();
+}
+
+/* Segments this close to the eye in the render list are rarely hidden,
+ * so -gl_occlusion does not spend queries on them.
+ */
+constexpr unsigned occlusion_min_depth = 4;
+
+/* Test the projected bounds of each distant segment against the walls
+ * drawn so far.  A quad at the nearest depth of the segment's bounding
+ * sphere covers every pixel the segment can reach, so no samples
+ * passing means the segment was hidden.
+ */
+static void render_occlusion_tests(render_state_t &rstate, const render_sphere_view &sphere_view, const render_segment_sphere *const spheres)
+{
+	ogl_occlusion_begin_tests();
+	range_for (const auto segnum, partial_const_range(rstate.Render_list, rstate.N_render_segs))
+	{
+		if (segnum == segment_none || rstate.segment_state(segnum).Seg_depth < occlusion_min_depth)
+			continue;
+		render_sphere_bounds b;
+		//	Keep the quad well beyond the near clip plane.
+		if (!sphere_view.bounds(spheres[segnum], b) || b.near_z < F1_0)
+			continue;
+		const GLfloat z = b.near_z / F1_0;
+		ogl_occlusion_test(segnum, b.left * z, b.right * z, b.bot * z, b.top * z, z);
+	}
+	ogl_occlusion_end_tests();
+}
+
+/* An object in a hidden segment can only be skipped if it cannot reach
+ * past the segment's bounding sphere.
+ */
+static bool object_inside_sphere(const object_base &obj, const render_segment_sphere &s)
+{
+	return vm_vec_dist(obj.pos, s.center) + obj.size <= s.radius;
+}
+#endif
+
 //renders onto current canvas
 void render_mine(grs_canvas &canvas, const vms_vector &Viewer_eye, const vcsegidx_t start_seg_num, const fix eye_offset, window_rendered_data &window)
 {
@@ -1442,7 +2104,12 @@ void render_mine(grs_canvas &canvas, const vms_vector &Viewer_eye, const vcsegid
 	//else
 	#endif
 		//NOTE LINK TO ABOVE!!	-Link killed by kreatordxx to get editor selection working again
-		build_segment_list(rstate, Viewer_eye, visited, first_terminal_seg, start_seg_num);		//fills in Render_list & N_render_segs
+	{
+		const unsigned window_depth = CGameArg.GfxWindowDepth;
+		const int render_depth = (window.secondary_view && window_depth && window_depth < static_cast<unsigned>(Render_depth)) ? window_depth : Render_depth;
+		build_segment_list(rstate, Viewer_eye, visited, first_terminal_seg, start_seg_num, render_depth);		//fills in Render_list & N_render_segs
+	}
+	DXX_TRACE_COUNTER("render segments", rstate.N_render_segs);
 
 	const auto &&render_range = partial_const_range(rstate.Render_list, rstate.N_render_segs);
 	const auto &&reversed_render_range = render_range.reversed();
@@ -1450,9 +2117,12 @@ void render_mine(grs_canvas &canvas, const vms_vector &Viewer_eye, const vcsegid
 
 	//if (!(_search_mode))
 		build_object_lists(Objects, vcsegptr, Viewer_eye, rstate);
+	render_object_cull cull(canvas);
 
-	if (eye_offset<=0) // Do for left eye or zero.
-		set_dynamic_light(rstate);
+	//	Object lights do not depend on the viewer, so the windows drawn
+	//	after the main view use the lights it set.
+	if (eye_offset<=0 && !window.secondary_view) // Do for left eye or zero.
+		set_dynamic_light();
 
 	if (reversed_render_range.empty())
 		/* Impossible, but later code has undefined behavior if this
@@ -1470,7 +2140,7 @@ void render_mine(grs_canvas &canvas, const vms_vector &Viewer_eye, const vcsegid
 			range_for (const auto segnum, partial_const_range(rstate.Render_list, first_terminal_seg, rstate.N_render_segs))
 			{
 				if (segnum != segment_none) {
-					const auto &rw = rstate.render_seg_map[segnum].render_window;
+					const auto &rw = rstate.segment_state(segnum).render_window;
 					#ifndef NDEBUG
 					if (rw.left == -1 || rw.top == -1 || rw.right == -1 || rw.bot == -1)
 						Int3();
@@ -1483,13 +2153,20 @@ void render_mine(grs_canvas &canvas, const vms_vector &Viewer_eye, const vcsegid
 		}
 	}
 #if !DXX_USE_OGL
+	/* The editor reads back pixels in search mode and outlines draw
+	 * lines over each face, so both need every face drawn at once.
+	 */
+	const bool batch_faces = !_search_mode
+#ifndef NDEBUG
+		&& !Outline_mode
+#endif
+		;
 	range_for (const auto segnum, reversed_render_range)
 	{
 		// Interpolation_method = 0;
-		auto &srsm = rstate.render_seg_map[segnum];
-
 		//if (!no_render_flag[nn])
 		if (segnum!=segment_none && (_search_mode || visited[segnum]!=3)) {
+			auto &srsm = rstate.segment_state(segnum);
 			//set global render window vars
 
 			Current_seg_depth = srsm.Seg_depth;
@@ -1501,10 +2178,13 @@ void render_mine(grs_canvas &canvas, const vms_vector &Viewer_eye, const vcsegid
 				Window_clip_bot   = rw.bot;
 			}
 
+			if (batch_faces)
+				draw_tmap_begin_batch();
 			render_segment(Viewer_eye, *grd_curcanv, vcsegptridx(segnum));
 			visited[segnum]=3;
-			if (srsm.objects.empty())
+			if (!srsm.num_objects)
 				continue;
+			draw_tmap_end_batch();
 
 			{		//reset for objects
 				Window_clip_left  = Window_clip_top = 0;
@@ -1515,15 +2195,17 @@ void render_mine(grs_canvas &canvas, const vms_vector &Viewer_eye, const vcsegid
 			{
 				//int n_expl_objs=0,expl_objs[5],i;
 				const auto save_linear_depth = exchange(Max_linear_depth, Max_linear_depth_objects);
-				range_for (auto &v, srsm.objects)
+				range_for (auto &v, rstate.segment_objects(srsm))
 				{
-					do_render_object(canvas, vmobjptridx(v.objnum), window);	// note link to above else
+					const auto &&objp = vmobjptridx(v.objnum);
+					do_render_object(canvas, objp, window, cull.outside_view(objp, v, srsm.render_window));	// note link to above else
 				}
 				Max_linear_depth = save_linear_depth;
 			}
 
 		}
 	}
+	draw_tmap_end_batch();
 #else
         // Two pass rendering. Since sprites and some level geometry can have transparency (blending), we need some fancy sorting.
         // GL_DEPTH_TEST helps to sort everything in view but we should make sure translucent sprites are rendered after geometry to prevent them to turn walls invisible (if rendered BEFORE geometry but still in FRONT of it).
@@ -1533,12 +2215,36 @@ void render_mine(grs_canvas &canvas, const vms_vector &Viewer_eye, const vcsegid
 	auto &vcvertptr = Vertices.vcptr;
 	auto &Walls = LevelUniqueWallSubsystemState.Walls;
 	auto &vcwallptr = Walls.vcptr;
+	/* Depth testing makes the order of opaque sides irrelevant, so
+	 * -gl_sortfaces collects them and draws them grouped by texture to
+	 * avoid a texture and blend change on nearly every face.
+	 */
+	static std::vector<deferred_side> opaque_sides, alphatest_sides;
+	const bool sort_faces = CGameArg.OglSortFaces
+#if DXX_USE_EDITOR
+		&& !_search_mode
+#endif
+		;
+	/* Occlusion results describe the previous frame, so only use them
+	 * for the player's own view, which changes little between frames.
+	 */
+	const auto occlusion_spheres = ogl_occlusion_enabled() &&
+		!eye_offset && !Rear_view && Viewer == ConsoleObject && !Endlevel_sequence &&
+		render_segment_spheres.size() == static_cast<std::size_t>(Highest_segment_index) + 1
+#if DXX_USE_EDITOR
+		&& !_search_mode && !EditorWindow
+#endif
+		? render_segment_spheres.data()
+		: nullptr;
+	if (occlusion_spheres)
+		ogl_occlusion_begin_frame(render_segment_spheres.size());
         // First Pass: render opaque level geometry and level geometry with alpha pixels (high Alpha-Test func)
 	range_for (const auto segnum, reversed_render_range)
 	{
-		auto &srsm = rstate.render_seg_map[segnum];
-
 		if (segnum!=segment_none && (_search_mode || visited[segnum]!=3)) {
+			if (occlusion_spheres && ogl_occlusion_occluded(segnum))
+				continue;
+			auto &srsm = rstate.segment_state(segnum);
 			//set global render window vars
 
 			{
@@ -1558,7 +2264,7 @@ void render_mine(grs_canvas &canvas, const vms_vector &Viewer_eye, const vcsegid
 				{		//all off screen?
 
 					if (Viewer->type!=OBJ_ROBOT)
-						Automap_visited[segnum]=1;
+						automap_visit_segment(segnum);
 
 					for (sn=0; sn<MAX_SIDES_PER_SEGMENT; sn++)
 					{
@@ -1571,10 +2277,22 @@ void render_mine(grs_canvas &canvas, const vms_vector &Viewer_eye, const vcsegid
 						{
 							if (PlayerCfg.AlphaBlendEClips && is_alphablend_eclip(TmapInfo[seg->unique_segment::sides[sn].tmap_num].eclip_num)) // Do NOT render geometry with blending textures. Since we've not rendered any objects, yet, they would disappear behind them.
                                                                 continue;
+							if (sort_faces)
+							{
+								alphatest_sides.push_back({build_deferred_side_key(TmapInfo, seg->unique_segment::sides[sn]), seg, static_cast<uint8_t>(sn), wid});
+								continue;
+							}
+							ogl_flush_world_buffer();
 							glAlphaFunc(GL_GEQUAL,0.8); // prevent ugly outlines if an object (which is rendered later) is shown behind a grate, door, etc. if texture filtering is enabled. These sides are rendered later again with normal AlphaFunc
 							render_side(vcvertptr, canvas, seg, sn, wid, Viewer_eye);
+							ogl_flush_world_buffer();
 							glAlphaFunc(GL_GEQUAL,0.02);
 						}
+						else if (sort_faces)
+						{
+							if (wid & WID_RENDER_FLAG)
+								opaque_sides.push_back({build_deferred_side_key(TmapInfo, seg->unique_segment::sides[sn]), seg, static_cast<uint8_t>(sn), wid});
+						}
 						else
 							render_side(vcvertptr, canvas, seg, sn, wid, Viewer_eye);
 					}
@@ -1582,13 +2300,31 @@ void render_mine(grs_canvas &canvas, const vms_vector &Viewer_eye, const vcsegid
 			}
 		}
 	}
+	if (sort_faces)
+	{
+		render_deferred_sides(vcvertptr, canvas, opaque_sides, Viewer_eye);
+		if (!alphatest_sides.empty())
+		{
+			ogl_flush_world_buffer();
+			glAlphaFunc(GL_GEQUAL,0.8);
+			render_deferred_sides(vcvertptr, canvas, alphatest_sides, Viewer_eye);
+			ogl_flush_world_buffer();
+			glAlphaFunc(GL_GEQUAL,0.02);
+		}
+	}
+	/* Only level geometry is in the depth buffer yet.  Sprites drawn
+	 * with the objects write depth for their translucent pixels too, so
+	 * they must not hide anything.
+	 */
+	if (occlusion_spheres)
+		render_occlusion_tests(rstate, render_sphere_view(canvas), occlusion_spheres);
 
         // Second pass: Render objects and level geometry with alpha pixels (normal Alpha-Test func) and eclips with blending
 	range_for (const auto segnum, reversed_render_range)
 	{
-		auto &srsm = rstate.render_seg_map[segnum];
-
 		if (segnum!=segment_none && (_search_mode || visited[segnum]!=3)) {
+			const bool occluded = occlusion_spheres && ogl_occlusion_occluded(segnum);
+			auto &srsm = rstate.segment_state(segnum);
 			//set global render window vars
 
 			{
@@ -1604,11 +2340,11 @@ void render_mine(grs_canvas &canvas, const vms_vector &Viewer_eye, const vcsegid
 				const auto &&seg = vcsegptridx(segnum);
 				int			sn;
 				Assert(segnum!=segment_none && segnum<=Highest_segment_index);
-				if (!rotate_list(vcvertptr, seg->verts).uand)
+				if (!occluded && !rotate_list(vcvertptr, seg->verts).uand)
 				{		//all off screen?
 
 					if (Viewer->type!=OBJ_ROBOT)
-						Automap_visited[segnum]=1;
+						automap_visit_segment(segnum);
 
 					for (sn=0; sn<MAX_SIDES_PER_SEGMENT; sn++)
 					{
@@ -1625,7 +2361,7 @@ void render_mine(grs_canvas &canvas, const vms_vector &Viewer_eye, const vcsegid
 				}
 			}
 			visited[segnum]=3;
-			if (srsm.objects.empty())
+			if (!srsm.num_objects)
 				continue;
 			{		//reset for objects
 				Window_clip_left  = Window_clip_top = 0;
@@ -1634,15 +2370,26 @@ void render_mine(grs_canvas &canvas, const vms_vector &Viewer_eye, const vcsegid
 			}
 
 			{
-				range_for (auto &v, srsm.objects)
+				range_for (auto &v, rstate.segment_objects(srsm))
 				{
-					do_render_object(canvas, vmobjptridx(v.objnum), window);	// note link to above else
+					const auto &&objp = vmobjptridx(v.objnum);
+					if (occluded && object_inside_sphere(objp, occlusion_spheres[segnum]))
+						continue;
+					do_render_object(canvas, objp, window, cull.outside_view(objp, v, srsm.render_window));	// note link to above else
 				}
 			}
 		}
 	}
 #endif
 
+	DXX_TRACE_COUNTER("render objects culled", cull.stats.culled);
+	if (!window.secondary_view)
+		render_last_object_stats = cull.stats;
+
+	//	Get ready for what lies past the end of the player's view.
+	if (!_search_mode && eye_offset <= 0 && !Rear_view && Viewer == ConsoleObject)
+		paging_prefetch_beyond(partial_const_range(rstate.Render_list, first_terminal_seg, rstate.N_render_segs));
+
 	// -- commented out by mk on 09/14/94...did i do a good thing??  object_render_targets();
 
 #if DXX_USE_EDITOR
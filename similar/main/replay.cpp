@@ -0,0 +1,407 @@
+/*
+ * This file is part of the DXX-Rebirth project <https://www.dxx-rebirth.com/>.
+ * It is copyright by its individual contributors, as recorded in the
+ * project's Git history.  See COPYING.txt at the top level for license
+ * terms and a link to the Git history.
+ */
+/*
+ *
+ * Recorded input streams, replayed to check that two builds or two
+ * sets of options simulate the same game
+ *
+ */
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include "replay.h"
+#include "args.h"
+#include "console.h"
+#include "endlevel.h"
+#include "game.h"
+#include "gameseq.h"
+#include "inferno.h"
+#include "kconfig.h"
+#include "maths.h"
+#include "newdemo.h"
+#include "object.h"
+#include "physfsx.h"
+#include "player.h"
+#include "segment.h"
+#include "state.h"
+#include "strutil.h"
+#include "timer.h"
+
+#include "compiler-range_for.h"
+
+#define REPLAY_SAVEGAME_FILENAME	PLAYER_DIRECTORY_STRING("replay.sgt")
+
+/* A replay stream is a savegame of the state when recording began,
+ * followed by the frame time and the controls of every frame after it.
+ * Playing it restores the savegame and feeds each frame the recorded
+ * time and controls, so the game simulates the same frames again.
+ *
+ * -replay writes a hash of each object after every frame to a .hsh
+ * file next to the stream.  -replay_check plays the stream again, and
+ * compares its hashes with that file.  Running the two with different
+ * options, such as -nojobs, or with two builds, shows whether an
+ * optimization changed the simulation, and where it first did.
+ *
+ * Both plays start from the restored savegame, so they can be compared
+ * with each other, but not with the run which recorded the stream: a
+ * restore is not exactly the state that was saved.
+ */
+
+namespace dsx {
+
+namespace {
+
+constexpr char replay_id[4] = {'D', 'R', 'P', 'L'};
+constexpr uint32_t replay_version = 1;
+
+struct replay_header
+{
+	char id[4];
+	uint32_t version;
+	/* The layout of the controls depends on the game and the build
+	 * options, so a stream can only be played by a build like the one
+	 * which recorded it.
+	 */
+	uint32_t controls_size;
+	uint32_t seed;
+	uint32_t savegame_size;
+};
+
+/* Written whole, so it must stay trivially copyable. */
+struct replay_frame
+{
+	fix64 game_time;
+	fix frame_time;
+	int tick_count;
+	int tick_step;
+	control_info controls;
+};
+
+static_assert(std::is_trivially_copyable<replay_frame>::value, "replay_frame is not trivially copyable");
+
+enum class replay_mode : uint8_t
+{
+	none,
+	record,
+	play,
+	check,
+	/* A stream was recorded or played, or could not be; do not start
+	 * another.
+	 */
+	finished,
+};
+
+struct replay_state
+{
+	replay_mode mode;
+	bool diverged;
+	int level;
+	unsigned frame;
+	RAIIPHYSFS_File input, hashes;
+	std::string path;
+	std::vector<uint32_t> current, reference;
+};
+
+}
+
+static replay_state replay;
+
+static uint32_t replay_hash(uint32_t h, const fix v)
+{
+	/* FNV-1a, over whole values so that it does not depend on the
+	 * byte order
+	 */
+	h ^= static_cast<uint32_t>(v);
+	return h * 16777619u;
+}
+
+static uint32_t replay_hash(uint32_t h, const vms_vector &v)
+{
+	return replay_hash(replay_hash(replay_hash(h, v.x), v.y), v.z);
+}
+
+static uint32_t replay_hash_object(const object_base &obj)
+{
+	uint32_t h = replay_hash(2166136261u, obj.type);
+	if (obj.type == OBJ_NONE)
+		return h;
+	h = replay_hash(h, obj.id);
+	h = replay_hash(h, obj.flags);
+	h = replay_hash(h, obj.segnum);
+	h = replay_hash(h, obj.pos);
+	h = replay_hash(h, obj.orient.rvec);
+	h = replay_hash(h, obj.orient.uvec);
+	h = replay_hash(h, obj.orient.fvec);
+	h = replay_hash(h, obj.shields);
+	if (obj.movement_type == MT_PHYSICS)
+	{
+		h = replay_hash(h, obj.mtype.phys_info.velocity);
+		h = replay_hash(h, obj.mtype.phys_info.rotvel);
+	}
+	return h;
+}
+
+static void replay_hash_objects(std::vector<uint32_t> &out)
+{
+	out.clear();
+	range_for (const auto &&objp, vcobjptr)
+		out.push_back(replay_hash_object(objp));
+}
+
+static void replay_record_start()
+{
+	auto &r = replay;
+	r.mode = replay_mode::finished;
+	/* state_save_all_sub writes a fixed length description */
+	char desc[32] = "replay";
+	if (!state_save_all_sub(REPLAY_SAVEGAME_FILENAME, desc))
+		return;
+	state_wait_for_writes();
+	std::vector<uint8_t> savegame;
+	{
+		RAIIPHYSFS_File fp{PHYSFS_openRead(REPLAY_SAVEGAME_FILENAME)};
+		if (!fp)
+			return;
+		savegame.resize(PHYSFS_fileLength(fp));
+		if (PHYSFS_read(fp, savegame.data(), 1, savegame.size()) != static_cast<PHYSFS_sint64>(savegame.size()))
+			return;
+	}
+	r.path = DEMO_DIR + CGameArg.SysReplayRecord;
+	r.input = PHYSFSX_openWriteBuffered(r.path.c_str());
+	if (!r.input)
+	{
+		con_printf(CON_URGENT, "replay: failed to open \"%s\": %s", r.path.c_str(), PHYSFS_getLastError());
+		return;
+	}
+	replay_header h{};
+	memcpy(h.id, replay_id, sizeof(h.id));
+	h.version = replay_version;
+	h.controls_size = sizeof(control_info);
+	h.seed = static_cast<uint32_t>(timer_query());
+	h.savegame_size = savegame.size();
+	PHYSFS_write(r.input, &h, sizeof(h), 1);
+	PHYSFS_write(r.input, savegame.data(), 1, savegame.size());
+	/* The plays seed the generator the same way after they restore. */
+	d_srand(h.seed);
+	r.mode = replay_mode::record;
+	r.level = Current_level_num;
+	r.frame = 0;
+	con_printf(CON_NORMAL, "replay: recording to \"%s\"", r.path.c_str());
+}
+
+static void replay_record_stop()
+{
+	auto &r = replay;
+	r.input.reset();
+	r.mode = replay_mode::finished;
+	con_printf(CON_URGENT, "replay: recorded %u frames to \"%s\"", r.frame, r.path.c_str());
+}
+
+static bool replay_record_allowed()
+{
+	return !(Game_mode & GM_MULTI) && Newdemo_state != ND_STATE_PLAYBACK && Player_dead_state == player_dead_state::no && !Endlevel_sequence;
+}
+
+bool replay_active()
+{
+	const auto mode = replay.mode;
+	return mode != replay_mode::none && mode != replay_mode::finished;
+}
+
+bool replay_playing()
+{
+	const auto mode = replay.mode;
+	return mode == replay_mode::play || mode == replay_mode::check;
+}
+
+bool replay_start()
+{
+	auto &r = replay;
+	if (r.mode != replay_mode::none)
+		return false;
+	r.mode = replay_mode::finished;
+	const bool check = !CGameArg.SysReplayCheck.empty();
+	r.path = DEMO_DIR + (check ? CGameArg.SysReplayCheck : CGameArg.SysReplay);
+	auto input = PHYSFSX_openReadBuffered(r.path.c_str());
+	if (!input)
+	{
+		con_printf(CON_URGENT, "replay: failed to open \"%s\": %s", r.path.c_str(), PHYSFS_getLastError());
+		return false;
+	}
+	replay_header h;
+	if (PHYSFS_read(input, &h, sizeof(h), 1) != 1 || memcmp(h.id, replay_id, sizeof(h.id)) || h.version != replay_version || h.controls_size != sizeof(control_info))
+	{
+		con_printf(CON_URGENT, "replay: \"%s\" was not recorded by a build like this one", r.path.c_str());
+		return false;
+	}
+	{
+		std::vector<uint8_t> savegame(h.savegame_size);
+		if (PHYSFS_read(input, savegame.data(), 1, savegame.size()) != static_cast<PHYSFS_sint64>(savegame.size()))
+		{
+			con_printf(CON_URGENT, "replay: \"%s\" is truncated", r.path.c_str());
+			return false;
+		}
+		RAIIPHYSFS_File fp{PHYSFS_openWrite(REPLAY_SAVEGAME_FILENAME)};
+		if (!fp || (PHYSFS_write)(fp, savegame.data(), 1, savegame.size()) != static_cast<PHYSFS_sint64>(savegame.size()) || !fp.close())
+		{
+			con_printf(CON_URGENT, "replay: failed to write %s: %s", REPLAY_SAVEGAME_FILENAME, PHYSFS_getLastError());
+			return false;
+		}
+	}
+	char hash_path[PATH_MAX];
+	change_filename_extension(hash_path, r.path.c_str(), "hsh");
+	auto hashes = check ? PHYSFSX_openReadBuffered(hash_path) : PHYSFSX_openWriteBuffered(hash_path);
+	if (!hashes)
+	{
+		con_printf(CON_URGENT, "replay: failed to open \"%s\": %s", hash_path, PHYSFS_getLastError());
+		return false;
+	}
+	if (!state_restore_all_sub(
+#if defined(DXX_BUILD_DESCENT_II)
+		LevelSharedSegmentState.DestructibleLights, secret_restore::none,
+#endif
+		REPLAY_SAVEGAME_FILENAME))
+	{
+		con_printf(CON_URGENT, "replay: failed to restore the start of \"%s\"", r.path.c_str());
+		return false;
+	}
+	d_srand(h.seed);
+	r.input = std::move(input);
+	r.hashes = std::move(hashes);
+	r.mode = check ? replay_mode::check : replay_mode::play;
+	r.diverged = false;
+	r.frame = 0;
+	return true;
+}
+
+/* Write the hashes of the state left by the previous frame, or compare
+ * them with the reference.  Returns false at the first divergence.
+ */
+static bool replay_hash_frame()
+{
+	auto &r = replay;
+	replay_hash_objects(r.current);
+	const uint32_t count = r.current.size();
+	if (r.mode == replay_mode::play)
+	{
+		PHYSFS_write(r.hashes, &count, sizeof(count), 1);
+		PHYSFS_write(r.hashes, r.current.data(), sizeof(uint32_t), count);
+		return true;
+	}
+	uint32_t reference_count;
+	if (PHYSFS_read(r.hashes, &reference_count, sizeof(reference_count), 1) != 1)
+	{
+		con_printf(CON_URGENT, "replay: the reference ends before frame %u", r.frame);
+		r.diverged = true;
+		return false;
+	}
+	r.reference.resize(reference_count);
+	if (PHYSFS_read(r.hashes, r.reference.data(), sizeof(uint32_t), reference_count) != static_cast<PHYSFS_sint64>(reference_count))
+	{
+		con_printf(CON_URGENT, "replay: the reference is truncated at frame %u", r.frame);
+		r.diverged = true;
+		return false;
+	}
+	const auto common = std::min(count, reference_count);
+	const auto mismatch = std::mismatch(r.current.begin(), r.current.begin() + common, r.reference.begin());
+	const unsigned objnum = mismatch.first - r.current.begin();
+	if (objnum == common && count == reference_count)
+		return true;
+	r.diverged = true;
+	if (objnum < count)
+	{
+		const auto &&objp = vcobjptr(static_cast<objnum_t>(objnum));
+		con_printf(CON_URGENT, "replay: frame %u differs first at object %u (type %u, id %u, segment %hu)", r.frame, objnum, objp->type, objp->id, static_cast<segnum_t>(objp->segnum));
+	}
+	else
+		con_printf(CON_URGENT, "replay: frame %u differs first at object %u, which exists only in the reference", r.frame, objnum);
+	return false;
+}
+
+bool replay_frame_begin()
+{
+	auto &r = replay;
+	switch (r.mode)
+	{
+		case replay_mode::none:
+			if (!CGameArg.SysReplayRecord.empty() && replay_record_allowed())
+				replay_record_start();
+			if (r.mode != replay_mode::record)
+				return false;
+			//-fallthrough
+		case replay_mode::record:
+			/* One level is recorded, up to the first death or the exit */
+			if (!replay_record_allowed() || Current_level_num != r.level)
+			{
+				replay_record_stop();
+				return false;
+			}
+			{
+				const replay_frame f{GameTime64, FrameTime, d_tick_count, d_tick_step, Controls};
+				(PHYSFS_write)(r.input, &f, sizeof(f), 1);
+			}
+			++r.frame;
+			return false;
+		case replay_mode::play:
+		case replay_mode::check:
+			break;
+		case replay_mode::finished:
+		default:
+			return false;
+	}
+	if (!replay_hash_frame())
+		return true;
+	replay_frame f;
+	if ((PHYSFS_read)(r.input, &f, sizeof(f), 1) != 1)
+		return true;
+	GameTime64 = f.game_time;
+	FrameTime = f.frame_time;
+	d_tick_count = f.tick_count;
+	d_tick_step = f.tick_step;
+	Controls = f.controls;
+	++r.frame;
+	return false;
+}
+
+void replay_stop()
+{
+	auto &r = replay;
+	switch (r.mode)
+	{
+		case replay_mode::record:
+			replay_record_stop();
+			return;
+		case replay_mode::play:
+			con_printf(CON_URGENT, "replay: wrote the hashes of %u frames of \"%s\"", r.frame, r.path.c_str());
+			break;
+		case replay_mode::check:
+			if (!r.diverged)
+			{
+				uint32_t reference_count;
+				if (PHYSFS_read(r.hashes, &reference_count, sizeof(reference_count), 1) == 1)
+					con_printf(CON_URGENT, "replay: the reference continues past frame %u", r.frame);
+				else
+					con_printf(CON_URGENT, "replay: all %u frames of \"%s\" match the reference", r.frame, r.path.c_str());
+			}
+			break;
+		case replay_mode::none:
+		case replay_mode::finished:
+		default:
+			return;
+	}
+	r.input.reset();
+	r.hashes.reset();
+	r.mode = replay_mode::finished;
+	Quitting = 1;
+}
+
+}
@@ -33,6 +33,7 @@ COPYRIGHT 1993-1999 PARALLAX SOFTWARE CORPORATION.  ALL RIGHTS RESERVED.
 #include "songs.h"
 #include "strutil.h"
 #include "digi.h"
+#include "hmp.h"
 #include "rbaudio.h"
 #if DXX_USE_SDLMIXER
 #include "digi_mixer_music.h"
@@ -44,6 +45,7 @@ COPYRIGHT 1993-1999 PARALLAX SOFTWARE CORPORATION.  ALL RIGHTS RESERVED.
 #include "args.h"
 #include "physfsx.h"
 #include "game.h"
+#include "profile.h"
 
 int Songs_initialized = 0;
 static int Song_playing = -1; // -1 if no song playing, else the Descent song number
@@ -82,6 +84,7 @@ void songs_set_volume(int volume)
 namespace dsx {
 static void songs_init()
 {
+	const trace_scope trace_phase("songs_init");
 	int i = 0;
 	Songs_initialized = 0;
 
@@ -498,6 +501,27 @@ static void redbook_first_song_func()
 
 // play track given by levelnum (depending on the music type and it's playing behaviour) or increment/decrement current track number via offset value
 namespace dsx {
+/* Convert the song songs_play_level_song would play for levelnum while
+ * the level loads, so that starting it does not stall.
+ */
+void songs_prefetch_level_song(const int levelnum)
+{
+#if !defined(_WIN32) && DXX_USE_SDLMIXER
+	if (GameCfg.MusicType != MUSIC_TYPE_BUILTIN)
+		return;
+	songs_init();
+	if (!Songs_initialized || Num_bim_songs - SONG_FIRST_LEVEL_SONG <= 0)
+		return;
+	const int songnum = (levelnum > 0) ? (levelnum - 1) : (-levelnum);
+	const char *const filename = BIMSongs[SONG_FIRST_LEVEL_SONG + (songnum % (Num_bim_songs - SONG_FIRST_LEVEL_SONG))].filename;
+	const char *const fptr = strrchr(filename, '.');
+	if (fptr && !d_stricmp(fptr + 1, SONG_EXT_HMP))
+		hmp2mid_prefetch(filename);
+#else
+	(void)levelnum;
+#endif
+}
+
 int songs_play_level_song( int levelnum, int offset )
 {
 	int songnum;
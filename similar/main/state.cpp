@@ -27,6 +27,10 @@ COPYRIGHT 1993-1999 PARALLAX SOFTWARE CORPORATION.  ALL RIGHTS RESERVED.
 #include <stdlib.h>
 #include <math.h>
 #include <string.h>
+#include <deque>
+#include <string>
+#include <vector>
+#include <SDL.h>
 
 #include "pstypes.h"
 #include "inferno.h"
@@ -56,6 +60,7 @@ COPYRIGHT 1993-1999 PARALLAX SOFTWARE CORPORATION.  ALL RIGHTS RESERVED.
 #include "robot.h"
 #include "gauges.h"
 #include "newdemo.h"
+#include "endlevel.h"
 #include "automap.h"
 #include "piggy.h"
 #include "paging.h"
@@ -613,6 +618,106 @@ static void state_player_rw_to_player(const player_rw *pl_rw, player *pl, player
 }
 }
 
+namespace dcx {
+
+namespace {
+
+/* A savegame is built in the write buffer of a handle to a temporary
+ * file.  A worker thread then closes the handle, which writes the
+ * buffer to disk, and renames the file over the old one, so that the
+ * game does not wait for the disk and a failed write leaves the old
+ * savegame intact.  Only one write is outstanding at a time.
+ */
+struct state_write_job
+{
+	RAIIPHYSFS_File fp;
+	std::string temp_filename, filename;
+};
+
+struct state_writer_state
+{
+	SDL_Thread *thread;
+	state_write_job job;
+};
+
+}
+
+static state_writer_state state_writer;
+
+static int state_write_finish(state_write_job &job)
+{
+	if (!job.fp.close())
+	{
+		job.fp.reset();
+		PHYSFS_delete(job.temp_filename.c_str());
+		return 0;
+	}
+	if (PHYSFSX_rename(job.temp_filename.c_str(), job.filename.c_str()))
+		return 1;
+	/* rename does not replace an existing file on Windows */
+	PHYSFS_delete(job.filename.c_str());
+	return PHYSFSX_rename(job.temp_filename.c_str(), job.filename.c_str());
+}
+
+static int state_write_thread(void *)
+{
+	return state_write_finish(state_writer.job);
+}
+
+// Returns false if the outstanding write failed.
+static bool state_writer_wait()
+{
+	auto &w = state_writer;
+	if (!w.thread)
+		return true;
+	int ok;
+	SDL_WaitThread(w.thread, &ok);
+	w.thread = nullptr;
+	if (!ok)
+		con_printf(CON_URGENT, "Failed to write %s", w.job.filename.c_str());
+	return ok;
+}
+
+// Called before starting a write, where a failure can be shown.
+static void state_writer_check()
+{
+	if (!state_writer_wait())
+		nm_messagebox(NULL, 1, TXT_OK, "Error writing savegame.\nPossibly out of disk\nspace.");
+}
+
+/* Open a buffered handle to a temporary file next to filename.  The
+ * caller writes the whole file, then passes the handle to
+ * state_writer_start.
+ */
+static RAIIPHYSFS_File state_writer_open(const char *const filename, std::string &temp_filename)
+{
+	temp_filename = filename;
+	temp_filename += ".tmp";
+	return PHYSFSX_openWriteBuffered(temp_filename.c_str());
+}
+
+// Returns false if the file was written on this thread and failed.
+static bool state_writer_start(RAIIPHYSFS_File &&fp, std::string &&temp_filename, const char *const filename)
+{
+	auto &w = state_writer;
+	w.job.fp = std::move(fp);
+	w.job.temp_filename = std::move(temp_filename);
+	w.job.filename = filename;
+#if SDL_MAJOR_VERSION == 2
+	w.thread = SDL_CreateThread(state_write_thread, "state_write", nullptr);
+#else
+	w.thread = SDL_CreateThread(state_write_thread, nullptr);
+#endif
+	return w.thread || state_write_finish(w.job);
+}
+
+void state_wait_for_writes()
+{
+	state_writer_wait();
+}
+
+}
+
 static void state_write_player(PHYSFS_File *fp, const player &pl, const fix pl_shields, const player_info &pl_info)
 {
 	player_rw pl_rw;
@@ -713,6 +818,7 @@ static int state_get_savegame_filename(char * fname, char * dsc, const char * ca
 	char id[5], dummy_callsign[CALLSIGN_LEN+1];
 	int valid;
 
+	state_writer_check();
 	nsaves=0;
 	nm_set_item_text(m[0], "\n\n\n\n");
 	for (i=0;i<NUM_SAVES; i++ )	{
@@ -808,10 +914,13 @@ int state_get_restore_file(char * fname, blind_save blind_save)
 static int copy_file(const char *old_file, const char *new_file)
 {
 	int		buf_size;
+	/* old_file may be the outstanding write */
+	state_writer_check();
 	RAIIPHYSFS_File in_file{PHYSFS_openRead(old_file)};
 	if (!in_file)
 		return -2;
-	RAIIPHYSFS_File out_file{PHYSFS_openWrite(new_file)};
+	std::string temp_filename;
+	auto out_file = state_writer_open(new_file, temp_filename);
 	if (!out_file)
 		return -1;
 
@@ -838,7 +947,7 @@ static int copy_file(const char *old_file, const char *new_file)
 		if (PHYSFS_write(out_file, buf, 1, bytes_read) < bytes_read)
 			Error("Cannot write to file <%s>: %s", new_file, PHYSFS_getLastError());
 	}
-	if (!out_file.close())
+	if (!state_writer_start(std::move(out_file), std::move(temp_filename), new_file))
 		return -4;
 
 	return 0;
@@ -940,6 +1049,13 @@ int state_save_all(const secret_save secret, const blind_save blind_save)
 
 	if (rval && secret == secret_save::none)
 		HUD_init_message_literal(HM_DEFAULT, "Game saved");
+#if defined(DXX_BUILD_DESCENT_II)
+	/* The level sequencing code checks for the secret level files
+	 * directly, so they must be in place before this returns.
+	 */
+	if (secret != secret_save::none)
+		state_writer_check();
+#endif
 
 	return rval;
 }
@@ -957,9 +1073,11 @@ int state_save_all_sub(const char *filename, const char *desc)
 		Int3();
 	#endif
 
-	auto fp = PHYSFSX_openWriteBuffered(filename);
+	state_writer_check();
+	std::string temp_filename;
+	auto fp = state_writer_open(filename, temp_filename);
 	if ( !fp ) {
-		con_printf(CON_URGENT, "Failed to open %s: %s", filename, PHYSFS_getLastError());
+		con_printf(CON_URGENT, "Failed to open %s: %s", temp_filename.c_str(), PHYSFS_getLastError());
 		nm_messagebox(NULL, 1, TXT_OK, "Error writing savegame.\nPossibly out of disk\nspace.");
 		return 0;
 	}
@@ -995,6 +1113,7 @@ int state_save_all_sub(const char *filename, const char *desc)
 #if DXX_USE_OGL
 		RAIIdmem<uint8_t[]> buf;
 		MALLOC(buf, uint8_t[], THUMBNAIL_W * THUMBNAIL_H * 4);
+		ogl_flush_text_batch();
 #if !DXX_USE_OGLES
 		GLint gl_draw_buffer;
  		glGetIntegerv(GL_DRAW_BUFFER, &gl_draw_buffer);
@@ -1226,7 +1345,13 @@ int state_save_all_sub(const char *filename, const char *desc)
 			m = -1;
 		PHYSFS_write(fp, &m, sizeof(m), 1);
 	}
-	PHYSFS_seek(fp, PHYSFS_tell(fp) + (NUM_MARKERS)*(CALLSIGN_LEN+1)); // PHYSFS_write(fp, MarkerOwner, sizeof(MarkerOwner), 1); MarkerOwner is obsolete
+	{
+		/* MarkerOwner is obsolete.  Write zeroes where it was, since a
+		 * seek would flush the write buffer.
+		 */
+		const array<char, NUM_MARKERS * (CALLSIGN_LEN + 1)> MarkerOwner{};
+		PHYSFS_write(fp, MarkerOwner.data(), MarkerOwner.size(), 1);
+	}
 	range_for (const auto &m, MarkerState.message)
 		PHYSFS_write(fp, m.data(), m.size(), 1);
 
@@ -1311,9 +1436,192 @@ int state_save_all_sub(const char *filename, const char *desc)
 		PHYSFS_write(fp, &Netgame.numconnected, sizeof(ubyte), 1);
 		PHYSFS_write(fp, &Netgame.level_time, sizeof(int), 1);
 	}
+	if (!state_writer_start(std::move(fp), std::move(temp_filename), filename))
+	{
+		nm_messagebox(NULL, 1, TXT_OK, "Error writing savegame.\nPossibly out of disk\nspace.");
+		return 0;
+	}
 	return 1;
 }
 
+#define REWIND_FILENAME	PLAYER_DIRECTORY_STRING("rewind.sgt")
+
+namespace {
+
+constexpr unsigned rewind_max_snapshots = 16;
+
+/* Snapshots for -rewind.  The newest is kept whole.  Each older one is
+ * kept as the changes which turn the snapshot after it back into it,
+ * which are small since little of a level changes in a few seconds.
+ * Snapshots are ordinary savegames, written to REWIND_FILENAME in the
+ * background and read back when the next one is due.
+ */
+struct state_rewind_ring
+{
+	std::vector<uint8_t> newest;
+	// most recent first
+	std::deque<std::vector<uint8_t>> older;
+	fix64 next_time;
+	// REWIND_FILENAME holds a snapshot which has not been read yet
+	bool pending;
+};
+
+}
+
+static state_rewind_ring state_rewind;
+
+static void rewind_put_count(std::vector<uint8_t> &out, std::size_t n)
+{
+	for (; n >= 0x80; n >>= 7)
+		out.push_back(static_cast<uint8_t>(n) | 0x80);
+	out.push_back(static_cast<uint8_t>(n));
+}
+
+static std::size_t rewind_get_count(const uint8_t *&p)
+{
+	std::size_t n = 0;
+	for (unsigned shift = 0;; shift += 7)
+	{
+		const uint8_t b = *p++;
+		n |= static_cast<std::size_t>(b & 0x7f) << shift;
+		if (!(b & 0x80))
+			return n;
+	}
+}
+
+/* Encode target as the length of target, then pairs of counts: bytes
+ * equal to base at the same offset, and bytes which follow literally.
+ */
+static std::vector<uint8_t> rewind_delta(const std::vector<uint8_t> &base, const std::vector<uint8_t> &target)
+{
+	std::vector<uint8_t> out;
+	rewind_put_count(out, target.size());
+	const auto b = base.data();
+	const auto t = target.data();
+	const std::size_t size = target.size(), common = std::min(base.size(), size);
+	for (std::size_t i = 0; i != size;)
+	{
+		const auto same = i;
+		while (i != common && b[i] == t[i])
+			++i;
+		const auto literal = i;
+		// A short match costs more to encode than it saves
+		while (i != size && !(i + 4 <= common && !memcmp(b + i, t + i, 4)))
+			++i;
+		rewind_put_count(out, literal - same);
+		rewind_put_count(out, i - literal);
+		out.insert(out.end(), t + literal, t + i);
+	}
+	return out;
+}
+
+static std::vector<uint8_t> rewind_undelta(const std::vector<uint8_t> &base, const std::vector<uint8_t> &delta)
+{
+	const uint8_t *p = delta.data();
+	const auto size = rewind_get_count(p);
+	std::vector<uint8_t> out;
+	out.reserve(size);
+	while (out.size() != size)
+	{
+		const auto at = out.size();
+		const auto same = rewind_get_count(p);
+		out.insert(out.end(), base.begin() + at, base.begin() + at + same);
+		const auto literal = rewind_get_count(p);
+		out.insert(out.end(), p, p + literal);
+		p += literal;
+	}
+	return out;
+}
+
+// Add the snapshot in REWIND_FILENAME, if any, to the ring.
+static void state_rewind_collect()
+{
+	auto &r = state_rewind;
+	if (!r.pending)
+		return;
+	r.pending = false;
+	if (!state_writer_wait())
+		return;
+	RAIIPHYSFS_File fp{PHYSFS_openRead(REWIND_FILENAME)};
+	if (!fp)
+		return;
+	std::vector<uint8_t> snapshot(PHYSFS_fileLength(fp));
+	if (PHYSFS_read(fp, snapshot.data(), 1, snapshot.size()) != static_cast<PHYSFS_sint64>(snapshot.size()))
+		return;
+	if (!r.newest.empty())
+	{
+		r.older.emplace_front(rewind_delta(snapshot, r.newest));
+		if (r.older.size() >= rewind_max_snapshots)
+			r.older.pop_back();
+	}
+	r.newest = std::move(snapshot);
+}
+
+static fix64 state_rewind_interval()
+{
+	return static_cast<fix64>(CGameArg.SysRewindInterval) << 16;
+}
+
+void state_rewind_frame()
+{
+	if (!CGameArg.SysRewindInterval)
+		return;
+	if ((Game_mode & GM_MULTI) || Newdemo_state == ND_STATE_PLAYBACK || Player_dead_state != player_dead_state::no || Endlevel_sequence)
+		return;
+#if defined(DXX_BUILD_DESCENT_II)
+	if (Current_level_num < 0 || Final_boss_is_dead)
+		return;
+#endif
+	auto &r = state_rewind;
+	const auto interval = state_rewind_interval();
+	// GameTime64 starts over on a new level and on a restore
+	if (r.next_time > GameTime64 + interval)
+		r.next_time = GameTime64 + interval;
+	if (GameTime64 < r.next_time)
+		return;
+	r.next_time = GameTime64 + interval;
+	state_rewind_collect();
+	char desc[DESC_LENGTH + 1] = "rewind";
+	if (state_save_all_sub(REWIND_FILENAME, desc))
+		r.pending = true;
+}
+
+void state_rewind_restore(const bool older)
+{
+	auto &r = state_rewind;
+	state_rewind_collect();
+	if (older && !r.older.empty())
+	{
+		r.newest = rewind_undelta(r.newest, r.older.front());
+		r.older.pop_front();
+	}
+	if (r.newest.empty())
+	{
+		HUD_init_message_literal(HM_DEFAULT, "No rewind snapshot");
+		return;
+	}
+	if (Newdemo_state == ND_STATE_RECORDING)
+		newdemo_stop_recording();
+	if (Newdemo_state != ND_STATE_NORMAL)
+		return;
+	{
+		RAIIPHYSFS_File fp{PHYSFS_openWrite(REWIND_FILENAME)};
+		if (!fp)
+			return;
+		if ((PHYSFS_write)(fp, r.newest.data(), 1, r.newest.size()) != static_cast<PHYSFS_sint64>(r.newest.size()) || !fp.close())
+		{
+			con_printf(CON_URGENT, "Failed to write %s: %s", REWIND_FILENAME, PHYSFS_getLastError());
+			return;
+		}
+	}
+	if (state_restore_all_sub(
+#if defined(DXX_BUILD_DESCENT_II)
+		LevelSharedSegmentState.DestructibleLights, secret_restore::none,
+#endif
+		REWIND_FILENAME))
+		r.next_time = GameTime64 + state_rewind_interval();
+}
+
 //	-----------------------------------------------------------------------------------
 //	Set the player's position from the globals Secret_return_segment and Secret_return_orient.
 #if defined(DXX_BUILD_DESCENT_II)
@@ -1399,6 +1707,7 @@ int state_restore_all(const int in_game, const secret_restore secret, const char
 				rval = copy_file(temp_fname, SECRETC_FILENAME);
 				Assert(rval == 0);	//	Oops, error copying temp_fname to secret.sgc!
 				(void)rval;
+				state_writer_check();
 			} else
 				PHYSFS_delete(SECRETC_FILENAME);
 		}
@@ -1449,6 +1758,7 @@ int state_restore_all_sub(const d_level_shared_destructible_light_state &LevelSh
 		Int3();
 	#endif
 
+	state_writer_check();
 	auto fp = PHYSFSX_openReadBuffered(filename);
 	if ( !fp ) return 0;
 
@@ -1636,7 +1946,10 @@ int state_restore_all_sub(const d_level_shared_destructible_light_state &LevelSh
 
 	//Read objects, and pop 'em into their respective segments.
 	{
-		const int i = PHYSFSX_readSXE32(fp, swap);
+		const unsigned i = PHYSFSX_readSXE32(fp, swap);
+		/* Saved by a build with a larger max_objects */
+		if (i > MAX_OBJECTS)
+			Error("Savegame has %u objects, but this build supports at most %u.  Rebuild with max_objects=%u to restore it.", i, static_cast<unsigned>(MAX_OBJECTS), i);
 	Objects.set_count(i);
 	}
 	range_for (const auto &&objp, vmobjptr)
@@ -1765,6 +2078,9 @@ int state_restore_all_sub(const d_level_shared_destructible_light_state &LevelSh
 			TempTmapNum2[segp][j] = PHYSFSX_readSXE16(fp, swap);
 		}
 	}
+	//	The walls of each side were replaced, so the copy the renderer
+	//	walks may be stale.
+	render_build_segment_tables();
 
 	//Restore the fuelcen info
 	Control_center_destroyed = PHYSFSX_readSXE32(fp, swap);
@@ -1815,6 +2131,7 @@ int state_restore_all_sub(const d_level_shared_destructible_light_state &LevelSh
 	}
 	else
 		PHYSFS_read(fp, &Automap_visited[0], sizeof(ubyte), MAX_SEGMENTS_ORIGINAL);
+	automap_invalidate_edges();
 
 	{
 	//	Restore hacked up weapon system stuff.
@@ -1985,6 +2302,7 @@ int state_restore_all_sub(const d_level_shared_destructible_light_state &LevelSh
 			uside.tmap_num2 = TempTmapNum2[segp][j];
 		}
 	}
+	flush_fcd_cache();
 
 // Read Coop Info
 	if (Game_mode & GM_MULTI_COOP)
@@ -2105,6 +2423,7 @@ int state_get_game_id(const char *filename)
 	if (!(Game_mode & GM_MULTI_COOP))
 		return 0;
 
+	state_writer_check();
 	auto fp = PHYSFSX_openReadBuffered(filename);
 	if ( !fp ) return 0;
 
@@ -24,6 +24,7 @@ COPYRIGHT 1993-1999 PARALLAX SOFTWARE CORPORATION.  ALL RIGHTS RESERVED.
  */
 
 #include <bitset>
+#include <vector>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -41,8 +42,12 @@ COPYRIGHT 1993-1999 PARALLAX SOFTWARE CORPORATION.  ALL RIGHTS RESERVED.
 #include "fireball.h"
 #include "render.h"
 #include "terrain.h"
+#if DXX_USE_OGL
+#include "ogl_init.h"
+#endif
 
 #include "compiler-make_unique.h"
+#include "compiler-range_for.h"
 
 #define GRID_MAX_SIZE   64
 #define GRID_SCALE      i2f(2*20)
@@ -68,6 +73,14 @@ static int org_i,org_j;
 // LINT: adding function prototypes
 static void build_light_table(void);
 
+static void render_exit_mine(grs_canvas &canvas, const vms_vector &Viewer_eye)
+{
+	window_rendered_data window;
+	render_mine(canvas, Viewer_eye, exit_segnum, 0, window);
+	//if (ext_expl_playing)
+	//	draw_fireball(&external_explosion);
+}
+
 // ------------------------------------------------------------------------
 static void draw_cell(grs_canvas &canvas, const vms_vector &Viewer_eye, const int i, const int j, cg3s_point &p0, cg3s_point &p1, cg3s_point &p2, cg3s_point &p3, int &mine_tiles_drawn)
 {
@@ -139,10 +152,7 @@ static void draw_cell(grs_canvas &canvas, const vms_vector &Viewer_eye, const in
 	if (mine_tiles_drawn == 0xf) {
 		//draw_exit_model();
 		mine_tiles_drawn=-1;
-		window_rendered_data window;
-		render_mine(canvas, Viewer_eye, exit_segnum, 0, window);
-		//if (ext_expl_playing)
-		//	draw_fireball(&external_explosion);
+		render_exit_mine(canvas, Viewer_eye);
 	}
 
 }
@@ -175,6 +185,130 @@ vms_vector &terrain_y_cache::operator()(uint_fast32_t h)
 	return dyp;
 }
 
+#if DXX_USE_OGL
+namespace {
+
+/* The grid is drawn from a buffer object in chunks of this many cells on
+ * each side, and chunks which are entirely off screen are skipped.
+ */
+constexpr unsigned TERRAIN_CHUNK_CELLS = 8;
+
+struct terrain_chunk
+{
+	uint8_t i0, j0, i1, j1;		// cells [i0, i1) x [j0, j1)
+	array<vms_vector, 8> corners;	// bounding box in world space
+};
+
+struct terrain_mesh_state
+{
+	bool built, buffered;
+	vms_vector org_point;
+	vms_matrix orient;
+	int org_i, org_j;
+	std::vector<terrain_chunk> chunks;
+	std::vector<uint16_t> indices;
+};
+
+}
+
+static terrain_mesh_state terrain_mesh;
+
+static vms_vector terrain_point(const vms_vector &start_point, const int i, const int j, const unsigned h)
+{
+	auto p = vm_vec_scale_add(start_point, surface_orient.rvec, i * GRID_SCALE);
+	vm_vec_scale_add2(p, surface_orient.fvec, j * GRID_SCALE);
+	vm_vec_scale_add2(p, surface_orient.uvec, h * HEIGHT_SCALE);
+	return p;
+}
+
+/* The grid only moves when the exit does, so its points are put in world
+ * space once and kept in a buffer object with their light.
+ */
+static void build_terrain_mesh(const vms_vector &org_point)
+{
+	auto &m = terrain_mesh;
+	m.built = true;
+	m.org_point = org_point;
+	m.orient = surface_orient;
+	m.org_i = org_i;
+	m.org_j = org_j;
+	m.chunks.clear();
+	auto start_point = vm_vec_scale_add(org_point, surface_orient.rvec, -org_i * GRID_SCALE);
+	vm_vec_scale_add2(start_point, surface_orient.fvec, -org_j * GRID_SCALE);
+	const unsigned count = grid_w * grid_h;
+	std::vector<vms_vector> points(count);
+	std::vector<g3s_uvl> uvls(count);
+	for (int i = 0; i < grid_w; i++)
+		for (int j = 0; j < grid_h; j++)
+		{
+			const unsigned v = i * grid_h + j;
+			points[v] = terrain_point(start_point, i, j, HEIGHT(i, j));
+			auto &uvl = uvls[v];
+			uvl.u = i * f1_0 / 4;
+			uvl.v = j * f1_0 / 4;
+			uvl.l = LIGHTVAL(i, j);
+		}
+	m.buffered = ogl_build_terrain_buffer(count, points.data(), uvls.data());
+	if (!m.buffered)
+		return;
+	for (int i0 = 0; i0 < grid_w - 1; i0 += TERRAIN_CHUNK_CELLS)
+		for (int j0 = 0; j0 < grid_h - 1; j0 += TERRAIN_CHUNK_CELLS)
+		{
+			terrain_chunk c;
+			c.i0 = i0;
+			c.j0 = j0;
+			c.i1 = std::min<int>(i0 + TERRAIN_CHUNK_CELLS, grid_w - 1);
+			c.j1 = std::min<int>(j0 + TERRAIN_CHUNK_CELLS, grid_h - 1);
+			unsigned max_h = 0;
+			for (int i = c.i0; i <= c.i1; i++)
+				for (int j = c.j0; j <= c.j1; j++)
+					max_h = std::max<unsigned>(max_h, HEIGHT(i, j));
+			for (unsigned k = 0; k != 8; ++k)
+				c.corners[k] = terrain_point(start_point, (k & 1) ? c.i1 : c.i0, (k & 2) ? c.j1 : c.j0, (k & 4) ? max_h : 0);
+			m.chunks.emplace_back(c);
+		}
+}
+
+static bool render_terrain_mesh(grs_canvas &canvas, const vms_vector &Viewer_eye, const vms_vector &org_point)
+{
+	if (terrain_outline)
+		return false;
+	auto &m = terrain_mesh;
+	if (!m.built || m.org_i != org_i || m.org_j != org_j || memcmp(&m.org_point, &org_point, sizeof(m.org_point)) ||
+		memcmp(&m.orient, &surface_orient, sizeof(m.orient)))
+		build_terrain_mesh(org_point);
+	if (!m.buffered)
+		return false;
+	auto &indices = m.indices;
+	indices.clear();
+	range_for (auto &c, m.chunks)
+	{
+		ubyte codes_and = 0xff;
+		range_for (auto &corner, c.corners)
+		{
+			g3s_point p;
+			codes_and &= g3_rotate_point(p, corner);
+		}
+		if (codes_and)
+			continue;
+		for (unsigned i = c.i0; i != c.i1; ++i)
+			for (unsigned j = c.j0; j != c.j1; ++j)
+			{
+				const uint16_t v00 = i * grid_h + j, v01 = v00 + 1, v10 = v00 + grid_h, v11 = v10 + 1;
+				indices.insert(indices.end(), {v00, v01, v10, v01, v11, v10});
+			}
+	}
+	if (!ogl_draw_terrain(canvas, *terrain_bm, indices.data(), indices.size()))
+		return false;
+	/* The depth buffer keeps the nearer cells in front of the mine, so it
+	 * can be drawn after all of them.
+	 */
+	if (org_i > 0 && org_j > 0 && org_i < grid_w - 1 && org_j < grid_h - 1)
+		render_exit_mine(canvas, Viewer_eye);
+	return true;
+}
+#endif
+
 void render_terrain(grs_canvas &canvas, const vms_vector &Viewer_eye, const vms_vector &org_point,int org_2dx,int org_2dy)
 {
 	vms_vector delta_i,delta_j;		//delta_y;
@@ -185,6 +319,10 @@ void render_terrain(grs_canvas &canvas, const vms_vector &Viewer_eye, const vms_
 	int viewer_i,viewer_j;
 	org_i = org_2dy;
 	org_j = org_2dx;
+#if DXX_USE_OGL
+	if (render_terrain_mesh(canvas, Viewer_eye, org_point))
+		return;
+#endif
 
 	low_i = 0;  high_i = grid_w-1;
 	low_j = 0;  high_j = grid_h-1;
@@ -344,6 +482,10 @@ void render_terrain(grs_canvas &canvas, const vms_vector &Viewer_eye, const vms_
 void free_height_array()
 {
 	height_array.reset();
+#if DXX_USE_OGL
+	terrain_mesh.built = terrain_mesh.buffered = false;
+	ogl_free_terrain_buffer();
+#endif
 }
 
 void load_terrain(const char *filename)
@@ -388,6 +530,18 @@ void load_terrain(const char *filename)
 	terrain_bm = terrain_bitmap;
 
 	build_light_table();
+#if DXX_USE_OGL
+	terrain_mesh.built = false;
+#endif
+}
+
+void reuse_terrain()
+{
+	terrain_bm = terrain_bitmap;
+#if DXX_USE_OGL
+	//the mesh is placed relative to the exit, which differs by level
+	terrain_mesh.built = false;
+#endif
 }
 
 
@@ -442,9 +596,12 @@ static void build_light_table()
 	memset(light_array.get(), 0, alloc);
 	int i,j;
 	fix l, l2, min_l = INT32_MAX, max_l = 0;
+	/* Keep each average for the second pass instead of computing it again */
+	std::vector<fix> avg_light(alloc);
+#define AVG_LIGHT(_i,_j) avg_light[(_i)*grid_w+(_j)]
 	for (i=1;i<grid_w;i++)
 		for (j=1;j<grid_h;j++) {
-			l = get_avg_light(i,j);
+			l = AVG_LIGHT(i,j) = get_avg_light(i,j);
 
 			if (l > max_l)
 				max_l = l;
@@ -456,7 +613,7 @@ static void build_light_table()
 	for (i=1;i<grid_w;i++)
 		for (j=1;j<grid_h;j++) {
 
-			l = get_avg_light(i,j);
+			l = AVG_LIGHT(i,j);
 
 			if (min_l == max_l) {
 				LIGHT(i,j) = l>>8;
@@ -471,4 +628,5 @@ static void build_light_table()
 			LIGHT(i,j) = l2>>8;
 
 		}
+#undef AVG_LIGHT
 }
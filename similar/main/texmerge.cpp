@@ -24,7 +24,13 @@ COPYRIGHT 1993-1999 PARALLAX SOFTWARE CORPORATION.  ALL RIGHTS RESERVED.
  */
 
 
+#include <algorithm>
+#include <cstdlib>
+#include <vector>
 #include "gr.h"
+#include "cmd.h"
+#include "console.h"
+#include "strutil.h"
 #include "dxxerror.h"
 #include "game.h"
 #include "textures.h"
@@ -33,6 +39,7 @@ COPYRIGHT 1993-1999 PARALLAX SOFTWARE CORPORATION.  ALL RIGHTS RESERVED.
 #include "piggy.h"
 #include "texmerge.h"
 #include "piggy.h"
+#include "texmap.h"
 
 #include "compiler-range_for.h"
 #include "partial_range.h"
@@ -40,18 +47,34 @@ COPYRIGHT 1993-1999 PARALLAX SOFTWARE CORPORATION.  ALL RIGHTS RESERVED.
 #if DXX_USE_OGL
 #include "ogl_init.h"
 #endif
-#define MAX_NUM_CACHE_BITMAPS 10
-
-//static grs_bitmap * cache_bitmaps[MAX_NUM_CACHE_BITMAPS];                     
+/* Number of merged textures kept when no "texmerge size" command has
+ * changed it.
+ */
+#define DEFAULT_NUM_CACHE_BITMAPS 32
+#define MAX_NUM_CACHE_BITMAPS texmerge_max_capacity
 
 namespace {
 
+/* Entries are found through a hash of the textures and orientation,
+ * and kept in a list from the most to the least recently used.  An
+ * entry with no top_bmp is unused and stays at the end of that list.
+ */
 struct TEXTURE_CACHE {
 	grs_bitmap_ptr bitmap;
 	grs_bitmap * bottom_bmp;
 	grs_bitmap * top_bmp;
 	int 		orient;
-	fix64		last_time_used;
+	TEXTURE_CACHE *lru_prev, *lru_next;
+	TEXTURE_CACHE *hash_next;
+};
+
+struct texmerge_cache_state
+{
+	std::vector<TEXTURE_CACHE> entries;
+	/* A power of two at least twice the number of entries. */
+	std::vector<TEXTURE_CACHE *> buckets;
+	TEXTURE_CACHE *lru_head, *lru_tail;
+	unsigned capacity = DEFAULT_NUM_CACHE_BITMAPS;
 };
 
 /* Helper classes merge_texture_0 through merge_texture_3 correspond to
@@ -162,73 +185,178 @@ static void merge_textures(unsigned orient, const grs_bitmap &expanded_bottom_bm
 	}
 }
 
-static array<TEXTURE_CACHE, MAX_NUM_CACHE_BITMAPS> Cache;
+static texmerge_cache_state Cache;
+static unsigned cache_hits;
+static unsigned cache_misses;
 
-static int cache_hits = 0;
-static int cache_misses = 0;
+static std::size_t texmerge_bucket(const grs_bitmap *const top, const grs_bitmap *const bottom, const unsigned orient)
+{
+	const auto t = reinterpret_cast<uintptr_t>(top), b = reinterpret_cast<uintptr_t>(bottom);
+	/* Bitmaps are elements of GameBitmaps, so the low bits of their
+	 * addresses do not vary; mix the whole address down.
+	 */
+	uint64_t h = (t * 0x9e3779b97f4a7c15ull) ^ (b * 0xc2b2ae3d27d4eb4full) ^ orient;
+	h ^= h >> 29;
+	return h & (Cache.buckets.size() - 1);
+}
 
-//----------------------------------------------------------------------
+static void texmerge_lru_unlink(TEXTURE_CACHE &e)
+{
+	auto &c = Cache;
+	(e.lru_prev ? e.lru_prev->lru_next : c.lru_head) = e.lru_next;
+	(e.lru_next ? e.lru_next->lru_prev : c.lru_tail) = e.lru_prev;
+}
 
-int texmerge_init()
+static void texmerge_lru_push_front(TEXTURE_CACHE &e)
+{
+	auto &c = Cache;
+	e.lru_prev = nullptr;
+	e.lru_next = c.lru_head;
+	(c.lru_head ? c.lru_head->lru_prev : c.lru_tail) = &e;
+	c.lru_head = &e;
+}
+
+static void texmerge_hash_unlink(TEXTURE_CACHE &e)
+{
+	for (auto p = &Cache.buckets[texmerge_bucket(e.top_bmp, e.bottom_bmp, e.orient)]; *p; p = &(*p)->hash_next)
+		if (*p == &e)
+		{
+			*p = e.hash_next;
+			return;
+		}
+}
+
+/* Forget every merged texture, but keep the bitmaps, so that they can
+ * be reused by the next merges.
+ */
+static void texmerge_reset_entries()
 {
-	range_for (auto &i, Cache)
+	auto &c = Cache;
+	std::fill(c.buckets.begin(), c.buckets.end(), nullptr);
+	c.lru_head = c.lru_tail = nullptr;
+	range_for (auto &i, c.entries)
 	{
-		i.bitmap = NULL;
-		i.last_time_used = -1;
 		i.top_bmp = NULL;
 		i.bottom_bmp = NULL;
 		i.orient = -1;
+		i.hash_next = nullptr;
+		texmerge_lru_push_front(i);
 	}
+}
 
-	return 1;
+void texmerge_set_capacity(const unsigned capacity)
+{
+	auto &c = Cache;
+#if !DXX_USE_OGL
+	//	A pending texture map may still use a bitmap being freed.
+	draw_tmap_flush();
+#endif
+	c.capacity = capacity;
+	/* Entries point at each other, so the vector must not reallocate
+	 * once the lists are built.
+	 */
+	std::vector<TEXTURE_CACHE>(capacity).swap(c.entries);
+	unsigned buckets = 1;
+	while (buckets < capacity * 2)
+		buckets <<= 1;
+	c.buckets.assign(buckets, nullptr);
+	texmerge_reset_entries();
 }
 
-void texmerge_flush()
+/* Grow the cache to hold at least `count` merged textures, so that the
+ * overlays of one level do not evict each other.  A smaller count
+ * leaves the cache, and its entries, alone.
+ */
+void texmerge_reserve(unsigned count)
+{
+	count = std::min(count, MAX_NUM_CACHE_BITMAPS);
+	if (count > Cache.capacity)
+		texmerge_set_capacity(count);
+}
+
+static void texmerge_cmd(unsigned long argc, const char *const *const argv)
 {
-	range_for (auto &i, Cache)
+	auto &c = Cache;
+	if (argc == 1)
 	{
-		i.last_time_used = -1;
-		i.top_bmp = NULL;
-		i.bottom_bmp = NULL;
-		i.orient = -1;
+		const auto lookups = cache_hits + cache_misses;
+		con_printf(CON_NORMAL, "texmerge: %u of %u entries, %u hits, %u misses (%u%% hit)", static_cast<unsigned>(std::count_if(c.entries.begin(), c.entries.end(), [](const TEXTURE_CACHE &e) { return e.top_bmp != nullptr; })), c.capacity, cache_hits, cache_misses, lookups ? static_cast<unsigned>(uint64_t(cache_hits) * 100 / lookups) : 0);
+		return;
+	}
+	if (argc == 2 && !d_stricmp(argv[1], "reset"))
+	{
+		cache_hits = cache_misses = 0;
+		return;
 	}
+	if (argc == 3 && !d_stricmp(argv[1], "size"))
+	{
+		char *end;
+		const auto n = strtoul(argv[2], &end, 10);
+		if (!*end && n >= 1 && n <= MAX_NUM_CACHE_BITMAPS)
+		{
+			texmerge_set_capacity(n);
+			return;
+		}
+	}
+	cmd_insertf("help %s", argv[0]);
+}
+
+//----------------------------------------------------------------------
+
+int texmerge_init()
+{
+	texmerge_set_capacity(Cache.capacity);
+	cmd_addcommand("texmerge", texmerge_cmd, "texmerge\n"        "    show the size of the merged texture cache and its hits and misses\n"
+	                                         "texmerge size <n>\n" "    keep up to <n> merged textures, from 1 to 1024\n"
+	                                         "texmerge reset\n"    "    set the hit and miss counts to 0");
+	return 1;
 }
 
+void texmerge_flush()
+{
+	texmerge_reset_entries();
+}
 
 //-------------------------------------------------------------------------
 void texmerge_close()
 {
-	range_for (auto &i, Cache)
+	auto &c = Cache;
+	range_for (auto &i, c.entries)
 	{
 		i.bitmap.reset();
 	}
 }
 
+texmerge_stats texmerge_get_stats()
+{
+	return {cache_hits, cache_misses, Cache.capacity};
+}
+
 //--unused-- int info_printed = 0;
 
 grs_bitmap &texmerge_get_cached_bitmap(unsigned tmap_bottom, unsigned tmap_top)
 {
 	grs_bitmap *bitmap_top, *bitmap_bottom;
 	int orient;
-	int lowest_time_used;
 
 	bitmap_top = &GameBitmaps[Textures[tmap_top&0x3FFF].index];
 	bitmap_bottom = &GameBitmaps[Textures[tmap_bottom].index];
 	
 	orient = ((tmap_top&0xC000)>>14) & 3;
 
-	lowest_time_used = Cache[0].last_time_used;
-	auto least_recently_used = &Cache.front();
-	range_for (auto &i, Cache)
+	auto &c = Cache;
+	auto &bucket = c.buckets[texmerge_bucket(bitmap_top, bitmap_bottom, orient)];
+	for (auto i = bucket; i; i = i->hash_next)
 	{
-		if ( (i.last_time_used > -1) && (i.top_bmp==bitmap_top) && (i.bottom_bmp==bitmap_bottom) && (i.orient==orient ))	{
+		if (i->top_bmp == bitmap_top && i->bottom_bmp == bitmap_bottom && i->orient == orient)
+		{
 			cache_hits++;
-			i.last_time_used = timer_query();
-			return *i.bitmap.get();
-		}	
-		if ( i.last_time_used < lowest_time_used )	{
-			lowest_time_used = i.last_time_used;
-			least_recently_used = &i;
+			if (i != c.lru_head)
+			{
+				texmerge_lru_unlink(*i);
+				texmerge_lru_push_front(*i);
+			}
+			return *i->bitmap.get();
 		}
 	}
 
@@ -236,7 +364,6 @@ grs_bitmap &texmerge_get_cached_bitmap(unsigned tmap_bottom, unsigned tmap_top)
 	cache_misses++;
 
 	// Make sure the bitmaps are paged in...
-
 	PIGGY_PAGE_IN(Textures[tmap_top&0x3FFF]);
 	PIGGY_PAGE_IN(Textures[tmap_bottom]);
 	if (bitmap_bottom->bm_w != bitmap_bottom->bm_h || bitmap_top->bm_w != bitmap_top->bm_h)
@@ -244,27 +371,45 @@ grs_bitmap &texmerge_get_cached_bitmap(unsigned tmap_bottom, unsigned tmap_top)
 	if (bitmap_bottom->bm_w != bitmap_top->bm_w || bitmap_bottom->bm_h != bitmap_top->bm_h)
 		Error("Top and Bottom textures have different size!\nbottom tmap = %u; bottom bitmap = %u; bottom width = %u; bottom height = %u\ntop tmap = %u; top bitmap = %u; top width=%u; top height=%u", tmap_bottom, Textures[tmap_bottom].index, bitmap_bottom->bm_w, bitmap_bottom->bm_h, tmap_top, Textures[tmap_top & 0x3fff].index, bitmap_top->bm_w, bitmap_top->bm_h);
 
-	least_recently_used->bitmap = gr_create_bitmap(bitmap_bottom->bm_w,  bitmap_bottom->bm_h);
+	auto &least_recently_used = *c.lru_tail;
+	if (least_recently_used.top_bmp)
+		texmerge_hash_unlink(least_recently_used);
+	texmerge_lru_unlink(least_recently_used);
+	texmerge_lru_push_front(least_recently_used);
+	least_recently_used.hash_next = bucket;
+	bucket = &least_recently_used;
+
+#if !DXX_USE_OGL
+	//	A pending texture map may still use the bitmap being replaced.
+	if (least_recently_used.bitmap)
+		draw_tmap_flush();
+#endif
+	/* Reuse the bitmap of the entry when it has the right size, rather
+	 * than allocating another.
+	 */
+	auto &bitmap = least_recently_used.bitmap;
+	if (!bitmap || bitmap->bm_w != bitmap_bottom->bm_w || bitmap->bm_h != bitmap_bottom->bm_h)
+		bitmap = gr_create_bitmap(bitmap_bottom->bm_w,  bitmap_bottom->bm_h);
 #if DXX_USE_OGL
-	ogl_freebmtexture(*least_recently_used->bitmap.get());
+	ogl_freebmtexture(*bitmap.get());
 #endif
 
 	auto &expanded_top_bmp = *rle_expand_texture(*bitmap_top);
 	auto &expanded_bottom_bmp = *rle_expand_texture(*bitmap_bottom);
 	if (bitmap_top->get_flag_mask(BM_FLAG_SUPER_TRANSPARENT))
 	{
-		merge_textures<merge_transform_super_xparent>(orient, expanded_bottom_bmp, expanded_top_bmp, least_recently_used->bitmap->get_bitmap_data());
-		gr_set_bitmap_flags(*least_recently_used->bitmap.get(), BM_FLAG_TRANSPARENT);
-		least_recently_used->bitmap->avg_color = bitmap_top->avg_color;
+		merge_textures<merge_transform_super_xparent>(orient, expanded_bottom_bmp, expanded_top_bmp, bitmap->get_bitmap_data());
+		gr_set_bitmap_flags(*bitmap.get(), BM_FLAG_TRANSPARENT);
+		bitmap->avg_color = bitmap_top->avg_color;
 	} else	{
-		merge_textures<merge_transform_new>(orient, expanded_bottom_bmp, expanded_top_bmp, least_recently_used->bitmap->get_bitmap_data());
-		least_recently_used->bitmap->set_flags(bitmap_bottom->get_flag_mask(~BM_FLAG_RLE));
-		least_recently_used->bitmap->avg_color = bitmap_bottom->avg_color;
+		merge_textures<merge_transform_new>(orient, expanded_bottom_bmp, expanded_top_bmp, bitmap->get_bitmap_data());
+		bitmap->set_flags(bitmap_bottom->get_flag_mask(~BM_FLAG_RLE));
+		bitmap->avg_color = bitmap_bottom->avg_color;
 	}
 
-	least_recently_used->top_bmp = bitmap_top;
-	least_recently_used->bottom_bmp = bitmap_bottom;
-	least_recently_used->last_time_used = timer_query();
-	least_recently_used->orient = orient;
-	return *least_recently_used->bitmap.get();
+	least_recently_used.top_bmp = bitmap_top;
+	least_recently_used.bottom_bmp = bitmap_bottom;
+	least_recently_used.orient = orient;
+
+	return *bitmap.get();
 }
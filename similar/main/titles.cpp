@@ -712,6 +712,57 @@ static void put_char_delay(const grs_font &cv_font, briefing *const br, const ch
 static void init_spinning_robot(grs_canvas &canvas, briefing &br);
 static int load_briefing_screen(grs_canvas &, briefing *br, const char *fname);
 
+#if defined(DXX_BUILD_DESCENT_II)
+// $Z names the low resolution screen.  Use the high resolution one, which
+// has a b before the extension, if it is wanted or if it is the only one.
+static void briefing_z_filename(char (&fname)[15])
+{
+	char fname2[15];
+	int i=0;
+	while (fname[i]!='.') {
+		fname2[i] = fname[i];
+		i++;
+	}
+	fname2[i++]='b';
+	fname2[i++]='.';
+	fname2[i++]='p';
+	fname2[i++]='c';
+	fname2[i++]='x';
+	fname2[i++]=0;
+
+	if ((HIRESMODE && PHYSFSX_exists(fname2,1)) || !PHYSFSX_exists(fname,1))
+		strcpy(fname,fname2);
+}
+
+// Decode the screen the next $Z of this briefing loads while the player
+// reads the current one.
+static void preload_next_z_screen(const char *message)
+{
+	for (; *message; ++message)
+	{
+		if (message[0] != '$')
+			continue;
+		if (message[1] == 'S')
+			return;		// start of the next level's briefing
+		if (message[1] != 'Z')
+			continue;
+		message += 2;
+		char fname[15];
+		std::size_t i = 0;
+		for (; message[i] && message[i] != '\n' && message[i] != '\r'; ++i)
+			if (i == sizeof(fname) - 2)		// no room for the b
+				return;
+		memcpy(fname, message, i);
+		fname[i] = 0;
+		if (!strchr(fname, '.'))
+			return;
+		briefing_z_filename(fname);
+		pcx_preload(fname);
+		return;
+	}
+}
+#endif
+
 // Process a character for the briefing,
 // including special characters preceded by a '$'.
 // Return 1 when page is finished, 0 otherwise
@@ -813,25 +864,9 @@ static int briefing_process_char(grs_canvas &canvas, briefing *const br)
 				while (*br->message++ != 10)    //  Get and drop eoln
 					;
 
-			{
-				char fname2[15];
-
-				i=0;
-				while (fname[i]!='.') {
-					fname2[i] = fname[i];
-					i++;
-				}
-				fname2[i++]='b';
-				fname2[i++]='.';
-				fname2[i++]='p';
-				fname2[i++]='c';
-				fname2[i++]='x';
-				fname2[i++]=0;
-
-				if ((HIRESMODE && PHYSFSX_exists(fname2,1)) || !PHYSFSX_exists(fname,1))
-					strcpy(fname,fname2);
-				load_briefing_screen(*grd_curcanv, br, fname);
-			}
+			briefing_z_filename(fname);
+			load_briefing_screen(*grd_curcanv, br, fname);
+			preload_next_z_screen(br->message);
 
 #endif
 		} else if (ch == 'B') {
@@ -1283,15 +1318,10 @@ static int DefineBriefingBox(const grs_bitmap &cv_bitmap, const char *&buf)
 
 static void free_briefing_screen(briefing *br);
 
-//	-----------------------------------------------------------------------------
-//	loads a briefing screen
-static int load_briefing_screen(grs_canvas &canvas, briefing *const br, const char *const fname)
-{
 #if defined(DXX_BUILD_DESCENT_I)
-	int pcx_error;
-	char fname2[PATH_MAX], forigin[PATH_MAX];
-
-	free_briefing_screen(br);
+static void briefing_screen_filename(const char *const fname, char (&fname2)[PATH_MAX])
+{
+	char forigin[PATH_MAX];
 
 	snprintf(fname2, sizeof(char)*PATH_MAX, "%s", fname);
 	snprintf(forigin, sizeof(char)*PATH_MAX, "%s", PHYSFS_getRealDir(fname));
@@ -1308,6 +1338,47 @@ static int load_briefing_screen(grs_canvas &canvas, briefing *const br, const ch
 		if (!PHYSFSX_exists(fname2,1))
 			snprintf(fname2, sizeof(char)*PATH_MAX, "%s", fname);
 	}
+}
+#endif
+
+// Decode the background of the screen new_briefing_screen shows after
+// cur_screen while the player reads this one.
+static void preload_next_briefing_screen(const briefing &br, const briefing_screen *const screens, const int count)
+{
+	auto level_num = br.level_num;
+	for (int i = br.cur_screen + 1;; ++i)
+	{
+		if (i == count)
+		{
+			if (level_num != 0)
+				return;
+			level_num = 1;
+			i = 0;
+		}
+		if (screens[i].level_num != level_num)
+			continue;
+#if defined(DXX_BUILD_DESCENT_I)
+		char fname[PATH_MAX];
+		briefing_screen_filename(screens[i].bs_name, fname);
+		pcx_preload(fname);
+#elif defined(DXX_BUILD_DESCENT_II)
+		pcx_preload(screens[i].bs_name);
+#endif
+		return;
+	}
+}
+
+//	-----------------------------------------------------------------------------
+//	loads a briefing screen
+static int load_briefing_screen(grs_canvas &canvas, briefing *const br, const char *const fname)
+{
+#if defined(DXX_BUILD_DESCENT_I)
+	int pcx_error;
+	char fname2[PATH_MAX];
+
+	free_briefing_screen(br);
+
+	briefing_screen_filename(fname, fname2);
 	if (d_stricmp(br->background_name, fname2))
 		strncpy (br->background_name,fname2, sizeof(br->background_name));
 
@@ -1417,6 +1488,7 @@ static int new_briefing_screen(briefing *br, int first)
 		return 0;
 
 	br->message = get_briefing_message(br, D1_Briefing_screens[br->cur_screen].message_num);
+	preload_next_briefing_screen(*br, D1_Briefing_screens, NUM_D1_BRIEFING_SCREENS);
 #elif defined(DXX_BUILD_DESCENT_II)
 	br->got_z = 0;
 
@@ -1444,6 +1516,7 @@ static int new_briefing_screen(briefing *br, int first)
 
 		if (!load_briefing_screen(*grd_curcanv, br, Briefing_screens[br->cur_screen].bs_name))
 			return 0;
+		preload_next_briefing_screen(*br, Briefing_screens.data(), NUM_D1_BRIEFING_SCREENS);
 	}
 	else if (first)
 	{
@@ -1460,6 +1533,8 @@ static int new_briefing_screen(briefing *br, int first)
 	br->line_adjustment = 1;
 	br->chattering = 0;
 	br->robot_playing=0;
+	if (!EMULATING_D1 && br->message)
+		preload_next_z_screen(br->message);
 #endif
 
 	if (br->message==NULL)
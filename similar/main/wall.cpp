@@ -170,7 +170,7 @@ static uint_fast32_t check_transparency(const GameBitmaps_array &GameBitmaps, co
 //		WID_NO_WALL					5	//	1/0/1		no wall, can fly through
 namespace dsx {
 
-static WALL_IS_DOORWAY_result_t wall_is_doorway(const GameBitmaps_array &GameBitmaps, const Textures_array &Textures, fvcwallptr &vcwallptr, const shared_side &sside, const unique_side &uside)
+WALL_IS_DOORWAY_result_t wall_is_doorway(const GameBitmaps_array &GameBitmaps, const Textures_array &Textures, fvcwallptr &vcwallptr, const shared_side &sside, const unique_side &uside)
 {
 	auto &w = *vcwallptr(sside.wall_num);
 	const auto type = w.type;
@@ -212,20 +212,6 @@ static WALL_IS_DOORWAY_result_t wall_is_doorway(const GameBitmaps_array &GameBit
 		return WID_WALL; // There are children behind the door.
 }
 
-WALL_IS_DOORWAY_result_t WALL_IS_DOORWAY(const GameBitmaps_array &GameBitmaps, const Textures_array &Textures, fvcwallptr &vcwallptr, const shared_segment &sseg, const unique_segment &useg, const uint_fast32_t side)
-{
-	const auto child = sseg.children[side];
-	if (unlikely(child == segment_none))
-		return WID_WALL;
-	if (unlikely(child == segment_exit))
-		return WID_EXTERNAL;
-	auto &sside = sseg.sides[side];
-	if (likely(sside.wall_num == wall_none))
-		return WID_NO_WALL;
-	auto &uside = useg.sides[side];
-	return wall_is_doorway(GameBitmaps, Textures, vcwallptr, sside, uside);
-}
-
 }
 
 #if DXX_USE_EDITOR
@@ -269,6 +255,9 @@ void wall_set_tmap_num(const wclip &anim, const vmsegptridx_t seg, const unsigne
 	const auto tmap = anim.frames[frame_num];
 	auto &uside = seg->unique_segment::sides[side];
 	auto &cuside = csegp->unique_segment::sides[cside];
+#if defined(DXX_BUILD_DESCENT_II)
+	const auto transparent = check_transparency(GameBitmaps, Textures, uside);
+#endif
 	if (anim.flags & WCF_TMAP1)	{
 		if (tmap != uside.tmap_num || tmap != cuside.tmap_num)
 		{
@@ -285,6 +274,11 @@ void wall_set_tmap_num(const wclip &anim, const vmsegptridx_t seg, const unsigne
 				newdemo_record_wall_set_tmap_num2(seg,side,csegp,cside,tmap);
 		}
 	}
+#if defined(DXX_BUILD_DESCENT_II)
+	//	Sound passes through transparent door frames.
+	if (check_transparency(GameBitmaps, Textures, uside) != transparent)
+		flush_fcd_cache();
+#endif
 }
 
 
@@ -443,6 +437,7 @@ void wall_open_door(const vmsegptridx_t seg, int side)
 
 
 	w->state = WALL_DOOR_OPENING;
+	flush_fcd_cache();
 
 	// So that door can't be shot while opening
 	const auto &&csegp = vcsegptr(seg->children[side]);
@@ -693,6 +688,7 @@ void wall_close_door_ref(fvmsegptridx &vmsegptridx, wall_array &Walls, const wal
 
 		wall_set_tmap_num(WallAnims[w.clip_num], seg, side, csegp, Connectside, 0);
 	}
+	flush_fcd_cache();
 }
 
 static unsigned check_poke(fvcvertptr &vcvertptr, const object_base &obj, const shared_segment &seg, const unsigned side)
@@ -778,6 +774,7 @@ void wall_close_door(wall_array &Walls, const vmsegptridx_t seg, const unsigned
 	}
 
 	w->state = WALL_DOOR_CLOSING;
+	flush_fcd_cache();
 
 	// So that door can't be shot while opening
 	const auto &&csegp = vcsegptr(seg->children[side]);
@@ -861,9 +858,10 @@ static bool do_door_open(active_door &d)
 
 		const auto cwall_num = csegp->shared_segment::sides[Connectside].wall_num;
 		auto &w1 = *vmwallptr(cwall_num);
-		if (i> n/2) {
+		if (i> n/2 && !(w.flags & WALL_DOOR_OPENED)) {
 			w.flags |= WALL_DOOR_OPENED;
 			w1.flags |= WALL_DOOR_OPENED;
+			flush_fcd_cache();
 		}
 
 		if (i >= n-1) {
@@ -884,7 +882,6 @@ static bool do_door_open(active_door &d)
 		}
 
 	}
-	flush_fcd_cache();
 	return remove;
 }
 
@@ -968,9 +965,10 @@ static bool do_door_close(active_door &d)
 
 		const auto cwall_num = csegp->shared_segment::sides[Connectside].wall_num;
 		auto &w1 = *vmwallptr(cwall_num);
-		if (i < n/2) {
+		if (i < n/2 && (wp.flags & WALL_DOOR_OPENED)) {
 			wp.flags &= ~WALL_DOOR_OPENED;
 			w1.flags &= ~WALL_DOOR_OPENED;
+			flush_fcd_cache();
 		}
 
 		// Animate door.
@@ -1014,6 +1012,7 @@ static void wall_illusion_op(fvmwallptr &vmwallptr, const vcsegptridx_t seg, con
 	{
 		op(*r.first);
 		op(*r.second);
+		flush_fcd_cache();
 	}
 }
 
@@ -1295,6 +1294,7 @@ bool cw_removal_predicate::operator()(cloaking_wall &d)
 	const bool initial = (d.time == 0);
 	d.time += FrameTime;
 
+	const auto type = front.w.type;
 	cwresult r;
 	if (front.w.state == WALL_DOOR_CLOAKING)
 		r = do_cloaking_wall_frame(initial, d, front, back);
@@ -1305,6 +1305,8 @@ bool cw_removal_predicate::operator()(cloaking_wall &d)
 		d_debugbreak();	//unexpected wall state
 		return false;
 	}
+	if (front.w.type != type)
+		flush_fcd_cache();
 	if (r.record)
 	{
 		// check if the actual cloak_value changed in this frame to prevent redundant recordings and wasted bytes
@@ -1322,29 +1324,31 @@ static void process_exploding_walls()
 {
 	if (Newdemo_state == ND_STATE_PLAYBACK)
 		return;
-	if (unsigned num_exploding_walls = Num_exploding_walls)
+	auto &l = Exploding_walls;
+	if (l.walls.empty())
+		return;
+	auto &Walls = LevelUniqueWallSubsystemState.Walls;
+	auto &vmwallptr = Walls.vmptr;
+	/* Visit the walls in wall number order, as a scan of every wall
+	 * would, so that the explosions draw random numbers in the same
+	 * order.  Walls which start exploding during this loop are appended
+	 * after n and wait for the next frame.
+	 */
+	std::sort(l.walls.begin(), l.walls.end());
+	const std::size_t n = l.walls.size();
+	for (std::size_t i = 0; i != n; ++i)
 	{
-		auto &Walls = LevelUniqueWallSubsystemState.Walls;
-		range_for (auto &&wp, Walls.vmptr)
-		{
-			auto &w1 = *wp;
-			if (w1.flags & WALL_EXPLODING)
-			{
-				assert(num_exploding_walls);
-				do_exploding_wall_frame(w1);
-				if (! -- num_exploding_walls)
-				{
-					/* In debug builds, iterate over all remaining walls
-					 * to verify that none are marked as WALL_EXPLODING.
-					 */
-#ifdef NDEBUG
-					break;
-#endif
-				}
-			}
-		}
-		assert(!num_exploding_walls);
+		auto &w1 = *vmwallptr(l.walls[i]);
+		if (w1.flags & WALL_EXPLODING)
+			do_exploding_wall_frame(w1);
 	}
+	l.walls.erase_if([&l, &vmwallptr](const wallnum_t w) {
+		if (vmwallptr(w)->flags & WALL_EXPLODING)
+			return false;
+		l.listed[w] = false;
+		return true;
+	});
+	assert(l.walls.size() == Num_exploding_walls);
 }
 
 void wall_frame_process()
@@ -153,6 +153,8 @@ static void arg_port_number(Arglist::iterator &pp, Arglist::const_iterator end,
 static void InitGameArg()
 {
 	CGameArg.SysMaxFPS = MAXIMUM_FPS;
+	CGameArg.SysRleCacheSize = 4;
+	CGameArg.SysDemoVideoFPS = 60;
 #if defined(DXX_BUILD_DESCENT_II)
 	GameArg.SndDigiSampleRate = SAMPLE_RATE_22K;
 #endif
@@ -205,6 +207,8 @@ static void ReadCmdArgs(Inilist &ini, Arglist &Args)
 			CGameArg.SysNoNiceFPS = true;
 		else if (!d_stricmp(p, "-maxfps"))
 			CGameArg.SysMaxFPS = arg_integer(pp, end);
+		else if (!d_stricmp(p, "-fixedtick"))
+			CGameArg.SysFixedTickRate = arg_integer(pp, end);
 		else if (!d_stricmp(p, "-hogdir"))
 			CGameArg.SysHogDir = arg_string(pp, end);
 #if PHYSFS_VER_MAJOR >= 2
@@ -224,12 +228,30 @@ static void ReadCmdArgs(Inilist &ini, Arglist &Args)
 			CGameArg.SysUsePlayersDir = static_cast<int8_t>(- (sizeof(PLAYER_DIRECTORY_TEXT) - 1));
 		else if (!d_stricmp(p, "-lowmem"))
 			CGameArg.SysLowMem = true;
+		else if (!d_stricmp(p, "-mappig"))
+			CGameArg.SysMapPigFile = true;
+		else if (!d_stricmp(p, "-nomissioncache"))
+			CGameArg.SysNoMissionCache = true;
+		else if (!d_stricmp(p, "-nomodelcache"))
+			CGameArg.SysNoModelCache = true;
+		else if (!d_stricmp(p, "-nolevelcache"))
+			CGameArg.SysNoLevelCache = true;
+		else if (!d_stricmp(p, "-rlecache"))
+			CGameArg.SysRleCacheSize = arg_integer(pp, end);
+		else if (!d_stricmp(p, "-rlepin"))
+			CGameArg.SysRlePin = true;
+		else if (!d_stricmp(p, "-ai_lod"))
+			CGameArg.SysAiLodDepth = arg_integer(pp, end);
+		else if (!d_stricmp(p, "-rewind"))
+			CGameArg.SysRewindInterval = arg_integer(pp, end);
 		else if (!d_stricmp(p, "-pilot"))
 			CGameArg.SysPilot = arg_string(pp, end);
 		else if (!d_stricmp(p, "-record-demo-format"))
 			CGameArg.SysRecordDemoNameTemplate = arg_string(pp, end);
 		else if (!d_stricmp(p, "-auto-record-demo"))
 			CGameArg.SysAutoRecordDemo = true;
+		else if (!d_stricmp(p, "-record-demo-delta"))
+			CGameArg.SysRecordDemoDelta = true;
 		else if (!d_stricmp(p, "-window"))
 			CGameArg.SysWindow = true;
 		else if (!d_stricmp(p, "-noborders"))
@@ -242,6 +264,53 @@ static void ReadCmdArgs(Inilist &ini, Arglist &Args)
 #endif
 		else if (!d_stricmp(p, "-autodemo"))
 			CGameArg.SysAutoDemo = true;
+		else if (!d_stricmp(p, "-demo_stats"))
+		{
+			CGameArg.SysDemoStats = arg_string(pp, end);
+			CGameArg.SysAutoDemo = true;
+		}
+		else if (!d_stricmp(p, "-demo_video"))
+		{
+			CGameArg.SysDemoVideo = arg_string(pp, end);
+			CGameArg.SysAutoDemo = true;
+		}
+		else if (!d_stricmp(p, "-timedemo"))
+		{
+			CGameArg.SysTimeDemo = arg_string(pp, end);
+			CGameArg.SysAutoDemo = true;
+		}
+		else if (!d_stricmp(p, "-replay_record"))
+			CGameArg.SysReplayRecord = arg_string(pp, end);
+		else if (!d_stricmp(p, "-replay"))
+		{
+			CGameArg.SysReplay = arg_string(pp, end);
+			CGameArg.SysAutoDemo = true;
+		}
+		else if (!d_stricmp(p, "-replay_check"))
+		{
+			CGameArg.SysReplayCheck = arg_string(pp, end);
+			CGameArg.SysAutoDemo = true;
+		}
+		else if (!d_stricmp(p, "-fast_screenshots"))
+			CGameArg.SysFastScreenshots = true;
+		else if (!d_stricmp(p, "-demo_batch"))
+			CGameArg.SysDemoBatch = arg_string(pp, end);
+		else if (!d_stricmp(p, "-demo_video_fps"))
+			CGameArg.SysDemoVideoFPS = arg_integer(pp, end);
+		else if (!d_stricmp(p, "-headless"))
+		{
+			CGameArg.SysHeadless = true;
+			CGameArg.SysNoTitles = true;
+#if defined(DXX_BUILD_DESCENT_II)
+			GameArg.SysNoMovies = 1;
+#endif
+			CGameArg.SndNoSound = 1;
+			CGameArg.SndNoMusic = true;
+			CGameArg.CtlNoMouse = true;
+#if DXX_MAX_JOYSTICKS
+			CGameArg.CtlNoJoystick = 1;
+#endif
+		}
 
 	// Control Options
 
@@ -257,6 +326,8 @@ static void ReadCmdArgs(Inilist &ini, Arglist &Args)
 		}
 		else if (!d_stricmp(p, "-nostickykeys"))
 			CGameArg.CtlNoStickyKeys	= true;
+		else if (!d_stricmp(p, "-latelook"))
+			CGameArg.CtlLateLook	= true;
 
 	// Sound Options
 
@@ -264,6 +335,8 @@ static void ReadCmdArgs(Inilist &ini, Arglist &Args)
 			CGameArg.SndNoSound		= 1;
 		else if (!d_stricmp(p, "-nomusic"))
 			CGameArg.SndNoMusic = true;
+		else if (!d_stricmp(p, "-lazysounds"))
+			CGameArg.SndLazyLoad = true;
 #if defined(DXX_BUILD_DESCENT_II)
 		else if (!d_stricmp(p, "-sound11k"))
 			GameArg.SndDigiSampleRate 		= SAMPLE_RATE_11K;
@@ -279,6 +352,8 @@ static void ReadCmdArgs(Inilist &ini, Arglist &Args)
 
 		else if (!d_stricmp(p, "-lowresfont"))
 			CGameArg.GfxSkipHiresFNT = true;
+		else if (!d_stricmp(p, "-window_depth"))
+			CGameArg.GfxWindowDepth = arg_integer(pp, end);
 #if defined(DXX_BUILD_DESCENT_II)
 		else if (!d_stricmp(p, "-lowresgraphics"))
 			GameArg.GfxSkipHiresGFX	= 1;
@@ -296,6 +371,32 @@ static void ReadCmdArgs(Inilist &ini, Arglist &Args)
 			CGameArg.OglSyncWait = arg_integer(pp, end);
 		else if (!d_stricmp(p, "-gl_darkedges"))
 			CGameArg.OglDarkEdges = true;
+		else if (!d_stricmp(p, "-gl_worldbuffer"))
+			CGameArg.OglWorldBuffer = true;
+		else if (!d_stricmp(p, "-gl_sortfaces"))
+			CGameArg.OglSortFaces = true;
+		else if (!d_stricmp(p, "-gl_overlayshader"))
+			CGameArg.OglOverlayShader = true;
+		else if (!d_stricmp(p, "-gl_pixellight"))
+			CGameArg.OglPixelLight = true;
+		else if (!d_stricmp(p, "-gl_modelbuffer"))
+			CGameArg.OglModelBuffer = true;
+		else if (!d_stricmp(p, "-gl_asyncupload"))
+			CGameArg.OglAsyncUpload = true;
+		else if (!d_stricmp(p, "-gl_occlusion"))
+			CGameArg.OglOcclusionQueries = true;
+		else if (!d_stricmp(p, "-gl_texcache"))
+			CGameArg.OglTextureCache = true;
+		else if (!d_stricmp(p, "-gl_vram"))
+			CGameArg.OglVramBudget = arg_integer(pp, end);
+		else if (!d_stricmp(p, "-gl_pipeline"))
+			CGameArg.OglPipeline = true;
+		else if (!d_stricmp(p, "-gl_dynres"))
+			CGameArg.OglDynresTarget = arg_integer(pp, end);
+		else if (!d_stricmp(p, "-gl_modellod"))
+			CGameArg.OglModelLod = arg_integer(pp, end);
+		else if (!d_stricmp(p, "-gl_instancing"))
+			CGameArg.OglInstancing = true;
 #endif
 
 	// Multiplayer Options
@@ -312,6 +413,15 @@ static void ReadCmdArgs(Inilist &ini, Arglist &Args)
 		{
 			arg_port_number(pp, end, CGameArg.MplUdpMyPort, false);
 		}
+		else if (!d_stricmp(p, "-udp_interp_delay"))
+		{
+			const auto delay = arg_integer(pp, end);
+			CGameArg.MplUdpInterpDelay = delay < 0 ? 0 : (delay > 500 ? 500 : delay);
+		}
+		else if (!d_stricmp(p, "-udp_autohost"))
+			CGameArg.MplUdpAutoHost = arg_string(pp, end);
+		else if (!d_stricmp(p, "-udp_stats_file"))
+			CGameArg.MplUdpStatsFile = arg_string(pp, end);
 		else if (!d_stricmp(p, "-no-tracker"))
 		{
 			/* Always recognized.  No-op if tracker support compiled
@@ -344,6 +454,10 @@ static void ReadCmdArgs(Inilist &ini, Arglist &Args)
 		else if (!d_stricmp(p, "-hoarddata"))
 			GameArg.EdiSaveHoardData 	= 1;
 #endif
+#endif
+#if DXX_USE_EDITOR
+		else if (!d_stricmp(p, "-notblcache"))
+			GameArg.EdiNoTblCache 	= 1;
 #endif
 
 	// Debug Options
@@ -357,10 +471,18 @@ static void ReadCmdArgs(Inilist &ini, Arglist &Args)
 			CGameArg.DbgForbidConsoleGrab = true;
 		else if (!d_stricmp(p, "-safelog"))
 			CGameArg.DbgSafelog = true;
+		else if (!d_stricmp(p, "-tracefile"))
+			CGameArg.DbgTraceFile = arg_string(pp, end);
 		else if (!d_stricmp(p, "-norun"))
 			CGameArg.DbgNoRun = true;
 		else if (!d_stricmp(p, "-renderstats"))
 			CGameArg.DbgRenderStats = true;
+		else if (!d_stricmp(p, "-latency"))
+			CGameArg.DbgLatency = true;
+		else if (!d_stricmp(p, "-nopvs"))
+			CGameArg.DbgNoPVS = true;
+		else if (!d_stricmp(p, "-nojobs"))
+			CGameArg.DbgNoJobs = true;
 		else if (!d_stricmp(p, "-text"))
 			CGameArg.DbgAltTex = arg_string(pp, end);
 		else if (!d_stricmp(p, "-showmeminfo"))
@@ -392,6 +514,8 @@ static void ReadCmdArgs(Inilist &ini, Arglist &Args)
 			CGameArg.DbgSdlHWSurface = true;
 		else if (!d_stricmp(p, "-asyncblit"))
 			CGameArg.DbgSdlASyncBlit = true;
+		else if (!d_stricmp(p, "-sdl_scale"))
+			CGameArg.SdlRenderScale = arg_integer(pp, end);
 #endif
 		else if (!d_stricmp(p, "-ini"))
 		{
@@ -421,6 +545,17 @@ static void PostProcessGameArg()
 		CGameArg.SysMaxFPS = MINIMUM_FPS;
 	else if (CGameArg.SysMaxFPS > MAXIMUM_FPS)
 		CGameArg.SysMaxFPS = MAXIMUM_FPS;
+	if (CGameArg.SysFixedTickRate)
+	{
+		if (CGameArg.SysFixedTickRate < DESIGNATED_GAME_FPS)
+			CGameArg.SysFixedTickRate = DESIGNATED_GAME_FPS;
+		else if (CGameArg.SysFixedTickRate > MAXIMUM_FPS)
+			CGameArg.SysFixedTickRate = MAXIMUM_FPS;
+	}
+	if (CGameArg.SysDemoVideoFPS < 1)
+		CGameArg.SysDemoVideoFPS = 1;
+	else if (CGameArg.SysDemoVideoFPS > MAXIMUM_FPS)
+		CGameArg.SysDemoVideoFPS = MAXIMUM_FPS;
 #if PHYSFS_VER_MAJOR >= 2
 	if (!CGameArg.SysMissionDir.empty())
 		PHYSFS_mount(CGameArg.SysMissionDir.c_str(), MISSION_DIR, 1);
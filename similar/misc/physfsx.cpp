@@ -10,10 +10,23 @@
  *
  */
 
+#include <algorithm>
+#include <atomic>
 #include <cstdlib>
+#include <limits>
+#include <vector>
+#include <SDL.h>
 #if !defined(macintosh) && !defined(_MSC_VER)
 #include <sys/param.h>
 #endif
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
 #if defined(__APPLE__) && defined(__MACH__)
 #include <sys/mount.h>
 #include <unistd.h>	// for chdir hack
@@ -23,8 +36,10 @@
 #include "args.h"
 #include "newdemo.h"
 #include "console.h"
+#include "profile.h"
 #include "strutil.h"
 #include "ignorecase.h"
+#include "hog2.h"
 #include "physfs_list.h"
 
 #include "compiler-range_for.h"
@@ -107,6 +122,7 @@ bool PHYSFSX_init(int argc, char *argv[])
 	if (!PHYSFS_init(argv[0]))
 		Error("Failed to init PhysFS: %s", PHYSFS_getLastError());
 	PHYSFS_permitSymbolicLinks(1);
+	hog2_register_archiver();
 	
 #ifdef macintosh
 	strcpy(base_dir, PHYSFS_getBaseDir());
@@ -198,6 +214,7 @@ bool PHYSFSX_init(int argc, char *argv[])
 	if (!InitArgs( argc,argv ))
 		return false;
 	PHYSFS_removeFromSearchPath(base_dir);
+	PHYSFSEXT_flushCaseCache();
 	
 	if (!PHYSFS_getWriteDir())
 	{
@@ -263,6 +280,7 @@ bool PHYSFSX_init(int argc, char *argv[])
 		PHYSFS_addToSearchPath(base_dir, 1);
 	}
 #endif
+	PHYSFSEXT_flushCaseCache();
 	return true;
 }
 
@@ -289,7 +307,10 @@ int PHYSFSX_addRelToSearchPath(const char *relname, int add_to_end)
 	auto r = PHYSFS_addToSearchPath(pathname.data(), add_to_end);
 	const auto action = add_to_end ? "append" : "insert";
 	if (r)
+	{
+		PHYSFSEXT_flushCaseCache();
 		con_printf(CON_DEBUG, "PHYSFS: %s canonical directory \"%s\" to search path from relative name \"%s\"", action, pathname.data(), relname);
+	}
 	else
 		con_printf(CON_VERBOSE, "PHYSFS: failed to %s canonical directory \"%s\" to search path from relative name \"%s\": \"%s\"", action, pathname.data(), relname, PHYSFS_getLastError());
 	return r;
@@ -310,7 +331,10 @@ int PHYSFSX_removeRelFromSearchPath(const char *relname)
 	}
 	auto r = PHYSFS_removeFromSearchPath(pathname.data());
 	if (r)
+	{
+		PHYSFSEXT_flushCaseCache();
 		con_printf(CON_DEBUG, "PHYSFS: unmap canonical directory \"%s\" (relative name \"%s\")", pathname.data(), relname);
+	}
 	else
 		con_printf(CON_VERBOSE, "PHYSFS: failed to unmap canonical directory \"%s\" (relative name \"%s\"): \"%s\"", pathname.data(), relname, PHYSFS_getLastError());
 	return r;
@@ -523,6 +547,25 @@ int PHYSFSX_exists_ignorecase(const char *filename)
 	return !PHYSFSEXT_locateCorrectCase(filename2);
 }
 
+bool PHYSFSX_stat(const char *const filename, PHYSFS_sint64 &size, PHYSFS_sint64 &mtime)
+{
+	char filename2[PATH_MAX];
+	snprintf(filename2, sizeof(filename2), "%s", filename);
+	PHYSFSEXT_locateCorrectCase(filename2);
+#if PHYSFS_VER_MAJOR > 2 || (PHYSFS_VER_MAJOR == 2 && PHYSFS_VER_MINOR >= 1)
+	PHYSFS_Stat st;
+	if (!PHYSFS_stat(filename2, &st))
+		return false;
+	size = st.filesize;
+	mtime = st.modtime;
+#else
+	/* Getting the size would need opening the file. */
+	size = -1;
+	mtime = PHYSFS_getLastModTime(filename2);
+#endif
+	return mtime != -1;
+}
+
 //Open a file for reading, set up a buffer
 RAIIPHYSFS_File PHYSFSX_openReadBuffered(const char *filename)
 {
@@ -561,6 +604,303 @@ RAIIPHYSFS_File PHYSFSX_openWriteBuffered(const char *filename)
 	return fp;
 }
 
+static void PHYSFSX_getReplacementName(const char *const filename, array<char, PATH_MAX> &temp)
+{
+	snprintf(temp.data(), temp.size(), "%s.tmp", filename);
+}
+
+//Open a temporary file for writing, set up a buffer.  PHYSFSX_commitReplace
+//moves it over filename once the caller has written all of it.
+RAIIPHYSFS_File PHYSFSX_openReplaceBuffered(const char *filename)
+{
+	array<char, PATH_MAX> temp;
+	PHYSFSX_getReplacementName(filename, temp);
+	return PHYSFSX_openWriteBuffered(temp.data());
+}
+
+int PHYSFSX_commitReplace(RAIIPHYSFS_File &file, const char *filename)
+{
+	array<char, PATH_MAX> temp;
+	PHYSFSX_getReplacementName(filename, temp);
+	if (!file.close())
+	{
+		file.reset();
+		PHYSFS_delete(temp.data());
+		return 0;
+	}
+	/* The temporary file is in the write directory, so the real path of
+	 * filename is the same without the suffix.  Asking for filename itself
+	 * could find a copy of it elsewhere in the search path.
+	 */
+	array<char, PATH_MAX> old, n;
+	if (!PHYSFSX_getRealPath(temp.data(), old))
+	{
+		PHYSFS_delete(temp.data());
+		return 0;
+	}
+	n = old;
+	n[strlen(n.data()) - 4] = 0;
+#ifdef _WIN32
+	/* rename cannot replace an existing file on Windows */
+	const bool replaced = MoveFileExA(old.data(), n.data(), MOVEFILE_REPLACE_EXISTING);
+#else
+	const bool replaced = rename(old.data(), n.data()) == 0;
+#endif
+	if (!replaced)
+		PHYSFS_delete(temp.data());
+	return replaced;
+}
+
+PHYSFSX_mapped_file::PHYSFSX_mapped_file(void *const base, const std::size_t base_size, const std::size_t offset, const std::size_t length) :
+	base(base), base_size(base_size), first(static_cast<uint8_t *>(base) + offset), length(length)
+{
+}
+
+void PHYSFSX_mapped_file::reset()
+{
+	if (!base)
+		return;
+#ifdef _WIN32
+	UnmapViewOfFile(base);
+#else
+	munmap(base, base_size);
+#endif
+	base = nullptr;
+	first = nullptr;
+}
+
+/* Map the whole of the native file path, and return a view of length
+ * bytes at offset.  The mapping is private, so a caller which changes
+ * the data never writes to the file.
+ */
+static PHYSFSX_mapped_file PHYSFSX_mapNative(const char *const path, const uint64_t offset, const uint64_t length)
+{
+#ifdef _WIN32
+	const HANDLE file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (file == INVALID_HANDLE_VALUE)
+		return {};
+	LARGE_INTEGER file_size;
+	if (!GetFileSizeEx(file, &file_size) || static_cast<uint64_t>(file_size.QuadPart) < offset + length)
+	{
+		CloseHandle(file);
+		return {};
+	}
+	const HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_WRITECOPY, 0, 0, nullptr);
+	CloseHandle(file);
+	if (!mapping)
+		return {};
+	void *const base = MapViewOfFile(mapping, FILE_MAP_COPY, 0, 0, 0);
+	CloseHandle(mapping);
+	if (!base)
+		return {};
+	return {base, static_cast<std::size_t>(file_size.QuadPart), static_cast<std::size_t>(offset), static_cast<std::size_t>(length)};
+#else
+	const int fd = open(path, O_RDONLY);
+	if (fd == -1)
+		return {};
+	struct stat st;
+	if (fstat(fd, &st) || !S_ISREG(st.st_mode) || static_cast<uint64_t>(st.st_size) < offset + length || static_cast<uint64_t>(st.st_size) > std::numeric_limits<std::size_t>::max())
+	{
+		close(fd);
+		return {};
+	}
+	const std::size_t file_size = st.st_size;
+	void *const base = mmap(nullptr, file_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if (base == MAP_FAILED)
+		return {};
+	return {base, file_size, static_cast<std::size_t>(offset), static_cast<std::size_t>(length)};
+#endif
+}
+
+/* Find where the data of member starts in the indexed HOG open as fp.
+ * Only stored members are the file itself.
+ */
+static bool PHYSFSX_findHog2Member(FILE *const fp, const uint8_t *const raw_header, const char *const member, const uint64_t length, uint64_t &offset)
+{
+	hog2_header header;
+	if (!hog2_parse_header(raw_header, header))
+		return false;
+	array<uint8_t, hog2_entry_size> raw_entry;
+	for (uint32_t i = header.count; i--;)
+	{
+		if (fread(raw_entry.data(), raw_entry.size(), 1, fp) != 1)
+			return false;
+		hog2_entry e;
+		hog2_parse_entry(raw_entry.data(), e);
+		const auto c = hog2_compare_name(e.name.data(), member);
+		if (c < 0)
+			continue;
+		/* The directory is sorted, so a later entry cannot match. */
+		if (c > 0 || e.method != hog2_method::stored || e.size != length)
+			return false;
+		offset = e.offset;
+		return true;
+	}
+	return false;
+}
+
+/* Find where the data of member starts in the HOG at native path hog.
+ * Classic HOG members are never compressed, so the data is the file
+ * itself.
+ */
+static bool PHYSFSX_findHogMember(const char *const hog, const char *const member, const uint64_t length, uint64_t &offset)
+{
+	const std::unique_ptr<FILE, int (*)(FILE *)> fp{fopen(hog, "rb"), fclose};
+	if (!fp)
+		return false;
+	array<char, 3> sig;
+	if (fread(sig.data(), sig.size(), 1, fp.get()) != 1)
+		return false;
+	if (!memcmp(sig.data(), hog2_signature.data(), sig.size()))
+	{
+		array<uint8_t, hog2_header_size> raw_header;
+		memcpy(raw_header.data(), sig.data(), sig.size());
+		if (fread(&raw_header[sig.size()], raw_header.size() - sig.size(), 1, fp.get()) != 1)
+			return false;
+		return PHYSFSX_findHog2Member(fp.get(), raw_header.data(), member, length, offset);
+	}
+	if (memcmp(sig.data(), "DHF", sig.size()))
+		return false;
+	uint64_t position = sig.size();
+	for (;;)
+	{
+		array<char, 13> name;
+		array<uint8_t, 4> raw_size;
+		if (fread(name.data(), name.size(), 1, fp.get()) != 1 || fread(raw_size.data(), raw_size.size(), 1, fp.get()) != 1)
+			return false;
+		name.back() = 0;
+		const uint64_t size = GET_INTEL_INT(raw_size.data());
+		position += name.size() + raw_size.size();
+		if (!d_stricmp(name.data(), member))
+		{
+			if (size != length)
+				return false;
+			offset = position;
+			return true;
+		}
+		position += size;
+		if (fseek(fp.get(), size, SEEK_CUR))
+			return false;
+	}
+}
+
+PHYSFSX_mapped_file PHYSFSX_mapRead(const char *const filename)
+{
+	char filename2[PATH_MAX];
+	snprintf(filename2, sizeof(filename2), "%s", filename);
+	PHYSFSEXT_locateCorrectCase(filename2);
+	uint64_t length;
+	{
+		RAIIPHYSFS_File fp{PHYSFS_openRead(filename2)};
+		if (!fp)
+			return {};
+		const auto l = PHYSFS_fileLength(fp);
+		if (l < 0)
+			return {};
+		length = l;
+	}
+	array<char, PATH_MAX> realfile;
+	if (PHYSFSX_getRealPath(filename2, realfile))
+		if (auto m = PHYSFSX_mapNative(realfile.data(), 0, length))
+			if (m.size() == length)
+				return m;
+	const auto realdir = PHYSFS_getRealDir(filename2);
+	if (!realdir)
+		return {};
+	const auto slash = strrchr(filename2, '/');
+	uint64_t offset;
+	if (!PHYSFSX_findHogMember(realdir, slash ? slash + 1 : filename2, length, offset))
+		return {};
+	return PHYSFSX_mapNative(realdir, offset, length);
+}
+
+/* Reading the directory of each archive is most of the cost of adding
+ * it, and PhysFS adds archives one at a time.  Before they are added,
+ * threads read the part of each archive which PhysFS reads when adding
+ * it, so that adding them finds that part in the operating system's
+ * file cache.  The threads use only native file I/O, and the archives
+ * are still added in the order they were found.
+ */
+namespace {
+
+constexpr unsigned archive_prefetch_max_threads = 4;
+
+struct archive_prefetch_state
+{
+	const std::vector<array<char, PATH_MAX>> &paths;
+	std::atomic<unsigned> next;
+};
+
+}
+
+/* Read the central directory of the ZIP file open as fp. */
+static void PHYSFSX_prefetchZipDirectory(FILE *const fp)
+{
+	/* The end of central directory record is 22 bytes, followed by a
+	 * comment of at most 65535 bytes.
+	 */
+	constexpr long eocd_size = 22;
+	if (fseek(fp, 0, SEEK_END))
+		return;
+	const long size = ftell(fp);
+	if (size < eocd_size)
+		return;
+	const long tail = std::min(size, eocd_size + 65535);
+	std::vector<uint8_t> buffer(tail);
+	if (fseek(fp, size - tail, SEEK_SET) || fread(buffer.data(), tail, 1, fp) != 1)
+		return;
+	for (long i = tail - eocd_size; i >= 0; --i)
+	{
+		if (GET_INTEL_INT(&buffer[i]) != 0x06054b50)
+			continue;
+		const unsigned long directory_size = GET_INTEL_INT(&buffer[i + 12]);
+		const unsigned long directory_offset = GET_INTEL_INT(&buffer[i + 16]);
+		if (!directory_size || directory_offset >= static_cast<unsigned long>(size) || directory_size > size - directory_offset)
+			return;
+		buffer.resize(directory_size);
+		if (!fseek(fp, directory_offset, SEEK_SET))
+			(void)fread(buffer.data(), directory_size, 1, fp);
+		return;
+	}
+}
+
+static int PHYSFSX_prefetchArchiveThread(void *const data)
+{
+	auto &s = *static_cast<archive_prefetch_state *>(data);
+	for (unsigned i; (i = s.next.fetch_add(1, std::memory_order_relaxed)) < s.paths.size();)
+	{
+		const std::unique_ptr<FILE, int (*)(FILE *)> fp{fopen(s.paths[i].data(), "rb"), fclose};
+		if (fp)
+			PHYSFSX_prefetchZipDirectory(fp.get());
+	}
+	return 0;
+}
+
+static void PHYSFSX_prefetchArchives(const std::vector<array<char, PATH_MAX>> &paths)
+{
+	if (paths.size() < 2)
+		return;
+	archive_prefetch_state s{paths, {0}};
+#if SDL_MAJOR_VERSION == 2
+	const int cpus = SDL_GetCPUCount();
+	const unsigned want = std::min<std::size_t>({cpus < 1 ? 1u : static_cast<unsigned>(cpus), archive_prefetch_max_threads, paths.size()});
+#else
+	const unsigned want = std::min<std::size_t>(archive_prefetch_max_threads, paths.size());
+#endif
+	array<SDL_Thread *, archive_prefetch_max_threads> threads{};
+	for (unsigned i = 0; i != want; ++i)
+#if SDL_MAJOR_VERSION == 2
+		threads[i] = SDL_CreateThread(PHYSFSX_prefetchArchiveThread, "archive_prefetch", &s);
+#else
+		threads[i] = SDL_CreateThread(PHYSFSX_prefetchArchiveThread, &s);
+#endif
+	/* If no thread started, the archives are added without help. */
+	range_for (const auto t, threads)
+		if (t)
+			SDL_WaitThread(t, nullptr);
+}
+
 /* 
  * Add archives to the game.
  * 1) archives from Sharepath/Data to extend/replace builtin game content
@@ -568,33 +908,45 @@ RAIIPHYSFS_File PHYSFSX_openWriteBuffered(const char *filename)
  */
 void PHYSFSX_addArchiveContent()
 {
+	const trace_scope trace_phase("PHYSFSX_addArchiveContent");
 	int content_updated = 0;
 
 	con_puts(CON_DEBUG, "PHYSFS: Adding archives to the game.");
+	std::vector<array<char, PATH_MAX>> archives;
 	// find files in Searchpath ...
 	auto list = PHYSFSX_findFiles("", archive_exts);
-	// if found, add them...
 	range_for (const auto i, list)
 	{
-		array<char, PATH_MAX> realfile;
-		PHYSFSX_getRealPath(i,realfile);
-		if (PHYSFS_addToSearchPath(realfile.data(), 0))
-		{
-			con_printf(CON_DEBUG, "PHYSFS: Added %s to Search Path",realfile.data());
-			content_updated = 1;
-		}
+		archives.emplace_back();
+		PHYSFSX_getRealPath(i, archives.back());
 	}
+	const auto content = archives.size();
 #if PHYSFS_VER_MAJOR >= 2
 	list.reset();
 	// find files in DEMO_DIR ...
 	list = PHYSFSX_findFiles(DEMO_DIR, archive_exts);
-	// if found, add them...
 	range_for (const auto i, list)
 	{
 		char demofile[PATH_MAX];
 		snprintf(demofile, sizeof(demofile), DEMO_DIR "%s", i);
-		array<char, PATH_MAX> realfile;
-		PHYSFSX_getRealPath(demofile,realfile);
+		archives.emplace_back();
+		PHYSFSX_getRealPath(demofile, archives.back());
+	}
+#endif
+	list.reset();
+	PHYSFSX_prefetchArchives(archives);
+	// if found, add them...
+	range_for (auto &realfile, partial_const_range(archives, content))
+	{
+		if (PHYSFS_addToSearchPath(realfile.data(), 0))
+		{
+			con_printf(CON_DEBUG, "PHYSFS: Added %s to Search Path",realfile.data());
+			content_updated = 1;
+		}
+	}
+#if PHYSFS_VER_MAJOR >= 2
+	range_for (auto &realfile, partial_const_range(archives, content, archives.size()))
+	{
 		if (PHYSFS_mount(realfile.data(), DEMO_DIR, 0))
 		{
 			con_printf(CON_DEBUG, "PHYSFS: Added %s to " DEMO_DIR, realfile.data());
@@ -602,10 +954,10 @@ void PHYSFSX_addArchiveContent()
 		}
 	}
 #endif
-	list.reset();
 
 	if (content_updated)
 	{
+		PHYSFSEXT_flushCaseCache();
 		con_puts(CON_DEBUG, "Game content updated!");
 		PHYSFSX_listSearchPathContent();
 	}
@@ -635,6 +987,7 @@ void PHYSFSX_removeArchiveContent()
 		PHYSFSX_getRealPath(demofile,realfile);
 		PHYSFS_removeFromSearchPath(realfile.data());
 	}
+	PHYSFSEXT_flushCaseCache();
 }
 
 void PHYSFSX_read_helper_report_error(const char *const filename, const unsigned line, const char *const func, PHYSFS_File *const file)
@@ -642,4 +995,19 @@ void PHYSFSX_read_helper_report_error(const char *const filename, const unsigned
 	(Error)(filename, line, func, "reading at %lu", static_cast<unsigned long>((PHYSFS_tell)(file)));
 }
 
+PHYSFSX_buffer_reader::PHYSFSX_buffer_reader(PHYSFS_File *const fp, const std::size_t max_length) :
+	file_offset(PHYSFS_tell(fp))
+{
+	const auto remaining = PHYSFS_fileLength(fp) - file_offset;
+	const std::size_t want = remaining < 0 ? 0 : std::min<PHYSFS_uint64>(remaining, max_length);
+	buffer = make_unique<uint8_t[]>(want);
+	const auto got = PHYSFS_read(fp, buffer.get(), 1, want);
+	length = got < 0 ? 0 : got;
+}
+
+void PHYSFSX_buffer_reader::report_overread(const std::size_t size) const
+{
+	Error("reading %u bytes at %lu", static_cast<unsigned>(size), static_cast<unsigned long>(tell()));
+}
+
 }